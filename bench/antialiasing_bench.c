@@ -0,0 +1,320 @@
+// antialiasing_bench.c
+// No antialiasing, FXAA and MSAA (common/antialiasing.h) on the same scene,
+// for frame time, memory and edge quality.
+//
+// The scene is a fan of thin triangles and a few large ones with edges a
+// little off the axes, where aliasing shows most. Each mode renders into a
+// hidden window of its own; the frame time runs from the first draw to a
+// glFinish after the FXAA pass or the multisample resolve. Memory is the
+// window's colour, depth and stencil bits times its samples, plus the
+// resolve buffer of MSAA and the offscreen buffers of FXAA; drivers may
+// add to it.
+//
+// The reference renders the scene 4 times larger in each direction and
+// averages each 4x4 block. Quality is the PSNR against it over the whole
+// image and over the edge pixels, those whose block is not one colour.
+//
+// Usage: antialiasing_bench [size] [frames] [msaa samples]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/antialiasing.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANTIALIASING_BENCH_MAX_FRAMES 1000
+#define ANTIALIASING_BENCH_SUPERSAMPLING 4
+#define ANTIALIASING_BENCH_FAN 48
+// Fan and three large triangles
+#define ANTIALIASING_BENCH_VERTICES ((ANTIALIASING_BENCH_FAN + 3) * 3)
+
+typedef struct SceneVertex
+{
+    GLfloat position[2];
+    GLfloat color[4];
+} SceneVertex;
+
+static int size = 512;
+static int frameCount = 30;
+static int msaaSamples = 4;
+static double times[ANTIALIASING_BENCH_MAX_FRAMES];
+static SceneVertex vertices[ANTIALIASING_BENCH_VERTICES];
+static unsigned char *reference;  // size x size RGBA
+static unsigned char *edgeMask;   // 1 where the reference block is not one colour
+
+static void set_vertex(SceneVertex *vertex, float x, float y, float r, float g, float b)
+{
+    vertex->position[0] = x;
+    vertex->position[1] = y;
+    vertex->color[0] = r;
+    vertex->color[1] = g;
+    vertex->color[2] = b;
+    vertex->color[3] = 1.0f;
+}
+
+static void make_scene(void)
+{
+    SceneVertex *vertex = vertices;
+    // Large triangles first, the fan drawn over them
+    static const float large[3][9] = {
+        {-0.95f, -0.90f, 0.90f, -0.78f, -0.70f, 0.92f, 0.85f, 0.30f, 0.20f},
+        {0.95f, 0.95f, -0.80f, 0.88f, 0.60f, -0.95f, 0.20f, 0.55f, 0.90f},
+        {-0.30f, -0.97f, 0.97f, -0.40f, 0.10f, 0.05f, 0.95f, 0.90f, 0.30f},
+    };
+    for (int i = 0; i < 3; ++i)
+    {
+        const float *t = large[i];
+        set_vertex(vertex++, t[0], t[1], t[6], t[7], t[8]);
+        set_vertex(vertex++, t[2], t[3], t[6], t[7], t[8]);
+        set_vertex(vertex++, t[4], t[5], t[6], t[7], t[8]);
+    }
+    // Spokes a fraction of a degree wide, so they break up into dashes
+    // without antialiasing
+    const double pi = 3.14159265358979323846;
+    for (int i = 0; i < ANTIALIASING_BENCH_FAN; ++i)
+    {
+        double angle = 2.0 * pi * (i + 0.37) / ANTIALIASING_BENCH_FAN;
+        double halfWidth = 0.004 + 0.002 * (i % 3);
+        float shade = (i & 1) ? 1.0f : 0.05f;
+        set_vertex(vertex++, 0.03f * (float)cos(angle), 0.03f * (float)sin(angle), shade, shade, shade);
+        set_vertex(vertex++, 0.98f * (float)cos(angle - halfWidth), 0.98f * (float)sin(angle - halfWidth), shade,
+                   shade, shade);
+        set_vertex(vertex++, 0.98f * (float)cos(angle + halfWidth), 0.98f * (float)sin(angle + halfWidth), shade,
+                   shade, shade);
+    }
+}
+
+// Program, buffer and attributes of the scene in the current context.
+static int init_scene(GLuint *program, GLuint *buffer)
+{
+    *program = shader_program_create(shader_color_vert.source, shader_color_frag.source, "aPosition");
+    if (!*program)
+        return 0;
+    GLuint colorLocation = (GLuint)glGetAttribLocation(*program, "aColor");
+    glGenBuffers(1, buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, *buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)0);
+    glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)(2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(colorLocation);
+    glUseProgram(*program);
+    return 1;
+}
+
+static void draw_scene(int width, int height)
+{
+    glViewport(0, 0, width, height);
+    glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, ANTIALIASING_BENCH_VERTICES);
+}
+
+static GLFWwindow *create_window(int width, int height, AntialiasingMode mode)
+{
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    antialiasing_hint(mode, msaaSamples);
+    GLFWwindow *window = glfwCreateWindow(width, height, "antialiasing_bench", NULL, NULL);
+    if (window)
+        glfwMakeContextCurrent(window);
+    return window;
+}
+
+static int read_pixels(int width, int height, unsigned char *pixels)
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return glGetError() == GL_NO_ERROR;
+}
+
+static int make_reference(void)
+{
+    int large = size * ANTIALIASING_BENCH_SUPERSAMPLING;
+    GLFWwindow *window = create_window(large, large, ANTIALIASING_NONE);
+    unsigned char *pixels = (unsigned char *)malloc((size_t)large * (size_t)large * 4);
+    reference = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    edgeMask = (unsigned char *)calloc((size_t)size * (size_t)size, 1);
+    GLuint program = 0, buffer = 0;
+    int ok = window && pixels && reference && edgeMask && init_scene(&program, &buffer);
+    if (ok)
+    {
+        draw_scene(large, large);
+        ok = read_pixels(large, large, pixels);
+    }
+    for (int y = 0; ok && y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            const unsigned char *first = pixels + ((size_t)y * large + (size_t)x) * ANTIALIASING_BENCH_SUPERSAMPLING * 4;
+            int sums[4] = {0, 0, 0, 0};
+            int uniform = 1;
+            for (int sy = 0; sy < ANTIALIASING_BENCH_SUPERSAMPLING; ++sy)
+            {
+                for (int sx = 0; sx < ANTIALIASING_BENCH_SUPERSAMPLING; ++sx)
+                {
+                    const unsigned char *p = first + ((size_t)sy * large + sx) * 4;
+                    for (int c = 0; c < 4; ++c)
+                        sums[c] += p[c];
+                    uniform &= memcmp(p, first, 3) == 0;
+                }
+            }
+            const int count = ANTIALIASING_BENCH_SUPERSAMPLING * ANTIALIASING_BENCH_SUPERSAMPLING;
+            for (int c = 0; c < 4; ++c)
+                reference[((size_t)y * size + x) * 4 + c] = (unsigned char)((sums[c] + count / 2) / count);
+            edgeMask[(size_t)y * size + x] = !uniform;
+        }
+    }
+    if (program)
+        glDeleteProgram(program);
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    free(pixels);
+    if (window)
+        glfwDestroyWindow(window);
+    return ok;
+}
+
+// PSNR of the colour channels against the reference, over the edge pixels
+// when edgesOnly.
+static double psnr(const unsigned char *pixels, int edgesOnly)
+{
+    double sum = 0.0;
+    unsigned long long count = 0;
+    for (size_t i = 0; i < (size_t)size * (size_t)size; ++i)
+    {
+        if (edgesOnly && !edgeMask[i])
+            continue;
+        for (int c = 0; c < 3; ++c)
+        {
+            double d = (double)pixels[i * 4 + c] - (double)reference[i * 4 + c];
+            sum += d * d;
+        }
+        count += 3;
+    }
+    if (count == 0 || sum == 0.0)
+        return INFINITY;
+    return 10.0 * log10(255.0 * 255.0 / (sum / (double)count));
+}
+
+// Times the frames of the current window and prints its row.
+static void measure(const char *name, Antialiasing *antialiasing, GLint samples, unsigned char *pixels)
+{
+    for (int frame = -1; frame < frameCount; ++frame)
+    {
+        double start = bench_seconds();
+        antialiasing_begin(antialiasing);
+        draw_scene(size, size);
+        antialiasing_end(antialiasing);
+        glFinish();
+        if (frame >= 0)
+            times[frame] = bench_seconds() - start;
+    }
+    double frameMs = bench_median_ms(times, frameCount);
+
+    GLint bits[6];
+    glGetIntegerv(GL_RED_BITS, &bits[0]);
+    glGetIntegerv(GL_GREEN_BITS, &bits[1]);
+    glGetIntegerv(GL_BLUE_BITS, &bits[2]);
+    glGetIntegerv(GL_ALPHA_BITS, &bits[3]);
+    glGetIntegerv(GL_DEPTH_BITS, &bits[4]);
+    glGetIntegerv(GL_STENCIL_BITS, &bits[5]);
+    unsigned long long pixelCount = (unsigned long long)size * (unsigned long long)size;
+    unsigned long long colorBytes = (unsigned long long)(bits[0] + bits[1] + bits[2] + bits[3]) / 8;
+    unsigned long long sampleBytes = colorBytes + (unsigned long long)(bits[4] + bits[5]) / 8;
+    unsigned long long bytes = pixelCount * sampleBytes * (unsigned long long)(samples > 1 ? samples : 1);
+    if (samples > 1)
+        bytes += pixelCount * colorBytes; // resolve
+    bytes += antialiasing_extra_bytes(antialiasing);
+
+    if (!read_pixels(size, size, pixels))
+    {
+        printf("%-10s %10s\n", name, "no readback");
+        return;
+    }
+    char label[32];
+    if (samples > 1)
+        snprintf(label, sizeof(label), "%s %dx", name, samples);
+    else
+        snprintf(label, sizeof(label), "%s", name);
+    printf("%-10s %10.2f %10.2f %10.2f %10.2f\n", label, frameMs, (double)bytes / (1024.0 * 1024.0), psnr(pixels, 0),
+           psnr(pixels, 1));
+}
+
+static void run_mode(AntialiasingMode mode)
+{
+    const char *name = antialiasing_mode_name(mode);
+    GLFWwindow *window = create_window(size, size, mode);
+    if (!window)
+    {
+        printf("%-10s %10s\n", name, "no window");
+        return;
+    }
+    GLint samples = 0;
+    glGetIntegerv(GL_SAMPLES, &samples);
+    GLuint program = 0, buffer = 0;
+    unsigned char *pixels = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    if (pixels && init_scene(&program, &buffer))
+    {
+        Antialiasing *antialiasing = mode == ANTIALIASING_FXAA ? antialiasing_create(mode, size, size) : NULL;
+        if ((mode == ANTIALIASING_MSAA && samples <= 1) || (mode == ANTIALIASING_FXAA && !antialiasing))
+            printf("%-10s %10s\n", name, "unavailable");
+        else
+            measure(name, antialiasing, samples, pixels);
+        antialiasing_destroy(antialiasing);
+    }
+    if (program)
+        glDeleteProgram(program);
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    free(pixels);
+    glfwDestroyWindow(window);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > ANTIALIASING_BENCH_MAX_FRAMES)
+        frameCount = ANTIALIASING_BENCH_MAX_FRAMES;
+    if (argc > 3 && atoi(argv[3]) >= 2)
+        msaaSamples = atoi(argv[3]);
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    make_scene();
+    if (!make_reference())
+    {
+        fprintf(stderr, "Failed to render the %dx supersampled reference\n", ANTIALIASING_BENCH_SUPERSAMPLING);
+        glfwTerminate();
+        return 1;
+    }
+
+    GLFWwindow *window = create_window(16, 16, ANTIALIASING_NONE);
+    const char *renderer = window ? (const char *)glGetString(GL_RENDERER) : NULL;
+    printf("INFO: %s, %dx%d, %d frames\n", renderer ? renderer : "unknown renderer", size, size, frameCount);
+    if (window)
+        glfwDestroyWindow(window);
+    printf("%-10s %10s %10s %10s %10s\n", "mode", "frame ms", "MiB", "PSNR dB", "edges dB");
+    for (int mode = 0; mode < ANTIALIASING_MODES; ++mode)
+        run_mode((AntialiasingMode)mode);
+    printf("INFO: PSNR against a %dx%d supersampled reference\n", ANTIALIASING_BENCH_SUPERSAMPLING,
+           ANTIALIASING_BENCH_SUPERSAMPLING);
+
+    free(reference);
+    free(edgeMask);
+    glfwTerminate();
+    return 0;
+}
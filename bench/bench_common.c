@@ -0,0 +1,31 @@
+// bench_common.c
+// See bench_common.h.
+#include "bench_common.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int bench_compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+double bench_median_ms(double *values, int count)
+{
+    qsort(values, (size_t)count, sizeof(double), bench_compare_doubles);
+    return values[count / 2] * 1000.0;
+}
+
+float bench_random(unsigned *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
@@ -0,0 +1,27 @@
+// bench_common.h
+// Timing and input helpers shared by the benchmarks: a monotonic clock, the
+// median of a set of timings, and a seeded random sequence so every run
+// draws the same scene.
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Seconds on the monotonic clock, for differences only.
+double bench_seconds(void);
+// qsort comparison of two doubles, in ascending order.
+int bench_compare_doubles(const void *a, const void *b);
+// The median of count timings in seconds, in milliseconds. The values are
+// sorted in place.
+double bench_median_ms(double *values, int count);
+// The next number in [0, 1) of the sequence seeded by *state, the same on
+// every run.
+float bench_random(unsigned *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_COMMON_H
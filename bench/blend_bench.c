@@ -0,0 +1,234 @@
+// blend_bench.c
+// Cost of the shader blend modes of common/programmable_blend.h, against
+// the blend unit where it has the mode.
+//
+// The scene is a number of translucent overlapping quads over a gradient,
+// each drawn as its own blended draw, so through the shader path each one
+// is a layer with its full-screen composite. For every mode the frame is
+// timed with the blend unit, when it does the mode, and with the shader,
+// from programmable_blend_begin to a glFinish after programmable_blend_end.
+// The difference divided by the quads is the cost of a layer, also given
+// per megapixel so it carries over to other sizes. Both frames are read
+// back and the largest difference in 8-bit levels shows the shader blends
+// like the hardware.
+//
+// Usage: blend_bench [size] [frames] [quads]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/programmable_blend.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLEND_BENCH_MAX_FRAMES 1000
+#define BLEND_BENCH_MAX_QUADS 4096
+
+typedef struct SceneVertex
+{
+    GLfloat position[2];
+    GLfloat color[4];
+} SceneVertex;
+
+static int size = 512;
+static int frameCount = 20;
+static int quadCount = 32;
+static double times[BLEND_BENCH_MAX_FRAMES];
+// The background and the quads, 6 vertices each
+static SceneVertex vertices[(BLEND_BENCH_MAX_QUADS + 1) * 6];
+
+static void set_quad(SceneVertex *vertex, float x0, float y0, float x1, float y1, const float colors[4][4])
+{
+    // Corners in the order 00, 10, 01, 11 of colors
+    static const int corners[6] = {0, 1, 2, 1, 3, 2};
+    for (int i = 0; i < 6; ++i)
+    {
+        int corner = corners[i];
+        vertex[i].position[0] = (corner & 1) ? x1 : x0;
+        vertex[i].position[1] = (corner & 2) ? y1 : y0;
+        memcpy(vertex[i].color, colors[corner], sizeof(vertex[i].color));
+    }
+}
+
+static void make_scene(void)
+{
+    // Gradient background, so that every mode has dark and light
+    // destinations to work on
+    static const float background[4][4] = {
+        {0.05f, 0.10f, 0.20f, 1.0f}, {0.90f, 0.30f, 0.10f, 1.0f}, {0.20f, 0.80f, 0.40f, 1.0f}, {0.95f, 0.95f, 0.85f, 1.0f}};
+    set_quad(vertices, -1.0f, -1.0f, 1.0f, 1.0f, background);
+    unsigned state = 12345u;
+    for (int i = 0; i < quadCount; ++i)
+    {
+        float x = bench_random(&state) * 1.4f - 1.0f;
+        float y = bench_random(&state) * 1.4f - 1.0f;
+        float w = 0.3f + bench_random(&state) * 0.3f;
+        float h = 0.3f + bench_random(&state) * 0.3f;
+        float colors[4][4];
+        float alpha = 0.35f + bench_random(&state) * 0.5f;
+        for (int c = 0; c < 4; ++c)
+        {
+            colors[c][0] = bench_random(&state);
+            colors[c][1] = bench_random(&state);
+            colors[c][2] = bench_random(&state);
+            colors[c][3] = alpha;
+        }
+        set_quad(vertices + (i + 1) * 6, x, y, x + w, y + h, colors);
+    }
+}
+
+// Program, buffer and attributes of the scene in the current context.
+static int init_scene(GLuint *program, GLuint *buffer)
+{
+    *program = shader_program_create(shader_color_vert.source, shader_color_frag.source, "aPosition");
+    if (!*program)
+        return 0;
+    GLuint colorLocation = (GLuint)glGetAttribLocation(*program, "aColor");
+    glGenBuffers(1, buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, *buffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((size_t)(quadCount + 1) * 6 * sizeof(SceneVertex)), vertices,
+                 GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)0);
+    glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)(2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(colorLocation);
+    glUseProgram(*program);
+    return 1;
+}
+
+static void draw_scene(ProgrammableBlend *blend, ProgrammableBlendMode mode)
+{
+    programmable_blend_begin(blend);
+    glViewport(0, 0, size, size);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    for (int i = 0; i < quadCount; ++i)
+    {
+        programmable_blend_draw_begin(blend, mode);
+        glDrawArrays(GL_TRIANGLES, (i + 1) * 6, 6);
+        programmable_blend_draw_end(blend);
+    }
+    programmable_blend_end(blend);
+}
+
+// Median frame time of mode in ms, with the last frame in pixels.
+static double measure(ProgrammableBlend *blend, ProgrammableBlendMode mode, unsigned char *pixels)
+{
+    for (int frame = -1; frame < frameCount; ++frame)
+    {
+        double start = bench_seconds();
+        draw_scene(blend, mode);
+        glFinish();
+        if (frame >= 0)
+            times[frame] = bench_seconds() - start;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return bench_median_ms(times, frameCount);
+}
+
+static int max_difference(const unsigned char *a, const unsigned char *b)
+{
+    int maxDifference = 0;
+    for (size_t i = 0; i < (size_t)size * (size_t)size * 4; ++i)
+    {
+        int d = abs((int)a[i] - (int)b[i]);
+        if (d > maxDifference)
+            maxDifference = d;
+    }
+    return maxDifference;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > BLEND_BENCH_MAX_FRAMES)
+        frameCount = BLEND_BENCH_MAX_FRAMES;
+    if (argc > 3 && atoi(argv[3]) > 0)
+        quadCount = atoi(argv[3]);
+    if (quadCount > BLEND_BENCH_MAX_QUADS)
+        quadCount = BLEND_BENCH_MAX_QUADS;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(size, size, "blend_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    make_scene();
+    GLuint program = 0, buffer = 0;
+    unsigned char *hardwarePixels = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    unsigned char *shaderPixels = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    ProgrammableBlend *blend = NULL;
+    int status = 1;
+    if (hardwarePixels && shaderPixels && init_scene(&program, &buffer))
+        blend = programmable_blend_create(size, size);
+    if (blend)
+    {
+        const char *renderer = (const char *)glGetString(GL_RENDERER);
+        printf("INFO: %s, %dx%d, %d quads, %d frames\n", renderer ? renderer : "unknown renderer", size, size,
+               quadCount, frameCount);
+        printf("%-18s %12s %12s %12s %14s %8s\n", "mode", "hardware ms", "shader ms", "layer ms", "layer ms/MPix",
+               "max err");
+        double megapixels = (double)size * (double)size / 1e6;
+        for (int mode = 0; mode < PROGRAMMABLE_BLEND_MODES; ++mode)
+        {
+            const char *name = programmable_blend_mode_name((ProgrammableBlendMode)mode);
+            double hardwareMs = 0.0;
+            int hardware = programmable_blend_hardware_supports((ProgrammableBlendMode)mode);
+            if (hardware)
+            {
+                programmable_blend_use_hardware(blend, 1);
+                hardwareMs = measure(blend, (ProgrammableBlendMode)mode, hardwarePixels);
+            }
+            programmable_blend_use_hardware(blend, 0);
+            double shaderMs = measure(blend, (ProgrammableBlendMode)mode, shaderPixels);
+            if (hardware)
+            {
+                double layerMs = (shaderMs - hardwareMs) / quadCount;
+                printf("%-18s %12.3f %12.3f %12.4f %14.4f %8d\n", name, hardwareMs, shaderMs, layerMs,
+                       layerMs / megapixels, max_difference(hardwarePixels, shaderPixels));
+            }
+            else
+            {
+                printf("%-18s %12s %12.3f %12.4f %14.4f %8s\n", name, "-", shaderMs, shaderMs / quadCount,
+                       shaderMs / quadCount / megapixels, "-");
+            }
+        }
+        printf("INFO: layer ms is the extra cost of a quad drawn through the shader, or its whole cost where the "
+               "blend unit lacks the mode\n");
+        status = 0;
+    }
+    else
+    {
+        fprintf(stderr, "Failed to set up programmable blending\n");
+    }
+
+    programmable_blend_destroy(blend);
+    if (program)
+        glDeleteProgram(program);
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    free(hardwarePixels);
+    free(shaderPixels);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return status;
+}
@@ -0,0 +1,181 @@
+// etc1_bench.c
+// ETC1 encoder (texture/etc1.h) throughput and quality, and the cost of
+// uploading the result against uploading RGBA8.
+//
+// A procedural image (gradients, hard edges and noise) is encoded at each
+// quality with one thread and with several. The bench reports the median
+// encode time, the throughput in Mpixels/s and the PSNR of the decoded
+// image against the source (RGB, 8 bits per channel). It then times
+// glTexImage2D with the RGBA8 texels against etc1_tex_image_2d() with the
+// encoded ones, followed by glFinish, and prints the bytes each takes.
+//
+// Usage: etc1_bench [size] [iterations] [threads]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <texture/etc1.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ETC1_BENCH_MAX_ITERATIONS 1000
+
+static GLFWwindow *window;
+static int imageSize = 1024;
+static int iterationCount = 5;
+static int threadCount;
+static double times[ETC1_BENCH_MAX_ITERATIONS];
+
+static void make_image(unsigned char *texels, int size)
+{
+    unsigned state = 0x2545f491u;
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            unsigned char *texel = texels + ((size_t)y * (size_t)size + (size_t)x) * 4;
+            int cx = x - size / 2, cy = y - size / 2;
+            int inside = cx * cx + cy * cy < size * size / 9;
+            int checker = (x / 32 + y / 32) & 1;
+            texel[0] = (unsigned char)(inside ? 230 : x * 255 / size);
+            texel[1] = (unsigned char)(inside ? 40 + (int)(state & 15) : y * 255 / size);
+            texel[2] = (unsigned char)(checker ? 200 : 30 + (state >> 4 & 31));
+            texel[3] = 255;
+        }
+    }
+}
+
+static double psnr(const unsigned char *a, const unsigned char *b, size_t texelCount)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < texelCount; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            double d = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+            sum += d * d;
+        }
+    }
+    double mse = sum / ((double)texelCount * 3.0);
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+static void run_encode(const unsigned char *texels, unsigned char *encoded, unsigned char *decoded, Etc1Quality quality,
+                       int threads)
+{
+    for (int i = -1; i < iterationCount; ++i) // -1: warm-up
+    {
+        double start = bench_seconds();
+        etc1_encode(texels, imageSize, imageSize, (ptrdiff_t)imageSize * 4, encoded, quality, threads);
+        if (i >= 0)
+            times[i] = bench_seconds() - start;
+    }
+    double seconds = bench_median_ms(times, iterationCount) / 1000.0;
+    etc1_decode(encoded, imageSize, imageSize, decoded);
+    printf("%-7s %7d %10.2f %10.2f %8.2f\n", etc1_quality_name(quality), threads, seconds * 1000.0,
+           (double)imageSize * imageSize / seconds / 1e6,
+           psnr(texels, decoded, (size_t)imageSize * (size_t)imageSize));
+}
+
+// Median seconds for one upload path, and the error it left
+static double time_upload(const unsigned char *data, int compressed, GLenum *used)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (int i = -1; i < iterationCount; ++i)
+    {
+        double start = bench_seconds();
+        if (compressed)
+        {
+            *used = etc1_tex_image_2d(0, imageSize, imageSize, data);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imageSize, imageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            *used = GL_RGBA;
+        }
+        glFinish();
+        if (i >= 0)
+            times[i] = bench_seconds() - start;
+    }
+    if (glGetError() != GL_NO_ERROR)
+        *used = 0;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+    return bench_median_ms(times, iterationCount) / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) >= 4)
+        imageSize = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        iterationCount = atoi(argv[2]);
+    if (iterationCount > ETC1_BENCH_MAX_ITERATIONS)
+        iterationCount = ETC1_BENCH_MAX_ITERATIONS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = argc > 3 && atoi(argv[3]) > 0 ? atoi(argv[3]) : cpus > 0 ? (int)cpus : 1;
+
+    size_t texelCount = (size_t)imageSize * (size_t)imageSize;
+    unsigned char *texels = (unsigned char *)malloc(texelCount * 4);
+    unsigned char *decoded = (unsigned char *)malloc(texelCount * 4);
+    unsigned char *encoded = (unsigned char *)malloc(etc1_encoded_size(imageSize, imageSize));
+    if (!texels || !decoded || !encoded)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    make_image(texels, imageSize);
+
+    printf("INFO: %dx%d image, %d iterations, %d threads\n", imageSize, imageSize, iterationCount, threadCount);
+    printf("%-7s %7s %10s %10s %8s\n", "quality", "threads", "encode ms", "Mpixel/s", "PSNR dB");
+    for (int quality = 0; quality < ETC1_QUALITIES; ++quality)
+    {
+        run_encode(texels, encoded, decoded, (Etc1Quality)quality, 1);
+        if (threadCount > 1)
+            run_encode(texels, encoded, decoded, (Etc1Quality)quality, threadCount);
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "etc1_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, GL_OES_compressed_ETC1_RGB8_texture %s\n", renderer ? renderer : "unknown renderer",
+           etc1_supported() ? "supported" : "not supported, uploading decoded RGB565");
+    printf("%-8s %10s %12s\n", "upload", "ms", "bytes");
+    GLenum used;
+    double seconds = time_upload(texels, 0, &used);
+    printf("%-8s %10.3f %12zu%s\n", "RGBA8", seconds * 1000.0, texelCount * 4, used ? "" : " (failed)");
+    seconds = time_upload(encoded, 1, &used);
+    printf("%-8s %10.3f %12zu%s\n", used == GL_RGB ? "RGB565" : "ETC1", seconds * 1000.0,
+           used == GL_RGB ? texelCount * 2 : etc1_encoded_size(imageSize, imageSize), used ? "" : " (failed)");
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    free(texels);
+    free(decoded);
+    free(encoded);
+    return 0;
+}
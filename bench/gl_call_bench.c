@@ -0,0 +1,318 @@
+// gl_call_bench.c
+// Cost of the small GL calls in the samples' render loops, in nanoseconds
+// per call. Each call is timed in a tight loop twice: once passing the same
+// values on every call, which a driver that caches state can skip, and once
+// alternating between two values, so the state really changes. A sample
+// is one batch of calls followed by glFinish(), so work the driver defers
+// is paid for inside the batch; the results are the mean over the samples
+// with a 95% confidence interval, the median and the fastest sample.
+//
+// Usage: gl_call_bench [calls per sample] [samples]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_CALL_BENCH_MAX_SAMPLES 200
+
+static GLFWwindow *window;
+static GLuint programs[2];
+static GLint colorLocation;
+static GLuint vertexBuffer;
+static int width = 256;
+static int height = 256;
+static int callCount = 20000;
+static int sampleCount = 30;
+
+static const char *gl_call_bench_vert =
+    "attribute vec4 aPos;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = aPos;\n"
+    "}\n";
+static const char *gl_call_bench_frag =
+    "precision mediump float;\n"
+    "uniform int uColor;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4(float(uColor), 0.4, 0.6, 0.25);\n"
+    "}\n";
+
+// Two small triangles of a few pixels each, so a draw costs its submission
+// rather than its rasterization
+static const float vertices[] = {
+    -0.5f, -0.5f, -0.48f, -0.5f, -0.5f, -0.48f,
+    0.5f, 0.5f, 0.52f, 0.5f, 0.5f, 0.52f,
+};
+
+static int init(void)
+{
+    programs[0] = shader_program_create(gl_call_bench_vert, gl_call_bench_frag, "aPos");
+    programs[1] = shader_program_create(gl_call_bench_vert, gl_call_bench_frag, "aPos");
+    if (!programs[0] || !programs[1])
+        return 0;
+    colorLocation = glGetUniformLocation(programs[0], "uColor");
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glUseProgram(programs[0]);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glViewport(0, 0, width, height);
+    return glGetError() == GL_NO_ERROR;
+}
+
+// Puts back the state every benchmark starts from.
+static void reset_state(void)
+{
+    glUseProgram(programs[0]);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glViewport(0, 0, width, height);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glUniform1i(colorLocation, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarked loops. "same" passes identical values on every call, "changed"
+// alternates between two values on consecutive calls.
+
+static void blend_func_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+static void blend_func_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glBlendFunc(GL_SRC_ALPHA, (i & 1) ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+}
+
+static void blend_func_separate_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+}
+
+static void blend_func_separate_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, (i & 1) ? GL_ONE : GL_ZERO);
+}
+
+static void uniform1i_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glUniform1i(colorLocation, 1);
+}
+
+static void uniform1i_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glUniform1i(colorLocation, i & 1);
+}
+
+static void use_program_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glUseProgram(programs[0]);
+}
+
+static void use_program_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glUseProgram(programs[i & 1]);
+}
+
+static void viewport_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glViewport(0, 0, width, height);
+}
+
+static void viewport_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glViewport(0, 0, width - (i & 1), height);
+}
+
+static void vertex_attrib_pointer_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+}
+
+static void vertex_attrib_pointer_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)(size_t)((i & 1) * 6 * sizeof(float)));
+}
+
+static void draw_arrays_same(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void draw_arrays_changed(int n)
+{
+    for (int i = 0; i < n; ++i)
+        glDrawArrays(GL_TRIANGLES, (i & 1) * 3, 3);
+}
+
+typedef struct GlCallBenchCase
+{
+    const char *call;
+    void (*same)(int n);
+    void (*changed)(int n);
+} GlCallBenchCase;
+
+static const GlCallBenchCase gl_call_bench_cases[] = {
+    {"glBlendFunc", blend_func_same, blend_func_changed},
+    {"glBlendFuncSeparate", blend_func_separate_same, blend_func_separate_changed},
+    {"glUniform1i", uniform1i_same, uniform1i_changed},
+    {"glUseProgram", use_program_same, use_program_changed},
+    {"glViewport", viewport_same, viewport_changed},
+    {"glVertexAttribPointer", vertex_attrib_pointer_same, vertex_attrib_pointer_changed},
+    {"glDrawArrays(3)", draw_arrays_same, draw_arrays_changed},
+};
+
+// ---------------------------------------------------------------------------
+// Statistics
+
+typedef struct GlCallBenchResult
+{
+    double mean;
+    double ci95; // half-width of the 95% confidence interval of the mean
+    double median;
+    double min;
+} GlCallBenchResult;
+
+// Two-sided 95% quantile of Student's t distribution
+static double student_t95(int degrees)
+{
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degrees < 1)
+        return 0.0;
+    if (degrees <= 30)
+        return table[degrees - 1];
+    return degrees <= 60 ? 2.000 : degrees <= 120 ? 1.980 : 1.960;
+}
+
+static GlCallBenchResult summarize(double *samples, int count)
+{
+    GlCallBenchResult result;
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i)
+        sum += samples[i];
+    result.mean = sum / count;
+    double squares = 0.0;
+    for (int i = 0; i < count; ++i)
+        squares += (samples[i] - result.mean) * (samples[i] - result.mean);
+    double deviation = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+    result.ci95 = student_t95(count - 1) * deviation / sqrt((double)count);
+    qsort(samples, (size_t)count, sizeof(double), bench_compare_doubles);
+    result.median = count % 2 ? samples[count / 2] : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+    result.min = samples[0];
+    return result;
+}
+
+// Times sampleCount batches of callCount calls after one batch of warm-up.
+// Returns 0 when the calls raised a GL error.
+static int measure(void (*loop)(int n), GlCallBenchResult *result)
+{
+    double samples[GL_CALL_BENCH_MAX_SAMPLES];
+    reset_state();
+    glFinish();
+    loop(callCount);
+    glFinish();
+    for (int s = 0; s < sampleCount; ++s)
+    {
+        double start = bench_seconds();
+        loop(callCount);
+        glFinish();
+        samples[s] = (bench_seconds() - start) * 1e9 / callCount;
+        // Keep the drawn triangles from piling up across samples
+        glClear(GL_COLOR_BUFFER_BIT);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    *result = summarize(samples, sampleCount);
+    return glGetError() == GL_NO_ERROR;
+}
+
+static void print_result(const char *call, const char *values, const GlCallBenchResult *result)
+{
+    printf("%-22s %-8s %9.1f +- %7.1f %9.1f %9.1f\n", call, values, result->mean, result->ci95, result->median,
+           result->min);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        callCount = atoi(argv[1]) > 0 ? atoi(argv[1]) : callCount;
+    if (argc > 2)
+        sampleCount = atoi(argv[2]) > 1 ? atoi(argv[2]) : sampleCount;
+    if (sampleCount > GL_CALL_BENCH_MAX_SAMPLES)
+        sampleCount = GL_CALL_BENCH_MAX_SAMPLES;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(width, height, "gl_call_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!init())
+    {
+        fprintf(stderr, "Failed to initialize the benchmark state\n");
+        glfwTerminate();
+        return 1;
+    }
+
+    printf("INFO: %s, %d calls per sample, %d samples\n", (const char *)glGetString(GL_RENDERER), callCount,
+           sampleCount);
+    printf("%-22s %-8s %20s %9s %9s\n", "call", "values", "mean ns/call (95%)", "median", "min");
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(gl_call_bench_cases) / sizeof(gl_call_bench_cases[0]); ++i)
+    {
+        const GlCallBenchCase *bench = &gl_call_bench_cases[i];
+        GlCallBenchResult same, changed;
+        if (!measure(bench->same, &same) || !measure(bench->changed, &changed))
+        {
+            printf("ERROR: %s raised a GL error\n", bench->call);
+            ok = 0;
+            continue;
+        }
+        print_result(bench->call, "same", &same);
+        print_result(bench->call, "changed", &changed);
+    }
+
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteProgram(programs[0]);
+    glDeleteProgram(programs[1]);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return ok ? 0 : 1;
+}
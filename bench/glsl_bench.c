@@ -0,0 +1,139 @@
+// glsl_bench.c
+// Throughput of the software renderer's GLSL engine. Compiles a few shaders
+// in the style of the samples, runs each over a large number of invocations
+// and reports the compile time and millions of invocations per second.
+//
+// Usage: glsl_bench [invocations]
+#include "bench_common.h"
+#include <swgl/swgl_glsl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static long invocationCount = 4000000;
+
+typedef struct GlslBenchShader
+{
+    const char *name;
+    SwglGlslStage stage;
+    const char *source;
+} GlslBenchShader;
+
+static const GlslBenchShader glsl_bench_shaders[] = {
+    {"constant color", SWGL_GLSL_FRAGMENT,
+     "precision mediump float;\n"
+     "void main()\n"
+     "{\n"
+     "    gl_FragColor = vec4(0.2, 0.4, 0.6, 0.25);\n"
+     "}\n"},
+    {"transform", SWGL_GLSL_VERTEX,
+     "attribute vec3 aPosition;\n"
+     "attribute vec3 aNormal;\n"
+     "uniform mat4 uModelViewProjection;\n"
+     "uniform mat3 uNormalMatrix;\n"
+     "varying vec3 vNormal;\n"
+     "void main()\n"
+     "{\n"
+     "    vNormal = normalize(uNormalMatrix * aNormal);\n"
+     "    gl_Position = uModelViewProjection * vec4(aPosition, 1.0);\n"
+     "}\n"},
+    {"lighting", SWGL_GLSL_FRAGMENT,
+     "precision mediump float;\n"
+     "uniform vec3 uLightDir;\n"
+     "uniform vec4 uColor;\n"
+     "varying vec3 vNormal;\n"
+     "void main()\n"
+     "{\n"
+     "    vec3 n = normalize(vNormal);\n"
+     "    float diffuse = max(dot(n, uLightDir), 0.0);\n"
+     "    vec3 h = normalize(uLightDir + vec3(0.0, 0.0, 1.0));\n"
+     "    float specular = pow(max(dot(n, h), 0.0), 32.0);\n"
+     "    gl_FragColor = vec4(uColor.rgb * (0.1 + diffuse) + specular, uColor.a);\n"
+     "}\n"},
+    {"divergent loop", SWGL_GLSL_FRAGMENT,
+     "precision mediump float;\n"
+     "varying vec3 vNormal;\n"
+     "void main()\n"
+     "{\n"
+     "    vec2 z = vNormal.xy;\n"
+     "    int n = 0;\n"
+     "    for (int i = 0; i < 16; i++)\n"
+     "    {\n"
+     "        if (dot(z, z) > 4.0)\n"
+     "            break;\n"
+     "        z = vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + vNormal.xy;\n"
+     "        n++;\n"
+     "    }\n"
+     "    gl_FragColor = vec4(vec3(float(n) / 16.0), 1.0);\n"
+     "}\n"},
+};
+
+static int run_shader(const GlslBenchShader *bench, SwglGlslExec *exec)
+{
+    char log[1024];
+    double start = bench_seconds();
+    SwglGlslShader *shader = swgl_glsl_compile(bench->stage, bench->source, log, sizeof(log));
+    double compileMs = (bench_seconds() - start) * 1000.0;
+    if (!shader)
+    {
+        printf("ERROR: %s: %s", bench->name, log);
+        return 0;
+    }
+
+    // Inputs cycle through values in [-1, 1] so branches diverge across lanes
+    enum { ROWS = 64 };
+    static float rows[ROWS][SWGL_GLSL_LANES];
+    static float outputs[ROWS][SWGL_GLSL_LANES];
+    static float uniforms[SWGL_GLSL_MAX_UNIFORM_VECTORS * 4];
+    const float *inputPointers[ROWS];
+    float *outputPointers[ROWS];
+    for (int r = 0; r < ROWS; ++r)
+    {
+        for (int lane = 0; lane < SWGL_GLSL_LANES; ++lane)
+            rows[r][lane] = (float)((r * 7 + lane * 3) % 17) / 8.0f - 1.0f;
+        inputPointers[r] = rows[r];
+        outputPointers[r] = outputs[r];
+    }
+    for (int i = 0; i < SWGL_GLSL_MAX_UNIFORM_VECTORS * 4; ++i)
+        uniforms[i] = (float)(i % 5) * 0.25f;
+    SwglGlslBatch batch = {0};
+    batch.mask = (1u << SWGL_GLSL_LANES) - 1u;
+    batch.uniforms = uniforms;
+    batch.inputs = inputPointers;
+    batch.outputs = outputPointers;
+    for (int k = 0; k < 4; ++k)
+        batch.fragCoord[k] = rows[k];
+    batch.pointCoord[0] = rows[0];
+    batch.pointCoord[1] = rows[1];
+    batch.frontFacing = 1;
+
+    long batches = invocationCount / SWGL_GLSL_LANES;
+    start = bench_seconds();
+    for (long i = 0; i < batches; ++i)
+        swgl_glsl_run(exec, shader, &batch);
+    double seconds = bench_seconds() - start;
+    printf("%-16s %4d instr %4d regs  compile %7.3f ms  %8.2f Minvocations/s\n", bench->name,
+           swgl_glsl_instruction_count(shader), swgl_glsl_register_count(shader), compileMs,
+           (double)batches * SWGL_GLSL_LANES / (seconds * 1e6));
+    swgl_glsl_free(shader);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        invocationCount = atol(argv[1]) > 0 ? atol(argv[1]) : invocationCount;
+
+    SwglGlslExec *exec = swgl_glsl_exec_create();
+    if (!exec)
+    {
+        fprintf(stderr, "Failed to create the shader executor\n");
+        return 1;
+    }
+    printf("INFO: %ld invocations per shader, %d lanes\n", invocationCount, SWGL_GLSL_LANES);
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(glsl_bench_shaders) / sizeof(glsl_bench_shaders[0]); ++i)
+        ok &= run_shader(&glsl_bench_shaders[i], exec);
+    swgl_glsl_exec_destroy(exec);
+    return ok ? 0 : 1;
+}
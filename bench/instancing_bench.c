@@ -0,0 +1,237 @@
+// instancing_bench.c
+// Stress test of common/instancing.h: thousands of copies of one quad (two
+// triangles), each with its own place, size and colour, drawn three ways:
+//   per draw   one glDrawArrays per instance, its vectors set as constant
+//              vertex attributes (glVertexAttrib4fv), as without instancing
+//   pseudo     pseudo-instancing: a batch of copies per draw, the vectors
+//              in a uniform array
+//   hardware   one glDrawArraysInstanced, with GL_ANGLE_instanced_arrays or
+//              GL_EXT_instanced_arrays
+// and reports the draw calls and median frame time up to glFinish of each,
+// and the largest difference from the per-draw image in 8-bit levels.
+//
+// Usage: instancing_bench [size] [frames] [instances...]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/instancing.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INSTANCING_BENCH_MAX_FRAMES 1000
+#define INSTANCING_BENCH_MAX_COUNTS 16
+#define INSTANCING_BENCH_VECTORS 2
+
+typedef enum InstancingBenchMethod
+{
+    INSTANCING_BENCH_PER_DRAW,
+    INSTANCING_BENCH_PSEUDO,
+    INSTANCING_BENCH_HARDWARE,
+    INSTANCING_BENCH_METHODS
+} InstancingBenchMethod;
+
+static const char *methodNames[INSTANCING_BENCH_METHODS] = {"per draw", "pseudo", "hardware"};
+
+static const GLfloat quad[6][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f},
+                                   {1.0f, -1.0f},  {1.0f, 1.0f},  {-1.0f, 1.0f}};
+
+static int size = 512;
+static int frameCount = 10;
+static double times[INSTANCING_BENCH_MAX_FRAMES];
+static Instancing *instancings[INSTANCING_BENCH_METHODS]; // pseudo and hardware
+static GLuint perDrawProgram;
+static GLuint quadBuffer;
+static unsigned char *pixels[INSTANCING_BENCH_METHODS];
+
+// Scale and offset, then colour and point size, of each instance
+static void make_instances(GLfloat *instances, int count)
+{
+    unsigned state = 4242u;
+    for (int i = 0; i < count; ++i, instances += INSTANCING_BENCH_VECTORS * 4)
+    {
+        float extent = 0.005f + bench_random(&state) * 0.02f;
+        instances[0] = extent;
+        instances[1] = extent;
+        instances[2] = bench_random(&state) * 2.0f - 1.0f;
+        instances[3] = bench_random(&state) * 2.0f - 1.0f;
+        instances[4] = bench_random(&state);
+        instances[5] = bench_random(&state);
+        instances[6] = bench_random(&state);
+        instances[7] = 1.0f;
+    }
+}
+
+static int draw_per_instance(const GLfloat *instances, int count)
+{
+    glUseProgram(perDrawProgram);
+    GLint position = glGetAttribLocation(perDrawProgram, "aPosition");
+    GLint placement = glGetAttribLocation(perDrawProgram, "aInstance0");
+    GLint style = glGetAttribLocation(perDrawProgram, "aInstance1");
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glVertexAttribPointer((GLuint)position, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    glEnableVertexAttribArray((GLuint)position);
+    for (int i = 0; i < count; ++i, instances += INSTANCING_BENCH_VECTORS * 4)
+    {
+        glVertexAttrib4fv((GLuint)placement, instances);
+        glVertexAttrib4fv((GLuint)style, instances + 4);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    glDisableVertexAttribArray((GLuint)position);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return count;
+}
+
+static int draw_frame(InstancingBenchMethod method, const GLfloat *instances, int count)
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (method == INSTANCING_BENCH_PER_DRAW)
+        return draw_per_instance(instances, count);
+    return instancing_draw(instancings[method], GL_TRIANGLES, instances, count);
+}
+
+static int max_difference(const unsigned char *a, const unsigned char *b)
+{
+    int largest = 0;
+    for (size_t i = 0; i < (size_t)size * (size_t)size * 4; ++i)
+    {
+        int difference = abs((int)a[i] - (int)b[i]);
+        largest = difference > largest ? difference : largest;
+    }
+    return largest;
+}
+
+static void run_count(int count)
+{
+    GLfloat *instances = (GLfloat *)malloc((size_t)count * INSTANCING_BENCH_VECTORS * 4 * sizeof(GLfloat));
+    if (!instances)
+    {
+        printf("%-10d %-10s %12s\n", count, "", "out of memory");
+        return;
+    }
+    make_instances(instances, count);
+    for (int method = 0; method < INSTANCING_BENCH_METHODS; ++method)
+    {
+        if (method != INSTANCING_BENCH_PER_DRAW && !instancings[method])
+        {
+            printf("%-10d %-10s %10s\n", count, methodNames[method], "unavailable");
+            continue;
+        }
+        int drawCalls = 0;
+        for (int frame = -1; frame < frameCount; ++frame)
+        {
+            double start = bench_seconds();
+            drawCalls = draw_frame((InstancingBenchMethod)method, instances, count);
+            glFinish();
+            if (frame >= 0)
+                times[frame] = bench_seconds() - start;
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels[method]);
+        printf("%-10d %-10s %10d %12.3f", count, methodNames[method], drawCalls, bench_median_ms(times, frameCount));
+        if (method != INSTANCING_BENCH_PER_DRAW)
+            printf(" %10d", max_difference(pixels[method], pixels[INSTANCING_BENCH_PER_DRAW]));
+        printf("\n");
+    }
+    free(instances);
+}
+
+int main(int argc, char **argv)
+{
+    int counts[INSTANCING_BENCH_MAX_COUNTS] = {1000, 10000, 100000};
+    int countCount = 3;
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > INSTANCING_BENCH_MAX_FRAMES)
+        frameCount = INSTANCING_BENCH_MAX_FRAMES;
+    if (argc > 3)
+    {
+        countCount = 0;
+        for (int i = 3; i < argc && countCount < INSTANCING_BENCH_MAX_COUNTS; ++i)
+        {
+            if (atoi(argv[i]) > 0)
+                counts[countCount++] = atoi(argv[i]);
+        }
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(size, size, "instancing_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    for (int method = 0; method < INSTANCING_BENCH_METHODS; ++method)
+    {
+        pixels[method] = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+        if (!pixels[method])
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+    // instanced_vert without instancing: aInstance0 and aInstance1 are set
+    // per draw call
+    perDrawProgram = shader_program_create(shader_instanced_vert.source, shader_color_frag.source, "aPosition");
+    instancings[INSTANCING_BENCH_HARDWARE] = instancing_create(INSTANCING_HARDWARE, shader_instanced_vert.source,
+                                                               shader_color_frag.source, INSTANCING_BENCH_VECTORS, 0);
+    if (instancings[INSTANCING_BENCH_HARDWARE] &&
+        instancing_path(instancings[INSTANCING_BENCH_HARDWARE]) != INSTANCING_HARDWARE)
+    {
+        // No instanced arrays: it fell back to pseudo-instancing, so it is
+        // measured as the pseudo one rather than creating another that
+        // would print its path again
+        instancings[INSTANCING_BENCH_PSEUDO] = instancings[INSTANCING_BENCH_HARDWARE];
+        instancings[INSTANCING_BENCH_HARDWARE] = NULL;
+    }
+    else
+    {
+        instancings[INSTANCING_BENCH_PSEUDO] = instancing_create(INSTANCING_PSEUDO, shader_instanced_vert.source,
+                                                                 shader_color_frag.source, INSTANCING_BENCH_VECTORS, 0);
+    }
+    if (!perDrawProgram)
+    {
+        glfwTerminate();
+        return 1;
+    }
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    for (int method = INSTANCING_BENCH_PSEUDO; method < INSTANCING_BENCH_METHODS; ++method)
+    {
+        if (instancings[method])
+            instancing_set_mesh(instancings[method], &quad[0][0], 6, 2);
+    }
+    glViewport(0, 0, size, size);
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %dx%d, %d frames, pseudo-instancing batch %d\n", renderer ? renderer : "unknown renderer", size,
+           size, frameCount,
+           instancings[INSTANCING_BENCH_PSEUDO] ? instancing_batch_size(instancings[INSTANCING_BENCH_PSEUDO]) : 0);
+    printf("%-10s %-10s %10s %12s %10s\n", "instances", "method", "draws", "frame ms", "max err");
+    for (int i = 0; i < countCount; ++i)
+        run_count(counts[i]);
+
+    for (int method = INSTANCING_BENCH_PSEUDO; method < INSTANCING_BENCH_METHODS; ++method)
+        instancing_destroy(instancings[method]);
+    glDeleteProgram(perDrawProgram);
+    glDeleteBuffers(1, &quadBuffer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
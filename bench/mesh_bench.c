@@ -0,0 +1,237 @@
+// mesh_bench.c
+// Load time of a mesh from OBJ text against the memory-mapped binary
+// format (mesh/mesh.h), and the vertex cache efficiency of both index
+// orders.
+//
+// Each iteration loads the mesh both ways, twice:
+//   warm  the file is in the page cache, as after a previous run
+//   cold  the file's pages were dropped from the page cache first
+//         (posix_fadvise DONTNEED), so it is read from the disk again
+// and reports the time until the vertices and indices are in memory
+// (parsed, or mapped and every page touched) and until they are uploaded
+// into GL buffers (followed by glFinish). OBJ indices are converted to 16
+// bits before the upload when the mesh allows it, as a loader would.
+//
+// Usage: mesh_bench [<file.obj> <file.mesh>] [iterations]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <mesh/mesh.h>
+#include <mesh/obj.h>
+#include <mesh/vertex_cache.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef MESH_BENCH_OBJ
+#define MESH_BENCH_OBJ "meshes/torus.obj"
+#endif
+#ifndef MESH_BENCH_MESH
+#define MESH_BENCH_MESH "torus.mesh"
+#endif
+#define MESH_BENCH_MAX_ITERATIONS 1000
+
+typedef enum MeshBenchCache
+{
+    MESH_BENCH_WARM,
+    MESH_BENCH_COLD,
+    MESH_BENCH_CACHES
+} MeshBenchCache;
+
+typedef enum MeshBenchFormat
+{
+    MESH_BENCH_TEXT,
+    MESH_BENCH_BINARY,
+    MESH_BENCH_FORMATS
+} MeshBenchFormat;
+
+static GLFWwindow *window;
+static int iterationCount = 20;
+static const char *objPath = MESH_BENCH_OBJ;
+static const char *meshPath = MESH_BENCH_MESH;
+// Milliseconds: [format][cache][iteration]
+static double memoryTimes[MESH_BENCH_FORMATS][MESH_BENCH_CACHES][MESH_BENCH_MAX_ITERATIONS];
+static double uploadTimes[MESH_BENCH_FORMATS][MESH_BENCH_CACHES][MESH_BENCH_MAX_ITERATIONS];
+static volatile unsigned pageSum; // keeps the page touching from being optimized out
+
+static void drop_from_page_cache(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static void upload(const void *vertices, size_t vertexBytes, const void *indices, size_t indexBytes)
+{
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexBytes, vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexBytes, indices, GL_STATIC_DRAW);
+    glFinish();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(2, buffers);
+}
+
+static int load_text(int iteration, MeshBenchCache cache)
+{
+    double start = bench_seconds();
+    ObjMesh mesh;
+    if (!obj_load(objPath, &mesh))
+        return 0;
+    double loaded = bench_seconds();
+    size_t indexBytes = (size_t)mesh.indexCount * sizeof(uint32_t);
+    void *indices = mesh.indices;
+    unsigned short *shortIndices = NULL;
+    if (mesh.vertexCount <= 65536)
+    {
+        shortIndices = (unsigned short *)malloc((size_t)mesh.indexCount * sizeof(unsigned short));
+        if (!shortIndices)
+        {
+            obj_free(&mesh);
+            return 0;
+        }
+        for (uint32_t i = 0; i < mesh.indexCount; ++i)
+            shortIndices[i] = (unsigned short)mesh.indices[i];
+        indices = shortIndices;
+        indexBytes = (size_t)mesh.indexCount * sizeof(unsigned short);
+    }
+    upload(mesh.vertices, (size_t)mesh.vertexCount * mesh.vertexStride * sizeof(float), indices, indexBytes);
+    double end = bench_seconds();
+    free(shortIndices);
+    obj_free(&mesh);
+    memoryTimes[MESH_BENCH_TEXT][cache][iteration] = (loaded - start) * 1000.0;
+    uploadTimes[MESH_BENCH_TEXT][cache][iteration] = (end - start) * 1000.0;
+    return 1;
+}
+
+static int load_binary(int iteration, MeshBenchCache cache)
+{
+    double start = bench_seconds();
+    MeshFile file;
+    if (!mesh_file_map(meshPath, &file))
+        return 0;
+    const MeshFileHeader *header = file.header;
+    // The upload reads every page; for the in-memory time touch them here
+    long pageSize = sysconf(_SC_PAGESIZE);
+    unsigned sum = 0;
+    for (size_t offset = 0; offset < file.size; offset += (size_t)pageSize)
+        sum += ((const unsigned char *)file.mapping)[offset];
+    pageSum += sum;
+    double loaded = bench_seconds();
+    upload(file.vertices, (size_t)header->vertexCount * header->vertexStride, file.indices,
+           (size_t)header->indexCount * header->indexSize);
+    mesh_file_unmap(&file);
+    double end = bench_seconds();
+    memoryTimes[MESH_BENCH_BINARY][cache][iteration] = (loaded - start) * 1000.0;
+    uploadTimes[MESH_BENCH_BINARY][cache][iteration] = (end - start) * 1000.0;
+    return 1;
+}
+
+static void print_times(const char *format, const char *cache, double *memory, double *uploaded)
+{
+    qsort(memory, (size_t)iterationCount, sizeof(double), bench_compare_doubles);
+    qsort(uploaded, (size_t)iterationCount, sizeof(double), bench_compare_doubles);
+    printf("%-7s %-5s %10.3f %10.3f %12.3f %10.3f\n", format, cache, memory[iterationCount / 2], memory[0],
+           uploaded[iterationCount / 2], uploaded[0]);
+}
+
+static void print_acmr(void)
+{
+    ObjMesh mesh;
+    MeshFile file;
+    if (!obj_load(objPath, &mesh))
+        return;
+    if (!mesh_file_map(meshPath, &file))
+    {
+        obj_free(&mesh);
+        return;
+    }
+    const MeshFileHeader *header = file.header;
+    uint32_t *indices = (uint32_t *)malloc((size_t)header->indexCount * sizeof(uint32_t));
+    if (indices)
+    {
+        for (uint32_t i = 0; i < header->indexCount; ++i)
+        {
+            indices[i] = header->indexSize == 2 ? ((const unsigned short *)file.indices)[i]
+                                                : ((const uint32_t *)file.indices)[i];
+        }
+        printf("%-7s %10s %10s\n", "order", "FIFO 16", "FIFO 32");
+        printf("%-7s %10.3f %10.3f\n", "obj", vertex_cache_acmr(mesh.indices, mesh.indexCount, mesh.vertexCount, 16),
+               vertex_cache_acmr(mesh.indices, mesh.indexCount, mesh.vertexCount, 32));
+        printf("%-7s %10.3f %10.3f\n", "mesh", vertex_cache_acmr(indices, header->indexCount, header->vertexCount, 16),
+               vertex_cache_acmr(indices, header->indexCount, header->vertexCount, 32));
+        free(indices);
+    }
+    mesh_file_unmap(&file);
+    obj_free(&mesh);
+}
+
+int main(int argc, char **argv)
+{
+    int argument = 1;
+    if (argc > 2)
+    {
+        objPath = argv[1];
+        meshPath = argv[2];
+        argument = 3;
+    }
+    if (argc > argument)
+        iterationCount = atoi(argv[argument]) > 0 ? atoi(argv[argument]) : iterationCount;
+    if (iterationCount > MESH_BENCH_MAX_ITERATIONS)
+        iterationCount = MESH_BENCH_MAX_ITERATIONS;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "mesh_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    printf("INFO: %s against %s, %d iterations\n", objPath, meshPath, iterationCount);
+    print_acmr();
+    int ok = load_text(0, MESH_BENCH_WARM) && load_binary(0, MESH_BENCH_WARM); // warm-up
+    for (int i = 0; ok && i < iterationCount; ++i)
+    {
+        ok = load_text(i, MESH_BENCH_WARM) && load_binary(i, MESH_BENCH_WARM);
+        drop_from_page_cache(objPath);
+        ok = ok && load_text(i, MESH_BENCH_COLD);
+        drop_from_page_cache(meshPath);
+        ok = ok && load_binary(i, MESH_BENCH_COLD);
+    }
+    if (ok)
+    {
+        printf("%-7s %-5s %21s %23s\n", "format", "cache", "in memory ms", "uploaded ms");
+        printf("%-7s %-5s %10s %10s %12s %10s\n", "", "", "median", "min", "median", "min");
+        const char *formats[MESH_BENCH_FORMATS] = {"obj", "mesh"};
+        const char *caches[MESH_BENCH_CACHES] = {"warm", "cold"};
+        for (int cache = 0; cache < MESH_BENCH_CACHES; ++cache)
+        {
+            for (int format = 0; format < MESH_BENCH_FORMATS; ++format)
+                print_times(formats[format], caches[cache], memoryTimes[format][cache], uploadTimes[format][cache]);
+        }
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+// mipmap_bench.c
+// CPU mipmap chains (texture/mipmap.h) against glGenerateMipmap on the same
+// texture, for time and for quality.
+//
+// The image mixes 1-texel black and white stripes, whose average is the
+// test for gamma-correct filtering, with gradients, a disc and noise. The
+// reference levels are exact averages of the level 0 texels each level
+// texel covers, in linear light. Each CPU filter is timed with one thread
+// and with several, and its upload with glTexImage2D per level is timed
+// separately; glGenerateMipmap is timed after uploading level 0. Times
+// end with glFinish where GL is involved.
+//
+// Quality is the PSNR of levels 1 and below against the reference (all
+// levels' texels together). glGenerateMipmap's levels are read back by
+// drawing each one at its own size with GL_NEAREST_MIPMAP_NEAREST into a
+// framebuffer; swgl does not sample textures, so there it is not measured.
+//
+// Usage: mipmap_bench [size] [iterations] [threads]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+#include <texture/mipmap.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MIPMAP_BENCH_MAX_ITERATIONS 1000
+
+static GLFWwindow *window;
+static int imageSize = 1024;
+static int iterationCount = 5;
+static int threadCount;
+static double times[MIPMAP_BENCH_MAX_ITERATIONS];
+static MipmapChain reference;
+
+static void make_image(unsigned char *texels, int size)
+{
+    unsigned state = 0x6b8b4567u;
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            unsigned char *texel = texels + ((size_t)y * (size_t)size + (size_t)x) * 4;
+            int cx = x - size * 3 / 4, cy = y - size / 4;
+            if (x < size / 2 && y < size / 2)
+            {
+                unsigned char stripe = (x + y) & 1 ? 255 : 0;
+                texel[0] = texel[1] = texel[2] = stripe;
+            }
+            else if (cx * cx + cy * cy < size * size / 25)
+            {
+                texel[0] = 240;
+                texel[1] = (unsigned char)(60 + (state & 31));
+                texel[2] = 20;
+            }
+            else
+            {
+                texel[0] = (unsigned char)(x * 255 / size);
+                texel[1] = (unsigned char)(y * 255 / size);
+                texel[2] = (unsigned char)((x ^ y) & 0x40 ? 200 : state >> 8 & 63);
+            }
+            texel[3] = (unsigned char)(x < size / 2 ? 255 : 128 + (y * 127 / size));
+        }
+    }
+}
+
+static double srgb_to_linear(double c)
+{
+    c /= 255.0;
+    return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+static unsigned char linear_to_srgb(double l)
+{
+    double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+    return (unsigned char)(c * 255.0 + 0.5);
+}
+
+// Exact box averages of level 0 in linear light; the size is a power of two
+static int make_reference(const unsigned char *texels)
+{
+    if (!mipmap_build(texels, imageSize, imageSize, MIPMAP_BOX, 1, 1, &reference))
+        return 0;
+    double *linear = (double *)malloc((size_t)imageSize * (size_t)imageSize * 4 * sizeof(double));
+    if (!linear)
+        return 0;
+    for (size_t i = 0; i < (size_t)imageSize * (size_t)imageSize * 4; ++i)
+        linear[i] = i % 4 == 3 ? texels[i] / 255.0 : srgb_to_linear(texels[i]);
+    for (int level = 1; level < reference.levelCount; ++level)
+    {
+        int footprint = imageSize / reference.widths[level];
+        for (int y = 0; y < reference.heights[level]; ++y)
+        {
+            for (int x = 0; x < reference.widths[level]; ++x)
+            {
+                double sum[4] = {0.0, 0.0, 0.0, 0.0};
+                for (int sy = y * footprint; sy < (y + 1) * footprint; ++sy)
+                {
+                    const double *row = linear + ((size_t)sy * (size_t)imageSize + (size_t)x * footprint) * 4;
+                    for (int sx = 0; sx < footprint * 4; ++sx)
+                        sum[sx % 4] += row[sx];
+                }
+                unsigned char *out =
+                    reference.levels[level] + ((size_t)y * (size_t)reference.widths[level] + (size_t)x) * 4;
+                double count = (double)footprint * footprint;
+                for (int c = 0; c < 3; ++c)
+                    out[c] = linear_to_srgb(sum[c] / count);
+                out[3] = (unsigned char)(sum[3] / count * 255.0 + 0.5);
+            }
+        }
+    }
+    free(linear);
+    return 1;
+}
+
+// PSNR of levels 1 and below against the reference
+static double chain_psnr(const MipmapChain *chain)
+{
+    double sum = 0.0, count = 0.0;
+    for (int level = 1; level < chain->levelCount; ++level)
+    {
+        size_t n = (size_t)chain->widths[level] * (size_t)chain->heights[level] * 4;
+        for (size_t i = 0; i < n; ++i)
+        {
+            double d = (double)chain->levels[level][i] - (double)reference.levels[level][i];
+            sum += d * d;
+        }
+        count += (double)n;
+    }
+    return sum > 0.0 ? 10.0 * log10(255.0 * 255.0 / (sum / count)) : INFINITY;
+}
+
+// Reads the levels of a mipmapped texture into chain, which has their sizes
+static int read_levels(GLuint texture, MipmapChain *chain)
+{
+    GLuint program =
+        shader_program_create(shader_texture_quad_vert.source, shader_texture_quad_frag.source, "aPosition");
+    if (!program)
+        return 0;
+    GLuint target, framebuffer;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, chain->widths[1], chain->heights[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    int ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    static const float quad[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    glUseProgram(program);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+    glEnableVertexAttribArray(0);
+    glDisable(GL_BLEND);
+    for (int level = 1; ok && level < chain->levelCount; ++level)
+    {
+        // Drawn at its own size, the level's LOD is exactly level
+        glViewport(0, 0, chain->widths[level], chain->heights[level]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glReadPixels(0, 0, chain->widths[level], chain->heights[level], GL_RGBA, GL_UNSIGNED_BYTE,
+                     chain->levels[level]);
+    }
+    glDisableVertexAttribArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &target);
+    glDeleteProgram(program);
+    return ok && glGetError() == GL_NO_ERROR;
+}
+
+static void run_cpu(const unsigned char *texels, MipmapFilter filter, int gammaCorrect)
+{
+    MipmapChain chain;
+    double buildMs[2] = {0.0, 0.0};
+    int threadCounts[2] = {1, threadCount};
+    for (int t = 0; t < (threadCount > 1 ? 2 : 1); ++t)
+    {
+        for (int i = -1; i < iterationCount; ++i) // -1: warm-up
+        {
+            double start = bench_seconds();
+            if (!mipmap_build(texels, imageSize, imageSize, filter, gammaCorrect, threadCounts[t], &chain))
+            {
+                fprintf(stderr, "Out of memory\n");
+                return;
+            }
+            if (i >= 0)
+                times[i] = bench_seconds() - start;
+            mipmap_free(&chain);
+        }
+        buildMs[t] = bench_median_ms(times, iterationCount);
+    }
+    mipmap_build(texels, imageSize, imageSize, filter, gammaCorrect, threadCount, &chain);
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (int i = -1; i < iterationCount; ++i)
+    {
+        double start = bench_seconds();
+        mipmap_upload(&chain);
+        glFinish();
+        if (i >= 0)
+            times[i] = bench_seconds() - start;
+    }
+    glDeleteTextures(1, &texture);
+    char name[32];
+    snprintf(name, sizeof(name), "%s%s", mipmap_filter_name(filter), gammaCorrect ? " sRGB" : "");
+    char threaded[16] = "";
+    if (threadCount > 1)
+        snprintf(threaded, sizeof(threaded), "%.2f", buildMs[1]);
+    printf("%-18s %10.2f %10s %10.2f %8.2f\n", name, buildMs[0], threaded, bench_median_ms(times, iterationCount),
+           chain_psnr(&chain));
+    mipmap_free(&chain);
+}
+
+static void run_gl(const unsigned char *texels, int sampled)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (int i = -1; i < iterationCount; ++i)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imageSize, imageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+        glFinish();
+        double start = bench_seconds();
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+        if (i >= 0)
+            times[i] = bench_seconds() - start;
+    }
+    double generateMs = bench_median_ms(times, iterationCount);
+
+    // The reference chain has the sizes; its copy gets the levels read back
+    MipmapChain chain;
+    int ok = sampled && mipmap_build(texels, imageSize, imageSize, MIPMAP_BOX, 0, 1, &chain);
+    if (ok && read_levels(texture, &chain))
+        printf("%-18s %10s %10s %10.2f %8.2f\n", "glGenerateMipmap", "", "", generateMs, chain_psnr(&chain));
+    else
+        printf("%-18s %10s %10s %10.2f %8s\n", "glGenerateMipmap", "", "", generateMs, "n/a");
+    if (ok)
+        mipmap_free(&chain);
+    glDeleteTextures(1, &texture);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) >= 2)
+        imageSize = atoi(argv[1]);
+    if (imageSize & (imageSize - 1))
+    {
+        fprintf(stderr, "The size must be a power of two\n");
+        return 1;
+    }
+    if (argc > 2 && atoi(argv[2]) > 0)
+        iterationCount = atoi(argv[2]);
+    if (iterationCount > MIPMAP_BENCH_MAX_ITERATIONS)
+        iterationCount = MIPMAP_BENCH_MAX_ITERATIONS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = argc > 3 && atoi(argv[3]) > 0 ? atoi(argv[3]) : cpus > 0 ? (int)cpus : 1;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "mipmap_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    unsigned char *texels = (unsigned char *)malloc((size_t)imageSize * (size_t)imageSize * 4);
+    if (!texels)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    make_image(texels, imageSize);
+    int ok = make_reference(texels);
+    if (ok)
+    {
+        const char *renderer = (const char *)glGetString(GL_RENDERER);
+        int sampled = !renderer || !strstr(renderer, "swgl");
+        printf("INFO: %s, %dx%d, %d iterations, %d threads\n", renderer ? renderer : "unknown renderer", imageSize,
+               imageSize, iterationCount, threadCount);
+        printf("%-18s %10s %10s %10s %8s\n", "filter", "1 thread", "threads", "upload", "PSNR dB");
+        for (int filter = 0; filter < MIPMAP_FILTERS; ++filter)
+        {
+            run_cpu(texels, (MipmapFilter)filter, 0);
+            run_cpu(texels, (MipmapFilter)filter, 1);
+        }
+        run_gl(texels, sampled);
+        printf("INFO: times in ms; PSNR against exact box averages in linear light\n");
+        mipmap_free(&reference);
+    }
+    else
+    {
+        fprintf(stderr, "Out of memory\n");
+    }
+
+    free(texels);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+// oit_bench.c
+// Weighted blended transparency (common/weighted_oit.h) against sorting on
+// the CPU, on scenes of random translucent triangles that turn a little
+// every frame.
+//
+// For each triangle count the scene is drawn three ways:
+//   sorted     the triangles' centres are sorted back to front every frame
+//              (common/transparency_sort.h) and an index buffer in that order is uploaded and
+//              drawn with glDrawElements; the reference
+//   unsorted   drawn in submission order, as if no one sorted
+//   oit        drawn in submission order into the weighted targets, then
+//              composited
+// and reports the median frame time up to glFinish, the time spent sorting
+// and building the indices, and the mean difference from the sorted frame
+// in 8-bit levels over the colour channels. The triangles shrink as their
+// number grows, so that about 20 layers cover the average pixel at every
+// count.
+//
+// Usage: oit_bench [size] [frames] [triangles...]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+#include <common/transparency_sort.h>
+#include <common/weighted_oit.h>
+#include <shaders.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OIT_BENCH_MAX_FRAMES 1000
+#define OIT_BENCH_MAX_COUNTS 16
+
+typedef struct SceneVertex
+{
+    GLfloat position[3];
+    GLubyte color[4];
+} SceneVertex;
+
+typedef enum OitBenchMethod
+{
+    OIT_BENCH_SORTED,
+    OIT_BENCH_UNSORTED,
+    OIT_BENCH_OIT,
+    OIT_BENCH_METHODS
+} OitBenchMethod;
+
+static const char *methodNames[OIT_BENCH_METHODS] = {"sorted", "unsorted", "oit"};
+
+static int size = 512;
+static int frameCount = 10;
+static int triangleCount;
+static double times[OIT_BENCH_MAX_FRAMES];
+static double sortTimes[OIT_BENCH_MAX_FRAMES];
+static SceneVertex *vertices;
+static GLfloat *centres; // 3 per triangle
+static TransparencySort *sorter;
+static GLuint *indices;
+static unsigned char *pixels[OIT_BENCH_METHODS];
+static GLuint programs[2]; // straight alpha, oit
+static GLuint colorLocation;
+static GLuint vertexBuffer;
+static GLuint indexBuffer;
+static WeightedOit *oit;
+
+static void make_scene(void)
+{
+    unsigned state = 777u;
+    float extent = 0.3f * sqrtf(10000.0f / (float)triangleCount);
+    for (int i = 0; i < triangleCount; ++i)
+    {
+        GLfloat *centre = centres + i * 3;
+        for (int c = 0; c < 3; ++c)
+            centre[c] = bench_random(&state) * 2.0f - 1.0f;
+        GLubyte color[4] = {(GLubyte)(bench_random(&state) * 255.0f), (GLubyte)(bench_random(&state) * 255.0f),
+                            (GLubyte)(bench_random(&state) * 255.0f), (GLubyte)(51.0f + bench_random(&state) * 102.0f)};
+        for (int v = 0; v < 3; ++v)
+        {
+            SceneVertex *vertex = &vertices[i * 3 + v];
+            for (int c = 0; c < 3; ++c)
+                vertex->position[c] = centre[c] + (bench_random(&state) - 0.5f) * extent;
+            memcpy(vertex->color, color, sizeof(color));
+        }
+    }
+}
+
+// Rotation of frame, scaled so the cube stays within the clip volume;
+// column-major
+static void make_transform(int frame, GLfloat transform[16])
+{
+    float yaw = 0.05f * (float)frame, pitch = 0.4f;
+    float s = 1.0f / sqrtf(3.0f);
+    float cy = cosf(yaw), sy = sinf(yaw), cp = cosf(pitch), sp = sinf(pitch);
+    // Rx(pitch) * Ry(yaw)
+    GLfloat m[16] = {cy * s, sp * sy * s, -cp * sy * s, 0.0f, 0.0f, cp * s, sp * s, 0.0f,
+                     sy * s, -sp * cy * s, cp * cy * s, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    memcpy(transform, m, sizeof(m));
+}
+
+// Back-to-front indices of the triangles under transform: larger NDC z is
+// farther.
+static void sort_triangles(const GLfloat transform[16])
+{
+    const float depthRow[4] = {transform[2], transform[6], transform[10], transform[14]};
+    transparency_sort_triangles(sorter, centres, (size_t)triangleCount, depthRow, NULL, indices);
+}
+
+// Both programs run oit_vert, so aColor gets the same location in each.
+static int init_programs(void)
+{
+    GLuint vertexShader = shader_program_compile(GL_VERTEX_SHADER, shader_oit_vert.source);
+    GLuint fragmentShader = shader_program_compile(GL_FRAGMENT_SHADER, shader_color_frag.source);
+    if (vertexShader && fragmentShader)
+        programs[0] = shader_program_link(vertexShader, fragmentShader, "aPosition");
+    if (vertexShader && oit)
+        programs[1] = shader_program_link(vertexShader, weighted_oit_fragment_shader(oit), "aPosition");
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    if (!programs[0])
+        return 0;
+    colorLocation = (GLuint)glGetAttribLocation(programs[0], "aColor");
+    return 1;
+}
+
+static void set_transform(GLuint program, int frame)
+{
+    GLfloat transform[16];
+    make_transform(frame, transform);
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "uTransform"), 1, GL_FALSE, transform);
+}
+
+static void draw_frame(OitBenchMethod method, int frame, double *sortSeconds)
+{
+    glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    *sortSeconds = 0.0;
+    if (method == OIT_BENCH_OIT)
+    {
+        weighted_oit_begin(oit);
+        for (int pass = 0; pass < weighted_oit_pass_count(oit); ++pass)
+        {
+            weighted_oit_pass(oit, pass, programs[1]);
+            set_transform(programs[1], frame);
+            glDrawArrays(GL_TRIANGLES, 0, triangleCount * 3);
+        }
+        weighted_oit_end(oit);
+        return;
+    }
+    set_transform(programs[0], frame);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (method == OIT_BENCH_SORTED)
+    {
+        double start = bench_seconds();
+        GLfloat transform[16];
+        make_transform(frame, transform);
+        sort_triangles(transform);
+        *sortSeconds = bench_seconds() - start;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)((size_t)triangleCount * 3 * sizeof(GLuint)), indices,
+                     GL_STREAM_DRAW);
+        glDrawElements(GL_TRIANGLES, triangleCount * 3, GL_UNSIGNED_INT, (void *)0);
+    }
+    else
+    {
+        glDrawArrays(GL_TRIANGLES, 0, triangleCount * 3);
+    }
+    glDisable(GL_BLEND);
+}
+
+static void measure(OitBenchMethod method, double *frameMs, double *sortMs)
+{
+    for (int frame = -1; frame < frameCount; ++frame)
+    {
+        double sortSeconds;
+        double start = bench_seconds();
+        draw_frame(method, frame < 0 ? 0 : frame, &sortSeconds);
+        glFinish();
+        if (frame >= 0)
+        {
+            times[frame] = bench_seconds() - start;
+            sortTimes[frame] = sortSeconds;
+        }
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels[method]);
+    *frameMs = bench_median_ms(times, frameCount);
+    *sortMs = bench_median_ms(sortTimes, frameCount);
+}
+
+static double mean_difference(const unsigned char *a, const unsigned char *b)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < (size_t)size * (size_t)size * 4; ++i)
+    {
+        if ((i & 3) != 3)
+            sum += abs((int)a[i] - (int)b[i]);
+    }
+    return sum / ((double)size * (double)size * 3.0);
+}
+
+static void run_count(int count, int uintIndices)
+{
+    triangleCount = count;
+    vertices = (SceneVertex *)malloc((size_t)count * 3 * sizeof(SceneVertex));
+    centres = (GLfloat *)malloc((size_t)count * 3 * sizeof(GLfloat));
+    sorter = transparency_sort_create((size_t)count, 0);
+    indices = (GLuint *)malloc((size_t)count * 3 * sizeof(GLuint));
+    if (!vertices || !centres || !sorter || !indices)
+    {
+        printf("%-10d %-10s %12s\n", count, "", "out of memory");
+    }
+    else
+    {
+        make_scene();
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((size_t)count * 3 * sizeof(SceneVertex)), vertices,
+                     GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)0);
+        glVertexAttribPointer(colorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SceneVertex),
+                              (void *)(3 * sizeof(GLfloat)));
+        for (int method = 0; method < OIT_BENCH_METHODS; ++method)
+        {
+            if ((method == OIT_BENCH_SORTED && !uintIndices) || (method == OIT_BENCH_OIT && !programs[1]))
+            {
+                printf("%-10d %-10s %12s\n", count, methodNames[method], "unavailable");
+                continue;
+            }
+            double frameMs, sortMs;
+            measure((OitBenchMethod)method, &frameMs, &sortMs);
+            printf("%-10d %-10s %12.3f %12.3f", count, methodNames[method], frameMs, sortMs);
+            if (method != OIT_BENCH_SORTED && uintIndices)
+                printf(" %12.3f", mean_difference(pixels[method], pixels[OIT_BENCH_SORTED]));
+            printf("\n");
+        }
+    }
+    free(vertices);
+    free(centres);
+    transparency_sort_destroy(sorter);
+    free(indices);
+}
+
+int main(int argc, char **argv)
+{
+    int counts[OIT_BENCH_MAX_COUNTS] = {10000, 100000, 1000000};
+    int countCount = 3;
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > OIT_BENCH_MAX_FRAMES)
+        frameCount = OIT_BENCH_MAX_FRAMES;
+    if (argc > 3)
+    {
+        countCount = 0;
+        for (int i = 3; i < argc && countCount < OIT_BENCH_MAX_COUNTS; ++i)
+        {
+            if (atoi(argv[i]) > 0)
+                counts[countCount++] = atoi(argv[i]);
+        }
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(size, size, "oit_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    for (int method = 0; method < OIT_BENCH_METHODS; ++method)
+    {
+        pixels[method] = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+        if (!pixels[method])
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+    oit = weighted_oit_create(size, size);
+    if (!init_programs())
+    {
+        glfwTerminate();
+        return 1;
+    }
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(colorLocation);
+    glViewport(0, 0, size, size);
+    int uintIndices = glfwExtensionSupported("GL_OES_element_index_uint");
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %dx%d, %d frames, oit targets %.1f MiB\n", renderer ? renderer : "unknown renderer", size, size,
+           frameCount, (double)weighted_oit_bytes(oit) / (1024.0 * 1024.0));
+    if (!uintIndices)
+        printf("INFO: no GL_OES_element_index_uint, sorting unavailable\n");
+    printf("%-10s %-10s %12s %12s %12s\n", "triangles", "method", "frame ms", "sort ms", "mean err");
+    for (int i = 0; i < countCount; ++i)
+        run_count(counts[i], uintIndices);
+    printf("INFO: errors in 8-bit levels against the sorted frame\n");
+
+    weighted_oit_destroy(oit);
+    for (int i = 0; i < 2; ++i)
+    {
+        if (programs[i])
+            glDeleteProgram(programs[i]);
+    }
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    for (int method = 0; method < OIT_BENCH_METHODS; ++method)
+        free(pixels[method]);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,485 @@
+// precision_bench.c
+// Cost and accuracy of lowp, mediump and highp for each of the samples'
+// shaders (shaders.h). Every shader is rewritten into the three variants:
+// each precision qualifier becomes the variant's, and default precision
+// statements for float and int are added after the #version line. It is
+// linked, unchanged, with a partner of the other stage, preferably the one
+// with the same name, e.g. qualifiers_vert with qualifiers_frag.
+//
+// The inputs are generated from what the program declares. The attribute
+// whose name contains "Pos" spans the viewport on a 32x32 grid; the other
+// attributes, the uniforms and a gradient texture on every sampler get
+// smooth values in [0, 1]; matrices are the identity. Each variant draws
+// the grid a number of times per frame into a hidden window; the frame time
+// is the median up to glFinish. The error is the difference from the highp
+// frame in 8-bit levels, over all channels: the largest and the mean.
+//
+// Drivers that run every precision at 32 bits, like llvmpipe and swgl,
+// show no error and no speed-up; the precision formats of the driver
+// (glGetShaderPrecisionFormat) are printed first.
+//
+// Usage: precision_bench [size] [frames] [draws per frame]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRECISION_BENCH_MAX_FRAMES 1000
+#define PRECISION_BENCH_GRID 32
+#define PRECISION_BENCH_MAX_ATTRIBUTES 16
+#define PRECISION_BENCH_TEXTURE_SIZE 64
+
+typedef enum PrecisionVariant
+{
+    PRECISION_HIGH,
+    PRECISION_MEDIUM,
+    PRECISION_LOW,
+    PRECISION_VARIANTS
+} PrecisionVariant;
+
+static const char *precisionNames[PRECISION_VARIANTS] = {"highp", "mediump", "lowp"};
+
+static GLFWwindow *window;
+static int size = 256;
+static int frameCount = 20;
+static int drawCount = 8;
+static double times[PRECISION_BENCH_MAX_FRAMES];
+static GLuint attributeBuffers[PRECISION_BENCH_MAX_ATTRIBUTES];
+static GLuint indexBuffer;
+static GLuint textures[2]; // 2D and cube map
+static unsigned char *pixels[PRECISION_VARIANTS];
+
+static void print_formats(void)
+{
+    static const GLenum stages[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    static const char *stageNames[2] = {"vertex", "fragment"};
+    static const GLenum floats[PRECISION_VARIANTS] = {GL_HIGH_FLOAT, GL_MEDIUM_FLOAT, GL_LOW_FLOAT};
+    static const GLenum ints[PRECISION_VARIANTS] = {GL_HIGH_INT, GL_MEDIUM_INT, GL_LOW_INT};
+    for (int stage = 0; stage < 2; ++stage)
+    {
+        printf("INFO: %-8s", stageNames[stage]);
+        for (int variant = 0; variant < PRECISION_VARIANTS; ++variant)
+        {
+            GLint range[2] = {0, 0}, precision = 0, intRange[2] = {0, 0}, intPrecision = 0;
+            glGetShaderPrecisionFormat(stages[stage], floats[variant], range, &precision);
+            glGetShaderPrecisionFormat(stages[stage], ints[variant], intRange, &intPrecision);
+            printf("  %s float 2^%d, %d bits, int 2^%d", precisionNames[variant], range[1], precision, intRange[1]);
+        }
+        printf("\n");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Variants
+
+static int is_word_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Every lowp, mediump and highp in source becomes the variant's, and the
+// default precisions are set after the #version line.
+static char *rewrite(const char *source, PrecisionVariant variant)
+{
+    static const char *qualifiers[PRECISION_VARIANTS] = {"highp", "mediump", "lowp"};
+    const char *name = precisionNames[variant];
+    char precisions[64];
+    snprintf(precisions, sizeof(precisions), "precision %s float;precision %s int;", name, name);
+    char *text = shader_program_insert_defines(source, precisions);
+    if (!text)
+        return NULL;
+    // Each qualifier grows by at most 2 bytes (lowp to mediump)
+    char *result = (char *)malloc(strlen(text) * 2 + 1);
+    if (!result)
+    {
+        free(text);
+        return NULL;
+    }
+    char *out = result;
+    const char *in = text;
+    while (*in)
+    {
+        int replaced = 0;
+        if (in == text || !is_word_char(in[-1]))
+        {
+            for (int q = 0; q < PRECISION_VARIANTS && !replaced; ++q)
+            {
+                size_t qualifierLength = strlen(qualifiers[q]);
+                if (strncmp(in, qualifiers[q], qualifierLength) == 0 && !is_word_char(in[qualifierLength]))
+                {
+                    out += sprintf(out, "%s", name);
+                    in += qualifierLength;
+                    replaced = 1;
+                }
+            }
+        }
+        if (!replaced)
+            *out++ = *in++;
+    }
+    *out = '\0';
+    free(text);
+    return result;
+}
+
+// The shader of the other stage that links with shader, preferring the one
+// with the same name apart from the _vert/_frag suffix. NULL when none does.
+static const ShaderSource *find_partner(const ShaderSource *shader)
+{
+    size_t baseLength = strlen(shader->name) > 5 ? strlen(shader->name) - 5 : 0;
+    const ShaderSource *fallback = NULL;
+    for (int i = 0; i < SHADER_SOURCE_COUNT; ++i)
+    {
+        const ShaderSource *partner = shader_sources[i];
+        if (partner->stage == shader->stage)
+            continue;
+        int sameName = strlen(partner->name) == baseLength + 5 && strncmp(partner->name, shader->name, baseLength) == 0;
+        if (!sameName && fallback)
+            continue;
+        int vertex = shader->stage == SHADER_STAGE_VERTEX;
+        GLuint program = shader_program_try_create(vertex ? shader->source : partner->source,
+                                                   vertex ? partner->source : shader->source, NULL);
+        if (!program)
+            continue;
+        glDeleteProgram(program);
+        if (sameName)
+            return partner;
+        fallback = partner;
+    }
+    return fallback;
+}
+
+// ---------------------------------------------------------------------------
+// Inputs
+
+static float smooth_value(float x, float y, int index)
+{
+    return 0.5f + 0.5f * sinf(3.1f * x + 2.3f * y + 1.7f * (float)index);
+}
+
+static void create_inputs(void)
+{
+    const int side = PRECISION_BENCH_GRID + 1;
+    GLfloat *values = (GLfloat *)malloc((size_t)side * side * 4 * sizeof(GLfloat));
+    GLushort *indices = (GLushort *)malloc((size_t)PRECISION_BENCH_GRID * PRECISION_BENCH_GRID * 6 * sizeof(GLushort));
+    if (!values || !indices)
+    {
+        free(values);
+        free(indices);
+        return;
+    }
+    // Buffer 0 holds the positions, the others smooth vec4s
+    glGenBuffers(PRECISION_BENCH_MAX_ATTRIBUTES, attributeBuffers);
+    for (int a = 0; a < PRECISION_BENCH_MAX_ATTRIBUTES; ++a)
+    {
+        for (int y = 0; y < side; ++y)
+        {
+            for (int x = 0; x < side; ++x)
+            {
+                GLfloat *v = values + ((size_t)y * side + x) * 4;
+                float fx = (float)x / PRECISION_BENCH_GRID * 2.0f - 1.0f;
+                float fy = (float)y / PRECISION_BENCH_GRID * 2.0f - 1.0f;
+                for (int c = 0; c < 4; ++c)
+                    v[c] = smooth_value(fx, fy, a * 4 + c);
+                if (a == 0)
+                {
+                    v[0] = fx;
+                    v[1] = fy;
+                    v[2] = 0.0f;
+                    v[3] = 1.0f;
+                }
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, attributeBuffers[a]);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((size_t)side * side * 4 * sizeof(GLfloat)), values, GL_STATIC_DRAW);
+    }
+    GLushort *index = indices;
+    for (int y = 0; y < PRECISION_BENCH_GRID; ++y)
+    {
+        for (int x = 0; x < PRECISION_BENCH_GRID; ++x)
+        {
+            GLushort corner = (GLushort)(y * side + x);
+            *index++ = corner;
+            *index++ = (GLushort)(corner + 1);
+            *index++ = (GLushort)(corner + side);
+            *index++ = (GLushort)(corner + 1);
+            *index++ = (GLushort)(corner + side + 1);
+            *index++ = (GLushort)(corner + side);
+        }
+    }
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(index - indices) * (GLsizeiptr)sizeof(GLushort), indices,
+                 GL_STATIC_DRAW);
+
+    // A gradient with a little detail, for 2D and cube samplers
+    unsigned char *texels = (unsigned char *)values;
+    for (int y = 0; y < PRECISION_BENCH_TEXTURE_SIZE; ++y)
+    {
+        for (int x = 0; x < PRECISION_BENCH_TEXTURE_SIZE; ++x)
+        {
+            unsigned char *t = texels + ((size_t)y * PRECISION_BENCH_TEXTURE_SIZE + x) * 4;
+            t[0] = (unsigned char)(x * 255 / (PRECISION_BENCH_TEXTURE_SIZE - 1));
+            t[1] = (unsigned char)(y * 255 / (PRECISION_BENCH_TEXTURE_SIZE - 1));
+            t[2] = (unsigned char)(smooth_value((float)x * 0.3f, (float)y * 0.3f, 0) * 255.0f);
+            t[3] = 255;
+        }
+    }
+    glGenTextures(2, textures);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textures[1]);
+    for (int face = 0; face < 6; ++face)
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, PRECISION_BENCH_TEXTURE_SIZE,
+                     PRECISION_BENCH_TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textures[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PRECISION_BENCH_TEXTURE_SIZE, PRECISION_BENCH_TEXTURE_SIZE, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, texels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    free(values);
+    free(indices);
+}
+
+static void set_uniform(GLint location, GLenum type, int index)
+{
+    GLfloat v[4];
+    for (int c = 0; c < 4; ++c)
+        v[c] = smooth_value(0.37f, 0.61f, index * 4 + c);
+    static const GLfloat identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    static const GLfloat identity3[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    static const GLfloat identity2[4] = {1, 0, 0, 1};
+    switch (type)
+    {
+    case GL_FLOAT:
+        glUniform1fv(location, 1, v);
+        break;
+    case GL_FLOAT_VEC2:
+        glUniform2fv(location, 1, v);
+        break;
+    case GL_FLOAT_VEC3:
+        glUniform3fv(location, 1, v);
+        break;
+    case GL_FLOAT_VEC4:
+        glUniform4fv(location, 1, v);
+        break;
+    case GL_INT:
+    case GL_BOOL:
+        glUniform1i(location, 1);
+        break;
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:
+        glUniform2i(location, 1, 2);
+        break;
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:
+        glUniform3i(location, 1, 2, 3);
+        break;
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+        glUniform4i(location, 1, 2, 3, 4);
+        break;
+    case GL_FLOAT_MAT2:
+        glUniformMatrix2fv(location, 1, GL_FALSE, identity2);
+        break;
+    case GL_FLOAT_MAT3:
+        glUniformMatrix3fv(location, 1, GL_FALSE, identity3);
+        break;
+    case GL_FLOAT_MAT4:
+        glUniformMatrix4fv(location, 1, GL_FALSE, identity);
+        break;
+    case GL_SAMPLER_2D:
+        glUniform1i(location, 0);
+        break;
+    case GL_SAMPLER_CUBE:
+        glUniform1i(location, 1);
+        break;
+    default:
+        break;
+    }
+}
+
+// Feeds every active uniform and attribute of program.
+static void bind_inputs(GLuint program)
+{
+    glUseProgram(program);
+    GLint count = 0;
+    char name[128];
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLint arraySize;
+        GLenum type;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), NULL, &arraySize, &type, name);
+        // Array elements are set one by one, as name[0], name[1], ...
+        char *bracket = strchr(name, '[');
+        if (bracket)
+            *bracket = '\0';
+        for (GLint element = 0; element < arraySize; ++element)
+        {
+            char elementName[160];
+            if (arraySize > 1)
+                snprintf(elementName, sizeof(elementName), "%s[%d]", name, element);
+            else
+                snprintf(elementName, sizeof(elementName), "%s", name);
+            set_uniform(glGetUniformLocation(program, elementName), type, i + element);
+        }
+    }
+
+    for (int a = 0; a < PRECISION_BENCH_MAX_ATTRIBUTES; ++a)
+        glDisableVertexAttribArray((GLuint)a);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    int nextBuffer = 1;
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLint arraySize;
+        GLenum type;
+        glGetActiveAttrib(program, (GLuint)i, sizeof(name), NULL, &arraySize, &type, name);
+        GLint location = glGetAttribLocation(program, name);
+        if (location < 0 || location >= PRECISION_BENCH_MAX_ATTRIBUTES)
+            continue;
+        int buffer = strstr(name, "Pos") ? 0 : nextBuffer++ % PRECISION_BENCH_MAX_ATTRIBUTES;
+        glBindBuffer(GL_ARRAY_BUFFER, attributeBuffers[buffer]);
+        glVertexAttribPointer((GLuint)location, 4, GL_FLOAT, GL_FALSE, 0, (void *)0);
+        glEnableVertexAttribArray((GLuint)location);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Measurement
+
+static void draw_frame(void)
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (int i = 0; i < drawCount; ++i)
+        glDrawElements(GL_TRIANGLES, PRECISION_BENCH_GRID * PRECISION_BENCH_GRID * 6, GL_UNSIGNED_SHORT, (void *)0);
+}
+
+// Renders program into pixels and returns the median frame time in ms.
+static double measure(GLuint program, unsigned char *result)
+{
+    bind_inputs(program);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    for (int frame = -1; frame < frameCount; ++frame)
+    {
+        double start = bench_seconds();
+        draw_frame();
+        glFinish();
+        if (frame >= 0)
+            times[frame] = bench_seconds() - start;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, result);
+    return bench_median_ms(times, frameCount);
+}
+
+static void run_shader(const ShaderSource *shader)
+{
+    const ShaderSource *partner = find_partner(shader);
+    if (!partner)
+    {
+        printf("%-24s %-8s %s\n", shader->name, "", "does not link with any shader");
+        return;
+    }
+    int vertex = shader->stage == SHADER_STAGE_VERTEX;
+    size_t pixelCount = (size_t)size * (size_t)size * 4;
+    for (int variant = 0; variant < PRECISION_VARIANTS; ++variant)
+    {
+        const char *label = variant == 0 ? shader->name : "";
+        char *source = rewrite(shader->source, (PrecisionVariant)variant);
+        const char *vertexSource = vertex ? source : partner->source;
+        const char *fragmentSource = vertex ? partner->source : source;
+        GLuint program = source ? shader_program_try_create(vertexSource, fragmentSource, NULL) : 0;
+        free(source);
+        if (!program)
+        {
+            printf("%-24s %-8s %10s\n", label, precisionNames[variant], "unsupported");
+            if (variant == 0)
+                return; // no reference
+            continue;
+        }
+        double ms = measure(program, pixels[variant]);
+        glDeleteProgram(program);
+        int maxError = 0;
+        double sum = 0.0;
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            int d = abs((int)pixels[variant][i] - (int)pixels[PRECISION_HIGH][i]);
+            if (d > maxError)
+                maxError = d;
+            sum += d;
+        }
+        printf("%-24s %-8s %10.3f %10d %10.4f", label, precisionNames[variant], ms, maxError,
+               sum / (double)pixelCount);
+        if (variant == 0)
+            printf("   with %s", partner->name);
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > PRECISION_BENCH_MAX_FRAMES)
+        frameCount = PRECISION_BENCH_MAX_FRAMES;
+    if (argc > 3 && atoi(argv[3]) > 0)
+        drawCount = atoi(argv[3]);
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(size, size, "precision_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    for (int variant = 0; variant < PRECISION_VARIANTS; ++variant)
+    {
+        pixels[variant] = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+        if (!pixels[variant])
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+    create_inputs();
+    glViewport(0, 0, size, size);
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %dx%d, %d frames of %d draws\n", renderer ? renderer : "unknown renderer", size, size,
+           frameCount, drawCount);
+    print_formats();
+    printf("%-24s %-8s %10s %10s %10s\n", "shader", "variant", "frame ms", "max err", "mean err");
+    for (int i = 0; i < SHADER_SOURCE_COUNT; ++i)
+        run_shader(shader_sources[i]);
+    printf("INFO: errors in 8-bit levels against the highp variant\n");
+
+    glDeleteBuffers(PRECISION_BENCH_MAX_ATTRIBUTES, attributeBuffers);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteTextures(2, textures);
+    for (int variant = 0; variant < PRECISION_VARIANTS; ++variant)
+        free(pixels[variant]);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,254 @@
+// premultiplied_bench.c
+// Straight against premultiplied alpha (common/premultiplied_alpha.h) on a
+// particle-like scene that mixes alpha-over and additive quads.
+//
+// The quads are drawn in a fixed order, each one over or additive at
+// random. With straight alpha the two need different blend functions, so
+// every run of quads of one kind is a draw call with a glBlendFunc before
+// it when the kind changes. Premultiplied on upload, all of them are one
+// draw with one blend function. The bench reports the draw calls, the
+// blend state changes, the median frame time up to glFinish and the time
+// to premultiply the vertex colours. The colour channels of the two images
+// differ by a level or two of rounding, as the blend unit multiplies by
+// alpha in its own precision; the mean difference shows it. The largest
+// difference can be more where a quad edge runs through pixel centres and
+// a driver covers them in one draw and not in the other (llvmpipe, a few
+// pixels). The alpha channel is not compared, as premultiplied additive
+// quads leave it alone.
+//
+// Usage: premultiplied_bench [size] [frames] [quads] [additive percent]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/premultiplied_alpha.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PREMULTIPLIED_BENCH_MAX_FRAMES 1000
+
+typedef struct SceneVertex
+{
+    GLfloat position[2];
+    GLfloat color[4];
+} SceneVertex;
+
+typedef struct DrawStats
+{
+    int drawCalls;
+    int stateChanges;
+} DrawStats;
+
+static int size = 512;
+static int frameCount = 20;
+static int quadCount = 4096;
+static int additivePercent = 50;
+static double times[PREMULTIPLIED_BENCH_MAX_FRAMES];
+static SceneVertex *straightVertices;
+static SceneVertex *premultipliedVertices;
+static unsigned char *kinds; // PremultipliedBlend of each quad
+static GLuint colorLocation;
+
+// Small quads scattered over the image, as two triangles each
+static void make_scene(void)
+{
+    static const int corners[6] = {0, 1, 2, 1, 3, 2};
+    unsigned state = 2024u;
+    for (int i = 0; i < quadCount; ++i)
+    {
+        float x = bench_random(&state) * 1.9f - 1.0f;
+        float y = bench_random(&state) * 1.9f - 1.0f;
+        float extent = 0.03f + bench_random(&state) * 0.07f;
+        kinds[i] = bench_random(&state) * 100.0f < (float)additivePercent ? PREMULTIPLIED_ADDITIVE : PREMULTIPLIED_OVER;
+        float color[4] = {bench_random(&state), bench_random(&state), bench_random(&state),
+                          0.2f + bench_random(&state) * 0.6f};
+        if (kinds[i] == PREMULTIPLIED_ADDITIVE)
+            color[3] *= 0.5f; // sparks are fainter
+        for (int v = 0; v < 6; ++v)
+        {
+            SceneVertex *vertex = &straightVertices[i * 6 + v];
+            vertex->position[0] = (corners[v] & 1) ? x + extent : x;
+            vertex->position[1] = (corners[v] & 2) ? y + extent : y;
+            memcpy(vertex->color, color, sizeof(color));
+        }
+    }
+}
+
+static void bind_vertices(GLuint buffer)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)0);
+    glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(SceneVertex), (void *)(2 * sizeof(GLfloat)));
+}
+
+static void begin_frame(void)
+{
+    glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+}
+
+// A draw call per run of quads of one kind, switching the blend function
+// between runs.
+static void draw_straight(GLuint buffer, DrawStats *stats)
+{
+    begin_frame();
+    bind_vertices(buffer);
+    memset(stats, 0, sizeof(*stats));
+    int first = 0;
+    while (first < quadCount)
+    {
+        int last = first;
+        while (last + 1 < quadCount && kinds[last + 1] == kinds[first])
+            ++last;
+        glBlendFunc(GL_SRC_ALPHA, kinds[first] == PREMULTIPLIED_ADDITIVE ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+        glDrawArrays(GL_TRIANGLES, first * 6, (last - first + 1) * 6);
+        ++stats->stateChanges;
+        ++stats->drawCalls;
+        first = last + 1;
+    }
+}
+
+static void draw_premultiplied(GLuint buffer, DrawStats *stats)
+{
+    begin_frame();
+    bind_vertices(buffer);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, quadCount * 6);
+    stats->stateChanges = 1;
+    stats->drawCalls = 1;
+}
+
+static double measure(void (*draw)(GLuint, DrawStats *), GLuint buffer, DrawStats *stats, unsigned char *pixels)
+{
+    for (int frame = -1; frame < frameCount; ++frame)
+    {
+        double start = bench_seconds();
+        draw(buffer, stats);
+        glFinish();
+        if (frame >= 0)
+            times[frame] = bench_seconds() - start;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return bench_median_ms(times, frameCount);
+}
+
+static GLuint upload(const SceneVertex *vertices)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((size_t)quadCount * 6 * sizeof(SceneVertex)), vertices,
+                 GL_STATIC_DRAW);
+    return buffer;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > PREMULTIPLIED_BENCH_MAX_FRAMES)
+        frameCount = PREMULTIPLIED_BENCH_MAX_FRAMES;
+    if (argc > 3 && atoi(argv[3]) > 0)
+        quadCount = atoi(argv[3]);
+    if (argc > 4 && atoi(argv[4]) >= 0 && atoi(argv[4]) <= 100)
+        additivePercent = atoi(argv[4]);
+
+    straightVertices = (SceneVertex *)malloc((size_t)quadCount * 6 * sizeof(SceneVertex));
+    premultipliedVertices = (SceneVertex *)malloc((size_t)quadCount * 6 * sizeof(SceneVertex));
+    kinds = (unsigned char *)malloc((size_t)quadCount);
+    unsigned char *straightPixels = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    unsigned char *premultipliedPixels = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    if (!straightVertices || !premultipliedVertices || !kinds || !straightPixels || !premultipliedPixels)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    make_scene();
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(size, size, "premultiplied_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    GLuint program = shader_program_create(shader_color_vert.source, shader_color_frag.source, "aPosition");
+    if (!program)
+    {
+        glfwTerminate();
+        return 1;
+    }
+    colorLocation = (GLuint)glGetAttribLocation(program, "aColor");
+    glUseProgram(program);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(colorLocation);
+    glViewport(0, 0, size, size);
+
+    // The conversion on upload, by kind of quad
+    double start = bench_seconds();
+    memcpy(premultipliedVertices, straightVertices, (size_t)quadCount * 6 * sizeof(SceneVertex));
+    for (int i = 0; i < quadCount; ++i)
+        premultiply_colors((PremultipliedBlend)kinds[i], premultipliedVertices[i * 6].color, 6, sizeof(SceneVertex));
+    double convertMs = (bench_seconds() - start) * 1000.0;
+    GLuint straightBuffer = upload(straightVertices);
+    GLuint premultipliedBuffer = upload(premultipliedVertices);
+
+    DrawStats straightStats, premultipliedStats;
+    double straightMs = measure(draw_straight, straightBuffer, &straightStats, straightPixels);
+    double premultipliedMs = measure(draw_premultiplied, premultipliedBuffer, &premultipliedStats,
+                                     premultipliedPixels);
+    int maxDifference = 0;
+    double sumDifference = 0.0;
+    for (size_t i = 0; i < (size_t)size * (size_t)size * 4; ++i)
+    {
+        if ((i & 3) == 3)
+            continue;
+        int d = abs((int)straightPixels[i] - (int)premultipliedPixels[i]);
+        if (d > maxDifference)
+            maxDifference = d;
+        sumDifference += d;
+    }
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %dx%d, %d quads, %d%% additive, %d frames\n", renderer ? renderer : "unknown renderer", size,
+           size, quadCount, additivePercent, frameCount);
+    printf("%-14s %10s %14s %10s\n", "alpha", "draws", "blend changes", "frame ms");
+    printf("%-14s %10d %14d %10.3f\n", "straight", straightStats.drawCalls, straightStats.stateChanges, straightMs);
+    printf("%-14s %10d %14d %10.3f\n", "premultiplied", premultipliedStats.drawCalls, premultipliedStats.stateChanges,
+           premultipliedMs);
+    printf("INFO: %d draw calls and %d blend state changes saved per frame, %.3f ms to premultiply %d vertices, "
+           "colour difference max %d mean %.3f\n",
+           straightStats.drawCalls - premultipliedStats.drawCalls,
+           straightStats.stateChanges - premultipliedStats.stateChanges, convertMs, quadCount * 6, maxDifference,
+           sumDifference / ((double)size * (double)size * 3.0));
+
+    glDeleteBuffers(1, &straightBuffer);
+    glDeleteBuffers(1, &premultipliedBuffer);
+    glDeleteProgram(program);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    free(straightVertices);
+    free(premultipliedVertices);
+    free(kinds);
+    free(straightPixels);
+    free(premultipliedPixels);
+    return 0;
+}
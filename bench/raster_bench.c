@@ -0,0 +1,177 @@
+// raster_bench.c
+// Fill-rate benchmark: draws many overlapping alpha-blended triangles per
+// frame, in the style of the glBlendFunc samples, and reports the frame time.
+// Built twice: raster_bench runs on the system GL ES driver, raster_bench_sw
+// links the software renderer and sweeps its thread count.
+//
+// Usage: raster_bench [triangles] [frames]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+
+#ifdef RASTER_BENCH_SWGL
+#include <swgl/swgl.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static GLFWwindow *window;
+static GLuint shaderProgram;
+static GLuint vertexBuffer;
+static int width = 900;
+static int height = 900;
+static int triangleCount = 2000;
+static int frameCount = 60;
+
+static const char *raster_bench_vert =
+    "attribute vec4 aPos;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = aPos;\n"
+    "}\n";
+static const char *raster_bench_frag =
+    "precision mediump float;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4(0.2, 0.4, 0.6, 0.25);\n"
+    "}\n";
+
+// Deterministic triangles of roughly a quarter of the screen, so every tile
+// sees many overlapping blended primitives.
+static int init(void)
+{
+    shaderProgram = shader_program_create(raster_bench_vert, raster_bench_frag, NULL);
+    if (!shaderProgram)
+        return 0;
+
+    float *vertices = (float *)malloc((size_t)triangleCount * 3 * 2 * sizeof(float));
+    if (!vertices)
+        return 0;
+    unsigned seed = 12345u;
+    for (int i = 0; i < triangleCount * 3; ++i)
+    {
+        if (i % 3 == 0)
+        {
+            vertices[i * 2 + 0] = bench_random(&seed) * 1.5f - 1.0f;
+            vertices[i * 2 + 1] = bench_random(&seed) * 1.5f - 1.0f;
+        }
+        else
+        {
+            // The other two corners span half the viewport, counter-clockwise
+            vertices[i * 2 + 0] = vertices[(i - i % 3) * 2 + 0] + (i % 3 == 1 ? 0.5f : 0.0f);
+            vertices[i * 2 + 1] = vertices[(i - i % 3) * 2 + 1] + (i % 3 == 2 ? 0.5f : 0.0f);
+        }
+    }
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)triangleCount * 3 * 2 * sizeof(float), vertices, GL_STATIC_DRAW);
+    free(vertices);
+
+    GLint posLoc = glGetAttribLocation(shaderProgram, "aPos");
+    glVertexAttribPointer((GLuint)posLoc, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray((GLuint)posLoc);
+    glUseProgram(shaderProgram);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glViewport(0, 0, width, height);
+    return glGetError() == GL_NO_ERROR;
+}
+
+static void draw(void)
+{
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, triangleCount * 3);
+}
+
+static void warm_up(void)
+{
+    draw();
+    glFinish();
+}
+
+// Returns the average milliseconds per frame. glFinish() keeps the driver
+// from queueing frames, so the number reflects rendering, not submission.
+static double run_frames(void)
+{
+    double start = bench_seconds();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        draw();
+        glFinish();
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    return (bench_seconds() - start) * 1000.0 / frameCount;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        triangleCount = atoi(argv[1]) > 0 ? atoi(argv[1]) : triangleCount;
+    if (argc > 2)
+        frameCount = atoi(argv[2]) > 0 ? atoi(argv[2]) : frameCount;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(width, height, "raster_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!init())
+    {
+        fprintf(stderr, "Failed to initialize the benchmark scene\n");
+        glfwTerminate();
+        return 1;
+    }
+
+    printf("INFO: %s, %d triangles, %d frames at %dx%d\n",
+           (const char *)glGetString(GL_RENDERER), triangleCount, frameCount, width, height);
+#ifdef RASTER_BENCH_SWGL
+    swgl_set_thread_count(0);
+    int maxThreads = swgl_get_thread_count();
+    double baseline = 0.0;
+    for (int threads = 1;; threads *= 2)
+    {
+        if (threads > maxThreads)
+            threads = maxThreads;
+        swgl_set_thread_count(threads);
+        warm_up();
+        swgl_reset_stats();
+        double ms = run_frames();
+        SwglStats stats;
+        swgl_get_stats(&stats);
+        if (threads == 1)
+            baseline = ms;
+        printf("threads %2d: %8.3f ms/frame  speedup %5.2fx  %6.1f Mfrag/s  bins/prim %.2f  steals %llu\n",
+               threads, ms, baseline / ms, (double)stats.fragments / (ms * frameCount * 1000.0),
+               stats.primitives ? (double)stats.binnedRefs / (double)stats.primitives : 0.0, stats.steals);
+        if (threads == maxThreads)
+            break;
+    }
+#else
+    warm_up();
+    double ms = run_frames();
+    printf("driver: %8.3f ms/frame\n", ms);
+#endif
+
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteProgram(shaderProgram);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
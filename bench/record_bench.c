@@ -0,0 +1,151 @@
+// record_bench.c
+// Throughput of the frame recorder at 1080p. Records synthetic frames in
+// the style of the blending samples (flat background, overlapping
+// translucent triangles, one gradient panel) with 1, 2, 4 and all encoder
+// threads, and checks that a decoded frame matches its source.
+//
+// Usage: record_bench [frames] [output.qrec]
+#include "bench_common.h"
+#include <capture/frame_recorder.h>
+#include <capture/qoi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RECORD_BENCH_WIDTH 1920
+#define RECORD_BENCH_HEIGHT 1080
+#define RECORD_BENCH_SOURCES 8
+
+static int frameCount = 240;
+static const char *outputPath = "record_bench.qrec";
+
+static float edge(float ax, float ay, float bx, float by, float px, float py)
+{
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+static void blend_triangle(unsigned char *pixels, const float *v, const unsigned char color[4])
+{
+    for (int y = 0; y < RECORD_BENCH_HEIGHT; ++y)
+    {
+        for (int x = 0; x < RECORD_BENCH_WIDTH; ++x)
+        {
+            float px = (float)x + 0.5f, py = (float)y + 0.5f;
+            if (edge(v[0], v[1], v[2], v[3], px, py) < 0.0f || edge(v[2], v[3], v[4], v[5], px, py) < 0.0f ||
+                edge(v[4], v[5], v[0], v[1], px, py) < 0.0f)
+                continue;
+            unsigned char *p = pixels + ((size_t)y * RECORD_BENCH_WIDTH + x) * 4;
+            for (int c = 0; c < 3; ++c)
+                p[c] = (unsigned char)((p[c] * (255 - color[3]) + color[c] * color[3]) / 255);
+        }
+    }
+}
+
+static void make_frame(unsigned char *pixels, int index)
+{
+    for (size_t i = 0; i < (size_t)RECORD_BENCH_WIDTH * RECORD_BENCH_HEIGHT; ++i)
+    {
+        pixels[i * 4 + 0] = 255;
+        pixels[i * 4 + 1] = 255;
+        pixels[i * 4 + 2] = 255;
+        pixels[i * 4 + 3] = 0;
+    }
+    // Gradient panel
+    for (int y = 700; y < 1000; ++y)
+    {
+        for (int x = 1300; x < 1800; ++x)
+        {
+            unsigned char *p = pixels + ((size_t)y * RECORD_BENCH_WIDTH + x) * 4;
+            p[0] = (unsigned char)(x + index * 3);
+            p[1] = (unsigned char)(y * 2);
+            p[2] = (unsigned char)((x + y) / 3);
+        }
+    }
+    const unsigned char colors[3][4] = {{51, 102, 153, 128}, {200, 60, 40, 160}, {30, 180, 90, 96}};
+    for (int t = 0; t < 3; ++t)
+    {
+        float ox = 200.0f + (float)t * 350.0f + (float)index * 12.0f, oy = 150.0f + (float)t * 120.0f;
+        float v[6] = {ox, oy, ox + 700.0f, oy + 40.0f, ox + 250.0f, oy + 650.0f};
+        blend_triangle(pixels, v, colors[t]);
+    }
+}
+
+static int run(int threads, unsigned char **sources)
+{
+    FrameRecorder *recorder = frame_recorder_create(outputPath, RECORD_BENCH_WIDTH, RECORD_BENCH_HEIGHT, threads);
+    if (!recorder)
+        return 0;
+    ptrdiff_t stride = (ptrdiff_t)RECORD_BENCH_WIDTH * 4;
+    double start = bench_seconds();
+    for (int i = 0; i < frameCount; ++i)
+        frame_recorder_submit(recorder, sources[i % RECORD_BENCH_SOURCES], stride, (unsigned long long)i);
+    FrameRecorderStats stats;
+    frame_recorder_close(recorder, &stats);
+    double seconds = bench_seconds() - start;
+    double raw = (double)stats.frames * RECORD_BENCH_WIDTH * RECORD_BENCH_HEIGHT * 3;
+    printf("%2d threads  %7.1f fps  encode %6.2f ms/frame  %6.1f KB/frame (%4.1f%% of RGB)\n", threads,
+           (double)stats.frames / seconds, stats.encodeMs, (double)stats.bytes / (double)stats.frames / 1024.0,
+           (double)stats.bytes * 100.0 / raw);
+    return stats.frames == (unsigned long long)frameCount;
+}
+
+// Decodes the last recorded frame through the index and compares it.
+static int verify(unsigned char **sources)
+{
+    FrameRecording recording;
+    if (!frame_recording_open(&recording, outputPath))
+        return 0;
+    uint64_t last = recording.header.frameCount - 1;
+    size_t size;
+    const unsigned char *data = frame_recording_frame(&recording, last, &size, NULL);
+    unsigned char *decoded = (unsigned char *)malloc((size_t)RECORD_BENCH_WIDTH * RECORD_BENCH_HEIGHT * 4);
+    int ok = data && decoded && qoi_decode(data, size, decoded);
+    const unsigned char *source = sources[last % RECORD_BENCH_SOURCES];
+    for (size_t i = 0; ok && i < (size_t)RECORD_BENCH_WIDTH * RECORD_BENCH_HEIGHT; ++i)
+        ok = memcmp(decoded + i * 4, source + i * 4, 3) == 0 && decoded[i * 4 + 3] == 255;
+    free(decoded);
+    frame_recording_close(&recording);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        frameCount = atoi(argv[1]) > 0 ? atoi(argv[1]) : frameCount;
+    if (argc > 2)
+        outputPath = argv[2];
+
+    unsigned char *sources[RECORD_BENCH_SOURCES];
+    for (int i = 0; i < RECORD_BENCH_SOURCES; ++i)
+    {
+        sources[i] = (unsigned char *)malloc((size_t)RECORD_BENCH_WIDTH * RECORD_BENCH_HEIGHT * 4);
+        if (!sources[i])
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        make_frame(sources[i], i);
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("INFO: %d frames of %dx%d, %ld CPUs\n", frameCount, RECORD_BENCH_WIDTH, RECORD_BENCH_HEIGHT, cpus);
+    int ok = 1;
+    int threadCounts[] = {1, 2, 4, (int)cpus};
+    for (int i = 0; i < 4 && ok; ++i)
+    {
+        if (i == 3 && cpus <= 4)
+            break;
+        ok = run(threadCounts[i], sources);
+    }
+    if (ok && !verify(sources))
+    {
+        printf("ERROR: the decoded frame differs from its source\n");
+        ok = 0;
+    }
+    remove(outputPath);
+    for (int i = 0; i < RECORD_BENCH_SOURCES; ++i)
+        free(sources[i]);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+// shader_bench.c
+// Compile and link latency of the samples' shaders: every shader built from
+// shaders/*.glsl (shaders.h), compiled as embedded, i.e. minified. Each
+// vertex shader is linked with every fragment shader it can be linked with.
+//
+// Every iteration compiles and links everything twice:
+//   cold  the source gets a unique #define after its #version line, so no
+//         driver shader cache (in memory or on disk) can have seen it
+//   warm  the unchanged source, which the driver has compiled before
+// A compile is timed up to the GL_COMPILE_STATUS query and a link up to
+// GL_LINK_STATUS, since drivers may defer the work until the status is read.
+// Latencies are reported as distributions per stage and per source size.
+//
+// Usage: shader_bench [iterations]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHADER_BENCH_MAX_PROGRAMS (SHADER_SOURCE_COUNT * SHADER_SOURCE_COUNT)
+#define SHADER_BENCH_SIZE_CLASSES 4
+#define SHADER_BENCH_HISTOGRAM_BUCKETS 24
+
+typedef enum ShaderBenchCache
+{
+    SHADER_BENCH_COLD,
+    SHADER_BENCH_WARM,
+    SHADER_BENCH_CACHES
+} ShaderBenchCache;
+
+typedef struct ShaderBenchShader
+{
+    const char *name;
+    GLenum type;
+    const char *source;
+    size_t size;
+    int compileFailed;
+    GLuint shaders[SHADER_BENCH_CACHES]; // compiled in the current iteration
+} ShaderBenchShader;
+
+typedef struct ShaderBenchProgram
+{
+    int vertex;
+    int fragment;
+    int linked; // links in the warm-up pass
+} ShaderBenchProgram;
+
+// Growable list of latencies in microseconds
+typedef struct LatencySeries
+{
+    double *values;
+    int count;
+    int capacity;
+} LatencySeries;
+
+static GLFWwindow *window;
+static int iterationCount = 20;
+static ShaderBenchShader shaders[SHADER_SOURCE_COUNT];
+static int shaderCount;
+static ShaderBenchProgram programs[SHADER_BENCH_MAX_PROGRAMS];
+static int programCount;
+static unsigned long long nonceBase;
+
+// [stage: 0 vertex, 1 fragment][cache][size class]
+static LatencySeries compileTimes[2][SHADER_BENCH_CACHES][SHADER_BENCH_SIZE_CLASSES];
+static LatencySeries linkTimes[SHADER_BENCH_CACHES];
+
+static const size_t sizeClassLimits[SHADER_BENCH_SIZE_CLASSES] = {128, 256, 512, (size_t)-1};
+static const char *sizeClassNames[SHADER_BENCH_SIZE_CLASSES] = {"< 128 B", "128-255 B", "256-511 B", ">= 512 B"};
+static const char *cacheNames[SHADER_BENCH_CACHES] = {"cold", "warm"};
+
+static void series_add(LatencySeries *series, double value)
+{
+    if (series->count == series->capacity)
+    {
+        int capacity = series->capacity ? series->capacity * 2 : 64;
+        double *values = (double *)realloc(series->values, (size_t)capacity * sizeof(double));
+        if (!values)
+            return;
+        series->values = values;
+        series->capacity = capacity;
+    }
+    series->values[series->count++] = value;
+}
+
+static int size_class(size_t size)
+{
+    int i = 0;
+    while (size >= sizeClassLimits[i])
+        ++i;
+    return i;
+}
+
+// Pairs every vertex shader with every fragment shader; the warm-up pass
+// keeps the pairs that link.
+static void load_shaders(void)
+{
+    for (int i = 0; i < SHADER_SOURCE_COUNT; ++i)
+    {
+        ShaderBenchShader *shader = &shaders[shaderCount++];
+        memset(shader, 0, sizeof(*shader));
+        shader->name = shader_sources[i]->name;
+        shader->type = shader_sources[i]->stage == SHADER_STAGE_VERTEX ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER;
+        shader->source = shader_sources[i]->source;
+        shader->size = shader_sources[i]->length;
+    }
+    for (int v = 0; v < shaderCount; ++v)
+    {
+        for (int f = 0; f < shaderCount; ++f)
+        {
+            if (shaders[v].type == GL_VERTEX_SHADER && shaders[f].type == GL_FRAGMENT_SHADER)
+            {
+                programs[programCount].vertex = v;
+                programs[programCount].fragment = f;
+                programCount++;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Measurement
+
+// The cold variant declares a macro no driver has seen, after the #version
+// line (shader_program_insert_defines).
+static char *cold_source(const ShaderBenchShader *shader, int iteration)
+{
+    char nonce[96];
+    snprintf(nonce, sizeof(nonce), "#define SHADER_BENCH_NONCE_%llx_%d\n", nonceBase, iteration);
+    return shader_program_insert_defines(shader->source, nonce);
+}
+
+// Returns the shader object even when it failed to compile; *compiled tells.
+static GLuint time_compile(const char *source, GLenum type, double *microseconds, GLint *compiled)
+{
+    double start = bench_seconds();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, compiled);
+    *microseconds = (bench_seconds() - start) * 1e6;
+    return shader;
+}
+
+static GLuint time_link(GLuint vertexShader, GLuint fragmentShader, double *microseconds)
+{
+    double start = bench_seconds();
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    *microseconds = (bench_seconds() - start) * 1e6;
+    if (!linked)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// Compiles every shader and links every program once, either from the cold
+// or from the warm sources. record is 0 for the warm-up pass.
+static void run_pass(ShaderBenchCache cache, int iteration, int record)
+{
+    for (int i = 0; i < shaderCount; ++i)
+    {
+        ShaderBenchShader *shader = &shaders[i];
+        char *cold = cache == SHADER_BENCH_COLD ? cold_source(shader, iteration) : NULL;
+        const char *source = cold ? cold : shader->source;
+        double microseconds;
+        GLint compiled;
+        GLuint object = time_compile(source, shader->type, &microseconds, &compiled);
+        free(cold);
+        if (!compiled)
+        {
+            if (!shader->compileFailed)
+            {
+                char infoLog[512] = "";
+                glGetShaderInfoLog(object, sizeof(infoLog), NULL, infoLog);
+                printf("INFO: %s does not compile on this driver (timed anyway): %s\n", shader->name, infoLog);
+                shader->compileFailed = 1;
+            }
+            glDeleteShader(object);
+            object = 0;
+        }
+        shader->shaders[cache] = object;
+        if (record)
+        {
+            int stage = shader->type == GL_FRAGMENT_SHADER;
+            series_add(&compileTimes[stage][cache][size_class(shader->size)], microseconds);
+        }
+    }
+    for (int i = 0; i < programCount; ++i)
+    {
+        ShaderBenchProgram *program = &programs[i];
+        GLuint vertexShader = shaders[program->vertex].shaders[cache];
+        GLuint fragmentShader = shaders[program->fragment].shaders[cache];
+        if (!vertexShader || !fragmentShader || (record && !program->linked))
+            continue;
+        double microseconds;
+        GLuint linked = time_link(vertexShader, fragmentShader, &microseconds);
+        if (!record)
+            program->linked = linked != 0;
+        else
+            series_add(&linkTimes[cache], microseconds);
+        glDeleteProgram(linked);
+    }
+    for (int i = 0; i < shaderCount; ++i)
+    {
+        glDeleteShader(shaders[i].shaders[cache]);
+        shaders[i].shaders[cache] = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+
+// Nearest-rank percentile of sorted values
+static double percentile(const LatencySeries *series, double p)
+{
+    int rank = (int)(p / 100.0 * series->count + 0.999999);
+    rank = rank < 1 ? 1 : rank > series->count ? series->count : rank;
+    return series->values[rank - 1];
+}
+
+// Merges series into one sorted series; the caller frees values.
+static LatencySeries merge(LatencySeries *const *parts, int count)
+{
+    LatencySeries merged = {NULL, 0, 0};
+    for (int i = 0; i < count; ++i)
+    {
+        for (int j = 0; j < parts[i]->count; ++j)
+            series_add(&merged, parts[i]->values[j]);
+    }
+    if (merged.count)
+        qsort(merged.values, (size_t)merged.count, sizeof(double), bench_compare_doubles);
+    return merged;
+}
+
+static void print_summary(const char *label, const LatencySeries *series)
+{
+    if (!series->count)
+        return;
+    double sum = 0.0;
+    for (int i = 0; i < series->count; ++i)
+        sum += series->values[i];
+    printf("%-26s %6d %10.1f %10.1f %10.1f %10.1f %10.1f\n", label, series->count, sum / series->count,
+           percentile(series, 50.0), percentile(series, 90.0), percentile(series, 99.0),
+           series->values[series->count - 1]);
+}
+
+// Histogram over power-of-two microsecond buckets; the first also holds
+// everything under 1 us
+static void print_histogram(const char *label, const LatencySeries *series)
+{
+    if (!series->count)
+        return;
+    int counts[SHADER_BENCH_HISTOGRAM_BUCKETS] = {0};
+    int first = SHADER_BENCH_HISTOGRAM_BUCKETS, last = 0, peak = 0;
+    for (int i = 0; i < series->count; ++i)
+    {
+        int bucket = 0;
+        while (bucket + 1 < SHADER_BENCH_HISTOGRAM_BUCKETS && series->values[i] >= (double)(1u << (bucket + 1)))
+            ++bucket;
+        counts[bucket]++;
+        first = bucket < first ? bucket : first;
+        last = bucket > last ? bucket : last;
+        peak = counts[bucket] > peak ? counts[bucket] : peak;
+    }
+    printf("%s\n", label);
+    for (int bucket = first; bucket <= last; ++bucket)
+    {
+        char bar[41];
+        int length = counts[bucket] * 40 / peak;
+        memset(bar, '#', (size_t)length);
+        bar[length] = '\0';
+        printf("  %8u - %8u us %-40s %d\n", bucket ? 1u << bucket : 0u, 1u << (bucket + 1), bar, counts[bucket]);
+    }
+}
+
+static void report(void)
+{
+    static const char *stageNames[2] = {"vertex", "fragment"};
+    char label[64];
+    printf("\n%-26s %6s %10s %10s %10s %10s %10s\n", "latency (us)", "count", "mean", "p50", "p90", "p99", "max");
+    for (int cache = 0; cache < SHADER_BENCH_CACHES; ++cache)
+    {
+        for (int stage = 0; stage < 2; ++stage)
+        {
+            LatencySeries *parts[SHADER_BENCH_SIZE_CLASSES];
+            for (int c = 0; c < SHADER_BENCH_SIZE_CLASSES; ++c)
+                parts[c] = &compileTimes[stage][cache][c];
+            LatencySeries all = merge(parts, SHADER_BENCH_SIZE_CLASSES);
+            snprintf(label, sizeof(label), "compile %s, %s", stageNames[stage], cacheNames[cache]);
+            print_summary(label, &all);
+            free(all.values);
+        }
+        LatencySeries *part = &linkTimes[cache];
+        LatencySeries links = merge(&part, 1);
+        snprintf(label, sizeof(label), "link, %s", cacheNames[cache]);
+        print_summary(label, &links);
+        free(links.values);
+    }
+
+    printf("\ncompile by source size\n");
+    for (int stage = 0; stage < 2; ++stage)
+    {
+        for (int c = 0; c < SHADER_BENCH_SIZE_CLASSES; ++c)
+        {
+            for (int cache = 0; cache < SHADER_BENCH_CACHES; ++cache)
+            {
+                LatencySeries *part = &compileTimes[stage][cache][c];
+                LatencySeries sized = merge(&part, 1);
+                snprintf(label, sizeof(label), "%s %s, %s", stageNames[stage], sizeClassNames[c], cacheNames[cache]);
+                print_summary(label, &sized);
+                free(sized.values);
+            }
+        }
+    }
+
+    printf("\n");
+    for (int cache = 0; cache < SHADER_BENCH_CACHES; ++cache)
+    {
+        for (int stage = 0; stage < 2; ++stage)
+        {
+            LatencySeries *parts[SHADER_BENCH_SIZE_CLASSES];
+            for (int c = 0; c < SHADER_BENCH_SIZE_CLASSES; ++c)
+                parts[c] = &compileTimes[stage][cache][c];
+            LatencySeries all = merge(parts, SHADER_BENCH_SIZE_CLASSES);
+            snprintf(label, sizeof(label), "compile %s, %s:", stageNames[stage], cacheNames[cache]);
+            print_histogram(label, &all);
+            free(all.values);
+        }
+        LatencySeries *part = &linkTimes[cache];
+        LatencySeries links = merge(&part, 1);
+        snprintf(label, sizeof(label), "link, %s:", cacheNames[cache]);
+        print_histogram(label, &links);
+        free(links.values);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        iterationCount = atoi(argv[1]) > 0 ? atoi(argv[1]) : iterationCount;
+    load_shaders();
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "shader_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    nonceBase = ((unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec) ^
+                ((unsigned long long)getpid() << 40);
+
+    // The warm sources are compiled once before measuring, so the first
+    // warm iteration already finds them in the driver's caches
+    run_pass(SHADER_BENCH_WARM, 0, 0);
+    int vertexCount = 0, linkedCount = 0;
+    for (int i = 0; i < shaderCount; ++i)
+        vertexCount += shaders[i].type == GL_VERTEX_SHADER;
+    for (int i = 0; i < programCount; ++i)
+        linkedCount += programs[i].linked;
+    printf("INFO: %s, %d vertex and %d fragment shaders, %d programs, %d iterations\n",
+           (const char *)glGetString(GL_RENDERER), vertexCount, shaderCount - vertexCount, linkedCount,
+           iterationCount);
+    for (int i = 0; i < SHADER_SOURCE_COUNT; ++i)
+        printf("INFO: %-24s %5u bytes (%u in %s)\n", shader_sources[i]->name, shader_sources[i]->length,
+               shader_sources[i]->originalLength, shader_sources[i]->path);
+
+    for (int iteration = 0; iteration < iterationCount; ++iteration)
+    {
+        run_pass(SHADER_BENCH_COLD, iteration, 1);
+        run_pass(SHADER_BENCH_WARM, iteration, 1);
+    }
+    report();
+
+    for (int cache = 0; cache < SHADER_BENCH_CACHES; ++cache)
+    {
+        free(linkTimes[cache].values);
+        for (int stage = 0; stage < 2; ++stage)
+        {
+            for (int c = 0; c < SHADER_BENCH_SIZE_CLASSES; ++c)
+                free(compileTimes[stage][cache][c].values);
+        }
+    }
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,274 @@
+// texture_stream_bench.c
+// Texture upload throughput, and texture streaming (texture/texture_stream.h)
+// with one decode thread against several.
+//
+// The upload part times glTexSubImage2D into an allocated texture for each
+// format and size, followed by glFinish: once with the whole image, and
+// once in bands of rows of at most the streaming budget, as
+// texture_stream_update() uploads them.
+//
+// The streaming part queues QOI-encoded procedural images and calls
+// texture_stream_update() once per "frame" (followed by glFinish) until all
+// of them are textures. It reports the time until then, the texel
+// throughput, the longest update (the frame hitch the budget bounds) and
+// the frames that uploaded.
+//
+// Usage: texture_stream_bench [iterations] [threads] [budget KiB]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <capture/qoi.h>
+#include <texture/texture_stream.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEXTURE_STREAM_BENCH_MAX_ITERATIONS 1000
+#define TEXTURE_STREAM_BENCH_SIZES 4
+#define TEXTURE_STREAM_BENCH_IMAGES 24
+#define TEXTURE_STREAM_BENCH_IMAGE_SIZE 512
+#define TEXTURE_STREAM_BENCH_STAGING (16u << 20)
+
+static const int sizes[TEXTURE_STREAM_BENCH_SIZES] = {256, 512, 1024, 2048};
+
+static GLFWwindow *window;
+static int iterationCount = 10;
+static int threadCount;
+static size_t frameBudget = 256u << 10;
+static double times[TEXTURE_STREAM_BENCH_MAX_ITERATIONS];
+
+static unsigned char *images[TEXTURE_STREAM_BENCH_IMAGES];
+static size_t imageSizes[TEXTURE_STREAM_BENCH_IMAGES];
+
+// ---------------------------------------------------------------------------
+// Upload throughput
+
+static GLenum format_of(TextureStreamFormat format)
+{
+    return format == TEXTURE_STREAM_RGB565 ? GL_RGB : GL_RGBA;
+}
+
+static GLenum type_of(TextureStreamFormat format)
+{
+    static const GLenum types[TEXTURE_STREAM_FORMATS] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT_5_6_5,
+                                                         GL_UNSIGNED_SHORT_4_4_4_4};
+    return types[format];
+}
+
+// Median seconds to upload size x size texels in bands of bandRows rows
+static double time_upload(TextureStreamFormat format, int size, int bandRows, const unsigned char *texels)
+{
+    size_t rowBytes = (size_t)size * (size_t)texture_stream_texel_size(format);
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format_of(format), size, size, 0, format_of(format), type_of(format), NULL);
+    for (int i = -1; i < iterationCount; ++i) // -1: warm-up
+    {
+        double start = bench_seconds();
+        for (int row = 0; row < size; row += bandRows)
+        {
+            int rows = size - row < bandRows ? size - row : bandRows;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, size, rows, format_of(format), type_of(format),
+                            texels + (size_t)row * rowBytes);
+        }
+        glFinish();
+        if (i >= 0)
+            times[i] = bench_seconds() - start;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+    return bench_median_ms(times, iterationCount) / 1000.0;
+}
+
+static int run_uploads(void)
+{
+    int largest = sizes[TEXTURE_STREAM_BENCH_SIZES - 1];
+    unsigned char *texels = (unsigned char *)malloc((size_t)largest * (size_t)largest * 4);
+    if (!texels)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 0;
+    }
+    for (size_t i = 0; i < (size_t)largest * (size_t)largest * 4; ++i)
+        texels[i] = (unsigned char)(i * 2654435761u >> 24);
+
+    printf("%-9s %5s %10s %10s %10s %10s %10s\n", "format", "size", "whole ms", "MB/s", "Mtexel/s", "banded ms",
+           "MB/s");
+    for (int format = 0; format < TEXTURE_STREAM_FORMATS; ++format)
+    {
+        for (int i = 0; i < TEXTURE_STREAM_BENCH_SIZES; ++i)
+        {
+            int size = sizes[i];
+            double texelCount = (double)size * size;
+            double bytes = texelCount * texture_stream_texel_size((TextureStreamFormat)format);
+            size_t rowBytes = (size_t)size * (size_t)texture_stream_texel_size((TextureStreamFormat)format);
+            int bandRows = frameBudget / rowBytes > 0 ? (int)(frameBudget / rowBytes) : 1;
+            double whole = time_upload((TextureStreamFormat)format, size, size, texels);
+            double banded = time_upload((TextureStreamFormat)format, size, bandRows, texels);
+            printf("%-9s %5d %10.3f %10.1f %10.1f %10.3f %10.1f\n",
+                   texture_stream_format_name((TextureStreamFormat)format), size, whole * 1000.0, bytes / whole / 1e6,
+                   texelCount / whole / 1e6, banded * 1000.0, bytes / banded / 1e6);
+        }
+    }
+    free(texels);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming
+
+// Gradients with noise in the low bits, so QOI compresses them about as
+// well as photographs
+static int make_images(void)
+{
+    int size = TEXTURE_STREAM_BENCH_IMAGE_SIZE;
+    unsigned char *pixels = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+    if (!pixels)
+        return 0;
+    unsigned state = 0x9e3779b9u;
+    for (int image = 0; image < TEXTURE_STREAM_BENCH_IMAGES; ++image)
+    {
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                unsigned char *p = pixels + ((size_t)y * (size_t)size + (size_t)x) * 4;
+                unsigned noise = (state & 0x30) == 0 ? state : 0;
+                p[0] = (unsigned char)((x + image * 10) ^ (noise & 3));
+                p[1] = (unsigned char)((y + image * 20) ^ (noise >> 2 & 3));
+                p[2] = (unsigned char)((x + y) / 2);
+                p[3] = 255;
+            }
+        }
+        images[image] = (unsigned char *)malloc(qoi_max_size(size, size));
+        if (!images[image])
+        {
+            free(pixels);
+            return 0;
+        }
+        imageSizes[image] = qoi_encode(pixels, size, size, (ptrdiff_t)size * 4, 4, images[image]);
+    }
+    free(pixels);
+    return 1;
+}
+
+static void delete_texture(GLuint texture, int width, int height, void *userData)
+{
+    (void)width;
+    (void)height;
+    if (texture)
+        glDeleteTextures(1, &texture);
+    else
+        ++*(int *)userData;
+}
+
+static int run_stream(TextureStreamFormat format, int threads)
+{
+    TextureStream *stream = texture_stream_create(threads, TEXTURE_STREAM_BENCH_STAGING, frameBudget);
+    if (!stream)
+        return 0;
+    int failed = 0;
+    double start = bench_seconds();
+    for (int i = 0; i < TEXTURE_STREAM_BENCH_IMAGES; ++i)
+        texture_stream_load_memory(stream, images[i], imageSizes[i], format, delete_texture, &failed);
+    TextureStreamStats stats;
+    memset(&stats, 0, sizeof(stats));
+    while (texture_stream_pending(stream) > 0)
+    {
+        unsigned long long updates = stats.updates;
+        texture_stream_update(stream);
+        glFinish();
+        texture_stream_get_stats(stream, &stats);
+        // Nothing decoded yet: leave the CPU to the workers
+        if (stats.updates == updates)
+            usleep(100);
+    }
+    double seconds = bench_seconds() - start;
+    texture_stream_get_stats(stream, &stats);
+    texture_stream_destroy(stream);
+    if (failed)
+    {
+        fprintf(stderr, "Failed to decode %d images\n", failed);
+        return 0;
+    }
+    double texels = (double)TEXTURE_STREAM_BENCH_IMAGES * TEXTURE_STREAM_BENCH_IMAGE_SIZE *
+                    TEXTURE_STREAM_BENCH_IMAGE_SIZE;
+    printf("%-9s %7d %10.2f %10.1f %10.1f %12.3f %8llu %10.2f %10.2f %9.1f\n", texture_stream_format_name(format),
+           threads, seconds * 1000.0, texels / seconds / 1e6, (double)stats.uploadedBytes / seconds / 1e6,
+           stats.maxUpdateMs, stats.updates, stats.decodeMs, stats.uploadMs, (double)stats.stagingPeak / (1 << 20));
+    return 1;
+}
+
+static int run_streaming(void)
+{
+    if (!make_images())
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 0;
+    }
+    size_t encodedBytes = 0;
+    for (int i = 0; i < TEXTURE_STREAM_BENCH_IMAGES; ++i)
+        encodedBytes += imageSizes[i];
+    printf("INFO: streaming %d QOI images of %dx%d (%.1f MB encoded), %zu KiB per frame\n",
+           TEXTURE_STREAM_BENCH_IMAGES, TEXTURE_STREAM_BENCH_IMAGE_SIZE, TEXTURE_STREAM_BENCH_IMAGE_SIZE,
+           (double)encodedBytes / 1e6, frameBudget >> 10);
+    printf("%-9s %7s %10s %10s %10s %12s %8s %10s %10s %9s\n", "format", "threads", "total ms", "Mtexel/s", "MB/s",
+           "max frame ms", "frames", "decode ms", "upload ms", "peak MiB");
+    int ok = 1;
+    for (int format = 0; ok && format < TEXTURE_STREAM_FORMATS; ++format)
+    {
+        ok = run_stream((TextureStreamFormat)format, 1);
+        if (ok && threadCount > 1)
+            ok = run_stream((TextureStreamFormat)format, threadCount);
+    }
+    for (int i = 0; i < TEXTURE_STREAM_BENCH_IMAGES; ++i)
+        free(images[i]);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        iterationCount = atoi(argv[1]) > 0 ? atoi(argv[1]) : iterationCount;
+    if (iterationCount > TEXTURE_STREAM_BENCH_MAX_ITERATIONS)
+        iterationCount = TEXTURE_STREAM_BENCH_MAX_ITERATIONS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = argc > 2 && atoi(argv[2]) > 0 ? atoi(argv[2]) : cpus > 0 ? (int)cpus : 1;
+    if (argc > 3 && atoi(argv[3]) > 0)
+        frameBudget = (size_t)atoi(argv[3]) << 10;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "texture_stream_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %d iterations, %d decode threads\n", renderer ? renderer : "unknown renderer", iterationCount,
+           threadCount);
+    if (renderer && strstr(renderer, "swgl"))
+        printf("INFO: swgl keeps no texture storage; the upload times are call overhead only\n");
+    int ok = run_uploads() && run_streaming();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+// transparency_sort_bench.c
+// Back-to-front sorting of translucent triangles (common/transparency_sort.h)
+// at 100k to 10M triangles, against qsort.
+//
+// The triangles' centres are random points in a cube seen from a direction
+// that turns a little every frame. For each count the indices are sorted
+// with qsort, with the radix sort on one thread and on every CPU, and the
+// bench reports the median time of each step and of the upload of the
+// index buffer (glBufferData up to glFinish), which every method shares.
+// Each result is checked to be farthest first.
+//
+// Usage: transparency_sort_bench [frames] [threads] [triangles...]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/transparency_sort.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SORT_BENCH_MAX_FRAMES 1000
+#define SORT_BENCH_MAX_COUNTS 16
+
+typedef struct SortKey
+{
+    float depth;
+    GLuint triangle;
+} SortKey;
+
+typedef struct StepTimes
+{
+    double depth[SORT_BENCH_MAX_FRAMES];
+    double sort[SORT_BENCH_MAX_FRAMES];
+    double index[SORT_BENCH_MAX_FRAMES];
+    double total[SORT_BENCH_MAX_FRAMES];
+} StepTimes;
+
+static int frameCount = 5;
+static int threadCount;
+static size_t triangleCount;
+static GLfloat *centres; // 3 per triangle
+static SortKey *keys;
+static GLuint *indices;
+static StepTimes steps;
+static double uploadTimes[SORT_BENCH_MAX_FRAMES];
+
+// Farthest first
+static int compare_keys(const void *a, const void *b)
+{
+    float x = ((const SortKey *)a)->depth, y = ((const SortKey *)b)->depth;
+    return (x < y) - (x > y);
+}
+
+// The distance along a direction that turns with frame
+static void make_depth_row(int frame, float depthRow[4])
+{
+    float yaw = 0.05f * (float)frame, pitch = 0.4f;
+    depthRow[0] = -cosf(pitch) * sinf(yaw);
+    depthRow[1] = sinf(pitch);
+    depthRow[2] = cosf(pitch) * cosf(yaw);
+    depthRow[3] = 2.0f;
+}
+
+static float triangle_depth(const float depthRow[4], GLuint firstIndex)
+{
+    const GLfloat *centre = centres + (size_t)(firstIndex / 3) * 3;
+    // Summed in the sorter's order, so that the check sees its rounding
+    return (depthRow[0] * centre[0] + depthRow[1] * centre[1]) + (depthRow[2] * centre[2] + depthRow[3]);
+}
+
+static int is_back_to_front(const float depthRow[4])
+{
+    for (size_t i = 0; i + 1 < triangleCount; ++i)
+    {
+        if (triangle_depth(depthRow, indices[i * 3]) < triangle_depth(depthRow, indices[i * 3 + 3]))
+            return 0;
+    }
+    return 1;
+}
+
+static void qsort_triangles(const float depthRow[4], double *depthSeconds, double *sortSeconds,
+                            double *indexSeconds)
+{
+    double start = bench_seconds();
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        keys[i].depth = triangle_depth(depthRow, (GLuint)i * 3);
+        keys[i].triangle = (GLuint)i;
+    }
+    double sorting = bench_seconds();
+    qsort(keys, triangleCount, sizeof(SortKey), compare_keys);
+    double indexing = bench_seconds();
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        GLuint first = keys[i].triangle * 3;
+        indices[i * 3] = first;
+        indices[i * 3 + 1] = first + 1;
+        indices[i * 3 + 2] = first + 2;
+    }
+    double done = bench_seconds();
+    *depthSeconds = sorting - start;
+    *sortSeconds = indexing - sorting;
+    *indexSeconds = done - indexing;
+}
+
+// sorter NULL: qsort. Returns 0 when an order is wrong.
+static int measure(TransparencySort *sorter, int *passes)
+{
+    int correct = 1;
+    *passes = 0;
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        float depthRow[4];
+        make_depth_row(frame, depthRow);
+        double start = bench_seconds();
+        if (sorter)
+        {
+            transparency_sort_triangles(sorter, centres, triangleCount, depthRow, NULL, indices);
+            TransparencySortTimings timings;
+            transparency_sort_get_timings(sorter, &timings);
+            steps.depth[frame] = timings.depthMs / 1000.0;
+            steps.sort[frame] = timings.sortMs / 1000.0;
+            steps.index[frame] = timings.indexMs / 1000.0;
+            *passes = timings.passes;
+        }
+        else
+        {
+            qsort_triangles(depthRow, &steps.depth[frame], &steps.sort[frame], &steps.index[frame]);
+        }
+        steps.total[frame] = bench_seconds() - start;
+
+        start = bench_seconds();
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(triangleCount * 3 * sizeof(GLuint)), indices,
+                     GL_STREAM_DRAW);
+        glFinish();
+        uploadTimes[frame] = bench_seconds() - start;
+        correct &= is_back_to_front(depthRow);
+    }
+    return correct;
+}
+
+static void run_count(size_t count)
+{
+    triangleCount = count;
+    centres = (GLfloat *)malloc(count * 3 * sizeof(GLfloat));
+    keys = (SortKey *)malloc(count * sizeof(SortKey));
+    indices = (GLuint *)malloc(count * 3 * sizeof(GLuint));
+    TransparencySort *single = transparency_sort_create(count, 1);
+    TransparencySort *parallel = transparency_sort_create(count, threadCount);
+    if (!centres || !keys || !indices || !single || !parallel)
+    {
+        printf("%-10zu %-12s %12s\n", count, "", "out of memory");
+    }
+    else
+    {
+        unsigned state = 777u;
+        for (size_t i = 0; i < count * 3; ++i)
+            centres[i] = bench_random(&state) * 2.0f - 1.0f;
+        TransparencySort *sorters[3] = {NULL, single, parallel};
+        char names[3][32] = {"qsort", "radix 1"};
+        snprintf(names[2], sizeof(names[2]), "radix %d", transparency_sort_thread_count(parallel));
+        for (int method = 0; method < 3; ++method)
+        {
+            int passes;
+            int correct = measure(sorters[method], &passes);
+            printf("%-10zu %-12s %10.2f %10.2f %10.2f %10.2f %10.2f", count, names[method],
+                   bench_median_ms(steps.depth, frameCount), bench_median_ms(steps.sort, frameCount),
+                   bench_median_ms(steps.index, frameCount), bench_median_ms(steps.total, frameCount),
+                   bench_median_ms(uploadTimes, frameCount));
+            if (sorters[method])
+                printf(" %7d", passes);
+            else
+                printf(" %7s", "-");
+            printf("%s\n", correct ? "" : "  WRONG ORDER");
+        }
+    }
+    transparency_sort_destroy(single);
+    transparency_sort_destroy(parallel);
+    free(centres);
+    free(keys);
+    free(indices);
+}
+
+int main(int argc, char **argv)
+{
+    size_t counts[SORT_BENCH_MAX_COUNTS] = {100000, 1000000, 10000000};
+    int countCount = 3;
+    if (argc > 1 && atoi(argv[1]) > 0)
+        frameCount = atoi(argv[1]);
+    if (frameCount > SORT_BENCH_MAX_FRAMES)
+        frameCount = SORT_BENCH_MAX_FRAMES;
+    if (argc > 2 && atoi(argv[2]) > 0)
+        threadCount = atoi(argv[2]);
+    if (argc > 3)
+    {
+        countCount = 0;
+        for (int i = 3; i < argc && countCount < SORT_BENCH_MAX_COUNTS; ++i)
+        {
+            if (atol(argv[i]) > 1)
+                counts[countCount++] = (size_t)atol(argv[i]);
+        }
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "transparency_sort_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    GLuint indexBuffer;
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %d frames\n", renderer ? renderer : "unknown renderer", frameCount);
+    printf("%-10s %-12s %10s %10s %10s %10s %10s %7s\n", "triangles", "method", "depth ms", "sort ms", "index ms",
+           "total ms", "upload ms", "passes");
+    for (int i = 0; i < countCount; ++i)
+        run_count(counts[i]);
+
+    glDeleteBuffers(1, &indexBuffer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
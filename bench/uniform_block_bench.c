@@ -0,0 +1,254 @@
+// uniform_block_bench.c
+// Uniforms set one call each against a packed block (common/uniform_block.h).
+//
+// Each frame draws many quads, each with its own six uniforms: a mat4, a
+// mat3, a vec4, a vec2 and two floats, 12 vectors in all. They are set:
+//   separate   one glUniform* call per uniform, as the samples did
+//   block      packed into one vec4 array (9 vectors), one glUniform4fv
+// and the bench reports the uniform calls per frame, the median frame time
+// up to glFinish and the largest difference between the two images in
+// 8-bit levels.
+//
+// Usage: uniform_block_bench [size] [frames] [quads...]
+#include "bench_common.h"
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/shader_program.h>
+#include <common/uniform_block.h>
+#include <shaders.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UNIFORM_BLOCK_BENCH_MAX_FRAMES 1000
+#define UNIFORM_BLOCK_BENCH_MAX_COUNTS 16
+#define UNIFORM_BLOCK_BENCH_UNIFORMS 6
+
+typedef enum UniformBlockBenchMethod
+{
+    UNIFORM_BLOCK_BENCH_SEPARATE,
+    UNIFORM_BLOCK_BENCH_BLOCK,
+    UNIFORM_BLOCK_BENCH_METHODS
+} UniformBlockBenchMethod;
+
+// The uniforms of one quad, in the order of entries
+typedef struct QuadUniforms
+{
+    GLfloat transform[16];
+    GLfloat colorMatrix[9];
+    GLfloat color[4];
+    GLfloat offset[2];
+    GLfloat scale;
+    GLfloat brightness;
+} QuadUniforms;
+
+static const char *methodNames[UNIFORM_BLOCK_BENCH_METHODS] = {"separate", "block"};
+
+static const UniformBlockEntry entries[UNIFORM_BLOCK_BENCH_UNIFORMS] = {
+    {"uTransform", UNIFORM_BLOCK_MAT4}, {"uColorMatrix", UNIFORM_BLOCK_MAT3}, {"uColor", UNIFORM_BLOCK_VEC4},
+    {"uOffset", UNIFORM_BLOCK_VEC2},    {"uScale", UNIFORM_BLOCK_FLOAT},      {"uBrightness", UNIFORM_BLOCK_FLOAT}};
+
+static const GLfloat quad[6][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f},
+                                   {1.0f, -1.0f},  {1.0f, 1.0f},  {-1.0f, 1.0f}};
+
+static int size = 512;
+static int frameCount = 10;
+static double times[UNIFORM_BLOCK_BENCH_MAX_FRAMES];
+static GLuint programs[UNIFORM_BLOCK_BENCH_METHODS];
+static GLint locations[UNIFORM_BLOCK_BENCH_UNIFORMS]; // of the separate program
+static UniformBlock *block;
+static GLuint quadBuffer;
+static unsigned char *pixels[UNIFORM_BLOCK_BENCH_METHODS];
+
+static void make_quads(QuadUniforms *quads, int count)
+{
+    unsigned state = 99u;
+    for (int i = 0; i < count; ++i)
+    {
+        QuadUniforms *q = &quads[i];
+        float angle = bench_random(&state) * 6.2831853f;
+        float c = cosf(angle), s = sinf(angle);
+        GLfloat transform[16] = {c, s, 0, 0, -s, c, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        for (int k = 0; k < 16; ++k)
+            q->transform[k] = transform[k];
+        // A colour matrix that mixes a little of each channel into the others
+        for (int k = 0; k < 9; ++k)
+            q->colorMatrix[k] = (k % 4 == 0) ? 0.8f : bench_random(&state) * 0.2f;
+        for (int k = 0; k < 3; ++k)
+            q->color[k] = bench_random(&state);
+        q->color[3] = 1.0f;
+        q->offset[0] = bench_random(&state) * 1.6f - 0.8f;
+        q->offset[1] = bench_random(&state) * 1.6f - 0.8f;
+        q->scale = 0.01f + bench_random(&state) * 0.04f;
+        q->brightness = 0.5f + bench_random(&state) * 0.5f;
+    }
+}
+
+static int init_programs(void)
+{
+    programs[UNIFORM_BLOCK_BENCH_SEPARATE] =
+        shader_program_create(shader_block_quad_vert.source, shader_color_frag.source, "aPosition");
+    for (int i = 0; i < UNIFORM_BLOCK_BENCH_UNIFORMS; ++i)
+        locations[i] = glGetUniformLocation(programs[UNIFORM_BLOCK_BENCH_SEPARATE], entries[i].name);
+    block = uniform_block_create(entries, UNIFORM_BLOCK_BENCH_UNIFORMS, UNIFORM_BLOCK_VERTEX, 0);
+    if (block)
+    {
+        char *source = uniform_block_source(block, shader_block_quad_vert.source, UNIFORM_BLOCK_VERTEX);
+        programs[UNIFORM_BLOCK_BENCH_BLOCK] =
+            source ? shader_program_create(source, shader_color_frag.source, "aPosition") : 0;
+        free(source);
+        uniform_block_bind(block, programs[UNIFORM_BLOCK_BENCH_BLOCK]);
+    }
+    return programs[UNIFORM_BLOCK_BENCH_SEPARATE] && programs[UNIFORM_BLOCK_BENCH_BLOCK];
+}
+
+// Returns the uniform calls made.
+static int draw_frame(UniformBlockBenchMethod method, const QuadUniforms *quads, int count)
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(programs[method]);
+    int calls = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const QuadUniforms *q = &quads[i];
+        if (method == UNIFORM_BLOCK_BENCH_SEPARATE)
+        {
+            glUniformMatrix4fv(locations[0], 1, GL_FALSE, q->transform);
+            glUniformMatrix3fv(locations[1], 1, GL_FALSE, q->colorMatrix);
+            glUniform4fv(locations[2], 1, q->color);
+            glUniform2fv(locations[3], 1, q->offset);
+            glUniform1f(locations[4], q->scale);
+            glUniform1f(locations[5], q->brightness);
+            calls += UNIFORM_BLOCK_BENCH_UNIFORMS;
+        }
+        else
+        {
+            uniform_block_set(block, 0, q->transform);
+            uniform_block_set(block, 1, q->colorMatrix);
+            uniform_block_set(block, 2, q->color);
+            uniform_block_set(block, 3, q->offset);
+            uniform_block_set(block, 4, &q->scale);
+            uniform_block_set(block, 5, &q->brightness);
+            calls += uniform_block_upload(block);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    return calls;
+}
+
+static int max_difference(const unsigned char *a, const unsigned char *b)
+{
+    int largest = 0;
+    for (size_t i = 0; i < (size_t)size * (size_t)size * 4; ++i)
+    {
+        int difference = abs((int)a[i] - (int)b[i]);
+        largest = difference > largest ? difference : largest;
+    }
+    return largest;
+}
+
+static void run_count(int count)
+{
+    QuadUniforms *quads = (QuadUniforms *)malloc((size_t)count * sizeof(QuadUniforms));
+    if (!quads)
+    {
+        printf("%-10d %-10s %12s\n", count, "", "out of memory");
+        return;
+    }
+    make_quads(quads, count);
+    for (int method = 0; method < UNIFORM_BLOCK_BENCH_METHODS; ++method)
+    {
+        int calls = 0;
+        for (int frame = -1; frame < frameCount; ++frame)
+        {
+            double start = bench_seconds();
+            calls = draw_frame((UniformBlockBenchMethod)method, quads, count);
+            glFinish();
+            if (frame >= 0)
+                times[frame] = bench_seconds() - start;
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels[method]);
+        printf("%-10d %-10s %14d %12.3f", count, methodNames[method], calls, bench_median_ms(times, frameCount));
+        if (method == UNIFORM_BLOCK_BENCH_BLOCK)
+            printf(" %10d", max_difference(pixels[method], pixels[UNIFORM_BLOCK_BENCH_SEPARATE]));
+        printf("\n");
+    }
+    free(quads);
+}
+
+int main(int argc, char **argv)
+{
+    int counts[UNIFORM_BLOCK_BENCH_MAX_COUNTS] = {1000, 10000};
+    int countCount = 2;
+    if (argc > 1 && atoi(argv[1]) >= 16)
+        size = atoi(argv[1]);
+    if (argc > 2 && atoi(argv[2]) > 0)
+        frameCount = atoi(argv[2]);
+    if (frameCount > UNIFORM_BLOCK_BENCH_MAX_FRAMES)
+        frameCount = UNIFORM_BLOCK_BENCH_MAX_FRAMES;
+    if (argc > 3)
+    {
+        countCount = 0;
+        for (int i = 3; i < argc && countCount < UNIFORM_BLOCK_BENCH_MAX_COUNTS; ++i)
+        {
+            if (atoi(argv[i]) > 0)
+                counts[countCount++] = atoi(argv[i]);
+        }
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(size, size, "uniform_block_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    for (int method = 0; method < UNIFORM_BLOCK_BENCH_METHODS; ++method)
+    {
+        pixels[method] = (unsigned char *)malloc((size_t)size * (size_t)size * 4);
+        if (!pixels[method])
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+    if (!init_programs())
+    {
+        glfwTerminate();
+        return 1;
+    }
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    glEnableVertexAttribArray(0);
+    glViewport(0, 0, size, size);
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    printf("INFO: %s, %dx%d, %d frames, block of %d vectors\n", renderer ? renderer : "unknown renderer", size, size,
+           frameCount, uniform_block_vectors(block));
+    printf("%-10s %-10s %14s %12s %10s\n", "quads", "method", "uniform calls", "frame ms", "max err");
+    for (int i = 0; i < countCount; ++i)
+        run_count(counts[i]);
+
+    uniform_block_destroy(block);
+    for (int method = 0; method < UNIFORM_BLOCK_BENCH_METHODS; ++method)
+        glDeleteProgram(programs[method]);
+    glDeleteBuffers(1, &quadBuffer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,56 @@
+// frame_capture.h
+// Frame capture for the samples. Frames are rendered into two offscreen
+// framebuffers used alternately; frame N-1 is read back at the start of
+// frame N, before any of frame N's commands are issued, so the readback
+// does not wait for the frame that is being rendered. Pixels are handed to
+// a writer thread through a lock-free single-producer/single-consumer queue,
+// which flips them and stores one PPM file per frame, or passes them to a
+// frame recorder (frame_recorder.h).
+//
+// When offscreen framebuffers are not available (e.g. on the software
+// renderer) the default framebuffer is read back at the end of each frame.
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FrameCapture FrameCapture;
+
+typedef struct FrameCaptureStats
+{
+    unsigned long long frames;   // frames handed to the writer thread
+    unsigned long long written;  // frames stored by the writer thread
+    unsigned long long dropped;  // frames skipped because the queue was full
+    double captureMs;            // average time per frame in frame_capture_begin/end
+    double maxCaptureMs;         // longest frame_capture_begin + end pair
+    double waitMs;               // average glFinish before a synchronous readback, not in captureMs
+    double frameMs;              // average time from one frame_capture_end to the next
+    int offscreen;               // 1 when rendering into offscreen framebuffers
+} FrameCaptureStats;
+
+// Creates a capture of width x height pixels whose frames are stored as
+// <prefix>_<frame>.ppm. Returns NULL when the resources cannot be created.
+// Needs a current GL context.
+FrameCapture *frame_capture_create(int width, int height, const char *prefix);
+// Creates a capture that records every frame into one QOI recording.
+FrameCapture *frame_capture_create_recording(int width, int height, const char *path);
+// Creates a recording capture when SAMPLES_RECORD holds a file name, a PPM
+// capture when SAMPLES_CAPTURE holds a file prefix, NULL otherwise.
+FrameCapture *frame_capture_create_from_env(int width, int height);
+// Drains the queue, prints the statistics and releases the GL resources.
+void frame_capture_destroy(FrameCapture *capture);
+
+// Bracket the rendering of each frame; call frame_capture_end before the
+// buffer swap. Both are no-ops for a NULL capture.
+void frame_capture_begin(FrameCapture *capture);
+void frame_capture_end(FrameCapture *capture);
+
+void frame_capture_get_stats(const FrameCapture *capture, FrameCaptureStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,84 @@
+// frame_recorder.h
+// Streaming recorder: frames are QOI-encoded by worker threads, each worker
+// taking whole frames, and appended in order to a memory-mapped file.
+//
+// File layout (little-endian):
+//   FrameRecordHeader
+//   per frame: FrameRecordChunk, then chunk.size bytes of QOI data, padded to 8
+//   index:     frameCount uint64 file offsets of the chunks
+// The header's indexOffset and frameCount are written when the recording is
+// closed. Files left without an index (a crashed recording) can still be
+// read by walking the chunks.
+#ifndef FRAME_RECORDER_H
+#define FRAME_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_RECORD_MAGIC 0x43455251u // "QREC"
+#define FRAME_RECORD_CHUNK_MAGIC 0x4d524651u // "QFRM"
+#define FRAME_RECORD_VERSION 1
+
+typedef struct FrameRecordHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint64_t frameCount;
+    uint64_t indexOffset; // 0 until the recording is closed
+} FrameRecordHeader;
+
+typedef struct FrameRecordChunk
+{
+    uint32_t magic;
+    uint32_t size;   // QOI bytes that follow
+    uint64_t frame;  // frame number given to frame_recorder_submit
+} FrameRecordChunk;
+
+typedef struct FrameRecorder FrameRecorder;
+
+typedef struct FrameRecorderStats
+{
+    unsigned long long frames;
+    unsigned long long bytes;   // QOI data written
+    double encodeMs;            // average time to encode one frame
+    double submitWaitMs;        // average time frame_recorder_submit waited for a free job
+} FrameRecorderStats;
+
+// Creates path and starts threadCount encoders (0: one per CPU).
+FrameRecorder *frame_recorder_create(const char *path, int width, int height, int threadCount);
+// Queues one RGBA8 frame; rows are stride bytes apart (negative for bottom-up
+// images, with pixels pointing at the top row). The pixels are copied, so
+// the caller may reuse them on return. Blocks while every job is in use.
+int frame_recorder_submit(FrameRecorder *recorder, const unsigned char *pixels, ptrdiff_t stride,
+                          unsigned long long frame);
+// Waits for the queued frames, writes the index and closes the file.
+void frame_recorder_close(FrameRecorder *recorder, FrameRecorderStats *stats);
+
+// Read side: maps a recording and finds its frames in O(1) through the
+// index (or one pass over the chunks when the index is missing).
+typedef struct FrameRecording
+{
+    const unsigned char *data;
+    size_t size;
+    FrameRecordHeader header;
+    const uint64_t *index; // chunk offsets, header.frameCount entries
+    uint64_t *rebuiltIndex;
+} FrameRecording;
+
+int frame_recording_open(FrameRecording *recording, const char *path);
+void frame_recording_close(FrameRecording *recording);
+// QOI data of the i-th recorded frame, NULL when out of range.
+const unsigned char *frame_recording_frame(const FrameRecording *recording, uint64_t i, size_t *size,
+                                           unsigned long long *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_RECORDER_H
@@ -0,0 +1,36 @@
+// qoi.h
+// Lossless QOI image codec ("Quite OK Image" format, qoiformat.org) used by
+// the frame recorder. The encoder finds pixel runs and computes the colour
+// index hashes for blocks of pixels with SSE2 before the sequential pass.
+#ifndef QOI_H
+#define QOI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+
+// Largest encoding of a width x height image.
+size_t qoi_max_size(int width, int height);
+
+// Encodes RGBA8 pixels; rows are stride bytes apart, so a negative stride
+// with a pointer to the last row flips a bottom-up image. With channels 3
+// the alpha bytes are ignored. Returns the encoded size.
+size_t qoi_encode(const unsigned char *pixels, int width, int height, ptrdiff_t stride, int channels,
+                  unsigned char *out);
+
+// Reads the size from a QOI header. Returns 0 when data is not a QOI image.
+int qoi_read_header(const unsigned char *data, size_t size, int *width, int *height, int *channels);
+// Decodes into width x height RGBA8 pixels, top row first. Returns 0 on
+// malformed input.
+int qoi_decode(const unsigned char *data, size_t size, unsigned char *pixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QOI_H
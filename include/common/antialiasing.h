@@ -0,0 +1,58 @@
+// antialiasing.h
+// Antialiasing for the samples, selected with SAMPLES_AA:
+//   none           aliased edges (default)
+//   fxaa           the scene is rendered into a single-sample offscreen
+//                  framebuffer and drawn to the window by an FXAA pass,
+//                  which blends across the edges it finds in the image
+//   msaa[:<n>]     the window is created with n samples (default 4,
+//                  GLFW_SAMPLES) and resolved by the driver
+// FXAA costs one full-screen pass and an extra colour and depth buffer
+// whatever the scene; MSAA multiplies the memory and, on software
+// rasterizers, much of the fill cost by the sample count, but only touches
+// real geometry edges.
+#ifndef ANTIALIASING_H
+#define ANTIALIASING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum AntialiasingMode
+{
+    ANTIALIASING_NONE,
+    ANTIALIASING_FXAA,
+    ANTIALIASING_MSAA,
+    ANTIALIASING_MODES
+} AntialiasingMode;
+
+typedef struct Antialiasing Antialiasing;
+
+// Reads SAMPLES_AA and, for msaa, sets the GLFW_SAMPLES window hint; call
+// it before glfwCreateWindow. samples receives the requested sample count.
+AntialiasingMode antialiasing_hint_from_env(int *samples);
+// Sets the window hint of mode: GLFW_SAMPLES to samples for msaa, 0 otherwise.
+void antialiasing_hint(AntialiasingMode mode, int samples);
+
+// Creates the per-frame work of mode for a window of width x height pixels
+// and prints what is in use. Returns NULL when there is none: for none and
+// msaa, and for fxaa without offscreen framebuffers (e.g. on the software
+// renderer). Needs a current GL context.
+Antialiasing *antialiasing_create(AntialiasingMode mode, int width, int height);
+void antialiasing_destroy(Antialiasing *antialiasing);
+
+// Bracket the rendering of the scene; both are no-ops for NULL. begin binds
+// the offscreen framebuffer, end runs the FXAA pass into the framebuffer
+// that was bound at begin.
+void antialiasing_begin(Antialiasing *antialiasing);
+void antialiasing_end(Antialiasing *antialiasing);
+
+// Bytes of the offscreen buffers that fxaa adds.
+unsigned long long antialiasing_extra_bytes(const Antialiasing *antialiasing);
+
+const char *antialiasing_mode_name(AntialiasingMode mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ANTIALIASING_H
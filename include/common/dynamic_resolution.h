@@ -0,0 +1,59 @@
+// dynamic_resolution.h
+// Dynamic resolution for the samples: the scene is rendered into an
+// offscreen framebuffer at a fraction of the window size and stretched to
+// the window with a bilinear pass. The fraction follows the frame time, so
+// a scene that is too slow at full resolution holds its frame rate instead.
+//
+// The frame time is measured from dynamic_resolution_begin to the end of
+// the upscale, with a glFinish, so swap pacing and vsync do not hide the
+// cost of rendering. A PI controller works on the logarithm of the pixel
+// count, to which fill-bound rendering is about proportional: the error is
+// log(target / frame time), errors within 5% are ignored so the scale does
+// not wander with timing noise, and the integral stops while the scale is
+// at either limit.
+//
+// SAMPLES_DYNAMIC_RESOLUTION=<target ms>[:<min scale>] enables it; the
+// minimum scale per axis defaults to 0.25. Every second the chosen scale
+// and the frame time are printed.
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DynamicResolution DynamicResolution;
+
+typedef struct DynamicResolutionStats
+{
+    unsigned long long frames;
+    unsigned long long overBudget; // frames slower than the target
+    double scale;                  // per axis, for the next frame
+    double frameMs;                // last frame
+    double averageScale;
+    double averageFrameMs;
+} DynamicResolutionStats;
+
+// Creates the offscreen target for a window of width x height pixels.
+// Returns NULL when offscreen framebuffers are not available (e.g. on the
+// software renderer). Needs a current GL context.
+DynamicResolution *dynamic_resolution_create(int width, int height, double targetMs, double minScale);
+// Reads SAMPLES_DYNAMIC_RESOLUTION; NULL when it is not set.
+DynamicResolution *dynamic_resolution_create_from_env(int width, int height);
+// Prints the statistics and releases the GL resources.
+void dynamic_resolution_destroy(DynamicResolution *resolution);
+
+// Bracket the rendering of the scene. begin binds the offscreen framebuffer
+// and returns the size to render at; for a NULL resolution both are left
+// as they are. end draws the scene into the framebuffer that was bound at
+// begin, e.g. the window or a frame capture's target.
+void dynamic_resolution_begin(DynamicResolution *resolution, int *renderWidth, int *renderHeight);
+void dynamic_resolution_end(DynamicResolution *resolution);
+
+void dynamic_resolution_get_stats(const DynamicResolution *resolution, DynamicResolutionStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DYNAMIC_RESOLUTION_H
@@ -0,0 +1,58 @@
+// gl_pass.h
+// Full-screen passes run in the middle of a sample's frame loop: frame
+// capture, dynamic resolution, FXAA, programmable blending and the weighted
+// transparency composite. A pass saves the state it changes, sets up its
+// own and puts everything back afterwards:
+//   GlPassState state;
+//   gl_pass_save_state(&state);
+//   glBindFramebuffer(...);
+//   gl_pass_set_state(width, height);
+//   glUseProgram(program); glBindTexture(...);
+//   gl_pass_draw(buffer);
+//   gl_pass_restore_state(&state);
+// The framebuffer binding is not part of the state: every pass chooses its
+// target itself. The programs take the triangle's corners in attribute 0,
+// e.g. texture_quad_vert linked with shader_program_create(..., "aPosition").
+#ifndef GL_PASS_H
+#define GL_PASS_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GlPassState
+{
+    GLint program;
+    GLint arrayBuffer;
+    GLint viewport[4];
+    GLint activeTexture;
+    GLint textures[2]; // units 0 and 1
+    GLboolean colorMask[4];
+    GLboolean depthMask;
+    GLfloat clearColor[4];
+    GLboolean blend, scissor, cull, depth, stencil;
+    GLint equationRgb, equationAlpha, srcRgb, dstRgb, srcAlpha, dstAlpha;
+    GLint attribEnabled, attribSize, attribType, attribNormalized, attribStride, attribBuffer;
+    void *attribPointer;
+} GlPassState;
+
+// Leaves texture unit 0 active.
+void gl_pass_save_state(GlPassState *state);
+void gl_pass_restore_state(const GlPassState *state);
+// Viewport (0, 0, width, height), every colour channel written, blending,
+// scissor, culling, depth and stencil tests off.
+void gl_pass_set_state(int width, int height);
+
+// A buffer with one triangle covering the viewport. The array buffer
+// binding is kept.
+GLuint gl_pass_create_triangle(void);
+// Draws the triangle in buffer through attribute 0 with the current program.
+void gl_pass_draw(GLuint buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GL_PASS_H
@@ -0,0 +1,59 @@
+// gl_tracker.h
+// GL object tracker: counts the buffers, textures, renderbuffers,
+// framebuffers, shaders and programs that are alive and estimates their
+// memory from the sizes and formats passed to glBufferData, glTexImage2D,
+// glCompressedTexImage2D, glCopyTexImage2D, glGenerateMipmap and
+// glRenderbufferStorage. Estimates are the bytes the application specified;
+// drivers may pad or compress them.
+//
+// The tracker is compiled in only when SAMPLES_GL_TRACKER is defined
+// (cmake -DSAMPLES_GL_TRACKER=ON). The GL and GLFW calls are intercepted at
+// link time (ld --wrap), so the samples need no changes. Objects belong to
+// the windows sharing a context with the one that was current when they
+// were created. When the last window of such a group is destroyed, and at
+// exit for the groups still alive, the objects that were never deleted are
+// reported.
+//
+// Without SAMPLES_GL_TRACKER the totals stay zero.
+#ifndef GL_TRACKER_H
+#define GL_TRACKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum GlTrackerKind
+{
+    GL_TRACKER_BUFFER,
+    GL_TRACKER_TEXTURE,
+    GL_TRACKER_RENDERBUFFER,
+    GL_TRACKER_FRAMEBUFFER,
+    GL_TRACKER_SHADER,
+    GL_TRACKER_PROGRAM,
+    GL_TRACKER_KINDS
+} GlTrackerKind;
+
+typedef struct GlTrackerTotals
+{
+    unsigned long long objects[GL_TRACKER_KINDS]; // alive
+    unsigned long long bytes[GL_TRACKER_KINDS];   // estimated, alive
+    unsigned long long totalBytes;
+    unsigned long long peakBytes; // highest totalBytes so far
+    unsigned long long created;
+    unsigned long long deleted;
+} GlTrackerTotals;
+
+// Whether the tracker is compiled in.
+int gl_tracker_enabled(void);
+// Totals over every context, safe to call from any thread.
+void gl_tracker_get_totals(GlTrackerTotals *totals);
+// Prints the objects alive in every context. Returns how many there are.
+unsigned long long gl_tracker_report(void);
+
+const char *gl_tracker_kind_name(GlTrackerKind kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GL_TRACKER_H
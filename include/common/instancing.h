@@ -0,0 +1,71 @@
+// instancing.h
+// Many copies of one small mesh in few draw calls. With
+// GL_ANGLE_instanced_arrays or GL_EXT_instanced_arrays the per-instance
+// vectors go into a buffer whose attributes advance once per instance, and
+// every instance is one glDrawArraysInstanced. Without either, it falls
+// back to pseudo-instancing: the mesh is stored a batch of times over, each
+// copy with its number in an extra attribute, and the instances' vectors
+// are uploaded into a uniform array with one glUniform4fv per batch. The
+// batch is as large as GL_MAX_VERTEX_UNIFORM_VECTORS allows.
+//
+// The vertex shader follows the layout of shaders/instanced_vert.glsl:
+// vectorsPerInstance vec4s per instance, read from attributes aInstance0,
+// aInstance1, ... on the hardware path, and from
+// uInstances[int(aInstanceIndex) * vectorsPerInstance + i] when the
+// library defines INSTANCING_BATCH (the batch size) and INSTANCING_VECTORS
+// (the array size) after its #version line. The mesh is the vertex
+// attribute aPosition.
+//
+// Copies of the mesh are drawn as one primitive list, so the mode is
+// GL_POINTS, GL_LINES or GL_TRIANGLES.
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum InstancingPath
+{
+    INSTANCING_HARDWARE,
+    INSTANCING_PSEUDO
+} InstancingPath;
+
+typedef struct Instancing Instancing;
+
+// SAMPLES_INSTANCING=pseudo forces the fallback; otherwise hardware is
+// preferred.
+InstancingPath instancing_path_from_env(void);
+
+// Builds the program for preferred, or for pseudo-instancing when the
+// context has no instanced arrays, and prints the path in use.
+// reservedVectors counts the vertex uniform vectors the shader uses besides
+// uInstances. Returns NULL when the shader does not compile or not even one
+// instance fits in the uniform vectors. Needs a current GL context.
+Instancing *instancing_create(InstancingPath preferred, const char *vertexSource, const char *fragmentSource,
+                              int vectorsPerInstance, int reservedVectors);
+void instancing_destroy(Instancing *instancing);
+
+GLuint instancing_program(const Instancing *instancing);
+InstancingPath instancing_path(const Instancing *instancing);
+// Instances per draw call on the pseudo path; 0 on the hardware path,
+// where there is no limit.
+int instancing_batch_size(const Instancing *instancing);
+const char *instancing_path_name(InstancingPath path);
+
+// The mesh: vertexCount positions of components (2-4) floats each.
+void instancing_set_mesh(Instancing *instancing, const GLfloat *positions, int vertexCount, int components);
+
+// Draws instanceCount copies of the mesh with instancing's program, which
+// it makes current. instances holds vectorsPerInstance * 4 floats per
+// instance. Leaves GL_ARRAY_BUFFER unbound and the attributes it used
+// disabled. Returns the draw calls made.
+int instancing_draw(Instancing *instancing, GLenum mode, const GLfloat *instances, int instanceCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INSTANCING_H
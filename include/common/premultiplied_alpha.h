@@ -0,0 +1,47 @@
+// premultiplied_alpha.h
+// Conversion of straight-alpha colours to premultiplied form, done once when
+// vertex or texture data is uploaded. Premultiplied, alpha-over and additive
+// primitives share one blend state, glBlendFunc(GL_ONE,
+// GL_ONE_MINUS_SRC_ALPHA), and can be drawn in one batch:
+//   over       (r, g, b, a) -> (r*a, g*a, b*a, a)   like GL_SRC_ALPHA,
+//                                                   GL_ONE_MINUS_SRC_ALPHA
+//   additive   (r, g, b, a) -> (r*a, g*a, b*a, 0)   like GL_SRC_ALPHA, GL_ONE
+// The colour channels come out as with the straight-alpha blend states. The
+// destination alpha does not: it becomes the coverage, a + d*(1 - a) for
+// over and unchanged for additive, where straight alpha blends the alpha
+// channel with the same factors as the colour.
+#ifndef PREMULTIPLIED_ALPHA_H
+#define PREMULTIPLIED_ALPHA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum PremultipliedBlend
+{
+    PREMULTIPLIED_OVER,
+    PREMULTIPLIED_ADDITIVE,
+    PREMULTIPLIED_BLENDS
+} PremultipliedBlend;
+
+// out may be rgba.
+void premultiply_color(PremultipliedBlend blend, const float rgba[4], float out[4]);
+// count colours of 4 floats, stride bytes apart (e.g. in interleaved
+// vertices), in place.
+void premultiply_colors(PremultipliedBlend blend, float *colors, size_t count, size_t stride);
+// count RGBA8 pixels in place, rounded to nearest.
+void premultiply_rgba8(PremultipliedBlend blend, unsigned char *pixels, size_t count);
+
+const char *premultiplied_blend_name(PremultipliedBlend blend);
+
+// Whether SAMPLES_PREMULTIPLIED=1 asks the samples that support it to
+// draw premultiplied.
+int premultiplied_alpha_from_env(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PREMULTIPLIED_ALPHA_H
@@ -0,0 +1,79 @@
+// profiler.h
+// CPU zone profiler. Zones are recorded into per-thread buffers with
+// nanosecond timestamps and exported as a Chrome trace (chrome://tracing,
+// ui.perfetto.dev) when the process exits, to the file named by
+// SAMPLES_PROFILE (default trace.json).
+//
+// The profiler is compiled in only when SAMPLES_PROFILER is defined
+// (cmake -DSAMPLES_PROFILER=ON); otherwise every macro expands to nothing.
+//
+//   PROFILE_ZONE("name");        zone until the end of the enclosing block
+//   PROFILE_BEGIN("name"); ...   explicit zone, closed by PROFILE_END()
+//   PROFILE_CALL(f(x));          zone named after the call around one call
+//   PROFILE_THREAD_NAME("name"); name of the calling thread in the trace
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#if defined(SAMPLES_PROFILER)
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ProfileScope
+{
+    const char *name;
+    uint64_t start;
+} ProfileScope;
+
+static inline uint64_t profile_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Records a finished zone; name must outlive the process (a literal).
+void profile_record(const char *name, uint64_t start, uint64_t end);
+void profile_begin(const char *name);
+void profile_end(void);
+void profile_scope_end(ProfileScope *scope);
+void profile_set_thread_name(const char *name);
+// Writes every zone recorded so far. Threads that are still recording may
+// miss their latest zones. Returns 0 when the file cannot be written.
+int profile_write_chrome_trace(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name)                                                                        \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__) __attribute__((cleanup(profile_scope_end))) = \
+        {(name), profile_now()}
+#define PROFILE_BEGIN(name) profile_begin(name)
+#define PROFILE_END() profile_end()
+#define PROFILE_CALL(call)    \
+    do                        \
+    {                         \
+        profile_begin(#call); \
+        call;                 \
+        profile_end();        \
+    } while (0)
+#define PROFILE_THREAD_NAME(name) profile_set_thread_name(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#define PROFILE_CALL(call) call
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif // SAMPLES_PROFILER
+
+#endif // PROFILER_H
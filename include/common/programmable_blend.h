@@ -0,0 +1,75 @@
+// programmable_blend.h
+// Blend modes beyond what ES 2.0 blending offers, done in a shader. The
+// frame is drawn into one of two offscreen images; a draw with a mode the
+// blend unit lacks goes into a layer instead, which is then composited with
+// the current image into the other one, reading both as textures, and the
+// two swap. Modes:
+//   add, subtract, reverse subtract   GL_FUNC_* with GL_SRC_ALPHA and
+//                                     GL_ONE_MINUS_SRC_ALPHA
+//   min, max                          GL_MIN_EXT and GL_MAX_EXT
+//   multiply, screen, overlay         separable blend of the colours,
+//                                     mixed in by the source alpha
+// The core equations, and min and max where GL_EXT_blend_minmax is present,
+// use the blend unit unless programmable_blend_use_hardware turns it off.
+//
+// A layer is composited as a whole: its draws overwrite each other rather
+// than blend with each other, and the stencil buffer marks the pixels they
+// cover, so layers cannot use stencil testing of their own. The images have
+// no depth buffer. Each layer costs a full-screen pass that reads two
+// textures.
+#ifndef PROGRAMMABLE_BLEND_H
+#define PROGRAMMABLE_BLEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ProgrammableBlendMode
+{
+    PROGRAMMABLE_BLEND_ADD,
+    PROGRAMMABLE_BLEND_SUBTRACT,
+    PROGRAMMABLE_BLEND_REVERSE_SUBTRACT,
+    PROGRAMMABLE_BLEND_MIN,
+    PROGRAMMABLE_BLEND_MAX,
+    PROGRAMMABLE_BLEND_MULTIPLY,
+    PROGRAMMABLE_BLEND_SCREEN,
+    PROGRAMMABLE_BLEND_OVERLAY,
+    PROGRAMMABLE_BLEND_MODES
+} ProgrammableBlendMode;
+
+typedef struct ProgrammableBlend ProgrammableBlend;
+
+// Creates the images, the layer and the composite programs for a frame of
+// width x height pixels. Returns NULL without offscreen framebuffers with a
+// stencil attachment (e.g. on the software renderer). Needs a current GL
+// context.
+ProgrammableBlend *programmable_blend_create(int width, int height);
+void programmable_blend_destroy(ProgrammableBlend *blend);
+
+// Whether the blend unit does mode in this context.
+int programmable_blend_hardware_supports(ProgrammableBlendMode mode);
+// With enabled 0, every mode goes through a layer; 1 by default.
+void programmable_blend_use_hardware(ProgrammableBlend *blend, int enabled);
+
+// Bracket the frame: begin binds the current image, end draws it into the
+// width x height pixels at the origin of the framebuffer that was bound at
+// begin.
+void programmable_blend_begin(ProgrammableBlend *blend);
+void programmable_blend_end(ProgrammableBlend *blend);
+
+// Bracket draws blended with mode, between begin and end. draw_begin sets
+// up the blend unit, or binds a cleared layer; draw_end composites the
+// layer. The sample's blend and stencil state are restored by draw_end.
+void programmable_blend_draw_begin(ProgrammableBlend *blend, ProgrammableBlendMode mode);
+void programmable_blend_draw_end(ProgrammableBlend *blend);
+
+// Layers composited since creation.
+unsigned long long programmable_blend_layer_count(const ProgrammableBlend *blend);
+
+const char *programmable_blend_mode_name(ProgrammableBlendMode mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROGRAMMABLE_BLEND_H
@@ -0,0 +1,54 @@
+// sample_clock.h
+// Clock handed to each sample's draw(). Samples read the time of the frame
+// from the clock instead of glfwGetTime(), so the same code can run against
+// the wall clock or against a virtual clock that advances by a fixed step
+// per frame and produces the same frames on every run.
+//
+// SAMPLES_CLOCK selects the mode:
+//   real            wall-clock time (default)
+//   fixed[:<step>]  time advances by step seconds per frame (default 1/60);
+//                   frames are paced to the wall clock for viewing
+//   fast[:<step>]   like fixed, but frames run as fast as possible
+// SAMPLES_FRAMES=<n> ends the sample after n frames.
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum SampleClockMode
+{
+    SAMPLE_CLOCK_REAL,
+    SAMPLE_CLOCK_FIXED,
+    SAMPLE_CLOCK_FAST
+} SampleClockMode;
+
+typedef struct SampleClock
+{
+    SampleClockMode mode;
+    double step;               // seconds per frame in the fixed and fast modes
+    double time;               // seconds since the first frame
+    double delta;              // seconds since the previous frame
+    unsigned long long frame;  // index of the current frame
+    unsigned long long frameLimit; // 0: unlimited
+    double start;              // wall-clock time of the first frame
+    int started;
+} SampleClock;
+
+void sample_clock_init(SampleClock *clock, SampleClockMode mode, double step);
+// Reads SAMPLES_CLOCK and SAMPLES_FRAMES.
+void sample_clock_init_from_env(SampleClock *clock);
+// Starts the next frame: updates time, delta and frame. In the fixed mode
+// it waits until the frame is due on the wall clock.
+void sample_clock_tick(SampleClock *clock);
+// 1 once frameLimit frames have been ticked.
+int sample_clock_done(const SampleClock *clock);
+// Swap interval matching the mode: 0 for the fast mode, 1 otherwise.
+int sample_clock_swap_interval(const SampleClock *clock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_CLOCK_H
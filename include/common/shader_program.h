@@ -0,0 +1,35 @@
+// shader_program.h
+// Compiling and linking of the samples' shaders, with the info log printed
+// as an ERROR when a step fails.
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The compiled shader, or 0.
+GLuint shader_program_compile(GLenum type, const char *source);
+// The program linked from two compiled shaders, or 0. attribute, when not
+// NULL, is bound to location 0 before linking. The shaders are kept, e.g.
+// to link them again with other partners.
+GLuint shader_program_link(GLuint vertexShader, GLuint fragmentShader, const char *attribute);
+// The linked program, or 0. attribute, when not NULL, is bound to location
+// 0 before linking. The shaders are deleted either way.
+GLuint shader_program_create(const char *vertexSource, const char *fragmentSource, const char *attribute);
+// shader_program_create without the ERROR output, for callers that try
+// sources of which some are expected to fail.
+GLuint shader_program_try_create(const char *vertexSource, const char *fragmentSource, const char *attribute);
+
+// source with defines (e.g. "#define BLEND_MODE 3\n") inserted after its
+// #version line, or in front when it has none. The caller frees the
+// result. NULL when out of memory.
+char *shader_program_insert_defines(const char *source, const char *defines);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHADER_PROGRAM_H
@@ -0,0 +1,50 @@
+// shader_reload.h
+// Development mode that rebuilds a sample's programs when their .glsl files
+// change, without restarting. Enabled with SAMPLES_SHADER_RELOAD=1, which
+// watches the files the shaders were built from (ShaderSource.path), or
+// SAMPLES_SHADER_RELOAD=<directory>, which watches <directory>/<name>.glsl.
+//
+// Files are watched with inotify. When a file is saved, only that stage is
+// compiled again and the programs using it are relinked, on a worker thread
+// with a context sharing objects with the window's. The new program is
+// swapped in by shader_reload_update() at the next frame boundary; the
+// render thread only exchanges program names and copies uniform values.
+// A stage that fails to compile or link is reported and the old program
+// stays in use. Where contexts cannot share objects (swgl) the programs are
+// rebuilt by shader_reload_update() on the render thread instead.
+#ifndef SHADER_RELOAD_H
+#define SHADER_RELOAD_H
+
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+
+#include <common/shader_source.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ShaderReloader ShaderReloader;
+
+// Called on the render thread after a new program replaced the old one,
+// e.g. to look up uniform locations again. Attribute locations and uniform
+// values are carried over from the old program.
+typedef void (*ShaderReloadCallback)(GLuint program, void *userData);
+
+// Call with window's context current. NULL when SAMPLES_SHADER_RELOAD is
+// not set or the files cannot be watched; every function accepts NULL.
+ShaderReloader *shader_reload_create_from_env(GLFWwindow *window);
+void shader_reload_destroy(ShaderReloader *reloader);
+// Keeps *program, linked from vertex and fragment, up to date. program
+// must stay valid until the reloader is destroyed.
+void shader_reload_watch(ShaderReloader *reloader, GLuint *program, const ShaderSource *vertex,
+                         const ShaderSource *fragment, ShaderReloadCallback reloaded, void *userData);
+// Swaps in the programs rebuilt since the last call. Call once per frame
+// before drawing.
+void shader_reload_update(ShaderReloader *reloader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHADER_RELOAD_H
@@ -0,0 +1,34 @@
+// shader_source.h
+// Shaders embedded at build time. shader_pack reads shaders/*.glsl,
+// validates and minifies them and generates shaders.h, which declares one
+// ShaderSource per file (shaders/qualifiers_vert.glsl becomes
+// shader_qualifiers_vert) and the table shader_sources.
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ShaderStage
+{
+    SHADER_STAGE_VERTEX,
+    SHADER_STAGE_FRAGMENT
+} ShaderStage;
+
+typedef struct ShaderSource
+{
+    const char *name;        // file name without .glsl
+    const char *path;        // the .glsl file it was built from
+    ShaderStage stage;
+    const char *source;      // minified source
+    unsigned length;         // strlen(source)
+    unsigned originalLength; // bytes in the .glsl file
+    unsigned long long hash; // 64-bit FNV-1a of source, e.g. as a cache key
+} ShaderSource;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHADER_SOURCE_H
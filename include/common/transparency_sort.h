@@ -0,0 +1,58 @@
+// transparency_sort.h
+// Back-to-front ordering of translucent triangles for one glDrawElements.
+//
+// The depth of each triangle's centre is a dot product with a row of the
+// view transform, computed 4 triangles at a time with SSE2 when it is
+// available. Each depth becomes a 32-bit key whose unsigned order is the
+// float order, and the keys with their triangle numbers are sorted by an
+// LSD radix sort, 8 bits per pass. Passes in which every key has the same
+// digit are skipped. The triangles are split between threads: each counts
+// the digits of its part, works out where its keys go from everyone's
+// counts, and moves them there, so the sort is stable and triangles of
+// equal depth keep their order. The sorted triangles' indices are then
+// written out, also in parallel.
+#ifndef TRANSPARENCY_SORT_H
+#define TRANSPARENCY_SORT_H
+
+#include <GLES2/gl2.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TransparencySort TransparencySort;
+
+// Time spent in each step of the last transparency_sort_triangles
+typedef struct TransparencySortTimings
+{
+    double depthMs; // depths and keys
+    double sortMs;
+    double indexMs;
+    int passes; // radix passes not skipped
+} TransparencySortTimings;
+
+// A sorter for up to capacity triangles. threadCount 0: one thread per CPU.
+// Returns NULL when out of memory.
+TransparencySort *transparency_sort_create(size_t capacity, int threadCount);
+void transparency_sort_destroy(TransparencySort *sort);
+
+// Writes the indices of count triangles to indices (3 each), farthest
+// first. centres holds x, y, z of each triangle's centre; the distance
+// from the viewer is depthRow[0] * x + depthRow[1] * y + depthRow[2] * z +
+// depthRow[3], e.g. the negated third row of a view matrix or the third row
+// of an orthographic projection. sourceIndices holds the triangles' 3
+// indices each, or is NULL for triangles stored one after the other
+// (triangle t is vertices 3t to 3t + 2). count is at most the capacity.
+void transparency_sort_triangles(TransparencySort *sort, const float *centres, size_t count,
+                                 const float depthRow[4], const GLuint *sourceIndices, GLuint *indices);
+
+void transparency_sort_get_timings(const TransparencySort *sort, TransparencySortTimings *timings);
+int transparency_sort_thread_count(const TransparencySort *sort);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRANSPARENCY_SORT_H
@@ -0,0 +1,91 @@
+// uniform_block.h
+// Uniform blocks for ES 2.0: a program's uniforms packed into one vec4
+// array, so that all of them are uploaded with a single glUniform4fv.
+//
+// The layout is worked out when the block is created. Larger types are
+// placed first, and smaller ones fill the components the larger ones leave
+// free. For example, two floats go into the w of a mat3's columns. The
+// result is checked against GL_MAX_VERTEX_UNIFORM_VECTORS and
+// GL_MAX_FRAGMENT_UNIFORM_VECTORS of the stages that declare the block.
+//
+// The shaders of those stages are compiled from uniform_block_source, which
+// adds after the #version line (shader_program_insert_defines)
+//   #define UNIFORM_BLOCK_VECTORS <vectors>
+// and a macro per uniform that reads it out of the array, e.g.
+//   #define uModel mat4(uUniformBlock[0], uUniformBlock[1], ...)
+// so a shader keeps its uniform names and only swaps the declarations:
+//   #ifdef UNIFORM_BLOCK_VECTORS
+//   uniform vec4 uUniformBlock[UNIFORM_BLOCK_VECTORS];
+//   #else
+//   uniform mat4 uModel;
+//   #endif
+// A block declared by both stages must have the same precision in both.
+//
+// Per frame, or per draw:
+//   uniform_block_set(block, index, values); ... for the uniforms that change
+//   glUseProgram(program);
+//   uniform_block_upload(block);
+#ifndef UNIFORM_BLOCK_H
+#define UNIFORM_BLOCK_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum UniformBlockType
+{
+    UNIFORM_BLOCK_FLOAT,
+    UNIFORM_BLOCK_VEC2,
+    UNIFORM_BLOCK_VEC3,
+    UNIFORM_BLOCK_VEC4,
+    UNIFORM_BLOCK_MAT2,
+    UNIFORM_BLOCK_MAT3,
+    UNIFORM_BLOCK_MAT4
+} UniformBlockType;
+
+// Stages that declare the block
+#define UNIFORM_BLOCK_VERTEX 1
+#define UNIFORM_BLOCK_FRAGMENT 2
+
+typedef struct UniformBlockEntry
+{
+    const char *name;
+    UniformBlockType type;
+} UniformBlockEntry;
+
+typedef struct UniformBlock UniformBlock;
+
+// Lays out entryCount uniforms for the stages in stages. reservedVectors
+// counts the uniform vectors those stages use outside the block. Returns
+// NULL, and prints why, when the block does not fit the queried limits.
+// Needs a current GL context.
+UniformBlock *uniform_block_create(const UniformBlockEntry *entries, int entryCount, int stages, int reservedVectors);
+void uniform_block_destroy(UniformBlock *block);
+
+// source, the shader of stage (UNIFORM_BLOCK_VERTEX or
+// UNIFORM_BLOCK_FRAGMENT), with the block's defines when stage declares it.
+// The caller frees the result. NULL when out of memory.
+char *uniform_block_source(const UniformBlock *block, const char *source, int stage);
+// Uses the block with program, linked from shaders of uniform_block_source,
+// from now on.
+void uniform_block_bind(UniformBlock *block, GLuint program);
+
+// The index of the uniform called name, or -1.
+int uniform_block_find(const UniformBlock *block, const char *name);
+// Sets uniform index to values: 1 to 4 floats for the scalar and vector
+// types, 4, 9 or 16 for the matrices, column-major.
+void uniform_block_set(UniformBlock *block, int index, const GLfloat *values);
+// Uploads the block into the bound program, which must be current, if a
+// value changed since the last upload. Returns the glUniform4fv calls made.
+int uniform_block_upload(UniformBlock *block);
+
+// The vec4s of the block.
+int uniform_block_vectors(const UniformBlock *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UNIFORM_BLOCK_H
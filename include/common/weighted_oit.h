@@ -0,0 +1,67 @@
+// weighted_oit.h
+// Weighted blended order-independent transparency (McGuire and Bavoil):
+// translucent geometry drawn in any order, without sorting. Each fragment
+// is added into offscreen targets with a weight that favours the nearer
+// ones, and a composite pass divides the weights out and blends the
+// average colour over the framebuffer by the product of (1 - alpha). The
+// result is an approximation: it matches sorted blending for similar
+// colours and alphas and drifts from it where a few opaque-looking layers
+// overlap.
+//
+// The targets are half-float (or float) textures, so the context needs
+// renderable floating-point colour buffers (e.g. GL_OES_texture_half_float
+// with GL_EXT_color_buffer_half_float). With GL_EXT_draw_buffers the
+// geometry is drawn once into both targets; without it, once per target.
+// The targets have no depth buffer, so opaque geometry does not hide the
+// translucent geometry behind it.
+//
+// Per frame:
+//   weighted_oit_begin(oit);
+//   for (int pass = 0; pass < weighted_oit_pass_count(oit); ++pass)
+//   {
+//       weighted_oit_pass(oit, pass, program);
+//       ... draw the translucent geometry with program ...
+//   }
+//   weighted_oit_end(oit);
+// where program was linked with the fragment shader of
+// weighted_oit_fragment_shader, which takes a straight-alpha vColor.
+#ifndef WEIGHTED_OIT_H
+#define WEIGHTED_OIT_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct WeightedOit WeightedOit;
+
+// Creates the targets and the composite pass for a framebuffer of width x
+// height pixels and prints what is in use. Returns NULL without renderable
+// floating-point textures (e.g. on the software renderer). Needs a current
+// GL context.
+WeightedOit *weighted_oit_create(int width, int height);
+void weighted_oit_destroy(WeightedOit *oit);
+
+// The compiled oit_frag shader for this context's path, to attach to the
+// programs of the translucent geometry. Owned by oit.
+GLuint weighted_oit_fragment_shader(const WeightedOit *oit);
+// 1 with GL_EXT_draw_buffers, 2 without.
+int weighted_oit_pass_count(const WeightedOit *oit);
+
+// begin saves the framebuffer binding and the state the passes change;
+// pass binds and clears the target of pass, sets the blend state and
+// program's uPass; end composites into the framebuffer bound at begin and
+// restores the state.
+void weighted_oit_begin(WeightedOit *oit);
+void weighted_oit_pass(WeightedOit *oit, int pass, GLuint program);
+void weighted_oit_end(WeightedOit *oit);
+
+// Bytes of the offscreen targets.
+unsigned long long weighted_oit_bytes(const WeightedOit *oit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEIGHTED_OIT_H
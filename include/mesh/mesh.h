@@ -0,0 +1,60 @@
+// mesh.h
+// Loads .mesh files (mesh_format.h) into GL buffers. The file is mapped
+// into memory and its vertex and index sections are passed to
+// glBufferData as they are; pages are read by the kernel as the upload
+// touches them.
+#ifndef MESH_H
+#define MESH_H
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+#include <mesh/mesh_format.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A mapped .mesh file
+typedef struct MeshFile
+{
+    const MeshFileHeader *header;
+    const void *vertices;
+    const void *indices;
+    void *mapping;
+    size_t size;
+} MeshFile;
+
+typedef struct Mesh
+{
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLenum indexType;
+    GLsizei indexCount;
+    GLsizei vertexStride;
+    GLuint attributes; // MESH_ATTRIBUTE_*
+    float boundsMin[3];
+    float boundsMax[3];
+} Mesh;
+
+// Maps and validates a .mesh file. Returns 0 with an error message when
+// the file cannot be read or is not a valid mesh.
+int mesh_file_map(const char *path, MeshFile *file);
+void mesh_file_unmap(MeshFile *file);
+
+// Creates the buffers of a mapped file. 32-bit indices need
+// GL_OES_element_index_uint. Needs a current GL context.
+int mesh_upload(const MeshFile *file, Mesh *mesh);
+// mesh_file_map, mesh_upload and mesh_file_unmap.
+int mesh_load(const char *path, Mesh *mesh);
+void mesh_destroy(Mesh *mesh);
+
+// Draws the mesh with glDrawElements. Attributes with location -1, or
+// missing from the mesh, are not enabled.
+void mesh_draw(const Mesh *mesh, GLint positionLocation, GLint normalLocation, GLint texcoordLocation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MESH_H
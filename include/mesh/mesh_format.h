@@ -0,0 +1,62 @@
+// mesh_format.h
+// Binary mesh file (.mesh) written by obj2mesh. The vertex and index data
+// are stored exactly as they are uploaded, so a loader maps the file and
+// hands the two sections to glBufferData without parsing anything.
+//
+// Layout, little-endian:
+//   MeshFileHeader
+//   vertices  at vertexOffset: vertexCount * vertexStride bytes of
+//             interleaved floats: position xyz, then normal xyz
+//             (MESH_ATTRIBUTE_NORMAL), then texcoord uv
+//             (MESH_ATTRIBUTE_TEXCOORD)
+//   indices   at indexOffset: indexCount unsigned shorts (indexSize 2) or
+//             unsigned ints (indexSize 4) forming a triangle list
+// Both sections start at a multiple of MESH_FILE_ALIGNMENT.
+#ifndef MESH_FORMAT_H
+#define MESH_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MESH_FILE_MAGIC 0x4853454du // "MESH"
+#define MESH_FILE_VERSION 1
+#define MESH_FILE_ALIGNMENT 16
+
+#define MESH_ATTRIBUTE_NORMAL 0x1u
+#define MESH_ATTRIBUTE_TEXCOORD 0x2u
+
+typedef struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t attributes;   // MESH_ATTRIBUTE_* besides the position
+    uint32_t vertexStride; // bytes
+    uint32_t vertexCount;
+    uint32_t indexSize;    // 2 or 4
+    uint32_t indexCount;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+} MeshFileHeader;
+
+// Bytes per vertex for a set of attributes.
+static inline uint32_t mesh_vertex_stride(uint32_t attributes)
+{
+    uint32_t floats = 3;
+    if (attributes & MESH_ATTRIBUTE_NORMAL)
+        floats += 3;
+    if (attributes & MESH_ATTRIBUTE_TEXCOORD)
+        floats += 2;
+    return floats * (uint32_t)sizeof(float);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MESH_FORMAT_H
@@ -0,0 +1,36 @@
+// obj.h
+// Wavefront OBJ reader for obj2mesh and mesh_bench. Reads v, vt, vn and f
+// records; polygons are split into triangle fans and every distinct
+// position/texcoord/normal combination becomes one vertex. Everything else
+// (groups, materials, smoothing) is ignored.
+#ifndef OBJ_H
+#define OBJ_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ObjMesh
+{
+    float *vertices;       // interleaved as in mesh_format.h
+    uint32_t attributes;   // MESH_ATTRIBUTE_*: the ones any face refers to
+    uint32_t vertexStride; // floats per vertex
+    uint32_t vertexCount;
+    uint32_t *indices;     // triangle list
+    uint32_t indexCount;
+} ObjMesh;
+
+// Parses NUL-terminated OBJ text. Returns 0 and prints the offending line
+// on malformed input.
+int obj_parse(const char *text, ObjMesh *mesh);
+// Reads and parses an OBJ file.
+int obj_load(const char *path, ObjMesh *mesh);
+void obj_free(ObjMesh *mesh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OBJ_H
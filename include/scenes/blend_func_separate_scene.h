@@ -0,0 +1,38 @@
+// blend_func_separate_scene.h
+// The scene of the glBlendFuncSeparate sample, also run by sample_host: two
+// overlapping triangles in a 4x4 grid of viewports. Each cell has its own
+// source colour factor; the source alpha and both destination factors step
+// through every combination, one per second of the sample clock.
+#ifndef BLEND_FUNC_SEPARATE_SCENE_H
+#define BLEND_FUNC_SEPARATE_SCENE_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BlendFuncSeparateScene
+{
+    GLuint program; // aPos at location 0
+    GLuint vertexBuffer;
+    int comboIndex;
+    GLenum sFactorAlpha;
+    GLenum dFactorRGB;
+    GLenum dFactorAlpha;
+} BlendFuncSeparateScene;
+
+// Returns 0 when the program does not build. Needs a current GL context.
+int blend_func_separate_scene_init(BlendFuncSeparateScene *scene);
+// Selects the combination shown at time seconds. Returns 1 when it
+// changed. The combination follows from the time alone, so a virtual clock
+// gives identical frames on every run.
+int blend_func_separate_scene_update(BlendFuncSeparateScene *scene, double time);
+void blend_func_separate_scene_draw(const BlendFuncSeparateScene *scene, int width, int height);
+void blend_func_separate_scene_destroy(BlendFuncSeparateScene *scene);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLEND_FUNC_SEPARATE_SCENE_H
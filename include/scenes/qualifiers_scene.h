@@ -0,0 +1,33 @@
+// qualifiers_scene.h
+// The scene of the qualifiers sample, also run by sample_host: one triangle
+// whose colour goes from a uniform through a varying to the fragment
+// shader.
+#ifndef QUALIFIERS_SCENE_H
+#define QUALIFIERS_SCENE_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct QualifiersScene
+{
+    GLuint program; // aPosition at location 0
+    GLuint vertexBuffer;
+    GLint colorLocation;
+    GLfloat color[3]; // green after qualifiers_scene_init
+} QualifiersScene;
+
+// Returns 0 when the program does not build. Needs a current GL context.
+int qualifiers_scene_init(QualifiersScene *scene);
+// Looks the uniform up again after scene->program was relinked.
+void qualifiers_scene_reloaded(QualifiersScene *scene);
+void qualifiers_scene_draw(const QualifiersScene *scene, int width, int height);
+void qualifiers_scene_destroy(QualifiersScene *scene);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QUALIFIERS_SCENE_H
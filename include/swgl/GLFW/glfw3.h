@@ -0,0 +1,68 @@
+// GLFW/glfw3.h (swgl)
+// Headless subset of the GLFW 3 API, implemented by the software renderer.
+// Only used when the samples are built with SAMPLES_SOFTWARE_RENDERER: windows
+// are offscreen swgl surfaces, and glfwWindowShouldClose() turns true after
+// SWGL_FRAMES frames (when set). SWGL_DUMP=<file.ppm> stores the last frame.
+#ifndef SWGL_GLFW3_H
+#define SWGL_GLFW3_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GLFW_VERSION_MAJOR 3
+#define GLFW_VERSION_MINOR 3
+#define GLFW_VERSION_REVISION 0
+
+#define GLFW_TRUE 1
+#define GLFW_FALSE 0
+
+#define GLFW_RESIZABLE 0x00020003
+#define GLFW_VISIBLE 0x00020004
+#define GLFW_SAMPLES 0x0002100D
+#define GLFW_DOUBLEBUFFER 0x00021010
+#define GLFW_CLIENT_API 0x00022001
+#define GLFW_CONTEXT_VERSION_MAJOR 0x00022002
+#define GLFW_CONTEXT_VERSION_MINOR 0x00022003
+#define GLFW_CONTEXT_CREATION_API 0x0002200B
+
+#define GLFW_NO_API 0
+#define GLFW_OPENGL_API 0x00030001
+#define GLFW_OPENGL_ES_API 0x00030002
+#define GLFW_NATIVE_CONTEXT_API 0x00036001
+#define GLFW_EGL_CONTEXT_API 0x00036002
+
+typedef struct GLFWwindow GLFWwindow;
+typedef struct GLFWmonitor GLFWmonitor;
+typedef void (*GLFWglproc)(void);
+typedef void (*GLFWerrorfun)(int error_code, const char *description);
+
+int glfwInit(void);
+void glfwTerminate(void);
+GLFWerrorfun glfwSetErrorCallback(GLFWerrorfun callback);
+
+void glfwDefaultWindowHints(void);
+void glfwWindowHint(int hint, int value);
+GLFWwindow *glfwCreateWindow(int width, int height, const char *title, GLFWmonitor *monitor, GLFWwindow *share);
+void glfwDestroyWindow(GLFWwindow *window);
+int glfwWindowShouldClose(GLFWwindow *window);
+void glfwSetWindowShouldClose(GLFWwindow *window, int value);
+void glfwSetWindowTitle(GLFWwindow *window, const char *title);
+void glfwGetWindowSize(GLFWwindow *window, int *width, int *height);
+void glfwGetFramebufferSize(GLFWwindow *window, int *width, int *height);
+
+void glfwMakeContextCurrent(GLFWwindow *window);
+GLFWwindow *glfwGetCurrentContext(void);
+void glfwSwapBuffers(GLFWwindow *window);
+void glfwSwapInterval(int interval);
+int glfwExtensionSupported(const char *extension);
+GLFWglproc glfwGetProcAddress(const char *procname);
+
+void glfwPollEvents(void);
+double glfwGetTime(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SWGL_GLFW3_H
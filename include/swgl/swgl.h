@@ -0,0 +1,36 @@
+// swgl.h
+// Control and statistics API of the built-in software renderer (swgl).
+// Samples linked against swgl keep using the regular GL ES 2.0 and GLFW
+// entry points; this header is only needed to tune or inspect the renderer.
+#ifndef SWGL_H
+#define SWGL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SwglStats
+{
+    unsigned long long frames;      // flushes issued by glfwSwapBuffers
+    unsigned long long flushes;     // all flushes, including glReadPixels/glFinish
+    unsigned long long primitives;  // triangles and points after clipping and culling
+    unsigned long long binnedRefs;  // primitive references written into tile bins
+    unsigned long long fragments;   // fragments that passed the coverage test
+    unsigned long long steals;      // tiles executed by a worker other than their owner
+} SwglStats;
+
+// Number of rasterizer threads, including the submitting thread.
+// 0 selects the number of online CPUs. SWGL_THREADS in the environment
+// overrides the default at startup.
+void swgl_set_thread_count(int count);
+int swgl_get_thread_count(void);
+
+// Statistics accumulated since the process started or the last reset.
+void swgl_get_stats(SwglStats *stats);
+void swgl_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SWGL_H
@@ -0,0 +1,115 @@
+// swgl_glsl.h
+// CPU execution engine for GLSL ES 1.00 shaders. Sources are preprocessed,
+// parsed and lowered to a scalar register IR, which is then interpreted for
+// SWGL_GLSL_LANES vertices or fragments at a time under an execution mask.
+// The software renderer runs its programs through this engine; tools can use
+// it directly to validate shaders or evaluate them without a GL driver.
+#ifndef SWGL_GLSL_H
+#define SWGL_GLSL_H
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SWGL_GLSL_LANES 8
+
+// Implementation limits, also reported through the gl_Max* built-ins
+#define SWGL_GLSL_MAX_VERTEX_ATTRIBS 16
+#define SWGL_GLSL_MAX_UNIFORM_VECTORS 256
+#define SWGL_GLSL_MAX_VARYING_VECTORS 8
+#define SWGL_GLSL_MAX_TEXTURE_IMAGE_UNITS 8
+
+typedef enum SwglGlslStage
+{
+    SWGL_GLSL_VERTEX,
+    SWGL_GLSL_FRAGMENT
+} SwglGlslStage;
+
+typedef enum SwglGlslVariableKind
+{
+    SWGL_GLSL_UNIFORM,
+    SWGL_GLSL_ATTRIBUTE,
+    SWGL_GLSL_VARYING
+} SwglGlslVariableKind;
+
+// Built-ins a shader reads, so callers can skip computing the others
+enum
+{
+    SWGL_GLSL_USES_FRAGCOORD = 1 << 0,
+    SWGL_GLSL_USES_POINTCOORD = 1 << 1,
+    SWGL_GLSL_USES_FRONTFACING = 1 << 2,
+    SWGL_GLSL_USES_DISCARD = 1 << 3,
+    SWGL_GLSL_WRITES_POINTSIZE = 1 << 4
+};
+
+typedef struct SwglGlslVariable
+{
+    char name[64];
+    GLenum type;    // GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+    int arraySize;  // 1 for non-arrays
+    int components; // floats per element (16 for mat4)
+    int offset;     // uniforms: first float in the uniform block;
+                    // attributes/varyings: first row in the input/output rows
+} SwglGlslVariable;
+
+typedef struct SwglGlslShader SwglGlslShader;
+typedef struct SwglGlslExec SwglGlslExec;
+
+// Compiles a shader. On failure NULL is returned and log receives the errors
+// in the usual "ERROR: 0:<line>: ..." format.
+SwglGlslShader *swgl_glsl_compile(SwglGlslStage stage, const char *source, char *log, size_t logSize);
+// Copies a compiled shader, e.g. to relocate its uniforms for one program.
+SwglGlslShader *swgl_glsl_clone(const SwglGlslShader *shader);
+void swgl_glsl_free(SwglGlslShader *shader);
+
+SwglGlslStage swgl_glsl_stage(const SwglGlslShader *shader);
+unsigned swgl_glsl_flags(const SwglGlslShader *shader);
+int swgl_glsl_instruction_count(const SwglGlslShader *shader);
+int swgl_glsl_register_count(const SwglGlslShader *shader);
+
+// Reflection. Variables are listed in declaration order. Uniforms, attributes
+// and fragment varyings are listed only when the shader references them;
+// vertex varyings are outputs and are always listed.
+int swgl_glsl_variable_count(const SwglGlslShader *shader, SwglGlslVariableKind kind);
+const SwglGlslVariable *swgl_glsl_variable(const SwglGlslShader *shader, SwglGlslVariableKind kind, int index);
+// Floats used by the default uniform layout (uniforms packed in declaration order).
+int swgl_glsl_uniform_floats(const SwglGlslShader *shader);
+// Moves a uniform to another offset, so two stages can share one block.
+void swgl_glsl_set_uniform_offset(SwglGlslShader *shader, int index, int offset);
+
+// Rows of SWGL_GLSL_LANES floats exchanged with a batch of invocations.
+//
+// Vertex inputs are the attribute components in declaration order (an
+// attribute's rows start at its offset). Vertex outputs are gl_Position (4
+// rows), gl_PointSize (1 row) and then the varyings in declaration order.
+// Fragment inputs are the fragment shader's varyings in declaration order;
+// its outputs are the 4 rows of gl_FragColor.
+typedef struct SwglGlslBatch
+{
+    unsigned mask;         // lanes to run
+    const float *uniforms; // uniform block
+    const float *const *inputs;
+    float *const *outputs;
+    const float *fragCoord[4];  // fragment stage, when SWGL_GLSL_USES_FRAGCOORD
+    const float *pointCoord[2]; // fragment stage, when SWGL_GLSL_USES_POINTCOORD
+    int frontFacing;
+} SwglGlslBatch;
+
+int swgl_glsl_input_rows(const SwglGlslShader *shader);
+int swgl_glsl_output_rows(const SwglGlslShader *shader);
+
+// An executor holds the register file; use one per thread.
+SwglGlslExec *swgl_glsl_exec_create(void);
+void swgl_glsl_exec_destroy(SwglGlslExec *exec);
+// Runs the shader for the lanes in batch->mask and returns the lanes that
+// were not discarded.
+unsigned swgl_glsl_run(SwglGlslExec *exec, const SwglGlslShader *shader, const SwglGlslBatch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SWGL_GLSL_H
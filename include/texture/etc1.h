@@ -0,0 +1,61 @@
+// etc1.h
+// ETC1 (GL_OES_compressed_ETC1_RGB8_texture) encoder and decoder. ETC1
+// stores each 4x4 block of RGB texels in 8 bytes: two base colours, one per
+// half of the block, and per texel a 2-bit index into a table of luminance
+// offsets added to its half's base colour. Alpha is not stored.
+//
+// The encoder tries both ways to split a block (2x4 and 4x2), both ways to
+// store the base colours (two 4-bit colours, or a 5-bit colour and a 3-bit
+// difference) and, for each half, every offset table with a set of base
+// colours around the half's average. The quality decides how many base
+// colours are tried. The error of the 8 texels of a half is evaluated with
+// SSE2 when it is available. Rows of blocks are encoded in parallel.
+#ifndef ETC1_H
+#define ETC1_H
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+#define ETC1_BLOCK_SIZE 8
+
+typedef enum Etc1Quality
+{
+    ETC1_QUALITY_FAST,   // the average colour of each half only
+    ETC1_QUALITY_MEDIUM, // and the average one step lighter and darker
+    ETC1_QUALITY_HIGH,   // and every colour one step away in each channel
+    ETC1_QUALITIES
+} Etc1Quality;
+
+// Bytes of ETC1 data for an image; partial blocks are padded to 4x4.
+size_t etc1_encoded_size(int width, int height);
+
+// Encodes RGBA8 texels whose rows are stride bytes apart into
+// etc1_encoded_size(width, height) bytes, ignoring alpha. Partial blocks
+// repeat the last row and column. threadCount 0: one thread per CPU.
+void etc1_encode(const unsigned char *texels, int width, int height, ptrdiff_t stride, unsigned char *out,
+                 Etc1Quality quality, int threadCount);
+// Decodes into width x height RGBA8 texels with opaque alpha.
+void etc1_decode(const unsigned char *data, int width, int height, unsigned char *texels);
+
+// Whether the current context takes ETC1 textures.
+int etc1_supported(void);
+// Specifies level of the bound GL_TEXTURE_2D from ETC1 data: compressed
+// when etc1_supported(), otherwise decoded to RGB565. Returns the internal
+// format used, 0 when out of memory.
+GLenum etc1_tex_image_2d(GLint level, int width, int height, const unsigned char *data);
+
+const char *etc1_quality_name(Etc1Quality quality);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ETC1_H
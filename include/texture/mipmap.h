@@ -0,0 +1,54 @@
+// mipmap.h
+// Mipmap chains built on the CPU, as an alternative to glGenerateMipmap
+// whose filter, speed and treatment of gamma depend on the driver.
+//
+// Each level is filtered from the one above it, with a 2x2 box or a
+// separable Kaiser-windowed sinc (width 3, alpha 4) that keeps more detail
+// and aliases less. With gammaCorrect the colour channels are taken as
+// sRGB and averaged in linear light, so fine dark and bright detail does
+// not fade into a dark grey; alpha is always averaged as it is. The levels
+// are kept as linear floats between passes and filtered 4 channels at a
+// time with SSE when it is available; the rows of a level are split
+// between threads.
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <GLES2/gl2.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIPMAP_MAX_LEVELS 16
+
+typedef enum MipmapFilter
+{
+    MIPMAP_BOX,
+    MIPMAP_KAISER,
+    MIPMAP_FILTERS
+} MipmapFilter;
+
+typedef struct MipmapChain
+{
+    int levelCount;
+    int widths[MIPMAP_MAX_LEVELS];
+    int heights[MIPMAP_MAX_LEVELS];
+    unsigned char *levels[MIPMAP_MAX_LEVELS]; // RGBA8; level 0 is a copy of the image
+} MipmapChain;
+
+// Builds every level down to 1x1 from tightly packed RGBA8 texels.
+// threadCount 0: one thread per CPU. Returns 0 when out of memory.
+int mipmap_build(const unsigned char *texels, int width, int height, MipmapFilter filter, int gammaCorrect,
+                 int threadCount, MipmapChain *chain);
+void mipmap_free(MipmapChain *chain);
+
+// Specifies every level of the bound GL_TEXTURE_2D with glTexImage2D.
+void mipmap_upload(const MipmapChain *chain);
+
+const char *mipmap_filter_name(MipmapFilter filter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MIPMAP_H
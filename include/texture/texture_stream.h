@@ -0,0 +1,84 @@
+// texture_stream.h
+// Texture streaming: images are decoded by a pool of worker threads into
+// staging memory and uploaded by the GL thread a bounded number of bytes
+// per frame, so loading textures never stalls a frame for long.
+//
+// Workers read PPM (P6) and QOI images, from files or memory, and convert
+// them to the requested format while decoding. Staging memory is pooled in
+// power-of-two blocks and capped; workers wait for blocks to be returned
+// when the cap is reached, so decoding cannot run ahead of the uploads.
+// texture_stream_update() creates each texture and fills it with
+// glTexSubImage2D in bands of rows until the frame's byte budget is spent;
+// at least one row is uploaded per call.
+//
+// Images are uploaded top row first, so the top of the image is at t = 0.
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum TextureStreamFormat
+{
+    TEXTURE_STREAM_RGBA8,    // GL_RGBA, GL_UNSIGNED_BYTE
+    TEXTURE_STREAM_RGB565,   // GL_RGB, GL_UNSIGNED_SHORT_5_6_5
+    TEXTURE_STREAM_RGBA4444, // GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4
+    TEXTURE_STREAM_FORMATS
+} TextureStreamFormat;
+
+typedef struct TextureStream TextureStream;
+
+// Called on the GL thread once a texture is complete, with texture 0 when
+// the image could not be read. The texture belongs to the caller.
+typedef void (*TextureStreamCallback)(GLuint texture, int width, int height, void *userData);
+
+typedef struct TextureStreamStats
+{
+    unsigned long long completed;    // textures handed to their callback
+    unsigned long long failed;       // images that could not be read
+    unsigned long long decodedBytes; // staging bytes produced by the workers
+    double decodeMs;                 // worker time spent decoding, all threads
+    unsigned long long uploadedBytes;
+    double uploadMs;                 // GL thread time in texture_stream_update
+    double maxUpdateMs;              // longest texture_stream_update
+    unsigned long long updates;      // texture_stream_update calls that uploaded
+    size_t stagingPeak;              // most staging bytes in use at once
+    unsigned long long stagingWaits; // decodes that waited for staging memory
+} TextureStreamStats;
+
+// Creates the worker threads (threadCount 0: one per CPU). stagingBytes caps
+// the staging memory, frameBudget the bytes uploaded per update.
+TextureStream *texture_stream_create(int threadCount, size_t stagingBytes, size_t frameBudget);
+// Stops the workers and drops the requests not completed yet. Needs the GL
+// context for textures that were partially uploaded.
+void texture_stream_destroy(TextureStream *stream);
+
+// Queues an image file. Returns 0 when out of memory.
+int texture_stream_load_file(TextureStream *stream, const char *path, TextureStreamFormat format,
+                             TextureStreamCallback completed, void *userData);
+// Queues an encoded image in memory, which must stay valid until the
+// callback.
+int texture_stream_load_memory(TextureStream *stream, const void *data, size_t size, TextureStreamFormat format,
+                               TextureStreamCallback completed, void *userData);
+
+// Uploads up to the frame budget and calls the callbacks of the textures
+// completed. Call once per frame on the GL thread.
+void texture_stream_update(TextureStream *stream);
+// Requests queued, decoding or uploading.
+int texture_stream_pending(TextureStream *stream);
+
+void texture_stream_get_stats(TextureStream *stream, TextureStreamStats *stats);
+
+// Bytes per texel of a format.
+int texture_stream_texel_size(TextureStreamFormat format);
+const char *texture_stream_format_name(TextureStreamFormat format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEXTURE_STREAM_H
@@ -0,0 +1,5 @@
+precision mediump float;
+void main()
+{
+    gl_FragColor = vec4(0.2, 0.4, 0.6, 0.5);
+}
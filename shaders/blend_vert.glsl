@@ -0,0 +1,5 @@
+attribute vec4 aPos;
+void main()
+{
+    gl_Position = aPos;
+}
@@ -0,0 +1,20 @@
+#version 100
+// Quads placed and coloured by several uniforms (uniform_block_bench), set
+// one call each, or packed into one array when common/uniform_block.h
+// defines UNIFORM_BLOCK_VECTORS
+attribute vec2 aPosition;
+#ifdef UNIFORM_BLOCK_VECTORS
+uniform vec4 uUniformBlock[UNIFORM_BLOCK_VECTORS];
+#else
+uniform mat4 uTransform;
+uniform mat3 uColorMatrix;
+uniform vec4 uColor;
+uniform vec2 uOffset;
+uniform float uScale;
+uniform float uBrightness;
+#endif
+varying vec4 vColor;
+void main() {
+    vColor = vec4(uColorMatrix * uColor.rgb * uBrightness, uColor.a);
+    gl_Position = uTransform * vec4(aPosition * uScale + uOffset, 0.0, 1.0);
+}
@@ -0,0 +1,9 @@
+#version 100
+// 2D positions with a colour per vertex
+attribute vec2 aPosition;
+attribute vec4 aColor;
+varying vec4 vColor;
+void main() {
+    vColor = aColor;
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+}
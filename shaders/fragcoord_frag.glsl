@@ -0,0 +1,5 @@
+#version 100
+precision mediump float;
+void main() {
+    gl_FragColor = vec4(gl_FragCoord.xy / 800.0, 0.0, 1.0);
+}
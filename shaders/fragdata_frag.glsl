@@ -0,0 +1,6 @@
+#version 100
+precision mediump float;
+void main() {
+    //gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); // Only gl_FragColor is available in ES 2.0
+    gl_FragData[0] = vec4(1.0, 0.0, 0.0, 1.0); // Not available in ES 2.0
+}
@@ -0,0 +1,13 @@
+#version 100
+precision mediump float;
+void main() {
+#ifdef GL_OES_standard_derivatives
+    if (gl_FrontFacing) {
+        gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0); // Green for front faces
+    } else {
+        gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); // Red for back faces
+    }
+#else
+    gl_FragColor = vec4(0.5, 0.5, 0.5, 1.0); // Fallback for ES 2.0
+#endif
+}
@@ -0,0 +1,44 @@
+#version 100
+// FXAA: finds the direction of the edge through each pixel from the luma of
+// its corners and blends along it, with 2 taps or, when they stay within
+// the local luma range, 4. Pixels without enough local contrast are left
+// as they are.
+precision mediump float;
+varying vec2 vTexcoord;
+uniform sampler2D uTexture;
+uniform vec2 uTexel;
+const float reduceMin = 1.0 / 128.0;
+const float reduceMul = 1.0 / 8.0;
+const float spanMax = 8.0;
+const float edgeThreshold = 1.0 / 8.0;
+const float edgeThresholdMin = 1.0 / 32.0;
+void main() {
+    vec3 luma = vec3(0.299, 0.587, 0.114);
+    vec4 colorM = texture2D(uTexture, vTexcoord);
+    float lumaNW = dot(texture2D(uTexture, vTexcoord + vec2(-1.0, -1.0) * uTexel).rgb, luma);
+    float lumaNE = dot(texture2D(uTexture, vTexcoord + vec2(1.0, -1.0) * uTexel).rgb, luma);
+    float lumaSW = dot(texture2D(uTexture, vTexcoord + vec2(-1.0, 1.0) * uTexel).rgb, luma);
+    float lumaSE = dot(texture2D(uTexture, vTexcoord + vec2(1.0, 1.0) * uTexel).rgb, luma);
+    float lumaM = dot(colorM.rgb, luma);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+    if (lumaMax - lumaMin < max(edgeThresholdMin, lumaMax * edgeThreshold)) {
+        gl_FragColor = colorM;
+        return;
+    }
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * reduceMul), reduceMin);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-spanMax), vec2(spanMax)) * uTexel;
+
+    vec3 colorA = 0.5 * (texture2D(uTexture, vTexcoord + dir * (1.0 / 3.0 - 0.5)).rgb +
+                         texture2D(uTexture, vTexcoord + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 colorB = colorA * 0.5 + 0.25 * (texture2D(uTexture, vTexcoord - dir * 0.5).rgb +
+                                         texture2D(uTexture, vTexcoord + dir * 0.5).rgb);
+    float lumaB = dot(colorB, luma);
+    if (lumaB < lumaMin || lumaB > lumaMax)
+        gl_FragColor = vec4(colorA, colorM.a);
+    else
+        gl_FragColor = vec4(colorB, colorM.a);
+}
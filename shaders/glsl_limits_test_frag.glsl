@@ -0,0 +1,41 @@
+#version 100
+
+precision mediump int;
+precision mediump float;
+
+uniform int u_index;
+
+void main() {
+    int value = 0;
+    int minValue = 0;
+    if (u_index == 0) {
+        value = gl_MaxVertexAttribs;
+        minValue = 8;
+    } else if (u_index == 1) {
+        value = gl_MaxVertexUniformVectors;
+        minValue = 128;
+    } else if (u_index == 2) {
+        value = gl_MaxVaryingVectors;
+        minValue = 8;
+    } else if (u_index == 3) {
+        value = gl_MaxVertexTextureImageUnits;
+        minValue = 0;
+    } else if (u_index == 4) {
+        value = gl_MaxCombinedTextureImageUnits;
+        minValue = 8;
+    } else if (u_index == 5) {
+        value = gl_MaxTextureImageUnits;
+        minValue = 8;
+    } else if (u_index == 6) {
+        value = gl_MaxFragmentUniformVectors;
+        minValue = 16;
+    } else if (u_index == 7) {
+        value = gl_MaxDrawBuffers;
+        minValue = 1;
+    }
+    if (value >= minValue) {
+        gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0); // green
+    } else {
+        gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); // red
+    }
+}
@@ -0,0 +1,6 @@
+#version 100
+
+attribute vec4 a_position;
+void main() {
+    gl_Position = a_position;
+}
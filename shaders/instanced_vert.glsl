@@ -0,0 +1,30 @@
+#version 100
+// Repeated geometry placed per instance (common/instancing.h). Each
+// instance is two vectors: the scale (xy) and offset (zw) of its positions,
+// then its colour (rgb) and point size (w). With hardware instancing they
+// are aInstance0 and aInstance1, which advance once per instance. With
+// pseudo-instancing (INSTANCING_BATCH defined) the geometry is repeated
+// INSTANCING_BATCH times and aInstanceIndex picks each copy's vectors out
+// of uInstances.
+attribute vec3 aPosition;
+#ifdef INSTANCING_BATCH
+attribute float aInstanceIndex;
+uniform vec4 uInstances[INSTANCING_VECTORS];
+#else
+attribute vec4 aInstance0;
+attribute vec4 aInstance1;
+#endif
+varying vec4 vColor;
+void main() {
+#ifdef INSTANCING_BATCH
+    int first = int(aInstanceIndex) * 2;
+    vec4 placement = uInstances[first];
+    vec4 style = uInstances[first + 1];
+#else
+    vec4 placement = aInstance0;
+    vec4 style = aInstance1;
+#endif
+    vColor = vec4(style.rgb, 1.0);
+    gl_Position = vec4(aPosition.xy * placement.xy + placement.zw, aPosition.z, 1.0);
+    gl_PointSize = style.w;
+}
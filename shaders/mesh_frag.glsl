@@ -0,0 +1,9 @@
+#version 100
+precision mediump float;
+varying vec3 vNormal;
+// direction towards the light, in world space
+const vec3 lightDirection = vec3(0.3, 0.6, 0.74);
+void main() {
+    float diffuse = max(dot(normalize(vNormal), lightDirection), 0.0);
+    gl_FragColor = vec4(vec3(0.9, 0.6, 0.2) * (0.2 + 0.8 * diffuse), 1.0);
+}
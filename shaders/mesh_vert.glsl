@@ -0,0 +1,16 @@
+#version 100
+attribute vec3 aPosition;
+attribute vec3 aNormal;
+// model-view-projection and the model's rotation, column-major; packed into
+// one array when common/uniform_block.h defines UNIFORM_BLOCK_VECTORS
+#ifdef UNIFORM_BLOCK_VECTORS
+uniform vec4 uUniformBlock[UNIFORM_BLOCK_VECTORS];
+#else
+uniform mat4 uModelViewProjection;
+uniform mat4 uModel;
+#endif
+varying vec3 vNormal;
+void main() {
+    vNormal = (uModel * vec4(aNormal, 0.0)).xyz;
+    gl_Position = uModelViewProjection * vec4(aPosition, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 100
+// Resolves weighted blended transparency: the weighted average colour,
+// covering 1 - revealage of the background it is blended over
+precision mediump float;
+varying vec2 vTexcoord;
+uniform sampler2D uAccumulation;
+uniform sampler2D uWeight;
+void main() {
+    vec4 accumulation = texture2D(uAccumulation, vTexcoord);
+    float weight = texture2D(uWeight, vTexcoord).r;
+    gl_FragColor = vec4(accumulation.rgb / max(weight, 0.00001), 1.0 - accumulation.a);
+}
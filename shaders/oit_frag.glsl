@@ -0,0 +1,29 @@
+#version 100
+// Weighted blended order-independent transparency (common/weighted_oit.h).
+// Each fragment adds its premultiplied colour times a weight that falls off
+// with depth, and its alpha times the weight, so the composite can divide
+// them out; its alpha also multiplies the revealage, the share of the
+// background that shows through. With GL_EXT_draw_buffers (OIT_DRAW_BUFFERS)
+// both targets are written at once: colour and alpha to the first, weight
+// to the second. Without it the geometry is drawn twice and uPass selects
+// the target.
+#ifdef OIT_DRAW_BUFFERS
+#extension GL_EXT_draw_buffers : require
+#endif
+precision mediump float;
+varying vec4 vColor;
+uniform float uPass;
+void main() {
+    float a = vColor.a;
+    // Nearer fragments weigh up to 100 times more; bounded so that hundreds
+    // of layers stay within half float
+    float w = a * clamp(100.0 * pow(1.0 - gl_FragCoord.z, 3.0), 0.01, 100.0);
+    vec4 accumulation = vec4(vColor.rgb * w, a);
+    vec4 weight = vec4(w, 0.0, 0.0, 0.0);
+#ifdef OIT_DRAW_BUFFERS
+    gl_FragData[0] = accumulation;
+    gl_FragData[1] = weight;
+#else
+    gl_FragColor = uPass < 0.5 ? accumulation : weight;
+#endif
+}
@@ -0,0 +1,10 @@
+#version 100
+// Translucent triangles with a colour per vertex, straight alpha
+attribute vec3 aPosition;
+attribute vec4 aColor;
+uniform mat4 uTransform;
+varying vec4 vColor;
+void main() {
+    vColor = aColor;
+    gl_Position = uTransform * vec4(aPosition, 1.0);
+}
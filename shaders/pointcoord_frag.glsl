@@ -0,0 +1,6 @@
+#version 100
+// Demonstrates gl_PointCoord usage (OpenGL ES 2.0)
+precision mediump float;
+void main() {
+    gl_FragColor = vec4(gl_PointCoord, 0.0, 1.0);
+}
@@ -0,0 +1,7 @@
+#version 100
+attribute vec3 aPosition;
+uniform float uPointSize;
+void main() {
+    gl_Position = vec4(aPosition, 1.0);
+    gl_PointSize = uPointSize;
+}
@@ -0,0 +1,47 @@
+#version 100
+// Composites a layer (uSource) onto the destination image (uDestination),
+// like the blend unit would, for the modes of common/programmable_blend.h.
+// BLEND_MODE selects the mode and is defined when the program is built;
+// BLEND_MODE 8 copies the destination, for the pixels the layer left alone.
+// The core equations use GL_SRC_ALPHA and GL_ONE_MINUS_SRC_ALPHA on all
+// four channels, min and max ignore the factors as GL_EXT_blend_minmax
+// does, and the separable modes mix the result into the destination by the
+// source alpha.
+#ifndef BLEND_MODE
+#define BLEND_MODE 0
+#endif
+precision mediump float;
+varying vec2 vTexcoord;
+uniform sampler2D uSource;
+uniform sampler2D uDestination;
+void main() {
+    vec4 d = texture2D(uDestination, vTexcoord);
+#if BLEND_MODE == 8
+    gl_FragColor = d;
+#else
+    vec4 s = texture2D(uSource, vTexcoord);
+#if BLEND_MODE == 0
+    gl_FragColor = s * s.a + d * (1.0 - s.a);
+#elif BLEND_MODE == 1
+    gl_FragColor = clamp(s * s.a - d * (1.0 - s.a), 0.0, 1.0);
+#elif BLEND_MODE == 2
+    gl_FragColor = clamp(d * (1.0 - s.a) - s * s.a, 0.0, 1.0);
+#elif BLEND_MODE == 3
+    gl_FragColor = min(s, d);
+#elif BLEND_MODE == 4
+    gl_FragColor = max(s, d);
+#else
+#if BLEND_MODE == 5
+    vec3 b = s.rgb * d.rgb;
+#elif BLEND_MODE == 6
+    vec3 b = s.rgb + d.rgb - s.rgb * d.rgb;
+#else
+    // Overlay: multiply where the destination is dark, screen where light
+    vec3 low = 2.0 * s.rgb * d.rgb;
+    vec3 high = 1.0 - 2.0 * (1.0 - s.rgb) * (1.0 - d.rgb);
+    vec3 b = mix(low, high, step(0.5, d.rgb));
+#endif
+    gl_FragColor = vec4(mix(d.rgb, b, s.a), s.a + d.a * (1.0 - s.a));
+#endif
+#endif
+}
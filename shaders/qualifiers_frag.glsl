@@ -0,0 +1,6 @@
+#version 100
+precision mediump float;
+varying vec3 varyVar;
+void main() {
+    gl_FragColor = vec4(varyVar, 1.0); // Use the varying variable
+}
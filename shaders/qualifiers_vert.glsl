@@ -0,0 +1,15 @@
+#version 100
+// attribute: per-vertex input
+attribute vec3 aPosition;
+// uniform: constant for all vertices
+uniform vec3 vColor;
+// varying: passed to fragment shader
+varying vec3 varyVar;
+// None (local variable)
+float localVar = 0.2;
+// const (compile-time constant)
+const float constVar = 0.3;
+void main() {
+    varyVar = vColor;
+    gl_Position = vec4(aPosition.x - localVar - constVar, aPosition.y - localVar - constVar, 0.0, 1.0);
+}
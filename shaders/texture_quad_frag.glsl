@@ -0,0 +1,7 @@
+#version 100
+precision mediump float;
+varying vec2 vTexcoord;
+uniform sampler2D uTexture;
+void main() {
+    gl_FragColor = texture2D(uTexture, vTexcoord);
+}
@@ -0,0 +1,8 @@
+#version 100
+// A quad covering the viewport, with texture coordinates from 0 to 1
+attribute vec2 aPosition;
+varying vec2 vTexcoord;
+void main() {
+    vTexcoord = aPosition * 0.5 + 0.5;
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 100
+// Bilinear upscale; uMax keeps the filter from reaching the texels outside
+// the rendered part
+precision mediump float;
+varying vec2 vTexcoord;
+uniform sampler2D uTexture;
+uniform vec2 uMax;
+void main() {
+    gl_FragColor = texture2D(uTexture, min(vTexcoord, uMax));
+}
@@ -0,0 +1,10 @@
+#version 100
+// A quad covering the viewport; uScale maps it onto the rendered part of
+// the offscreen texture
+attribute vec2 aPosition;
+uniform vec2 uScale;
+varying vec2 vTexcoord;
+void main() {
+    vTexcoord = (aPosition * 0.5 + 0.5) * uScale;
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+}
@@ -0,0 +1,435 @@
+// frame_capture.c
+// Double-buffered offscreen capture with a background writer. See
+// frame_capture.h for the frame pipeline.
+#include "capture/frame_capture.h"
+#include "capture/frame_recorder.h"
+#include "common/gl_pass.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <GLES2/gl2.h>
+#include <shaders.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Frames that can wait for the writer; further frames are dropped rather
+// than stalling the render loop.
+#define FRAME_CAPTURE_QUEUE 4
+
+typedef struct FrameCaptureSlot
+{
+    unsigned char *pixels; // RGBA8, bottom row first
+    unsigned long long frame;
+} FrameCaptureSlot;
+
+struct FrameCapture
+{
+    int width;
+    int height;
+    char prefix[256];
+
+    // Offscreen targets, rendered alternately
+    int offscreen;
+    GLuint framebuffers[2];
+    GLuint textures[2];
+    GLuint depthBuffers[2];
+    int current;
+    int pending; // the other framebuffer holds a frame not read back yet
+    GLuint blitProgram;
+    GLuint blitBuffer;
+
+    // Single-producer/single-consumer queue: the render thread advances
+    // head, the writer thread advances tail
+    FrameCaptureSlot slots[FRAME_CAPTURE_QUEUE];
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_int quit;
+    sem_t ready;
+    pthread_t writer;
+    int writerStarted;
+    atomic_ullong written;
+    unsigned char *rows; // writer's RGB conversion buffer
+    FrameRecorder *recorder; // replaces the PPM files when recording
+
+    unsigned long long frame;
+    unsigned long long frames;
+    unsigned long long dropped;
+    double beginSeconds; // spent in this frame's frame_capture_begin
+    double lastEndTime;
+    double captureSeconds;
+    double maxCaptureSeconds;
+    double waitSeconds;
+    double frameSeconds;
+    unsigned long long frameIntervals;
+};
+
+static double frame_capture_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ---------------------------------------------------------------------------
+// Writer thread
+
+static void frame_capture_store(FrameCapture *capture, const FrameCaptureSlot *slot)
+{
+    if (capture->recorder)
+    {
+        // The recorder copies the frame top row first and encodes it on its own threads
+        ptrdiff_t stride = (ptrdiff_t)capture->width * 4;
+        if (frame_recorder_submit(capture->recorder, slot->pixels + stride * (capture->height - 1), -stride,
+                                  slot->frame))
+            atomic_fetch_add_explicit(&capture->written, 1, memory_order_relaxed);
+        return;
+    }
+
+    // PPM rows go top to bottom without alpha
+    size_t rowBytes = (size_t)capture->width * 3;
+    for (int y = 0; y < capture->height; ++y)
+    {
+        const unsigned char *src = slot->pixels + (size_t)(capture->height - 1 - y) * capture->width * 4;
+        unsigned char *dst = capture->rows + (size_t)y * rowBytes;
+        for (int x = 0; x < capture->width; ++x)
+        {
+            dst[x * 3 + 0] = src[x * 4 + 0];
+            dst[x * 3 + 1] = src[x * 4 + 1];
+            dst[x * 3 + 2] = src[x * 4 + 2];
+        }
+    }
+
+    char path[300];
+    snprintf(path, sizeof(path), "%s_%05llu.ppm", capture->prefix, slot->frame);
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("ERROR: cannot write %s\n", path);
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", capture->width, capture->height);
+    fwrite(capture->rows, rowBytes, (size_t)capture->height, file);
+    fclose(file);
+    atomic_fetch_add_explicit(&capture->written, 1, memory_order_relaxed);
+}
+
+static void *frame_capture_writer(void *userData)
+{
+    FrameCapture *capture = (FrameCapture *)userData;
+    PROFILE_THREAD_NAME("capture writer");
+    for (;;)
+    {
+        sem_wait(&capture->ready);
+        unsigned tail = atomic_load_explicit(&capture->tail, memory_order_relaxed);
+        unsigned head = atomic_load_explicit(&capture->head, memory_order_acquire);
+        while (tail != head)
+        {
+            PROFILE_CALL(frame_capture_store(capture, &capture->slots[tail % FRAME_CAPTURE_QUEUE]));
+            atomic_store_explicit(&capture->tail, ++tail, memory_order_release);
+        }
+        if (atomic_load_explicit(&capture->quit, memory_order_acquire) &&
+            tail == atomic_load_explicit(&capture->head, memory_order_acquire))
+            return NULL;
+    }
+}
+
+// Reads the bound framebuffer into the next free slot. Never waits for the
+// writer: when the queue is full the frame is counted as dropped.
+static void frame_capture_read(FrameCapture *capture, unsigned long long frame)
+{
+    unsigned head = atomic_load_explicit(&capture->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&capture->tail, memory_order_acquire);
+    if (head - tail >= FRAME_CAPTURE_QUEUE)
+    {
+        capture->dropped++;
+        return;
+    }
+    FrameCaptureSlot *slot = &capture->slots[head % FRAME_CAPTURE_QUEUE];
+    GLint alignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, capture->width, capture->height, GL_RGBA, GL_UNSIGNED_BYTE, slot->pixels);
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    slot->frame = frame;
+    atomic_store_explicit(&capture->head, head + 1, memory_order_release);
+    sem_post(&capture->ready);
+    capture->frames++;
+}
+
+// ---------------------------------------------------------------------------
+// Offscreen targets
+
+static int frame_capture_create_blit(FrameCapture *capture)
+{
+    capture->blitProgram =
+        shader_program_create(shader_texture_quad_vert.source, shader_texture_quad_frag.source, "aPosition");
+    if (!capture->blitProgram)
+        return 0;
+    GLint program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glUseProgram(capture->blitProgram);
+    glUniform1i(glGetUniformLocation(capture->blitProgram, "uTexture"), 0);
+    glUseProgram((GLuint)program);
+    capture->blitBuffer = gl_pass_create_triangle();
+    return 1;
+}
+
+static int frame_capture_create_targets(FrameCapture *capture)
+{
+    GLint texture, renderbuffer;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+    glGenFramebuffers(2, capture->framebuffers);
+    glGenTextures(2, capture->textures);
+    glGenRenderbuffers(2, capture->depthBuffers);
+    int complete = 1;
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, capture->textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, capture->width, capture->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindRenderbuffer(GL_RENDERBUFFER, capture->depthBuffers[i]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, capture->width, capture->height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, capture->framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, capture->textures[i], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, capture->depthBuffers[i]);
+        complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)texture);
+    glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)renderbuffer);
+    return complete && frame_capture_create_blit(capture);
+}
+
+static void frame_capture_delete_targets(FrameCapture *capture)
+{
+    glDeleteFramebuffers(2, capture->framebuffers);
+    glDeleteTextures(2, capture->textures);
+    glDeleteRenderbuffers(2, capture->depthBuffers);
+    if (capture->blitProgram)
+        glDeleteProgram(capture->blitProgram);
+    if (capture->blitBuffer)
+        glDeleteBuffers(1, &capture->blitBuffer);
+    memset(capture->framebuffers, 0, sizeof(capture->framebuffers));
+    memset(capture->textures, 0, sizeof(capture->textures));
+    memset(capture->depthBuffers, 0, sizeof(capture->depthBuffers));
+    capture->blitProgram = 0;
+    capture->blitBuffer = 0;
+}
+
+// Shows the offscreen frame in the window.
+static void frame_capture_blit(FrameCapture *capture)
+{
+    GlPassState state;
+    gl_pass_save_state(&state);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl_pass_set_state(capture->width, capture->height);
+    glUseProgram(capture->blitProgram);
+    glBindTexture(GL_TEXTURE_2D, capture->textures[capture->current]);
+    gl_pass_draw(capture->blitBuffer);
+    gl_pass_restore_state(&state);
+}
+
+// ---------------------------------------------------------------------------
+// API
+
+static FrameCapture *frame_capture_create_with(int width, int height, const char *prefix, const char *recordPath)
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+    FrameCapture *capture = (FrameCapture *)calloc(1, sizeof(FrameCapture));
+    if (!capture)
+        return NULL;
+    capture->width = width;
+    capture->height = height;
+    snprintf(capture->prefix, sizeof(capture->prefix), "%s", prefix);
+    atomic_init(&capture->head, 0);
+    atomic_init(&capture->tail, 0);
+    atomic_init(&capture->quit, 0);
+    atomic_init(&capture->written, 0);
+
+    size_t pixelBytes = (size_t)width * height * 4;
+    int ok;
+    if (recordPath)
+        ok = (capture->recorder = frame_recorder_create(recordPath, width, height, 0)) != NULL;
+    else
+        ok = (capture->rows = (unsigned char *)malloc((size_t)width * height * 3)) != NULL;
+    for (int i = 0; ok && i < FRAME_CAPTURE_QUEUE; ++i)
+        ok = (capture->slots[i].pixels = (unsigned char *)malloc(pixelBytes)) != NULL;
+    if (ok && sem_init(&capture->ready, 0, 0) == 0)
+    {
+        capture->writerStarted = pthread_create(&capture->writer, NULL, frame_capture_writer, capture) == 0;
+        if (!capture->writerStarted)
+            sem_destroy(&capture->ready);
+    }
+    if (!capture->writerStarted)
+    {
+        printf("ERROR: frame capture: cannot start the writer thread\n");
+        frame_capture_destroy(capture);
+        return NULL;
+    }
+
+    capture->offscreen = frame_capture_create_targets(capture);
+    if (!capture->offscreen)
+    {
+        frame_capture_delete_targets(capture);
+        printf("INFO: frame capture: offscreen framebuffers unavailable, reading the window back every frame\n");
+    }
+    if (recordPath)
+        printf("INFO: frame capture: %dx%d recorded to %s\n", width, height, recordPath);
+    else
+        printf("INFO: frame capture: %dx%d to %s_*.ppm\n", width, height, capture->prefix);
+    return capture;
+}
+
+FrameCapture *frame_capture_create(int width, int height, const char *prefix)
+{
+    return prefix ? frame_capture_create_with(width, height, prefix, NULL) : NULL;
+}
+
+FrameCapture *frame_capture_create_recording(int width, int height, const char *path)
+{
+    return path ? frame_capture_create_with(width, height, "", path) : NULL;
+}
+
+FrameCapture *frame_capture_create_from_env(int width, int height)
+{
+    const char *path = getenv("SAMPLES_RECORD");
+    if (path && *path)
+        return frame_capture_create_recording(width, height, path);
+    const char *prefix = getenv("SAMPLES_CAPTURE");
+    return prefix && *prefix ? frame_capture_create(width, height, prefix) : NULL;
+}
+
+void frame_capture_begin(FrameCapture *capture)
+{
+    if (!capture)
+        return;
+    capture->beginSeconds = 0.0;
+    if (!capture->offscreen)
+        return;
+    double start = frame_capture_seconds();
+    // The previous frame was submitted before the last swap; reading it back
+    // now does not wait for any of this frame's commands
+    if (capture->pending)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, capture->framebuffers[capture->current ^ 1]);
+        PROFILE_CALL(frame_capture_read(capture, capture->frame - 1));
+        capture->pending = 0;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, capture->framebuffers[capture->current]);
+    capture->beginSeconds = frame_capture_seconds() - start;
+    capture->captureSeconds += capture->beginSeconds;
+}
+
+void frame_capture_end(FrameCapture *capture)
+{
+    if (!capture)
+        return;
+    double start = frame_capture_seconds();
+    if (capture->offscreen)
+    {
+        PROFILE_CALL(frame_capture_blit(capture));
+        capture->current ^= 1;
+        capture->pending = 1;
+    }
+    else
+    {
+        // Finishing the frame first keeps the rendering it flushes out of
+        // the readback time; it is reported separately as waiting
+        PROFILE_CALL(glFinish());
+        double finished = frame_capture_seconds();
+        capture->waitSeconds += finished - start;
+        start = finished;
+        PROFILE_CALL(frame_capture_read(capture, capture->frame));
+    }
+    capture->frame++;
+
+    double end = frame_capture_seconds();
+    capture->captureSeconds += end - start;
+    double frameCapture = capture->beginSeconds + (end - start);
+    if (frameCapture > capture->maxCaptureSeconds)
+        capture->maxCaptureSeconds = frameCapture;
+    if (capture->lastEndTime > 0.0)
+    {
+        capture->frameSeconds += end - capture->lastEndTime;
+        capture->frameIntervals++;
+    }
+    capture->lastEndTime = end;
+}
+
+void frame_capture_get_stats(const FrameCapture *capture, FrameCaptureStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!capture)
+        return;
+    stats->frames = capture->frames;
+    stats->written = atomic_load_explicit(&capture->written, memory_order_relaxed);
+    stats->dropped = capture->dropped;
+    stats->captureMs = capture->frame ? capture->captureSeconds * 1000.0 / (double)capture->frame : 0.0;
+    stats->waitMs = capture->frame ? capture->waitSeconds * 1000.0 / (double)capture->frame : 0.0;
+    stats->maxCaptureMs = capture->maxCaptureSeconds * 1000.0;
+    stats->frameMs = capture->frameIntervals ? capture->frameSeconds * 1000.0 / (double)capture->frameIntervals : 0.0;
+    stats->offscreen = capture->offscreen;
+}
+
+void frame_capture_destroy(FrameCapture *capture)
+{
+    if (!capture)
+        return;
+    if (capture->writerStarted)
+    {
+        // The last frame is still waiting in its framebuffer
+        if (capture->pending)
+        {
+            GLint framebuffer;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, capture->framebuffers[capture->current ^ 1]);
+            frame_capture_read(capture, capture->frame - 1);
+            glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+        }
+        atomic_store_explicit(&capture->quit, 1, memory_order_release);
+        sem_post(&capture->ready);
+        pthread_join(capture->writer, NULL);
+        sem_destroy(&capture->ready);
+        if (capture->recorder)
+        {
+            FrameRecorderStats recorderStats;
+            frame_recorder_close(capture->recorder, &recorderStats);
+            capture->recorder = NULL;
+            double raw = (double)recorderStats.frames * capture->width * capture->height * 3;
+            printf("INFO: frame recorder: %llu frames, %.1f MB (%.1f%% of raw RGB), encoding %.3f ms/frame, "
+                   "waited %.3f ms/frame for a free encoder\n",
+                   recorderStats.frames, (double)recorderStats.bytes / (1024.0 * 1024.0),
+                   raw > 0.0 ? (double)recorderStats.bytes * 100.0 / raw : 0.0, recorderStats.encodeMs,
+                   recorderStats.submitWaitMs);
+        }
+
+        FrameCaptureStats stats;
+        frame_capture_get_stats(capture, &stats);
+        printf("INFO: frame capture: %llu frames written, %llu dropped, %s readback\n", stats.written,
+               stats.dropped, stats.offscreen ? "double-buffered" : "synchronous");
+        printf("INFO: frame capture: overhead %.3f ms/frame (max %.3f ms, %.1f%% of a 60 fps frame), "
+               "%.3f ms/frame waiting for rendering, frame time %.3f ms\n",
+               stats.captureMs, stats.maxCaptureMs, stats.captureMs * 100.0 / (1000.0 / 60.0), stats.waitMs,
+               stats.frameMs);
+    }
+    if (capture->offscreen)
+        frame_capture_delete_targets(capture);
+    for (int i = 0; i < FRAME_CAPTURE_QUEUE; ++i)
+        free(capture->slots[i].pixels);
+    frame_recorder_close(capture->recorder, NULL);
+    free(capture->rows);
+    free(capture);
+}
@@ -0,0 +1,428 @@
+// frame_recorder.c
+// Encoder jobs live in a ring indexed by their sequence number, so the
+// frames finish out of order but are committed to the file in order: the
+// worker that completes the oldest outstanding job appends it and any
+// finished successors. The file is grown in large steps and written through
+// a shared mapping.
+#include "capture/frame_recorder.h"
+#include "capture/qoi.h"
+#include "common/profiler.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FRAME_RECORDER_GROWTH ((size_t)64 << 20)
+
+enum
+{
+    FRAME_JOB_FREE,
+    FRAME_JOB_QUEUED,
+    FRAME_JOB_ENCODING,
+    FRAME_JOB_DONE
+};
+
+typedef struct FrameRecorderJob
+{
+    int state;
+    unsigned long long seq;
+    unsigned long long frame;
+    unsigned char *pixels; // RGBA8, top row first
+    unsigned char *encoded;
+    size_t size;
+} FrameRecorderJob;
+
+struct FrameRecorder
+{
+    int width;
+    int height;
+    int fd;
+    unsigned char *map;
+    size_t mapSize;
+    size_t fileSize; // bytes written so far
+    uint64_t *index;
+    size_t indexCapacity;
+    uint64_t frameCount;
+    uint64_t dataBytes;
+
+    FrameRecorderJob *jobs;
+    int jobCount;
+    pthread_t *threads;
+    int threadCount;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;   // a job was queued or the recorder is closing
+    pthread_cond_t released; // a job became free
+    unsigned long long submitSeq;
+    unsigned long long encodeSeq;
+    unsigned long long commitSeq;
+    int committing;
+    int closing;
+    int failed;
+
+    double encodeSeconds;
+    double submitWaitSeconds;
+};
+
+static double frame_recorder_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ---------------------------------------------------------------------------
+// Output file
+
+static int frame_recorder_reserve(FrameRecorder *recorder, size_t bytes)
+{
+    if (recorder->fileSize + bytes <= recorder->mapSize)
+        return 1;
+    size_t size = recorder->mapSize + FRAME_RECORDER_GROWTH;
+    while (size < recorder->fileSize + bytes)
+        size += FRAME_RECORDER_GROWTH;
+    if (recorder->map)
+        munmap(recorder->map, recorder->mapSize);
+    recorder->map = NULL;
+    if (ftruncate(recorder->fd, (off_t)size) != 0)
+        return 0;
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, recorder->fd, 0);
+    if (map == MAP_FAILED)
+        return 0;
+    recorder->map = (unsigned char *)map;
+    recorder->mapSize = size;
+    return 1;
+}
+
+static int frame_recorder_append(FrameRecorder *recorder, const FrameRecorderJob *job)
+{
+    size_t padded = (job->size + 7) & ~(size_t)7;
+    if (!frame_recorder_reserve(recorder, sizeof(FrameRecordChunk) + padded))
+        return 0;
+    if (recorder->frameCount == recorder->indexCapacity)
+    {
+        size_t capacity = recorder->indexCapacity ? recorder->indexCapacity * 2 : 1024;
+        uint64_t *index = (uint64_t *)realloc(recorder->index, capacity * sizeof(uint64_t));
+        if (!index)
+            return 0;
+        recorder->index = index;
+        recorder->indexCapacity = capacity;
+    }
+    FrameRecordChunk chunk = {FRAME_RECORD_CHUNK_MAGIC, (uint32_t)job->size, job->frame};
+    unsigned char *dst = recorder->map + recorder->fileSize;
+    memcpy(dst, &chunk, sizeof(chunk));
+    memcpy(dst + sizeof(chunk), job->encoded, job->size);
+    memset(dst + sizeof(chunk) + job->size, 0, padded - job->size);
+    recorder->index[recorder->frameCount++] = recorder->fileSize;
+    recorder->fileSize += sizeof(chunk) + padded;
+    recorder->dataBytes += job->size;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Encoder threads
+
+static void *frame_recorder_worker(void *userData)
+{
+    FrameRecorder *recorder = (FrameRecorder *)userData;
+    PROFILE_THREAD_NAME("recorder encoder");
+    pthread_mutex_lock(&recorder->lock);
+    for (;;)
+    {
+        while (recorder->encodeSeq == recorder->submitSeq && !recorder->closing)
+            pthread_cond_wait(&recorder->queued, &recorder->lock);
+        if (recorder->encodeSeq == recorder->submitSeq)
+            break;
+        FrameRecorderJob *job = &recorder->jobs[recorder->encodeSeq++ % (unsigned)recorder->jobCount];
+        job->state = FRAME_JOB_ENCODING;
+        pthread_mutex_unlock(&recorder->lock);
+
+        double start = frame_recorder_seconds();
+        PROFILE_BEGIN("qoi_encode");
+        job->size = qoi_encode(job->pixels, recorder->width, recorder->height, (ptrdiff_t)recorder->width * 4, 3,
+                               job->encoded);
+        PROFILE_END();
+        double seconds = frame_recorder_seconds() - start;
+
+        pthread_mutex_lock(&recorder->lock);
+        recorder->encodeSeconds += seconds;
+        job->state = FRAME_JOB_DONE;
+        // Whoever finishes the oldest job commits the finished prefix
+        while (!recorder->committing)
+        {
+            FrameRecorderJob *next = &recorder->jobs[recorder->commitSeq % (unsigned)recorder->jobCount];
+            if (next->state != FRAME_JOB_DONE || next->seq != recorder->commitSeq)
+                break;
+            recorder->committing = 1;
+            pthread_mutex_unlock(&recorder->lock);
+            int ok = recorder->failed ? 0 : frame_recorder_append(recorder, next);
+            pthread_mutex_lock(&recorder->lock);
+            if (!ok && !recorder->failed)
+            {
+                recorder->failed = 1;
+                printf("ERROR: frame recorder: cannot grow the output file\n");
+            }
+            next->state = FRAME_JOB_FREE;
+            recorder->commitSeq++;
+            recorder->committing = 0;
+            pthread_cond_broadcast(&recorder->released);
+        }
+    }
+    pthread_mutex_unlock(&recorder->lock);
+    return NULL;
+}
+
+static int frame_recorder_default_threads(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+static void frame_recorder_free(FrameRecorder *recorder)
+{
+    for (int i = 0; recorder->jobs && i < recorder->jobCount; ++i)
+    {
+        free(recorder->jobs[i].pixels);
+        free(recorder->jobs[i].encoded);
+    }
+    free(recorder->jobs);
+    free(recorder->threads);
+    free(recorder->index);
+    if (recorder->map)
+        munmap(recorder->map, recorder->mapSize);
+    if (recorder->fd >= 0)
+        close(recorder->fd);
+    free(recorder);
+}
+
+FrameRecorder *frame_recorder_create(const char *path, int width, int height, int threadCount)
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+    FrameRecorder *recorder = (FrameRecorder *)calloc(1, sizeof(FrameRecorder));
+    if (!recorder)
+        return NULL;
+    recorder->width = width;
+    recorder->height = height;
+    recorder->threadCount = threadCount > 0 ? threadCount : frame_recorder_default_threads();
+    // Two jobs per encoder keep every worker busy while frames are copied in
+    recorder->jobCount = recorder->threadCount * 2;
+    recorder->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (recorder->fd < 0)
+    {
+        printf("ERROR: frame recorder: cannot create %s\n", path);
+        frame_recorder_free(recorder);
+        return NULL;
+    }
+
+    recorder->jobs = (FrameRecorderJob *)calloc((size_t)recorder->jobCount, sizeof(FrameRecorderJob));
+    recorder->threads = (pthread_t *)calloc((size_t)recorder->threadCount, sizeof(pthread_t));
+    int ok = recorder->jobs && recorder->threads;
+    for (int i = 0; ok && i < recorder->jobCount; ++i)
+    {
+        recorder->jobs[i].pixels = (unsigned char *)malloc((size_t)width * height * 4);
+        recorder->jobs[i].encoded = (unsigned char *)malloc(qoi_max_size(width, height));
+        ok = recorder->jobs[i].pixels && recorder->jobs[i].encoded;
+    }
+    FrameRecordHeader header = {FRAME_RECORD_MAGIC, FRAME_RECORD_VERSION, (uint32_t)width, (uint32_t)height, 0, 0};
+    ok = ok && frame_recorder_reserve(recorder, sizeof(header));
+    if (!ok)
+    {
+        printf("ERROR: frame recorder: out of memory\n");
+        frame_recorder_free(recorder);
+        return NULL;
+    }
+    memcpy(recorder->map, &header, sizeof(header));
+    recorder->fileSize = sizeof(header);
+
+    pthread_mutex_init(&recorder->lock, NULL);
+    pthread_cond_init(&recorder->queued, NULL);
+    pthread_cond_init(&recorder->released, NULL);
+    int started = 0;
+    while (started < recorder->threadCount &&
+           pthread_create(&recorder->threads[started], NULL, frame_recorder_worker, recorder) == 0)
+        ++started;
+    recorder->threadCount = started;
+    if (!started)
+    {
+        printf("ERROR: frame recorder: cannot start the encoder threads\n");
+        pthread_mutex_destroy(&recorder->lock);
+        pthread_cond_destroy(&recorder->queued);
+        pthread_cond_destroy(&recorder->released);
+        frame_recorder_free(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+int frame_recorder_submit(FrameRecorder *recorder, const unsigned char *pixels, ptrdiff_t stride,
+                          unsigned long long frame)
+{
+    double start = frame_recorder_seconds();
+    pthread_mutex_lock(&recorder->lock);
+    FrameRecorderJob *job = &recorder->jobs[recorder->submitSeq % (unsigned)recorder->jobCount];
+    while (job->state != FRAME_JOB_FREE)
+        pthread_cond_wait(&recorder->released, &recorder->lock);
+    int failed = recorder->failed;
+    pthread_mutex_unlock(&recorder->lock);
+    recorder->submitWaitSeconds += frame_recorder_seconds() - start;
+    if (failed)
+        return 0;
+
+    // The job is free and only this thread queues jobs, so it can be filled
+    // without the lock
+    size_t rowBytes = (size_t)recorder->width * 4;
+    for (int y = 0; y < recorder->height; ++y)
+        memcpy(job->pixels + rowBytes * y, pixels + stride * y, rowBytes);
+    job->frame = frame;
+
+    pthread_mutex_lock(&recorder->lock);
+    job->seq = recorder->submitSeq++;
+    job->state = FRAME_JOB_QUEUED;
+    pthread_cond_signal(&recorder->queued);
+    pthread_mutex_unlock(&recorder->lock);
+    return 1;
+}
+
+void frame_recorder_close(FrameRecorder *recorder, FrameRecorderStats *stats)
+{
+    if (!recorder)
+        return;
+    pthread_mutex_lock(&recorder->lock);
+    recorder->closing = 1;
+    pthread_cond_broadcast(&recorder->queued);
+    pthread_mutex_unlock(&recorder->lock);
+    for (int i = 0; i < recorder->threadCount; ++i)
+        pthread_join(recorder->threads[i], NULL);
+
+    // Index last, then the header that points to it
+    size_t indexBytes = (size_t)recorder->frameCount * sizeof(uint64_t);
+    if (!recorder->failed && frame_recorder_reserve(recorder, indexBytes))
+    {
+        uint64_t indexOffset = recorder->fileSize;
+        if (indexBytes)
+            memcpy(recorder->map + recorder->fileSize, recorder->index, indexBytes);
+        recorder->fileSize += indexBytes;
+        FrameRecordHeader header = {FRAME_RECORD_MAGIC, FRAME_RECORD_VERSION, (uint32_t)recorder->width,
+                                    (uint32_t)recorder->height, recorder->frameCount, indexOffset};
+        memcpy(recorder->map, &header, sizeof(header));
+    }
+    munmap(recorder->map, recorder->mapSize);
+    recorder->map = NULL;
+    if (ftruncate(recorder->fd, (off_t)recorder->fileSize) != 0)
+        printf("ERROR: frame recorder: cannot truncate the output file\n");
+
+    if (stats)
+    {
+        stats->frames = recorder->frameCount;
+        stats->bytes = recorder->dataBytes;
+        stats->encodeMs = recorder->frameCount ? recorder->encodeSeconds * 1000.0 / (double)recorder->frameCount : 0.0;
+        stats->submitWaitMs =
+            recorder->submitSeq ? recorder->submitWaitSeconds * 1000.0 / (double)recorder->submitSeq : 0.0;
+    }
+    pthread_mutex_destroy(&recorder->lock);
+    pthread_cond_destroy(&recorder->queued);
+    pthread_cond_destroy(&recorder->released);
+    frame_recorder_free(recorder);
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+
+static int frame_recording_chunk_valid(const FrameRecording *recording, uint64_t offset)
+{
+    if (offset < sizeof(FrameRecordHeader) || offset > recording->size - sizeof(FrameRecordChunk))
+        return 0;
+    FrameRecordChunk chunk;
+    memcpy(&chunk, recording->data + offset, sizeof(chunk));
+    return chunk.magic == FRAME_RECORD_CHUNK_MAGIC && chunk.size <= recording->size - offset - sizeof(chunk);
+}
+
+// Walks the chunks of a recording that was not closed.
+static int frame_recording_rebuild_index(FrameRecording *recording)
+{
+    size_t capacity = 0;
+    uint64_t count = 0;
+    uint64_t offset = sizeof(FrameRecordHeader);
+    while (frame_recording_chunk_valid(recording, offset))
+    {
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            uint64_t *index = (uint64_t *)realloc(recording->rebuiltIndex, capacity * sizeof(uint64_t));
+            if (!index)
+                return 0;
+            recording->rebuiltIndex = index;
+        }
+        recording->rebuiltIndex[count++] = offset;
+        FrameRecordChunk chunk;
+        memcpy(&chunk, recording->data + offset, sizeof(chunk));
+        offset += sizeof(chunk) + ((chunk.size + 7u) & ~7u);
+    }
+    recording->index = recording->rebuiltIndex;
+    recording->header.frameCount = count;
+    return 1;
+}
+
+int frame_recording_open(FrameRecording *recording, const char *path)
+{
+    memset(recording, 0, sizeof(*recording));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FrameRecordHeader))
+    {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return 0;
+    recording->data = (const unsigned char *)map;
+    recording->size = (size_t)st.st_size;
+    memcpy(&recording->header, recording->data, sizeof(recording->header));
+    if (recording->header.magic != FRAME_RECORD_MAGIC || recording->header.version != FRAME_RECORD_VERSION)
+    {
+        frame_recording_close(recording);
+        return 0;
+    }
+
+    const FrameRecordHeader *header = &recording->header;
+    if (header->indexOffset && header->indexOffset % 8 == 0 && header->indexOffset <= recording->size &&
+        header->frameCount <= (recording->size - header->indexOffset) / sizeof(uint64_t))
+        recording->index = (const uint64_t *)(recording->data + header->indexOffset);
+    else if (!frame_recording_rebuild_index(recording))
+    {
+        frame_recording_close(recording);
+        return 0;
+    }
+    return 1;
+}
+
+void frame_recording_close(FrameRecording *recording)
+{
+    if (recording->data)
+        munmap((void *)recording->data, recording->size);
+    free(recording->rebuiltIndex);
+    memset(recording, 0, sizeof(*recording));
+}
+
+const unsigned char *frame_recording_frame(const FrameRecording *recording, uint64_t i, size_t *size,
+                                           unsigned long long *frame)
+{
+    if (i >= recording->header.frameCount || !frame_recording_chunk_valid(recording, recording->index[i]))
+        return NULL;
+    FrameRecordChunk chunk;
+    memcpy(&chunk, recording->data + recording->index[i], sizeof(chunk));
+    *size = chunk.size;
+    if (frame)
+        *frame = chunk.frame;
+    return recording->data + recording->index[i] + sizeof(chunk);
+}
@@ -0,0 +1,273 @@
+// qoi.c
+// QOI encoder and decoder. The format is a single sequential stream, so the
+// encoder works in blocks of 64 pixels: a vectorized pass marks the pixels
+// equal to their predecessor and computes every pixel's index hash, then
+// the scalar pass skips whole runs with one bit scan and only does the
+// byte-level diff work for the pixels that start a new colour.
+#include "capture/qoi.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+
+#define QOI_BLOCK 64
+#define QOI_OPAQUE 0xff000000u
+
+// Pixels are handled as little-endian words: r | g << 8 | b << 16 | a << 24
+static uint32_t qoi_load(const unsigned char *p)
+{
+    uint32_t px;
+    memcpy(&px, p, sizeof(px));
+    return px;
+}
+
+static unsigned qoi_hash(uint32_t px)
+{
+    unsigned r = px & 0xff, g = (px >> 8) & 0xff, b = (px >> 16) & 0xff, a = px >> 24;
+    return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+}
+
+static void qoi_write32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static uint32_t qoi_read32(const unsigned char *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+size_t qoi_max_size(int width, int height)
+{
+    return (size_t)width * height * 5 + QOI_HEADER_SIZE + QOI_PADDING_SIZE;
+}
+
+// Loads up to QOI_BLOCK pixels of a row, marks in *same the pixels equal to
+// the one before them (prev for the first) and computes their hashes.
+static void qoi_analyze(const unsigned char *row, int count, uint32_t alpha, uint32_t prev,
+                        uint32_t *px, unsigned char *hash, uint64_t *same)
+{
+    uint64_t mask = 0;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i alphaBits = _mm_set1_epi32((int)alpha);
+    const __m128i weights = _mm_setr_epi16(3, 5, 7, 11, 3, 5, 7, 11);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i last = _mm_set1_epi32((int)prev);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_or_si128(_mm_loadu_si128((const __m128i *)(row + (size_t)i * 4)), alphaBits);
+        _mm_storeu_si128((__m128i *)(px + i), v);
+        // Predecessors: the last pixel of the previous group, then v shifted by one pixel
+        __m128i before = _mm_or_si128(_mm_slli_si128(v, 4), _mm_srli_si128(last, 12));
+        unsigned eq = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, before)));
+        mask |= (uint64_t)eq << i;
+        last = v;
+
+        // r*3 + g*5 and b*7 + a*11 per pixel, then the two halves summed
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights);
+        __m128i sumLo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+        __m128i sumHi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+        hash[i + 0] = (unsigned char)(_mm_cvtsi128_si32(sumLo) & 63);
+        hash[i + 1] = (unsigned char)(_mm_cvtsi128_si32(_mm_srli_si128(sumLo, 8)) & 63);
+        hash[i + 2] = (unsigned char)(_mm_cvtsi128_si32(sumHi) & 63);
+        hash[i + 3] = (unsigned char)(_mm_cvtsi128_si32(_mm_srli_si128(sumHi, 8)) & 63);
+    }
+    if (i > 0)
+        prev = px[i - 1];
+#endif
+    for (; i < count; ++i)
+    {
+        px[i] = qoi_load(row + (size_t)i * 4) | alpha;
+        mask |= (uint64_t)(px[i] == prev) << i;
+        hash[i] = (unsigned char)qoi_hash(px[i]);
+        prev = px[i];
+    }
+    *same = mask;
+}
+
+static unsigned char *qoi_emit_run(unsigned char *out, int run)
+{
+    for (; run >= 62; run -= 62)
+        *out++ = (unsigned char)(QOI_OP_RUN | 61);
+    if (run > 0)
+        *out++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+    return out;
+}
+
+size_t qoi_encode(const unsigned char *pixels, int width, int height, ptrdiff_t stride, int channels,
+                  unsigned char *out)
+{
+    unsigned char *start = out;
+    memcpy(out, "qoif", 4);
+    qoi_write32(out + 4, (uint32_t)width);
+    qoi_write32(out + 8, (uint32_t)height);
+    out[12] = (unsigned char)channels;
+    out[13] = 0; // sRGB with linear alpha
+    out += QOI_HEADER_SIZE;
+
+    uint32_t index[64];
+    memset(index, 0, sizeof(index));
+    uint32_t prev = QOI_OPAQUE;
+    uint32_t alpha = channels == 3 ? QOI_OPAQUE : 0;
+    int run = 0;
+    uint32_t px[QOI_BLOCK];
+    unsigned char hash[QOI_BLOCK];
+
+    // Runs continue across rows, as the stream does not know about rows
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char *row = pixels + stride * y;
+        for (int x = 0; x < width; x += QOI_BLOCK)
+        {
+            int count = width - x < QOI_BLOCK ? width - x : QOI_BLOCK;
+            uint64_t same;
+            qoi_analyze(row + (size_t)x * 4, count, alpha, prev, px, hash, &same);
+            for (int i = 0; i < count;)
+            {
+                if ((same >> i) & 1u)
+                {
+                    // Length of the run of set bits starting at i
+                    uint64_t rest = ~(same >> i);
+                    int length = rest ? __builtin_ctzll(rest) : 64 - i;
+                    if (length > count - i)
+                        length = count - i;
+                    run += length;
+                    i += length;
+                    continue;
+                }
+                out = qoi_emit_run(out, run);
+                run = 0;
+
+                uint32_t p = px[i];
+                unsigned h = hash[i];
+                if (index[h] == p)
+                    *out++ = (unsigned char)(QOI_OP_INDEX | h);
+                else
+                {
+                    index[h] = p;
+                    if ((p ^ prev) >> 24 == 0)
+                    {
+                        signed char dr = (signed char)((p & 0xff) - (prev & 0xff));
+                        signed char dg = (signed char)(((p >> 8) & 0xff) - ((prev >> 8) & 0xff));
+                        signed char db = (signed char)(((p >> 16) & 0xff) - ((prev >> 16) & 0xff));
+                        signed char drdg = (signed char)(dr - dg);
+                        signed char dbdg = (signed char)(db - dg);
+                        if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+                            *out++ = (unsigned char)(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                        else if (drdg > -9 && drdg < 8 && dg > -33 && dg < 32 && dbdg > -9 && dbdg < 8)
+                        {
+                            *out++ = (unsigned char)(QOI_OP_LUMA | (dg + 32));
+                            *out++ = (unsigned char)((drdg + 8) << 4 | (dbdg + 8));
+                        }
+                        else
+                        {
+                            *out++ = QOI_OP_RGB;
+                            *out++ = (unsigned char)p;
+                            *out++ = (unsigned char)(p >> 8);
+                            *out++ = (unsigned char)(p >> 16);
+                        }
+                    }
+                    else
+                    {
+                        *out++ = QOI_OP_RGBA;
+                        memcpy(out, &p, 4);
+                        out += 4;
+                    }
+                }
+                prev = p;
+                ++i;
+            }
+        }
+    }
+    out = qoi_emit_run(out, run);
+    static const unsigned char padding[QOI_PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+    memcpy(out, padding, sizeof(padding));
+    out += sizeof(padding);
+    return (size_t)(out - start);
+}
+
+int qoi_read_header(const unsigned char *data, size_t size, int *width, int *height, int *channels)
+{
+    if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE || memcmp(data, "qoif", 4) != 0)
+        return 0;
+    uint32_t w = qoi_read32(data + 4), h = qoi_read32(data + 8);
+    if (w == 0 || h == 0 || w > 65536 || h > 65536 || (data[12] != 3 && data[12] != 4))
+        return 0;
+    *width = (int)w;
+    *height = (int)h;
+    *channels = data[12];
+    return 1;
+}
+
+int qoi_decode(const unsigned char *data, size_t size, unsigned char *pixels)
+{
+    int width, height, channels;
+    if (!qoi_read_header(data, size, &width, &height, &channels))
+        return 0;
+    unsigned char index[64][4];
+    memset(index, 0, sizeof(index));
+    unsigned char px[4] = {0, 0, 0, 255};
+    size_t p = QOI_HEADER_SIZE, end = size - QOI_PADDING_SIZE;
+    size_t count = (size_t)width * height;
+    int run = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (run > 0)
+            --run;
+        else if (p < end)
+        {
+            unsigned char b1 = data[p++];
+            if (b1 == QOI_OP_RGB && p + 3 <= end)
+            {
+                memcpy(px, data + p, 3);
+                p += 3;
+            }
+            else if (b1 == QOI_OP_RGBA && p + 4 <= end)
+            {
+                memcpy(px, data + p, 4);
+                p += 4;
+            }
+            else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+                memcpy(px, index[b1], 4);
+            else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+            {
+                px[0] = (unsigned char)(px[0] + ((b1 >> 4) & 3) - 2);
+                px[1] = (unsigned char)(px[1] + ((b1 >> 2) & 3) - 2);
+                px[2] = (unsigned char)(px[2] + (b1 & 3) - 2);
+            }
+            else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA && p < end)
+            {
+                unsigned char b2 = data[p++];
+                int dg = (b1 & 0x3f) - 32;
+                px[0] = (unsigned char)(px[0] + dg - 8 + ((b2 >> 4) & 0x0f));
+                px[1] = (unsigned char)(px[1] + dg);
+                px[2] = (unsigned char)(px[2] + dg - 8 + (b2 & 0x0f));
+            }
+            else if ((b1 & QOI_MASK_2) == QOI_OP_RUN)
+                run = b1 & 0x3f;
+            else
+                return 0;
+            memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63], px, 4);
+        }
+        else
+            return 0;
+        memcpy(pixels + i * 4, px, 4);
+    }
+    return 1;
+}
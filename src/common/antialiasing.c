@@ -0,0 +1,200 @@
+// antialiasing.c
+// SAMPLES_AA handling and the FXAA pass. See antialiasing.h.
+#include "common/antialiasing.h"
+#include "common/gl_pass.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANTIALIASING_DEFAULT_SAMPLES 4
+
+struct Antialiasing
+{
+    int width;
+    int height;
+    GLuint framebuffer;
+    GLuint texture;
+    GLuint depthBuffer;
+    GLuint program;
+    GLuint buffer;
+    GLint outerFramebuffer; // bound at antialiasing_begin
+};
+
+static const char *antialiasingModeNames[ANTIALIASING_MODES] = {"none", "fxaa", "msaa"};
+
+const char *antialiasing_mode_name(AntialiasingMode mode)
+{
+    return antialiasingModeNames[mode];
+}
+
+void antialiasing_hint(AntialiasingMode mode, int samples)
+{
+    glfwWindowHint(GLFW_SAMPLES, mode == ANTIALIASING_MSAA ? samples : 0);
+}
+
+AntialiasingMode antialiasing_hint_from_env(int *samples)
+{
+    const char *value = getenv("SAMPLES_AA");
+    AntialiasingMode mode = ANTIALIASING_NONE;
+    *samples = 0;
+    if (value && strcmp(value, "fxaa") == 0)
+        mode = ANTIALIASING_FXAA;
+    else if (value && strncmp(value, "msaa", 4) == 0 && (value[4] == '\0' || value[4] == ':'))
+    {
+        mode = ANTIALIASING_MSAA;
+        *samples = value[4] == ':' ? atoi(value + 5) : ANTIALIASING_DEFAULT_SAMPLES;
+        if (*samples < 2)
+            *samples = ANTIALIASING_DEFAULT_SAMPLES;
+    }
+    else if (value && *value && strcmp(value, "none") != 0)
+        printf("ERROR: SAMPLES_AA must be none, fxaa or msaa[:<samples>], not %s\n", value);
+    antialiasing_hint(mode, *samples);
+    return mode;
+}
+
+// ---------------------------------------------------------------------------
+// FXAA pass
+
+static int antialiasing_create_pass(Antialiasing *antialiasing)
+{
+    antialiasing->program =
+        shader_program_create(shader_texture_quad_vert.source, shader_fxaa_frag.source, "aPosition");
+    if (!antialiasing->program)
+        return 0;
+    GLint program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glUseProgram(antialiasing->program);
+    glUniform1i(glGetUniformLocation(antialiasing->program, "uTexture"), 0);
+    glUniform2f(glGetUniformLocation(antialiasing->program, "uTexel"), 1.0f / (GLfloat)antialiasing->width,
+                1.0f / (GLfloat)antialiasing->height);
+    glUseProgram((GLuint)program);
+    antialiasing->buffer = gl_pass_create_triangle();
+    return 1;
+}
+
+static int antialiasing_create_target(Antialiasing *antialiasing)
+{
+    GLint texture, renderbuffer, framebuffer;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGenFramebuffers(1, &antialiasing->framebuffer);
+    glGenTextures(1, &antialiasing->texture);
+    glGenRenderbuffers(1, &antialiasing->depthBuffer);
+    glBindTexture(GL_TEXTURE_2D, antialiasing->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, antialiasing->width, antialiasing->height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 NULL);
+    // FXAA reads between texels along the edge direction
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindRenderbuffer(GL_RENDERBUFFER, antialiasing->depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, antialiasing->width, antialiasing->height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, antialiasing->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, antialiasing->texture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, antialiasing->depthBuffer);
+    int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)texture);
+    glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)renderbuffer);
+    return complete && antialiasing_create_pass(antialiasing);
+}
+
+static void antialiasing_delete_target(Antialiasing *antialiasing)
+{
+    if (antialiasing->framebuffer)
+        glDeleteFramebuffers(1, &antialiasing->framebuffer);
+    if (antialiasing->texture)
+        glDeleteTextures(1, &antialiasing->texture);
+    if (antialiasing->depthBuffer)
+        glDeleteRenderbuffers(1, &antialiasing->depthBuffer);
+    if (antialiasing->program)
+        glDeleteProgram(antialiasing->program);
+    if (antialiasing->buffer)
+        glDeleteBuffers(1, &antialiasing->buffer);
+}
+
+static void antialiasing_pass(Antialiasing *antialiasing)
+{
+    GlPassState state;
+    gl_pass_save_state(&state);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)antialiasing->outerFramebuffer);
+    gl_pass_set_state(antialiasing->width, antialiasing->height);
+    glUseProgram(antialiasing->program);
+    glBindTexture(GL_TEXTURE_2D, antialiasing->texture);
+    gl_pass_draw(antialiasing->buffer);
+    gl_pass_restore_state(&state);
+}
+
+// ---------------------------------------------------------------------------
+// API
+
+Antialiasing *antialiasing_create(AntialiasingMode mode, int width, int height)
+{
+    if (mode == ANTIALIASING_MSAA)
+    {
+        GLint samples = 0;
+        glGetIntegerv(GL_SAMPLES, &samples);
+        if (samples > 1)
+            printf("INFO: antialiasing: msaa, %d samples\n", samples);
+        else
+            printf("INFO: antialiasing: multisampling unavailable, edges stay aliased\n");
+        return NULL;
+    }
+    if (mode != ANTIALIASING_FXAA || width <= 0 || height <= 0)
+        return NULL;
+    Antialiasing *antialiasing = (Antialiasing *)calloc(1, sizeof(Antialiasing));
+    if (!antialiasing)
+        return NULL;
+    antialiasing->width = width;
+    antialiasing->height = height;
+    if (!antialiasing_create_target(antialiasing))
+    {
+        antialiasing_delete_target(antialiasing);
+        free(antialiasing);
+        printf("INFO: antialiasing: offscreen framebuffers unavailable, edges stay aliased\n");
+        return NULL;
+    }
+    printf("INFO: antialiasing: fxaa, %dx%d offscreen target\n", width, height);
+    return antialiasing;
+}
+
+void antialiasing_destroy(Antialiasing *antialiasing)
+{
+    if (!antialiasing)
+        return;
+    antialiasing_delete_target(antialiasing);
+    free(antialiasing);
+}
+
+void antialiasing_begin(Antialiasing *antialiasing)
+{
+    if (!antialiasing)
+        return;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &antialiasing->outerFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, antialiasing->framebuffer);
+}
+
+void antialiasing_end(Antialiasing *antialiasing)
+{
+    if (!antialiasing)
+        return;
+    PROFILE_CALL(antialiasing_pass(antialiasing));
+}
+
+unsigned long long antialiasing_extra_bytes(const Antialiasing *antialiasing)
+{
+    if (!antialiasing)
+        return 0;
+    // RGBA8 colour and 16-bit depth
+    return (unsigned long long)antialiasing->width * (unsigned long long)antialiasing->height * 6ull;
+}
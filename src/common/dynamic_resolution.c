@@ -0,0 +1,298 @@
+// dynamic_resolution.c
+// Scaled offscreen rendering with a frame-time controller. See
+// dynamic_resolution.h for the controller.
+#include "common/dynamic_resolution.h"
+#include "common/gl_pass.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <GLES2/gl2.h>
+#include <shaders.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DYNAMIC_RESOLUTION_KP 0.25
+#define DYNAMIC_RESOLUTION_KI 0.15
+// Errors within log(1.05) count as on target
+#define DYNAMIC_RESOLUTION_DEADBAND 0.04879
+// Weight of the newest frame in the smoothed frame time
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.25
+#define DYNAMIC_RESOLUTION_LOG_SECONDS 1.0
+
+struct DynamicResolution
+{
+    int width;
+    int height;
+    double targetMs;
+    double minScale;
+
+    GLuint framebuffer;
+    GLuint texture;
+    GLuint depthBuffer;
+    GLuint program;
+    GLuint buffer;
+    GLint scaleLocation;
+    GLint maxLocation;
+    GLint outerFramebuffer; // bound at dynamic_resolution_begin
+
+    // Controller, on the log of the pixel fraction
+    double integral;
+    double smoothedMs;
+    double scale; // per axis
+    int renderWidth;
+    int renderHeight;
+
+    double beginTime;
+    double lastLogTime;
+    unsigned long long frames;
+    unsigned long long overBudget;
+    double frameMs;
+    double scaleSum;
+    double frameMsSum;
+    unsigned long long logFrames;
+    double logScaleSum;
+    double logFrameMsSum;
+};
+
+static double dynamic_resolution_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ---------------------------------------------------------------------------
+// GL resources
+
+static int dynamic_resolution_create_upscale(DynamicResolution *resolution)
+{
+    resolution->program =
+        shader_program_create(shader_upscale_vert.source, shader_upscale_frag.source, "aPosition");
+    if (!resolution->program)
+        return 0;
+    GLint program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glUseProgram(resolution->program);
+    glUniform1i(glGetUniformLocation(resolution->program, "uTexture"), 0);
+    resolution->scaleLocation = glGetUniformLocation(resolution->program, "uScale");
+    resolution->maxLocation = glGetUniformLocation(resolution->program, "uMax");
+    glUseProgram((GLuint)program);
+    resolution->buffer = gl_pass_create_triangle();
+    return 1;
+}
+
+// The texture has the size of the window; smaller frames use its lower
+// left corner, so changing the scale never reallocates it.
+static int dynamic_resolution_create_target(DynamicResolution *resolution)
+{
+    GLint texture, renderbuffer, framebuffer;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGenFramebuffers(1, &resolution->framebuffer);
+    glGenTextures(1, &resolution->texture);
+    glGenRenderbuffers(1, &resolution->depthBuffer);
+    glBindTexture(GL_TEXTURE_2D, resolution->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, resolution->width, resolution->height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolution->depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, resolution->width, resolution->height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolution->texture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, resolution->depthBuffer);
+    int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)texture);
+    glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)renderbuffer);
+    return complete && dynamic_resolution_create_upscale(resolution);
+}
+
+static void dynamic_resolution_delete_target(DynamicResolution *resolution)
+{
+    if (resolution->framebuffer)
+        glDeleteFramebuffers(1, &resolution->framebuffer);
+    if (resolution->texture)
+        glDeleteTextures(1, &resolution->texture);
+    if (resolution->depthBuffer)
+        glDeleteRenderbuffers(1, &resolution->depthBuffer);
+    if (resolution->program)
+        glDeleteProgram(resolution->program);
+    if (resolution->buffer)
+        glDeleteBuffers(1, &resolution->buffer);
+}
+
+// Stretches the rendered corner of the texture over the outer framebuffer.
+static void dynamic_resolution_upscale(DynamicResolution *resolution)
+{
+    GlPassState state;
+    gl_pass_save_state(&state);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)resolution->outerFramebuffer);
+    gl_pass_set_state(resolution->width, resolution->height);
+    glUseProgram(resolution->program);
+    glUniform2f(resolution->scaleLocation, (GLfloat)resolution->renderWidth / (GLfloat)resolution->width,
+                (GLfloat)resolution->renderHeight / (GLfloat)resolution->height);
+    glUniform2f(resolution->maxLocation, ((GLfloat)resolution->renderWidth - 0.5f) / (GLfloat)resolution->width,
+                ((GLfloat)resolution->renderHeight - 0.5f) / (GLfloat)resolution->height);
+    glBindTexture(GL_TEXTURE_2D, resolution->texture);
+    gl_pass_draw(resolution->buffer);
+    gl_pass_restore_state(&state);
+}
+
+// ---------------------------------------------------------------------------
+// Controller
+
+static void dynamic_resolution_set_scale(DynamicResolution *resolution, double scale)
+{
+    resolution->scale = scale;
+    resolution->renderWidth = (int)lround(resolution->width * scale);
+    resolution->renderHeight = (int)lround(resolution->height * scale);
+    if (resolution->renderWidth < 1)
+        resolution->renderWidth = 1;
+    if (resolution->renderHeight < 1)
+        resolution->renderHeight = 1;
+}
+
+static void dynamic_resolution_control(DynamicResolution *resolution, double frameMs)
+{
+    double error = log(resolution->targetMs / frameMs);
+    if (fabs(error) < DYNAMIC_RESOLUTION_DEADBAND)
+        error = 0.0;
+    double minLogArea = 2.0 * log(resolution->minScale);
+    double integral = resolution->integral + error;
+    double logArea = DYNAMIC_RESOLUTION_KP * error + DYNAMIC_RESOLUTION_KI * integral;
+    // The integral does not keep growing past a limit the scale is held at
+    if (!(logArea > 0.0 && error > 0.0) && !(logArea < minLogArea && error < 0.0))
+        resolution->integral = integral;
+    if (logArea > 0.0)
+        logArea = 0.0;
+    if (logArea < minLogArea)
+        logArea = minLogArea;
+    dynamic_resolution_set_scale(resolution, exp(0.5 * logArea));
+}
+
+// ---------------------------------------------------------------------------
+// API
+
+DynamicResolution *dynamic_resolution_create(int width, int height, double targetMs, double minScale)
+{
+    if (width <= 0 || height <= 0 || targetMs <= 0.0)
+        return NULL;
+    DynamicResolution *resolution = (DynamicResolution *)calloc(1, sizeof(DynamicResolution));
+    if (!resolution)
+        return NULL;
+    resolution->width = width;
+    resolution->height = height;
+    resolution->targetMs = targetMs;
+    resolution->minScale = minScale > 0.0 && minScale <= 1.0 ? minScale : 0.25;
+    if (!dynamic_resolution_create_target(resolution))
+    {
+        dynamic_resolution_delete_target(resolution);
+        free(resolution);
+        printf("INFO: dynamic resolution: offscreen framebuffers unavailable, rendering at full resolution\n");
+        return NULL;
+    }
+    dynamic_resolution_set_scale(resolution, 1.0);
+    printf("INFO: dynamic resolution: %dx%d, target %.2f ms, scale %.2f to 1\n", width, height, targetMs,
+           resolution->minScale);
+    return resolution;
+}
+
+DynamicResolution *dynamic_resolution_create_from_env(int width, int height)
+{
+    const char *value = getenv("SAMPLES_DYNAMIC_RESOLUTION");
+    if (!value || !*value)
+        return NULL;
+    char *end;
+    double targetMs = strtod(value, &end);
+    double minScale = *end == ':' ? strtod(end + 1, NULL) : 0.0;
+    if (targetMs <= 0.0)
+    {
+        printf("ERROR: SAMPLES_DYNAMIC_RESOLUTION must be <target ms>[:<min scale>], not %s\n", value);
+        return NULL;
+    }
+    return dynamic_resolution_create(width, height, targetMs, minScale);
+}
+
+void dynamic_resolution_begin(DynamicResolution *resolution, int *renderWidth, int *renderHeight)
+{
+    if (!resolution)
+        return;
+    resolution->beginTime = dynamic_resolution_seconds();
+    if (resolution->lastLogTime == 0.0)
+        resolution->lastLogTime = resolution->beginTime;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &resolution->outerFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution->framebuffer);
+    glViewport(0, 0, resolution->renderWidth, resolution->renderHeight);
+    *renderWidth = resolution->renderWidth;
+    *renderHeight = resolution->renderHeight;
+}
+
+void dynamic_resolution_end(DynamicResolution *resolution)
+{
+    if (!resolution)
+        return;
+    PROFILE_CALL(dynamic_resolution_upscale(resolution));
+    PROFILE_CALL(glFinish());
+    double end = dynamic_resolution_seconds();
+    double frameMs = (end - resolution->beginTime) * 1000.0;
+    double scale = resolution->scale;
+
+    resolution->frames++;
+    resolution->overBudget += frameMs > resolution->targetMs;
+    resolution->frameMs = frameMs;
+    resolution->scaleSum += scale;
+    resolution->frameMsSum += frameMs;
+    resolution->logFrames++;
+    resolution->logScaleSum += scale;
+    resolution->logFrameMsSum += frameMs;
+    if (end - resolution->lastLogTime >= DYNAMIC_RESOLUTION_LOG_SECONDS)
+    {
+        printf("INFO: dynamic resolution: scale %.2f, now %dx%d, frame %.2f ms, target %.2f ms\n",
+               resolution->logScaleSum / (double)resolution->logFrames, resolution->renderWidth,
+               resolution->renderHeight, resolution->logFrameMsSum / (double)resolution->logFrames,
+               resolution->targetMs);
+        resolution->lastLogTime = end;
+        resolution->logFrames = 0;
+        resolution->logScaleSum = 0.0;
+        resolution->logFrameMsSum = 0.0;
+    }
+    // Smoothing keeps single slow or fast frames from moving the scale
+    resolution->smoothedMs = resolution->frames == 1 ? frameMs
+                                                     : resolution->smoothedMs +
+                                                           DYNAMIC_RESOLUTION_SMOOTHING * (frameMs - resolution->smoothedMs);
+    dynamic_resolution_control(resolution, resolution->smoothedMs > 1e-3 ? resolution->smoothedMs : 1e-3);
+}
+
+void dynamic_resolution_get_stats(const DynamicResolution *resolution, DynamicResolutionStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!resolution)
+        return;
+    stats->frames = resolution->frames;
+    stats->overBudget = resolution->overBudget;
+    stats->scale = resolution->scale;
+    stats->frameMs = resolution->frameMs;
+    stats->averageScale = resolution->frames ? resolution->scaleSum / (double)resolution->frames : 0.0;
+    stats->averageFrameMs = resolution->frames ? resolution->frameMsSum / (double)resolution->frames : 0.0;
+}
+
+void dynamic_resolution_destroy(DynamicResolution *resolution)
+{
+    if (!resolution)
+        return;
+    DynamicResolutionStats stats;
+    dynamic_resolution_get_stats(resolution, &stats);
+    printf("INFO: dynamic resolution: %llu frames, average scale %.2f, average frame %.2f ms, %llu over %.2f ms\n",
+           stats.frames, stats.averageScale, stats.averageFrameMs, stats.overBudget, resolution->targetMs);
+    dynamic_resolution_delete_target(resolution);
+    free(resolution);
+}
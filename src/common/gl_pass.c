@@ -0,0 +1,108 @@
+// gl_pass.c
+// See gl_pass.h.
+#include "common/gl_pass.h"
+
+static void gl_pass_set_enabled(GLenum cap, GLboolean enabled)
+{
+    if (enabled)
+        glEnable(cap);
+    else
+        glDisable(cap);
+}
+
+void gl_pass_save_state(GlPassState *state)
+{
+    glGetIntegerv(GL_CURRENT_PROGRAM, &state->program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &state->arrayBuffer);
+    glGetIntegerv(GL_VIEWPORT, state->viewport);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &state->activeTexture);
+    for (int unit = 1; unit >= 0; --unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + (GLenum)unit);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &state->textures[unit]);
+    }
+    glGetBooleanv(GL_COLOR_WRITEMASK, state->colorMask);
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &state->depthMask);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, state->clearColor);
+    state->blend = glIsEnabled(GL_BLEND);
+    state->scissor = glIsEnabled(GL_SCISSOR_TEST);
+    state->cull = glIsEnabled(GL_CULL_FACE);
+    state->depth = glIsEnabled(GL_DEPTH_TEST);
+    state->stencil = glIsEnabled(GL_STENCIL_TEST);
+    glGetIntegerv(GL_BLEND_EQUATION_RGB, &state->equationRgb);
+    glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &state->equationAlpha);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &state->srcRgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &state->dstRgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &state->srcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &state->dstAlpha);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &state->attribEnabled);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_SIZE, &state->attribSize);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_TYPE, &state->attribType);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &state->attribNormalized);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &state->attribStride);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &state->attribBuffer);
+    glGetVertexAttribPointerv(0, GL_VERTEX_ATTRIB_ARRAY_POINTER, &state->attribPointer);
+}
+
+void gl_pass_restore_state(const GlPassState *state)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)state->attribBuffer);
+    glVertexAttribPointer(0, state->attribSize, (GLenum)state->attribType, (GLboolean)state->attribNormalized,
+                          state->attribStride, state->attribPointer);
+    if (state->attribEnabled)
+        glEnableVertexAttribArray(0);
+    else
+        glDisableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)state->arrayBuffer);
+    glUseProgram((GLuint)state->program);
+    for (int unit = 0; unit < 2; ++unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + (GLenum)unit);
+        glBindTexture(GL_TEXTURE_2D, (GLuint)state->textures[unit]);
+    }
+    glActiveTexture((GLenum)state->activeTexture);
+    glViewport(state->viewport[0], state->viewport[1], state->viewport[2], state->viewport[3]);
+    glColorMask(state->colorMask[0], state->colorMask[1], state->colorMask[2], state->colorMask[3]);
+    glDepthMask(state->depthMask);
+    glClearColor(state->clearColor[0], state->clearColor[1], state->clearColor[2], state->clearColor[3]);
+    gl_pass_set_enabled(GL_BLEND, state->blend);
+    gl_pass_set_enabled(GL_SCISSOR_TEST, state->scissor);
+    gl_pass_set_enabled(GL_CULL_FACE, state->cull);
+    gl_pass_set_enabled(GL_DEPTH_TEST, state->depth);
+    gl_pass_set_enabled(GL_STENCIL_TEST, state->stencil);
+    glBlendEquationSeparate((GLenum)state->equationRgb, (GLenum)state->equationAlpha);
+    glBlendFuncSeparate((GLenum)state->srcRgb, (GLenum)state->dstRgb, (GLenum)state->srcAlpha,
+                        (GLenum)state->dstAlpha);
+}
+
+void gl_pass_set_state(int width, int height)
+{
+    glViewport(0, 0, width, height);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_STENCIL_TEST);
+}
+
+GLuint gl_pass_create_triangle(void)
+{
+    static const GLfloat vertices[] = {-1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f};
+    GLint arrayBuffer;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)arrayBuffer);
+    return buffer;
+}
+
+void gl_pass_draw(GLuint buffer)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,605 @@
+// gl_tracker.c
+// Each wrapper calls the real function first and then updates the record
+// of the object, found by its share group, kind and name in a hash table.
+// Sizes are attributed to the object bound to the target, queried with
+// glGetIntegerv; the wrappers never call glGetError, which would take
+// errors away from the application, so a call that fails still counts.
+#include "common/gl_tracker.h"
+
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *glTrackerKindNames[GL_TRACKER_KINDS] = {
+    "buffer", "texture", "renderbuffer", "framebuffer", "shader", "program",
+};
+
+static pthread_mutex_t trackerLock = PTHREAD_MUTEX_INITIALIZER;
+static GlTrackerTotals trackerTotals;
+
+int gl_tracker_enabled(void)
+{
+#if defined(SAMPLES_GL_TRACKER)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void gl_tracker_get_totals(GlTrackerTotals *totals)
+{
+    pthread_mutex_lock(&trackerLock);
+    *totals = trackerTotals;
+    pthread_mutex_unlock(&trackerLock);
+}
+
+const char *gl_tracker_kind_name(GlTrackerKind kind)
+{
+    return glTrackerKindNames[kind];
+}
+
+#if defined(SAMPLES_GL_TRACKER)
+
+#define GL_TRACKER_BUCKETS 1024
+#define GL_TRACKER_MAX_LEVELS 16
+#define GL_TRACKER_FACES 6
+#define GL_TRACKER_MAX_WINDOWS 64
+// Objects listed per report; the rest are only counted
+#define GL_TRACKER_REPORT_LINES 32
+
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+#ifndef GL_RGBA8_OES
+#define GL_RGBA8_OES 0x8058
+#endif
+#ifndef GL_RGB8_OES
+#define GL_RGB8_OES 0x8051
+#endif
+#ifndef GL_DEPTH24_STENCIL8_OES
+#define GL_DEPTH24_STENCIL8_OES 0x88F0
+#endif
+#ifndef GL_DEPTH_COMPONENT24_OES
+#define GL_DEPTH_COMPONENT24_OES 0x81A6
+#endif
+
+static void format_bytes(unsigned long long bytes, char *text, size_t size)
+{
+    if (bytes >= 1024ull * 1024ull)
+        snprintf(text, size, "%.1f MiB", (double)bytes / (1024.0 * 1024.0));
+    else if (bytes >= 1024ull)
+        snprintf(text, size, "%.1f KiB", (double)bytes / 1024.0);
+    else
+        snprintf(text, size, "%llu bytes", bytes);
+}
+
+// Per face and level of a texture
+typedef struct GlTrackerTexture
+{
+    unsigned long long levelBytes[GL_TRACKER_FACES][GL_TRACKER_MAX_LEVELS];
+    int width[GL_TRACKER_FACES]; // level 0, for glGenerateMipmap
+    int height[GL_TRACKER_FACES];
+    int texelBytes[GL_TRACKER_FACES]; // 0 when compressed
+} GlTrackerTexture;
+
+typedef struct GlTrackerObject
+{
+    struct GlTrackerObject *next;
+    unsigned group;
+    GlTrackerKind kind;
+    GLuint name;
+    unsigned long long bytes;
+    GlTrackerTexture *texture;
+} GlTrackerObject;
+
+typedef struct GlTrackerWindow
+{
+    GLFWwindow *window;
+    unsigned group; // shared by the windows sharing a context
+} GlTrackerWindow;
+
+static GlTrackerObject *objects[GL_TRACKER_BUCKETS];
+static GlTrackerWindow windows[GL_TRACKER_MAX_WINDOWS];
+static int windowCount;
+static unsigned groupCount;
+static pthread_once_t trackerOnce = PTHREAD_ONCE_INIT;
+
+void GL_APIENTRY __real_glGenBuffers(GLsizei n, GLuint *buffers);
+void GL_APIENTRY __real_glDeleteBuffers(GLsizei n, const GLuint *buffers);
+void GL_APIENTRY __real_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+void GL_APIENTRY __real_glGenTextures(GLsizei n, GLuint *textures);
+void GL_APIENTRY __real_glDeleteTextures(GLsizei n, const GLuint *textures);
+void GL_APIENTRY __real_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                                     GLint border, GLenum format, GLenum type, const void *pixels);
+void GL_APIENTRY __real_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width,
+                                               GLsizei height, GLint border, GLsizei imageSize, const void *data);
+void GL_APIENTRY __real_glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y,
+                                         GLsizei width, GLsizei height, GLint border);
+void GL_APIENTRY __real_glGenerateMipmap(GLenum target);
+void GL_APIENTRY __real_glGenRenderbuffers(GLsizei n, GLuint *renderbuffers);
+void GL_APIENTRY __real_glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers);
+void GL_APIENTRY __real_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+void GL_APIENTRY __real_glGenFramebuffers(GLsizei n, GLuint *framebuffers);
+void GL_APIENTRY __real_glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers);
+GLuint GL_APIENTRY __real_glCreateShader(GLenum type);
+void GL_APIENTRY __real_glDeleteShader(GLuint shader);
+GLuint GL_APIENTRY __real_glCreateProgram(void);
+void GL_APIENTRY __real_glDeleteProgram(GLuint program);
+GLFWwindow *__real_glfwCreateWindow(int width, int height, const char *title, GLFWmonitor *monitor,
+                                    GLFWwindow *share);
+void __real_glfwDestroyWindow(GLFWwindow *window);
+void __real_glfwTerminate(void);
+
+// ---------------------------------------------------------------------------
+// Records, called with the lock held
+
+// 0 for no window, or one the tracker did not see created
+static unsigned group_of(GLFWwindow *window)
+{
+    for (int i = 0; i < windowCount; ++i)
+    {
+        if (windows[i].window == window)
+            return windows[i].group;
+    }
+    return 0;
+}
+
+static unsigned bucket_of(unsigned group, GlTrackerKind kind, GLuint name)
+{
+    uint64_t key = ((uint64_t)group << 32) ^ ((uint64_t)kind << 56) ^ ((uint64_t)name * 0x9e3779b97f4a7c15ull);
+    return (unsigned)((key ^ key >> 29) % GL_TRACKER_BUCKETS);
+}
+
+static GlTrackerObject **find_object(unsigned group, GlTrackerKind kind, GLuint name)
+{
+    GlTrackerObject **link = &objects[bucket_of(group, kind, name)];
+    while (*link && ((*link)->group != group || (*link)->kind != kind || (*link)->name != name))
+        link = &(*link)->next;
+    return link;
+}
+
+static void set_bytes(GlTrackerObject *object, unsigned long long bytes)
+{
+    trackerTotals.bytes[object->kind] += bytes - object->bytes;
+    trackerTotals.totalBytes += bytes - object->bytes;
+    object->bytes = bytes;
+    if (trackerTotals.totalBytes > trackerTotals.peakBytes)
+        trackerTotals.peakBytes = trackerTotals.totalBytes;
+}
+
+static void remove_object(GlTrackerObject **link)
+{
+    GlTrackerObject *object = *link;
+    set_bytes(object, 0);
+    trackerTotals.objects[object->kind]--;
+    *link = object->next;
+    free(object->texture);
+    free(object);
+}
+
+static void report_at_exit(void);
+
+static void tracker_start(void)
+{
+    atexit(report_at_exit);
+}
+
+static void add_object(GlTrackerKind kind, GLuint name)
+{
+    if (name == 0)
+        return;
+    unsigned group = group_of(glfwGetCurrentContext());
+    GlTrackerObject **link = find_object(group, kind, name);
+    if (*link)
+        remove_object(link); // deleted behind the tracker's back
+    GlTrackerObject *object = (GlTrackerObject *)calloc(1, sizeof(GlTrackerObject));
+    if (!object)
+        return;
+    object->group = group;
+    object->kind = kind;
+    object->name = name;
+    object->next = *link;
+    *link = object;
+    trackerTotals.objects[kind]++;
+    trackerTotals.created++;
+}
+
+static void delete_object(GlTrackerKind kind, GLuint name)
+{
+    if (name == 0)
+        return;
+    GlTrackerObject **link = find_object(group_of(glfwGetCurrentContext()), kind, name);
+    if (*link)
+    {
+        remove_object(link);
+        trackerTotals.deleted++;
+    }
+}
+
+static void generate(GlTrackerKind kind, GLsizei n, const GLuint *names)
+{
+    pthread_once(&trackerOnce, tracker_start);
+    pthread_mutex_lock(&trackerLock);
+    for (GLsizei i = 0; i < n; ++i)
+        add_object(kind, names[i]);
+    pthread_mutex_unlock(&trackerLock);
+}
+
+static void delete_objects(GlTrackerKind kind, GLsizei n, const GLuint *names)
+{
+    pthread_mutex_lock(&trackerLock);
+    for (GLsizei i = 0; i < n; ++i)
+        delete_object(kind, names[i]);
+    pthread_mutex_unlock(&trackerLock);
+}
+
+// The object bound to binding, NULL when none is or it is not tracked
+static GlTrackerObject *bound_object(GlTrackerKind kind, GLenum binding)
+{
+    GLint name = 0;
+    glGetIntegerv(binding, &name);
+    if (name <= 0)
+        return NULL;
+    return *find_object(group_of(glfwGetCurrentContext()), kind, (GLuint)name);
+}
+
+// ---------------------------------------------------------------------------
+// Reports, called with the lock held
+
+// Prints the objects of group (all groups when all) and, with release,
+// forgets them. Returns how many there were.
+static int reported;
+
+static unsigned long long report_objects(unsigned group, int all, int release, const char *when)
+{
+    unsigned long long count = 0, bytes = 0;
+    for (int i = 0; i < GL_TRACKER_BUCKETS; ++i)
+    {
+        for (GlTrackerObject *object = objects[i]; object; object = object->next)
+        {
+            if (all || object->group == group)
+            {
+                count++;
+                bytes += object->bytes;
+            }
+        }
+    }
+    char text[32];
+    format_bytes(bytes, text, sizeof(text));
+    reported |= release;
+    if (count == 0)
+    {
+        printf("INFO: gl_tracker: no GL objects left %s\n", when);
+        return 0;
+    }
+    printf("%s: gl_tracker: %llu GL objects (%s) left %s\n", release ? "ERROR" : "INFO", count, text, when);
+    unsigned long long listed = 0;
+    for (int i = 0; i < GL_TRACKER_BUCKETS; ++i)
+    {
+        GlTrackerObject **link = &objects[i];
+        while (*link)
+        {
+            GlTrackerObject *object = *link;
+            if (!all && object->group != group)
+            {
+                link = &object->next;
+                continue;
+            }
+            if (listed++ < GL_TRACKER_REPORT_LINES)
+            {
+                format_bytes(object->bytes, text, sizeof(text));
+                printf("    %s %u, %s\n", glTrackerKindNames[object->kind], object->name, text);
+            }
+            if (release)
+                remove_object(link);
+            else
+                link = &object->next;
+        }
+    }
+    if (listed > GL_TRACKER_REPORT_LINES)
+        printf("    and %llu more\n", listed - GL_TRACKER_REPORT_LINES);
+    return count;
+}
+
+static void report_at_exit(void)
+{
+    pthread_mutex_lock(&trackerLock);
+    unsigned long long alive = 0;
+    for (int kind = 0; kind < GL_TRACKER_KINDS; ++kind)
+        alive += trackerTotals.objects[kind];
+    // Quiet when the contexts were torn down and reported already
+    if (alive || !reported)
+        report_objects(0, 1, 1, "at exit");
+    pthread_mutex_unlock(&trackerLock);
+}
+
+unsigned long long gl_tracker_report(void)
+{
+    pthread_mutex_lock(&trackerLock);
+    unsigned long long count = report_objects(0, 1, 0, "alive");
+    pthread_mutex_unlock(&trackerLock);
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Size estimates
+
+static int texel_bytes(GLenum format, GLenum type)
+{
+    if (type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1)
+        return 2;
+    int channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_LUMINANCE_ALPHA ? 2 : 1;
+    int channelBytes = type == GL_FLOAT || type == GL_UNSIGNED_INT         ? 4
+                       : type == GL_UNSIGNED_SHORT || type == GL_HALF_FLOAT_OES ? 2
+                                                                                : 1;
+    return channels * channelBytes;
+}
+
+static int renderbuffer_texel_bytes(GLenum internalformat)
+{
+    switch (internalformat)
+    {
+    case GL_STENCIL_INDEX8:
+        return 1;
+    case GL_RGBA4:
+    case GL_RGB5_A1:
+    case GL_RGB565:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    case GL_RGB8_OES:
+        return 3;
+    default: // GL_RGBA8_OES, GL_DEPTH24_STENCIL8_OES, GL_DEPTH_COMPONENT24_OES
+        return 4;
+    }
+}
+
+// The bound texture of a glTexImage2D target and the face it names
+static GlTrackerObject *texture_of(GLenum target, int *face)
+{
+    *face = 0;
+    GLenum binding = GL_TEXTURE_BINDING_2D;
+    if (target != GL_TEXTURE_2D)
+    {
+        *face = (int)(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X);
+        if (*face < 0 || *face >= GL_TRACKER_FACES)
+            return NULL;
+        binding = GL_TEXTURE_BINDING_CUBE_MAP;
+    }
+    GlTrackerObject *object = bound_object(GL_TRACKER_TEXTURE, binding);
+    if (object && !object->texture)
+        object->texture = (GlTrackerTexture *)calloc(1, sizeof(GlTrackerTexture));
+    return object && object->texture ? object : NULL;
+}
+
+static void set_level(GlTrackerObject *object, int face, GLint level, unsigned long long bytes)
+{
+    if (level < 0 || level >= GL_TRACKER_MAX_LEVELS)
+        return;
+    GlTrackerTexture *texture = object->texture;
+    set_bytes(object, object->bytes - texture->levelBytes[face][level] + bytes);
+    texture->levelBytes[face][level] = bytes;
+}
+
+static void specify_level(GLenum target, GLint level, int width, int height, int texelBytes,
+                          unsigned long long bytes)
+{
+    pthread_mutex_lock(&trackerLock);
+    int face;
+    GlTrackerObject *object = texture_of(target, &face);
+    if (object)
+    {
+        set_level(object, face, level, bytes);
+        if (level == 0)
+        {
+            object->texture->width[face] = width;
+            object->texture->height[face] = height;
+            object->texture->texelBytes[face] = texelBytes;
+        }
+    }
+    pthread_mutex_unlock(&trackerLock);
+}
+
+// ---------------------------------------------------------------------------
+// Wrappers
+
+void GL_APIENTRY __wrap_glGenBuffers(GLsizei n, GLuint *buffers)
+{
+    __real_glGenBuffers(n, buffers);
+    generate(GL_TRACKER_BUFFER, n, buffers);
+}
+
+void GL_APIENTRY __wrap_glDeleteBuffers(GLsizei n, const GLuint *buffers)
+{
+    __real_glDeleteBuffers(n, buffers);
+    delete_objects(GL_TRACKER_BUFFER, n, buffers);
+}
+
+void GL_APIENTRY __wrap_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+    __real_glBufferData(target, size, data, usage);
+    pthread_mutex_lock(&trackerLock);
+    GlTrackerObject *object = bound_object(
+        GL_TRACKER_BUFFER, target == GL_ELEMENT_ARRAY_BUFFER ? GL_ELEMENT_ARRAY_BUFFER_BINDING : GL_ARRAY_BUFFER_BINDING);
+    if (object && size >= 0)
+        set_bytes(object, (unsigned long long)size);
+    pthread_mutex_unlock(&trackerLock);
+}
+
+void GL_APIENTRY __wrap_glGenTextures(GLsizei n, GLuint *textures)
+{
+    __real_glGenTextures(n, textures);
+    generate(GL_TRACKER_TEXTURE, n, textures);
+}
+
+void GL_APIENTRY __wrap_glDeleteTextures(GLsizei n, const GLuint *textures)
+{
+    __real_glDeleteTextures(n, textures);
+    delete_objects(GL_TRACKER_TEXTURE, n, textures);
+}
+
+void GL_APIENTRY __wrap_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                                     GLint border, GLenum format, GLenum type, const void *pixels)
+{
+    __real_glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+    if (width < 0 || height < 0)
+        return;
+    int texelBytes = texel_bytes(format, type);
+    specify_level(target, level, width, height, texelBytes,
+                  (unsigned long long)width * (unsigned long long)height * (unsigned long long)texelBytes);
+}
+
+void GL_APIENTRY __wrap_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width,
+                                               GLsizei height, GLint border, GLsizei imageSize, const void *data)
+{
+    __real_glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
+    if (imageSize >= 0)
+        specify_level(target, level, width, height, 0, (unsigned long long)imageSize);
+}
+
+void GL_APIENTRY __wrap_glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y,
+                                         GLsizei width, GLsizei height, GLint border)
+{
+    __real_glCopyTexImage2D(target, level, internalformat, x, y, width, height, border);
+    if (width < 0 || height < 0)
+        return;
+    int texelBytes = texel_bytes(internalformat, GL_UNSIGNED_BYTE);
+    specify_level(target, level, width, height, texelBytes,
+                  (unsigned long long)width * (unsigned long long)height * (unsigned long long)texelBytes);
+}
+
+void GL_APIENTRY __wrap_glGenerateMipmap(GLenum target)
+{
+    __real_glGenerateMipmap(target);
+    pthread_mutex_lock(&trackerLock);
+    GlTrackerObject *object = bound_object(
+        GL_TRACKER_TEXTURE, target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D);
+    if (object && !object->texture)
+        object->texture = (GlTrackerTexture *)calloc(1, sizeof(GlTrackerTexture));
+    int faces = target == GL_TEXTURE_CUBE_MAP ? GL_TRACKER_FACES : 1;
+    for (int face = 0; object && object->texture && face < faces; ++face)
+    {
+        int width = object->texture->width[face], height = object->texture->height[face];
+        for (int level = 1; level < GL_TRACKER_MAX_LEVELS && (width > 1 || height > 1); ++level)
+        {
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            set_level(object, face, level,
+                      (unsigned long long)width * (unsigned long long)height *
+                          (unsigned long long)object->texture->texelBytes[face]);
+        }
+    }
+    pthread_mutex_unlock(&trackerLock);
+}
+
+void GL_APIENTRY __wrap_glGenRenderbuffers(GLsizei n, GLuint *renderbuffers)
+{
+    __real_glGenRenderbuffers(n, renderbuffers);
+    generate(GL_TRACKER_RENDERBUFFER, n, renderbuffers);
+}
+
+void GL_APIENTRY __wrap_glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers)
+{
+    __real_glDeleteRenderbuffers(n, renderbuffers);
+    delete_objects(GL_TRACKER_RENDERBUFFER, n, renderbuffers);
+}
+
+void GL_APIENTRY __wrap_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+    __real_glRenderbufferStorage(target, internalformat, width, height);
+    pthread_mutex_lock(&trackerLock);
+    GlTrackerObject *object = bound_object(GL_TRACKER_RENDERBUFFER, GL_RENDERBUFFER_BINDING);
+    if (object && width >= 0 && height >= 0)
+        set_bytes(object, (unsigned long long)width * (unsigned long long)height *
+                              (unsigned long long)renderbuffer_texel_bytes(internalformat));
+    pthread_mutex_unlock(&trackerLock);
+}
+
+void GL_APIENTRY __wrap_glGenFramebuffers(GLsizei n, GLuint *framebuffers)
+{
+    __real_glGenFramebuffers(n, framebuffers);
+    generate(GL_TRACKER_FRAMEBUFFER, n, framebuffers);
+}
+
+void GL_APIENTRY __wrap_glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+{
+    __real_glDeleteFramebuffers(n, framebuffers);
+    delete_objects(GL_TRACKER_FRAMEBUFFER, n, framebuffers);
+}
+
+GLuint GL_APIENTRY __wrap_glCreateShader(GLenum type)
+{
+    GLuint shader = __real_glCreateShader(type);
+    generate(GL_TRACKER_SHADER, 1, &shader);
+    return shader;
+}
+
+void GL_APIENTRY __wrap_glDeleteShader(GLuint shader)
+{
+    __real_glDeleteShader(shader);
+    delete_objects(GL_TRACKER_SHADER, 1, &shader);
+}
+
+GLuint GL_APIENTRY __wrap_glCreateProgram(void)
+{
+    GLuint program = __real_glCreateProgram();
+    generate(GL_TRACKER_PROGRAM, 1, &program);
+    return program;
+}
+
+void GL_APIENTRY __wrap_glDeleteProgram(GLuint program)
+{
+    __real_glDeleteProgram(program);
+    delete_objects(GL_TRACKER_PROGRAM, 1, &program);
+}
+
+GLFWwindow *__wrap_glfwCreateWindow(int width, int height, const char *title, GLFWmonitor *monitor,
+                                    GLFWwindow *share)
+{
+    GLFWwindow *window = __real_glfwCreateWindow(width, height, title, monitor, share);
+    pthread_mutex_lock(&trackerLock);
+    if (window && windowCount < GL_TRACKER_MAX_WINDOWS)
+    {
+        windows[windowCount].window = window;
+        windows[windowCount].group = share && group_of(share) ? group_of(share) : ++groupCount;
+        windowCount++;
+    }
+    pthread_mutex_unlock(&trackerLock);
+    return window;
+}
+
+void __wrap_glfwDestroyWindow(GLFWwindow *window)
+{
+    pthread_mutex_lock(&trackerLock);
+    unsigned group = group_of(window);
+    int members = 0;
+    for (int i = 0; i < windowCount; ++i)
+        members += windows[i].group == group;
+    if (group && members == 1)
+        report_objects(group, 0, 1, "when the context was destroyed");
+    for (int i = 0; i < windowCount; ++i)
+    {
+        if (windows[i].window == window)
+        {
+            windows[i] = windows[--windowCount];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&trackerLock);
+    __real_glfwDestroyWindow(window);
+}
+
+void __wrap_glfwTerminate(void)
+{
+    pthread_mutex_lock(&trackerLock);
+    if (windowCount > 0)
+        report_objects(0, 1, 1, "when GLFW was terminated");
+    windowCount = 0;
+    pthread_mutex_unlock(&trackerLock);
+    __real_glfwTerminate();
+}
+
+#endif // SAMPLES_GL_TRACKER
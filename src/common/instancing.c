@@ -0,0 +1,335 @@
+// instancing.c
+// Hardware instancing and the pseudo-instancing fallback. See instancing.h.
+#include "common/instancing.h"
+#include "common/shader_program.h"
+
+#include <GLFW/glfw3.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INSTANCING_MAX_VECTORS 4 // per instance
+// Copies of the mesh kept for pseudo-instancing; more would only grow the
+// buffers, as the per-draw cost is already shared by this many instances
+#define INSTANCING_MAX_BATCH 256
+
+// GL_ANGLE_instanced_arrays and GL_EXT_instanced_arrays have the same entry
+// points with different suffixes
+typedef void (*InstancingDrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+typedef void (*InstancingVertexAttribDivisor)(GLuint index, GLuint divisor);
+
+struct Instancing
+{
+    InstancingPath path;
+    int vectorsPerInstance;
+    int batchSize; // pseudo path
+    GLuint program;
+    GLint positionLocation;
+    GLint instanceLocations[INSTANCING_MAX_VECTORS]; // hardware path
+    GLint indexLocation;                             // pseudo path
+    GLint uniformLocation;                           // pseudo path
+    GLuint meshBuffer;     // the mesh, batchSize times over on the pseudo path
+    GLuint indexBuffer;    // pseudo path: the copy number of each vertex
+    GLuint instanceBuffer; // hardware path
+    int vertexCount;
+    int components;
+    InstancingDrawArraysInstanced drawArraysInstanced;
+    InstancingVertexAttribDivisor vertexAttribDivisor;
+};
+
+InstancingPath instancing_path_from_env(void)
+{
+    const char *value = getenv("SAMPLES_INSTANCING");
+    return value && strcmp(value, "pseudo") == 0 ? INSTANCING_PSEUDO : INSTANCING_HARDWARE;
+}
+
+// Compiles source with defines (shader_program_insert_defines). Failures
+// leave their log in log instead of printing it, as pseudo-instancing
+// expects some.
+static GLuint instancing_compile(GLenum type, const char *source, const char *defines, char *log, size_t logSize)
+{
+    char *text = shader_program_insert_defines(source, defines);
+    if (!text)
+        return 0;
+    GLuint shader = glCreateShader(type);
+    const char *sources[1] = {text};
+    glShaderSource(shader, 1, sources, NULL);
+    glCompileShader(shader);
+    free(text);
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, (GLsizei)logSize, NULL, log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint instancing_link(const char *vertexSource, const char *fragmentSource, const char *defines, char *log,
+                              size_t logSize)
+{
+    GLuint vertexShader = instancing_compile(GL_VERTEX_SHADER, vertexSource, defines, log, logSize);
+    GLuint fragmentShader = vertexShader ? instancing_compile(GL_FRAGMENT_SHADER, fragmentSource, "", log, logSize) : 0;
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, (GLsizei)logSize, NULL, log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// The instanced-arrays entry points, or 0 when the context has neither
+// extension.
+static int instancing_load_hardware(Instancing *instancing, const char **extension)
+{
+    static const char *extensions[2] = {"GL_ANGLE_instanced_arrays", "GL_EXT_instanced_arrays"};
+    static const char *suffixes[2] = {"ANGLE", "EXT"};
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!glfwExtensionSupported(extensions[i]))
+            continue;
+        char name[64];
+        snprintf(name, sizeof(name), "glDrawArraysInstanced%s", suffixes[i]);
+        instancing->drawArraysInstanced = (InstancingDrawArraysInstanced)glfwGetProcAddress(name);
+        snprintf(name, sizeof(name), "glVertexAttribDivisor%s", suffixes[i]);
+        instancing->vertexAttribDivisor = (InstancingVertexAttribDivisor)glfwGetProcAddress(name);
+        if (instancing->drawArraysInstanced && instancing->vertexAttribDivisor)
+        {
+            *extension = extensions[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The largest batch whose uniform array fits, halved while the driver
+// refuses it: some count vectors more coarsely than the limit suggests.
+static GLuint instancing_link_pseudo(Instancing *instancing, const char *vertexSource, const char *fragmentSource,
+                                     int reservedVectors, char *log, size_t logSize)
+{
+    GLint maxVectors = 0;
+    glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &maxVectors);
+    int batchSize = (maxVectors - reservedVectors) / instancing->vectorsPerInstance;
+    if (batchSize > INSTANCING_MAX_BATCH)
+        batchSize = INSTANCING_MAX_BATCH;
+    if (batchSize < 1)
+        snprintf(log, logSize, "%d vertex uniform vectors leave no room for an instance", (int)maxVectors);
+    for (; batchSize >= 1; batchSize /= 2)
+    {
+        char defines[96];
+        snprintf(defines, sizeof(defines), "#define INSTANCING_BATCH %d\n#define INSTANCING_VECTORS %d\n", batchSize,
+                 batchSize * instancing->vectorsPerInstance);
+        GLuint program = instancing_link(vertexSource, fragmentSource, defines, log, logSize);
+        if (program)
+        {
+            instancing->batchSize = batchSize;
+            printf("INFO: instancing: pseudo-instancing, %d instances per draw (%d vertex uniform vectors)\n",
+                   batchSize, (int)maxVectors);
+            return program;
+        }
+    }
+    return 0;
+}
+
+Instancing *instancing_create(InstancingPath preferred, const char *vertexSource, const char *fragmentSource,
+                              int vectorsPerInstance, int reservedVectors)
+{
+    if (vectorsPerInstance < 1 || vectorsPerInstance > INSTANCING_MAX_VECTORS)
+        return NULL;
+    Instancing *instancing = (Instancing *)calloc(1, sizeof(Instancing));
+    if (!instancing)
+        return NULL;
+    instancing->vectorsPerInstance = vectorsPerInstance;
+    char log[512] = "";
+    const char *extension = NULL;
+    if (preferred == INSTANCING_HARDWARE && instancing_load_hardware(instancing, &extension))
+    {
+        instancing->program = instancing_link(vertexSource, fragmentSource, "", log, sizeof(log));
+        if (instancing->program)
+        {
+            instancing->path = INSTANCING_HARDWARE;
+            printf("INFO: instancing: hardware (%s)\n", extension);
+        }
+    }
+    if (!instancing->program)
+    {
+        instancing->path = INSTANCING_PSEUDO;
+        instancing->program =
+            instancing_link_pseudo(instancing, vertexSource, fragmentSource, reservedVectors, log, sizeof(log));
+    }
+    if (!instancing->program)
+    {
+        printf("ERROR: instancing: %s\n", log);
+        instancing_destroy(instancing);
+        return NULL;
+    }
+
+    GLuint program = instancing->program;
+    instancing->positionLocation = glGetAttribLocation(program, "aPosition");
+    for (int i = 0; i < vectorsPerInstance; ++i)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "aInstance%d", i);
+        instancing->instanceLocations[i] = glGetAttribLocation(program, name);
+    }
+    instancing->indexLocation = glGetAttribLocation(program, "aInstanceIndex");
+    instancing->uniformLocation = glGetUniformLocation(program, "uInstances");
+    glGenBuffers(1, &instancing->meshBuffer);
+    glGenBuffers(1, &instancing->indexBuffer);
+    glGenBuffers(1, &instancing->instanceBuffer);
+    return instancing;
+}
+
+void instancing_destroy(Instancing *instancing)
+{
+    if (!instancing)
+        return;
+    if (instancing->program)
+        glDeleteProgram(instancing->program);
+    GLuint buffers[3] = {instancing->meshBuffer, instancing->indexBuffer, instancing->instanceBuffer};
+    if (buffers[0])
+        glDeleteBuffers(3, buffers);
+    free(instancing);
+}
+
+GLuint instancing_program(const Instancing *instancing)
+{
+    return instancing->program;
+}
+
+InstancingPath instancing_path(const Instancing *instancing)
+{
+    return instancing->path;
+}
+
+int instancing_batch_size(const Instancing *instancing)
+{
+    return instancing->path == INSTANCING_PSEUDO ? instancing->batchSize : 0;
+}
+
+const char *instancing_path_name(InstancingPath path)
+{
+    return path == INSTANCING_PSEUDO ? "pseudo" : "hardware";
+}
+
+void instancing_set_mesh(Instancing *instancing, const GLfloat *positions, int vertexCount, int components)
+{
+    instancing->vertexCount = vertexCount;
+    instancing->components = components;
+    size_t meshFloats = (size_t)vertexCount * (size_t)components;
+    glBindBuffer(GL_ARRAY_BUFFER, instancing->meshBuffer);
+    if (instancing->path == INSTANCING_HARDWARE)
+    {
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(meshFloats * sizeof(GLfloat)), positions, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
+    size_t copies = (size_t)instancing->batchSize;
+    GLfloat *repeated = (GLfloat *)malloc(meshFloats * copies * sizeof(GLfloat));
+    GLfloat *numbers = (GLfloat *)malloc((size_t)vertexCount * copies * sizeof(GLfloat));
+    if (repeated && numbers)
+    {
+        for (size_t copy = 0; copy < copies; ++copy)
+        {
+            memcpy(repeated + copy * meshFloats, positions, meshFloats * sizeof(GLfloat));
+            for (int v = 0; v < vertexCount; ++v)
+                numbers[copy * (size_t)vertexCount + (size_t)v] = (GLfloat)copy;
+        }
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(meshFloats * copies * sizeof(GLfloat)), repeated, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, instancing->indexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((size_t)vertexCount * copies * sizeof(GLfloat)), numbers,
+                     GL_STATIC_DRAW);
+    }
+    else
+    {
+        printf("ERROR: instancing: out of memory for %zu copies of the mesh\n", copies);
+        instancing->vertexCount = 0;
+    }
+    free(repeated);
+    free(numbers);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int instancing_draw(Instancing *instancing, GLenum mode, const GLfloat *instances, int instanceCount)
+{
+    if (instanceCount <= 0 || instancing->vertexCount <= 0)
+        return 0;
+    const int vectors = instancing->vectorsPerInstance;
+    glUseProgram(instancing->program);
+    glBindBuffer(GL_ARRAY_BUFFER, instancing->meshBuffer);
+    if (instancing->positionLocation >= 0)
+    {
+        glVertexAttribPointer((GLuint)instancing->positionLocation, instancing->components, GL_FLOAT, GL_FALSE, 0,
+                              (void *)0);
+        glEnableVertexAttribArray((GLuint)instancing->positionLocation);
+    }
+
+    int drawCalls = 0;
+    if (instancing->path == INSTANCING_HARDWARE)
+    {
+        GLsizei stride = (GLsizei)(vectors * 4 * sizeof(GLfloat));
+        glBindBuffer(GL_ARRAY_BUFFER, instancing->instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)instanceCount * stride, instances, GL_STREAM_DRAW);
+        for (int i = 0; i < vectors; ++i)
+        {
+            GLint location = instancing->instanceLocations[i];
+            if (location < 0)
+                continue;
+            glVertexAttribPointer((GLuint)location, 4, GL_FLOAT, GL_FALSE, stride,
+                                  (void *)(i * 4 * sizeof(GLfloat)));
+            glEnableVertexAttribArray((GLuint)location);
+            instancing->vertexAttribDivisor((GLuint)location, 1);
+        }
+        instancing->drawArraysInstanced(mode, 0, instancing->vertexCount, instanceCount);
+        drawCalls = 1;
+        for (int i = 0; i < vectors; ++i)
+        {
+            GLint location = instancing->instanceLocations[i];
+            if (location < 0)
+                continue;
+            instancing->vertexAttribDivisor((GLuint)location, 0);
+            glDisableVertexAttribArray((GLuint)location);
+        }
+    }
+    else
+    {
+        if (instancing->indexLocation >= 0)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, instancing->indexBuffer);
+            glVertexAttribPointer((GLuint)instancing->indexLocation, 1, GL_FLOAT, GL_FALSE, 0, (void *)0);
+            glEnableVertexAttribArray((GLuint)instancing->indexLocation);
+        }
+        for (int first = 0; first < instanceCount; first += instancing->batchSize)
+        {
+            int count = instanceCount - first < instancing->batchSize ? instanceCount - first : instancing->batchSize;
+            glUniform4fv(instancing->uniformLocation, count * vectors, instances + (size_t)first * (size_t)vectors * 4);
+            glDrawArrays(mode, 0, count * instancing->vertexCount);
+            ++drawCalls;
+        }
+        if (instancing->indexLocation >= 0)
+            glDisableVertexAttribArray((GLuint)instancing->indexLocation);
+    }
+    if (instancing->positionLocation >= 0)
+        glDisableVertexAttribArray((GLuint)instancing->positionLocation);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return drawCalls;
+}
@@ -0,0 +1,59 @@
+// premultiplied_alpha.c
+// See premultiplied_alpha.h.
+#include "common/premultiplied_alpha.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *premultipliedBlendNames[PREMULTIPLIED_BLENDS] = {"over", "additive"};
+
+const char *premultiplied_blend_name(PremultipliedBlend blend)
+{
+    return premultipliedBlendNames[blend];
+}
+
+int premultiplied_alpha_from_env(void)
+{
+    const char *value = getenv("SAMPLES_PREMULTIPLIED");
+    if (!value || !*value || strcmp(value, "0") == 0)
+        return 0;
+    if (strcmp(value, "1") != 0)
+    {
+        printf("ERROR: SAMPLES_PREMULTIPLIED must be 0 or 1, not %s\n", value);
+        return 0;
+    }
+    return 1;
+}
+
+void premultiply_color(PremultipliedBlend blend, const float rgba[4], float out[4])
+{
+    float alpha = rgba[3];
+    out[0] = rgba[0] * alpha;
+    out[1] = rgba[1] * alpha;
+    out[2] = rgba[2] * alpha;
+    out[3] = blend == PREMULTIPLIED_ADDITIVE ? 0.0f : alpha;
+}
+
+void premultiply_colors(PremultipliedBlend blend, float *colors, size_t count, size_t stride)
+{
+    unsigned char *color = (unsigned char *)colors;
+    for (size_t i = 0; i < count; ++i, color += stride)
+        premultiply_color(blend, (float *)color, (float *)color);
+}
+
+void premultiply_rgba8(PremultipliedBlend blend, unsigned char *pixels, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, pixels += 4)
+    {
+        unsigned alpha = pixels[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            // x / 255 rounded, exact for x up to 255 * 255
+            unsigned x = pixels[c] * alpha + 128;
+            pixels[c] = (unsigned char)((x + (x >> 8)) >> 8);
+        }
+        if (blend == PREMULTIPLIED_ADDITIVE)
+            pixels[3] = 0;
+    }
+}
@@ -0,0 +1,228 @@
+// profiler.c
+// Each thread appends to its own chain of event chunks, so recording takes
+// no lock: the owner publishes each event with a release store of the chunk
+// count, and the exporter reads up to the published count. Threads register
+// their buffer once, by pushing it onto a lock-free list.
+#if defined(SAMPLES_PROFILER)
+
+#include "common/profiler.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#define PROFILE_CHUNK_EVENTS 4096
+#define PROFILE_MAX_DEPTH 64
+
+typedef struct ProfileEvent
+{
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+} ProfileEvent;
+
+typedef struct ProfileChunk
+{
+    _Atomic(struct ProfileChunk *) next;
+    atomic_uint count;
+    ProfileEvent events[PROFILE_CHUNK_EVENTS];
+} ProfileChunk;
+
+typedef struct ProfileThread
+{
+    struct ProfileThread *next;
+    int id;
+    char name[32];
+    ProfileChunk *first;
+    ProfileChunk *last;
+    // Open PROFILE_BEGIN zones
+    const char *stackNames[PROFILE_MAX_DEPTH];
+    uint64_t stackStarts[PROFILE_MAX_DEPTH];
+    int depth;
+} ProfileThread;
+
+static _Atomic(ProfileThread *) profile_threads;
+static atomic_int profile_thread_count;
+static _Thread_local ProfileThread *profile_thread;
+static pthread_once_t profile_once = PTHREAD_ONCE_INIT;
+
+static void profile_export_at_exit(void)
+{
+    const char *path = getenv("SAMPLES_PROFILE");
+    if (!path || !*path)
+        path = "trace.json";
+    if (profile_write_chrome_trace(path))
+        printf("INFO: profile written to %s\n", path);
+}
+
+static void profile_start(void)
+{
+    atexit(profile_export_at_exit);
+}
+
+static int profile_is_main_thread(void)
+{
+#if defined(__linux__)
+    return syscall(SYS_gettid) == getpid();
+#else
+    return 0;
+#endif
+}
+
+static ProfileThread *profile_register(void)
+{
+    pthread_once(&profile_once, profile_start);
+    ProfileThread *thread = (ProfileThread *)calloc(1, sizeof(ProfileThread));
+    ProfileChunk *chunk = (ProfileChunk *)calloc(1, sizeof(ProfileChunk));
+    if (!thread || !chunk)
+    {
+        free(thread);
+        free(chunk);
+        return NULL;
+    }
+    thread->id = atomic_fetch_add(&profile_thread_count, 1) + 1;
+    if (profile_is_main_thread())
+        snprintf(thread->name, sizeof(thread->name), "main");
+    else
+        snprintf(thread->name, sizeof(thread->name), "thread %d", thread->id);
+    thread->first = thread->last = chunk;
+    ProfileThread *head = atomic_load(&profile_threads);
+    do
+        thread->next = head;
+    while (!atomic_compare_exchange_weak(&profile_threads, &head, thread));
+    // Buffers stay registered after their thread exits so the export sees them
+    profile_thread = thread;
+    return thread;
+}
+
+void profile_record(const char *name, uint64_t start, uint64_t end)
+{
+    ProfileThread *thread = profile_thread ? profile_thread : profile_register();
+    if (!thread)
+        return;
+    ProfileChunk *chunk = thread->last;
+    unsigned count = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+    if (count == PROFILE_CHUNK_EVENTS)
+    {
+        ProfileChunk *next = (ProfileChunk *)calloc(1, sizeof(ProfileChunk));
+        if (!next)
+            return;
+        atomic_store_explicit(&chunk->next, next, memory_order_release);
+        thread->last = chunk = next;
+        count = 0;
+    }
+    chunk->events[count].name = name;
+    chunk->events[count].start = start;
+    chunk->events[count].end = end;
+    atomic_store_explicit(&chunk->count, count + 1, memory_order_release);
+}
+
+void profile_begin(const char *name)
+{
+    ProfileThread *thread = profile_thread ? profile_thread : profile_register();
+    if (!thread)
+        return;
+    if (thread->depth < PROFILE_MAX_DEPTH)
+    {
+        thread->stackNames[thread->depth] = name;
+        thread->stackStarts[thread->depth] = profile_now();
+    }
+    thread->depth++;
+}
+
+void profile_end(void)
+{
+    uint64_t end = profile_now();
+    ProfileThread *thread = profile_thread;
+    if (!thread || thread->depth == 0)
+        return;
+    thread->depth--;
+    if (thread->depth < PROFILE_MAX_DEPTH)
+        profile_record(thread->stackNames[thread->depth], thread->stackStarts[thread->depth], end);
+}
+
+void profile_scope_end(ProfileScope *scope)
+{
+    profile_record(scope->name, scope->start, profile_now());
+}
+
+void profile_set_thread_name(const char *name)
+{
+    ProfileThread *thread = profile_thread ? profile_thread : profile_register();
+    if (thread)
+        snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+// Zone names are literals from the source; only quotes and backslashes need escaping
+static void profile_write_string(FILE *file, const char *s)
+{
+    fputc('"', file);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+int profile_write_chrome_trace(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        printf("ERROR: cannot write the profile to %s\n", path);
+        return 0;
+    }
+    // Timestamps start at the earliest zone
+    uint64_t base = UINT64_MAX;
+    for (ProfileThread *thread = atomic_load(&profile_threads); thread; thread = thread->next)
+    {
+        for (ProfileChunk *chunk = thread->first; chunk; chunk = atomic_load_explicit(&chunk->next, memory_order_acquire))
+        {
+            unsigned count = atomic_load_explicit(&chunk->count, memory_order_acquire);
+            for (unsigned i = 0; i < count; ++i)
+                base = chunk->events[i].start < base ? chunk->events[i].start : base;
+        }
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    int first = 1;
+    for (ProfileThread *thread = atomic_load(&profile_threads); thread; thread = thread->next)
+    {
+        fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":",
+                first ? "" : ",\n", thread->id);
+        profile_write_string(file, thread->name);
+        fprintf(file, "}}");
+        first = 0;
+        for (ProfileChunk *chunk = thread->first; chunk; chunk = atomic_load_explicit(&chunk->next, memory_order_acquire))
+        {
+            unsigned count = atomic_load_explicit(&chunk->count, memory_order_acquire);
+            for (unsigned i = 0; i < count; ++i)
+            {
+                const ProfileEvent *event = &chunk->events[i];
+                // Chrome traces use microseconds; three decimals keep the nanoseconds
+                uint64_t start = event->start - base;
+                uint64_t duration = event->end - event->start;
+                fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"name\":",
+                        thread->id, (unsigned long long)(start / 1000), (unsigned long long)(start % 1000),
+                        (unsigned long long)(duration / 1000), (unsigned long long)(duration % 1000));
+                profile_write_string(file, event->name);
+                fputc('}', file);
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+    int ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+#endif // SAMPLES_PROFILER
@@ -0,0 +1,376 @@
+// programmable_blend.c
+// Ping-pong images, layers and the composite pass. See programmable_blend.h.
+#include "common/programmable_blend.h"
+#include "common/gl_pass.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// GL_EXT_blend_minmax
+#ifndef GL_MIN_EXT
+#define GL_MIN_EXT 0x8007
+#endif
+#ifndef GL_MAX_EXT
+#define GL_MAX_EXT 0x8008
+#endif
+
+// BLEND_MODE of programmable_blend_frag.glsl that copies the destination
+#define PROGRAMMABLE_BLEND_COPY PROGRAMMABLE_BLEND_MODES
+
+// State the blend unit path and the layers change for the sample's draws
+typedef struct ProgrammableBlendDrawState
+{
+    GLboolean blend, stencil, scissor;
+    GLint equationRgb, equationAlpha, srcRgb, dstRgb, srcAlpha, dstAlpha;
+    GLint stencilFunc, stencilRef, stencilValueMask, stencilWriteMask;
+    GLint stencilFail, stencilDepthFail, stencilPass;
+    GLfloat clearColor[4];
+    GLint clearStencil;
+    GLboolean colorMask[4];
+} ProgrammableBlendDrawState;
+
+struct ProgrammableBlend
+{
+    int width;
+    int height;
+    GLuint framebuffers[2]; // the images
+    GLuint textures[2];
+    GLuint layerFramebuffer;
+    GLuint layerTexture;
+    GLuint stencilBuffer; // shared by the images and the layer
+    GLuint programs[PROGRAMMABLE_BLEND_MODES + 1];
+    GLuint buffer;
+    int current; // image being drawn into
+    int hardware;
+    int minmax; // GL_EXT_blend_minmax
+    GLint outerFramebuffer; // bound at programmable_blend_begin
+    ProgrammableBlendMode mode;
+    int layered; // between draw_begin and draw_end of a layer
+    ProgrammableBlendDrawState drawState;
+    unsigned long long layerCount;
+};
+
+static const char *programmableBlendModeNames[PROGRAMMABLE_BLEND_MODES] = {
+    "add", "subtract", "reverse subtract", "min", "max", "multiply", "screen", "overlay"};
+
+static const GLenum programmableBlendEquations[PROGRAMMABLE_BLEND_MODES] = {
+    GL_FUNC_ADD, GL_FUNC_SUBTRACT, GL_FUNC_REVERSE_SUBTRACT, GL_MIN_EXT, GL_MAX_EXT, 0, 0, 0};
+
+const char *programmable_blend_mode_name(ProgrammableBlendMode mode)
+{
+    return programmableBlendModeNames[mode];
+}
+
+static int programmable_blend_supported(ProgrammableBlendMode mode, int minmax)
+{
+    if (mode == PROGRAMMABLE_BLEND_MIN || mode == PROGRAMMABLE_BLEND_MAX)
+        return minmax;
+    return programmableBlendEquations[mode] != 0;
+}
+
+int programmable_blend_hardware_supports(ProgrammableBlendMode mode)
+{
+    return programmable_blend_supported(mode, glfwExtensionSupported("GL_EXT_blend_minmax"));
+}
+
+// ---------------------------------------------------------------------------
+// Programs
+
+// The composite program of mode, with BLEND_MODE defined.
+static GLuint programmable_blend_create_program(int mode)
+{
+    char defines[32];
+    snprintf(defines, sizeof(defines), "#define BLEND_MODE %d\n", mode);
+    char *text = shader_program_insert_defines(shader_programmable_blend_frag.source, defines);
+    if (!text)
+        return 0;
+    GLuint program = shader_program_create(shader_texture_quad_vert.source, text, "aPosition");
+    free(text);
+    if (!program)
+        return 0;
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uSource"), 0);
+    glUniform1i(glGetUniformLocation(program, "uDestination"), 1);
+    return program;
+}
+
+static int programmable_blend_create_programs(ProgrammableBlend *blend)
+{
+    GLint program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    int complete = 1;
+    for (int mode = 0; mode <= PROGRAMMABLE_BLEND_COPY && complete; ++mode)
+    {
+        blend->programs[mode] = programmable_blend_create_program(mode);
+        complete = blend->programs[mode] != 0;
+    }
+    glUseProgram((GLuint)program);
+    if (!complete)
+        return 0;
+    blend->buffer = gl_pass_create_triangle();
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Images
+
+static int programmable_blend_create_target(ProgrammableBlend *blend, GLuint framebuffer, GLuint texture)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, blend->width, blend->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    // Read texel for pixel
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, blend->stencilBuffer);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static int programmable_blend_create_targets(ProgrammableBlend *blend)
+{
+    GLint texture, renderbuffer, framebuffer;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGenFramebuffers(2, blend->framebuffers);
+    glGenTextures(2, blend->textures);
+    glGenFramebuffers(1, &blend->layerFramebuffer);
+    glGenTextures(1, &blend->layerTexture);
+    glGenRenderbuffers(1, &blend->stencilBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, blend->stencilBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, blend->width, blend->height);
+    int complete = programmable_blend_create_target(blend, blend->framebuffers[0], blend->textures[0]) &&
+                   programmable_blend_create_target(blend, blend->framebuffers[1], blend->textures[1]) &&
+                   programmable_blend_create_target(blend, blend->layerFramebuffer, blend->layerTexture);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)texture);
+    glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)renderbuffer);
+    return complete && programmable_blend_create_programs(blend);
+}
+
+static void programmable_blend_delete_targets(ProgrammableBlend *blend)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (blend->framebuffers[i])
+            glDeleteFramebuffers(1, &blend->framebuffers[i]);
+        if (blend->textures[i])
+            glDeleteTextures(1, &blend->textures[i]);
+    }
+    if (blend->layerFramebuffer)
+        glDeleteFramebuffers(1, &blend->layerFramebuffer);
+    if (blend->layerTexture)
+        glDeleteTextures(1, &blend->layerTexture);
+    if (blend->stencilBuffer)
+        glDeleteRenderbuffers(1, &blend->stencilBuffer);
+    for (int mode = 0; mode <= PROGRAMMABLE_BLEND_COPY; ++mode)
+    {
+        if (blend->programs[mode])
+            glDeleteProgram(blend->programs[mode]);
+    }
+    if (blend->buffer)
+        glDeleteBuffers(1, &blend->buffer);
+}
+
+// ---------------------------------------------------------------------------
+// State
+
+static void programmable_blend_set_enabled(GLenum cap, GLboolean enabled)
+{
+    if (enabled)
+        glEnable(cap);
+    else
+        glDisable(cap);
+}
+
+static void programmable_blend_save_draw_state(ProgrammableBlendDrawState *state)
+{
+    state->blend = glIsEnabled(GL_BLEND);
+    state->stencil = glIsEnabled(GL_STENCIL_TEST);
+    state->scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glGetIntegerv(GL_BLEND_EQUATION_RGB, &state->equationRgb);
+    glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &state->equationAlpha);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &state->srcRgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &state->dstRgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &state->srcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &state->dstAlpha);
+    glGetIntegerv(GL_STENCIL_FUNC, &state->stencilFunc);
+    glGetIntegerv(GL_STENCIL_REF, &state->stencilRef);
+    glGetIntegerv(GL_STENCIL_VALUE_MASK, &state->stencilValueMask);
+    glGetIntegerv(GL_STENCIL_WRITEMASK, &state->stencilWriteMask);
+    glGetIntegerv(GL_STENCIL_FAIL, &state->stencilFail);
+    glGetIntegerv(GL_STENCIL_PASS_DEPTH_FAIL, &state->stencilDepthFail);
+    glGetIntegerv(GL_STENCIL_PASS_DEPTH_PASS, &state->stencilPass);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, state->clearColor);
+    glGetIntegerv(GL_STENCIL_CLEAR_VALUE, &state->clearStencil);
+    glGetBooleanv(GL_COLOR_WRITEMASK, state->colorMask);
+}
+
+static void programmable_blend_restore_draw_state(const ProgrammableBlendDrawState *state)
+{
+    programmable_blend_set_enabled(GL_BLEND, state->blend);
+    programmable_blend_set_enabled(GL_STENCIL_TEST, state->stencil);
+    programmable_blend_set_enabled(GL_SCISSOR_TEST, state->scissor);
+    glBlendEquationSeparate((GLenum)state->equationRgb, (GLenum)state->equationAlpha);
+    glBlendFuncSeparate((GLenum)state->srcRgb, (GLenum)state->dstRgb, (GLenum)state->srcAlpha,
+                        (GLenum)state->dstAlpha);
+    glStencilFunc((GLenum)state->stencilFunc, state->stencilRef, (GLuint)state->stencilValueMask);
+    glStencilMask((GLuint)state->stencilWriteMask);
+    glStencilOp((GLenum)state->stencilFail, (GLenum)state->stencilDepthFail, (GLenum)state->stencilPass);
+    glClearColor(state->clearColor[0], state->clearColor[1], state->clearColor[2], state->clearColor[3]);
+    glClearStencil(state->clearStencil);
+    glColorMask(state->colorMask[0], state->colorMask[1], state->colorMask[2], state->colorMask[3]);
+}
+
+// Draws the full-screen triangle with program, reading source on unit 0 and
+// destination on unit 1.
+static void programmable_blend_pass(ProgrammableBlend *blend, GLuint program, GLuint source, GLuint destination)
+{
+    glUseProgram(program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, destination);
+    gl_pass_draw(blend->buffer);
+}
+
+// Writes the layer blended with the current image where the layer's draws
+// marked the stencil, and the current image elsewhere, into the other image.
+static void programmable_blend_composite(ProgrammableBlend *blend)
+{
+    GlPassState state;
+    gl_pass_save_state(&state);
+    int next = 1 - blend->current;
+    glBindFramebuffer(GL_FRAMEBUFFER, blend->framebuffers[next]);
+    gl_pass_set_state(blend->width, blend->height);
+    glEnable(GL_STENCIL_TEST);
+    glStencilMask(0);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glStencilFunc(GL_EQUAL, 1, 0xff);
+    programmable_blend_pass(blend, blend->programs[blend->mode], blend->layerTexture, blend->textures[blend->current]);
+    glStencilFunc(GL_NOTEQUAL, 1, 0xff);
+    programmable_blend_pass(blend, blend->programs[PROGRAMMABLE_BLEND_COPY], blend->layerTexture,
+                            blend->textures[blend->current]);
+    gl_pass_restore_state(&state);
+    blend->current = next;
+    ++blend->layerCount;
+}
+
+// ---------------------------------------------------------------------------
+// API
+
+ProgrammableBlend *programmable_blend_create(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+    ProgrammableBlend *blend = (ProgrammableBlend *)calloc(1, sizeof(ProgrammableBlend));
+    if (!blend)
+        return NULL;
+    blend->width = width;
+    blend->height = height;
+    blend->hardware = 1;
+    blend->minmax = glfwExtensionSupported("GL_EXT_blend_minmax");
+    if (!programmable_blend_create_targets(blend))
+    {
+        programmable_blend_delete_targets(blend);
+        free(blend);
+        printf("INFO: programmable_blend: offscreen framebuffers with stencil unavailable\n");
+        return NULL;
+    }
+    printf("INFO: programmable_blend: %dx%d images, min and max %s\n", width, height,
+           blend->minmax ? "by GL_EXT_blend_minmax" : "in the shader");
+    return blend;
+}
+
+void programmable_blend_destroy(ProgrammableBlend *blend)
+{
+    if (!blend)
+        return;
+    programmable_blend_delete_targets(blend);
+    free(blend);
+}
+
+void programmable_blend_use_hardware(ProgrammableBlend *blend, int enabled)
+{
+    if (blend)
+        blend->hardware = enabled;
+}
+
+void programmable_blend_begin(ProgrammableBlend *blend)
+{
+    if (!blend)
+        return;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &blend->outerFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, blend->framebuffers[blend->current]);
+}
+
+void programmable_blend_end(ProgrammableBlend *blend)
+{
+    if (!blend)
+        return;
+    GlPassState state;
+    gl_pass_save_state(&state);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)blend->outerFramebuffer);
+    gl_pass_set_state(blend->width, blend->height);
+    PROFILE_CALL(programmable_blend_pass(blend, blend->programs[PROGRAMMABLE_BLEND_COPY],
+                                         blend->textures[blend->current], blend->textures[blend->current]));
+    gl_pass_restore_state(&state);
+}
+
+void programmable_blend_draw_begin(ProgrammableBlend *blend, ProgrammableBlendMode mode)
+{
+    if (!blend)
+        return;
+    blend->mode = mode;
+    programmable_blend_save_draw_state(&blend->drawState);
+    blend->layered = !blend->hardware || !programmable_blend_supported(mode, blend->minmax);
+    if (!blend->layered)
+    {
+        glEnable(GL_BLEND);
+        glBlendEquation(programmableBlendEquations[mode]);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        return;
+    }
+    // A cleared layer, with the stencil marking what the draws cover
+    glBindFramebuffer(GL_FRAMEBUFFER, blend->layerFramebuffer);
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilMask(0xff);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClearStencil(0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glColorMask(blend->drawState.colorMask[0], blend->drawState.colorMask[1], blend->drawState.colorMask[2],
+                blend->drawState.colorMask[3]);
+    programmable_blend_set_enabled(GL_SCISSOR_TEST, blend->drawState.scissor);
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 1, 0xff);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+}
+
+void programmable_blend_draw_end(ProgrammableBlend *blend)
+{
+    if (!blend)
+        return;
+    if (blend->layered)
+    {
+        PROFILE_CALL(programmable_blend_composite(blend));
+        glBindFramebuffer(GL_FRAMEBUFFER, blend->framebuffers[blend->current]);
+        blend->layered = 0;
+    }
+    programmable_blend_restore_draw_state(&blend->drawState);
+}
+
+unsigned long long programmable_blend_layer_count(const ProgrammableBlend *blend)
+{
+    return blend ? blend->layerCount : 0;
+}
@@ -0,0 +1,101 @@
+// sample_clock.c
+// The virtual modes compute the time as frame * step rather than summing
+// the steps, so long runs do not drift and every run sees the same values.
+#include "common/sample_clock.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double sample_clock_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sample_clock_sleep_until(double deadline)
+{
+    double remaining = deadline - sample_clock_seconds();
+    if (remaining <= 0.0)
+        return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)remaining;
+    ts.tv_nsec = (long)((remaining - (double)ts.tv_sec) * 1e9);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+void sample_clock_init(SampleClock *clock, SampleClockMode mode, double step)
+{
+    memset(clock, 0, sizeof(*clock));
+    clock->mode = mode;
+    clock->step = step > 0.0 ? step : 1.0 / 60.0;
+}
+
+void sample_clock_init_from_env(SampleClock *clock)
+{
+    SampleClockMode mode = SAMPLE_CLOCK_REAL;
+    double step = 0.0;
+    const char *value = getenv("SAMPLES_CLOCK");
+    if (value && *value)
+    {
+        size_t length = strcspn(value, ":");
+        if (length == 4 && strncmp(value, "real", 4) == 0)
+            mode = SAMPLE_CLOCK_REAL;
+        else if (length == 5 && strncmp(value, "fixed", 5) == 0)
+            mode = SAMPLE_CLOCK_FIXED;
+        else if (length == 4 && strncmp(value, "fast", 4) == 0)
+            mode = SAMPLE_CLOCK_FAST;
+        else
+            printf("ERROR: unknown SAMPLES_CLOCK mode '%s', using real time\n", value);
+        if (value[length] == ':')
+        {
+            step = atof(value + length + 1);
+            if (step <= 0.0)
+                printf("ERROR: invalid SAMPLES_CLOCK step '%s', using 1/60 s\n", value + length + 1);
+        }
+    }
+    sample_clock_init(clock, mode, step);
+    const char *frames = getenv("SAMPLES_FRAMES");
+    if (frames)
+        clock->frameLimit = strtoull(frames, NULL, 10);
+}
+
+void sample_clock_tick(SampleClock *clock)
+{
+    double now = sample_clock_seconds();
+    if (!clock->started)
+    {
+        clock->start = now;
+        clock->started = 1;
+        clock->time = 0.0;
+        clock->delta = 0.0;
+        clock->frame = 0;
+        return;
+    }
+    double previous = clock->time;
+    clock->frame++;
+    if (clock->mode == SAMPLE_CLOCK_REAL)
+        clock->time = now - clock->start;
+    else
+    {
+        clock->time = (double)clock->frame * clock->step;
+        if (clock->mode == SAMPLE_CLOCK_FIXED)
+            sample_clock_sleep_until(clock->start + clock->time);
+    }
+    clock->delta = clock->time - previous;
+}
+
+int sample_clock_done(const SampleClock *clock)
+{
+    return clock->frameLimit && clock->started && clock->frame + 1 >= clock->frameLimit;
+}
+
+int sample_clock_swap_interval(const SampleClock *clock)
+{
+    return clock->mode == SAMPLE_CLOCK_FAST ? 0 : 1;
+}
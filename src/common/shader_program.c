@@ -0,0 +1,139 @@
+// shader_program.c
+// See shader_program.h.
+#include "common/shader_program.h"
+#include "common/profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Prints the info log of shader (isProgram 0) or program (isProgram 1).
+static void shader_program_print_log(GLuint object, int isProgram, const char *what)
+{
+    GLint logLength = 0;
+    if (isProgram)
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &logLength);
+    else
+        glGetShaderiv(object, GL_INFO_LOG_LENGTH, &logLength);
+    char *infoLog = (char *)malloc(logLength > 0 ? (size_t)logLength : 1);
+    if (!infoLog)
+    {
+        printf("ERROR: %s failed. (Could not allocate infoLog)\n", what);
+        return;
+    }
+    infoLog[0] = '\0';
+    if (isProgram)
+        glGetProgramInfoLog(object, logLength, NULL, infoLog);
+    else
+        glGetShaderInfoLog(object, logLength, NULL, infoLog);
+    printf("ERROR: %s failed: %s\n", what, infoLog);
+    free(infoLog);
+}
+
+// Compiles source; a failure prints its log when report is set.
+static GLuint shader_program_compile_stage(GLenum type, const char *source, int report)
+{
+    GLuint shader = glCreateShader(type);
+    if (!shader)
+    {
+        printf("ERROR: Failed to create shader object\n");
+        return 0;
+    }
+    glShaderSource(shader, 1, &source, NULL);
+    PROFILE_CALL(glCompileShader(shader));
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        if (report)
+            shader_program_print_log(shader, 0, type == GL_VERTEX_SHADER ? "Vertex shader compilation"
+                                                                         : "Fragment shader compilation");
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint shader_program_compile(GLenum type, const char *source)
+{
+    return shader_program_compile_stage(type, source, 1);
+}
+
+// Links the two shaders, which are kept; a failure prints its log when
+// report is set.
+static GLuint shader_program_link_stages(GLuint vertexShader, GLuint fragmentShader, const char *attribute,
+                                         int report)
+{
+    GLuint program = glCreateProgram();
+    if (!program)
+    {
+        printf("ERROR: Failed to create shader program\n");
+        return 0;
+    }
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    if (attribute)
+        glBindAttribLocation(program, 0, attribute);
+    PROFILE_CALL(glLinkProgram(program));
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        if (report)
+            shader_program_print_log(program, 1, "Program linking");
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+GLuint shader_program_link(GLuint vertexShader, GLuint fragmentShader, const char *attribute)
+{
+    return shader_program_link_stages(vertexShader, fragmentShader, attribute, 1);
+}
+
+static GLuint shader_program_build(const char *vertexSource, const char *fragmentSource, const char *attribute,
+                                   int report)
+{
+    GLuint vertexShader = shader_program_compile_stage(GL_VERTEX_SHADER, vertexSource, report);
+    GLuint fragmentShader =
+        vertexShader ? shader_program_compile_stage(GL_FRAGMENT_SHADER, fragmentSource, report) : 0;
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        return 0;
+    }
+    GLuint program = shader_program_link_stages(vertexShader, fragmentShader, attribute, report);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+GLuint shader_program_create(const char *vertexSource, const char *fragmentSource, const char *attribute)
+{
+    return shader_program_build(vertexSource, fragmentSource, attribute, 1);
+}
+
+GLuint shader_program_try_create(const char *vertexSource, const char *fragmentSource, const char *attribute)
+{
+    return shader_program_build(vertexSource, fragmentSource, attribute, 0);
+}
+
+char *shader_program_insert_defines(const char *source, const char *defines)
+{
+    // #version must stay the first line
+    const char *body = source;
+    if (strncmp(source, "#version", 8) == 0)
+    {
+        body = strchr(source, '\n');
+        body = body ? body + 1 : source + strlen(source);
+    }
+    size_t size = strlen(source) + strlen(defines) + 2;
+    char *text = (char *)malloc(size);
+    if (!text)
+        return NULL;
+    // A #version line without a newline gets one
+    snprintf(text, size, "%.*s%s%s%s", (int)(body - source), source, body > source && body[-1] != '\n' ? "\n" : "",
+             defines, body);
+    return text;
+}
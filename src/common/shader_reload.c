@@ -0,0 +1,523 @@
+// shader_reload.c
+// The worker thread owns the inotify descriptor, the compiled stages and a
+// hidden window whose context shares objects with the sample's. Finished
+// programs are handed to the render thread through one atomic program name
+// per watched program, so the frame boundary never waits for the worker.
+#include "common/shader_reload.h"
+#include "common/profiler.h"
+
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+#define SHADER_RELOAD_MAX_STAGES 32
+#define SHADER_RELOAD_MAX_PROGRAMS 16
+// Editors save in several steps; changes are built once the files have
+// been quiet for this long
+#define SHADER_RELOAD_SETTLE_MS 50
+
+typedef struct ShaderReloadStage
+{
+    const ShaderSource *shader;
+    char path[PATH_MAX];
+    const char *file; // name within the watched directory
+    int watch;        // inotify watch of the directory
+    char *text;       // source of the last good compile; NULL: still the embedded one
+    GLuint object;    // compiled in the building context, 0 until a program needs it
+    atomic_int dirty;
+} ShaderReloadStage;
+
+typedef struct ShaderReloadProgram
+{
+    GLuint *program;
+    int stages[2]; // vertex, fragment
+    ShaderReloadCallback reloaded;
+    void *userData;
+    GLuint latest;        // building side: newest program, in use or pending
+    atomic_uint pending;  // linked, waiting for the frame boundary
+} ShaderReloadProgram;
+
+struct ShaderReloader
+{
+    GLFWwindow *worker; // NULL: programs are rebuilt on the render thread
+    char directory[PATH_MAX];
+    int inotifyFd;
+    int wakeFds[2];
+    pthread_t thread;
+    int threadStarted;
+    atomic_int quit;
+    atomic_int changed; // render-thread mode: settled changes to build
+
+    pthread_mutex_t lock; // stages and programs, between watch and the builder
+    ShaderReloadStage stages[SHADER_RELOAD_MAX_STAGES];
+    int stageCount;
+    ShaderReloadProgram programs[SHADER_RELOAD_MAX_PROGRAMS];
+    int programCount;
+};
+
+static double shader_reload_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static char *read_text(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = size >= 0 ? (char *)malloc((size_t)size + 1) : NULL;
+    if (text && fread(text, 1, (size_t)size, file) != (size_t)size)
+    {
+        free(text);
+        text = NULL;
+    }
+    if (text)
+        text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+static const char *stage_source(const ShaderReloadStage *stage)
+{
+    return stage->text ? stage->text : stage->shader->source;
+}
+
+// ---------------------------------------------------------------------------
+// Building, with the worker's context (or the window's) current
+
+static GLuint compile_stage(const ShaderReloadStage *stage, const char *source)
+{
+    GLenum type = stage->shader->stage == SHADER_STAGE_VERTEX ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER;
+    GLuint object = glCreateShader(type);
+    glShaderSource(object, 1, &source, NULL);
+    PROFILE_CALL(glCompileShader(object));
+    GLint compiled;
+    glGetShaderiv(object, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        char infoLog[1024] = "";
+        glGetShaderInfoLog(object, sizeof(infoLog), NULL, infoLog);
+        printf("ERROR: shader reload: %s does not compile, keeping the old program:\n%s\n", stage->path, infoLog);
+        glDeleteShader(object);
+        return 0;
+    }
+    return object;
+}
+
+// The new program gets the attribute locations of the one it replaces, so
+// vertex setup done against the old program stays valid.
+static void bind_attributes(GLuint from, GLuint to)
+{
+    GLint count = 0;
+    glGetProgramiv(from, GL_ACTIVE_ATTRIBUTES, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        char name[128];
+        GLint size;
+        GLenum type;
+        glGetActiveAttrib(from, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+        GLint location = glGetAttribLocation(from, name);
+        if (location >= 0)
+            glBindAttribLocation(to, (GLuint)location, name);
+    }
+}
+
+static void build_program(ShaderReloader *reloader, ShaderReloadProgram *program)
+{
+    ShaderReloadStage *vertex = &reloader->stages[program->stages[0]];
+    ShaderReloadStage *fragment = &reloader->stages[program->stages[1]];
+    // The stage that did not change is compiled once, the first time one
+    // of its programs is rebuilt
+    if (!vertex->object)
+        vertex->object = compile_stage(vertex, stage_source(vertex));
+    if (!fragment->object)
+        fragment->object = compile_stage(fragment, stage_source(fragment));
+    if (!vertex->object || !fragment->object)
+        return;
+
+    double start = shader_reload_seconds();
+    GLuint linked = glCreateProgram();
+    glAttachShader(linked, vertex->object);
+    glAttachShader(linked, fragment->object);
+    bind_attributes(program->latest, linked);
+    PROFILE_CALL(glLinkProgram(linked));
+    GLint success;
+    glGetProgramiv(linked, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[1024] = "";
+        glGetProgramInfoLog(linked, sizeof(infoLog), NULL, infoLog);
+        printf("ERROR: shader reload: %s and %s do not link, keeping the old program:\n%s\n", vertex->path,
+               fragment->path, infoLog);
+        glDeleteProgram(linked);
+        return;
+    }
+    if (reloader->worker)
+    {
+        // Drivers may finish compiling at the first draw; do that here, into
+        // the hidden window, and wait for it, since the render thread's
+        // context only sees the program complete after a glFinish
+        glUseProgram(linked);
+        glDrawArrays(GL_POINTS, 0, 1);
+        glUseProgram(0);
+        glFinish();
+    }
+    printf("INFO: shader reload: %s + %s rebuilt in %.1f ms\n", vertex->shader->name, fragment->shader->name,
+           (shader_reload_seconds() - start) * 1000.0);
+    program->latest = linked;
+    // A program the render thread has not picked up yet was never used
+    GLuint replaced = atomic_exchange(&program->pending, linked);
+    if (replaced)
+        glDeleteProgram(replaced);
+}
+
+// Compiles the stages whose files changed and relinks their programs.
+static void build_changes(ShaderReloader *reloader)
+{
+    int rebuild[SHADER_RELOAD_MAX_PROGRAMS] = {0};
+    pthread_mutex_lock(&reloader->lock);
+    for (int i = 0; i < reloader->stageCount; ++i)
+    {
+        ShaderReloadStage *stage = &reloader->stages[i];
+        if (!atomic_exchange(&stage->dirty, 0))
+            continue;
+        char *text = read_text(stage->path);
+        if (!text)
+        {
+            printf("ERROR: shader reload: cannot read %s\n", stage->path);
+            continue;
+        }
+        // Saving without changes, or a second event for the same save
+        if (stage->text && strcmp(text, stage->text) == 0)
+        {
+            free(text);
+            continue;
+        }
+        GLuint object = compile_stage(stage, text);
+        if (!object)
+        {
+            free(text);
+            continue;
+        }
+        glDeleteShader(stage->object);
+        stage->object = object;
+        free(stage->text);
+        stage->text = text;
+        for (int j = 0; j < reloader->programCount; ++j)
+            rebuild[j] |= reloader->programs[j].stages[0] == i || reloader->programs[j].stages[1] == i;
+    }
+    for (int j = 0; j < reloader->programCount; ++j)
+    {
+        if (rebuild[j])
+            build_program(reloader, &reloader->programs[j]);
+    }
+    pthread_mutex_unlock(&reloader->lock);
+}
+
+// ---------------------------------------------------------------------------
+// Watching
+
+#if defined(__linux__)
+static void *shader_reload_thread(void *userData)
+{
+    ShaderReloader *reloader = (ShaderReloader *)userData;
+    PROFILE_THREAD_NAME("shader reload");
+    if (reloader->worker)
+        glfwMakeContextCurrent(reloader->worker);
+    int settling = 0;
+    while (!atomic_load(&reloader->quit))
+    {
+        struct pollfd fds[2] = {{reloader->inotifyFd, POLLIN, 0}, {reloader->wakeFds[0], POLLIN, 0}};
+        int ready = poll(fds, 2, settling ? SHADER_RELOAD_SETTLE_MS : -1);
+        if (ready == 0 && settling)
+        {
+            settling = 0;
+            if (reloader->worker)
+                build_changes(reloader);
+            else
+                atomic_store(&reloader->changed, 1);
+            continue;
+        }
+        if (ready < 0 || !(fds[0].revents & POLLIN))
+            continue;
+        char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length;
+        while ((length = read(reloader->inotifyFd, events, sizeof(events))) > 0)
+        {
+            pthread_mutex_lock(&reloader->lock);
+            for (char *p = events; p < events + length;)
+            {
+                const struct inotify_event *event = (const struct inotify_event *)p;
+                for (int i = 0; i < reloader->stageCount && event->len; ++i)
+                {
+                    ShaderReloadStage *stage = &reloader->stages[i];
+                    if (stage->watch == event->wd && strcmp(stage->file, event->name) == 0)
+                    {
+                        atomic_store(&stage->dirty, 1);
+                        settling = 1;
+                    }
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+            pthread_mutex_unlock(&reloader->lock);
+        }
+    }
+    if (reloader->worker)
+    {
+        for (int i = 0; i < reloader->stageCount; ++i)
+        {
+            glDeleteShader(reloader->stages[i].object);
+            reloader->stages[i].object = 0;
+        }
+        glfwMakeContextCurrent(NULL);
+    }
+    return NULL;
+}
+#endif
+
+ShaderReloader *shader_reload_create_from_env(GLFWwindow *window)
+{
+    const char *value = getenv("SAMPLES_SHADER_RELOAD");
+    if (!value || !*value || strcmp(value, "0") == 0)
+        return NULL;
+#if defined(__linux__)
+    ShaderReloader *reloader = (ShaderReloader *)calloc(1, sizeof(ShaderReloader));
+    if (!reloader)
+        return NULL;
+    if (strcmp(value, "1") != 0 &&
+        snprintf(reloader->directory, sizeof(reloader->directory), "%s", value) >= (int)sizeof(reloader->directory))
+    {
+        printf("ERROR: shader reload: the directory %s is too long\n", value);
+        free(reloader);
+        return NULL;
+    }
+    pthread_mutex_init(&reloader->lock, NULL);
+    reloader->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (reloader->inotifyFd < 0 || pipe(reloader->wakeFds) != 0)
+    {
+        printf("ERROR: shader reload: cannot watch files\n");
+        if (reloader->inotifyFd >= 0)
+            close(reloader->inotifyFd);
+        pthread_mutex_destroy(&reloader->lock);
+        free(reloader);
+        return NULL;
+    }
+
+    // The hidden window only provides the worker's context
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    reloader->worker = glfwCreateWindow(1, 1, "shader reload", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!reloader->worker)
+        printf("INFO: shader reload: contexts cannot share objects here, programs are rebuilt on the render "
+               "thread\n");
+    reloader->threadStarted = pthread_create(&reloader->thread, NULL, shader_reload_thread, reloader) == 0;
+    if (!reloader->threadStarted)
+    {
+        printf("ERROR: shader reload: cannot start the worker thread\n");
+        shader_reload_destroy(reloader);
+        return NULL;
+    }
+    return reloader;
+#else
+    (void)window;
+    printf("ERROR: SAMPLES_SHADER_RELOAD needs inotify (Linux)\n");
+    return NULL;
+#endif
+}
+
+void shader_reload_destroy(ShaderReloader *reloader)
+{
+    if (!reloader)
+        return;
+    if (reloader->threadStarted)
+    {
+        atomic_store(&reloader->quit, 1);
+        if (write(reloader->wakeFds[1], "q", 1) < 0)
+            printf("ERROR: shader reload: cannot stop the worker thread\n");
+        pthread_join(reloader->thread, NULL);
+    }
+    if (reloader->worker)
+        glfwDestroyWindow(reloader->worker);
+    for (int i = 0; i < reloader->programCount; ++i)
+        glDeleteProgram(atomic_exchange(&reloader->programs[i].pending, 0));
+    for (int i = 0; i < reloader->stageCount; ++i)
+    {
+        // Render-thread mode compiled them in this context
+        glDeleteShader(reloader->stages[i].object);
+        free(reloader->stages[i].text);
+    }
+    close(reloader->inotifyFd);
+    close(reloader->wakeFds[0]);
+    close(reloader->wakeFds[1]);
+    pthread_mutex_destroy(&reloader->lock);
+    free(reloader);
+}
+
+// Returns the stage of shader, adding and watching it the first time.
+static int watch_stage(ShaderReloader *reloader, const ShaderSource *shader)
+{
+    for (int i = 0; i < reloader->stageCount; ++i)
+    {
+        if (reloader->stages[i].shader == shader)
+            return i;
+    }
+    if (reloader->stageCount == SHADER_RELOAD_MAX_STAGES)
+        return -1;
+    ShaderReloadStage *stage = &reloader->stages[reloader->stageCount];
+    stage->shader = shader;
+    int length;
+    if (reloader->directory[0])
+        length = snprintf(stage->path, sizeof(stage->path), "%s/%s.glsl", reloader->directory, shader->name);
+    else
+        length = snprintf(stage->path, sizeof(stage->path), "%s", shader->path);
+    if (length < 0 || (size_t)length >= sizeof(stage->path))
+    {
+        printf("ERROR: shader reload: the path of %s is longer than %d characters\n", shader->name, PATH_MAX - 1);
+        return -1;
+    }
+    char directory[PATH_MAX];
+    snprintf(directory, sizeof(directory), "%s", stage->path);
+    char *slash = strrchr(directory, '/');
+    stage->file = strrchr(stage->path, '/') ? strrchr(stage->path, '/') + 1 : stage->path;
+    if (slash)
+        *slash = '\0';
+    else
+        snprintf(directory, sizeof(directory), ".");
+#if defined(__linux__)
+    // One watch per directory; inotify returns the same descriptor again
+    stage->watch = inotify_add_watch(reloader->inotifyFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+#else
+    stage->watch = -1;
+#endif
+    if (stage->watch < 0)
+    {
+        printf("ERROR: shader reload: cannot watch %s\n", directory);
+        return -1;
+    }
+    printf("INFO: shader reload: watching %s\n", stage->path);
+    return reloader->stageCount++;
+}
+
+void shader_reload_watch(ShaderReloader *reloader, GLuint *program, const ShaderSource *vertex,
+                         const ShaderSource *fragment, ShaderReloadCallback reloaded, void *userData)
+{
+    if (!reloader)
+        return;
+    pthread_mutex_lock(&reloader->lock);
+    int vertexStage = watch_stage(reloader, vertex);
+    int fragmentStage = watch_stage(reloader, fragment);
+    if (vertexStage >= 0 && fragmentStage >= 0 && reloader->programCount < SHADER_RELOAD_MAX_PROGRAMS)
+    {
+        ShaderReloadProgram *entry = &reloader->programs[reloader->programCount++];
+        entry->program = program;
+        entry->stages[0] = vertexStage;
+        entry->stages[1] = fragmentStage;
+        entry->reloaded = reloaded;
+        entry->userData = userData;
+        entry->latest = *program;
+    }
+    pthread_mutex_unlock(&reloader->lock);
+}
+
+// ---------------------------------------------------------------------------
+// Frame boundary
+
+// Copies the values of the uniforms both programs declare; to must be the
+// current program.
+static void copy_uniforms(GLuint from, GLuint to)
+{
+    GLint count = 0, targetCount = 0;
+    glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(to, GL_ACTIVE_UNIFORMS, &targetCount);
+    for (GLint i = 0; i < count; ++i)
+    {
+        char name[128], targetName[128];
+        GLint size, targetSize;
+        GLenum type, targetType;
+        glGetActiveUniform(from, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+        int found = 0;
+        for (GLint j = 0; j < targetCount && !found; ++j)
+        {
+            glGetActiveUniform(to, (GLuint)j, sizeof(targetName), NULL, &targetSize, &targetType, targetName);
+            found = targetType == type && strcmp(targetName, name) == 0;
+        }
+        if (!found)
+            continue;
+        // Arrays are reported as name[0]; their elements are copied one by one
+        char *bracket = strchr(name, '[');
+        if (bracket)
+            *bracket = '\0';
+        for (GLint element = 0; element < (size < targetSize ? size : targetSize); ++element)
+        {
+            char elementName[160];
+            if (bracket)
+                snprintf(elementName, sizeof(elementName), "%s[%d]", name, element);
+            else
+                snprintf(elementName, sizeof(elementName), "%s", name);
+            GLint source = glGetUniformLocation(from, elementName);
+            GLint target = glGetUniformLocation(to, elementName);
+            if (source < 0 || target < 0)
+                continue;
+            GLfloat f[16];
+            GLint n[4];
+            switch (type)
+            {
+            case GL_FLOAT: glGetUniformfv(from, source, f); glUniform1fv(target, 1, f); break;
+            case GL_FLOAT_VEC2: glGetUniformfv(from, source, f); glUniform2fv(target, 1, f); break;
+            case GL_FLOAT_VEC3: glGetUniformfv(from, source, f); glUniform3fv(target, 1, f); break;
+            case GL_FLOAT_VEC4: glGetUniformfv(from, source, f); glUniform4fv(target, 1, f); break;
+            case GL_FLOAT_MAT2: glGetUniformfv(from, source, f); glUniformMatrix2fv(target, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3: glGetUniformfv(from, source, f); glUniformMatrix3fv(target, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4: glGetUniformfv(from, source, f); glUniformMatrix4fv(target, 1, GL_FALSE, f); break;
+            case GL_INT_VEC2:
+            case GL_BOOL_VEC2: glGetUniformiv(from, source, n); glUniform2iv(target, 1, n); break;
+            case GL_INT_VEC3:
+            case GL_BOOL_VEC3: glGetUniformiv(from, source, n); glUniform3iv(target, 1, n); break;
+            case GL_INT_VEC4:
+            case GL_BOOL_VEC4: glGetUniformiv(from, source, n); glUniform4iv(target, 1, n); break;
+            default: // int, bool and samplers
+                glGetUniformiv(from, source, n);
+                glUniform1iv(target, 1, n);
+                break;
+            }
+        }
+    }
+}
+
+void shader_reload_update(ShaderReloader *reloader)
+{
+    if (!reloader)
+        return;
+    if (!reloader->worker && atomic_exchange(&reloader->changed, 0))
+        build_changes(reloader);
+    for (int i = 0; i < reloader->programCount; ++i)
+    {
+        ShaderReloadProgram *entry = &reloader->programs[i];
+        GLuint program = atomic_exchange(&entry->pending, 0);
+        if (!program)
+            continue;
+        GLint current;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        glUseProgram(program);
+        copy_uniforms(*entry->program, program);
+        glUseProgram((GLuint)current == *entry->program ? program : (GLuint)current);
+        glDeleteProgram(*entry->program);
+        *entry->program = program;
+        if (entry->reloaded)
+            entry->reloaded(program, entry->userData);
+    }
+}
@@ -0,0 +1,310 @@
+// transparency_sort.c
+// Depth keys, the parallel LSD radix sort and the index rewrite. See
+// transparency_sort.h.
+//
+// Every call runs one job on the calling thread and threadCount - 1
+// started for it. Each thread owns a contiguous part of the triangles in
+// every step; the steps are separated by a barrier. A key and its triangle
+// number travel together as one 64-bit item, the key in the upper half.
+#include "common/transparency_sort.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TRANSPARENCY_SORT_MAX_THREADS 32
+// Fewer triangles per thread are not worth starting a thread for
+#define TRANSPARENCY_SORT_MIN_THREAD_TRIANGLES 32768
+#define TRANSPARENCY_SORT_DIGIT_BITS 8
+#define TRANSPARENCY_SORT_RADIX (1 << TRANSPARENCY_SORT_DIGIT_BITS)
+#define TRANSPARENCY_SORT_PASSES (32 / TRANSPARENCY_SORT_DIGIT_BITS)
+
+typedef uint32_t TransparencySortCounts[TRANSPARENCY_SORT_RADIX];
+
+struct TransparencySort
+{
+    size_t capacity;
+    int threadCount;
+    uint64_t *items[2];
+    // Digit counts of every pass and thread, so that a thread can count the
+    // next pass while another still reads the counts of this one
+    TransparencySortCounts *counts;
+    TransparencySortTimings timings;
+};
+
+typedef struct TransparencySortJob
+{
+    TransparencySort *sort;
+    const float *centres;
+    size_t count;
+    float depthRow[4];
+    const GLuint *sourceIndices;
+    GLuint *indices;
+    int threadCount;
+    pthread_mutex_t startLock;
+    pthread_cond_t startCondition;
+    int ready;
+    pthread_barrier_t barrier;
+    double keysDone; // seconds, recorded by thread 0
+    double sortDone;
+    int passes;
+} TransparencySortJob;
+
+typedef struct TransparencySortWorker
+{
+    TransparencySortJob *job;
+    int thread;
+} TransparencySortWorker;
+
+static double transparency_sort_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Unsigned order of the result is the reverse float order: farthest first.
+static uint32_t transparency_sort_key(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    uint32_t mask = (uint32_t)((int32_t)bits >> 31) | 0x80000000u;
+    return ~(bits ^ mask);
+}
+
+static void transparency_sort_make_keys(const TransparencySortJob *job, size_t begin, size_t end, uint64_t *items)
+{
+    const float *row = job->depthRow;
+    size_t i = begin;
+#if defined(__SSE2__)
+    const __m128 r0 = _mm_set1_ps(row[0]), r1 = _mm_set1_ps(row[1]), r2 = _mm_set1_ps(row[2]);
+    const __m128 r3 = _mm_set1_ps(row[3]);
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    const __m128i ones = _mm_set1_epi32(-1);
+    __m128i triangles = _mm_setr_epi32((int)i, (int)i + 1, (int)i + 2, (int)i + 3);
+    const __m128i four = _mm_set1_epi32(4);
+    for (; i + 4 <= end; i += 4)
+    {
+        // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 to x, y and z of the 4
+        const float *c = job->centres + i * 3;
+        __m128 a = _mm_loadu_ps(c), b = _mm_loadu_ps(c + 4), d = _mm_loadu_ps(c + 8);
+        __m128 x = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 3, 0)),
+                                  _mm_shuffle_ps(b, d, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)),
+                                  _mm_shuffle_ps(b, d, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                                  _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r0), _mm_mul_ps(y, r1)),
+                                  _mm_add_ps(_mm_mul_ps(z, r2), r3));
+        __m128i bits = _mm_castps_si128(depth);
+        __m128i mask = _mm_or_si128(_mm_srai_epi32(bits, 31), sign);
+        __m128i keys = _mm_xor_si128(_mm_xor_si128(bits, mask), ones);
+        _mm_storeu_si128((__m128i *)(items + i), _mm_unpacklo_epi32(triangles, keys));
+        _mm_storeu_si128((__m128i *)(items + i + 2), _mm_unpackhi_epi32(triangles, keys));
+        triangles = _mm_add_epi32(triangles, four);
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        const float *c = job->centres + i * 3;
+        // Summed as the SSE2 path does, so equal centres get equal keys
+        float depth = (row[0] * c[0] + row[1] * c[1]) + (row[2] * c[2] + row[3]);
+        items[i] = (uint64_t)transparency_sort_key(depth) << 32 | (uint64_t)i;
+    }
+}
+
+static void *transparency_sort_worker(void *userData)
+{
+    TransparencySortWorker *worker = (TransparencySortWorker *)userData;
+    TransparencySortJob *job = worker->job;
+    TransparencySort *sort = job->sort;
+    pthread_mutex_lock(&job->startLock);
+    while (!job->ready)
+        pthread_cond_wait(&job->startCondition, &job->startLock);
+    pthread_mutex_unlock(&job->startLock);
+    const int t = worker->thread;
+    const int threadCount = job->threadCount;
+    const size_t begin = job->count * (size_t)t / (size_t)threadCount;
+    const size_t end = job->count * (size_t)(t + 1) / (size_t)threadCount;
+
+    transparency_sort_make_keys(job, begin, end, sort->items[0]);
+    pthread_barrier_wait(&job->barrier);
+    if (t == 0)
+        job->keysDone = transparency_sort_seconds();
+
+    uint64_t *source = sort->items[0], *destination = sort->items[1];
+    int passes = 0;
+    for (int pass = 0; pass < TRANSPARENCY_SORT_PASSES; ++pass)
+    {
+        const int shift = 32 + pass * TRANSPARENCY_SORT_DIGIT_BITS;
+        TransparencySortCounts *counts = sort->counts + (size_t)pass * TRANSPARENCY_SORT_MAX_THREADS;
+        uint32_t *own = counts[t];
+        memset(own, 0, sizeof(TransparencySortCounts));
+        for (size_t i = begin; i < end; ++i)
+            ++own[(source[i] >> shift) & (TRANSPARENCY_SORT_RADIX - 1)];
+        pthread_barrier_wait(&job->barrier);
+
+        // Where this thread's keys of each digit start: after every key of
+        // a smaller digit and the keys of this digit in earlier parts
+        size_t offsets[TRANSPARENCY_SORT_RADIX];
+        size_t total = 0;
+        int skip = 0;
+        for (int digit = 0; digit < TRANSPARENCY_SORT_RADIX; ++digit)
+        {
+            size_t digitCount = 0, before = 0;
+            for (int other = 0; other < threadCount; ++other)
+            {
+                digitCount += counts[other][digit];
+                if (other < t)
+                    before += counts[other][digit];
+            }
+            skip |= digitCount == job->count;
+            offsets[digit] = total + before;
+            total += digitCount;
+        }
+        if (skip)
+            continue; // every key has this digit; the order stays
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint64_t item = source[i];
+            destination[offsets[(item >> shift) & (TRANSPARENCY_SORT_RADIX - 1)]++] = item;
+        }
+        pthread_barrier_wait(&job->barrier);
+        uint64_t *swap = source;
+        source = destination;
+        destination = swap;
+        ++passes;
+    }
+    if (t == 0)
+    {
+        job->sortDone = transparency_sort_seconds();
+        job->passes = passes;
+    }
+
+    GLuint *indices = job->indices + begin * 3;
+    for (size_t i = begin; i < end; ++i, indices += 3)
+    {
+        GLuint triangle = (GLuint)(source[i] & 0xffffffffu);
+        if (job->sourceIndices)
+        {
+            const GLuint *from = job->sourceIndices + (size_t)triangle * 3;
+            indices[0] = from[0];
+            indices[1] = from[1];
+            indices[2] = from[2];
+        }
+        else
+        {
+            indices[0] = triangle * 3;
+            indices[1] = triangle * 3 + 1;
+            indices[2] = triangle * 3 + 2;
+        }
+    }
+    return NULL;
+}
+
+TransparencySort *transparency_sort_create(size_t capacity, int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    threadCount = threadCount > TRANSPARENCY_SORT_MAX_THREADS ? TRANSPARENCY_SORT_MAX_THREADS : threadCount;
+    TransparencySort *sort = (TransparencySort *)calloc(1, sizeof(TransparencySort));
+    if (!sort)
+        return NULL;
+    sort->capacity = capacity;
+    sort->threadCount = threadCount;
+    sort->items[0] = (uint64_t *)malloc((capacity ? capacity : 1) * sizeof(uint64_t));
+    sort->items[1] = (uint64_t *)malloc((capacity ? capacity : 1) * sizeof(uint64_t));
+    sort->counts = (TransparencySortCounts *)malloc((size_t)TRANSPARENCY_SORT_PASSES * TRANSPARENCY_SORT_MAX_THREADS *
+                                                    sizeof(TransparencySortCounts));
+    if (!sort->items[0] || !sort->items[1] || !sort->counts)
+    {
+        transparency_sort_destroy(sort);
+        return NULL;
+    }
+    return sort;
+}
+
+void transparency_sort_destroy(TransparencySort *sort)
+{
+    if (!sort)
+        return;
+    free(sort->items[0]);
+    free(sort->items[1]);
+    free(sort->counts);
+    free(sort);
+}
+
+void transparency_sort_triangles(TransparencySort *sort, const float *centres, size_t count,
+                                 const float depthRow[4], const GLuint *sourceIndices, GLuint *indices)
+{
+    if (count > sort->capacity)
+        count = sort->capacity;
+    double start = transparency_sort_seconds();
+    TransparencySortJob job;
+    memset(&job, 0, sizeof(job));
+    job.sort = sort;
+    job.centres = centres;
+    job.count = count;
+    memcpy(job.depthRow, depthRow, sizeof(job.depthRow));
+    job.sourceIndices = sourceIndices;
+    job.indices = indices;
+    size_t useful = count / TRANSPARENCY_SORT_MIN_THREAD_TRIANGLES;
+    job.threadCount = useful < (size_t)sort->threadCount ? (int)(useful ? useful : 1) : sort->threadCount;
+
+    // Threads that fail to start leave their parts to the others: the ones
+    // that did start wait until the count is known and the barrier is set up
+    pthread_t threads[TRANSPARENCY_SORT_MAX_THREADS];
+    TransparencySortWorker workers[TRANSPARENCY_SORT_MAX_THREADS];
+    pthread_mutex_init(&job.startLock, NULL);
+    pthread_cond_init(&job.startCondition, NULL);
+    int started = 0;
+    for (; started < job.threadCount - 1; ++started)
+    {
+        workers[started + 1].job = &job;
+        workers[started + 1].thread = started + 1;
+        if (pthread_create(&threads[started], NULL, transparency_sort_worker, &workers[started + 1]) != 0)
+            break;
+    }
+    pthread_mutex_lock(&job.startLock);
+    job.threadCount = started + 1;
+    pthread_barrier_init(&job.barrier, NULL, (unsigned)job.threadCount);
+    job.ready = 1;
+    pthread_cond_broadcast(&job.startCondition);
+    pthread_mutex_unlock(&job.startLock);
+
+    workers[0].job = &job;
+    workers[0].thread = 0;
+    transparency_sort_worker(&workers[0]);
+    for (int t = 0; t < started; ++t)
+        pthread_join(threads[t], NULL);
+    pthread_barrier_destroy(&job.barrier);
+    pthread_cond_destroy(&job.startCondition);
+    pthread_mutex_destroy(&job.startLock);
+
+    double done = transparency_sort_seconds();
+    sort->timings.depthMs = (job.keysDone - start) * 1000.0;
+    sort->timings.sortMs = (job.sortDone - job.keysDone) * 1000.0;
+    sort->timings.indexMs = (done - job.sortDone) * 1000.0;
+    sort->timings.passes = job.passes;
+}
+
+void transparency_sort_get_timings(const TransparencySort *sort, TransparencySortTimings *timings)
+{
+    *timings = sort->timings;
+}
+
+int transparency_sort_thread_count(const TransparencySort *sort)
+{
+    return sort->threadCount;
+}
@@ -0,0 +1,247 @@
+// uniform_block.c
+// Layout, defines and upload of packed uniform blocks. See uniform_block.h.
+#include "common/uniform_block.h"
+#include "common/shader_program.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNIFORM_BLOCK_NAME 64 // longest uniform name, with its terminator
+
+typedef struct UniformBlockSlot
+{
+    char name[UNIFORM_BLOCK_NAME];
+    UniformBlockType type;
+    int vector; // first vector
+    int offset; // first component in each vector
+} UniformBlockSlot;
+
+struct UniformBlock
+{
+    int stages;
+    int slotCount;
+    UniformBlockSlot *slots; // in declaration order
+    int vectors;
+    GLfloat *values; // vectors * 4
+    int dirty;
+    GLuint program; // bound with uniform_block_bind
+    GLint location;
+};
+
+// Vectors a type takes and components it takes in each
+static const int typeRows[7] = {1, 1, 1, 1, 1, 3, 4};
+static const int typeWidths[7] = {1, 2, 3, 4, 4, 3, 4};
+
+static int uniform_block_type_valid(UniformBlockType type)
+{
+    return type >= UNIFORM_BLOCK_FLOAT && type <= UNIFORM_BLOCK_MAT4;
+}
+
+// Order of placement: most components first, so that the small types fill
+// what the large ones leave
+static int uniform_block_rank(UniformBlockType type)
+{
+    return typeRows[type] * typeWidths[type];
+}
+
+// First fit of every slot into vectors whose used components are in used,
+// one bit per component. Returns the vectors the block needs.
+static int uniform_block_pack(UniformBlockSlot *slots, int slotCount, unsigned char *used)
+{
+    int vectors = 0;
+    for (int rank = 16; rank >= 1; --rank)
+    {
+        for (int i = 0; i < slotCount; ++i)
+        {
+            UniformBlockSlot *slot = &slots[i];
+            if (uniform_block_rank(slot->type) != rank)
+                continue;
+            int rows = typeRows[slot->type], width = typeWidths[slot->type];
+            unsigned char mask = (unsigned char)(((1u << width) - 1u));
+            for (int vector = 0;; ++vector)
+            {
+                int offset = 0;
+                for (; offset + width <= 4; ++offset)
+                {
+                    int available = 1;
+                    for (int row = 0; row < rows && available; ++row)
+                        available = (used[vector + row] & (mask << offset)) == 0;
+                    if (available)
+                        break;
+                }
+                if (offset + width > 4)
+                    continue;
+                for (int row = 0; row < rows; ++row)
+                    used[vector + row] |= (unsigned char)(mask << offset);
+                slot->vector = vector;
+                slot->offset = offset;
+                if (vector + rows > vectors)
+                    vectors = vector + rows;
+                break;
+            }
+        }
+    }
+    return vectors;
+}
+
+UniformBlock *uniform_block_create(const UniformBlockEntry *entries, int entryCount, int stages, int reservedVectors)
+{
+    if (entryCount <= 0 || !(stages & (UNIFORM_BLOCK_VERTEX | UNIFORM_BLOCK_FRAGMENT)))
+        return NULL;
+    UniformBlock *block = (UniformBlock *)calloc(1, sizeof(UniformBlock));
+    if (!block)
+        return NULL;
+    block->stages = stages;
+    block->slotCount = entryCount;
+    block->slots = (UniformBlockSlot *)calloc((size_t)entryCount, sizeof(UniformBlockSlot));
+    // Every slot in vectors of its own is the most the packing can need
+    unsigned char *used = (unsigned char *)calloc((size_t)entryCount * 4, 1);
+    if (!block->slots || !used)
+    {
+        free(used);
+        uniform_block_destroy(block);
+        return NULL;
+    }
+    for (int i = 0; i < entryCount; ++i)
+    {
+        if (!uniform_block_type_valid(entries[i].type) || strlen(entries[i].name) >= UNIFORM_BLOCK_NAME)
+        {
+            printf("ERROR: uniform_block: bad uniform %s\n", entries[i].name);
+            free(used);
+            uniform_block_destroy(block);
+            return NULL;
+        }
+        snprintf(block->slots[i].name, UNIFORM_BLOCK_NAME, "%s", entries[i].name);
+        block->slots[i].type = entries[i].type;
+    }
+    block->vectors = uniform_block_pack(block->slots, entryCount, used);
+    free(used);
+
+    static const GLenum limitNames[2] = {GL_MAX_VERTEX_UNIFORM_VECTORS, GL_MAX_FRAGMENT_UNIFORM_VECTORS};
+    static const char *stageNames[2] = {"vertex", "fragment"};
+    for (int stage = 0; stage < 2; ++stage)
+    {
+        if (!(stages & (1 << stage)))
+            continue;
+        GLint limit = 0;
+        glGetIntegerv(limitNames[stage], &limit);
+        if (block->vectors + reservedVectors > limit)
+        {
+            printf("ERROR: uniform_block: %d vectors and %d reserved exceed the %d %s uniform vectors\n",
+                   block->vectors, reservedVectors, (int)limit, stageNames[stage]);
+            uniform_block_destroy(block);
+            return NULL;
+        }
+    }
+    block->values = (GLfloat *)calloc((size_t)block->vectors * 4, sizeof(GLfloat));
+    if (!block->values)
+    {
+        uniform_block_destroy(block);
+        return NULL;
+    }
+    block->dirty = 1;
+    block->location = -1;
+    return block;
+}
+
+void uniform_block_destroy(UniformBlock *block)
+{
+    if (!block)
+        return;
+    free(block->slots);
+    free(block->values);
+    free(block);
+}
+
+// Appends the GLSL that reads slot out of uUniformBlock.
+static int uniform_block_print_slot(char *out, size_t size, const UniformBlockSlot *slot)
+{
+    static const char *components = "xyzw";
+    static const char *matrixNames[7] = {NULL, NULL, NULL, NULL, "mat2", "mat3", "mat4"};
+    int width = typeWidths[slot->type];
+    char swizzle[6] = "";
+    if (width < 4)
+        snprintf(swizzle, sizeof(swizzle), ".%.*s", width, components + slot->offset);
+    if (!matrixNames[slot->type])
+        return snprintf(out, size, "#define %s uUniformBlock[%d]%s\n", slot->name, slot->vector, swizzle);
+    if (slot->type == UNIFORM_BLOCK_MAT2)
+        return snprintf(out, size, "#define %s mat2(uUniformBlock[%d].xy, uUniformBlock[%d].zw)\n", slot->name,
+                        slot->vector, slot->vector);
+    int written = snprintf(out, size, "#define %s %s(", slot->name, matrixNames[slot->type]);
+    for (int row = 0; row < typeRows[slot->type]; ++row)
+    {
+        written += snprintf(out + written, size > (size_t)written ? size - (size_t)written : 0, "%suUniformBlock[%d]%s",
+                            row ? ", " : "", slot->vector + row, swizzle);
+    }
+    written += snprintf(out + written, size > (size_t)written ? size - (size_t)written : 0, ")\n");
+    return written;
+}
+
+char *uniform_block_source(const UniformBlock *block, const char *source, int stage)
+{
+    if (!(block->stages & stage))
+    {
+        size_t length = strlen(source) + 1;
+        char *text = (char *)malloc(length);
+        if (text)
+            memcpy(text, source, length);
+        return text;
+    }
+    size_t size = 64 + (size_t)block->slotCount * (UNIFORM_BLOCK_NAME + 128);
+    char *defines = (char *)malloc(size);
+    if (!defines)
+        return NULL;
+    int written = snprintf(defines, size, "#define UNIFORM_BLOCK_VECTORS %d\n", block->vectors);
+    for (int i = 0; i < block->slotCount; ++i)
+        written += uniform_block_print_slot(defines + written, size - (size_t)written, &block->slots[i]);
+    char *text = shader_program_insert_defines(source, defines);
+    free(defines);
+    return text;
+}
+
+void uniform_block_bind(UniformBlock *block, GLuint program)
+{
+    block->program = program;
+    block->location = program ? glGetUniformLocation(program, "uUniformBlock") : -1;
+    block->dirty = 1;
+    printf("INFO: uniform_block: %d uniforms in %d vectors\n", block->slotCount, block->vectors);
+}
+
+int uniform_block_find(const UniformBlock *block, const char *name)
+{
+    for (int i = 0; i < block->slotCount; ++i)
+    {
+        if (strcmp(block->slots[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+void uniform_block_set(UniformBlock *block, int index, const GLfloat *values)
+{
+    if (index < 0 || index >= block->slotCount)
+        return;
+    const UniformBlockSlot *slot = &block->slots[index];
+    int rows = typeRows[slot->type], width = typeWidths[slot->type];
+    for (int row = 0; row < rows; ++row)
+    {
+        GLfloat *to = block->values + (size_t)(slot->vector + row) * 4 + slot->offset;
+        memcpy(to, values + row * width, (size_t)width * sizeof(GLfloat));
+    }
+    block->dirty = 1;
+}
+
+int uniform_block_upload(UniformBlock *block)
+{
+    if (!block->dirty || block->location < 0)
+        return 0;
+    glUniform4fv(block->location, block->vectors, block->values);
+    block->dirty = 0;
+    return 1;
+}
+
+int uniform_block_vectors(const UniformBlock *block)
+{
+    return block->vectors;
+}
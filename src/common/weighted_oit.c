@@ -0,0 +1,268 @@
+// weighted_oit.c
+// Targets, passes and composite of weighted blended transparency. See
+// weighted_oit.h.
+#include "common/weighted_oit.h"
+#include "common/gl_pass.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <GLFW/glfw3.h>
+#include <shaders.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// GL_OES_texture_half_float, GL_OES_texture_float and GL_EXT_draw_buffers
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+#ifndef GL_COLOR_ATTACHMENT1_EXT
+#define GL_COLOR_ATTACHMENT1_EXT 0x8CE1
+#endif
+
+typedef void (*WeightedOitDrawBuffers)(GLsizei n, const GLenum *bufs);
+
+struct WeightedOit
+{
+    int width;
+    int height;
+    int drawBuffers; // GL_EXT_draw_buffers: one framebuffer with both targets
+    GLenum type;     // of the targets, half float or float
+    GLuint framebuffers[2];
+    GLuint textures[2]; // accumulation and revealage, weight
+    GLuint fragmentShader;
+    GLuint program; // composite
+    GLuint buffer;
+    GLint framebuffer; // bound at begin, composited into at end
+    GlPassState state; // put back by weighted_oit_end
+};
+
+// oit_frag, with OIT_DRAW_BUFFERS defined for GL_EXT_draw_buffers.
+static GLuint weighted_oit_compile_fragment(int drawBuffers)
+{
+    const char *source = shader_oit_frag.source;
+    if (!drawBuffers)
+        return shader_program_compile(GL_FRAGMENT_SHADER, source);
+    char *text = shader_program_insert_defines(source, "#define OIT_DRAW_BUFFERS\n");
+    if (!text)
+        return 0;
+    GLuint shader = shader_program_compile(GL_FRAGMENT_SHADER, text);
+    free(text);
+    return shader;
+}
+
+static int weighted_oit_create_composite(WeightedOit *oit)
+{
+    oit->program =
+        shader_program_create(shader_texture_quad_vert.source, shader_oit_composite_frag.source, "aPosition");
+    if (!oit->program)
+        return 0;
+    GLint program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glUseProgram(oit->program);
+    glUniform1i(glGetUniformLocation(oit->program, "uAccumulation"), 0);
+    glUniform1i(glGetUniformLocation(oit->program, "uWeight"), 1);
+    glUseProgram((GLuint)program);
+    oit->buffer = gl_pass_create_triangle();
+    return 1;
+}
+
+// Allocates both textures with type and attaches them, to one framebuffer
+// with draw buffers or to one each. 0 when the result is not renderable.
+static int weighted_oit_create_targets(WeightedOit *oit, GLenum type)
+{
+    glGenTextures(2, oit->textures);
+    glGenFramebuffers(oit->drawBuffers ? 1 : 2, oit->framebuffers);
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, oit->textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, oit->width, oit->height, 0, GL_RGBA, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    int complete = glGetError() == GL_NO_ERROR;
+    if (oit->drawBuffers)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, oit->framebuffers[0]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oit->textures[0], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1_EXT, GL_TEXTURE_2D, oit->textures[1], 0);
+        WeightedOitDrawBuffers drawBuffers = (WeightedOitDrawBuffers)glfwGetProcAddress("glDrawBuffersEXT");
+        static const GLenum attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1_EXT};
+        if (drawBuffers)
+            drawBuffers(2, attachments);
+        complete = complete && drawBuffers && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    else
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, oit->framebuffers[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oit->textures[i], 0);
+            complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+    }
+    oit->type = type;
+    return complete;
+}
+
+static void weighted_oit_delete_targets(WeightedOit *oit)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (oit->framebuffers[i])
+            glDeleteFramebuffers(1, &oit->framebuffers[i]);
+        if (oit->textures[i])
+            glDeleteTextures(1, &oit->textures[i]);
+        oit->framebuffers[i] = 0;
+        oit->textures[i] = 0;
+    }
+}
+
+// Half float where it renders, float otherwise
+static int weighted_oit_create_renderable_targets(WeightedOit *oit)
+{
+    GLint texture, framebuffer;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    while (glGetError() != GL_NO_ERROR)
+        ;
+    int complete = 0;
+    if (glfwExtensionSupported("GL_OES_texture_half_float"))
+        complete = weighted_oit_create_targets(oit, GL_HALF_FLOAT_OES);
+    if (!complete && glfwExtensionSupported("GL_OES_texture_float"))
+    {
+        weighted_oit_delete_targets(oit);
+        while (glGetError() != GL_NO_ERROR)
+            ;
+        complete = weighted_oit_create_targets(oit, GL_FLOAT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)texture);
+    return complete;
+}
+
+// Blends the average colour over the framebuffer bound at begin, through
+// the colour mask that was set then.
+static void weighted_oit_composite(WeightedOit *oit)
+{
+    const GLboolean *colorMask = oit->state.colorMask;
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)oit->framebuffer);
+    gl_pass_set_state(oit->width, oit->height);
+    glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(oit->program);
+    for (int unit = 1; unit >= 0; --unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + (GLenum)unit);
+        glBindTexture(GL_TEXTURE_2D, oit->textures[unit]);
+    }
+    gl_pass_draw(oit->buffer);
+}
+
+// ---------------------------------------------------------------------------
+// API
+
+WeightedOit *weighted_oit_create(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+    WeightedOit *oit = (WeightedOit *)calloc(1, sizeof(WeightedOit));
+    if (!oit)
+        return NULL;
+    oit->width = width;
+    oit->height = height;
+    oit->drawBuffers = glfwExtensionSupported("GL_EXT_draw_buffers");
+    int complete = weighted_oit_create_renderable_targets(oit);
+    if (!complete && oit->drawBuffers)
+    {
+        // Two attachments of this format may not render together
+        weighted_oit_delete_targets(oit);
+        oit->drawBuffers = 0;
+        complete = weighted_oit_create_renderable_targets(oit);
+    }
+    if (complete)
+        oit->fragmentShader = weighted_oit_compile_fragment(oit->drawBuffers);
+    if (!complete || !oit->fragmentShader || !weighted_oit_create_composite(oit))
+    {
+        weighted_oit_destroy(oit);
+        printf("INFO: weighted_oit: floating-point render targets unavailable\n");
+        return NULL;
+    }
+    printf("INFO: weighted_oit: %dx%d %s targets, %d geometry pass%s\n", width, height,
+           oit->type == GL_FLOAT ? "float" : "half-float", weighted_oit_pass_count(oit),
+           oit->drawBuffers ? " (GL_EXT_draw_buffers)" : "es");
+    return oit;
+}
+
+void weighted_oit_destroy(WeightedOit *oit)
+{
+    if (!oit)
+        return;
+    weighted_oit_delete_targets(oit);
+    if (oit->fragmentShader)
+        glDeleteShader(oit->fragmentShader);
+    if (oit->program)
+        glDeleteProgram(oit->program);
+    if (oit->buffer)
+        glDeleteBuffers(1, &oit->buffer);
+    free(oit);
+}
+
+GLuint weighted_oit_fragment_shader(const WeightedOit *oit)
+{
+    return oit ? oit->fragmentShader : 0;
+}
+
+int weighted_oit_pass_count(const WeightedOit *oit)
+{
+    return oit && oit->drawBuffers ? 1 : 2;
+}
+
+void weighted_oit_begin(WeightedOit *oit)
+{
+    if (!oit)
+        return;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oit->framebuffer);
+    gl_pass_save_state(&oit->state);
+}
+
+void weighted_oit_pass(WeightedOit *oit, int pass, GLuint program)
+{
+    if (!oit)
+        return;
+    glBindFramebuffer(GL_FRAMEBUFFER, oit->framebuffers[oit->drawBuffers ? 0 : pass]);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    // Revealage starts at 1, in the alpha of the first target; the weight
+    // target only uses red
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    // Colour and weight add up, alpha multiplies the revealage by 1 - alpha
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(program);
+    glUniform1f(glGetUniformLocation(program, "uPass"), (GLfloat)pass);
+}
+
+void weighted_oit_end(WeightedOit *oit)
+{
+    if (!oit)
+        return;
+    PROFILE_CALL(weighted_oit_composite(oit));
+    // The composite leaves the framebuffer of begin bound
+    gl_pass_restore_state(&oit->state);
+}
+
+unsigned long long weighted_oit_bytes(const WeightedOit *oit)
+{
+    if (!oit)
+        return 0;
+    unsigned long long texel = oit->type == GL_FLOAT ? 16ull : 8ull;
+    return (unsigned long long)oit->width * (unsigned long long)oit->height * texel * 2ull;
+}
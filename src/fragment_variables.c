@@ -4,6 +4,9 @@
 
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -13,56 +16,6 @@ static GLuint shaderPrograms[NUM_SHADERS];
 static GLuint vbo;
 static GLint posLoc;
 
-// Embedded shader sources
-static const char *fragcoord_frag =
-    "#version 100\n"
-    "precision mediump float;\n"
-    "void main() {\n"
-    "    gl_FragColor = vec4(gl_FragCoord.xy / 800.0, 0.0, 1.0);\n"
-    "}\n";
-static const char *frontfacing_frag =
-    "#version 100\n"
-    "precision mediump float;\n"
-    "void main() {\n"
-    "#ifdef GL_OES_standard_derivatives\n"
-    "    if (gl_FrontFacing) {\n"
-    "        gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0); // Green for front faces\n"
-    "    } else {\n"
-    "        gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); // Red for back faces\n"
-    "    }\n"
-    "#else\n"
-    "    gl_FragColor = vec4(0.5, 0.5, 0.5, 1.0); // Fallback for ES 2.0\n"
-    "#endif\n"
-    "}\n";
-static const char *pointcoord_frag =
-    "#version 100\n"
-    "// Demonstrates gl_PointCoord usage (OpenGL ES 2.0)\n"
-    "precision mediump float;\n"
-    "void main() {\n"
-    "    gl_FragColor = vec4(gl_PointCoord, 0.0, 1.0);\n"
-    "}\n";
-static const char *fragcolor_frag =
-    "#version 100\n"
-    "precision mediump float;\n"
-    "void main() {\n"
-    "    gl_FragColor = vec4(0.2, 0.4, 0.6, 1.0);\n"
-    "}\n";
-static const char *fragdata_frag =
-    "#version 100\n"
-    "precision mediump float;\n"
-    "void main() {\n"
-    "    //gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); // Only gl_FragColor is available in ES 2.0\n"
-    "    gl_FragData[0] = vec4(1.0, 0.0, 0.0, 1.0); // Not available in ES 2.0\n"
-    "}\n";
-static const char *pointsize_vert =
-    "#version 100\n"
-    "attribute vec3 aPosition;\n"
-    "uniform float uPointSize;\n"
-    "void main() {\n"
-    "    gl_Position = vec4(aPosition, 1.0);\n"
-    "    gl_PointSize = uPointSize;\n"
-    "}\n";
-
 // Remove static/global initialization of frag_shaders
 // Instead, declare as NULL and initialize in main before use
 static const char *frag_shaders[NUM_SHADERS] = {NULL};
@@ -77,7 +30,7 @@ GLuint compile_shader_from_source(const char *source, GLenum type)
         return 0;
     }
     glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+    PROFILE_CALL(glCompileShader(shader));
     GLint compiled;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
     if (!compiled)
@@ -128,7 +81,7 @@ GLuint create_shader_program_embedded(const char *vertex_src, const char *fragme
     }
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+    PROFILE_CALL(glLinkProgram(program));
     GLint linked;
     glGetProgramiv(program, GL_LINK_STATUS, &linked);
     if (!linked)
@@ -161,11 +114,11 @@ GLuint create_shader_program_embedded(const char *vertex_src, const char *fragme
 void init()
 {
     // Initialize frag_shaders array after all shader strings are defined
-    frag_shaders[0] = fragcoord_frag;
-    frag_shaders[1] = frontfacing_frag;
-    frag_shaders[2] = pointcoord_frag;
-    frag_shaders[3] = fragcolor_frag;
-    frag_shaders[4] = fragdata_frag;
+    frag_shaders[0] = shader_fragcoord_frag.source;
+    frag_shaders[1] = shader_frontfacing_frag.source;
+    frag_shaders[2] = shader_pointcoord_frag.source;
+    frag_shaders[3] = shader_fragcolor_frag.source;
+    frag_shaders[4] = shader_fragdata_frag.source;
 
     // Vertex data for a triangle
     float vertices[3][3] = {
@@ -174,18 +127,19 @@ void init()
         {0.8f, -0.8f, 0.0f}};
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
     // Compile all shader programs once and store them
     for (int i = 0; i < NUM_SHADERS; ++i)
     {
-        shaderPrograms[i] = create_shader_program_embedded(pointsize_vert, frag_shaders[i]);
+        shaderPrograms[i] = create_shader_program_embedded(shader_pointsize_vert.source, frag_shaders[i]);
     }
     // Use the first program to get the attribute location (all use same vertex shader)
     posLoc = glGetAttribLocation(shaderPrograms[0], "aPosition");
 }
 
-void draw()
+void draw(const SampleClock *sampleClock)
 {
+    (void)sampleClock; // the scene does not change over time
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -225,12 +179,17 @@ int main(void)
     }
     glfwMakeContextCurrent(window);
 
-    init();
-    while (!glfwWindowShouldClose(window))
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock))
     {
-        draw();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
+        PROFILE_CALL(glfwSwapBuffers(window));
+        PROFILE_CALL(glfwPollEvents());
     }
     glfwTerminate();
     return 0;
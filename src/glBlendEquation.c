@@ -1,5 +1,8 @@
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
 
 #include <stdio.h>
 
@@ -10,23 +13,12 @@ static int width = 1600;
 static int height = 400;
 
 void init() {
-    const char *vertexShaderSource =
-            "attribute vec4 aPos;\n"
-            "void main()\n"
-            "{\n"
-            "gl_Position = aPos;\n"
-            "}\n";
-
-    const char *fragmentShaderSource =
-            "precision mediump float;\n"
-            "void main()\n"
-            "{\n"
-            "gl_FragColor = vec4(0.2f, 0.4f, 0.6f, 0.5f);\n"
-            "}\n";
+    const char *vertexShaderSource = shader_blend_vert.source;
+    const char *fragmentShaderSource = shader_blend_frag.source;
 
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    PROFILE_CALL(glCompileShader(vertexShader));
     GLint success;
     glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
     if (!success) {
@@ -36,7 +28,7 @@ void init() {
 
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    PROFILE_CALL(glCompileShader(fragmentShader));
     glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
     if (!success) {
         glDeleteShader(fragmentShader);
@@ -47,7 +39,7 @@ void init() {
 
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    PROFILE_CALL(glLinkProgram(shaderProgram));
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
@@ -64,14 +56,15 @@ void init() {
 
     glGenBuffers(1, &vertexBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
 
     GLuint posAttrib = glGetAttribLocation(shaderProgram, "aPos");
     glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
     glEnableVertexAttribArray(posAttrib);
 }
 
-void draw() {
+void draw(const SampleClock *sampleClock) {
+    (void)sampleClock; // the scene does not change over time
     glClearColor(1.0f, 1.0f, 1.0f, 0.5f);
     glClear(GL_COLOR_BUFFER_BIT);
 
@@ -109,6 +102,13 @@ void draw() {
     glDisable(GL_BLEND);
 }
 
+void cleanup() {
+    glDeleteProgram(shaderProgram);
+    glDeleteBuffers(1, &vertexBuffer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
 int main() {
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
@@ -126,11 +126,17 @@ int main() {
         return 0;
     }
     glfwMakeContextCurrent(window);
-    init();
-    while (!glfwWindowShouldClose(window)) {
-        draw();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock)) {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
+        PROFILE_CALL(glfwSwapBuffers(window));
+        PROFILE_CALL(glfwPollEvents());
     }
+    cleanup();
     return 0;
 }
@@ -1,13 +1,24 @@
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <capture/frame_capture.h>
+#include <common/antialiasing.h>
+#include <common/dynamic_resolution.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
 
 #include <stdio.h>
 
 static GLFWwindow *window;
+static FrameCapture *capture;
 static GLuint shaderProgram;
 static GLuint vertexBuffer;
 static int width = 900;
 static int height = 900;
+static DynamicResolution *dynamicResolution;
+static Antialiasing *antialiasing;
+static int renderWidth = 900; // scaled by dynamicResolution
+static int renderHeight = 900;
 
 static GLenum glBlendEquationOptions[] = {
         GL_FUNC_ADD, GL_FUNC_SUBTRACT, GL_FUNC_REVERSE_SUBTRACT
@@ -24,23 +35,12 @@ static GLenum glBlendEquationMode = GL_FUNC_ADD;
 static GLenum glBlendFuncDFactor = GL_ONE_MINUS_SRC_ALPHA; // Any item from glBlendFuncOptions except GL_SRC_ALPHA_SATURATE
 
 void init() {
-    const char *vertexShaderSource =
-            "attribute vec4 aPos;\n"
-            "void main()\n"
-            "{\n"
-            "gl_Position = aPos;\n"
-            "}\n";
-
-    const char *fragmentShaderSource =
-            "precision mediump float;\n"
-            "void main()\n"
-            "{\n"
-            "gl_FragColor = vec4(0.2f, 0.4f, 0.6f, 0.5f);\n"
-            "}\n";
+    const char *vertexShaderSource = shader_blend_vert.source;
+    const char *fragmentShaderSource = shader_blend_frag.source;
 
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    PROFILE_CALL(glCompileShader(vertexShader));
     GLint success;
     glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
     if (!success) {
@@ -50,7 +50,7 @@ void init() {
 
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    PROFILE_CALL(glCompileShader(fragmentShader));
     glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
     if (!success) {
         glDeleteShader(fragmentShader);
@@ -61,7 +61,7 @@ void init() {
 
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    PROFILE_CALL(glLinkProgram(shaderProgram));
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
@@ -78,14 +78,15 @@ void init() {
 
     glGenBuffers(1, &vertexBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
 
     GLuint posAttrib = glGetAttribLocation(shaderProgram, "aPos");
     glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
     glEnableVertexAttribArray(posAttrib);
 }
 
-void draw() {
+void draw(const SampleClock *sampleClock) {
+    (void)sampleClock; // the scene does not change over time
     glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
@@ -96,7 +97,7 @@ void draw() {
 
     for (int i = 0; i < rowCount; i++) {
         for (int j = 0; j < columnCount; j++) {
-            glViewport(j * width / columnCount, i * height / rowCount, width / columnCount, height / rowCount);
+            glViewport(j * renderWidth / columnCount, i * renderHeight / rowCount, renderWidth / columnCount, renderHeight / rowCount);
             if (i == 3 && j == 3) {
                 glDisable(GL_BLEND);
             } else {
@@ -110,6 +111,13 @@ void draw() {
     }
 }
 
+void cleanup() {
+    glDeleteProgram(shaderProgram);
+    glDeleteBuffers(1, &vertexBuffer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
 int main() {
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
@@ -119,6 +127,8 @@ int main() {
     glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    int aaSamples;
+    AntialiasingMode aaMode = antialiasing_hint_from_env(&aaSamples);
 
     window = glfwCreateWindow(width, height, "glBlendFunc", NULL, NULL);
     if (window == NULL) {
@@ -127,11 +137,29 @@ int main() {
         return 0;
     }
     glfwMakeContextCurrent(window);
-    init();
-    while (!glfwWindowShouldClose(window)) {
-        draw();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    capture = frame_capture_create_from_env(width, height);
+    dynamicResolution = dynamic_resolution_create_from_env(width, height);
+    antialiasing = antialiasing_create(aaMode, width, height);
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock)) {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        frame_capture_begin(capture);
+        antialiasing_begin(antialiasing);
+        dynamic_resolution_begin(dynamicResolution, &renderWidth, &renderHeight);
+        PROFILE_CALL(draw(&sampleClock));
+        dynamic_resolution_end(dynamicResolution);
+        antialiasing_end(antialiasing);
+        frame_capture_end(capture);
+        PROFILE_CALL(glfwSwapBuffers(window));
+        PROFILE_CALL(glfwPollEvents());
     }
+    antialiasing_destroy(antialiasing);
+    dynamic_resolution_destroy(dynamicResolution);
+    frame_capture_destroy(capture);
+    cleanup();
     return 0;
 }
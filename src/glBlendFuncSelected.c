@@ -1,5 +1,10 @@
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <common/premultiplied_alpha.h>
+#include <common/profiler.h>
+#include <common/shader_program.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
 
 #include <stdio.h>
 
@@ -8,25 +13,75 @@ static GLuint shaderProgram;
 static GLuint vertexBuffer;
 static int width = 1600;
 static int height = 400;
+// SAMPLES_PREMULTIPLIED=1: the alpha and additive viewports in one draw
+static int premultiplied;
+static GLuint premultipliedProgram;
+static GLuint premultipliedBuffer;
+static GLuint premultipliedColorLocation;
+
+typedef struct PremultipliedVertex {
+    GLfloat position[2];
+    GLfloat color[4];
+} PremultipliedVertex;
+
+// The triangles of viewports 2 and 3 with the colour of blend_frag, in one
+// viewport spanning both, premultiplied for the blend of each. Returns 0,
+// with the log printed, when the program does not build.
+static int init_premultiplied(const GLfloat *vertices) {
+    premultipliedProgram =
+        shader_program_create(shader_color_vert.source, shader_color_frag.source, "aPosition");
+    if (!premultipliedProgram)
+        return 0;
+    premultipliedColorLocation = (GLuint)glGetAttribLocation(premultipliedProgram, "aColor");
+
+    const GLfloat color[4] = {0.2f, 0.4f, 0.6f, 0.5f};
+    PremultipliedVertex batch[12];
+    for (int i = 0; i < 12; i++) {
+        int additive = i >= 6;
+        // Left half of the span for viewport 2, right half for viewport 3
+        batch[i].position[0] = (vertices[(i % 6) * 3] + (additive ? 1.0f : -1.0f)) * 0.5f;
+        batch[i].position[1] = vertices[(i % 6) * 3 + 1];
+        for (int c = 0; c < 4; c++)
+            batch[i].color[c] = color[c];
+    }
+    premultiply_colors(PREMULTIPLIED_OVER, batch[0].color, 6, sizeof(PremultipliedVertex));
+    premultiply_colors(PREMULTIPLIED_ADDITIVE, batch[6].color, 6, sizeof(PremultipliedVertex));
+
+    glGenBuffers(1, &premultipliedBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, premultipliedBuffer);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(batch), batch, GL_STATIC_DRAW));
+    printf("INFO: premultiplied alpha: alpha and additive blending in 1 draw and 1 blend state instead of 4 and 2\n");
+    return 1;
+}
+
+static void draw_premultiplied(GLuint posAttrib) {
+    glViewport(width / 4, 0, 2 * width / 4, height);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glBlendEquation(GL_FUNC_ADD);
+    glUseProgram(premultipliedProgram);
+    glBindBuffer(GL_ARRAY_BUFFER, premultipliedBuffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PremultipliedVertex), (void *) 0);
+    glVertexAttribPointer(premultipliedColorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(PremultipliedVertex),
+                          (void *) (2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(premultipliedColorLocation);
+    glDrawArrays(GL_TRIANGLES, 0, 12);
+
+    // Back to the blend_vert attributes
+    glDisableVertexAttribArray(premultipliedColorLocation);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(posAttrib);
+    glUseProgram(shaderProgram);
+}
 
 void init() {
-    const char *vertexShaderSource =
-            "attribute vec4 aPos;\n"
-            "void main()\n"
-            "{\n"
-            "gl_Position = aPos;\n"
-            "}\n";
-
-    const char *fragmentShaderSource =
-            "precision mediump float;\n"
-            "void main()\n"
-            "{\n"
-            "gl_FragColor = vec4(0.2f, 0.4f, 0.6f, 0.5f);\n"
-            "}\n";
+    const char *vertexShaderSource = shader_blend_vert.source;
+    const char *fragmentShaderSource = shader_blend_frag.source;
 
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    PROFILE_CALL(glCompileShader(vertexShader));
     GLint success;
     glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
     if (!success) {
@@ -36,7 +91,7 @@ void init() {
 
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    PROFILE_CALL(glCompileShader(fragmentShader));
     glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
     if (!success) {
         glDeleteShader(fragmentShader);
@@ -46,7 +101,7 @@ void init() {
     shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    PROFILE_CALL(glLinkProgram(shaderProgram));
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
@@ -62,14 +117,19 @@ void init() {
 
     glGenBuffers(1, &vertexBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
 
     GLuint posAttrib = glGetAttribLocation(shaderProgram, "aPos");
     glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
     glEnableVertexAttribArray(posAttrib);
+
+    // Without the program the viewports are drawn one by one as usual
+    if (premultiplied && !init_premultiplied(vertices))
+        premultiplied = 0;
 }
 
-void draw() {
+void draw(const SampleClock *sampleClock) {
+    (void)sampleClock; // the scene does not change over time
     glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     glUseProgram(shaderProgram);
@@ -85,19 +145,24 @@ void draw() {
     // Enable blend
     glEnable(GL_BLEND);
 
-    // Viewport 2: Alpha blending (transparency)
-    glViewport(width / columnCount, 0, width / columnCount, height);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glBlendEquation(GL_FUNC_ADD);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDrawArrays(GL_TRIANGLES, 3, 3);
-
-    // Viewport 3: Additive blending (lightening)
-    glViewport(2 * width / columnCount, 0, width / columnCount, height);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glBlendEquation(GL_FUNC_ADD);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDrawArrays(GL_TRIANGLES, 3, 3);
+    if (premultiplied) {
+        // Viewports 2 and 3 in one draw
+        draw_premultiplied(glGetAttribLocation(shaderProgram, "aPos"));
+    } else {
+        // Viewport 2: Alpha blending (transparency)
+        glViewport(width / columnCount, 0, width / columnCount, height);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBlendEquation(GL_FUNC_ADD);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glDrawArrays(GL_TRIANGLES, 3, 3);
+
+        // Viewport 3: Additive blending (lightening)
+        glViewport(2 * width / columnCount, 0, width / columnCount, height);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glBlendEquation(GL_FUNC_ADD);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glDrawArrays(GL_TRIANGLES, 3, 3);
+    }
 
     // Viewport 4: Multiplicative blending (darkening)
     glViewport(3 * width / columnCount, 0, width / columnCount, height);
@@ -109,6 +174,17 @@ void draw() {
     glDisable(GL_BLEND);
 }
 
+void cleanup() {
+    glDeleteProgram(shaderProgram);
+    glDeleteBuffers(1, &vertexBuffer);
+    if (premultiplied) {
+        glDeleteProgram(premultipliedProgram);
+        glDeleteBuffers(1, &premultipliedBuffer);
+    }
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
 int main() {
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
@@ -125,11 +201,18 @@ int main() {
         return 0;
     }
     glfwMakeContextCurrent(window);
-    init();
-    while (!glfwWindowShouldClose(window)) {
-        draw();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    premultiplied = premultiplied_alpha_from_env();
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock)) {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
+        PROFILE_CALL(glfwSwapBuffers(window));
+        PROFILE_CALL(glfwPollEvents());
     }
+    cleanup();
     return 0;
 }
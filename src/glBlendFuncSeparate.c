@@ -1,145 +1,42 @@
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <capture/frame_capture.h>
+#include <common/antialiasing.h>
+#include <common/dynamic_resolution.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <common/shader_reload.h>
+#include <scenes/blend_func_separate_scene.h>
+#include <shaders.h>
 
 #include <stdio.h>
 
 static GLFWwindow *window;
-static GLuint shaderProgram;
-static GLuint vertexBuffer;
+static FrameCapture *capture;
 static int width = 900;
 static int height = 900;
+static DynamicResolution *dynamicResolution;
+static Antialiasing *antialiasing;
+static int renderWidth = 900; // scaled by dynamicResolution
+static int renderHeight = 900;
 
-static GLenum glBlendEquationOptions[] = {
-        GL_FUNC_ADD, GL_FUNC_SUBTRACT, GL_FUNC_REVERSE_SUBTRACT
-};
-
-static GLenum glBlendFuncSFactorOptions[] = {
-        GL_ZERO, GL_ONE, GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR,
-        GL_DST_COLOR, GL_ONE_MINUS_DST_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
-        GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_CONSTANT_COLOR, GL_ONE_MINUS_CONSTANT_COLOR,
-        GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA, GL_SRC_ALPHA_SATURATE
-};
-
-static GLenum glBlendFuncDFactorOptions[] = {
-        GL_ZERO, GL_ONE, GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR,
-        GL_DST_COLOR, GL_ONE_MINUS_DST_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
-        GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_CONSTANT_COLOR, GL_ONE_MINUS_CONSTANT_COLOR,
-        GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA
-};
-
-static GLenum glBlendEquationMode = GL_FUNC_ADD;
-static GLenum glBlendFuncsSFactorAlpha = GL_ZERO;
-static GLenum glBlendFuncsDFactorRGB = GL_ZERO;
-static GLenum glBlendFuncsDFactorAlpha = GL_ZERO;
-
-static int sFactorAlphaCount = sizeof(glBlendFuncSFactorOptions) / sizeof(GLenum);
-static int dFactorRGBCount = sizeof(glBlendFuncDFactorOptions) / sizeof(GLenum);
-static int dFactorAlphaCount = sizeof(glBlendFuncDFactorOptions) / sizeof(GLenum);
-
-static double lastTime;
-static int comboIndex = 0;
+static BlendFuncSeparateScene scene;
 
 void init() {
-    const char *vertexShaderSource =
-        "attribute vec4 aPos;\n"
-        "void main()\n"
-        "{\n"
-            "gl_Position = aPos;\n"
-        "}\n";
-
-    const char *fragmentShaderSource =
-        "precision mediump float;\n"
-        "void main()\n"
-        "{\n"
-            "gl_FragColor = vec4(0.2f, 0.4f, 0.6f, 0.5f);\n"
-        "}\n";
-
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    GLint success;
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glDeleteShader(vertexShader);
-        vertexShader = 0;
-    }
-
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glDeleteShader(fragmentShader);
-        fragmentShader = 0;
-    }
-
-    shaderProgram = glCreateProgram();
-
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    GLfloat vertices[] = {
-            -0.6f, -0.5f, 0.0f,  // left
-            0.4f, -0.5f, 0.0f,   // right
-            -0.1f, 0.5f, 0.0f,   // top
-
-            -0.4f, -0.5f, 0.0f, // left
-            0.6f, -0.5f, 0.0f, // right
-            0.1f, 0.5f, 0.0f   // top
-    };
-
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    GLuint posAttrib = glGetAttribLocation(shaderProgram, "aPos");
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(posAttrib);
-
-    lastTime = glfwGetTime();
+    blend_func_separate_scene_init(&scene);
 }
 
-void draw() {
-    double currentTime = glfwGetTime();
-    if (currentTime - lastTime >= 1.0) { // Change every second
-        comboIndex++;
-        int totalCombos = sFactorAlphaCount * dFactorRGBCount * dFactorAlphaCount;
-        if (comboIndex >= totalCombos) comboIndex = 0;
-        int sIdx = comboIndex % sFactorAlphaCount;
-        int dRGBIdx = (comboIndex / sFactorAlphaCount) % dFactorRGBCount;
-        int dAlphaIdx = (comboIndex / (sFactorAlphaCount * dFactorRGBCount)) % dFactorAlphaCount;
-        glBlendFuncsSFactorAlpha = glBlendFuncSFactorOptions[sIdx];
-        glBlendFuncsDFactorRGB = glBlendFuncDFactorOptions[dRGBIdx];
-        glBlendFuncsDFactorAlpha = glBlendFuncDFactorOptions[dAlphaIdx];
-        lastTime = currentTime;
-        printf("Counter: %d | SFactorAlpha: %d, DFactorRGB: %d, DFactorAlpha: %d\n", comboIndex, glBlendFuncsSFactorAlpha, glBlendFuncsDFactorRGB, glBlendFuncsDFactorAlpha);
+void draw(const SampleClock *sampleClock) {
+    if (blend_func_separate_scene_update(&scene, sampleClock->time)) {
+        printf("Counter: %d | SFactorAlpha: %d, DFactorRGB: %d, DFactorAlpha: %d\n", scene.comboIndex, scene.sFactorAlpha, scene.dFactorRGB, scene.dFactorAlpha);
     }
-    glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    glUseProgram(shaderProgram);
-
-    int columnCount = 4;
-    int rowCount = 4;
+    blend_func_separate_scene_draw(&scene, renderWidth, renderHeight);
+}
 
-    for (int i = 0; i < rowCount; i++) {
-        for (int j = 0; j < columnCount; j++) {
-            glViewport(j * width / columnCount, i * height / rowCount, width / columnCount, height / rowCount);
-            glEnable(GL_BLEND);
-            glBlendEquation(glBlendEquationMode);
-            glBlendFuncSeparate(glBlendFuncSFactorOptions[(i * columnCount + j) % 14],
-                                glBlendFuncsDFactorRGB,
-                                glBlendFuncsSFactorAlpha,
-                                glBlendFuncsDFactorAlpha
-            );
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            glDrawArrays(GL_TRIANGLES, 3, 3);
-        }
-    }
+void cleanup() {
+    blend_func_separate_scene_destroy(&scene);
+    glfwDestroyWindow(window);
+    glfwTerminate();
 }
 
 int main() {
@@ -151,6 +48,8 @@ int main() {
     glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    int aaSamples;
+    AntialiasingMode aaMode = antialiasing_hint_from_env(&aaSamples);
 
     window = glfwCreateWindow(width, height, "glBlendFunc", NULL, NULL);
     if (window == NULL) {
@@ -159,11 +58,33 @@ int main() {
         return 0;
     }
     glfwMakeContextCurrent(window);
-    init();
-    while (!glfwWindowShouldClose(window)) {
-        draw();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    capture = frame_capture_create_from_env(width, height);
+    dynamicResolution = dynamic_resolution_create_from_env(width, height);
+    antialiasing = antialiasing_create(aaMode, width, height);
+    ShaderReloader *shaderReloader = shader_reload_create_from_env(window);
+    shader_reload_watch(shaderReloader, &scene.program, &shader_blend_vert, &shader_blend_frag, NULL, NULL);
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock)) {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        shader_reload_update(shaderReloader);
+        frame_capture_begin(capture);
+        antialiasing_begin(antialiasing);
+        dynamic_resolution_begin(dynamicResolution, &renderWidth, &renderHeight);
+        PROFILE_CALL(draw(&sampleClock));
+        dynamic_resolution_end(dynamicResolution);
+        antialiasing_end(antialiasing);
+        frame_capture_end(capture);
+        PROFILE_CALL(glfwSwapBuffers(window));
+        PROFILE_CALL(glfwPollEvents());
     }
+    shader_reload_destroy(shaderReloader);
+    antialiasing_destroy(antialiasing);
+    dynamic_resolution_destroy(dynamicResolution);
+    frame_capture_destroy(capture);
+    cleanup();
     return 0;
 }
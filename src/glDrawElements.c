@@ -0,0 +1,263 @@
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <common/uniform_block.h>
+#include <mesh/mesh.h>
+#include <shaders.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Indexed mesh loaded from a .mesh file (built from meshes/torus.obj by
+// obj2mesh) and drawn with glDrawElements
+#ifndef SAMPLE_MESH_DIR
+#define SAMPLE_MESH_DIR "meshes"
+#endif
+
+static GLFWwindow *window;
+static GLuint shaderProgram;
+// Both matrices in one vec4 array, uploaded with one call per frame
+static UniformBlock *uniformBlock;
+static const UniformBlockEntry uniforms[2] = {{"uModelViewProjection", UNIFORM_BLOCK_MAT4},
+                                              {"uModel", UNIFORM_BLOCK_MAT4}};
+static GLint aPositionLoc;
+static GLint aNormalLoc;
+static Mesh mesh;
+static float meshCenter[3];
+static float meshScale = 1.0f;
+
+GLuint compile_shader_from_source(const char *source, GLenum type)
+{
+    GLuint shader = glCreateShader(type);
+    if (!shader)
+    {
+        printf("ERROR: Failed to create shader object\n");
+        return 0;
+    }
+    glShaderSource(shader, 1, &source, NULL);
+    PROFILE_CALL(glCompileShader(shader));
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        GLint logLength = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        char *infoLog = (char *)malloc(logLength);
+        if (infoLog)
+        {
+            glGetShaderInfoLog(shader, logLength, NULL, infoLog);
+            printf("ERROR: Shader compilation failed: %s\n", infoLog);
+            free(infoLog);
+        }
+        else
+        {
+            printf("ERROR: Shader compilation failed. (Could not allocate infoLog)\n");
+        }
+        glDeleteShader(shader);
+        return 0;
+    }
+    printf("INFO: Shader compiled successfully\n");
+    return shader;
+}
+
+GLuint create_shader_program_embedded(const char *vertex_src, const char *fragment_src)
+{
+    GLuint vertexShader = compile_shader_from_source(vertex_src, GL_VERTEX_SHADER);
+    if (!vertexShader)
+    {
+        printf("ERROR: Vertex shader compilation failed\n");
+        return 0;
+    }
+    GLuint fragmentShader = compile_shader_from_source(fragment_src, GL_FRAGMENT_SHADER);
+    if (!fragmentShader)
+    {
+        printf("ERROR: Fragment shader compilation failed\n");
+        glDeleteShader(vertexShader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    if (!program)
+    {
+        printf("ERROR: Failed to create shader program\n");
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    PROFILE_CALL(glLinkProgram(program));
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        GLint logLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        char *infoLog = (char *)malloc(logLength);
+        if (infoLog)
+        {
+            glGetProgramInfoLog(program, logLength, NULL, infoLog);
+            printf("ERROR: Program linking failed: %s\n", infoLog);
+            free(infoLog);
+        }
+        else
+        {
+            printf("ERROR: Program linking failed. (Could not allocate infoLog)\n");
+        }
+        glDeleteProgram(program);
+        program = 0;
+    }
+    else
+    {
+        printf("INFO: Shader program linked successfully\n");
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// out = a * b, column-major 4x4
+static void multiply(float *out, const float *a, const float *b)
+{
+    float result[16];
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k)
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            result[column * 4 + row] = sum;
+        }
+    }
+    for (int i = 0; i < 16; ++i)
+        out[i] = result[i];
+}
+
+int init()
+{
+    uniformBlock = uniform_block_create(uniforms, 2, UNIFORM_BLOCK_VERTEX, 0);
+    if (!uniformBlock)
+        return 0;
+    char *vertexSource = uniform_block_source(uniformBlock, shader_mesh_vert.source, UNIFORM_BLOCK_VERTEX);
+    if (!vertexSource)
+        return 0;
+    shaderProgram = create_shader_program_embedded(vertexSource, shader_mesh_frag.source);
+    free(vertexSource);
+    uniform_block_bind(uniformBlock, shaderProgram);
+    aPositionLoc = glGetAttribLocation(shaderProgram, "aPosition");
+    aNormalLoc = glGetAttribLocation(shaderProgram, "aNormal");
+
+    double start = glfwGetTime();
+    if (!mesh_load(SAMPLE_MESH_DIR "/torus.mesh", &mesh))
+        return 0;
+    printf("INFO: Loaded %d triangles in %.3f ms\n", mesh.indexCount / 3, (glfwGetTime() - start) * 1000.0);
+    // Fit the mesh's bounding box into the unit sphere
+    float radius = 0.0f;
+    for (int k = 0; k < 3; ++k)
+    {
+        meshCenter[k] = 0.5f * (mesh.boundsMin[k] + mesh.boundsMax[k]);
+        float half = 0.5f * (mesh.boundsMax[k] - mesh.boundsMin[k]);
+        radius += half * half;
+    }
+    meshScale = radius > 0.0f ? 1.0f / sqrtf(radius) : 1.0f;
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    return shaderProgram != 0;
+}
+
+void draw(const SampleClock *sampleClock)
+{
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    glViewport(0, 0, width, height);
+    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Model: centre and scale, tilt by 0.5 rad about x, turn about y over time
+    float angle = (float)sampleClock->time * 0.6f;
+    float c = cosf(angle), s = sinf(angle), ct = cosf(0.5f), st = sinf(0.5f);
+    float fit[16] = {meshScale, 0, 0, 0, 0, meshScale, 0, 0, 0, 0, meshScale, 0,
+                     -meshCenter[0] * meshScale, -meshCenter[1] * meshScale, -meshCenter[2] * meshScale, 1};
+    float turn[16] = {c, 0, -s, 0, 0, 1, 0, 0, s, 0, c, 0, 0, 0, 0, 1};
+    float tilt[16] = {1, 0, 0, 0, 0, ct, st, 0, 0, -st, ct, 0, 0, 0, 0, 1};
+    float rotation[16], model[16];
+    multiply(rotation, tilt, turn);
+    multiply(model, rotation, fit);
+    // View 3 units back, 45 degree vertical field of view
+    float aspect = (float)width / (float)height;
+    float f = 1.0f / tanf(0.5f * 0.785398f), zNear = 0.5f, zFar = 10.0f;
+    float projection[16] = {f / aspect, 0, 0, 0, 0, f, 0, 0, 0, 0, (zFar + zNear) / (zNear - zFar), -1,
+                            0, 0, 2.0f * zFar * zNear / (zNear - zFar), 0};
+    float view[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, -3.0f, 1};
+    float viewProjection[16];
+    multiply(viewProjection, projection, view);
+    float modelViewProjection[16];
+    multiply(modelViewProjection, viewProjection, model);
+
+    glUseProgram(shaderProgram);
+    uniform_block_set(uniformBlock, 0, modelViewProjection);
+    uniform_block_set(uniformBlock, 1, rotation);
+    uniform_block_upload(uniformBlock);
+    mesh_draw(&mesh, aPositionLoc, aNormalLoc, -1);
+
+    // Swap front and back buffers
+    PROFILE_CALL(glfwSwapBuffers(window));
+    // Poll for and process events
+    PROFILE_CALL(glfwPollEvents());
+}
+
+void cleanup()
+{
+    mesh_destroy(&mesh);
+    uniform_block_destroy(uniformBlock);
+    glDeleteProgram(shaderProgram);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+int main(void)
+{
+    // Initialize GLFW
+    if (!glfwInit())
+    {
+        printf("ERROR: Failed to initialize GLFW\n");
+        return -1;
+    }
+
+    // Set GLFW window hints for OpenGL ES 2.0
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+
+    // Create a windowed mode window and its OpenGL context
+    window = glfwCreateWindow(800, 800, "glDrawElements Example", NULL, NULL);
+    if (!window)
+    {
+        printf("ERROR: Failed to create GLFW window\n");
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    int ready;
+    PROFILE_CALL(ready = init());
+    if (!ready)
+    {
+        cleanup();
+        return -1;
+    }
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock))
+    {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
+    }
+    cleanup();
+
+    return 0;
+}
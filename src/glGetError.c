@@ -1,5 +1,7 @@
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
 
 #include <stdio.h>
 #include <stdbool.h>
@@ -168,7 +170,8 @@ void init() {
     }
 }
 
-void draw() {
+void draw(const SampleClock *sampleClock) {
+    (void)sampleClock; // the scene does not change over time
     // Nothing to draw
 }
 
@@ -191,11 +194,16 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
-    init();
-    while (!glfwWindowShouldClose(window)) {
-        draw();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock)) {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
+        PROFILE_CALL(glfwSwapBuffers(window));
+        PROFILE_CALL(glfwPollEvents());
     }
     return 0;
 }
@@ -1,6 +1,9 @@
 // glsl_limits_test.c
 // Test OpenGL ES 2.0 built-in constant limits
 #include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
 #include <GLES2/gl2.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,57 +14,6 @@ static GLuint vbo;
 static GLint posLoc;
 static GLint uIndexLoc;
 
-// Embedded shader sources
-static const char *glsl_limits_test_vert =
-    "#version 100\n"
-    "\n"
-    "attribute vec4 a_position;\n"
-    "void main() {\n"
-    "    gl_Position = a_position;\n"
-    "}\n";
-static const char *glsl_limits_test_frag =
-    "#version 100\n"
-    "\n"
-    "precision mediump int;\n"
-    "precision mediump float;\n"
-    "\n"
-    "uniform int u_index;\n"
-    "\n"
-    "void main() {\n"
-    "    int value = 0;\n"
-    "    int minValue = 0;\n"
-    "    if (u_index == 0) {\n"
-    "        value = gl_MaxVertexAttribs;\n"
-    "        minValue = 8;\n"
-    "    } else if (u_index == 1) {\n"
-    "        value = gl_MaxVertexUniformVectors;\n"
-    "        minValue = 128;\n"
-    "    } else if (u_index == 2) {\n"
-    "        value = gl_MaxVaryingVectors;\n"
-    "        minValue = 8;\n"
-    "    } else if (u_index == 3) {\n"
-    "        value = gl_MaxVertexTextureImageUnits;\n"
-    "        minValue = 0;\n"
-    "    } else if (u_index == 4) {\n"
-    "        value = gl_MaxCombinedTextureImageUnits;\n"
-    "        minValue = 8;\n"
-    "    } else if (u_index == 5) {\n"
-    "        value = gl_MaxTextureImageUnits;\n"
-    "        minValue = 8;\n"
-    "    } else if (u_index == 6) {\n"
-    "        value = gl_MaxFragmentUniformVectors;\n"
-    "        minValue = 16;\n"
-    "    } else if (u_index == 7) {\n"
-    "        value = gl_MaxDrawBuffers;\n"
-    "        minValue = 1;\n"
-    "    }\n"
-    "    if (value >= minValue) {\n"
-    "        gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0); // green\n"
-    "    } else {\n"
-    "        gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); // red\n"
-    "    }\n"
-    "}\n";
-
 GLuint compile_shader_from_source(const char *source, GLenum type)
 {
     GLuint shader = glCreateShader(type);
@@ -71,7 +23,7 @@ GLuint compile_shader_from_source(const char *source, GLenum type)
         return 0;
     }
     glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+    PROFILE_CALL(glCompileShader(shader));
     GLint compiled;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
     if (!compiled)
@@ -121,7 +73,7 @@ GLuint create_shader_program_embedded(const char *vertex_src, const char *fragme
     }
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+    PROFILE_CALL(glLinkProgram(program));
     GLint linked;
     glGetProgramiv(program, GL_LINK_STATUS, &linked);
     if (!linked)
@@ -165,21 +117,28 @@ void init()
         exit(1);
     }
     glfwMakeContextCurrent(window);
-    shaderProgram = create_shader_program_embedded(glsl_limits_test_vert, glsl_limits_test_frag);
+    shaderProgram = create_shader_program_embedded(shader_glsl_limits_test_vert.source, shader_glsl_limits_test_frag.source);
     glUseProgram(shaderProgram);
     uIndexLoc = glGetUniformLocation(shaderProgram, "u_index");
+    // The uniform limits the shader checks, as the packed uniform blocks of
+    // common/uniform_block.h are sized against them
+    GLint vertexVectors = 0, fragmentVectors = 0;
+    glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &vertexVectors);
+    glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_VECTORS, &fragmentVectors);
+    printf("INFO: %d vertex and %d fragment uniform vectors\n", (int)vertexVectors, (int)fragmentVectors);
     float vertices[] = {
         -0.8f, -0.8f,
         0.8f, -0.8f,
         0.0f, 0.8f};
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
     posLoc = glGetAttribLocation(shaderProgram, "a_position");
 }
 
-void draw()
+void draw(const SampleClock *sampleClock)
 {
+    (void)sampleClock; // the scene does not change over time
     int win_w, win_h;
     glfwGetFramebufferSize(window, &win_w, &win_h);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -197,8 +156,8 @@ void draw()
         glDrawArrays(GL_TRIANGLES, 0, 3);
     }
     glDisableVertexAttribArray(posLoc);
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    PROFILE_CALL(glfwSwapBuffers(window));
+    PROFILE_CALL(glfwPollEvents());
 }
 
 void cleanup()
@@ -216,10 +175,15 @@ int main()
         fprintf(stderr, "Failed to initialize GLFW\n");
         return 1;
     }
-    init();
-    while (!glfwWindowShouldClose(window))
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock))
     {
-        draw();
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
     }
     cleanup();
     return 0;
@@ -0,0 +1,379 @@
+// sample_host.c
+// Runs several sample scenes at once, each in its own window with its own
+// context and on its own thread, the way one process drives several
+// displays. Every instance presents its frames independently.
+//
+// The run has two phases. First every instance renders its frames alone,
+// one instance after the other, which gives its uncontended frame time.
+// Then all instances render their frames at the same time. The report
+// gives, per instance, the frame time split into submitting the draw calls
+// and presenting (glfwSwapBuffers), and how much slower its frames got
+// with the other contexts running. The summary compares the total work
+// done against the wall time of the concurrent phase: with N instances an
+// implementation that scales perfectly is N times faster than running them
+// one after the other.
+//
+// GLFW creates windows and handles their events on the main thread only;
+// rendering and presenting happen on the instance threads.
+//
+// Usage: sample_host [instances] [frames] [swap interval]
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <scenes/blend_func_separate_scene.h>
+#include <scenes/qualifiers_scene.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLE_HOST_MAX_INSTANCES 16
+
+typedef enum SampleHostPhase
+{
+    SAMPLE_HOST_SOLO,
+    SAMPLE_HOST_CONCURRENT,
+    SAMPLE_HOST_PHASES
+} SampleHostPhase;
+
+// One scene's state; each instance has its own objects in its own context
+typedef union SampleHostScene
+{
+    BlendFuncSeparateScene blend;
+    QualifiersScene qualifiers;
+} SampleHostScene;
+
+typedef struct SampleHostSceneType
+{
+    const char *name;
+    int (*init)(SampleHostScene *scene);
+    void (*draw)(SampleHostScene *scene, int frame);
+    void (*destroy)(SampleHostScene *scene);
+} SampleHostSceneType;
+
+// Per-frame times in milliseconds
+typedef struct SampleHostTimes
+{
+    double *frame;
+    double *draw;
+    double *present;
+    int count;
+    double start;
+    double end;
+} SampleHostTimes;
+
+typedef struct SampleHostInstance
+{
+    int index;
+    const SampleHostSceneType *type;
+    GLFWwindow *window;
+    pthread_t thread;
+    int ok;
+    SampleHostTimes times[SAMPLE_HOST_PHASES];
+} SampleHostInstance;
+
+static int instanceCount = 4;
+static int frameCount = 300;
+static int swapInterval = 0;
+static int width = 400;
+static int height = 400;
+static SampleHostInstance instances[SAMPLE_HOST_MAX_INSTANCES];
+
+// Solo turns are handed from one instance to the next; turn == instanceCount
+// starts the concurrent phase
+static pthread_mutex_t turnLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t turnChanged = PTHREAD_COND_INITIALIZER;
+static int turn;
+static pthread_barrier_t concurrentStart;
+static atomic_int finishedCount;
+
+static double sample_host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ---------------------------------------------------------------------------
+// Scenes, the same code as the samples of the same name
+
+static int blend_init(SampleHostScene *scene)
+{
+    return blend_func_separate_scene_init(&scene->blend);
+}
+
+// The combination changes every 30 frames
+static void blend_draw(SampleHostScene *scene, int frame)
+{
+    blend_func_separate_scene_update(&scene->blend, frame / 30.0);
+    blend_func_separate_scene_draw(&scene->blend, width, height);
+}
+
+static void blend_destroy(SampleHostScene *scene)
+{
+    blend_func_separate_scene_destroy(&scene->blend);
+}
+
+static int qualifiers_init(SampleHostScene *scene)
+{
+    return qualifiers_scene_init(&scene->qualifiers);
+}
+
+// The triangle's colour cycles so consecutive frames differ
+static void qualifiers_draw(SampleHostScene *scene, int frame)
+{
+    scene->qualifiers.color[0] = (float)(frame % 60) / 60.0f;
+    qualifiers_scene_draw(&scene->qualifiers, width, height);
+}
+
+static void qualifiers_destroy(SampleHostScene *scene)
+{
+    qualifiers_scene_destroy(&scene->qualifiers);
+}
+
+static const SampleHostSceneType sceneTypes[] = {
+    {"glBlendFuncSeparate", blend_init, blend_draw, blend_destroy},
+    {"qualifiers", qualifiers_init, qualifiers_draw, qualifiers_destroy},
+};
+#define SCENE_TYPE_COUNT ((int)(sizeof(sceneTypes) / sizeof(sceneTypes[0])))
+
+// ---------------------------------------------------------------------------
+// Instance threads
+
+static int allocate_times(SampleHostTimes *times)
+{
+    times->frame = (double *)calloc((size_t)frameCount, sizeof(double));
+    times->draw = (double *)calloc((size_t)frameCount, sizeof(double));
+    times->present = (double *)calloc((size_t)frameCount, sizeof(double));
+    return times->frame && times->draw && times->present;
+}
+
+static void render_frames(SampleHostInstance *instance, SampleHostScene *scene, SampleHostTimes *times)
+{
+    times->start = sample_host_seconds();
+    double previous = times->start;
+    for (int frame = 0; frame < frameCount && !glfwWindowShouldClose(instance->window); ++frame)
+    {
+        double drawStart = sample_host_seconds();
+        instance->type->draw(scene, frame);
+        double presentStart = sample_host_seconds();
+        glfwSwapBuffers(instance->window);
+        double end = sample_host_seconds();
+        times->draw[frame] = (presentStart - drawStart) * 1000.0;
+        times->present[frame] = (end - presentStart) * 1000.0;
+        times->frame[frame] = (end - previous) * 1000.0;
+        times->count = frame + 1;
+        previous = end;
+    }
+    times->end = previous;
+}
+
+static void wait_for_turn(int wanted)
+{
+    pthread_mutex_lock(&turnLock);
+    while (turn < wanted)
+        pthread_cond_wait(&turnChanged, &turnLock);
+    pthread_mutex_unlock(&turnLock);
+}
+
+static void pass_turn(void)
+{
+    pthread_mutex_lock(&turnLock);
+    turn++;
+    pthread_cond_broadcast(&turnChanged);
+    pthread_mutex_unlock(&turnLock);
+}
+
+static void *instance_main(void *userData)
+{
+    SampleHostInstance *instance = (SampleHostInstance *)userData;
+    SampleHostScene scene = {0};
+    glfwMakeContextCurrent(instance->window);
+    glfwSwapInterval(swapInterval);
+    instance->ok = instance->type->init(&scene) && allocate_times(&instance->times[SAMPLE_HOST_SOLO]) &&
+                   allocate_times(&instance->times[SAMPLE_HOST_CONCURRENT]);
+
+    wait_for_turn(instance->index);
+    if (instance->ok)
+    {
+        // The first frames after creating a context are often slow
+        render_frames(instance, &scene, &instance->times[SAMPLE_HOST_SOLO]);
+        render_frames(instance, &scene, &instance->times[SAMPLE_HOST_SOLO]);
+    }
+    pass_turn();
+
+    wait_for_turn(instanceCount);
+    pthread_barrier_wait(&concurrentStart);
+    if (instance->ok)
+        render_frames(instance, &scene, &instance->times[SAMPLE_HOST_CONCURRENT]);
+
+    instance->type->destroy(&scene);
+    glfwMakeContextCurrent(NULL);
+    atomic_fetch_add(&finishedCount, 1);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Report
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts values in place
+static double percentile(double *values, int count, double p)
+{
+    if (count == 0)
+        return 0.0;
+    qsort(values, (size_t)count, sizeof(double), compare_doubles);
+    int index = (int)(p * (count - 1) + 0.5);
+    return values[index];
+}
+
+static double sum(const double *values, int count)
+{
+    double total = 0.0;
+    for (int i = 0; i < count; ++i)
+        total += values[i];
+    return total;
+}
+
+static void print_report(void)
+{
+    printf("%-3s %-20s %-10s %8s %8s %8s %9s %9s %8s\n", "#", "scene", "phase", "frames", "median", "p99",
+           "draw", "present", "slowdown");
+    double soloWork = 0.0;
+    double phaseStart = 0.0, phaseEnd = 0.0;
+    int concurrentFrames = 0;
+    for (int i = 0; i < instanceCount; ++i)
+    {
+        SampleHostInstance *instance = &instances[i];
+        if (!instance->ok)
+        {
+            printf("%-3d %-20s failed to initialize\n", i, instance->type->name);
+            continue;
+        }
+        double soloMedian = 0.0;
+        for (int phase = 0; phase < SAMPLE_HOST_PHASES; ++phase)
+        {
+            SampleHostTimes *times = &instance->times[phase];
+            int count = times->count;
+            double draw = sum(times->draw, count) / (count ? count : 1);
+            double present = sum(times->present, count) / (count ? count : 1);
+            double median = percentile(times->frame, count, 0.5);
+            double p99 = percentile(times->frame, count, 0.99);
+            if (phase == SAMPLE_HOST_SOLO)
+            {
+                soloMedian = median;
+                soloWork += sum(times->frame, count) / 1000.0;
+                printf("%-3d %-20s %-10s %8d %8.3f %8.3f %9.3f %9.3f %8s\n", i, instance->type->name, "solo",
+                       count, median, p99, draw, present, "");
+            }
+            else
+            {
+                if (concurrentFrames == 0 || times->start < phaseStart)
+                    phaseStart = times->start;
+                if (times->end > phaseEnd)
+                    phaseEnd = times->end;
+                concurrentFrames += count;
+                printf("%-3s %-20s %-10s %8d %8.3f %8.3f %9.3f %9.3f %7.2fx\n", "", "", "concurrent", count,
+                       median, p99, draw, present, soloMedian > 0.0 ? median / soloMedian : 0.0);
+            }
+        }
+    }
+    double wall = phaseEnd - phaseStart;
+    if (wall > 0.0)
+    {
+        printf("INFO: concurrent phase: %d frames in %.3f s, %.1f frames/s in total\n", concurrentFrames, wall,
+               concurrentFrames / wall);
+        printf("INFO: the same frames take %.3f s one instance at a time: %.2fx faster concurrently, "
+               "ideal %dx\n",
+               soloWork, soloWork / wall, instanceCount);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        instanceCount = atoi(argv[1]) > 0 ? atoi(argv[1]) : instanceCount;
+    if (argc > 2)
+        frameCount = atoi(argv[2]) > 0 ? atoi(argv[2]) : frameCount;
+    if (argc > 3)
+        swapInterval = atoi(argv[3]) >= 0 ? atoi(argv[3]) : swapInterval;
+    if (instanceCount > SAMPLE_HOST_MAX_INSTANCES)
+        instanceCount = SAMPLE_HOST_MAX_INSTANCES;
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    for (int i = 0; i < instanceCount; ++i)
+    {
+        SampleHostInstance *instance = &instances[i];
+        char title[64];
+        instance->index = i;
+        instance->type = &sceneTypes[i % SCENE_TYPE_COUNT];
+        snprintf(title, sizeof(title), "sample_host %d: %s", i, instance->type->name);
+        instance->window = glfwCreateWindow(width, height, title, NULL, NULL);
+        if (instance->window == NULL)
+        {
+            fprintf(stderr, "Failed to create GLFW window %d\n", i);
+            glfwTerminate();
+            return 1;
+        }
+    }
+    printf("INFO: %d instances, %d frames each, swap interval %d\n", instanceCount, frameCount, swapInterval);
+
+    pthread_barrier_init(&concurrentStart, NULL, (unsigned)instanceCount);
+    int started = 0;
+    for (; started < instanceCount; ++started)
+    {
+        if (pthread_create(&instances[started].thread, NULL, instance_main, &instances[started]) != 0)
+        {
+            printf("ERROR: Failed to start instance thread %d\n", started);
+            break;
+        }
+    }
+    if (started < instanceCount)
+    {
+        // The instances that did start wait for the others forever
+        glfwTerminate();
+        return 1;
+    }
+
+    // Events are handled here while the instance threads render
+    while (atomic_load(&finishedCount) < instanceCount)
+    {
+        glfwPollEvents();
+        struct timespec pause = {0, 2000000};
+        nanosleep(&pause, NULL);
+    }
+    for (int i = 0; i < instanceCount; ++i)
+        pthread_join(instances[i].thread, NULL);
+    pthread_barrier_destroy(&concurrentStart);
+
+    print_report();
+
+    int ok = 1;
+    for (int i = 0; i < instanceCount; ++i)
+    {
+        ok &= instances[i].ok;
+        for (int phase = 0; phase < SAMPLE_HOST_PHASES; ++phase)
+        {
+            free(instances[i].times[phase].frame);
+            free(instances[i].times[phase].draw);
+            free(instances[i].times[phase].present);
+        }
+        glfwDestroyWindow(instances[i].window);
+    }
+    glfwTerminate();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <GLES2/gl2.h>
+#include <GLFW/glfw3.h>
+#include <common/instancing.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
+#include <stdio.h>
+
+// The points of vertex_variables, once per third of the window, in one
+// instanced draw instead of one draw per third (SAMPLES_INSTANCING=pseudo
+// forces the pseudo-instancing fallback)
+static GLFWwindow *window;
+static Instancing *instancing;
+
+void init()
+{
+    instancing = instancing_create(instancing_path_from_env(), shader_instanced_vert.source,
+                                   shader_color_frag.source, 2, 0);
+    if (!instancing)
+        return;
+    float points[4][3] = {
+        {-0.2f, 0.2f, 0.0f},
+        {0.2f, 0.2f, 0.0f},
+        {-0.2f, -0.2f, 0.0f},
+        {0.2f, -0.2f, 0.0f}};
+    instancing_set_mesh(instancing, &points[0][0], 4, 3);
+}
+
+void draw(const SampleClock *sampleClock)
+{
+    (void)sampleClock; // the scene does not change over time
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glViewport(0, 0, width, height);
+    // Each third squeezes x into its part of the window, as a viewport of
+    // its own would, and has its own point size: scale and offset, then
+    // colour and size
+    GLfloat instances[3][8] = {
+        {1.0f / 3.0f, 1.0f, -2.0f / 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 10.0f},
+        {1.0f / 3.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 30.0f},
+        {1.0f / 3.0f, 1.0f, 2.0f / 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 60.0f}};
+    if (instancing)
+        instancing_draw(instancing, GL_POINTS, &instances[0][0], 3);
+    // Swap front and back buffers
+    PROFILE_CALL(glfwSwapBuffers(window));
+    // Poll for and process events
+    PROFILE_CALL(glfwPollEvents());
+}
+
+void cleanup()
+{
+    instancing_destroy(instancing);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+int main(void)
+{
+    // Initialize GLFW
+    if (!glfwInit())
+    {
+        printf("ERROR: Failed to initialize GLFW\n");
+        return -1;
+    }
+
+    // Set GLFW window hints for OpenGL ES 2.0
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+
+    // Create a windowed mode window and its OpenGL context
+    window = glfwCreateWindow(1200, 800, "Instanced Points Example", NULL, NULL);
+    if (!window)
+    {
+        printf("ERROR: Failed to create GLFW window\n");
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock))
+    {
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
+    }
+
+    cleanup();
+    return 0;
+}
@@ -0,0 +1,163 @@
+// mesh.c
+#include "mesh/mesh.h"
+
+#include <GLFW/glfw3.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int mesh_section_fits(uint64_t offset, uint64_t bytes, size_t size)
+{
+    return offset % MESH_FILE_ALIGNMENT == 0 && offset >= sizeof(MeshFileHeader) && offset <= size &&
+           bytes <= size - offset;
+}
+
+int mesh_file_map(const char *path, MeshFile *file)
+{
+    memset(file, 0, sizeof(*file));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        printf("ERROR: mesh: cannot open %s\n", path);
+        return 0;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(MeshFileHeader))
+    {
+        printf("ERROR: mesh: %s is not a mesh file\n", path);
+        close(fd);
+        return 0;
+    }
+    void *mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        printf("ERROR: mesh: cannot map %s\n", path);
+        return 0;
+    }
+    file->mapping = mapping;
+    file->size = (size_t)status.st_size;
+    file->header = (const MeshFileHeader *)mapping;
+
+    const MeshFileHeader *header = file->header;
+    if (header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION)
+    {
+        printf("ERROR: mesh: %s is not a version %d mesh file\n", path, MESH_FILE_VERSION);
+        mesh_file_unmap(file);
+        return 0;
+    }
+    if (header->vertexStride != mesh_vertex_stride(header->attributes) ||
+        (header->indexSize != 2 && header->indexSize != 4) || header->indexCount % 3 != 0 ||
+        !mesh_section_fits(header->vertexOffset, (uint64_t)header->vertexCount * header->vertexStride, file->size) ||
+        !mesh_section_fits(header->indexOffset, (uint64_t)header->indexCount * header->indexSize, file->size))
+    {
+        printf("ERROR: mesh: %s is damaged\n", path);
+        mesh_file_unmap(file);
+        return 0;
+    }
+    file->vertices = (const char *)mapping + header->vertexOffset;
+    file->indices = (const char *)mapping + header->indexOffset;
+    // Start reading the pages now; the upload touches all of them
+    madvise(mapping, file->size, MADV_WILLNEED);
+    return 1;
+}
+
+void mesh_file_unmap(MeshFile *file)
+{
+    if (file->mapping)
+        munmap(file->mapping, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+int mesh_upload(const MeshFile *file, Mesh *mesh)
+{
+    const MeshFileHeader *header = file->header;
+    memset(mesh, 0, sizeof(*mesh));
+    if (header->indexSize == 4 && !glfwExtensionSupported("GL_OES_element_index_uint"))
+    {
+        printf("ERROR: mesh: %u vertices need 32-bit indices (GL_OES_element_index_uint)\n", header->vertexCount);
+        return 0;
+    }
+    glGenBuffers(1, &mesh->vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)header->vertexCount * header->vertexStride, file->vertices,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glGenBuffers(1, &mesh->indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)header->indexCount * header->indexSize, file->indices,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (glGetError() == GL_OUT_OF_MEMORY)
+    {
+        printf("ERROR: mesh: out of memory\n");
+        mesh_destroy(mesh);
+        return 0;
+    }
+    mesh->indexType = header->indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh->indexCount = (GLsizei)header->indexCount;
+    mesh->vertexStride = (GLsizei)header->vertexStride;
+    mesh->attributes = header->attributes;
+    memcpy(mesh->boundsMin, header->boundsMin, sizeof(mesh->boundsMin));
+    memcpy(mesh->boundsMax, header->boundsMax, sizeof(mesh->boundsMax));
+    return 1;
+}
+
+int mesh_load(const char *path, Mesh *mesh)
+{
+    MeshFile file;
+    if (!mesh_file_map(path, &file))
+        return 0;
+    int ok = mesh_upload(&file, mesh);
+    mesh_file_unmap(&file);
+    return ok;
+}
+
+void mesh_destroy(Mesh *mesh)
+{
+    glDeleteBuffers(1, &mesh->vertexBuffer);
+    glDeleteBuffers(1, &mesh->indexBuffer);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+void mesh_draw(const Mesh *mesh, GLint positionLocation, GLint normalLocation, GLint texcoordLocation)
+{
+    if (!(mesh->attributes & MESH_ATTRIBUTE_NORMAL))
+        normalLocation = -1;
+    if (!(mesh->attributes & MESH_ATTRIBUTE_TEXCOORD))
+        texcoordLocation = -1;
+    size_t texcoordOffset = (mesh->attributes & MESH_ATTRIBUTE_NORMAL ? 6 : 3) * sizeof(float);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+    if (positionLocation >= 0)
+    {
+        glVertexAttribPointer((GLuint)positionLocation, 3, GL_FLOAT, GL_FALSE, mesh->vertexStride, (void *)0);
+        glEnableVertexAttribArray((GLuint)positionLocation);
+    }
+    if (normalLocation >= 0)
+    {
+        glVertexAttribPointer((GLuint)normalLocation, 3, GL_FLOAT, GL_FALSE, mesh->vertexStride,
+                              (void *)(3 * sizeof(float)));
+        glEnableVertexAttribArray((GLuint)normalLocation);
+    }
+    if (texcoordLocation >= 0)
+    {
+        glVertexAttribPointer((GLuint)texcoordLocation, 2, GL_FLOAT, GL_FALSE, mesh->vertexStride,
+                              (void *)texcoordOffset);
+        glEnableVertexAttribArray((GLuint)texcoordLocation);
+    }
+    glDrawElements(GL_TRIANGLES, mesh->indexCount, mesh->indexType, (void *)0);
+    if (positionLocation >= 0)
+        glDisableVertexAttribArray((GLuint)positionLocation);
+    if (normalLocation >= 0)
+        glDisableVertexAttribArray((GLuint)normalLocation);
+    if (texcoordLocation >= 0)
+        glDisableVertexAttribArray((GLuint)texcoordLocation);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
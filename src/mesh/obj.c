@@ -0,0 +1,312 @@
+// obj.c
+// Faces are first collected as position/texcoord/normal index triples,
+// deduplicated through an open-addressing hash table; the interleaved
+// vertices are built once the whole file has been read, when it is known
+// which attributes the faces use.
+#include "mesh/obj.h"
+#include "mesh/mesh_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OBJ_NONE 0xffffffffu
+#define OBJ_MAX_POLYGON 64
+
+typedef struct ObjKey
+{
+    uint32_t position;
+    uint32_t texcoord;
+    uint32_t normal;
+} ObjKey;
+
+typedef struct ObjParser
+{
+    float *positions; // 3 per entry
+    uint32_t positionCount, positionCapacity;
+    float *texcoords; // 2 per entry
+    uint32_t texcoordCount, texcoordCapacity;
+    float *normals; // 3 per entry
+    uint32_t normalCount, normalCapacity;
+    ObjKey *keys; // one per vertex
+    uint32_t keyCount, keyCapacity;
+    uint32_t *table; // vertex index + 1, 0: empty
+    uint32_t tableCapacity;
+    uint32_t *indices;
+    uint32_t indexCount, indexCapacity;
+    int line;
+} ObjParser;
+
+// Makes room for one more element. Returns 0 when out of memory.
+static int obj_reserve(void **data, uint32_t count, uint32_t *capacity, size_t elementSize)
+{
+    if (count < *capacity)
+        return 1;
+    uint32_t grown = *capacity ? *capacity * 2 : 256;
+    void *resized = realloc(*data, grown * elementSize);
+    if (!resized)
+        return 0;
+    *data = resized;
+    *capacity = grown;
+    return 1;
+}
+
+static uint32_t obj_hash(const ObjKey *key)
+{
+    uint32_t h = key->position * 0x9e3779b1u;
+    h ^= (key->texcoord + 0x7f4a7c15u) * 0x85ebca77u;
+    h ^= (key->normal + 0x165667b1u) * 0xc2b2ae3du;
+    return h ^ (h >> 15);
+}
+
+static int obj_grow_table(ObjParser *parser)
+{
+    uint32_t capacity = parser->tableCapacity ? parser->tableCapacity * 2 : 1024;
+    uint32_t *table = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    if (!table)
+        return 0;
+    for (uint32_t i = 0; i < parser->keyCount; ++i)
+    {
+        uint32_t slot = obj_hash(&parser->keys[i]) & (capacity - 1);
+        while (table[slot])
+            slot = (slot + 1) & (capacity - 1);
+        table[slot] = i + 1;
+    }
+    free(parser->table);
+    parser->table = table;
+    parser->tableCapacity = capacity;
+    return 1;
+}
+
+// Returns the vertex for a position/texcoord/normal triple, adding it the
+// first time, or OBJ_NONE when out of memory.
+static uint32_t obj_vertex(ObjParser *parser, const ObjKey *key)
+{
+    if (parser->keyCount * 2 >= parser->tableCapacity && !obj_grow_table(parser))
+        return OBJ_NONE;
+    uint32_t slot = obj_hash(key) & (parser->tableCapacity - 1);
+    while (parser->table[slot])
+    {
+        const ObjKey *other = &parser->keys[parser->table[slot] - 1];
+        if (other->position == key->position && other->texcoord == key->texcoord && other->normal == key->normal)
+            return parser->table[slot] - 1;
+        slot = (slot + 1) & (parser->tableCapacity - 1);
+    }
+    if (!obj_reserve((void **)&parser->keys, parser->keyCount, &parser->keyCapacity, sizeof(ObjKey)))
+        return OBJ_NONE;
+    parser->keys[parser->keyCount] = *key;
+    parser->table[slot] = parser->keyCount + 1;
+    return parser->keyCount++;
+}
+
+// Reads count floats from the rest of the line; extra values are ignored.
+static int obj_floats(const char *p, const char *lineEnd, float *out, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        char *next;
+        out[i] = strtof(p, &next);
+        if (next == p || next > lineEnd)
+            return 0;
+        p = next;
+    }
+    return 1;
+}
+
+// Resolves a 1-based or negative (relative) OBJ index.
+static uint32_t obj_resolve(long index, uint32_t count)
+{
+    if (index > 0 && (unsigned long)index <= count)
+        return (uint32_t)(index - 1);
+    if (index < 0 && (unsigned long)-index <= count)
+        return (uint32_t)((long)count + index);
+    return OBJ_NONE;
+}
+
+static int obj_face(ObjParser *parser, const char *p, const char *lineEnd)
+{
+    uint32_t polygon[OBJ_MAX_POLYGON];
+    int corners = 0;
+    while (p < lineEnd)
+    {
+        while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r'))
+            ++p;
+        if (p >= lineEnd)
+            break;
+        char *next;
+        ObjKey key = {OBJ_NONE, OBJ_NONE, OBJ_NONE};
+        key.position = obj_resolve(strtol(p, &next, 10), parser->positionCount);
+        if (next == p || key.position == OBJ_NONE)
+            return 0;
+        p = next;
+        if (*p == '/')
+        {
+            ++p;
+            if (*p != '/')
+            {
+                key.texcoord = obj_resolve(strtol(p, &next, 10), parser->texcoordCount);
+                if (next == p || key.texcoord == OBJ_NONE)
+                    return 0;
+                p = next;
+            }
+            if (*p == '/')
+            {
+                ++p;
+                key.normal = obj_resolve(strtol(p, &next, 10), parser->normalCount);
+                if (next == p || key.normal == OBJ_NONE)
+                    return 0;
+                p = next;
+            }
+        }
+        if (corners == OBJ_MAX_POLYGON)
+            return 0;
+        polygon[corners] = obj_vertex(parser, &key);
+        if (polygon[corners++] == OBJ_NONE)
+            return 0;
+    }
+    if (corners < 3)
+        return 0;
+    for (int i = 2; i < corners; ++i)
+    {
+        uint32_t triangle[3] = {polygon[0], polygon[i - 1], polygon[i]};
+        for (int j = 0; j < 3; ++j)
+        {
+            if (!obj_reserve((void **)&parser->indices, parser->indexCount, &parser->indexCapacity,
+                             sizeof(uint32_t)))
+                return 0;
+            parser->indices[parser->indexCount++] = triangle[j];
+        }
+    }
+    return 1;
+}
+
+static int obj_build(ObjParser *parser, ObjMesh *mesh)
+{
+    mesh->attributes = 0;
+    for (uint32_t i = 0; i < parser->keyCount; ++i)
+    {
+        if (parser->keys[i].normal != OBJ_NONE)
+            mesh->attributes |= MESH_ATTRIBUTE_NORMAL;
+        if (parser->keys[i].texcoord != OBJ_NONE)
+            mesh->attributes |= MESH_ATTRIBUTE_TEXCOORD;
+    }
+    mesh->vertexStride = mesh_vertex_stride(mesh->attributes) / (uint32_t)sizeof(float);
+    mesh->vertexCount = parser->keyCount;
+    mesh->vertices = (float *)calloc((size_t)parser->keyCount * mesh->vertexStride + 1, sizeof(float));
+    if (!mesh->vertices)
+        return 0;
+    for (uint32_t i = 0; i < parser->keyCount; ++i)
+    {
+        const ObjKey *key = &parser->keys[i];
+        float *vertex = mesh->vertices + (size_t)i * mesh->vertexStride;
+        memcpy(vertex, parser->positions + (size_t)key->position * 3, 3 * sizeof(float));
+        vertex += 3;
+        if (mesh->attributes & MESH_ATTRIBUTE_NORMAL)
+        {
+            if (key->normal != OBJ_NONE)
+                memcpy(vertex, parser->normals + (size_t)key->normal * 3, 3 * sizeof(float));
+            vertex += 3;
+        }
+        if ((mesh->attributes & MESH_ATTRIBUTE_TEXCOORD) && key->texcoord != OBJ_NONE)
+            memcpy(vertex, parser->texcoords + (size_t)key->texcoord * 2, 2 * sizeof(float));
+    }
+    mesh->indices = parser->indices;
+    mesh->indexCount = parser->indexCount;
+    parser->indices = NULL;
+    return 1;
+}
+
+int obj_parse(const char *text, ObjMesh *mesh)
+{
+    memset(mesh, 0, sizeof(*mesh));
+    ObjParser parser;
+    memset(&parser, 0, sizeof(parser));
+    int ok = 1;
+    for (const char *p = text; *p && ok;)
+    {
+        const char *lineEnd = strchr(p, '\n');
+        if (!lineEnd)
+            lineEnd = p + strlen(p);
+        parser.line++;
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            ok = obj_reserve((void **)&parser.positions, parser.positionCount, &parser.positionCapacity,
+                             3 * sizeof(float)) &&
+                 obj_floats(p + 2, lineEnd, parser.positions + (size_t)parser.positionCount++ * 3, 3);
+        }
+        else if (p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            ok = obj_reserve((void **)&parser.texcoords, parser.texcoordCount, &parser.texcoordCapacity,
+                             2 * sizeof(float)) &&
+                 obj_floats(p + 3, lineEnd, parser.texcoords + (size_t)parser.texcoordCount++ * 2, 2);
+        }
+        else if (p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            ok = obj_reserve((void **)&parser.normals, parser.normalCount, &parser.normalCapacity,
+                             3 * sizeof(float)) &&
+                 obj_floats(p + 3, lineEnd, parser.normals + (size_t)parser.normalCount++ * 3, 3);
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            ok = obj_face(&parser, p + 2, lineEnd);
+        }
+        if (!ok)
+            printf("ERROR: obj: line %d: cannot read \"%.*s\"\n", parser.line, (int)(lineEnd - p), p);
+        p = *lineEnd ? lineEnd + 1 : lineEnd;
+    }
+    if (ok && parser.indexCount == 0)
+    {
+        printf("ERROR: obj: no faces\n");
+        ok = 0;
+    }
+    if (ok && !obj_build(&parser, mesh))
+    {
+        printf("ERROR: obj: out of memory\n");
+        ok = 0;
+    }
+    free(parser.positions);
+    free(parser.texcoords);
+    free(parser.normals);
+    free(parser.keys);
+    free(parser.table);
+    free(parser.indices);
+    if (!ok)
+        obj_free(mesh);
+    return ok;
+}
+
+int obj_load(const char *path, ObjMesh *mesh)
+{
+    memset(mesh, 0, sizeof(*mesh));
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        printf("ERROR: obj: cannot open %s\n", path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = size >= 0 ? (char *)malloc((size_t)size + 1) : NULL;
+    int ok = text && fread(text, 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+    if (!ok)
+    {
+        printf("ERROR: obj: cannot read %s\n", path);
+        free(text);
+        return 0;
+    }
+    text[size] = '\0';
+    ok = obj_parse(text, mesh);
+    free(text);
+    return ok;
+}
+
+void obj_free(ObjMesh *mesh)
+{
+    free(mesh->vertices);
+    free(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+}
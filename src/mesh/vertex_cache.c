@@ -0,0 +1,253 @@
+// vertex_cache.c
+// Forsyth's optimizer keeps, per vertex, its score and the triangles not
+// emitted yet, and per triangle the sum of its vertices' scores. After a
+// triangle is emitted only the vertices in the modelled cache change their
+// score, so only their triangles are rescored, and the best of those is
+// emitted next. When none of them is left (the end of an island) the best
+// remaining triangle of the whole mesh is taken.
+#include "mesh/vertex_cache.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+// Valences above this share the last boost value
+#define FORSYTH_MAX_VALENCE 32
+
+double vertex_cache_acmr(const uint32_t *indices, uint32_t indexCount, uint32_t vertexCount, int cacheSize)
+{
+    if (indexCount < 3)
+        return 0.0;
+    // A vertex is in the FIFO while fewer than cacheSize misses happened
+    // since it was loaded; its stamp is the number of the miss that loaded
+    // it, counting from 1, or 0 when it was never loaded
+    uint32_t *stamps = (uint32_t *)calloc(vertexCount ? vertexCount : 1, sizeof(uint32_t));
+    if (!stamps)
+        return 0.0;
+    uint32_t misses = 0;
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t v = indices[i];
+        if (stamps[v] == 0 || misses - stamps[v] >= (uint32_t)cacheSize)
+            stamps[v] = ++misses;
+    }
+    free(stamps);
+    return (double)misses / (double)(indexCount / 3);
+}
+
+typedef struct ForsythVertex
+{
+    float score;
+    int cachePosition; // -1: not in the cache
+    uint32_t firstTriangle; // into the adjacency array
+    uint32_t activeTriangles;
+} ForsythVertex;
+
+static float cacheScores[VERTEX_CACHE_SIZE];
+static float valenceScores[FORSYTH_MAX_VALENCE + 1];
+
+static void forsyth_init_scores(void)
+{
+    for (int i = 0; i < VERTEX_CACHE_SIZE; ++i)
+    {
+        // The last triangle's vertices get a fixed score, so the order
+        // within it does not matter
+        if (i < 3)
+            cacheScores[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+        else
+            cacheScores[i] = powf(1.0f - (float)(i - 3) / (float)(VERTEX_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+    }
+    valenceScores[0] = 0.0f;
+    for (int i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+        valenceScores[i] = FORSYTH_VALENCE_BOOST_SCALE * powf((float)i, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+static float forsyth_score(const ForsythVertex *vertex)
+{
+    if (vertex->activeTriangles == 0)
+        return -1.0f; // no triangle left to help
+    float score = vertex->cachePosition >= 0 ? cacheScores[vertex->cachePosition] : 0.0f;
+    uint32_t valence = vertex->activeTriangles < FORSYTH_MAX_VALENCE ? vertex->activeTriangles : FORSYTH_MAX_VALENCE;
+    return score + valenceScores[valence];
+}
+
+int vertex_cache_optimize(uint32_t *indices, uint32_t indexCount, uint32_t vertexCount)
+{
+    uint32_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return 1;
+    forsyth_init_scores();
+
+    ForsythVertex *vertices = (ForsythVertex *)calloc(vertexCount, sizeof(ForsythVertex));
+    uint32_t *adjacency = (uint32_t *)malloc((size_t)triangleCount * 3 * sizeof(uint32_t));
+    float *triangleScores = (float *)malloc((size_t)triangleCount * sizeof(float));
+    unsigned char *emitted = (unsigned char *)calloc(triangleCount, 1);
+    uint32_t *output = (uint32_t *)malloc((size_t)triangleCount * 3 * sizeof(uint32_t));
+    if (!vertices || !adjacency || !triangleScores || !emitted || !output)
+    {
+        free(vertices);
+        free(adjacency);
+        free(triangleScores);
+        free(emitted);
+        free(output);
+        return 0;
+    }
+
+    // Adjacency: the triangles of each vertex, stored contiguously
+    for (uint32_t i = 0; i < triangleCount * 3; ++i)
+        vertices[indices[i]].activeTriangles++;
+    uint32_t offset = 0;
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        vertices[v].firstTriangle = offset;
+        offset += vertices[v].activeTriangles;
+        vertices[v].activeTriangles = 0;
+        vertices[v].cachePosition = -1;
+    }
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            ForsythVertex *vertex = &vertices[indices[t * 3 + k]];
+            adjacency[vertex->firstTriangle + vertex->activeTriangles++] = t;
+        }
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        vertices[v].score = forsyth_score(&vertices[v]);
+
+    uint32_t best = 0;
+    float bestScore = -1.0f;
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t *triangle = &indices[t * 3];
+        triangleScores[t] = vertices[triangle[0]].score + vertices[triangle[1]].score + vertices[triangle[2]].score;
+        if (triangleScores[t] > bestScore)
+        {
+            bestScore = triangleScores[t];
+            best = t;
+        }
+    }
+
+    // The cache holds up to VERTEX_CACHE_SIZE vertices plus the three of the
+    // triangle just added, which push the oldest ones out
+    uint32_t cache[VERTEX_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    uint32_t scanStart = 0; // triangles before it are all emitted
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (bestScore < 0.0f)
+        {
+            // Dead end: the best triangle anywhere
+            while (emitted[scanStart])
+                ++scanStart;
+            best = scanStart;
+            bestScore = triangleScores[best];
+            for (uint32_t t = scanStart + 1; t < triangleCount; ++t)
+            {
+                if (!emitted[t] && triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+
+        const uint32_t *triangle = &indices[best * 3];
+        memcpy(&output[emittedCount * 3], triangle, 3 * sizeof(uint32_t));
+        emitted[best] = 1;
+
+        uint32_t newCache[VERTEX_CACHE_SIZE + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            ForsythVertex *vertex = &vertices[triangle[k]];
+            uint32_t *list = &adjacency[vertex->firstTriangle];
+            for (uint32_t i = 0; i < vertex->activeTriangles; ++i)
+            {
+                if (list[i] == best)
+                {
+                    list[i] = list[--vertex->activeTriangles];
+                    break;
+                }
+            }
+            newCache[newCount++] = triangle[k];
+        }
+        for (int i = 0; i < cacheCount; ++i)
+        {
+            uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache[newCount++] = v;
+        }
+        for (int i = 0; i < newCount; ++i)
+        {
+            ForsythVertex *vertex = &vertices[newCache[i]];
+            vertex->cachePosition = i < VERTEX_CACHE_SIZE ? i : -1;
+            vertex->score = forsyth_score(vertex);
+        }
+
+        // Rescore the remaining triangles of every vertex whose cache
+        // position changed, including the ones just pushed out
+        bestScore = -1.0f;
+        for (int i = 0; i < newCount; ++i)
+        {
+            const ForsythVertex *vertex = &vertices[newCache[i]];
+            const uint32_t *list = &adjacency[vertex->firstTriangle];
+            for (uint32_t j = 0; j < vertex->activeTriangles; ++j)
+            {
+                uint32_t t = list[j];
+                const uint32_t *other = &indices[t * 3];
+                float score = vertices[other[0]].score + vertices[other[1]].score + vertices[other[2]].score;
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+        cacheCount = newCount < VERTEX_CACHE_SIZE ? newCount : VERTEX_CACHE_SIZE;
+        memcpy(cache, newCache, (size_t)cacheCount * sizeof(uint32_t));
+    }
+
+    memcpy(indices, output, (size_t)triangleCount * 3 * sizeof(uint32_t));
+    free(vertices);
+    free(adjacency);
+    free(triangleScores);
+    free(emitted);
+    free(output);
+    return 1;
+}
+
+uint32_t vertex_fetch_optimize(float *vertices, uint32_t stride, uint32_t vertexCount, uint32_t *indices,
+                               uint32_t indexCount)
+{
+    uint32_t *remap = (uint32_t *)malloc((vertexCount ? vertexCount : 1) * sizeof(uint32_t));
+    float *reordered = (float *)malloc(((size_t)vertexCount * stride + 1) * sizeof(float));
+    if (!remap || !reordered)
+    {
+        free(remap);
+        free(reordered);
+        return 0;
+    }
+    memset(remap, 0xff, vertexCount * sizeof(uint32_t));
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t v = indices[i];
+        if (remap[v] == 0xffffffffu)
+        {
+            remap[v] = next;
+            memcpy(reordered + (size_t)next * stride, vertices + (size_t)v * stride, stride * sizeof(float));
+            next++;
+        }
+        indices[i] = remap[v];
+    }
+    memcpy(vertices, reordered, (size_t)next * stride * sizeof(float));
+    free(remap);
+    free(reordered);
+    return next;
+}
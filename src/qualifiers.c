@@ -3,166 +3,53 @@
 //
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <common/shader_reload.h>
+#include <scenes/qualifiers_scene.h>
+#include <shaders.h>
 #include <stdio.h>
-#include <stdlib.h>
 
 static GLFWwindow *window;
-static GLuint shaderProgram;
+static QualifiersScene scene;
+static int width = 800;
+static int height = 600;
 
-static GLuint vbo;
-static GLint aPositionLoc;
-static GLint uniVarLoc;
-
-// Embedded shader sources
-static const char *qualifiers_vert =
-    "#version 100\n"
-    "// attribute: per-vertex input\n"
-    "attribute vec3 aPosition;\n"
-    "// uniform: constant for all vertices\n"
-    "uniform vec3 vColor;\n"
-    "// varying: passed to fragment shader\n"
-    "varying vec3 varyVar;\n"
-    "// None (local variable)\n"
-    "float localVar = 0.2;\n"
-    "// const (compile-time constant)\n"
-    "const float constVar = 0.3;\n"
-    "void main() {\n"
-    "    varyVar = vColor;\n"
-    "    gl_Position = vec4(aPosition.x - localVar - constVar, aPosition.y - localVar - constVar, 0.0, 1.0);\n"
-    "}\n";
-static const char *qualifiers_frag =
-    "#version 100\n"
-    "precision mediump float;\n"
-    "varying vec3 varyVar;\n"
-    "void main() {\n"
-    "    gl_FragColor = vec4(varyVar, 1.0f); // Use the varying variable\n"
-    "}\n";
-
-GLuint compile_shader_from_source(const char *source, GLenum type)
-{
-    GLuint shader = glCreateShader(type);
-    if (!shader)
-    {
-        printf("ERROR: Failed to create shader object\n");
-        return 0;
-    }
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-    GLint compiled;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
-    if (!compiled)
-    {
-        GLint logLength = 0;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
-        char *infoLog = (char *)malloc(logLength);
-        if (infoLog)
-        {
-            glGetShaderInfoLog(shader, logLength, NULL, infoLog);
-            printf("ERROR: Shader compilation failed: %s\n", infoLog);
-            free(infoLog);
-        }
-        else
-        {
-            printf("ERROR: Shader compilation failed. (Could not allocate infoLog)\n");
-        }
-        glDeleteShader(shader);
-        return 0;
-    }
-    printf("INFO: Shader compiled successfully\n");
-    return shader;
-}
-
-GLuint create_shader_program_embedded(const char *vertex_src, const char *fragment_src)
+void init()
 {
-    GLuint vertexShader = compile_shader_from_source(vertex_src, GL_VERTEX_SHADER);
-    if (!vertexShader)
-    {
-        printf("ERROR: Vertex shader compilation failed\n");
-        return 0;
-    }
-    GLuint fragmentShader = compile_shader_from_source(fragment_src, GL_FRAGMENT_SHADER);
-    if (!fragmentShader)
-    {
-        printf("ERROR: Fragment shader compilation failed\n");
-        glDeleteShader(vertexShader);
-        return 0;
-    }
-    GLuint program = glCreateProgram();
-    if (!program)
-    {
-        printf("ERROR: Failed to create shader program\n");
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-        return 0;
-    }
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-    GLint linked;
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
-    if (!linked)
-    {
-        GLint logLength = 0;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-        char *infoLog = (char *)malloc(logLength);
-        if (infoLog)
-        {
-            glGetProgramInfoLog(program, logLength, NULL, infoLog);
-            printf("ERROR: Program linking failed: %s\n", infoLog);
-            free(infoLog);
-        }
-        else
-        {
-            printf("ERROR: Program linking failed. (Could not allocate infoLog)\n");
-        }
-        glDeleteProgram(program);
-        program = 0;
-    }
-    else
+    // shader_program_create only reports failures; the sample keeps
+    // reporting each stage and the link as it did before the scene moved
+    // out, while sample_host stays quiet
+    if (qualifiers_scene_init(&scene))
     {
+        printf("INFO: Shader compiled successfully\n");
+        printf("INFO: Shader compiled successfully\n");
         printf("INFO: Shader program linked successfully\n");
     }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    return program;
 }
 
-void init()
+static void shaders_reloaded(GLuint program, void *userData)
 {
-    shaderProgram = create_shader_program_embedded(qualifiers_vert, qualifiers_frag);
-    float vertices[] = {
-        -0.5f, -0.5f, 0.0f,
-        0.5f, -0.5f, 0.0f,
-        0.0f, 0.5f, 0.0f};
-
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    aPositionLoc = glGetAttribLocation(shaderProgram, "aPosition");
-    uniVarLoc = glGetUniformLocation(shaderProgram, "vColor");
+    (void)program;
+    qualifiers_scene_reloaded((QualifiersScene *)userData);
 }
 
-void draw()
+void draw(const SampleClock *sampleClock)
 {
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    glUseProgram(shaderProgram);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glEnableVertexAttribArray(aPositionLoc);
-    glVertexAttribPointer(aPositionLoc, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
-    glUniform3f(uniVarLoc, 0.0f, 1.0f, 0.0f); // Set uniform color to white
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-
-    glDisableVertexAttribArray(aPositionLoc);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    (void)sampleClock; // the scene does not change over time
+    qualifiers_scene_draw(&scene, width, height);
 
     // Swap front and back buffers
-    glfwSwapBuffers(window);
+    PROFILE_CALL(glfwSwapBuffers(window));
     // Poll for and process events
-    glfwPollEvents();
+    PROFILE_CALL(glfwPollEvents());
+}
+
+void cleanup()
+{
+    qualifiers_scene_destroy(&scene);
+    glfwDestroyWindow(window);
+    glfwTerminate();
 }
 
 int main(void)
@@ -180,7 +67,7 @@ int main(void)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 
     // Create a windowed mode window and its OpenGL context
-    window = glfwCreateWindow(800, 600, "Qualifiers Example", NULL, NULL);
+    window = glfwCreateWindow(width, height, "Qualifiers Example", NULL, NULL);
     if (!window)
     {
         printf("ERROR: Failed to create GLFW window\n");
@@ -189,11 +76,22 @@ int main(void)
     }
     glfwMakeContextCurrent(window);
 
-    init();
-    while (!glfwWindowShouldClose(window))
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    ShaderReloader *shaderReloader = shader_reload_create_from_env(window);
+    shader_reload_watch(shaderReloader, &scene.program, &shader_qualifiers_vert, &shader_qualifiers_frag,
+                        shaders_reloaded, &scene);
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock))
     {
-        draw();
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        shader_reload_update(shaderReloader);
+        PROFILE_CALL(draw(&sampleClock));
     }
+    shader_reload_destroy(shaderReloader);
+    cleanup();
 
     return 0;
 }
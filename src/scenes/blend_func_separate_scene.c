@@ -0,0 +1,99 @@
+// blend_func_separate_scene.c
+// See blend_func_separate_scene.h.
+#include "scenes/blend_func_separate_scene.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <shaders.h>
+
+#include <string.h>
+
+static const GLenum sFactorOptions[] = {
+    GL_ZERO, GL_ONE, GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR,
+    GL_DST_COLOR, GL_ONE_MINUS_DST_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+    GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_CONSTANT_COLOR, GL_ONE_MINUS_CONSTANT_COLOR,
+    GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA, GL_SRC_ALPHA_SATURATE};
+
+// GL_SRC_ALPHA_SATURATE is a source factor only
+static const GLenum dFactorOptions[] = {
+    GL_ZERO, GL_ONE, GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR,
+    GL_DST_COLOR, GL_ONE_MINUS_DST_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+    GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_CONSTANT_COLOR, GL_ONE_MINUS_CONSTANT_COLOR,
+    GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA};
+
+#define S_FACTOR_COUNT ((int)(sizeof(sFactorOptions) / sizeof(sFactorOptions[0])))
+#define D_FACTOR_COUNT ((int)(sizeof(dFactorOptions) / sizeof(dFactorOptions[0])))
+
+static const double comboDuration = 1.0; // seconds each combination is shown
+
+int blend_func_separate_scene_init(BlendFuncSeparateScene *scene)
+{
+    static const GLfloat vertices[] = {
+        -0.6f, -0.5f, 0.0f, // left
+        0.4f, -0.5f, 0.0f,  // right
+        -0.1f, 0.5f, 0.0f,  // top
+
+        -0.4f, -0.5f, 0.0f, // left
+        0.6f, -0.5f, 0.0f,  // right
+        0.1f, 0.5f, 0.0f    // top
+    };
+    memset(scene, 0, sizeof(*scene));
+    scene->sFactorAlpha = sFactorOptions[0];
+    scene->dFactorRGB = dFactorOptions[0];
+    scene->dFactorAlpha = dFactorOptions[0];
+    scene->program = shader_program_create(shader_blend_vert.source, shader_blend_frag.source, "aPos");
+    if (!scene->program)
+        return 0;
+    glGenBuffers(1, &scene->vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vertexBuffer);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
+    return 1;
+}
+
+int blend_func_separate_scene_update(BlendFuncSeparateScene *scene, double time)
+{
+    int totalCombos = S_FACTOR_COUNT * D_FACTOR_COUNT * D_FACTOR_COUNT;
+    int index = (int)((unsigned long long)(time / comboDuration) % (unsigned long long)totalCombos);
+    if (index == scene->comboIndex)
+        return 0;
+    scene->comboIndex = index;
+    scene->sFactorAlpha = sFactorOptions[index % S_FACTOR_COUNT];
+    scene->dFactorRGB = dFactorOptions[(index / S_FACTOR_COUNT) % D_FACTOR_COUNT];
+    scene->dFactorAlpha = dFactorOptions[(index / (S_FACTOR_COUNT * D_FACTOR_COUNT)) % D_FACTOR_COUNT];
+    return 1;
+}
+
+void blend_func_separate_scene_draw(const BlendFuncSeparateScene *scene, int width, int height)
+{
+    glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUseProgram(scene->program);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vertexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    int columnCount = 4;
+    int rowCount = 4;
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    for (int i = 0; i < rowCount; i++)
+    {
+        for (int j = 0; j < columnCount; j++)
+        {
+            glViewport(j * width / columnCount, i * height / rowCount, width / columnCount, height / rowCount);
+            glBlendFuncSeparate(sFactorOptions[(i * columnCount + j) % D_FACTOR_COUNT], scene->dFactorRGB,
+                                scene->sFactorAlpha, scene->dFactorAlpha);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glDrawArrays(GL_TRIANGLES, 3, 3);
+        }
+    }
+}
+
+void blend_func_separate_scene_destroy(BlendFuncSeparateScene *scene)
+{
+    glDeleteProgram(scene->program);
+    glDeleteBuffers(1, &scene->vertexBuffer);
+    scene->program = 0;
+    scene->vertexBuffer = 0;
+}
@@ -0,0 +1,60 @@
+// qualifiers_scene.c
+// See qualifiers_scene.h.
+#include "scenes/qualifiers_scene.h"
+#include "common/profiler.h"
+#include "common/shader_program.h"
+
+#include <shaders.h>
+
+#include <string.h>
+
+int qualifiers_scene_init(QualifiersScene *scene)
+{
+    static const GLfloat vertices[] = {
+        -0.5f, -0.5f, 0.0f,
+        0.5f, -0.5f, 0.0f,
+        0.0f, 0.5f, 0.0f};
+    memset(scene, 0, sizeof(*scene));
+    scene->color[1] = 1.0f;
+    scene->program =
+        shader_program_create(shader_qualifiers_vert.source, shader_qualifiers_frag.source, "aPosition");
+    if (!scene->program)
+        return 0;
+    qualifiers_scene_reloaded(scene);
+    glGenBuffers(1, &scene->vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vertexBuffer);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
+    return 1;
+}
+
+// The attribute location is bound before linking; the uniform's may change
+void qualifiers_scene_reloaded(QualifiersScene *scene)
+{
+    scene->colorLocation = glGetUniformLocation(scene->program, "vColor");
+}
+
+void qualifiers_scene_draw(const QualifiersScene *scene, int width, int height)
+{
+    glViewport(0, 0, width, height);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUseProgram(scene->program);
+
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    glUniform3fv(scene->colorLocation, 1, scene->color);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glDisableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void qualifiers_scene_destroy(QualifiersScene *scene)
+{
+    glDeleteProgram(scene->program);
+    glDeleteBuffers(1, &scene->vertexBuffer);
+    scene->program = 0;
+    scene->vertexBuffer = 0;
+}
@@ -0,0 +1,188 @@
+// swgl_context.c
+// Context lifetime, the per-thread current context and GL object names.
+#include "swgl_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+char swgl_placeholder_object;
+
+static _Thread_local SwglContext *swgl_current;
+
+GLuint swgl_names_alloc(SwglNameTable *table, void *object)
+{
+    if (table->next == 0)
+        table->next = 1; // name 0 is reserved
+    while (table->next < table->capacity && table->slots[table->next])
+        table->next++;
+    GLuint name = table->next;
+    swgl_names_set(table, name, object);
+    if (swgl_names_get(table, name) != object)
+        return 0;
+    table->next++;
+    return name;
+}
+
+void *swgl_names_get(const SwglNameTable *table, GLuint name)
+{
+    if (name == 0 || name >= table->capacity)
+        return NULL;
+    return table->slots[name];
+}
+
+void swgl_names_set(SwglNameTable *table, GLuint name, void *object)
+{
+    if (name == 0)
+        return;
+    if (name >= table->capacity)
+    {
+        GLuint capacity = table->capacity ? table->capacity : 64;
+        while (capacity <= name)
+            capacity *= 2;
+        void **slots = (void **)realloc(table->slots, capacity * sizeof(void *));
+        if (!slots)
+            return;
+        memset(slots + table->capacity, 0, (capacity - table->capacity) * sizeof(void *));
+        table->slots = slots;
+        table->capacity = capacity;
+    }
+    table->slots[name] = object;
+}
+
+void swgl_names_release(SwglNameTable *table, GLuint name)
+{
+    if (name == 0 || name >= table->capacity)
+        return;
+    table->slots[name] = NULL;
+    if (name < table->next)
+        table->next = name;
+}
+
+void swgl_names_free(SwglNameTable *table)
+{
+    free(table->slots);
+    memset(table, 0, sizeof(SwglNameTable));
+}
+
+SwglContext *swgl_context_create(int width, int height)
+{
+    SwglContext *ctx = (SwglContext *)calloc(1, sizeof(SwglContext));
+    if (!ctx)
+        return NULL;
+    ctx->width = width;
+    ctx->height = height;
+    ctx->color = (uint32_t *)calloc((size_t)width * height, sizeof(uint32_t));
+    if (!ctx->color)
+    {
+        free(ctx);
+        return NULL;
+    }
+    swgl_frame_init(&ctx->frame, width, height);
+    if (!ctx->frame.bins || !ctx->frame.activeTiles)
+    {
+        swgl_frame_free(&ctx->frame);
+        free(ctx->color);
+        free(ctx);
+        return NULL;
+    }
+
+    ctx->error = GL_NO_ERROR;
+    ctx->activeTexture = GL_TEXTURE0;
+    ctx->viewport[2] = width;
+    ctx->viewport[3] = height;
+    ctx->scissor[2] = width;
+    ctx->scissor[3] = height;
+    ctx->blendEquationRGB = GL_FUNC_ADD;
+    ctx->blendEquationAlpha = GL_FUNC_ADD;
+    ctx->blendSrcRGB = GL_ONE;
+    ctx->blendSrcAlpha = GL_ONE;
+    ctx->blendDstRGB = GL_ZERO;
+    ctx->blendDstAlpha = GL_ZERO;
+    memset(ctx->colorMask, 1, sizeof(ctx->colorMask));
+    ctx->cullFace = GL_BACK;
+    ctx->frontFace = GL_CCW;
+    ctx->depthRange[1] = 1.0f;
+    ctx->packAlignment = 4;
+    ctx->unpackAlignment = 4;
+    ctx->lineWidth = 1.0f;
+    for (int i = 0; i < SWGL_MAX_ATTRIBS; ++i)
+    {
+        ctx->attribs[i].size = 4;
+        ctx->attribs[i].type = GL_FLOAT;
+        ctx->attribs[i].current[3] = 1.0f;
+    }
+    return ctx;
+}
+
+static void swgl_free_objects(SwglContext *ctx)
+{
+    for (GLuint i = 0; i < ctx->buffers.capacity; ++i)
+    {
+        SwglBuffer *buffer = (SwglBuffer *)ctx->buffers.slots[i];
+        if (buffer)
+        {
+            free(buffer->data);
+            free(buffer);
+        }
+    }
+    for (GLuint i = 0; i < ctx->objects.capacity; ++i)
+    {
+        void *object = ctx->objects.slots[i];
+        if (!object)
+            continue;
+        if (*(int *)object == SWGL_OBJECT_SHADER)
+        {
+            SwglShader *shader = (SwglShader *)object;
+            swgl_shader_release(shader);
+            free(shader->source);
+            free(shader->infoLog);
+            free(shader);
+        }
+        else
+        {
+            SwglProgram *program = (SwglProgram *)object;
+            swgl_program_release(program);
+            for (int a = 0; a < SWGL_MAX_ATTRIBS; ++a)
+                free(program->boundAttribNames[a]);
+            free(program->uniforms);
+            free(program->uniformData);
+            free(program->infoLog);
+            free(program);
+        }
+    }
+    swgl_names_free(&ctx->buffers);
+    swgl_names_free(&ctx->objects);
+    swgl_names_free(&ctx->textures);
+    swgl_names_free(&ctx->framebuffers);
+    swgl_names_free(&ctx->renderbuffers);
+}
+
+void swgl_context_destroy(SwglContext *ctx)
+{
+    if (!ctx)
+        return;
+    if (swgl_current == ctx)
+        swgl_current = NULL;
+    swgl_free_objects(ctx);
+    swgl_frame_free(&ctx->frame);
+    free(ctx->vertexScratch);
+    free(ctx->color);
+    free(ctx);
+}
+
+void swgl_context_make_current(SwglContext *ctx)
+{
+    swgl_current = ctx;
+}
+
+SwglContext *swgl_context_current(void)
+{
+    return swgl_current;
+}
+
+void swgl_set_error(SwglContext *ctx, GLenum error)
+{
+    // Only the first error is kept until glGetError() reads it
+    if (ctx->error == GL_NO_ERROR)
+        ctx->error = error;
+}
@@ -0,0 +1,876 @@
+// swgl_gl.c
+// GL ES 2.0 entry points for fixed-function state, buffers, drawing and
+// state queries. Shader and program entry points live in swgl_program.c;
+// textures, renderbuffers and framebuffer objects in swgl_objects.c.
+#include "swgl_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int swgl_valid_blend_equation(GLenum mode)
+{
+    return mode == GL_FUNC_ADD || mode == GL_FUNC_SUBTRACT || mode == GL_FUNC_REVERSE_SUBTRACT;
+}
+
+static int swgl_valid_blend_factor(GLenum factor)
+{
+    switch (factor)
+    {
+    case GL_ZERO:
+    case GL_ONE:
+    case GL_SRC_COLOR:
+    case GL_ONE_MINUS_SRC_COLOR:
+    case GL_DST_COLOR:
+    case GL_ONE_MINUS_DST_COLOR:
+    case GL_SRC_ALPHA:
+    case GL_ONE_MINUS_SRC_ALPHA:
+    case GL_DST_ALPHA:
+    case GL_ONE_MINUS_DST_ALPHA:
+    case GL_CONSTANT_COLOR:
+    case GL_ONE_MINUS_CONSTANT_COLOR:
+    case GL_CONSTANT_ALPHA:
+    case GL_ONE_MINUS_CONSTANT_ALPHA:
+    case GL_SRC_ALPHA_SATURATE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static float swgl_clamp01(float v)
+{
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// ---------------------------------------------------------------------------
+// Errors, capabilities and fixed-function state
+
+GL_APICALL GLenum GL_APIENTRY glGetError(void)
+{
+    SWGL_GET_CONTEXT(GL_NO_ERROR);
+    GLenum error = ctx->error;
+    ctx->error = GL_NO_ERROR;
+    return error;
+}
+
+static int *swgl_capability(SwglContext *ctx, GLenum cap)
+{
+    static int ignored;
+    switch (cap)
+    {
+    case GL_BLEND:
+        return &ctx->blendEnabled;
+    case GL_CULL_FACE:
+        return &ctx->cullEnabled;
+    case GL_SCISSOR_TEST:
+        return &ctx->scissorTest;
+    case GL_DEPTH_TEST:
+    case GL_STENCIL_TEST:
+    case GL_DITHER:
+    case GL_POLYGON_OFFSET_FILL:
+    case GL_SAMPLE_ALPHA_TO_COVERAGE:
+    case GL_SAMPLE_COVERAGE:
+        // Accepted but without effect: there is no depth or stencil buffer
+        ignored = 0;
+        return &ignored;
+    default:
+        return NULL;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glEnable(GLenum cap)
+{
+    SWGL_GET_CONTEXT();
+    int *flag = swgl_capability(ctx, cap);
+    if (!flag)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    *flag = 1;
+}
+
+GL_APICALL void GL_APIENTRY glDisable(GLenum cap)
+{
+    SWGL_GET_CONTEXT();
+    int *flag = swgl_capability(ctx, cap);
+    if (!flag)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    *flag = 0;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsEnabled(GLenum cap)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    int *flag = swgl_capability(ctx, cap);
+    if (!flag)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return GL_FALSE;
+    }
+    return *flag ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    SWGL_GET_CONTEXT();
+    if (width < 0 || height < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    ctx->viewport[0] = x;
+    ctx->viewport[1] = y;
+    ctx->viewport[2] = width;
+    ctx->viewport[3] = height;
+}
+
+GL_APICALL void GL_APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    SWGL_GET_CONTEXT();
+    if (width < 0 || height < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    ctx->scissor[0] = x;
+    ctx->scissor[1] = y;
+    ctx->scissor[2] = width;
+    ctx->scissor[3] = height;
+}
+
+GL_APICALL void GL_APIENTRY glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    SWGL_GET_CONTEXT();
+    ctx->clearColor[0] = swgl_clamp01(red);
+    ctx->clearColor[1] = swgl_clamp01(green);
+    ctx->clearColor[2] = swgl_clamp01(blue);
+    ctx->clearColor[3] = swgl_clamp01(alpha);
+}
+
+GL_APICALL void GL_APIENTRY glClear(GLbitfield mask)
+{
+    SWGL_GET_CONTEXT();
+    if (mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT))
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (ctx->framebuffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION);
+        return;
+    }
+    swgl_raster_clear(ctx, mask);
+}
+
+GL_APICALL void GL_APIENTRY glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    SWGL_GET_CONTEXT();
+    ctx->colorMask[0] = red != GL_FALSE;
+    ctx->colorMask[1] = green != GL_FALSE;
+    ctx->colorMask[2] = blue != GL_FALSE;
+    ctx->colorMask[3] = alpha != GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    SWGL_GET_CONTEXT();
+    ctx->blendColor[0] = swgl_clamp01(red);
+    ctx->blendColor[1] = swgl_clamp01(green);
+    ctx->blendColor[2] = swgl_clamp01(blue);
+    ctx->blendColor[3] = swgl_clamp01(alpha);
+}
+
+GL_APICALL void GL_APIENTRY glBlendEquation(GLenum mode)
+{
+    glBlendEquationSeparate(mode, mode);
+}
+
+GL_APICALL void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+{
+    SWGL_GET_CONTEXT();
+    if (!swgl_valid_blend_equation(modeRGB) || !swgl_valid_blend_equation(modeAlpha))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    ctx->blendEquationRGB = modeRGB;
+    ctx->blendEquationAlpha = modeAlpha;
+}
+
+GL_APICALL void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    glBlendFuncSeparate(sfactor, dfactor, sfactor, dfactor);
+}
+
+GL_APICALL void GL_APIENTRY glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha)
+{
+    SWGL_GET_CONTEXT();
+    // ES 2.0 only allows GL_SRC_ALPHA_SATURATE as a source factor
+    if (!swgl_valid_blend_factor(sfactorRGB) || !swgl_valid_blend_factor(sfactorAlpha) ||
+        !swgl_valid_blend_factor(dfactorRGB) || !swgl_valid_blend_factor(dfactorAlpha) ||
+        dfactorRGB == GL_SRC_ALPHA_SATURATE || dfactorAlpha == GL_SRC_ALPHA_SATURATE)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    ctx->blendSrcRGB = sfactorRGB;
+    ctx->blendDstRGB = dfactorRGB;
+    ctx->blendSrcAlpha = sfactorAlpha;
+    ctx->blendDstAlpha = dfactorAlpha;
+}
+
+GL_APICALL void GL_APIENTRY glCullFace(GLenum mode)
+{
+    SWGL_GET_CONTEXT();
+    if (mode != GL_FRONT && mode != GL_BACK && mode != GL_FRONT_AND_BACK)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    ctx->cullFace = mode;
+}
+
+GL_APICALL void GL_APIENTRY glFrontFace(GLenum mode)
+{
+    SWGL_GET_CONTEXT();
+    if (mode != GL_CW && mode != GL_CCW)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    ctx->frontFace = mode;
+}
+
+GL_APICALL void GL_APIENTRY glDepthRangef(GLfloat n, GLfloat f)
+{
+    SWGL_GET_CONTEXT();
+    ctx->depthRange[0] = swgl_clamp01(n);
+    ctx->depthRange[1] = swgl_clamp01(f);
+}
+
+GL_APICALL void GL_APIENTRY glLineWidth(GLfloat width)
+{
+    SWGL_GET_CONTEXT();
+    if (width <= 0.0f)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    ctx->lineWidth = width;
+}
+
+GL_APICALL void GL_APIENTRY glPixelStorei(GLenum pname, GLint param)
+{
+    SWGL_GET_CONTEXT();
+    if (param != 1 && param != 2 && param != 4 && param != 8)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (pname == GL_PACK_ALIGNMENT)
+        ctx->packAlignment = param;
+    else if (pname == GL_UNPACK_ALIGNMENT)
+        ctx->unpackAlignment = param;
+    else
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glHint(GLenum target, GLenum mode)
+{
+    SWGL_GET_CONTEXT();
+    (void)target;
+    if (mode != GL_FASTEST && mode != GL_NICEST && mode != GL_DONT_CARE)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glFlush(void)
+{
+    // Work is deferred until a swap, glFinish or glReadPixels
+}
+
+GL_APICALL void GL_APIENTRY glFinish(void)
+{
+    SWGL_GET_CONTEXT();
+    swgl_raster_flush(ctx);
+}
+
+// ---------------------------------------------------------------------------
+// Buffers
+
+static GLuint *swgl_buffer_binding(SwglContext *ctx, GLenum target)
+{
+    if (target == GL_ARRAY_BUFFER)
+        return &ctx->arrayBuffer;
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+        return &ctx->elementArrayBuffer;
+    return NULL;
+}
+
+GL_APICALL void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers)
+{
+    SWGL_GET_CONTEXT();
+    if (n < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        SwglBuffer *buffer = (SwglBuffer *)calloc(1, sizeof(SwglBuffer));
+        buffers[i] = buffer ? swgl_names_alloc(&ctx->buffers, buffer) : 0;
+        if (!buffers[i])
+        {
+            free(buffer);
+            swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        }
+    }
+}
+
+GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers)
+{
+    SWGL_GET_CONTEXT();
+    if (n < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        SwglBuffer *buffer = (SwglBuffer *)swgl_names_get(&ctx->buffers, buffers[i]);
+        if (!buffer)
+            continue;
+        if (ctx->arrayBuffer == buffers[i])
+            ctx->arrayBuffer = 0;
+        if (ctx->elementArrayBuffer == buffers[i])
+            ctx->elementArrayBuffer = 0;
+        for (int a = 0; a < SWGL_MAX_ATTRIBS; ++a)
+        {
+            if (ctx->attribs[a].buffer == buffers[i])
+                ctx->attribs[a].buffer = 0;
+        }
+        swgl_names_release(&ctx->buffers, buffers[i]);
+        free(buffer->data);
+        free(buffer);
+    }
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsBuffer(GLuint buffer)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    return swgl_names_get(&ctx->buffers, buffer) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer)
+{
+    SWGL_GET_CONTEXT();
+    GLuint *binding = swgl_buffer_binding(ctx, target);
+    if (!binding)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (buffer && !swgl_names_get(&ctx->buffers, buffer))
+    {
+        // Binding an unused name creates the buffer, as in ES 2.0
+        SwglBuffer *object = (SwglBuffer *)calloc(1, sizeof(SwglBuffer));
+        if (!object)
+        {
+            swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return;
+        }
+        swgl_names_set(&ctx->buffers, buffer, object);
+        if (swgl_names_get(&ctx->buffers, buffer) != object)
+        {
+            free(object);
+            swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+    *binding = buffer;
+}
+
+GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+    SWGL_GET_CONTEXT();
+    GLuint *binding = swgl_buffer_binding(ctx, target);
+    if (!binding || (usage != GL_STATIC_DRAW && usage != GL_DYNAMIC_DRAW && usage != GL_STREAM_DRAW))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (size < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    SwglBuffer *buffer = (SwglBuffer *)swgl_names_get(&ctx->buffers, *binding);
+    if (!buffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    unsigned char *storage = size ? (unsigned char *)malloc((size_t)size) : NULL;
+    if (size && !storage)
+    {
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return;
+    }
+    if (data && size)
+        memcpy(storage, data, (size_t)size);
+    else if (size)
+        memset(storage, 0, (size_t)size);
+    free(buffer->data);
+    buffer->data = storage;
+    buffer->size = size;
+    buffer->usage = usage;
+}
+
+GL_APICALL void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+    SWGL_GET_CONTEXT();
+    GLuint *binding = swgl_buffer_binding(ctx, target);
+    if (!binding)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    SwglBuffer *buffer = (SwglBuffer *)swgl_names_get(&ctx->buffers, *binding);
+    if (!buffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (offset < 0 || size < 0 || offset + size > buffer->size)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (size && data)
+        memcpy(buffer->data + offset, data, (size_t)size);
+}
+
+GL_APICALL void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    GLuint *binding = swgl_buffer_binding(ctx, target);
+    SwglBuffer *buffer = binding ? (SwglBuffer *)swgl_names_get(&ctx->buffers, *binding) : NULL;
+    if (!binding)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (!buffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (pname == GL_BUFFER_SIZE)
+        *params = (GLint)buffer->size;
+    else if (pname == GL_BUFFER_USAGE)
+        *params = (GLint)(buffer->usage ? buffer->usage : GL_STATIC_DRAW);
+    else
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+// ---------------------------------------------------------------------------
+// Vertex attributes
+
+GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint index)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    ctx->attribs[index].enabled = 1;
+}
+
+GL_APICALL void GL_APIENTRY glDisableVertexAttribArray(GLuint index)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    ctx->attribs[index].enabled = 0;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS || size < 1 || size > 4 || stride < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (type != GL_BYTE && type != GL_UNSIGNED_BYTE && type != GL_SHORT && type != GL_UNSIGNED_SHORT &&
+        type != GL_FIXED && type != GL_FLOAT)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    SwglAttribArray *array = &ctx->attribs[index];
+    array->size = size;
+    array->type = type;
+    array->normalized = normalized;
+    array->stride = stride;
+    array->pointer = pointer;
+    array->buffer = ctx->arrayBuffer;
+}
+
+static void swgl_vertex_attrib(GLuint index, float x, float y, float z, float w)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    float *current = ctx->attribs[index].current;
+    current[0] = x;
+    current[1] = y;
+    current[2] = z;
+    current[3] = w;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib1f(GLuint index, GLfloat x) { swgl_vertex_attrib(index, x, 0.0f, 0.0f, 1.0f); }
+GL_APICALL void GL_APIENTRY glVertexAttrib1fv(GLuint index, const GLfloat *v) { swgl_vertex_attrib(index, v[0], 0.0f, 0.0f, 1.0f); }
+GL_APICALL void GL_APIENTRY glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y) { swgl_vertex_attrib(index, x, y, 0.0f, 1.0f); }
+GL_APICALL void GL_APIENTRY glVertexAttrib2fv(GLuint index, const GLfloat *v) { swgl_vertex_attrib(index, v[0], v[1], 0.0f, 1.0f); }
+GL_APICALL void GL_APIENTRY glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z) { swgl_vertex_attrib(index, x, y, z, 1.0f); }
+GL_APICALL void GL_APIENTRY glVertexAttrib3fv(GLuint index, const GLfloat *v) { swgl_vertex_attrib(index, v[0], v[1], v[2], 1.0f); }
+GL_APICALL void GL_APIENTRY glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) { swgl_vertex_attrib(index, x, y, z, w); }
+GL_APICALL void GL_APIENTRY glVertexAttrib4fv(GLuint index, const GLfloat *v) { swgl_vertex_attrib(index, v[0], v[1], v[2], v[3]); }
+
+GL_APICALL void GL_APIENTRY glGetVertexAttribfv(GLuint index, GLenum pname, GLfloat *params)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (pname == GL_CURRENT_VERTEX_ATTRIB)
+    {
+        memcpy(params, ctx->attribs[index].current, 4 * sizeof(float));
+        return;
+    }
+    GLint value = 0;
+    glGetVertexAttribiv(index, pname, &value);
+    *params = (GLfloat)value;
+}
+
+GL_APICALL void GL_APIENTRY glGetVertexAttribiv(GLuint index, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    const SwglAttribArray *array = &ctx->attribs[index];
+    switch (pname)
+    {
+    case GL_VERTEX_ATTRIB_ARRAY_ENABLED:
+        *params = array->enabled;
+        break;
+    case GL_VERTEX_ATTRIB_ARRAY_SIZE:
+        *params = array->size;
+        break;
+    case GL_VERTEX_ATTRIB_ARRAY_STRIDE:
+        *params = array->stride;
+        break;
+    case GL_VERTEX_ATTRIB_ARRAY_TYPE:
+        *params = (GLint)array->type;
+        break;
+    case GL_VERTEX_ATTRIB_ARRAY_NORMALIZED:
+        *params = array->normalized;
+        break;
+    case GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING:
+        *params = (GLint)array->buffer;
+        break;
+    case GL_CURRENT_VERTEX_ATTRIB:
+        for (int i = 0; i < 4; ++i)
+            params[i] = (GLint)array->current[i];
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetVertexAttribPointerv(GLuint index, GLenum pname, void **pointer)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (pname != GL_VERTEX_ATTRIB_ARRAY_POINTER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    *pointer = (void *)ctx->attribs[index].pointer;
+}
+
+// ---------------------------------------------------------------------------
+// Drawing and readback
+
+static int swgl_valid_draw_mode(GLenum mode)
+{
+    return mode == GL_POINTS || mode == GL_LINES || mode == GL_LINE_LOOP || mode == GL_LINE_STRIP ||
+           mode == GL_TRIANGLES || mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN;
+}
+
+GL_APICALL void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    SWGL_GET_CONTEXT();
+    if (!swgl_valid_draw_mode(mode))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (first < 0 || count < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (ctx->framebuffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION);
+        return;
+    }
+    swgl_raster_draw(ctx, mode, first, count, 0, NULL);
+}
+
+GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+    SWGL_GET_CONTEXT();
+    if (!swgl_valid_draw_mode(mode) ||
+        (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (count < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (ctx->framebuffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION);
+        return;
+    }
+    if (!ctx->elementArrayBuffer && !indices)
+        return;
+    swgl_raster_draw(ctx, mode, 0, count, type, indices);
+}
+
+GL_APICALL void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels)
+{
+    SWGL_GET_CONTEXT();
+    if (width < 0 || height < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (format != GL_RGBA || type != GL_UNSIGNED_BYTE)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (ctx->framebuffer)
+    {
+        swgl_set_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION);
+        return;
+    }
+    swgl_raster_flush(ctx);
+    size_t rowBytes = (size_t)width * 4;
+    size_t pitch = (rowBytes + ctx->packAlignment - 1) / ctx->packAlignment * ctx->packAlignment;
+    for (GLsizei row = 0; row < height; ++row)
+    {
+        unsigned char *dst = (unsigned char *)pixels + (size_t)row * pitch;
+        for (GLsizei col = 0; col < width; ++col)
+        {
+            int sx = x + col, sy = y + row;
+            // Pixels outside the window are left untouched, as the spec allows
+            if (sx < 0 || sy < 0 || sx >= ctx->width || sy >= ctx->height)
+                continue;
+            memcpy(dst + (size_t)col * 4, ctx->color + (size_t)sy * ctx->width + sx, 4);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// State queries
+
+static const char *swgl_extensions = "GL_OES_element_index_uint";
+
+GL_APICALL const GLubyte *GL_APIENTRY glGetString(GLenum name)
+{
+    SWGL_GET_CONTEXT(NULL);
+    switch (name)
+    {
+    case GL_VENDOR:
+        return (const GLubyte *)"opengl-samples";
+    case GL_RENDERER:
+        return (const GLubyte *)"swgl tiled software rasterizer";
+    case GL_VERSION:
+        return (const GLubyte *)"OpenGL ES 2.0 swgl";
+    case GL_SHADING_LANGUAGE_VERSION:
+        return (const GLubyte *)"OpenGL ES GLSL ES 1.00 swgl";
+    case GL_EXTENSIONS:
+        return (const GLubyte *)swgl_extensions;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return NULL;
+    }
+}
+
+// Writes up to four values of an integer or float query; returns the count.
+static int swgl_query(SwglContext *ctx, GLenum pname, float *values)
+{
+    switch (pname)
+    {
+    case GL_VIEWPORT:
+        for (int i = 0; i < 4; ++i)
+            values[i] = (float)ctx->viewport[i];
+        return 4;
+    case GL_SCISSOR_BOX:
+        for (int i = 0; i < 4; ++i)
+            values[i] = (float)ctx->scissor[i];
+        return 4;
+    case GL_COLOR_CLEAR_VALUE:
+        memcpy(values, ctx->clearColor, 4 * sizeof(float));
+        return 4;
+    case GL_BLEND_COLOR:
+        memcpy(values, ctx->blendColor, 4 * sizeof(float));
+        return 4;
+    case GL_COLOR_WRITEMASK:
+        for (int i = 0; i < 4; ++i)
+            values[i] = ctx->colorMask[i];
+        return 4;
+    case GL_DEPTH_RANGE:
+        values[0] = ctx->depthRange[0];
+        values[1] = ctx->depthRange[1];
+        return 2;
+    case GL_ALIASED_POINT_SIZE_RANGE:
+        values[0] = 1.0f;
+        values[1] = SWGL_MAX_POINT_SIZE;
+        return 2;
+    case GL_ALIASED_LINE_WIDTH_RANGE:
+        values[0] = 1.0f;
+        values[1] = 1.0f;
+        return 2;
+    case GL_MAX_VIEWPORT_DIMS:
+        values[0] = (float)SWGL_MAX_TEXTURE_SIZE;
+        values[1] = (float)SWGL_MAX_TEXTURE_SIZE;
+        return 2;
+    case GL_LINE_WIDTH: values[0] = ctx->lineWidth; return 1;
+    case GL_BLEND: values[0] = (float)ctx->blendEnabled; return 1;
+    case GL_CULL_FACE: values[0] = (float)ctx->cullEnabled; return 1;
+    case GL_SCISSOR_TEST: values[0] = (float)ctx->scissorTest; return 1;
+    case GL_CULL_FACE_MODE: values[0] = (float)ctx->cullFace; return 1;
+    case GL_FRONT_FACE: values[0] = (float)ctx->frontFace; return 1;
+    case GL_BLEND_EQUATION_RGB: values[0] = (float)ctx->blendEquationRGB; return 1;
+    case GL_BLEND_EQUATION_ALPHA: values[0] = (float)ctx->blendEquationAlpha; return 1;
+    case GL_BLEND_SRC_RGB: values[0] = (float)ctx->blendSrcRGB; return 1;
+    case GL_BLEND_DST_RGB: values[0] = (float)ctx->blendDstRGB; return 1;
+    case GL_BLEND_SRC_ALPHA: values[0] = (float)ctx->blendSrcAlpha; return 1;
+    case GL_BLEND_DST_ALPHA: values[0] = (float)ctx->blendDstAlpha; return 1;
+    case GL_ARRAY_BUFFER_BINDING: values[0] = (float)ctx->arrayBuffer; return 1;
+    case GL_ELEMENT_ARRAY_BUFFER_BINDING: values[0] = (float)ctx->elementArrayBuffer; return 1;
+    case GL_CURRENT_PROGRAM: values[0] = (float)ctx->currentProgram; return 1;
+    case GL_FRAMEBUFFER_BINDING: values[0] = (float)ctx->framebuffer; return 1;
+    case GL_RENDERBUFFER_BINDING: values[0] = (float)ctx->renderbuffer; return 1;
+    case GL_TEXTURE_BINDING_2D: values[0] = (float)ctx->boundTexture; return 1;
+    case GL_ACTIVE_TEXTURE: values[0] = (float)ctx->activeTexture; return 1;
+    case GL_PACK_ALIGNMENT: values[0] = (float)ctx->packAlignment; return 1;
+    case GL_UNPACK_ALIGNMENT: values[0] = (float)ctx->unpackAlignment; return 1;
+    case GL_MAX_VERTEX_ATTRIBS: values[0] = (float)SWGL_MAX_ATTRIBS; return 1;
+    case GL_MAX_VERTEX_UNIFORM_VECTORS: values[0] = (float)SWGL_MAX_UNIFORM_VECTORS; return 1;
+    case GL_MAX_FRAGMENT_UNIFORM_VECTORS: values[0] = (float)SWGL_MAX_UNIFORM_VECTORS; return 1;
+    case GL_MAX_VARYING_VECTORS: values[0] = (float)(SWGL_MAX_VARYINGS / 4); return 1;
+    case GL_MAX_TEXTURE_SIZE: values[0] = (float)SWGL_MAX_TEXTURE_SIZE; return 1;
+    case GL_MAX_CUBE_MAP_TEXTURE_SIZE: values[0] = (float)SWGL_MAX_TEXTURE_SIZE; return 1;
+    case GL_MAX_RENDERBUFFER_SIZE: values[0] = (float)SWGL_MAX_TEXTURE_SIZE; return 1;
+    case GL_MAX_TEXTURE_IMAGE_UNITS: values[0] = 8.0f; return 1;
+    case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS: values[0] = 0.0f; return 1;
+    case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: values[0] = 8.0f; return 1;
+    case GL_SUBPIXEL_BITS: values[0] = 8.0f; return 1;
+    case GL_RED_BITS:
+    case GL_GREEN_BITS:
+    case GL_BLUE_BITS:
+    case GL_ALPHA_BITS:
+        values[0] = 8.0f;
+        return 1;
+    case GL_DEPTH_BITS:
+    case GL_STENCIL_BITS:
+    case GL_SAMPLES:
+    case GL_SAMPLE_BUFFERS:
+    case GL_NUM_COMPRESSED_TEXTURE_FORMATS:
+    case GL_NUM_SHADER_BINARY_FORMATS:
+        values[0] = 0.0f;
+        return 1;
+    case GL_SHADER_COMPILER: values[0] = 1.0f; return 1;
+    case GL_IMPLEMENTATION_COLOR_READ_FORMAT: values[0] = (float)GL_RGBA; return 1;
+    case GL_IMPLEMENTATION_COLOR_READ_TYPE: values[0] = (float)GL_UNSIGNED_BYTE; return 1;
+    default:
+        return 0;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetFloatv(GLenum pname, GLfloat *data)
+{
+    SWGL_GET_CONTEXT();
+    float values[4];
+    int count = swgl_query(ctx, pname, values);
+    if (!count)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    memcpy(data, values, count * sizeof(float));
+}
+
+GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *data)
+{
+    SWGL_GET_CONTEXT();
+    float values[4];
+    int count = swgl_query(ctx, pname, values);
+    if (!count)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    int colors = pname == GL_COLOR_CLEAR_VALUE || pname == GL_BLEND_COLOR || pname == GL_DEPTH_RANGE;
+    for (int i = 0; i < count; ++i)
+    {
+        // Normalized colors map to the full integer range
+        data[i] = colors ? (GLint)(values[i] * 2147483647.0) : (GLint)values[i];
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetBooleanv(GLenum pname, GLboolean *data)
+{
+    SWGL_GET_CONTEXT();
+    float values[4];
+    int count = swgl_query(ctx, pname, values);
+    if (!count)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    for (int i = 0; i < count; ++i)
+        data[i] = values[i] != 0.0f ? GL_TRUE : GL_FALSE;
+}
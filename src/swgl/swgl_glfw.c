@@ -0,0 +1,230 @@
+// swgl_glfw.c
+// Headless GLFW subset backing the samples when they are linked against the
+// software renderer. Each window owns an swgl context; glfwSwapBuffers()
+// flushes the binned frame.
+#include <GLFW/glfw3.h>
+
+#include "swgl_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct GLFWwindow
+{
+    SwglContext *context;
+    int shouldClose;
+    unsigned long long frames;
+};
+
+static int swgl_glfw_initialized;
+static unsigned long long swgl_glfw_frame_limit;
+static const char *swgl_glfw_dump_path;
+static double swgl_glfw_time_base;
+static _Thread_local GLFWwindow *swgl_glfw_current;
+static GLFWerrorfun swgl_glfw_error_callback;
+
+static double swgl_glfw_monotonic(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static void swgl_glfw_error(int code, const char *description)
+{
+    if (swgl_glfw_error_callback)
+        swgl_glfw_error_callback(code, description);
+}
+
+// Writes the color buffer as a binary PPM, top row first.
+static void swgl_glfw_dump(const SwglContext *ctx, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("ERROR: cannot open %s for writing\n", path);
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", ctx->width, ctx->height);
+    unsigned char *row = (unsigned char *)malloc((size_t)ctx->width * 3);
+    for (int y = ctx->height - 1; row && y >= 0; --y)
+    {
+        const uint32_t *src = ctx->color + (size_t)y * ctx->width;
+        for (int x = 0; x < ctx->width; ++x)
+        {
+            const unsigned char *rgba = (const unsigned char *)&src[x];
+            memcpy(row + x * 3, rgba, 3);
+        }
+        fwrite(row, 3, (size_t)ctx->width, file);
+    }
+    free(row);
+    fclose(file);
+    printf("INFO: wrote %s\n", path);
+}
+
+int glfwInit(void)
+{
+    if (!swgl_glfw_initialized)
+    {
+        const char *frames = getenv("SWGL_FRAMES");
+        swgl_glfw_frame_limit = frames ? strtoull(frames, NULL, 10) : 0;
+        swgl_glfw_dump_path = getenv("SWGL_DUMP");
+        swgl_glfw_time_base = swgl_glfw_monotonic();
+        swgl_glfw_initialized = 1;
+    }
+    return GLFW_TRUE;
+}
+
+void glfwTerminate(void)
+{
+    swgl_glfw_initialized = 0;
+    swgl_glfw_current = NULL;
+    swgl_context_make_current(NULL);
+}
+
+GLFWerrorfun glfwSetErrorCallback(GLFWerrorfun callback)
+{
+    GLFWerrorfun previous = swgl_glfw_error_callback;
+    swgl_glfw_error_callback = callback;
+    return previous;
+}
+
+// Context and framebuffer hints have a single answer in swgl, and windows
+// are never shown, so hints are accepted and ignored.
+void glfwDefaultWindowHints(void)
+{
+}
+
+void glfwWindowHint(int hint, int value)
+{
+    (void)hint;
+    (void)value;
+}
+
+GLFWwindow *glfwCreateWindow(int width, int height, const char *title, GLFWmonitor *monitor, GLFWwindow *share)
+{
+    (void)title;
+    (void)monitor;
+    if (!swgl_glfw_initialized || width <= 0 || height <= 0)
+    {
+        swgl_glfw_error(0x00010004, "swgl: invalid window size or GLFW not initialized");
+        return NULL;
+    }
+    // Every context has its own object names
+    if (share)
+    {
+        swgl_glfw_error(0x00010006, "swgl: contexts cannot share objects");
+        return NULL;
+    }
+    GLFWwindow *window = (GLFWwindow *)calloc(1, sizeof(GLFWwindow));
+    if (!window)
+        return NULL;
+    window->context = swgl_context_create(width, height);
+    if (!window->context)
+    {
+        free(window);
+        swgl_glfw_error(0x00010005, "swgl: out of memory");
+        return NULL;
+    }
+    return window;
+}
+
+void glfwDestroyWindow(GLFWwindow *window)
+{
+    if (!window)
+        return;
+    if (swgl_glfw_current == window)
+        glfwMakeContextCurrent(NULL);
+    swgl_context_destroy(window->context);
+    free(window);
+}
+
+int glfwWindowShouldClose(GLFWwindow *window)
+{
+    return window->shouldClose;
+}
+
+void glfwSetWindowShouldClose(GLFWwindow *window, int value)
+{
+    window->shouldClose = value;
+}
+
+void glfwSetWindowTitle(GLFWwindow *window, const char *title)
+{
+    (void)window;
+    (void)title;
+}
+
+void glfwGetWindowSize(GLFWwindow *window, int *width, int *height)
+{
+    if (width)
+        *width = window->context->width;
+    if (height)
+        *height = window->context->height;
+}
+
+void glfwGetFramebufferSize(GLFWwindow *window, int *width, int *height)
+{
+    glfwGetWindowSize(window, width, height);
+}
+
+void glfwMakeContextCurrent(GLFWwindow *window)
+{
+    swgl_glfw_current = window;
+    swgl_context_make_current(window ? window->context : NULL);
+}
+
+GLFWwindow *glfwGetCurrentContext(void)
+{
+    return swgl_glfw_current;
+}
+
+void glfwSwapBuffers(GLFWwindow *window)
+{
+    SwglContext *previous = swgl_context_current();
+    swgl_context_make_current(window->context);
+    swgl_raster_flush(window->context);
+    swgl_raster_count_frame();
+    window->frames++;
+    if (swgl_glfw_frame_limit && window->frames >= swgl_glfw_frame_limit)
+    {
+        if (swgl_glfw_dump_path && !window->shouldClose)
+            swgl_glfw_dump(window->context, swgl_glfw_dump_path);
+        window->shouldClose = 1;
+    }
+    swgl_context_make_current(previous);
+}
+
+void glfwSwapInterval(int interval)
+{
+    (void)interval;
+}
+
+int glfwExtensionSupported(const char *extension)
+{
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    size_t length = strlen(extension);
+    for (const char *p = extensions; p && (p = strstr(p, extension)) != NULL; p += length)
+    {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+            return GLFW_TRUE;
+    }
+    return GLFW_FALSE;
+}
+
+GLFWglproc glfwGetProcAddress(const char *procname)
+{
+    (void)procname;
+    return NULL; // swgl exposes no extension entry points
+}
+
+void glfwPollEvents(void)
+{
+}
+
+double glfwGetTime(void)
+{
+    return swgl_glfw_monotonic() - swgl_glfw_time_base;
+}
@@ -0,0 +1,270 @@
+// swgl_glsl_exec.c
+// Interpreter for the scalar shader IR. Each instruction processes
+// SWGL_GLSL_LANES invocations; the lane loops are simple enough for the
+// compiler to vectorize. Branches narrow an execution mask instead of
+// jumping, except when no lane is left on a path.
+#include "swgl_glsl_internal.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define L SWGL_GLSL_LANES
+
+typedef struct SwglGlslFrame
+{
+    unsigned mask;  // active lanes on entry
+    unsigned saved; // IF: condition; LOOP: outer breaks; FUNC: outer returns
+    unsigned saved2; // LOOP: outer continues
+    int iterations;
+} SwglGlslFrame;
+
+struct SwglGlslExec
+{
+    float (*regs)[L];
+    int capacity;
+    unsigned serial; // shader whose constants are loaded
+    SwglGlslFrame stack[SWGL_GLSL_MAX_NESTING];
+};
+
+static atomic_uint swgl_glsl_serial_counter;
+
+unsigned swgl_glsl_next_serial(void)
+{
+    return atomic_fetch_add(&swgl_glsl_serial_counter, 1u) + 1u;
+}
+
+SwglGlslExec *swgl_glsl_exec_create(void)
+{
+    return (SwglGlslExec *)calloc(1, sizeof(SwglGlslExec));
+}
+
+void swgl_glsl_exec_destroy(SwglGlslExec *exec)
+{
+    if (!exec)
+        return;
+    free(exec->regs);
+    free(exec);
+}
+
+static int swgl_glsl_exec_reserve(SwglGlslExec *exec, int regCount)
+{
+    if (regCount <= exec->capacity)
+        return 1;
+    size_t bytes = (size_t)regCount * sizeof(float[L]);
+    float (*regs)[L] = (float (*)[L])aligned_alloc(32, (bytes + 31) & ~(size_t)31);
+    if (!regs)
+        return 0;
+    free(exec->regs);
+    exec->regs = regs;
+    exec->capacity = regCount;
+    exec->serial = 0;
+    return 1;
+}
+
+static unsigned swgl_glsl_lanes(const float *r)
+{
+    unsigned mask = 0;
+    for (int l = 0; l < L; ++l)
+        mask |= (r[l] != 0.0f ? 1u : 0u) << l;
+    return mask;
+}
+
+static int swgl_glsl_clamp_index(float value, int count)
+{
+    // Out-of-range indices are undefined in GLSL; clamping keeps them in bounds
+    int i = value >= 0.0f ? (value < (float)count ? (int)value : count - 1) : 0;
+    return i;
+}
+
+unsigned swgl_glsl_run(SwglGlslExec *exec, const SwglGlslShader *shader, const SwglGlslBatch *batch)
+{
+    if (!batch->mask || !swgl_glsl_exec_reserve(exec, shader->regCount))
+        return 0;
+    float (*regs)[L] = exec->regs;
+    if (exec->serial != shader->serial)
+    {
+        for (int i = 0; i < shader->constantCount; ++i)
+        {
+            float *r = regs[shader->constants[i].reg];
+            for (int l = 0; l < L; ++l)
+                r[l] = shader->constants[i].value;
+        }
+        exec->serial = shader->serial;
+    }
+
+    const unsigned full = batch->mask;
+    unsigned mask = full;
+    unsigned discarded = 0, broken = 0, continued = 0, returned = 0;
+    SwglGlslFrame *top = exec->stack - 1;
+    const SwglGlslInstr *code = shader->code;
+    const int count = shader->codeCount;
+
+    for (int pc = 0; pc < count; ++pc)
+    {
+        const SwglGlslInstr *in = &code[pc];
+        float *d = regs[in->dst];
+        switch (in->op)
+        {
+#define SWGL_GLSL_OP_CASE(name, args, expr)                                        \
+    case SWGL_GLSL_OP_##name:                                                       \
+    {                                                                               \
+        const float *ra = regs[in->a], *rb = regs[in->b], *rc = regs[in->c];        \
+        float out[L];                                                               \
+        for (int l = 0; l < L; ++l)                                                 \
+        {                                                                           \
+            float a = ra[l], b = args > 1 ? rb[l] : 0.0f, c = args > 2 ? rc[l] : 0.0f; \
+            (void)b;                                                                \
+            (void)c;                                                                \
+            out[l] = (expr);                                                        \
+        }                                                                           \
+        memcpy(d, out, sizeof(out));                                                \
+        break;                                                                      \
+    }
+            SWGL_GLSL_ALU_OPS(SWGL_GLSL_OP_CASE)
+#undef SWGL_GLSL_OP_CASE
+
+        case SWGL_GLSL_OP_STORE:
+        {
+            const float *ra = regs[in->a];
+            if (mask == full)
+                memcpy(d, ra, sizeof(float[L]));
+            else
+            {
+                for (int l = 0; l < L; ++l)
+                    d[l] = (mask >> l) & 1u ? ra[l] : d[l];
+            }
+            break;
+        }
+        case SWGL_GLSL_OP_LOADU:
+        {
+            float value = batch->uniforms[in->imm];
+            for (int l = 0; l < L; ++l)
+                d[l] = value;
+            break;
+        }
+        case SWGL_GLSL_OP_GATHERU:
+        {
+            const float *ra = regs[in->a];
+            float out[L];
+            for (int l = 0; l < L; ++l)
+                out[l] = batch->uniforms[in->imm + swgl_glsl_clamp_index(ra[l], in->b) * in->c];
+            memcpy(d, out, sizeof(out));
+            break;
+        }
+        case SWGL_GLSL_OP_GATHERR:
+        {
+            const float *ra = regs[in->a];
+            float out[L];
+            for (int l = 0; l < L; ++l)
+                out[l] = regs[in->b + swgl_glsl_clamp_index(ra[l], in->imm2) * in->imm][l];
+            memcpy(d, out, sizeof(out));
+            break;
+        }
+        case SWGL_GLSL_OP_SCATTERR:
+        {
+            const float *ra = regs[in->a], *rc = regs[in->c];
+            for (int l = 0; l < L; ++l)
+            {
+                if ((mask >> l) & 1u)
+                    regs[in->b + swgl_glsl_clamp_index(rc[l], in->imm2) * in->imm][l] = ra[l];
+            }
+            break;
+        }
+        case SWGL_GLSL_OP_LOADIN:
+            memcpy(d, batch->inputs[in->imm], sizeof(float[L]));
+            break;
+        case SWGL_GLSL_OP_LOADB:
+            if (in->imm == SWGL_GLSL_BUILTIN_FRONTFACING)
+            {
+                for (int l = 0; l < L; ++l)
+                    d[l] = batch->frontFacing ? 1.0f : 0.0f;
+            }
+            else if (in->imm < SWGL_GLSL_BUILTIN_POINTCOORD)
+                memcpy(d, batch->fragCoord[in->imm], sizeof(float[L]));
+            else
+                memcpy(d, batch->pointCoord[in->imm - SWGL_GLSL_BUILTIN_POINTCOORD], sizeof(float[L]));
+            break;
+        case SWGL_GLSL_OP_STOREOUT:
+            memcpy(batch->outputs[in->imm], regs[in->a], sizeof(float[L]));
+            break;
+
+        case SWGL_GLSL_OP_IF:
+            ++top;
+            top->mask = mask;
+            top->saved = swgl_glsl_lanes(regs[in->a]);
+            mask &= top->saved;
+            if (!mask)
+                pc = in->imm - 1;
+            break;
+        case SWGL_GLSL_OP_ELSE:
+            mask = top->mask & ~top->saved & ~(broken | continued | returned | discarded);
+            if (!mask)
+                pc = in->imm - 1;
+            break;
+        case SWGL_GLSL_OP_ENDIF:
+            mask = top->mask & ~(broken | continued | returned | discarded);
+            --top;
+            break;
+        case SWGL_GLSL_OP_LOOP:
+            ++top;
+            top->mask = mask;
+            top->saved = broken;
+            top->saved2 = continued;
+            top->iterations = 0;
+            broken = continued = 0;
+            break;
+        case SWGL_GLSL_OP_LOOP_TEST:
+        {
+            unsigned pass = swgl_glsl_lanes(regs[in->a]);
+            broken |= mask & ~pass;
+            mask &= pass;
+            if (!mask)
+                pc = in->imm - 1;
+            break;
+        }
+        case SWGL_GLSL_OP_ITER_END:
+            continued = 0;
+            mask = top->mask & ~(broken | returned | discarded);
+            break;
+        case SWGL_GLSL_OP_LOOP_NEXT:
+            if (mask && ++top->iterations < SWGL_GLSL_LOOP_LIMIT)
+                pc = in->imm - 1;
+            break;
+        case SWGL_GLSL_OP_LOOP_EXIT:
+            broken = top->saved;
+            continued = top->saved2;
+            mask = top->mask & ~(returned | discarded);
+            --top;
+            break;
+        case SWGL_GLSL_OP_BREAK:
+            broken |= mask;
+            mask = 0;
+            break;
+        case SWGL_GLSL_OP_CONTINUE:
+            continued |= mask;
+            mask = 0;
+            break;
+        case SWGL_GLSL_OP_FUNC_BEGIN:
+            ++top;
+            top->mask = mask;
+            top->saved = returned;
+            returned = 0;
+            break;
+        case SWGL_GLSL_OP_FUNC_END:
+            returned = top->saved;
+            mask = top->mask & ~discarded;
+            --top;
+            break;
+        case SWGL_GLSL_OP_RET:
+            returned |= mask;
+            mask = 0;
+            break;
+        case SWGL_GLSL_OP_DISCARD:
+            discarded |= mask;
+            mask = 0;
+            break;
+        }
+    }
+    return full & ~discarded;
+}
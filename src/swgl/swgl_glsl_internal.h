@@ -0,0 +1,149 @@
+// swgl_glsl_internal.h
+// Intermediate representation shared by the GLSL front end (swgl_glsl_parse.c)
+// and the interpreter (swgl_glsl_exec.c).
+//
+// The IR is scalar: every register holds one float per lane and vectors are
+// lists of registers, so swizzles cost nothing. ints are floats holding whole
+// numbers and bools are 0.0 or 1.0. Control flow is structured and runs under
+// an execution mask; divergent lanes simply sit out the instructions of the
+// branch they did not take.
+#ifndef SWGL_GLSL_INTERNAL_H
+#define SWGL_GLSL_INTERNAL_H
+
+#include "swgl/swgl_glsl.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define SWGL_GLSL_MAX_REGISTERS 16384
+#define SWGL_GLSL_MAX_NESTING 64     // nested ifs, loops and inlined calls
+#define SWGL_GLSL_LOOP_LIMIT 65536   // iterations before a loop is abandoned
+
+// Arithmetic ops: name, operand count and the per-lane expression over a, b
+// and c. The interpreter and the constant folder expand the same table.
+#define SWGL_GLSL_ALU_OPS(X)                                        \
+    X(MOV, 1, a)                                                    \
+    X(NEG, 1, -a)                                                   \
+    X(ADD, 2, a + b)                                                \
+    X(SUB, 2, a - b)                                                \
+    X(MUL, 2, a * b)                                                \
+    X(DIV, 2, a / b)                                                \
+    X(MAD, 3, a * b + c)                                            \
+    X(MIN, 2, b < a ? b : a)                                        \
+    X(MAX, 2, a < b ? b : a)                                        \
+    X(CLAMP, 3, a < b ? b : (c < a ? c : a))                        \
+    X(MIX, 3, a * (1.0f - c) + b * c)                               \
+    X(STEP, 2, b < a ? 0.0f : 1.0f)                                 \
+    X(ABS, 1, fabsf(a))                                             \
+    X(SIGN, 1, a > 0.0f ? 1.0f : (a < 0.0f ? -1.0f : 0.0f))         \
+    X(FLOOR, 1, floorf(a))                                          \
+    X(CEIL, 1, ceilf(a))                                            \
+    X(FRACT, 1, a - floorf(a))                                      \
+    X(TRUNC, 1, truncf(a))                                          \
+    X(MOD, 2, a - b * floorf(a / b))                                \
+    X(SQRT, 1, sqrtf(a))                                            \
+    X(RSQ, 1, 1.0f / sqrtf(a))                                      \
+    X(EXP, 1, expf(a))                                              \
+    X(EXP2, 1, exp2f(a))                                            \
+    X(LOG, 1, logf(a))                                              \
+    X(LOG2, 1, log2f(a))                                            \
+    X(POW, 2, powf(a, b))                                           \
+    X(SIN, 1, sinf(a))                                              \
+    X(COS, 1, cosf(a))                                              \
+    X(TAN, 1, tanf(a))                                              \
+    X(ASIN, 1, asinf(a))                                            \
+    X(ACOS, 1, acosf(a))                                            \
+    X(ATAN, 1, atanf(a))                                            \
+    X(ATAN2, 2, atan2f(a, b))                                       \
+    X(LT, 2, a < b ? 1.0f : 0.0f)                                   \
+    X(LE, 2, a <= b ? 1.0f : 0.0f)                                  \
+    X(EQ, 2, a == b ? 1.0f : 0.0f)                                  \
+    X(NE, 2, a != b ? 1.0f : 0.0f)                                  \
+    X(AND, 2, (a != 0.0f && b != 0.0f) ? 1.0f : 0.0f)               \
+    X(OR, 2, (a != 0.0f || b != 0.0f) ? 1.0f : 0.0f)                \
+    X(XOR, 2, ((a != 0.0f) != (b != 0.0f)) ? 1.0f : 0.0f)           \
+    X(NOT, 1, a == 0.0f ? 1.0f : 0.0f)                              \
+    X(SEL, 3, a != 0.0f ? b : c)
+
+enum
+{
+#define SWGL_GLSL_OP_ENUM(name, args, expr) SWGL_GLSL_OP_##name,
+    SWGL_GLSL_ALU_OPS(SWGL_GLSL_OP_ENUM)
+#undef SWGL_GLSL_OP_ENUM
+    SWGL_GLSL_OP_ALU_COUNT,
+
+    // Data movement
+    SWGL_GLSL_OP_STORE = SWGL_GLSL_OP_ALU_COUNT, // dst = a in the active lanes
+    SWGL_GLSL_OP_LOADU,    // dst = uniforms[imm]; imm2 is the uniform index
+    SWGL_GLSL_OP_GATHERU,  // dst = uniforms[imm + clamp(a, 0, b - 1) * c]; imm2 is the uniform index
+    SWGL_GLSL_OP_GATHERR,  // dst = reg[b + clamp(a, 0, imm2 - 1) * imm]
+    SWGL_GLSL_OP_SCATTERR, // reg[b + clamp(c, 0, imm2 - 1) * imm] = a in the active lanes
+    SWGL_GLSL_OP_LOADIN,   // dst = inputs[imm]
+    SWGL_GLSL_OP_LOADB,    // dst = built-in input imm (SWGL_GLSL_BUILTIN_*)
+    SWGL_GLSL_OP_STOREOUT, // outputs[imm] = a
+
+    // Structured control flow; imm is the jump target where there is one
+    SWGL_GLSL_OP_IF,        // narrow the mask to a, or jump to the ELSE/ENDIF
+    SWGL_GLSL_OP_ELSE,      // switch to the other lanes, or jump to the ENDIF
+    SWGL_GLSL_OP_ENDIF,
+    SWGL_GLSL_OP_LOOP,      // enter a loop
+    SWGL_GLSL_OP_LOOP_TEST, // lanes with a false leave; jump to LOOP_EXIT when none remain
+    SWGL_GLSL_OP_ITER_END,  // continued lanes rejoin
+    SWGL_GLSL_OP_LOOP_NEXT, // jump back to imm while any lane is active
+    SWGL_GLSL_OP_LOOP_EXIT,
+    SWGL_GLSL_OP_BREAK,
+    SWGL_GLSL_OP_CONTINUE,
+    SWGL_GLSL_OP_FUNC_BEGIN, // inlined function body, so return only leaves the body
+    SWGL_GLSL_OP_FUNC_END,
+    SWGL_GLSL_OP_RET,
+    SWGL_GLSL_OP_DISCARD,
+    SWGL_GLSL_OP_COUNT
+};
+
+enum
+{
+    SWGL_GLSL_BUILTIN_FRAGCOORD = 0,   // 4 rows
+    SWGL_GLSL_BUILTIN_POINTCOORD = 4,  // 2 rows
+    SWGL_GLSL_BUILTIN_FRONTFACING = 6, // 1 row
+    SWGL_GLSL_BUILTIN_ROWS = 7
+};
+
+typedef struct SwglGlslInstr
+{
+    uint16_t op;
+    uint16_t dst;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+    int32_t imm;
+    int32_t imm2;
+} SwglGlslInstr;
+
+typedef struct SwglGlslConstant
+{
+    int reg;
+    float value;
+} SwglGlslConstant;
+
+struct SwglGlslShader
+{
+    SwglGlslStage stage;
+    unsigned flags;
+    unsigned serial; // identifies the constant registers an executor has loaded
+
+    SwglGlslInstr *code;
+    int codeCount;
+    int regCount;
+    SwglGlslConstant *constants;
+    int constantCount;
+
+    SwglGlslVariable *vars[3];
+    int varCount[3];
+    int inputRows;
+    int outputRows;
+    int uniformFloats;
+};
+
+unsigned swgl_glsl_next_serial(void);
+
+#endif // SWGL_GLSL_INTERNAL_H
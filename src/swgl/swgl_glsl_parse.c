@@ -0,0 +1,3510 @@
+// swgl_glsl_parse.c
+// GLSL ES 1.00 front end: preprocessor, tokenizer and a single-pass
+// recursive-descent parser that type-checks the source and emits the scalar
+// IR as it goes. Expressions whose operands are all constant are folded and
+// user functions are inlined at every call, so the IR needs no call stack.
+#include "swgl_glsl_internal.h"
+
+#include <ctype.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SWGL_GLSL_NAME 64
+#define SWGL_GLSL_MAX_ARGS 16
+#define SWGL_GLSL_MAX_MACRO_DEPTH 32
+#define SWGL_GLSL_MAX_CONDITIONALS 64
+// Register ids at or above this are constants and inputs loaded by the
+// prologue; they are moved after the temporaries once the size is known.
+#define SWGL_GLSL_PERSISTENT 0x8000
+
+// ---------------------------------------------------------------------------
+// Tokens
+
+enum
+{
+    SWGL_TOK_EOF,
+    SWGL_TOK_IDENT,
+    SWGL_TOK_INT,
+    SWGL_TOK_FLOAT,
+    SWGL_TOK_PUNCT
+};
+
+enum
+{
+    SWGL_P_INC = 256,
+    SWGL_P_DEC,
+    SWGL_P_LE,
+    SWGL_P_GE,
+    SWGL_P_EQ,
+    SWGL_P_NE,
+    SWGL_P_AND,
+    SWGL_P_OR,
+    SWGL_P_XOR,
+    SWGL_P_ADD_ASSIGN,
+    SWGL_P_SUB_ASSIGN,
+    SWGL_P_MUL_ASSIGN,
+    SWGL_P_DIV_ASSIGN,
+    SWGL_P_MOD_ASSIGN,
+    SWGL_P_SHL,
+    SWGL_P_SHR,
+    SWGL_P_SHL_ASSIGN,
+    SWGL_P_SHR_ASSIGN,
+    SWGL_P_AND_ASSIGN,
+    SWGL_P_OR_ASSIGN,
+    SWGL_P_XOR_ASSIGN
+};
+
+static const struct
+{
+    const char *text;
+    int punct;
+} swgl_punctuators[] = {
+    {"<<=", SWGL_P_SHL_ASSIGN}, {">>=", SWGL_P_SHR_ASSIGN}, {"++", SWGL_P_INC}, {"--", SWGL_P_DEC},
+    {"<=", SWGL_P_LE}, {">=", SWGL_P_GE}, {"==", SWGL_P_EQ}, {"!=", SWGL_P_NE},
+    {"&&", SWGL_P_AND}, {"||", SWGL_P_OR}, {"^^", SWGL_P_XOR}, {"+=", SWGL_P_ADD_ASSIGN},
+    {"-=", SWGL_P_SUB_ASSIGN}, {"*=", SWGL_P_MUL_ASSIGN}, {"/=", SWGL_P_DIV_ASSIGN}, {"%=", SWGL_P_MOD_ASSIGN},
+    {"<<", SWGL_P_SHL}, {">>", SWGL_P_SHR}, {"&=", SWGL_P_AND_ASSIGN}, {"|=", SWGL_P_OR_ASSIGN},
+    {"^=", SWGL_P_XOR_ASSIGN},
+};
+
+typedef struct SwglGlslToken
+{
+    int type;
+    int punct;
+    int line;
+    double value;
+    char text[SWGL_GLSL_NAME];
+} SwglGlslToken;
+
+typedef struct SwglGlslTokenList
+{
+    SwglGlslToken *items;
+    int count;
+    int capacity;
+} SwglGlslTokenList;
+
+typedef struct SwglGlslMacro
+{
+    char name[SWGL_GLSL_NAME];
+    int first; // body in SwglGlslParser.macroTokens
+    int count;
+    int expanding;
+} SwglGlslMacro;
+
+// ---------------------------------------------------------------------------
+// Types, values and symbols
+
+enum
+{
+    SWGL_T_VOID,
+    SWGL_T_FLOAT,
+    SWGL_T_INT,
+    SWGL_T_BOOL,
+    SWGL_T_SAMPLER2D,
+    SWGL_T_SAMPLERCUBE
+};
+
+typedef struct SwglGlslType
+{
+    unsigned char base;
+    unsigned char size;   // vector length, or N for matNxN
+    unsigned char matrix;
+    int array;            // element count, 0 for non-arrays
+} SwglGlslType;
+
+// A scalar operand: a register, or an immediate when reg is negative.
+typedef struct SwglGlslOperand
+{
+    int reg;
+    float k;
+} SwglGlslOperand;
+
+enum
+{
+    SWGL_LV_NONE,
+    SWGL_LV_REGS,   // components are writable registers
+    SWGL_LV_DYNAMIC // element of a register array chosen by an index register
+};
+
+enum
+{
+    SWGL_ST_REG,
+    SWGL_ST_CONST,
+    SWGL_ST_UNIFORM,
+    SWGL_ST_INPUT,
+    SWGL_ST_BUILTIN
+};
+
+typedef struct SwglGlslValue
+{
+    SwglGlslType type;
+    SwglGlslOperand c[16];
+    int lvalue;
+    // Arrays are only usable through indexing
+    int arrayStorage; // SWGL_ST_REG or SWGL_ST_UNIFORM
+    int arrayBase;    // first register, or uniform index
+    int dynBase;
+    int dynStride;
+    int dynCount;
+    int dynIndex;
+    unsigned char dynComp[16];
+} SwglGlslValue;
+
+typedef struct SwglGlslSymbol
+{
+    char name[SWGL_GLSL_NAME];
+    SwglGlslType type;
+    int storage;
+    int base; // register, declaration index or built-in row
+    int readOnly;
+    float value[16];
+} SwglGlslSymbol;
+
+enum
+{
+    SWGL_PARAM_IN,
+    SWGL_PARAM_OUT,
+    SWGL_PARAM_INOUT
+};
+
+typedef struct SwglGlslParam
+{
+    char name[SWGL_GLSL_NAME];
+    SwglGlslType type;
+    int qualifier;
+    int readOnly;
+} SwglGlslParam;
+
+typedef struct SwglGlslFunction
+{
+    char name[SWGL_GLSL_NAME];
+    SwglGlslType returnType;
+    SwglGlslParam params[SWGL_GLSL_MAX_ARGS];
+    int paramCount;
+    int bodyStart; // token index of the body, -1 for a prototype
+    int active;    // being inlined; a second entry is recursion
+} SwglGlslFunction;
+
+// Uniform, attribute or varying declared at global scope
+typedef struct SwglGlslDecl
+{
+    SwglGlslVariable info;
+    SwglGlslType type;
+    int cache;         // inputs: first register loaded by the prologue, -1 until used
+    int *uniformRegs;  // uniforms: register per float, -1 until used
+    int reg;           // vertex varyings: first register
+} SwglGlslDecl;
+
+typedef struct SwglGlslScope
+{
+    int scopeStart;
+    int regTop;
+} SwglGlslScope;
+
+typedef struct SwglGlslParser
+{
+    SwglGlslStage stage;
+    char *log;
+    size_t logSize;
+    jmp_buf fail;
+
+    // Preprocessor
+    char *text;
+    SwglGlslTokenList tokens;
+    SwglGlslTokenList macroTokens;
+    SwglGlslTokenList exprTokens;
+    SwglGlslMacro *macros;
+    int macroCount;
+    int macroCapacity;
+    int condActive[SWGL_GLSL_MAX_CONDITIONALS];
+    int condTaken[SWGL_GLSL_MAX_CONDITIONALS];
+    int condElse[SWGL_GLSL_MAX_CONDITIONALS];
+    int condDepth;
+    int sawDirective;
+
+    // Parser state
+    int pos;
+    SwglGlslSymbol *symbols;
+    int symbolCount;
+    int symbolCapacity;
+    int scopeStart;
+    int globalCount; // symbols at global scope, set before main is expanded
+    int frameStart;  // first symbol of the function being inlined
+    SwglGlslFunction *functions;
+    int functionCount;
+    int functionCapacity;
+    SwglGlslDecl *decls[3];
+    int declCount[3];
+    int declCapacity[3];
+    int builtinCache[SWGL_GLSL_BUILTIN_ROWS];
+
+    // Code generation
+    SwglGlslInstr *code;
+    int codeCount;
+    int codeCapacity;
+    SwglGlslInstr *prologue;
+    int prologueCount;
+    int prologueCapacity;
+    SwglGlslConstant *consts; // reg holds the persistent register id
+    int constCount;
+    int constCapacity;
+    SwglGlslConstant *globalInits;
+    int globalInitCount;
+    int globalInitCapacity;
+    int regTop;
+    int regMax;
+    int persistCount;
+    int tempFloor;  // registers at or above it are temporaries of this statement
+    int stmtStart;  // first instruction of the current statement
+    int maskDepth;  // enclosing ifs, loops and inlined calls
+    int loopDepth;
+    int dryRun;     // checking a function body at its definition
+    int inMain;
+    int mainReturned;
+    SwglGlslType returnType;
+    int resultBase;
+    int mainIndex;
+    int positionReg;
+    int pointSizeReg;
+    int fragColorReg;
+    int pointSizeWritten;
+} SwglGlslParser;
+
+static const int swgl_glsl_alu_args[] = {
+#define SWGL_GLSL_OP_ARGS(name, args, expr) args,
+    SWGL_GLSL_ALU_OPS(SWGL_GLSL_OP_ARGS)
+#undef SWGL_GLSL_OP_ARGS
+};
+
+static float swgl_glsl_fold(int op, float a, float b, float c)
+{
+    switch (op)
+    {
+#define SWGL_GLSL_OP_FOLD(name, args, expr) \
+    case SWGL_GLSL_OP_##name:               \
+        return (expr);
+        SWGL_GLSL_ALU_OPS(SWGL_GLSL_OP_FOLD)
+#undef SWGL_GLSL_OP_FOLD
+    }
+    (void)b;
+    (void)c;
+    return a;
+}
+
+// ---------------------------------------------------------------------------
+// Errors and storage
+
+_Noreturn static void swgl_error(SwglGlslParser *p, int line, const char *token, const char *format, ...)
+{
+    if (p->log && p->logSize)
+    {
+        int n = token && token[0] ? snprintf(p->log, p->logSize, "ERROR: 0:%d: '%s' : ", line, token)
+                                  : snprintf(p->log, p->logSize, "ERROR: 0:%d: ", line);
+        if (n >= 0 && (size_t)n < p->logSize)
+        {
+            va_list args;
+            va_start(args, format);
+            int m = vsnprintf(p->log + n, p->logSize - (size_t)n, format, args);
+            va_end(args);
+            if (m >= 0 && (size_t)(n + m) + 1 < p->logSize)
+                strcpy(p->log + n + m, "\n");
+        }
+    }
+    longjmp(p->fail, 1);
+}
+
+static void *swgl_grow(SwglGlslParser *p, void *items, int *capacity, int count, size_t size)
+{
+    if (count < *capacity)
+        return items;
+    int grown = *capacity ? *capacity * 2 : 16;
+    void *resized = realloc(items, (size_t)grown * size);
+    if (!resized)
+        swgl_error(p, 0, NULL, "out of memory");
+    *capacity = grown;
+    return resized;
+}
+
+static void swgl_token_push(SwglGlslParser *p, SwglGlslTokenList *list, const SwglGlslToken *tok)
+{
+    list->items = (SwglGlslToken *)swgl_grow(p, list->items, &list->capacity, list->count, sizeof(SwglGlslToken));
+    list->items[list->count++] = *tok;
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+
+// Reads one token from s and returns the position after it.
+static const char *swgl_lex(SwglGlslParser *p, const char *s, int line, SwglGlslToken *tok)
+{
+    while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\v' || *s == '\f')
+        s++;
+    tok->line = line;
+    tok->punct = 0;
+    tok->value = 0.0;
+    tok->text[0] = '\0';
+    if (!*s)
+    {
+        tok->type = SWGL_TOK_EOF;
+        return s;
+    }
+    const char *start = s;
+    if (isalpha((unsigned char)*s) || *s == '_')
+    {
+        while (isalnum((unsigned char)*s) || *s == '_')
+            s++;
+        if (s - start >= SWGL_GLSL_NAME)
+            swgl_error(p, line, NULL, "identifier is too long");
+        tok->type = SWGL_TOK_IDENT;
+        memcpy(tok->text, start, (size_t)(s - start));
+        tok->text[s - start] = '\0';
+        return s;
+    }
+    if (isdigit((unsigned char)*s) || (*s == '.' && isdigit((unsigned char)s[1])))
+    {
+        int isFloat = 0;
+        if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        {
+            char *end;
+            tok->value = (double)strtoull(s + 2, &end, 16);
+            if (end == s + 2)
+                swgl_error(p, line, NULL, "invalid hexadecimal constant");
+            s = end;
+        }
+        else
+        {
+            while (isdigit((unsigned char)*s))
+                s++;
+            if (*s == '.')
+            {
+                isFloat = 1;
+                s++;
+                while (isdigit((unsigned char)*s))
+                    s++;
+            }
+            if (*s == 'e' || *s == 'E')
+            {
+                const char *e = s + 1;
+                if (*e == '+' || *e == '-')
+                    e++;
+                if (!isdigit((unsigned char)*e))
+                    swgl_error(p, line, NULL, "invalid exponent in floating-point constant");
+                isFloat = 1;
+                s = e;
+                while (isdigit((unsigned char)*s))
+                    s++;
+            }
+            if (isFloat)
+            {
+                tok->value = strtod(start, NULL);
+                if (*s == 'f' || *s == 'F')
+                    s++; // not GLSL ES 1.00, but accepted by common drivers
+            }
+            else
+            {
+                char *end;
+                tok->value = (double)strtoull(start, &end, start[0] == '0' ? 8 : 10);
+                if (end != s)
+                    swgl_error(p, line, NULL, "invalid octal constant");
+            }
+        }
+        if (isalnum((unsigned char)*s) || *s == '_' || *s == '.')
+            swgl_error(p, line, NULL, "invalid numeric constant");
+        if (!isFloat && tok->value > 2147483647.0)
+            swgl_error(p, line, NULL, "integer constant overflow");
+        tok->type = isFloat ? SWGL_TOK_FLOAT : SWGL_TOK_INT;
+        size_t length = (size_t)(s - start) < SWGL_GLSL_NAME - 1 ? (size_t)(s - start) : SWGL_GLSL_NAME - 1;
+        memcpy(tok->text, start, length);
+        tok->text[length] = '\0';
+        return s;
+    }
+    tok->type = SWGL_TOK_PUNCT;
+    for (size_t i = 0; i < sizeof(swgl_punctuators) / sizeof(swgl_punctuators[0]); ++i)
+    {
+        size_t length = strlen(swgl_punctuators[i].text);
+        if (strncmp(s, swgl_punctuators[i].text, length) == 0)
+        {
+            tok->punct = swgl_punctuators[i].punct;
+            memcpy(tok->text, s, length);
+            tok->text[length] = '\0';
+            return s + length;
+        }
+    }
+    if (!strchr("+-*/%<>=!&|^~?:;,.()[]{}", *s))
+    {
+        char bad[2] = {*s, '\0'};
+        swgl_error(p, line, bad, "invalid character");
+    }
+    tok->punct = (unsigned char)*s;
+    tok->text[0] = *s;
+    tok->text[1] = '\0';
+    return s + 1;
+}
+
+// ---------------------------------------------------------------------------
+// Preprocessor: conditionals, object-like macros and the GLSL directives
+
+static int swgl_pp_find_macro(const SwglGlslParser *p, const char *name)
+{
+    for (int i = 0; i < p->macroCount; ++i)
+    {
+        if (strcmp(p->macros[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int swgl_pp_active(const SwglGlslParser *p)
+{
+    return p->condDepth == 0 || p->condActive[p->condDepth - 1];
+}
+
+static void swgl_pp_define(SwglGlslParser *p, const char *name, const char *body, int line)
+{
+    p->macros = (SwglGlslMacro *)swgl_grow(p, p->macros, &p->macroCapacity, p->macroCount, sizeof(SwglGlslMacro));
+    SwglGlslMacro *macro = &p->macros[p->macroCount++];
+    memset(macro, 0, sizeof(*macro));
+    snprintf(macro->name, sizeof(macro->name), "%s", name);
+    macro->first = p->macroTokens.count;
+    SwglGlslToken tok;
+    for (const char *s = swgl_lex(p, body, line, &tok); tok.type != SWGL_TOK_EOF; s = swgl_lex(p, s, line, &tok))
+        swgl_token_push(p, &p->macroTokens, &tok);
+    p->macros[p->macroCount - 1].count = p->macroTokens.count - p->macros[p->macroCount - 1].first;
+}
+
+// Appends tok to out, replacing macros by their expansion.
+static void swgl_pp_push(SwglGlslParser *p, SwglGlslTokenList *out, const SwglGlslToken *tok, int line, int depth)
+{
+    SwglGlslToken copy = *tok;
+    copy.line = line;
+    if (tok->type == SWGL_TOK_IDENT)
+    {
+        if (strcmp(tok->text, "__LINE__") == 0 || strcmp(tok->text, "__FILE__") == 0)
+        {
+            copy.type = SWGL_TOK_INT;
+            copy.value = tok->text[2] == 'L' ? line : 0;
+            snprintf(copy.text, sizeof(copy.text), "%d", (int)copy.value);
+        }
+        else
+        {
+            int m = swgl_pp_find_macro(p, tok->text);
+            if (m >= 0 && !p->macros[m].expanding)
+            {
+                if (depth >= SWGL_GLSL_MAX_MACRO_DEPTH)
+                    swgl_error(p, line, tok->text, "macro expansion is too deep");
+                p->macros[m].expanding = 1;
+                for (int i = 0; i < p->macros[m].count; ++i)
+                {
+                    SwglGlslToken body = p->macroTokens.items[p->macros[m].first + i];
+                    swgl_pp_push(p, out, &body, line, depth + 1);
+                }
+                p->macros[m].expanding = 0;
+                return;
+            }
+        }
+    }
+    swgl_token_push(p, out, &copy);
+}
+
+static long long swgl_pp_expr(SwglGlslParser *p, int *pos, int minLevel, int line);
+
+static long long swgl_pp_unary(SwglGlslParser *p, int *pos, int line)
+{
+    const SwglGlslToken *tok = &p->exprTokens.items[(*pos)++];
+    if (tok->type == SWGL_TOK_INT)
+        return (long long)tok->value;
+    if (tok->type == SWGL_TOK_PUNCT)
+    {
+        switch (tok->punct)
+        {
+        case '(':
+        {
+            long long value = swgl_pp_expr(p, pos, 0, line);
+            if (p->exprTokens.items[*pos].punct != ')')
+                swgl_error(p, line, "#if", "missing ')' in preprocessor expression");
+            (*pos)++;
+            return value;
+        }
+        case '+':
+            return swgl_pp_unary(p, pos, line);
+        case '-':
+            return -swgl_pp_unary(p, pos, line);
+        case '~':
+            return ~swgl_pp_unary(p, pos, line);
+        case '!':
+            return !swgl_pp_unary(p, pos, line);
+        }
+    }
+    if (tok->type == SWGL_TOK_IDENT)
+        swgl_error(p, line, tok->text, "undefined identifier in preprocessor expression");
+    swgl_error(p, line, tok->text, "invalid preprocessor expression");
+}
+
+static int swgl_pp_level(const SwglGlslToken *tok)
+{
+    if (tok->type != SWGL_TOK_PUNCT)
+        return -1;
+    switch (tok->punct)
+    {
+    case SWGL_P_OR: return 1;
+    case SWGL_P_AND: return 2;
+    case '|': return 3;
+    case '^': return 4;
+    case '&': return 5;
+    case SWGL_P_EQ: case SWGL_P_NE: return 6;
+    case '<': case '>': case SWGL_P_LE: case SWGL_P_GE: return 7;
+    case SWGL_P_SHL: case SWGL_P_SHR: return 8;
+    case '+': case '-': return 9;
+    case '*': case '/': case '%': return 10;
+    }
+    return -1;
+}
+
+static long long swgl_pp_expr(SwglGlslParser *p, int *pos, int minLevel, int line)
+{
+    long long left = swgl_pp_unary(p, pos, line);
+    for (;;)
+    {
+        const SwglGlslToken *tok = &p->exprTokens.items[*pos];
+        int level = swgl_pp_level(tok);
+        if (level <= minLevel)
+            return left;
+        int op = tok->punct;
+        (*pos)++;
+        long long right = swgl_pp_expr(p, pos, level, line);
+        switch (op)
+        {
+        case SWGL_P_OR: left = left || right; break;
+        case SWGL_P_AND: left = left && right; break;
+        case '|': left |= right; break;
+        case '^': left ^= right; break;
+        case '&': left &= right; break;
+        case SWGL_P_EQ: left = left == right; break;
+        case SWGL_P_NE: left = left != right; break;
+        case '<': left = left < right; break;
+        case '>': left = left > right; break;
+        case SWGL_P_LE: left = left <= right; break;
+        case SWGL_P_GE: left = left >= right; break;
+        case SWGL_P_SHL: left = (right >= 0 && right < 63) ? left << right : 0; break;
+        case SWGL_P_SHR: left = (right >= 0 && right < 63) ? left >> right : 0; break;
+        case '+': left += right; break;
+        case '-': left -= right; break;
+        case '*': left *= right; break;
+        case '/':
+        case '%':
+            if (right == 0)
+                swgl_error(p, line, "#if", "division by zero in preprocessor expression");
+            left = op == '/' ? left / right : left % right;
+            break;
+        }
+    }
+}
+
+static long long swgl_pp_eval(SwglGlslParser *p, const char *s, int line)
+{
+    p->exprTokens.count = 0;
+    SwglGlslToken tok;
+    for (s = swgl_lex(p, s, line, &tok); tok.type != SWGL_TOK_EOF; s = swgl_lex(p, s, line, &tok))
+    {
+        if (tok.type == SWGL_TOK_IDENT && strcmp(tok.text, "defined") == 0)
+        {
+            SwglGlslToken name;
+            s = swgl_lex(p, s, line, &name);
+            int paren = name.type == SWGL_TOK_PUNCT && name.punct == '(';
+            if (paren)
+                s = swgl_lex(p, s, line, &name);
+            if (name.type != SWGL_TOK_IDENT)
+                swgl_error(p, line, "defined", "macro name expected");
+            if (paren)
+            {
+                SwglGlslToken close;
+                s = swgl_lex(p, s, line, &close);
+                if (close.type != SWGL_TOK_PUNCT || close.punct != ')')
+                    swgl_error(p, line, "defined", "missing ')'");
+            }
+            SwglGlslToken value = {SWGL_TOK_INT, 0, line, swgl_pp_find_macro(p, name.text) >= 0 ? 1.0 : 0.0, "1"};
+            swgl_token_push(p, &p->exprTokens, &value);
+        }
+        else
+            swgl_pp_push(p, &p->exprTokens, &tok, line, 0);
+    }
+    SwglGlslToken end = {SWGL_TOK_EOF, 0, line, 0.0, ""};
+    swgl_token_push(p, &p->exprTokens, &end);
+    int pos = 0;
+    long long value = swgl_pp_expr(p, &pos, 0, line);
+    if (p->exprTokens.items[pos].type != SWGL_TOK_EOF)
+        swgl_error(p, line, p->exprTokens.items[pos].text, "unexpected token in preprocessor expression");
+    return value;
+}
+
+static void swgl_pp_push_conditional(SwglGlslParser *p, int active, int line)
+{
+    if (p->condDepth == SWGL_GLSL_MAX_CONDITIONALS)
+        swgl_error(p, line, "#if", "conditionals nested too deeply");
+    p->condActive[p->condDepth] = active;
+    p->condTaken[p->condDepth] = active;
+    p->condElse[p->condDepth] = 0;
+    p->condDepth++;
+}
+
+static int swgl_pp_is_reserved_macro(const char *name)
+{
+    return strncmp(name, "GL_", 3) == 0 || strstr(name, "__") != NULL;
+}
+
+static void swgl_pp_directive(SwglGlslParser *p, const char *s, int line)
+{
+    SwglGlslToken name;
+    s = swgl_lex(p, s, line, &name);
+    if (name.type == SWGL_TOK_EOF)
+        return; // null directive
+    int active = swgl_pp_active(p);
+    if (name.type != SWGL_TOK_IDENT)
+    {
+        if (active)
+            swgl_error(p, line, name.text, "invalid directive");
+        return;
+    }
+    if (strcmp(name.text, "ifdef") == 0 || strcmp(name.text, "ifndef") == 0)
+    {
+        int taken = 0;
+        if (active)
+        {
+            SwglGlslToken macro;
+            swgl_lex(p, s, line, &macro);
+            if (macro.type != SWGL_TOK_IDENT)
+                swgl_error(p, line, name.text, "macro name expected");
+            taken = (swgl_pp_find_macro(p, macro.text) >= 0) == (name.text[2] == 'd');
+        }
+        swgl_pp_push_conditional(p, taken, line);
+        p->condTaken[p->condDepth - 1] = taken || !active;
+        return;
+    }
+    if (strcmp(name.text, "if") == 0)
+    {
+        int taken = active && swgl_pp_eval(p, s, line) != 0;
+        swgl_pp_push_conditional(p, taken, line);
+        p->condTaken[p->condDepth - 1] = taken || !active;
+        return;
+    }
+    if (strcmp(name.text, "elif") == 0 || strcmp(name.text, "else") == 0 || strcmp(name.text, "endif") == 0)
+    {
+        if (p->condDepth == 0)
+            swgl_error(p, line, name.text, "unexpected directive without #if");
+        int top = p->condDepth - 1;
+        if (name.text[1] == 'n')
+        {
+            p->condDepth--;
+            return;
+        }
+        if (p->condElse[top])
+            swgl_error(p, line, name.text, "directive after #else");
+        if (name.text[2] == 'i')
+        {
+            int taken = !p->condTaken[top] && swgl_pp_eval(p, s, line) != 0;
+            p->condActive[top] = taken;
+            p->condTaken[top] |= taken;
+        }
+        else
+        {
+            p->condActive[top] = !p->condTaken[top];
+            p->condTaken[top] = 1;
+            p->condElse[top] = 1;
+        }
+        return;
+    }
+    if (!active)
+        return;
+
+    if (strcmp(name.text, "version") == 0)
+    {
+        SwglGlslToken version;
+        swgl_lex(p, s, line, &version);
+        if (p->tokens.count > 0 || p->sawDirective)
+            swgl_error(p, line, "#version", "must occur before anything else in the program");
+        if (version.type != SWGL_TOK_INT || version.value != 100.0)
+            swgl_error(p, line, version.text, "version number not supported");
+        return;
+    }
+    p->sawDirective = 1;
+    if (strcmp(name.text, "define") == 0)
+    {
+        SwglGlslToken macro;
+        s = swgl_lex(p, s, line, &macro);
+        if (macro.type != SWGL_TOK_IDENT)
+            swgl_error(p, line, "#define", "macro name expected");
+        if (swgl_pp_is_reserved_macro(macro.text))
+            swgl_error(p, line, macro.text, "reserved macro name");
+        if (*s == '(')
+            swgl_error(p, line, macro.text, "function-like macros are not supported");
+        int existing = swgl_pp_find_macro(p, macro.text);
+        swgl_pp_define(p, macro.text, s, line);
+        if (existing >= 0)
+        {
+            // Redefinition is only allowed with an identical body
+            const SwglGlslMacro *a = &p->macros[existing], *b = &p->macros[p->macroCount - 1];
+            int same = a->count == b->count;
+            for (int i = 0; same && i < a->count; ++i)
+            {
+                const SwglGlslToken *x = &p->macroTokens.items[a->first + i];
+                const SwglGlslToken *y = &p->macroTokens.items[b->first + i];
+                same = x->type == y->type && strcmp(x->text, y->text) == 0;
+            }
+            if (!same)
+                swgl_error(p, line, macro.text, "macro redefined");
+            p->macroCount--;
+        }
+        return;
+    }
+    if (strcmp(name.text, "undef") == 0)
+    {
+        SwglGlslToken macro;
+        swgl_lex(p, s, line, &macro);
+        if (macro.type != SWGL_TOK_IDENT)
+            swgl_error(p, line, "#undef", "macro name expected");
+        if (swgl_pp_is_reserved_macro(macro.text))
+            swgl_error(p, line, macro.text, "cannot undefine a predefined macro");
+        int m = swgl_pp_find_macro(p, macro.text);
+        if (m >= 0)
+            p->macros[m].name[0] = '\0';
+        return;
+    }
+    if (strcmp(name.text, "error") == 0)
+        swgl_error(p, line, "#error", "%s", s);
+    if (strcmp(name.text, "extension") == 0)
+    {
+        SwglGlslToken extension, colon, behavior;
+        s = swgl_lex(p, s, line, &extension);
+        s = swgl_lex(p, s, line, &colon);
+        swgl_lex(p, s, line, &behavior);
+        if (extension.type != SWGL_TOK_IDENT || colon.punct != ':' || behavior.type != SWGL_TOK_IDENT)
+            swgl_error(p, line, "#extension", "syntax error");
+        int all = strcmp(extension.text, "all") == 0;
+        if (strcmp(behavior.text, "require") == 0 || (all && strcmp(behavior.text, "enable") == 0))
+            swgl_error(p, line, extension.text, "extension is not supported");
+        if (strcmp(behavior.text, "enable") && strcmp(behavior.text, "warn") && strcmp(behavior.text, "disable") &&
+            strcmp(behavior.text, "require"))
+            swgl_error(p, line, behavior.text, "invalid extension behavior");
+        return;
+    }
+    if (strcmp(name.text, "pragma") == 0 || strcmp(name.text, "line") == 0)
+        return;
+    swgl_error(p, line, name.text, "invalid directive");
+}
+
+static void swgl_pp_run(SwglGlslParser *p, const char *source)
+{
+    size_t length = strlen(source);
+    p->text = (char *)malloc(length + 1);
+    if (!p->text)
+        swgl_error(p, 0, NULL, "out of memory");
+
+    // Comments become spaces; newlines are kept so line numbers stay right
+    int line = 1;
+    for (size_t i = 0; i <= length; ++i)
+    {
+        char ch = source[i];
+        if (ch == '/' && source[i + 1] == '/')
+        {
+            while (source[i] && source[i] != '\n')
+                p->text[i++] = ' ';
+            p->text[i] = source[i];
+            line += source[i] == '\n';
+        }
+        else if (ch == '/' && source[i + 1] == '*')
+        {
+            int startLine = line;
+            p->text[i] = p->text[i + 1] = ' ';
+            for (i += 2; source[i] && !(source[i] == '*' && source[i + 1] == '/'); ++i)
+            {
+                p->text[i] = source[i] == '\n' ? '\n' : ' ';
+                line += source[i] == '\n';
+            }
+            if (!source[i])
+                swgl_error(p, startLine, NULL, "unterminated comment");
+            p->text[i] = p->text[i + 1] = ' ';
+            i++;
+        }
+        else
+        {
+            p->text[i] = ch;
+            line += ch == '\n';
+        }
+    }
+
+    swgl_pp_define(p, "GL_ES", "1", 0);
+    swgl_pp_define(p, "__VERSION__", "100", 0);
+    swgl_pp_define(p, "GL_FRAGMENT_PRECISION_HIGH", "1", 0);
+
+    line = 1;
+    for (char *s = p->text;; ++line)
+    {
+        char *end = strchr(s, '\n');
+        if (end)
+            *end = '\0';
+        const char *t = s;
+        while (*t == ' ' || *t == '\t' || *t == '\r' || *t == '\v' || *t == '\f')
+            t++;
+        if (*t == '#')
+            swgl_pp_directive(p, t + 1, line);
+        else if (swgl_pp_active(p))
+        {
+            SwglGlslToken tok;
+            for (t = swgl_lex(p, t, line, &tok); tok.type != SWGL_TOK_EOF; t = swgl_lex(p, t, line, &tok))
+                swgl_pp_push(p, &p->tokens, &tok, line, 0);
+        }
+        if (!end)
+            break;
+        s = end + 1;
+    }
+    if (p->condDepth)
+        swgl_error(p, line, NULL, "unterminated #if");
+    SwglGlslToken eof = {SWGL_TOK_EOF, 0, line, 0.0, ""};
+    swgl_token_push(p, &p->tokens, &eof);
+}
+
+// ---------------------------------------------------------------------------
+// Parser helpers
+
+static SwglGlslToken *swgl_peek(SwglGlslParser *p, int ahead)
+{
+    int index = p->pos + ahead;
+    return &p->tokens.items[index < p->tokens.count ? index : p->tokens.count - 1];
+}
+
+static SwglGlslToken *swgl_next(SwglGlslParser *p)
+{
+    SwglGlslToken *tok = &p->tokens.items[p->pos];
+    if (tok->type != SWGL_TOK_EOF)
+        p->pos++;
+    return tok;
+}
+
+static int swgl_is_punct(const SwglGlslToken *tok, int punct)
+{
+    return tok->type == SWGL_TOK_PUNCT && tok->punct == punct;
+}
+
+static int swgl_is_word(const SwglGlslToken *tok, const char *word)
+{
+    return tok->type == SWGL_TOK_IDENT && strcmp(tok->text, word) == 0;
+}
+
+static int swgl_accept(SwglGlslParser *p, int punct)
+{
+    if (!swgl_is_punct(swgl_peek(p, 0), punct))
+        return 0;
+    p->pos++;
+    return 1;
+}
+
+static int swgl_accept_word(SwglGlslParser *p, const char *word)
+{
+    if (!swgl_is_word(swgl_peek(p, 0), word))
+        return 0;
+    p->pos++;
+    return 1;
+}
+
+static void swgl_expect(SwglGlslParser *p, int punct)
+{
+    if (!swgl_accept(p, punct))
+    {
+        const SwglGlslToken *tok = swgl_peek(p, 0);
+        swgl_error(p, tok->line, tok->type == SWGL_TOK_EOF ? "end of file" : tok->text,
+                   "syntax error, expected '%c'", punct);
+    }
+}
+
+static const char *const swgl_keywords[] = {
+    "attribute", "const", "uniform", "varying", "break", "continue", "do", "for", "while", "if", "else",
+    "in", "out", "inout", "float", "int", "void", "bool", "true", "false", "lowp", "mediump", "highp",
+    "precision", "invariant", "discard", "return", "mat2", "mat3", "mat4", "vec2", "vec3", "vec4",
+    "ivec2", "ivec3", "ivec4", "bvec2", "bvec3", "bvec4", "sampler2D", "samplerCube", "struct",
+    // reserved for future use
+    "asm", "class", "union", "enum", "typedef", "template", "this", "packed", "goto", "switch", "default",
+    "inline", "noinline", "volatile", "public", "static", "extern", "external", "interface", "flat", "long",
+    "short", "double", "half", "fixed", "unsigned", "superp", "input", "output", "hvec2", "hvec3", "hvec4",
+    "dvec2", "dvec3", "dvec4", "fvec2", "fvec3", "fvec4", "sampler1D", "sampler3D", "sampler1DShadow",
+    "sampler2DShadow", "sampler2DRect", "sampler3DRect", "sampler2DRectShadow", "sizeof", "cast",
+    "namespace", "using",
+};
+
+// Reads the name of a new declaration.
+static const SwglGlslToken *swgl_expect_name(SwglGlslParser *p)
+{
+    const SwglGlslToken *tok = swgl_next(p);
+    if (tok->type != SWGL_TOK_IDENT)
+        swgl_error(p, tok->line, tok->type == SWGL_TOK_EOF ? "end of file" : tok->text, "syntax error, identifier expected");
+    for (size_t i = 0; i < sizeof(swgl_keywords) / sizeof(swgl_keywords[0]); ++i)
+    {
+        if (strcmp(tok->text, swgl_keywords[i]) == 0)
+            swgl_error(p, tok->line, tok->text, "reserved word used as an identifier");
+    }
+    if (strncmp(tok->text, "gl_", 3) == 0 || strstr(tok->text, "__"))
+        swgl_error(p, tok->line, tok->text, "reserved built-in name");
+    return tok;
+}
+
+// ---------------------------------------------------------------------------
+// Types
+
+static const struct
+{
+    const char *name;
+    unsigned char base, size, matrix;
+    GLenum gl;
+} swgl_type_names[] = {
+    {"void", SWGL_T_VOID, 0, 0, 0},
+    {"float", SWGL_T_FLOAT, 1, 0, GL_FLOAT}, {"vec2", SWGL_T_FLOAT, 2, 0, GL_FLOAT_VEC2},
+    {"vec3", SWGL_T_FLOAT, 3, 0, GL_FLOAT_VEC3}, {"vec4", SWGL_T_FLOAT, 4, 0, GL_FLOAT_VEC4},
+    {"int", SWGL_T_INT, 1, 0, GL_INT}, {"ivec2", SWGL_T_INT, 2, 0, GL_INT_VEC2},
+    {"ivec3", SWGL_T_INT, 3, 0, GL_INT_VEC3}, {"ivec4", SWGL_T_INT, 4, 0, GL_INT_VEC4},
+    {"bool", SWGL_T_BOOL, 1, 0, GL_BOOL}, {"bvec2", SWGL_T_BOOL, 2, 0, GL_BOOL_VEC2},
+    {"bvec3", SWGL_T_BOOL, 3, 0, GL_BOOL_VEC3}, {"bvec4", SWGL_T_BOOL, 4, 0, GL_BOOL_VEC4},
+    {"mat2", SWGL_T_FLOAT, 2, 1, GL_FLOAT_MAT2}, {"mat3", SWGL_T_FLOAT, 3, 1, GL_FLOAT_MAT3},
+    {"mat4", SWGL_T_FLOAT, 4, 1, GL_FLOAT_MAT4},
+    {"sampler2D", SWGL_T_SAMPLER2D, 1, 0, GL_SAMPLER_2D}, {"samplerCube", SWGL_T_SAMPLERCUBE, 1, 0, GL_SAMPLER_CUBE},
+};
+
+static SwglGlslType swgl_type(int base, int size, int matrix)
+{
+    SwglGlslType type = {(unsigned char)base, (unsigned char)size, (unsigned char)matrix, 0};
+    return type;
+}
+
+static int swgl_components(const SwglGlslType *type)
+{
+    return type->matrix ? type->size * type->size : type->size;
+}
+
+static int swgl_type_equal(const SwglGlslType *a, const SwglGlslType *b)
+{
+    return a->base == b->base && a->size == b->size && a->matrix == b->matrix && a->array == b->array;
+}
+
+static int swgl_is_scalar(const SwglGlslType *type)
+{
+    return type->size == 1 && !type->matrix && !type->array;
+}
+
+static int swgl_is_sampler(const SwglGlslType *type)
+{
+    return type->base == SWGL_T_SAMPLER2D || type->base == SWGL_T_SAMPLERCUBE;
+}
+
+static int swgl_type_index(const SwglGlslType *type)
+{
+    for (size_t i = 0; i < sizeof(swgl_type_names) / sizeof(swgl_type_names[0]); ++i)
+    {
+        if (swgl_type_names[i].base == type->base && swgl_type_names[i].size == type->size &&
+            swgl_type_names[i].matrix == type->matrix)
+            return (int)i;
+    }
+    return 0;
+}
+
+static const char *swgl_type_name(const SwglGlslType *type)
+{
+    return swgl_type_names[swgl_type_index(type)].name;
+}
+
+// Consumes a type keyword if there is one.
+static int swgl_parse_type(SwglGlslParser *p, SwglGlslType *type)
+{
+    const SwglGlslToken *tok = swgl_peek(p, 0);
+    if (swgl_is_word(tok, "struct"))
+        swgl_error(p, tok->line, "struct", "structures are not supported");
+    for (size_t i = 0; i < sizeof(swgl_type_names) / sizeof(swgl_type_names[0]); ++i)
+    {
+        if (swgl_is_word(tok, swgl_type_names[i].name))
+        {
+            *type = swgl_type(swgl_type_names[i].base, swgl_type_names[i].size, swgl_type_names[i].matrix);
+            p->pos++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int swgl_accept_precision(SwglGlslParser *p)
+{
+    return swgl_accept_word(p, "lowp") || swgl_accept_word(p, "mediump") || swgl_accept_word(p, "highp");
+}
+
+// ---------------------------------------------------------------------------
+// Registers and instructions
+
+static int swgl_reg_alloc(SwglGlslParser *p, int count)
+{
+    int reg = p->regTop;
+    p->regTop += count;
+    if (p->regTop >= SWGL_GLSL_PERSISTENT)
+        swgl_error(p, swgl_peek(p, 0)->line, NULL, "shader is too complex");
+    if (p->regTop > p->regMax)
+        p->regMax = p->regTop;
+    return reg;
+}
+
+static int swgl_reg_persistent(SwglGlslParser *p, int count)
+{
+    int reg = SWGL_GLSL_PERSISTENT + p->persistCount;
+    p->persistCount += count;
+    if (p->persistCount >= SWGL_GLSL_PERSISTENT)
+        swgl_error(p, swgl_peek(p, 0)->line, NULL, "shader is too complex");
+    return reg;
+}
+
+static int swgl_emit_to(SwglGlslParser *p, int prologue, int op, int dst, int a, int b, int c, int imm, int imm2)
+{
+    SwglGlslInstr **code = prologue ? &p->prologue : &p->code;
+    int *count = prologue ? &p->prologueCount : &p->codeCount;
+    int *capacity = prologue ? &p->prologueCapacity : &p->codeCapacity;
+    *code = (SwglGlslInstr *)swgl_grow(p, *code, capacity, *count, sizeof(SwglGlslInstr));
+    SwglGlslInstr *in = &(*code)[*count];
+    in->op = (uint16_t)op;
+    in->dst = (uint16_t)dst;
+    in->a = (uint16_t)a;
+    in->b = (uint16_t)b;
+    in->c = (uint16_t)c;
+    in->imm = imm;
+    in->imm2 = imm2;
+    return (*count)++;
+}
+
+static int swgl_emit(SwglGlslParser *p, int op, int dst, int a, int b, int c, int imm, int imm2)
+{
+    return swgl_emit_to(p, 0, op, dst, a, b, c, imm, imm2);
+}
+
+// Instructions that push an execution-mask frame
+static int swgl_emit_nested(SwglGlslParser *p, int op, int a, int line)
+{
+    if (p->maskDepth + 1 >= SWGL_GLSL_MAX_NESTING)
+        swgl_error(p, line, NULL, "control flow is nested too deeply");
+    p->maskDepth++;
+    return swgl_emit(p, op, 0, a, 0, 0, 0, 0);
+}
+
+static int swgl_const_reg(SwglGlslParser *p, float value)
+{
+    for (int i = 0; i < p->constCount; ++i)
+    {
+        if (memcmp(&p->consts[i].value, &value, sizeof(float)) == 0)
+            return p->consts[i].reg;
+    }
+    p->consts = (SwglGlslConstant *)swgl_grow(p, p->consts, &p->constCapacity, p->constCount, sizeof(SwglGlslConstant));
+    int reg = swgl_reg_persistent(p, 1);
+    p->consts[p->constCount].reg = reg;
+    p->consts[p->constCount].value = value;
+    p->constCount++;
+    return reg;
+}
+
+static SwglGlslOperand swgl_imm(float k)
+{
+    SwglGlslOperand o = {-1, k};
+    return o;
+}
+
+static SwglGlslOperand swgl_reg(int reg)
+{
+    SwglGlslOperand o = {reg, 0.0f};
+    return o;
+}
+
+static int swgl_use(SwglGlslParser *p, SwglGlslOperand o)
+{
+    return o.reg >= 0 ? o.reg : swgl_const_reg(p, o.k);
+}
+
+static int swgl_is_imm(SwglGlslOperand o, float k)
+{
+    return o.reg < 0 && o.k == k;
+}
+
+static SwglGlslOperand swgl_alu(SwglGlslParser *p, int op, SwglGlslOperand a, SwglGlslOperand b, SwglGlslOperand c)
+{
+    int args = swgl_glsl_alu_args[op];
+    if (a.reg < 0 && (args < 2 || b.reg < 0) && (args < 3 || c.reg < 0))
+        return swgl_imm(swgl_glsl_fold(op, a.k, b.k, c.k));
+    if ((op == SWGL_GLSL_OP_MUL && swgl_is_imm(b, 1.0f)) || ((op == SWGL_GLSL_OP_ADD || op == SWGL_GLSL_OP_SUB) && swgl_is_imm(b, 0.0f)))
+        return a;
+    if ((op == SWGL_GLSL_OP_MUL && swgl_is_imm(a, 1.0f)) || (op == SWGL_GLSL_OP_ADD && swgl_is_imm(a, 0.0f)))
+        return b;
+    int ra = swgl_use(p, a);
+    int rb = args > 1 ? swgl_use(p, b) : 0;
+    int rc = args > 2 ? swgl_use(p, c) : 0;
+    int dst = swgl_reg_alloc(p, 1);
+    swgl_emit(p, op, dst, ra, rb, rc, 0, 0);
+    return swgl_reg(dst);
+}
+
+static SwglGlslOperand swgl_alu1(SwglGlslParser *p, int op, SwglGlslOperand a)
+{
+    return swgl_alu(p, op, a, a, a);
+}
+
+static SwglGlslOperand swgl_alu2(SwglGlslParser *p, int op, SwglGlslOperand a, SwglGlslOperand b)
+{
+    return swgl_alu(p, op, a, b, b);
+}
+
+// Register fields of an instruction, for renumbering and dependence checks
+enum
+{
+    SWGL_F_DST = 1,
+    SWGL_F_A = 2,
+    SWGL_F_B = 4,
+    SWGL_F_C = 8
+};
+
+static int swgl_op_fields(int op)
+{
+    if (op < SWGL_GLSL_OP_ALU_COUNT)
+    {
+        int args = swgl_glsl_alu_args[op];
+        return SWGL_F_DST | SWGL_F_A | (args > 1 ? SWGL_F_B : 0) | (args > 2 ? SWGL_F_C : 0);
+    }
+    switch (op)
+    {
+    case SWGL_GLSL_OP_STORE:
+    case SWGL_GLSL_OP_GATHERU:
+        return SWGL_F_DST | SWGL_F_A;
+    case SWGL_GLSL_OP_LOADU:
+    case SWGL_GLSL_OP_LOADIN:
+    case SWGL_GLSL_OP_LOADB:
+        return SWGL_F_DST;
+    case SWGL_GLSL_OP_GATHERR:
+        return SWGL_F_DST | SWGL_F_A | SWGL_F_B;
+    case SWGL_GLSL_OP_SCATTERR:
+        return SWGL_F_A | SWGL_F_B | SWGL_F_C;
+    case SWGL_GLSL_OP_STOREOUT:
+    case SWGL_GLSL_OP_IF:
+    case SWGL_GLSL_OP_LOOP_TEST:
+        return SWGL_F_A;
+    }
+    return 0;
+}
+
+static int swgl_op_jumps(int op)
+{
+    return op == SWGL_GLSL_OP_IF || op == SWGL_GLSL_OP_ELSE || op == SWGL_GLSL_OP_LOOP_TEST ||
+           op == SWGL_GLSL_OP_LOOP_NEXT;
+}
+
+static int swgl_reads(const SwglGlslInstr *in, int reg)
+{
+    int fields = swgl_op_fields(in->op);
+    return ((fields & SWGL_F_A) && in->a == reg) || ((fields & SWGL_F_B) && in->b == reg) ||
+           ((fields & SWGL_F_C) && in->c == reg);
+}
+
+// ---------------------------------------------------------------------------
+// Values
+
+static void swgl_value_init(SwglGlslValue *v, SwglGlslType type)
+{
+    memset(v, 0, sizeof(*v));
+    v->type = type;
+}
+
+static int swgl_value_constant(const SwglGlslValue *v)
+{
+    if (v->type.array)
+        return 0;
+    for (int k = 0; k < swgl_components(&v->type); ++k)
+    {
+        if (v->c[k].reg >= 0)
+            return 0;
+    }
+    return 1;
+}
+
+static int swgl_uniform_reg(SwglGlslParser *p, int decl, int index)
+{
+    SwglGlslDecl *d = &p->decls[SWGL_GLSL_UNIFORM][decl];
+    if (d->uniformRegs[index] < 0)
+    {
+        d->uniformRegs[index] = swgl_reg_persistent(p, 1);
+        swgl_emit_to(p, 1, SWGL_GLSL_OP_LOADU, d->uniformRegs[index], 0, 0, 0, index, decl);
+    }
+    return d->uniformRegs[index];
+}
+
+static int swgl_input_regs(SwglGlslParser *p, int decl)
+{
+    int kind = p->stage == SWGL_GLSL_VERTEX ? SWGL_GLSL_ATTRIBUTE : SWGL_GLSL_VARYING;
+    SwglGlslDecl *d = &p->decls[kind][decl];
+    if (d->cache < 0)
+    {
+        int n = swgl_components(&d->type) * (d->type.array ? d->type.array : 1);
+        int base = swgl_reg_persistent(p, n);
+        p->decls[kind][decl].cache = base;
+        for (int k = 0; k < n; ++k)
+            swgl_emit_to(p, 1, SWGL_GLSL_OP_LOADIN, base + k, 0, 0, 0, decl, k);
+    }
+    return p->decls[kind][decl].cache;
+}
+
+static int swgl_builtin_regs(SwglGlslParser *p, int row, int count)
+{
+    if (p->builtinCache[row] < 0)
+    {
+        int base = swgl_reg_persistent(p, count);
+        for (int k = 0; k < count; ++k)
+        {
+            p->builtinCache[row + k] = base + k;
+            swgl_emit_to(p, 1, SWGL_GLSL_OP_LOADB, base + k, 0, 0, 0, row + k, 0);
+        }
+    }
+    return p->builtinCache[row];
+}
+
+static void swgl_load_symbol(SwglGlslParser *p, int index, SwglGlslValue *v)
+{
+    SwglGlslSymbol s = p->symbols[index];
+    swgl_value_init(v, s.type);
+    int n = swgl_components(&s.type);
+    int base = s.base;
+    switch (s.storage)
+    {
+    case SWGL_ST_CONST:
+        for (int k = 0; k < n; ++k)
+            v->c[k] = swgl_imm(s.value[k]);
+        return;
+    case SWGL_ST_UNIFORM:
+        if (s.type.array)
+        {
+            v->arrayStorage = SWGL_ST_UNIFORM;
+            v->arrayBase = base;
+            return;
+        }
+        for (int k = 0; k < n; ++k)
+            v->c[k] = swgl_reg(swgl_uniform_reg(p, base, k));
+        return;
+    case SWGL_ST_INPUT:
+        base = swgl_input_regs(p, base);
+        break;
+    case SWGL_ST_BUILTIN:
+        base = swgl_builtin_regs(p, base, n);
+        break;
+    }
+    v->lvalue = s.readOnly ? SWGL_LV_NONE : SWGL_LV_REGS;
+    if (s.type.array)
+    {
+        v->arrayStorage = SWGL_ST_REG;
+        v->arrayBase = base;
+        return;
+    }
+    for (int k = 0; k < n; ++k)
+        v->c[k] = swgl_reg(base + k);
+}
+
+static int swgl_find_symbol(const SwglGlslParser *p, const char *name)
+{
+    for (int i = p->symbolCount - 1; i >= 0; --i)
+    {
+        // An inlined body sees the globals and its own locals, not the caller's
+        if (i < p->frameStart && i >= p->globalCount)
+            continue;
+        if (strcmp(p->symbols[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static SwglGlslSymbol *swgl_declare(SwglGlslParser *p, const char *name, SwglGlslType type, int storage, int base, int line)
+{
+    for (int i = p->scopeStart; i < p->symbolCount; ++i)
+    {
+        if (strcmp(p->symbols[i].name, name) == 0)
+            swgl_error(p, line, name, "redefinition");
+    }
+    p->symbols = (SwglGlslSymbol *)swgl_grow(p, p->symbols, &p->symbolCapacity, p->symbolCount, sizeof(SwglGlslSymbol));
+    SwglGlslSymbol *s = &p->symbols[p->symbolCount++];
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->type = type;
+    s->storage = storage;
+    s->base = base;
+    return s;
+}
+
+static SwglGlslScope swgl_scope_push(SwglGlslParser *p)
+{
+    SwglGlslScope scope = {p->scopeStart, p->regTop};
+    p->scopeStart = p->symbolCount;
+    return scope;
+}
+
+static void swgl_scope_pop(SwglGlslParser *p, SwglGlslScope scope)
+{
+    p->symbolCount = p->scopeStart;
+    p->scopeStart = scope.scopeStart;
+    p->regTop = scope.regTop;
+}
+
+static int swgl_contiguous(const SwglGlslValue *v, int n)
+{
+    if (v->lvalue != SWGL_LV_REGS)
+        return 0;
+    for (int k = 0; k < n; ++k)
+    {
+        if (v->c[k].reg != v->c[0].reg + k)
+            return 0;
+    }
+    return 1;
+}
+
+static void swgl_require_int_index(SwglGlslParser *p, const SwglGlslValue *index, int line)
+{
+    if (index->type.base != SWGL_T_INT || !swgl_is_scalar(&index->type))
+        swgl_error(p, line, "[", "integer expression required");
+}
+
+// v[index] for arrays, matrices and vectors
+static void swgl_index(SwglGlslParser *p, SwglGlslValue *v, const SwglGlslValue *index, int line)
+{
+    swgl_require_int_index(p, index, line);
+    int isConst = index->c[0].reg < 0;
+    int i = isConst ? (int)index->c[0].k : 0;
+    SwglGlslValue out;
+    if (v->type.array)
+    {
+        SwglGlslType element = v->type;
+        element.array = 0;
+        int stride = swgl_components(&element);
+        int count = v->type.array;
+        swgl_value_init(&out, element);
+        if (isConst && (i < 0 || i >= count))
+            swgl_error(p, line, "[", "array index out of range");
+        for (int k = 0; k < stride; ++k)
+        {
+            if (v->arrayStorage == SWGL_ST_UNIFORM && isConst)
+                out.c[k] = swgl_reg(swgl_uniform_reg(p, v->arrayBase, i * stride + k));
+            else if (isConst)
+                out.c[k] = swgl_reg(v->arrayBase + i * stride + k);
+            else
+            {
+                int dst = swgl_reg_alloc(p, 1);
+                int idx = swgl_use(p, index->c[0]);
+                if (v->arrayStorage == SWGL_ST_UNIFORM)
+                    swgl_emit(p, SWGL_GLSL_OP_GATHERU, dst, idx, count, stride, k, v->arrayBase);
+                else
+                    swgl_emit(p, SWGL_GLSL_OP_GATHERR, dst, idx, v->arrayBase + k, 0, stride, count);
+                out.c[k] = swgl_reg(dst);
+            }
+        }
+        if (v->arrayStorage == SWGL_ST_REG && v->lvalue)
+        {
+            out.lvalue = isConst ? SWGL_LV_REGS : SWGL_LV_DYNAMIC;
+            out.dynBase = v->arrayBase;
+            out.dynStride = stride;
+            out.dynCount = count;
+            out.dynIndex = isConst ? 0 : swgl_use(p, index->c[0]);
+            for (int k = 0; k < stride; ++k)
+                out.dynComp[k] = (unsigned char)k;
+        }
+        *v = out;
+        return;
+    }
+    if (!v->type.matrix && v->type.size < 2)
+        swgl_error(p, line, "[", "left of '[' is not of type array, matrix, or vector");
+    int count = v->type.size;
+    int stride = v->type.matrix ? count : 1;
+    swgl_value_init(&out, v->type.matrix ? swgl_type(v->type.base, count, 0) : swgl_type(v->type.base, 1, 0));
+    if (isConst)
+    {
+        if (i < 0 || i >= count)
+            swgl_error(p, line, "[", "index out of range");
+        for (int k = 0; k < stride; ++k)
+        {
+            out.c[k] = v->c[i * stride + k];
+            out.dynComp[k] = v->dynComp[i * stride + k];
+        }
+        out.lvalue = v->lvalue;
+        out.dynBase = v->dynBase;
+        out.dynStride = v->dynStride;
+        out.dynCount = v->dynCount;
+        out.dynIndex = v->dynIndex;
+    }
+    else if (swgl_contiguous(v, count * stride))
+    {
+        int idx = swgl_use(p, index->c[0]);
+        for (int k = 0; k < stride; ++k)
+        {
+            int dst = swgl_reg_alloc(p, 1);
+            swgl_emit(p, SWGL_GLSL_OP_GATHERR, dst, idx, v->c[k].reg, 0, stride, count);
+            out.c[k] = swgl_reg(dst);
+            out.dynComp[k] = (unsigned char)k;
+        }
+        out.lvalue = SWGL_LV_DYNAMIC;
+        out.dynBase = v->c[0].reg;
+        out.dynStride = stride;
+        out.dynCount = count;
+        out.dynIndex = idx;
+    }
+    else
+    {
+        // Select chain over the candidates
+        for (int k = 0; k < stride; ++k)
+        {
+            SwglGlslOperand r = v->c[k];
+            for (int j = 1; j < count; ++j)
+            {
+                SwglGlslOperand eq = swgl_alu2(p, SWGL_GLSL_OP_EQ, index->c[0], swgl_imm((float)j));
+                r = swgl_alu(p, SWGL_GLSL_OP_SEL, eq, v->c[j * stride + k], r);
+            }
+            out.c[k] = r;
+        }
+    }
+    *v = out;
+}
+
+static void swgl_swizzle(SwglGlslParser *p, SwglGlslValue *v, const SwglGlslToken *field)
+{
+    static const char *const sets[] = {"xyzw", "rgba", "stpq"};
+    const char *name = field->text;
+    size_t length = strlen(name);
+    if (v->type.array || v->type.matrix || v->type.size < 2 || swgl_is_sampler(&v->type) || v->type.base == SWGL_T_VOID)
+        swgl_error(p, field->line, name, "field selection requires a vector");
+    if (length > 4)
+        swgl_error(p, field->line, name, "illegal vector field selection");
+    int set = -1;
+    for (int s = 0; s < 3 && set < 0; ++s)
+    {
+        if (strchr(sets[s], name[0]))
+            set = s;
+    }
+    SwglGlslValue out;
+    swgl_value_init(&out, swgl_type(v->type.base, (int)length, 0));
+    out.lvalue = v->lvalue;
+    out.dynBase = v->dynBase;
+    out.dynStride = v->dynStride;
+    out.dynCount = v->dynCount;
+    out.dynIndex = v->dynIndex;
+    unsigned used = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        const char *at = set >= 0 ? strchr(sets[set], name[i]) : NULL;
+        if (!at || !name[i] || at - sets[set] >= v->type.size)
+            swgl_error(p, field->line, name, "illegal vector field selection");
+        int k = (int)(at - sets[set]);
+        if (used & (1u << k))
+            out.lvalue = SWGL_LV_NONE; // duplicated components cannot be assigned
+        used |= 1u << k;
+        out.c[i] = v->c[k];
+        out.dynComp[i] = v->dynComp[k];
+    }
+    *v = out;
+}
+
+static SwglGlslOperand swgl_convert(SwglGlslParser *p, SwglGlslOperand o, int from, int to)
+{
+    if (from == to || to == SWGL_T_FLOAT || (to == SWGL_T_INT && from == SWGL_T_BOOL))
+        return o; // ints and bools are already whole floats
+    if (to == SWGL_T_INT)
+        return swgl_alu1(p, SWGL_GLSL_OP_TRUNC, o);
+    return swgl_alu2(p, SWGL_GLSL_OP_NE, o, swgl_imm(0.0f));
+}
+
+static int swgl_is_temp(const SwglGlslParser *p, int reg)
+{
+    return reg >= p->tempFloor && reg < SWGL_GLSL_PERSISTENT;
+}
+
+// When the temporary holding a result is only moved into a variable, the
+// instruction that produced it can write the variable directly.
+static int swgl_retarget(SwglGlslParser *p, int temp, int reg)
+{
+    int def = -1;
+    for (int i = p->codeCount - 1; i >= p->stmtStart && def < 0; --i)
+    {
+        if ((swgl_op_fields(p->code[i].op) & SWGL_F_DST) && p->code[i].dst == temp)
+            def = i;
+    }
+    if (def < 0 || p->code[def].op >= SWGL_GLSL_OP_ALU_COUNT)
+        return 0;
+    for (int i = def + 1; i < p->codeCount; ++i)
+    {
+        const SwglGlslInstr *in = &p->code[i];
+        if (in->op > SWGL_GLSL_OP_STORE || swgl_reads(in, temp) || swgl_reads(in, reg) || in->dst == reg)
+            return 0;
+    }
+    p->code[def].dst = (uint16_t)reg;
+    return 1;
+}
+
+// Writes src into the lvalue dst in the active lanes.
+static void swgl_store(SwglGlslParser *p, const SwglGlslValue *dst, const SwglGlslValue *src)
+{
+    int n = swgl_components(&dst->type);
+    SwglGlslOperand s[16];
+    memcpy(s, src->c, sizeof(s));
+    if (dst->lvalue == SWGL_LV_DYNAMIC)
+    {
+        for (int k = 0; k < n; ++k)
+            swgl_emit(p, SWGL_GLSL_OP_SCATTERR, 0, swgl_use(p, s[k]), dst->dynBase + dst->dynComp[k], dst->dynIndex,
+                      dst->dynStride, dst->dynCount);
+        return;
+    }
+    // Sources overwritten by an earlier component (v = v.yx) are copied first
+    int alias = 0;
+    for (int k = 0; k < n; ++k)
+    {
+        for (int j = 0; j < k; ++j)
+            alias |= s[k].reg >= 0 && s[k].reg == dst->c[j].reg;
+    }
+    if (alias)
+    {
+        for (int k = 0; k < n; ++k)
+        {
+            if (s[k].reg >= 0)
+                s[k] = swgl_alu1(p, SWGL_GLSL_OP_MOV, s[k]);
+        }
+    }
+    int unconditional = p->maskDepth == 0 && !p->mainReturned;
+    for (int k = 0; k < n; ++k)
+    {
+        int reg = dst->c[k].reg;
+        if (reg == p->pointSizeReg && !p->dryRun)
+            p->pointSizeWritten = 1;
+        if (s[k].reg == reg)
+            continue;
+        int uses = 0;
+        for (int j = 0; j < n; ++j)
+            uses += s[j].reg == s[k].reg;
+        if (unconditional && uses == 1 && swgl_is_temp(p, s[k].reg) && swgl_retarget(p, s[k].reg, reg))
+            continue;
+        swgl_emit(p, SWGL_GLSL_OP_STORE, reg, swgl_use(p, s[k]), 0, 0, 0, 0);
+    }
+}
+
+static void swgl_require_lvalue(SwglGlslParser *p, const SwglGlslValue *v, const SwglGlslToken *tok)
+{
+    if (v->lvalue == SWGL_LV_NONE || v->type.array)
+        swgl_error(p, tok->line, tok->text, "l-value required");
+}
+
+static int swgl_is_arithmetic(const SwglGlslType *type)
+{
+    return (type->base == SWGL_T_FLOAT || type->base == SWGL_T_INT) && !type->array;
+}
+
+_Noreturn static void swgl_operand_error(SwglGlslParser *p, const SwglGlslToken *op, const SwglGlslValue *l,
+                                         const SwglGlslValue *r)
+{
+    swgl_error(p, op->line, op->text,
+               "wrong operand types - no operation '%s' exists that takes a left-hand operand of type '%s%s' "
+               "and a right operand of type '%s%s'",
+               op->text, swgl_type_name(&l->type), l->type.array ? "[]" : "", swgl_type_name(&r->type),
+               r->type.array ? "[]" : "");
+}
+
+// Sum of a[k * sa] * b[k * sb] for k < n
+static SwglGlslOperand swgl_dot(SwglGlslParser *p, const SwglGlslOperand *a, int sa, const SwglGlslOperand *b, int sb, int n)
+{
+    SwglGlslOperand acc = swgl_alu2(p, SWGL_GLSL_OP_MUL, a[0], b[0]);
+    for (int k = 1; k < n; ++k)
+        acc = swgl_alu(p, SWGL_GLSL_OP_MAD, a[k * sa], b[k * sb], acc);
+    return acc;
+}
+
+// + - * / with scalar broadcast and the linear-algebra products
+static void swgl_arith(SwglGlslParser *p, const SwglGlslToken *op, int punct, const SwglGlslValue *l,
+                       const SwglGlslValue *r, SwglGlslValue *out)
+{
+    if (!swgl_is_arithmetic(&l->type) || !swgl_is_arithmetic(&r->type) || l->type.base != r->type.base)
+        swgl_operand_error(p, op, l, r);
+    int alu = punct == '+' ? SWGL_GLSL_OP_ADD : punct == '-' ? SWGL_GLSL_OP_SUB : punct == '*' ? SWGL_GLSL_OP_MUL : SWGL_GLSL_OP_DIV;
+    int ls = swgl_is_scalar(&l->type), rs = swgl_is_scalar(&r->type);
+    if (punct == '*' && (l->type.matrix || r->type.matrix) && !ls && !rs)
+    {
+        int n = l->type.matrix ? l->type.size : r->type.size;
+        if (l->type.size != n || r->type.size != n)
+            swgl_operand_error(p, op, l, r);
+        if (l->type.matrix && r->type.matrix)
+        {
+            swgl_value_init(out, l->type);
+            for (int j = 0; j < n; ++j)
+            {
+                for (int i = 0; i < n; ++i)
+                    out->c[j * n + i] = swgl_dot(p, &l->c[i], n, &r->c[j * n], 1, n);
+            }
+        }
+        else if (l->type.matrix)
+        {
+            swgl_value_init(out, r->type);
+            for (int i = 0; i < n; ++i)
+                out->c[i] = swgl_dot(p, &l->c[i], n, r->c, 1, n);
+        }
+        else
+        {
+            swgl_value_init(out, l->type);
+            for (int j = 0; j < n; ++j)
+                out->c[j] = swgl_dot(p, l->c, 1, &r->c[j * n], 1, n);
+        }
+        return;
+    }
+    if (!ls && !rs && !swgl_type_equal(&l->type, &r->type))
+        swgl_operand_error(p, op, l, r);
+    swgl_value_init(out, ls ? r->type : l->type);
+    int n = swgl_components(&out->type);
+    for (int k = 0; k < n; ++k)
+    {
+        out->c[k] = swgl_alu2(p, alu, l->c[ls ? 0 : k], r->c[rs ? 0 : k]);
+        if (alu == SWGL_GLSL_OP_DIV && out->type.base == SWGL_T_INT)
+            out->c[k] = swgl_alu1(p, SWGL_GLSL_OP_TRUNC, out->c[k]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Constructors and built-in functions
+
+static void swgl_parse_assignment(SwglGlslParser *p, SwglGlslValue *v);
+static void swgl_parse_expression(SwglGlslParser *p, SwglGlslValue *v);
+static void swgl_parse_compound(SwglGlslParser *p);
+
+static void swgl_construct(SwglGlslParser *p, const SwglGlslToken *tok, SwglGlslType type, const SwglGlslValue *args,
+                           int n, SwglGlslValue *out)
+{
+    if (n == 0)
+        swgl_error(p, tok->line, tok->text, "constructor does not have any arguments");
+    for (int i = 0; i < n; ++i)
+    {
+        if (args[i].type.array || swgl_is_sampler(&args[i].type) || args[i].type.base == SWGL_T_VOID)
+            swgl_error(p, tok->line, tok->text, "cannot construct this type from an array, sampler or void");
+    }
+    swgl_value_init(out, type);
+    int total = swgl_components(&type);
+    if (type.matrix && n == 1 && args[0].type.matrix)
+    {
+        // Resize: copy the overlap, identity elsewhere
+        int m = args[0].type.size, size = type.size;
+        for (int col = 0; col < size; ++col)
+        {
+            for (int row = 0; row < size; ++row)
+                out->c[col * size + row] = col < m && row < m ? args[0].c[col * m + row] : swgl_imm(col == row ? 1.0f : 0.0f);
+        }
+        return;
+    }
+    if (n == 1 && swgl_is_scalar(&args[0].type) && total > 1)
+    {
+        SwglGlslOperand value = swgl_convert(p, args[0].c[0], args[0].type.base, type.base);
+        for (int k = 0; k < total; ++k)
+        {
+            if (type.matrix)
+                out->c[k] = k % (type.size + 1) == 0 ? value : swgl_imm(0.0f);
+            else
+                out->c[k] = value;
+        }
+        return;
+    }
+    int k = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (k >= total)
+            swgl_error(p, tok->line, tok->text, "too many arguments");
+        int count = swgl_components(&args[i].type);
+        for (int j = 0; j < count && k < total; ++j)
+            out->c[k++] = swgl_convert(p, args[i].c[j], args[i].type.base, type.base);
+    }
+    if (k < total)
+        swgl_error(p, tok->line, tok->text, "not enough data provided for construction");
+}
+
+enum
+{
+    SWGL_B_UNARY,
+    SWGL_B_ANGLE,
+    SWGL_B_ATAN,
+    SWGL_B_BINARY,
+    SWGL_B_BINARY_SCALAR, // second argument may be a float
+    SWGL_B_STEP,
+    SWGL_B_CLAMP,
+    SWGL_B_MIX,
+    SWGL_B_SMOOTHSTEP,
+    SWGL_B_LENGTH,
+    SWGL_B_DISTANCE,
+    SWGL_B_DOT,
+    SWGL_B_CROSS,
+    SWGL_B_NORMALIZE,
+    SWGL_B_FACEFORWARD,
+    SWGL_B_REFLECT,
+    SWGL_B_REFRACT,
+    SWGL_B_MATRIX_COMP_MULT,
+    SWGL_B_COMPARE,
+    SWGL_B_ANY,
+    SWGL_B_ALL,
+    SWGL_B_NOT,
+    SWGL_B_TEXTURE
+};
+
+static const struct
+{
+    const char *name;
+    int kind;
+    int op;  // ALU op, or the sampler type for textures
+    int arg; // ANGLE: to degrees; COMPARE: swap operands; TEXTURE: coordinate size (0: 3 or 4)
+    int lod; // TEXTURE: explicit level of detail
+} swgl_builtins[] = {
+    {"radians", SWGL_B_ANGLE, 0, 0, 0},
+    {"degrees", SWGL_B_ANGLE, 0, 1, 0},
+    {"sin", SWGL_B_UNARY, SWGL_GLSL_OP_SIN, 0, 0},
+    {"cos", SWGL_B_UNARY, SWGL_GLSL_OP_COS, 0, 0},
+    {"tan", SWGL_B_UNARY, SWGL_GLSL_OP_TAN, 0, 0},
+    {"asin", SWGL_B_UNARY, SWGL_GLSL_OP_ASIN, 0, 0},
+    {"acos", SWGL_B_UNARY, SWGL_GLSL_OP_ACOS, 0, 0},
+    {"atan", SWGL_B_ATAN, 0, 0, 0},
+    {"pow", SWGL_B_BINARY, SWGL_GLSL_OP_POW, 0, 0},
+    {"exp", SWGL_B_UNARY, SWGL_GLSL_OP_EXP, 0, 0},
+    {"log", SWGL_B_UNARY, SWGL_GLSL_OP_LOG, 0, 0},
+    {"exp2", SWGL_B_UNARY, SWGL_GLSL_OP_EXP2, 0, 0},
+    {"log2", SWGL_B_UNARY, SWGL_GLSL_OP_LOG2, 0, 0},
+    {"sqrt", SWGL_B_UNARY, SWGL_GLSL_OP_SQRT, 0, 0},
+    {"inversesqrt", SWGL_B_UNARY, SWGL_GLSL_OP_RSQ, 0, 0},
+    {"abs", SWGL_B_UNARY, SWGL_GLSL_OP_ABS, 0, 0},
+    {"sign", SWGL_B_UNARY, SWGL_GLSL_OP_SIGN, 0, 0},
+    {"floor", SWGL_B_UNARY, SWGL_GLSL_OP_FLOOR, 0, 0},
+    {"ceil", SWGL_B_UNARY, SWGL_GLSL_OP_CEIL, 0, 0},
+    {"fract", SWGL_B_UNARY, SWGL_GLSL_OP_FRACT, 0, 0},
+    {"mod", SWGL_B_BINARY_SCALAR, SWGL_GLSL_OP_MOD, 0, 0},
+    {"min", SWGL_B_BINARY_SCALAR, SWGL_GLSL_OP_MIN, 0, 0},
+    {"max", SWGL_B_BINARY_SCALAR, SWGL_GLSL_OP_MAX, 0, 0},
+    {"clamp", SWGL_B_CLAMP, SWGL_GLSL_OP_CLAMP, 0, 0},
+    {"mix", SWGL_B_MIX, SWGL_GLSL_OP_MIX, 0, 0},
+    {"step", SWGL_B_STEP, SWGL_GLSL_OP_STEP, 0, 0},
+    {"smoothstep", SWGL_B_SMOOTHSTEP, 0, 0, 0},
+    {"length", SWGL_B_LENGTH, 0, 0, 0},
+    {"distance", SWGL_B_DISTANCE, 0, 0, 0},
+    {"dot", SWGL_B_DOT, 0, 0, 0},
+    {"cross", SWGL_B_CROSS, 0, 0, 0},
+    {"normalize", SWGL_B_NORMALIZE, 0, 0, 0},
+    {"faceforward", SWGL_B_FACEFORWARD, 0, 0, 0},
+    {"reflect", SWGL_B_REFLECT, 0, 0, 0},
+    {"refract", SWGL_B_REFRACT, 0, 0, 0},
+    {"matrixCompMult", SWGL_B_MATRIX_COMP_MULT, 0, 0, 0},
+    {"lessThan", SWGL_B_COMPARE, SWGL_GLSL_OP_LT, 0, 0},
+    {"lessThanEqual", SWGL_B_COMPARE, SWGL_GLSL_OP_LE, 0, 0},
+    {"greaterThan", SWGL_B_COMPARE, SWGL_GLSL_OP_LT, 1, 0},
+    {"greaterThanEqual", SWGL_B_COMPARE, SWGL_GLSL_OP_LE, 1, 0},
+    {"equal", SWGL_B_COMPARE, SWGL_GLSL_OP_EQ, 0, 0},
+    {"notEqual", SWGL_B_COMPARE, SWGL_GLSL_OP_NE, 0, 0},
+    {"any", SWGL_B_ANY, 0, 0, 0},
+    {"all", SWGL_B_ALL, 0, 0, 0},
+    {"not", SWGL_B_NOT, 0, 0, 0},
+    {"texture2D", SWGL_B_TEXTURE, SWGL_T_SAMPLER2D, 2, 0},
+    {"texture2DProj", SWGL_B_TEXTURE, SWGL_T_SAMPLER2D, 0, 0},
+    {"texture2DLod", SWGL_B_TEXTURE, SWGL_T_SAMPLER2D, 2, 1},
+    {"texture2DProjLod", SWGL_B_TEXTURE, SWGL_T_SAMPLER2D, 0, 1},
+    {"textureCube", SWGL_B_TEXTURE, SWGL_T_SAMPLERCUBE, 3, 0},
+    {"textureCubeLod", SWGL_B_TEXTURE, SWGL_T_SAMPLERCUBE, 3, 1},
+};
+
+static int swgl_find_builtin(const char *name)
+{
+    for (size_t i = 0; i < sizeof(swgl_builtins) / sizeof(swgl_builtins[0]); ++i)
+    {
+        if (strcmp(swgl_builtins[i].name, name) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+static int swgl_is_gentype(const SwglGlslType *type)
+{
+    return type->base == SWGL_T_FLOAT && !type->matrix && !type->array;
+}
+
+static int swgl_is_float(const SwglGlslType *type)
+{
+    return type->base == SWGL_T_FLOAT && swgl_is_scalar(type);
+}
+
+// Applies op per component; scalar arguments are broadcast.
+static void swgl_componentwise(SwglGlslParser *p, int op, const SwglGlslValue *args, int n, SwglGlslType type,
+                               SwglGlslValue *out)
+{
+    swgl_value_init(out, type);
+    for (int k = 0; k < swgl_components(&type); ++k)
+    {
+        SwglGlslOperand a[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            const SwglGlslValue *arg = &args[j < n ? j : n - 1];
+            a[j] = arg->c[swgl_is_scalar(&arg->type) ? 0 : k];
+        }
+        out->c[k] = swgl_alu(p, op, a[0], a[1], a[2]);
+    }
+}
+
+static void swgl_call_builtin(SwglGlslParser *p, const SwglGlslToken *tok, int b, const SwglGlslValue *args, int n,
+                              SwglGlslValue *out)
+{
+    const SwglGlslType *t0 = &args[0].type;
+    int kind = swgl_builtins[b].kind, op = swgl_builtins[b].op;
+    int ok = n > 0;
+    for (int i = 0; i < n; ++i)
+        ok &= !args[i].type.array;
+    // Argument i matches the first argument, or is a float where that is allowed
+#define SWGL_SAME(i) (swgl_type_equal(&args[i].type, t0))
+#define SWGL_SAME_OR_FLOAT(i, ref) (swgl_type_equal(&args[i].type, &args[ref].type) || swgl_is_float(&args[i].type))
+    switch (kind)
+    {
+    case SWGL_B_UNARY:
+    case SWGL_B_ANGLE:
+    case SWGL_B_LENGTH:
+    case SWGL_B_NORMALIZE:
+        ok &= n == 1 && swgl_is_gentype(t0);
+        break;
+    case SWGL_B_ATAN:
+        ok &= (n == 1 || n == 2) && swgl_is_gentype(t0) && (n == 1 || SWGL_SAME(1));
+        break;
+    case SWGL_B_BINARY:
+    case SWGL_B_DISTANCE:
+    case SWGL_B_DOT:
+    case SWGL_B_REFLECT:
+        ok &= n == 2 && swgl_is_gentype(t0) && SWGL_SAME(1);
+        break;
+    case SWGL_B_BINARY_SCALAR:
+        ok &= n == 2 && swgl_is_gentype(t0) && SWGL_SAME_OR_FLOAT(1, 0);
+        break;
+    case SWGL_B_STEP:
+        ok &= n == 2 && swgl_is_gentype(&args[1].type) && SWGL_SAME_OR_FLOAT(0, 1);
+        break;
+    case SWGL_B_CLAMP:
+        ok &= n == 3 && swgl_is_gentype(t0) &&
+              ((SWGL_SAME(1) && SWGL_SAME(2)) || (swgl_is_float(&args[1].type) && swgl_is_float(&args[2].type)));
+        break;
+    case SWGL_B_MIX:
+        ok &= n == 3 && swgl_is_gentype(t0) && SWGL_SAME(1) && SWGL_SAME_OR_FLOAT(2, 0);
+        break;
+    case SWGL_B_SMOOTHSTEP:
+        ok &= n == 3 && swgl_is_gentype(&args[2].type) &&
+              ((swgl_type_equal(t0, &args[2].type) && SWGL_SAME(1)) ||
+               (swgl_is_float(t0) && swgl_is_float(&args[1].type)));
+        break;
+    case SWGL_B_CROSS:
+        ok &= n == 2 && swgl_is_gentype(t0) && t0->size == 3 && SWGL_SAME(1);
+        break;
+    case SWGL_B_FACEFORWARD:
+        ok &= n == 3 && swgl_is_gentype(t0) && SWGL_SAME(1) && SWGL_SAME(2);
+        break;
+    case SWGL_B_REFRACT:
+        ok &= n == 3 && swgl_is_gentype(t0) && SWGL_SAME(1) && swgl_is_float(&args[2].type);
+        break;
+    case SWGL_B_MATRIX_COMP_MULT:
+        ok &= n == 2 && t0->matrix && SWGL_SAME(1);
+        break;
+    case SWGL_B_COMPARE:
+        ok &= n == 2 && SWGL_SAME(1) && !t0->matrix && t0->size >= 2 &&
+              (t0->base == SWGL_T_FLOAT || t0->base == SWGL_T_INT ||
+               (t0->base == SWGL_T_BOOL && (op == SWGL_GLSL_OP_EQ || op == SWGL_GLSL_OP_NE)));
+        break;
+    case SWGL_B_ANY:
+    case SWGL_B_ALL:
+    case SWGL_B_NOT:
+        ok &= n == 1 && t0->base == SWGL_T_BOOL && t0->size >= 2;
+        break;
+    case SWGL_B_TEXTURE:
+    {
+        int size = swgl_builtins[b].arg, lod = swgl_builtins[b].lod;
+        ok &= n >= 2 && t0->base == op && swgl_is_gentype(&args[1].type) &&
+              (size ? args[1].type.size == size : args[1].type.size >= 3) &&
+              (lod ? n == 3 : n <= 3) && (n < 3 || swgl_is_float(&args[2].type));
+        if (ok && (lod ? p->stage != SWGL_GLSL_VERTEX : (n == 3 && p->stage != SWGL_GLSL_FRAGMENT)))
+            swgl_error(p, tok->line, tok->text, "function is not available in this shader stage");
+        break;
+    }
+    }
+#undef SWGL_SAME
+#undef SWGL_SAME_OR_FLOAT
+    if (!ok)
+        swgl_error(p, tok->line, tok->text, "no matching overloaded function found");
+
+    SwglGlslType scalar = swgl_type(SWGL_T_FLOAT, 1, 0);
+    int size = t0->size;
+    switch (kind)
+    {
+    case SWGL_B_UNARY:
+    case SWGL_B_BINARY:
+    case SWGL_B_BINARY_SCALAR:
+    case SWGL_B_CLAMP:
+    case SWGL_B_MIX:
+    case SWGL_B_MATRIX_COMP_MULT:
+        swgl_componentwise(p, kind == SWGL_B_MATRIX_COMP_MULT ? SWGL_GLSL_OP_MUL : op, args, n, *t0, out);
+        break;
+    case SWGL_B_STEP:
+        swgl_componentwise(p, op, args, n, args[1].type, out);
+        break;
+    case SWGL_B_ANGLE:
+    {
+        SwglGlslValue factor;
+        swgl_value_init(&factor, scalar);
+        factor.c[0] = swgl_imm(swgl_builtins[b].arg ? 57.295779513f : 0.017453292520f);
+        SwglGlslValue both[2] = {args[0], factor};
+        swgl_componentwise(p, SWGL_GLSL_OP_MUL, both, 2, *t0, out);
+        break;
+    }
+    case SWGL_B_ATAN:
+        swgl_componentwise(p, n == 2 ? SWGL_GLSL_OP_ATAN2 : SWGL_GLSL_OP_ATAN, args, n, *t0, out);
+        break;
+    case SWGL_B_SMOOTHSTEP:
+        swgl_value_init(out, args[2].type);
+        for (int k = 0; k < size; ++k)
+        {
+            int e = swgl_is_scalar(t0) ? 0 : k;
+            SwglGlslOperand range = swgl_alu2(p, SWGL_GLSL_OP_SUB, args[1].c[e], args[0].c[e]);
+            SwglGlslOperand t = swgl_alu2(p, SWGL_GLSL_OP_DIV, swgl_alu2(p, SWGL_GLSL_OP_SUB, args[2].c[k], args[0].c[e]), range);
+            t = swgl_alu(p, SWGL_GLSL_OP_CLAMP, t, swgl_imm(0.0f), swgl_imm(1.0f));
+            SwglGlslOperand poly = swgl_alu(p, SWGL_GLSL_OP_MAD, t, swgl_imm(-2.0f), swgl_imm(3.0f));
+            out->c[k] = swgl_alu2(p, SWGL_GLSL_OP_MUL, swgl_alu2(p, SWGL_GLSL_OP_MUL, t, t), poly);
+        }
+        break;
+    case SWGL_B_LENGTH:
+        swgl_value_init(out, scalar);
+        out->c[0] = swgl_alu1(p, SWGL_GLSL_OP_SQRT, swgl_dot(p, args[0].c, 1, args[0].c, 1, size));
+        break;
+    case SWGL_B_DISTANCE:
+    {
+        SwglGlslOperand d[4];
+        for (int k = 0; k < size; ++k)
+            d[k] = swgl_alu2(p, SWGL_GLSL_OP_SUB, args[0].c[k], args[1].c[k]);
+        swgl_value_init(out, scalar);
+        out->c[0] = swgl_alu1(p, SWGL_GLSL_OP_SQRT, swgl_dot(p, d, 1, d, 1, size));
+        break;
+    }
+    case SWGL_B_DOT:
+        swgl_value_init(out, scalar);
+        out->c[0] = swgl_dot(p, args[0].c, 1, args[1].c, 1, size);
+        break;
+    case SWGL_B_CROSS:
+        swgl_value_init(out, *t0);
+        for (int k = 0; k < 3; ++k)
+        {
+            int i = (k + 1) % 3, j = (k + 2) % 3;
+            SwglGlslOperand right = swgl_alu2(p, SWGL_GLSL_OP_MUL, args[0].c[j], args[1].c[i]);
+            out->c[k] = swgl_alu2(p, SWGL_GLSL_OP_SUB, swgl_alu2(p, SWGL_GLSL_OP_MUL, args[0].c[i], args[1].c[j]), right);
+        }
+        break;
+    case SWGL_B_NORMALIZE:
+    {
+        SwglGlslOperand scale = swgl_alu1(p, SWGL_GLSL_OP_RSQ, swgl_dot(p, args[0].c, 1, args[0].c, 1, size));
+        swgl_value_init(out, *t0);
+        for (int k = 0; k < size; ++k)
+            out->c[k] = swgl_alu2(p, SWGL_GLSL_OP_MUL, args[0].c[k], scale);
+        break;
+    }
+    case SWGL_B_FACEFORWARD:
+    {
+        SwglGlslOperand front = swgl_alu2(p, SWGL_GLSL_OP_LT, swgl_dot(p, args[2].c, 1, args[1].c, 1, size), swgl_imm(0.0f));
+        swgl_value_init(out, *t0);
+        for (int k = 0; k < size; ++k)
+            out->c[k] = swgl_alu(p, SWGL_GLSL_OP_SEL, front, args[0].c[k], swgl_alu1(p, SWGL_GLSL_OP_NEG, args[0].c[k]));
+        break;
+    }
+    case SWGL_B_REFLECT:
+    {
+        SwglGlslOperand d2 = swgl_alu2(p, SWGL_GLSL_OP_MUL, swgl_dot(p, args[1].c, 1, args[0].c, 1, size), swgl_imm(2.0f));
+        swgl_value_init(out, *t0);
+        for (int k = 0; k < size; ++k)
+            out->c[k] = swgl_alu2(p, SWGL_GLSL_OP_SUB, args[0].c[k], swgl_alu2(p, SWGL_GLSL_OP_MUL, d2, args[1].c[k]));
+        break;
+    }
+    case SWGL_B_REFRACT:
+    {
+        SwglGlslOperand eta = args[2].c[0];
+        SwglGlslOperand d = swgl_dot(p, args[1].c, 1, args[0].c, 1, size);
+        SwglGlslOperand k2 = swgl_alu2(p, SWGL_GLSL_OP_SUB, swgl_imm(1.0f), swgl_alu2(p, SWGL_GLSL_OP_MUL, d, d));
+        k2 = swgl_alu2(p, SWGL_GLSL_OP_SUB, swgl_imm(1.0f), swgl_alu2(p, SWGL_GLSL_OP_MUL, swgl_alu2(p, SWGL_GLSL_OP_MUL, eta, eta), k2));
+        SwglGlslOperand total = swgl_alu2(p, SWGL_GLSL_OP_LT, k2, swgl_imm(0.0f));
+        SwglGlslOperand s = swgl_alu(p, SWGL_GLSL_OP_MAD, eta, d, swgl_alu1(p, SWGL_GLSL_OP_SQRT, k2));
+        swgl_value_init(out, *t0);
+        for (int k = 0; k < size; ++k)
+        {
+            SwglGlslOperand r = swgl_alu2(p, SWGL_GLSL_OP_SUB, swgl_alu2(p, SWGL_GLSL_OP_MUL, eta, args[0].c[k]),
+                                          swgl_alu2(p, SWGL_GLSL_OP_MUL, s, args[1].c[k]));
+            out->c[k] = swgl_alu(p, SWGL_GLSL_OP_SEL, total, swgl_imm(0.0f), r);
+        }
+        break;
+    }
+    case SWGL_B_COMPARE:
+    {
+        SwglGlslValue swapped[2] = {args[swgl_builtins[b].arg], args[1 - swgl_builtins[b].arg]};
+        swgl_componentwise(p, op, swapped, 2, swgl_type(SWGL_T_BOOL, size, 0), out);
+        break;
+    }
+    case SWGL_B_ANY:
+    case SWGL_B_ALL:
+        swgl_value_init(out, swgl_type(SWGL_T_BOOL, 1, 0));
+        out->c[0] = args[0].c[0];
+        for (int k = 1; k < size; ++k)
+            out->c[0] = swgl_alu2(p, kind == SWGL_B_ANY ? SWGL_GLSL_OP_OR : SWGL_GLSL_OP_AND, out->c[0], args[0].c[k]);
+        break;
+    case SWGL_B_NOT:
+        swgl_componentwise(p, SWGL_GLSL_OP_NOT, args, 1, *t0, out);
+        break;
+    case SWGL_B_TEXTURE:
+        // Texture sampling is not implemented: every texel is opaque black
+        swgl_value_init(out, swgl_type(SWGL_T_FLOAT, 4, 0));
+        for (int k = 0; k < 4; ++k)
+            out->c[k] = swgl_imm(k == 3 ? 1.0f : 0.0f);
+        break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// User functions, inlined at each call
+
+static void swgl_call_function(SwglGlslParser *p, const SwglGlslToken *tok, int f, const SwglGlslValue *args,
+                               SwglGlslValue *out)
+{
+    SwglGlslFunction *fn = &p->functions[f];
+    SwglGlslType returnType = fn->returnType;
+    int paramCount = fn->paramCount;
+    for (int i = 0; i < paramCount; ++i)
+    {
+        if (fn->params[i].qualifier != SWGL_PARAM_IN)
+            swgl_require_lvalue(p, &args[i], tok);
+    }
+    swgl_value_init(out, returnType);
+    int resultBase = 0;
+    if (returnType.base != SWGL_T_VOID)
+    {
+        resultBase = swgl_reg_alloc(p, swgl_components(&returnType));
+        for (int k = 0; k < swgl_components(&returnType); ++k)
+            out->c[k] = swgl_reg(resultBase + k);
+    }
+    if (p->dryRun)
+        return; // bodies are checked at their definition, not expanded
+    if (fn->bodyStart < 0)
+        swgl_error(p, tok->line, tok->text, "function has no body");
+    if (fn->active)
+        swgl_error(p, tok->line, tok->text, "recursive function call");
+
+    int savedFrame = p->frameStart;
+    SwglGlslScope scope = swgl_scope_push(p);
+    p->frameStart = p->symbolCount;
+    int paramRegs[SWGL_GLSL_MAX_ARGS];
+    for (int i = 0; i < paramCount; ++i)
+    {
+        const SwglGlslParam *param = &p->functions[f].params[i];
+        int n = swgl_components(&param->type);
+        paramRegs[i] = swgl_reg_alloc(p, n);
+        if (param->name[0])
+            swgl_declare(p, param->name, param->type, SWGL_ST_REG, paramRegs[i], tok->line)->readOnly = param->readOnly;
+        if (param->qualifier != SWGL_PARAM_OUT)
+        {
+            for (int k = 0; k < n; ++k)
+                swgl_emit(p, SWGL_GLSL_OP_MOV, paramRegs[i] + k, swgl_use(p, args[i].c[k]), 0, 0, 0, 0);
+        }
+    }
+
+    int savedPos = p->pos, savedLoopDepth = p->loopDepth, savedInMain = p->inMain, savedResult = p->resultBase;
+    int savedFloor = p->tempFloor;
+    SwglGlslType savedReturn = p->returnType;
+    p->loopDepth = 0;
+    p->inMain = 0;
+    p->returnType = returnType;
+    p->resultBase = resultBase;
+    p->functions[f].active = 1;
+    swgl_emit_nested(p, SWGL_GLSL_OP_FUNC_BEGIN, 0, tok->line);
+    p->pos = p->functions[f].bodyStart;
+    swgl_parse_compound(p);
+    swgl_emit(p, SWGL_GLSL_OP_FUNC_END, 0, 0, 0, 0, 0, 0);
+    p->maskDepth--;
+    p->functions[f].active = 0;
+    p->pos = savedPos;
+    p->loopDepth = savedLoopDepth;
+    p->inMain = savedInMain;
+    p->returnType = savedReturn;
+    p->resultBase = savedResult;
+    p->tempFloor = savedFloor;
+    p->stmtStart = p->codeCount;
+    p->frameStart = savedFrame;
+
+    for (int i = 0; i < paramCount; ++i)
+    {
+        const SwglGlslParam *param = &p->functions[f].params[i];
+        if (param->qualifier == SWGL_PARAM_IN)
+            continue;
+        SwglGlslValue value;
+        swgl_value_init(&value, param->type);
+        for (int k = 0; k < swgl_components(&param->type); ++k)
+            value.c[k] = swgl_reg(paramRegs[i] + k);
+        swgl_store(p, &args[i], &value);
+    }
+    swgl_scope_pop(p, scope);
+}
+
+// ---------------------------------------------------------------------------
+// Expressions
+
+static int swgl_parse_args(SwglGlslParser *p, SwglGlslValue *args)
+{
+    int n = 0;
+    swgl_expect(p, '(');
+    if (swgl_accept(p, ')'))
+        return 0;
+    if (swgl_is_word(swgl_peek(p, 0), "void") && swgl_is_punct(swgl_peek(p, 1), ')'))
+    {
+        p->pos += 2;
+        return 0;
+    }
+    do
+    {
+        if (n == SWGL_GLSL_MAX_ARGS)
+            swgl_error(p, swgl_peek(p, 0)->line, NULL, "too many arguments");
+        swgl_parse_assignment(p, &args[n++]);
+    } while (swgl_accept(p, ','));
+    swgl_expect(p, ')');
+    return n;
+}
+
+static void swgl_parse_call(SwglGlslParser *p, const SwglGlslToken *tok, SwglGlslValue *v)
+{
+    SwglGlslValue args[SWGL_GLSL_MAX_ARGS];
+    int n = swgl_parse_args(p, args);
+    int found = 0;
+    for (int f = 0; f < p->functionCount; ++f)
+    {
+        const SwglGlslFunction *fn = &p->functions[f];
+        if (strcmp(fn->name, tok->text) != 0)
+            continue;
+        found = 1;
+        int match = fn->paramCount == n;
+        for (int i = 0; match && i < n; ++i)
+            match = swgl_type_equal(&fn->params[i].type, &args[i].type);
+        if (match)
+        {
+            swgl_call_function(p, tok, f, args, v);
+            return;
+        }
+    }
+    int b = swgl_find_builtin(tok->text);
+    if (b >= 0)
+    {
+        swgl_call_builtin(p, tok, b, args, n, v);
+        return;
+    }
+    swgl_error(p, tok->line, tok->text, found ? "no matching overloaded function found" : "no matching function found");
+}
+
+static void swgl_parse_primary(SwglGlslParser *p, SwglGlslValue *v)
+{
+    const SwglGlslToken *tok = swgl_next(p);
+    if (tok->type == SWGL_TOK_INT || tok->type == SWGL_TOK_FLOAT)
+    {
+        swgl_value_init(v, swgl_type(tok->type == SWGL_TOK_INT ? SWGL_T_INT : SWGL_T_FLOAT, 1, 0));
+        v->c[0] = swgl_imm((float)tok->value);
+        return;
+    }
+    if (swgl_is_word(tok, "true") || swgl_is_word(tok, "false"))
+    {
+        swgl_value_init(v, swgl_type(SWGL_T_BOOL, 1, 0));
+        v->c[0] = swgl_imm(tok->text[0] == 't' ? 1.0f : 0.0f);
+        return;
+    }
+    if (swgl_is_punct(tok, '('))
+    {
+        swgl_parse_expression(p, v);
+        swgl_expect(p, ')');
+        return;
+    }
+    if (tok->type == SWGL_TOK_IDENT)
+    {
+        SwglGlslType type;
+        p->pos--;
+        if (swgl_parse_type(p, &type))
+        {
+            if (type.base == SWGL_T_VOID || swgl_is_sampler(&type))
+                swgl_error(p, tok->line, tok->text, "cannot construct this type");
+            SwglGlslValue args[SWGL_GLSL_MAX_ARGS];
+            int n = swgl_parse_args(p, args);
+            swgl_construct(p, tok, type, args, n, v);
+            return;
+        }
+        p->pos++;
+        if (swgl_is_punct(swgl_peek(p, 0), '('))
+        {
+            swgl_parse_call(p, tok, v);
+            return;
+        }
+        int s = swgl_find_symbol(p, tok->text);
+        if (s < 0)
+            swgl_error(p, tok->line, tok->text, "undeclared identifier");
+        swgl_load_symbol(p, s, v);
+        return;
+    }
+    swgl_error(p, tok->line, tok->type == SWGL_TOK_EOF ? "end of file" : tok->text, "syntax error");
+}
+
+// ++ and -- on an lvalue; returns the old value for the postfix forms.
+static void swgl_increment(SwglGlslParser *p, SwglGlslValue *v, const SwglGlslToken *op, int postfix)
+{
+    swgl_require_lvalue(p, v, op);
+    if (!swgl_is_arithmetic(&v->type))
+        swgl_error(p, op->line, op->text, "wrong operand type");
+    int n = swgl_components(&v->type);
+    SwglGlslValue old = *v, next = *v;
+    old.lvalue = next.lvalue = SWGL_LV_NONE;
+    for (int k = 0; k < n; ++k)
+    {
+        if (postfix)
+            old.c[k] = swgl_alu1(p, SWGL_GLSL_OP_MOV, v->c[k]);
+        next.c[k] = swgl_alu2(p, op->punct == SWGL_P_INC ? SWGL_GLSL_OP_ADD : SWGL_GLSL_OP_SUB, v->c[k], swgl_imm(1.0f));
+    }
+    swgl_store(p, v, &next);
+    if (postfix)
+        *v = old;
+    else if (v->lvalue == SWGL_LV_DYNAMIC)
+        *v = next;
+    v->lvalue = SWGL_LV_NONE;
+}
+
+static void swgl_parse_postfix(SwglGlslParser *p, SwglGlslValue *v)
+{
+    swgl_parse_primary(p, v);
+    for (;;)
+    {
+        const SwglGlslToken *tok = swgl_peek(p, 0);
+        if (swgl_accept(p, '['))
+        {
+            SwglGlslValue index;
+            swgl_parse_expression(p, &index);
+            swgl_expect(p, ']');
+            if (!v->type.array && v->type.base == SWGL_T_VOID)
+                swgl_error(p, tok->line, "[", "left of '[' is not of type array, matrix, or vector");
+            swgl_index(p, v, &index, tok->line);
+        }
+        else if (swgl_accept(p, '.'))
+        {
+            const SwglGlslToken *field = swgl_next(p);
+            if (field->type != SWGL_TOK_IDENT)
+                swgl_error(p, field->line, field->text, "syntax error, field name expected");
+            swgl_swizzle(p, v, field);
+        }
+        else if (swgl_is_punct(tok, SWGL_P_INC) || swgl_is_punct(tok, SWGL_P_DEC))
+        {
+            p->pos++;
+            swgl_increment(p, v, tok, 1);
+        }
+        else
+            return;
+    }
+}
+
+static void swgl_parse_unary(SwglGlslParser *p, SwglGlslValue *v)
+{
+    const SwglGlslToken *tok = swgl_peek(p, 0);
+    if (tok->type != SWGL_TOK_PUNCT)
+    {
+        swgl_parse_postfix(p, v);
+        return;
+    }
+    switch (tok->punct)
+    {
+    case '+':
+    case '-':
+    {
+        p->pos++;
+        swgl_parse_unary(p, v);
+        if (!swgl_is_arithmetic(&v->type))
+            swgl_error(p, tok->line, tok->text, "wrong operand type");
+        v->lvalue = SWGL_LV_NONE;
+        if (tok->punct == '-')
+        {
+            for (int k = 0; k < swgl_components(&v->type); ++k)
+                v->c[k] = swgl_alu1(p, SWGL_GLSL_OP_NEG, v->c[k]);
+        }
+        return;
+    }
+    case '!':
+        p->pos++;
+        swgl_parse_unary(p, v);
+        if (v->type.base != SWGL_T_BOOL || !swgl_is_scalar(&v->type))
+            swgl_error(p, tok->line, tok->text, "wrong operand type");
+        v->lvalue = SWGL_LV_NONE;
+        v->c[0] = swgl_alu1(p, SWGL_GLSL_OP_NOT, v->c[0]);
+        return;
+    case '~':
+        swgl_error(p, tok->line, tok->text, "reserved operator");
+    case SWGL_P_INC:
+    case SWGL_P_DEC:
+        p->pos++;
+        swgl_parse_unary(p, v);
+        swgl_increment(p, v, tok, 0);
+        return;
+    }
+    swgl_parse_postfix(p, v);
+}
+
+static int swgl_binary_level(const SwglGlslToken *tok)
+{
+    if (tok->type != SWGL_TOK_PUNCT)
+        return 0;
+    switch (tok->punct)
+    {
+    case SWGL_P_OR: return 1;
+    case SWGL_P_XOR: return 2;
+    case SWGL_P_AND: return 3;
+    case SWGL_P_EQ: case SWGL_P_NE: return 4;
+    case '<': case '>': case SWGL_P_LE: case SWGL_P_GE: return 5;
+    case '+': case '-': return 6;
+    case '*': case '/': return 7;
+    case '%': case '&': case '|': case '^': case SWGL_P_SHL: case SWGL_P_SHR: return -1;
+    }
+    return 0;
+}
+
+static void swgl_binary(SwglGlslParser *p, const SwglGlslToken *op, const SwglGlslValue *l, const SwglGlslValue *r,
+                        SwglGlslValue *out)
+{
+    int punct = op->punct;
+    if (punct == '+' || punct == '-' || punct == '*' || punct == '/')
+    {
+        swgl_arith(p, op, punct, l, r, out);
+        return;
+    }
+    SwglGlslType boolean = swgl_type(SWGL_T_BOOL, 1, 0);
+    swgl_value_init(out, boolean);
+    if (punct == '<' || punct == '>' || punct == SWGL_P_LE || punct == SWGL_P_GE)
+    {
+        if (!swgl_is_arithmetic(&l->type) || !swgl_is_scalar(&l->type) || !swgl_type_equal(&l->type, &r->type))
+            swgl_operand_error(p, op, l, r);
+        int swap = punct == '>' || punct == SWGL_P_GE;
+        out->c[0] = swgl_alu2(p, punct == '<' || punct == '>' ? SWGL_GLSL_OP_LT : SWGL_GLSL_OP_LE,
+                              swap ? r->c[0] : l->c[0], swap ? l->c[0] : r->c[0]);
+        return;
+    }
+    if (punct == SWGL_P_EQ || punct == SWGL_P_NE)
+    {
+        if (!swgl_type_equal(&l->type, &r->type) || l->type.array || swgl_is_sampler(&l->type) || l->type.base == SWGL_T_VOID)
+            swgl_operand_error(p, op, l, r);
+        int eq = punct == SWGL_P_EQ;
+        for (int k = 0; k < swgl_components(&l->type); ++k)
+        {
+            SwglGlslOperand c = swgl_alu2(p, eq ? SWGL_GLSL_OP_EQ : SWGL_GLSL_OP_NE, l->c[k], r->c[k]);
+            out->c[0] = k == 0 ? c : swgl_alu2(p, eq ? SWGL_GLSL_OP_AND : SWGL_GLSL_OP_OR, out->c[0], c);
+        }
+        return;
+    }
+    if (!swgl_type_equal(&l->type, &boolean) || !swgl_type_equal(&r->type, &boolean))
+        swgl_operand_error(p, op, l, r);
+    // Both sides are evaluated: the operands of && and || have no side effects
+    // in the shaders this engine targets, and lanes would diverge anyway
+    int alu = punct == SWGL_P_AND ? SWGL_GLSL_OP_AND : punct == SWGL_P_OR ? SWGL_GLSL_OP_OR : SWGL_GLSL_OP_XOR;
+    out->c[0] = swgl_alu2(p, alu, l->c[0], r->c[0]);
+}
+
+static void swgl_parse_binary(SwglGlslParser *p, SwglGlslValue *v, int minLevel)
+{
+    swgl_parse_unary(p, v);
+    for (;;)
+    {
+        const SwglGlslToken *op = swgl_peek(p, 0);
+        int level = swgl_binary_level(op);
+        if (level < 0)
+            swgl_error(p, op->line, op->text, "reserved operator");
+        if (level <= minLevel)
+            return;
+        p->pos++;
+        SwglGlslValue r, out;
+        swgl_parse_binary(p, &r, level);
+        swgl_binary(p, op, v, &r, &out);
+        *v = out;
+    }
+}
+
+static void swgl_parse_conditional(SwglGlslParser *p, SwglGlslValue *v)
+{
+    swgl_parse_binary(p, v, 0);
+    const SwglGlslToken *tok = swgl_peek(p, 0);
+    if (!swgl_accept(p, '?'))
+        return;
+    if (v->type.base != SWGL_T_BOOL || !swgl_is_scalar(&v->type))
+        swgl_error(p, tok->line, "?", "boolean expression expected");
+    SwglGlslValue a, b;
+    swgl_parse_expression(p, &a);
+    swgl_expect(p, ':');
+    swgl_parse_assignment(p, &b);
+    if (!swgl_type_equal(&a.type, &b.type) || a.type.array)
+        swgl_error(p, tok->line, "?", "wrong operand types - the second and third expressions must have the same type");
+    SwglGlslOperand cond = v->c[0];
+    swgl_value_init(v, a.type);
+    for (int k = 0; k < swgl_components(&a.type); ++k)
+        v->c[k] = swgl_alu(p, SWGL_GLSL_OP_SEL, cond, a.c[k], b.c[k]);
+}
+
+static void swgl_parse_assignment(SwglGlslParser *p, SwglGlslValue *v)
+{
+    swgl_parse_conditional(p, v);
+    const SwglGlslToken *op = swgl_peek(p, 0);
+    if (op->type != SWGL_TOK_PUNCT)
+        return;
+    int arith;
+    switch (op->punct)
+    {
+    case '=': arith = 0; break;
+    case SWGL_P_ADD_ASSIGN: arith = '+'; break;
+    case SWGL_P_SUB_ASSIGN: arith = '-'; break;
+    case SWGL_P_MUL_ASSIGN: arith = '*'; break;
+    case SWGL_P_DIV_ASSIGN: arith = '/'; break;
+    case SWGL_P_MOD_ASSIGN:
+    case SWGL_P_SHL_ASSIGN:
+    case SWGL_P_SHR_ASSIGN:
+    case SWGL_P_AND_ASSIGN:
+    case SWGL_P_OR_ASSIGN:
+    case SWGL_P_XOR_ASSIGN:
+        swgl_error(p, op->line, op->text, "reserved operator");
+    default:
+        return;
+    }
+    p->pos++;
+    swgl_require_lvalue(p, v, op);
+    SwglGlslValue r, value;
+    swgl_parse_assignment(p, &r);
+    if (arith)
+        swgl_arith(p, op, arith, v, &r, &value);
+    else
+        value = r;
+    if (!swgl_type_equal(&v->type, &value.type))
+        swgl_error(p, op->line, op->text, "cannot convert from '%s' to '%s'", swgl_type_name(&value.type), swgl_type_name(&v->type));
+    swgl_store(p, v, &value);
+    if (v->lvalue == SWGL_LV_DYNAMIC)
+        *v = value;
+    v->lvalue = SWGL_LV_NONE;
+}
+
+static void swgl_parse_expression(SwglGlslParser *p, SwglGlslValue *v)
+{
+    swgl_parse_assignment(p, v);
+    while (swgl_accept(p, ','))
+        swgl_parse_assignment(p, v);
+}
+
+// ---------------------------------------------------------------------------
+// Statements
+
+static void swgl_parse_statement(SwglGlslParser *p);
+static int swgl_parse_declaration(SwglGlslParser *p, int global);
+
+static void swgl_parse_compound(SwglGlslParser *p)
+{
+    swgl_expect(p, '{');
+    SwglGlslScope scope = swgl_scope_push(p);
+    while (!swgl_accept(p, '}'))
+    {
+        const SwglGlslToken *tok = swgl_peek(p, 0);
+        if (tok->type == SWGL_TOK_EOF)
+            swgl_error(p, tok->line, "end of file", "syntax error, unexpected end of file");
+        swgl_parse_statement(p);
+    }
+    swgl_scope_pop(p, scope);
+}
+
+// A sub-statement gets its own scope, so "if (c) float x;" declares nothing outside.
+static void swgl_parse_substatement(SwglGlslParser *p)
+{
+    SwglGlslScope scope = swgl_scope_push(p);
+    swgl_parse_statement(p);
+    swgl_scope_pop(p, scope);
+}
+
+static SwglGlslOperand swgl_parse_condition(SwglGlslParser *p)
+{
+    const SwglGlslToken *tok = swgl_peek(p, 0);
+    SwglGlslValue cond;
+    swgl_parse_expression(p, &cond);
+    if (cond.type.base != SWGL_T_BOOL || !swgl_is_scalar(&cond.type))
+        swgl_error(p, tok->line, tok->text, "boolean expression expected");
+    return cond.c[0];
+}
+
+static void swgl_parse_if(SwglGlslParser *p, const SwglGlslToken *tok)
+{
+    swgl_expect(p, '(');
+    SwglGlslOperand cond = swgl_parse_condition(p);
+    swgl_expect(p, ')');
+    int at = swgl_emit_nested(p, SWGL_GLSL_OP_IF, swgl_use(p, cond), tok->line);
+    swgl_parse_substatement(p);
+    if (swgl_accept_word(p, "else"))
+    {
+        int other = swgl_emit(p, SWGL_GLSL_OP_ELSE, 0, 0, 0, 0, 0, 0);
+        p->code[at].imm = other;
+        swgl_parse_substatement(p);
+        at = other;
+    }
+    int end = swgl_emit(p, SWGL_GLSL_OP_ENDIF, 0, 0, 0, 0, 0, 0);
+    p->code[at].imm = end;
+    p->maskDepth--;
+}
+
+static void swgl_loop_end(SwglGlslParser *p, int top, int test)
+{
+    swgl_emit(p, SWGL_GLSL_OP_LOOP_NEXT, 0, 0, 0, 0, top, 0);
+    int exit = swgl_emit(p, SWGL_GLSL_OP_LOOP_EXIT, 0, 0, 0, 0, 0, 0);
+    if (test >= 0)
+        p->code[test].imm = exit;
+    p->maskDepth--;
+    p->loopDepth--;
+}
+
+static void swgl_parse_for(SwglGlslParser *p, const SwglGlslToken *tok)
+{
+    swgl_expect(p, '(');
+    SwglGlslScope scope = swgl_scope_push(p);
+    if (!swgl_accept(p, ';') && !swgl_parse_declaration(p, 0))
+    {
+        SwglGlslValue init;
+        swgl_parse_expression(p, &init);
+        swgl_expect(p, ';');
+    }
+    swgl_emit_nested(p, SWGL_GLSL_OP_LOOP, 0, tok->line);
+    p->loopDepth++;
+    int top = p->codeCount, test = -1;
+    if (!swgl_is_punct(swgl_peek(p, 0), ';'))
+        test = swgl_emit(p, SWGL_GLSL_OP_LOOP_TEST, 0, swgl_use(p, swgl_parse_condition(p)), 0, 0, 0, 0);
+    swgl_expect(p, ';');
+
+    // The step is emitted after the body
+    int step = p->pos;
+    for (int depth = 0; depth > 0 || !swgl_is_punct(swgl_peek(p, 0), ')');)
+    {
+        const SwglGlslToken *t = swgl_next(p);
+        if (t->type == SWGL_TOK_EOF)
+            swgl_error(p, t->line, "end of file", "syntax error, unexpected end of file");
+        depth += swgl_is_punct(t, '(') - swgl_is_punct(t, ')');
+    }
+    p->pos++;
+    swgl_parse_substatement(p);
+    swgl_emit(p, SWGL_GLSL_OP_ITER_END, 0, 0, 0, 0, 0, 0);
+    int end = p->pos;
+    p->pos = step;
+    if (!swgl_is_punct(swgl_peek(p, 0), ')'))
+    {
+        SwglGlslValue value;
+        swgl_parse_expression(p, &value);
+    }
+    swgl_expect(p, ')');
+    p->pos = end;
+    swgl_loop_end(p, top, test);
+    swgl_scope_pop(p, scope);
+}
+
+static void swgl_parse_while(SwglGlslParser *p, const SwglGlslToken *tok)
+{
+    swgl_emit_nested(p, SWGL_GLSL_OP_LOOP, 0, tok->line);
+    p->loopDepth++;
+    int top = p->codeCount;
+    swgl_expect(p, '(');
+    int test = swgl_emit(p, SWGL_GLSL_OP_LOOP_TEST, 0, swgl_use(p, swgl_parse_condition(p)), 0, 0, 0, 0);
+    swgl_expect(p, ')');
+    swgl_parse_substatement(p);
+    swgl_emit(p, SWGL_GLSL_OP_ITER_END, 0, 0, 0, 0, 0, 0);
+    swgl_loop_end(p, top, test);
+}
+
+static void swgl_parse_do(SwglGlslParser *p, const SwglGlslToken *tok)
+{
+    swgl_emit_nested(p, SWGL_GLSL_OP_LOOP, 0, tok->line);
+    p->loopDepth++;
+    int top = p->codeCount;
+    swgl_parse_substatement(p);
+    swgl_emit(p, SWGL_GLSL_OP_ITER_END, 0, 0, 0, 0, 0, 0);
+    if (!swgl_accept_word(p, "while"))
+        swgl_error(p, swgl_peek(p, 0)->line, swgl_peek(p, 0)->text, "syntax error, expected 'while'");
+    swgl_expect(p, '(');
+    int test = swgl_emit(p, SWGL_GLSL_OP_LOOP_TEST, 0, swgl_use(p, swgl_parse_condition(p)), 0, 0, 0, 0);
+    swgl_expect(p, ')');
+    swgl_expect(p, ';');
+    swgl_loop_end(p, top, test);
+}
+
+static void swgl_parse_return(SwglGlslParser *p, const SwglGlslToken *tok)
+{
+    if (swgl_accept(p, ';'))
+    {
+        if (p->returnType.base != SWGL_T_VOID)
+            swgl_error(p, tok->line, "return", "non-void function must return a value");
+    }
+    else
+    {
+        SwglGlslValue value;
+        swgl_parse_expression(p, &value);
+        swgl_expect(p, ';');
+        if (p->returnType.base == SWGL_T_VOID)
+            swgl_error(p, tok->line, "return", "void function cannot return a value");
+        if (!swgl_type_equal(&value.type, &p->returnType))
+            swgl_error(p, tok->line, "return", "function return is not matching type");
+        SwglGlslValue result;
+        swgl_value_init(&result, p->returnType);
+        result.lvalue = SWGL_LV_REGS;
+        for (int k = 0; k < swgl_components(&p->returnType); ++k)
+            result.c[k] = swgl_reg(p->resultBase + k);
+        swgl_store(p, &result, &value);
+    }
+    swgl_emit(p, SWGL_GLSL_OP_RET, 0, 0, 0, 0, 0, 0);
+    if (p->inMain)
+        p->mainReturned = 1;
+}
+
+static void swgl_parse_statement(SwglGlslParser *p)
+{
+    const SwglGlslToken *tok = swgl_peek(p, 0);
+    int savedFloor = p->tempFloor, savedStart = p->stmtStart, mark = p->regTop, keep = 0;
+    p->tempFloor = p->regTop;
+    p->stmtStart = p->codeCount;
+    if (swgl_is_punct(tok, '{'))
+        swgl_parse_compound(p);
+    else if (swgl_accept(p, ';'))
+        ;
+    else if (swgl_accept_word(p, "if"))
+        swgl_parse_if(p, tok);
+    else if (swgl_accept_word(p, "for"))
+        swgl_parse_for(p, tok);
+    else if (swgl_accept_word(p, "while"))
+        swgl_parse_while(p, tok);
+    else if (swgl_accept_word(p, "do"))
+        swgl_parse_do(p, tok);
+    else if (swgl_accept_word(p, "break") || swgl_accept_word(p, "continue"))
+    {
+        if (!p->loopDepth)
+            swgl_error(p, tok->line, tok->text, "%s statement only allowed in loops", tok->text);
+        swgl_expect(p, ';');
+        swgl_emit(p, tok->text[0] == 'b' ? SWGL_GLSL_OP_BREAK : SWGL_GLSL_OP_CONTINUE, 0, 0, 0, 0, 0, 0);
+    }
+    else if (swgl_accept_word(p, "return"))
+        swgl_parse_return(p, tok);
+    else if (swgl_accept_word(p, "discard"))
+    {
+        if (p->stage != SWGL_GLSL_FRAGMENT)
+            swgl_error(p, tok->line, "discard", "not supported in this stage");
+        swgl_expect(p, ';');
+        swgl_emit(p, SWGL_GLSL_OP_DISCARD, 0, 0, 0, 0, 0, 0);
+    }
+    else if (swgl_parse_declaration(p, 0))
+        keep = 1; // the new variables stay allocated until the scope ends
+    else
+    {
+        SwglGlslValue value;
+        swgl_parse_expression(p, &value);
+        swgl_expect(p, ';');
+    }
+    if (!keep)
+        p->regTop = mark;
+    p->tempFloor = savedFloor;
+    p->stmtStart = savedStart;
+}
+
+// ---------------------------------------------------------------------------
+// Declarations
+
+enum
+{
+    SWGL_Q_NONE,
+    SWGL_Q_CONST,
+    SWGL_Q_ATTRIBUTE,
+    SWGL_Q_VARYING,
+    SWGL_Q_UNIFORM
+};
+
+static int swgl_parse_array_size(SwglGlslParser *p)
+{
+    const SwglGlslToken *tok = swgl_peek(p, 0);
+    SwglGlslValue size;
+    swgl_parse_conditional(p, &size);
+    swgl_expect(p, ']');
+    if (size.type.base != SWGL_T_INT || !swgl_is_scalar(&size.type) || !swgl_value_constant(&size))
+        swgl_error(p, tok->line, tok->text, "array size must be a constant integer expression");
+    if (size.c[0].k <= 0.0f)
+        swgl_error(p, tok->line, tok->text, "array size must be greater than zero");
+    return (int)size.c[0].k;
+}
+
+static int swgl_add_decl(SwglGlslParser *p, int kind, const char *name, SwglGlslType type)
+{
+    p->decls[kind] = (SwglGlslDecl *)swgl_grow(p, p->decls[kind], &p->declCapacity[kind], p->declCount[kind],
+                                               sizeof(SwglGlslDecl));
+    SwglGlslDecl *d = &p->decls[kind][p->declCount[kind]];
+    memset(d, 0, sizeof(*d));
+    snprintf(d->info.name, sizeof(d->info.name), "%s", name);
+    SwglGlslType element = type;
+    element.array = 0;
+    d->info.type = swgl_type_names[swgl_type_index(&element)].gl;
+    d->info.arraySize = type.array ? type.array : 1;
+    d->info.components = swgl_components(&element);
+    d->type = type;
+    d->cache = -1;
+    d->reg = -1;
+    if (kind == SWGL_GLSL_UNIFORM)
+    {
+        int n = d->info.components * d->info.arraySize;
+        d->uniformRegs = (int *)malloc((size_t)n * sizeof(int));
+        if (!d->uniformRegs)
+            swgl_error(p, 0, NULL, "out of memory");
+        for (int i = 0; i < n; ++i)
+            d->uniformRegs[i] = -1;
+    }
+    return p->declCount[kind]++;
+}
+
+static void swgl_add_global_init(SwglGlslParser *p, int reg, float value)
+{
+    p->globalInits = (SwglGlslConstant *)swgl_grow(p, p->globalInits, &p->globalInitCapacity, p->globalInitCount,
+                                                   sizeof(SwglGlslConstant));
+    p->globalInits[p->globalInitCount].reg = reg;
+    p->globalInits[p->globalInitCount].value = value;
+    p->globalInitCount++;
+}
+
+static void swgl_declare_variable(SwglGlslParser *p, int qualifier, SwglGlslType type, const SwglGlslToken *name,
+                                  int global)
+{
+    int line = name->line;
+    int n = swgl_components(&type) * (type.array ? type.array : 1);
+    int floatOnly = type.base == SWGL_T_FLOAT;
+    if (swgl_is_sampler(&type) && qualifier != SWGL_Q_UNIFORM)
+        swgl_error(p, line, name->text, "samplers must be uniform");
+    switch (qualifier)
+    {
+    case SWGL_Q_UNIFORM:
+    {
+        int d = swgl_add_decl(p, SWGL_GLSL_UNIFORM, name->text, type);
+        swgl_declare(p, name->text, type, SWGL_ST_UNIFORM, d, line)->readOnly = 1;
+        return;
+    }
+    case SWGL_Q_ATTRIBUTE:
+    {
+        if (p->stage != SWGL_GLSL_VERTEX)
+            swgl_error(p, line, "attribute", "supported in vertex shaders only");
+        if (!floatOnly || type.array)
+            swgl_error(p, line, name->text, "cannot be bool, int or an array");
+        int d = swgl_add_decl(p, SWGL_GLSL_ATTRIBUTE, name->text, type);
+        swgl_declare(p, name->text, type, SWGL_ST_INPUT, d, line)->readOnly = 1;
+        return;
+    }
+    case SWGL_Q_VARYING:
+    {
+        if (!floatOnly)
+            swgl_error(p, line, name->text, "varyings cannot be bool or int");
+        int d = swgl_add_decl(p, SWGL_GLSL_VARYING, name->text, type);
+        if (p->stage == SWGL_GLSL_FRAGMENT)
+        {
+            swgl_declare(p, name->text, type, SWGL_ST_INPUT, d, line)->readOnly = 1;
+            return;
+        }
+        int reg = swgl_reg_alloc(p, n);
+        p->decls[SWGL_GLSL_VARYING][d].reg = reg;
+        for (int k = 0; k < n; ++k)
+            swgl_add_global_init(p, reg + k, 0.0f);
+        swgl_declare(p, name->text, type, SWGL_ST_REG, reg, line);
+        return;
+    }
+    }
+
+    int init = swgl_accept(p, '=');
+    if (qualifier == SWGL_Q_CONST && !init)
+        swgl_error(p, line, name->text, "variables with qualifier 'const' must be initialized");
+    if (init && type.array)
+        swgl_error(p, line, name->text, "arrays cannot be initialized");
+    int reg = qualifier == SWGL_Q_CONST ? 0 : swgl_reg_alloc(p, n);
+    p->tempFloor = p->regTop;
+    SwglGlslValue value;
+    if (init)
+    {
+        const SwglGlslToken *at = swgl_peek(p, -1);
+        swgl_parse_assignment(p, &value);
+        if (!swgl_type_equal(&value.type, &type))
+            swgl_error(p, at->line, "=", "cannot convert from '%s' to '%s'", swgl_type_name(&value.type), swgl_type_name(&type));
+        if ((qualifier == SWGL_Q_CONST || global) && !swgl_value_constant(&value))
+            swgl_error(p, at->line, "=", "initializer must be a constant expression");
+    }
+    if (qualifier == SWGL_Q_CONST)
+    {
+        SwglGlslSymbol *s = swgl_declare(p, name->text, type, SWGL_ST_CONST, 0, line);
+        for (int k = 0; k < n; ++k)
+            s->value[k] = value.c[k].k;
+        return;
+    }
+    if (global)
+    {
+        // Globals are set when main starts
+        for (int k = 0; k < n; ++k)
+            swgl_add_global_init(p, reg + k, init ? value.c[k].k : 0.0f);
+    }
+    else if (init)
+    {
+        SwglGlslValue dst;
+        swgl_value_init(&dst, type);
+        dst.lvalue = SWGL_LV_REGS;
+        for (int k = 0; k < n; ++k)
+            dst.c[k] = swgl_reg(reg + k);
+        swgl_store(p, &dst, &value);
+    }
+    p->regTop = reg + n;
+    swgl_declare(p, name->text, type, SWGL_ST_REG, reg, line);
+}
+
+// Parses a declaration statement; returns 0, consuming nothing, when the
+// tokens are not one.
+static int swgl_parse_declaration(SwglGlslParser *p, int global)
+{
+    int start = p->pos;
+    const SwglGlslToken *first = swgl_peek(p, 0);
+    if (swgl_accept_word(p, "precision"))
+    {
+        SwglGlslType type;
+        if (!swgl_accept_precision(p) || !swgl_parse_type(p, &type) ||
+            !(type.base == SWGL_T_FLOAT || type.base == SWGL_T_INT || swgl_is_sampler(&type)) || type.size > 1)
+            swgl_error(p, first->line, "precision", "illegal type for precision qualifier");
+        swgl_expect(p, ';');
+        return 1;
+    }
+    int invariant = swgl_accept_word(p, "invariant");
+    if (invariant && swgl_peek(p, 0)->type == SWGL_TOK_IDENT && !swgl_is_word(swgl_peek(p, 0), "varying"))
+    {
+        // invariant gl_Position, v;
+        if (!global)
+            swgl_error(p, first->line, "invariant", "only allowed at global scope");
+        do
+        {
+            const SwglGlslToken *name = swgl_next(p);
+            int s = swgl_find_symbol(p, name->text);
+            if (s < 0)
+                swgl_error(p, name->line, name->text, "undeclared identifier");
+        } while (swgl_accept(p, ','));
+        swgl_expect(p, ';');
+        return 1;
+    }
+
+    int qualifier = SWGL_Q_NONE;
+    const SwglGlslToken *qualifierTok = swgl_peek(p, 0);
+    if (swgl_accept_word(p, "const"))
+        qualifier = SWGL_Q_CONST;
+    else if (swgl_accept_word(p, "attribute"))
+        qualifier = SWGL_Q_ATTRIBUTE;
+    else if (swgl_accept_word(p, "varying"))
+        qualifier = SWGL_Q_VARYING;
+    else if (swgl_accept_word(p, "uniform"))
+        qualifier = SWGL_Q_UNIFORM;
+    if (invariant && qualifier != SWGL_Q_VARYING)
+        swgl_error(p, first->line, "invariant", "can only qualify varyings");
+    if (qualifier > SWGL_Q_CONST && !global)
+        swgl_error(p, qualifierTok->line, qualifierTok->text, "only allowed at global scope");
+    int precision = swgl_accept_precision(p);
+
+    SwglGlslType type;
+    if (!swgl_parse_type(p, &type))
+    {
+        if (p->pos != start)
+        {
+            const SwglGlslToken *tok = swgl_peek(p, 0);
+            swgl_error(p, tok->line, tok->type == SWGL_TOK_EOF ? "end of file" : tok->text, "syntax error, type expected");
+        }
+        return 0;
+    }
+    if (swgl_is_punct(swgl_peek(p, 0), '(') && qualifier == SWGL_Q_NONE && !precision)
+    {
+        p->pos = start; // constructor call
+        return 0;
+    }
+    if (type.base == SWGL_T_VOID)
+        swgl_error(p, first->line, "void", "illegal use of type 'void'");
+    if (swgl_accept(p, ';'))
+        return 1;
+    do
+    {
+        const SwglGlslToken *name = swgl_expect_name(p);
+        SwglGlslType variable = type;
+        if (swgl_accept(p, '['))
+        {
+            if (qualifier == SWGL_Q_CONST)
+                swgl_error(p, name->line, name->text, "arrays cannot be const");
+            variable.array = swgl_parse_array_size(p);
+        }
+        swgl_declare_variable(p, qualifier, variable, name, global);
+    } while (swgl_accept(p, ','));
+    swgl_expect(p, ';');
+    return 1;
+}
+
+static void swgl_parse_function(SwglGlslParser *p, SwglGlslType returnType)
+{
+    const SwglGlslToken *nameTok = swgl_expect_name(p);
+    if (swgl_find_builtin(nameTok->text) >= 0)
+        swgl_error(p, nameTok->line, nameTok->text, "cannot redefine a built-in function");
+    SwglGlslFunction fn;
+    memset(&fn, 0, sizeof(fn));
+    snprintf(fn.name, sizeof(fn.name), "%s", nameTok->text);
+    fn.returnType = returnType;
+    fn.bodyStart = -1;
+    swgl_expect(p, '(');
+    if (swgl_is_word(swgl_peek(p, 0), "void") && swgl_is_punct(swgl_peek(p, 1), ')'))
+        p->pos++;
+    if (!swgl_accept(p, ')'))
+    {
+        do
+        {
+            const SwglGlslToken *tok = swgl_peek(p, 0);
+            if (fn.paramCount == SWGL_GLSL_MAX_ARGS)
+                swgl_error(p, tok->line, tok->text, "too many parameters");
+            SwglGlslParam *param = &fn.params[fn.paramCount++];
+            param->readOnly = swgl_accept_word(p, "const");
+            if (swgl_accept_word(p, "out"))
+                param->qualifier = SWGL_PARAM_OUT;
+            else if (swgl_accept_word(p, "inout"))
+                param->qualifier = SWGL_PARAM_INOUT;
+            else
+                swgl_accept_word(p, "in");
+            if (param->readOnly && param->qualifier != SWGL_PARAM_IN)
+                swgl_error(p, tok->line, tok->text, "qualifier 'const' cannot be used with out or inout");
+            swgl_accept_precision(p);
+            if (!swgl_parse_type(p, &param->type) || param->type.base == SWGL_T_VOID)
+                swgl_error(p, tok->line, tok->text, "syntax error, parameter type expected");
+            if (swgl_is_sampler(&param->type) && param->qualifier != SWGL_PARAM_IN)
+                swgl_error(p, tok->line, tok->text, "samplers cannot be output parameters");
+            if (swgl_peek(p, 0)->type == SWGL_TOK_IDENT)
+                snprintf(param->name, sizeof(param->name), "%s", swgl_expect_name(p)->text);
+            if (swgl_is_punct(swgl_peek(p, 0), '['))
+                swgl_error(p, tok->line, tok->text, "array parameters are not supported");
+        } while (swgl_accept(p, ','));
+        swgl_expect(p, ')');
+    }
+
+    int f = -1;
+    for (int i = 0; i < p->functionCount && f < 0; ++i)
+    {
+        const SwglGlslFunction *other = &p->functions[i];
+        int same = strcmp(other->name, fn.name) == 0 && other->paramCount == fn.paramCount;
+        for (int k = 0; same && k < fn.paramCount; ++k)
+            same = swgl_type_equal(&other->params[k].type, &fn.params[k].type) &&
+                   other->params[k].qualifier == fn.params[k].qualifier;
+        if (same)
+            f = i;
+    }
+    if (f >= 0 && !swgl_type_equal(&p->functions[f].returnType, &returnType))
+        swgl_error(p, nameTok->line, nameTok->text, "overloaded functions must have the same return type");
+    if (swgl_accept(p, ';'))
+    {
+        if (f < 0)
+        {
+            p->functions = (SwglGlslFunction *)swgl_grow(p, p->functions, &p->functionCapacity, p->functionCount,
+                                                         sizeof(SwglGlslFunction));
+            p->functions[p->functionCount++] = fn;
+        }
+        return;
+    }
+    if (f >= 0 && p->functions[f].bodyStart >= 0)
+        swgl_error(p, nameTok->line, nameTok->text, "function already has a body");
+    if (f < 0)
+    {
+        p->functions = (SwglGlslFunction *)swgl_grow(p, p->functions, &p->functionCapacity, p->functionCount,
+                                                     sizeof(SwglGlslFunction));
+        f = p->functionCount++;
+    }
+    fn.bodyStart = p->pos;
+    p->functions[f] = fn;
+    int isMain = strcmp(fn.name, "main") == 0;
+    if (isMain)
+    {
+        if (returnType.base != SWGL_T_VOID)
+            swgl_error(p, nameTok->line, "main", "function cannot return a value");
+        if (fn.paramCount)
+            swgl_error(p, nameTok->line, "main", "function cannot take any parameter(s)");
+        p->mainIndex = f;
+    }
+
+    // Check the body now; the code is generated at each call
+    int codeCount = p->codeCount, prologueCount = p->prologueCount, persistCount = p->persistCount;
+    int constCount = p->constCount, regTop = p->regTop, regMax = p->regMax;
+    p->dryRun = 1;
+    p->inMain = isMain;
+    p->maskDepth = 1;
+    p->loopDepth = 0;
+    p->returnType = returnType;
+    SwglGlslScope scope = swgl_scope_push(p);
+    p->resultBase = swgl_reg_alloc(p, swgl_components(&returnType));
+    for (int i = 0; i < fn.paramCount; ++i)
+    {
+        int n = swgl_components(&fn.params[i].type) * (fn.params[i].type.array ? fn.params[i].type.array : 1);
+        int reg = swgl_reg_alloc(p, n);
+        if (fn.params[i].name[0])
+            swgl_declare(p, fn.params[i].name, fn.params[i].type, SWGL_ST_REG, reg, nameTok->line)->readOnly =
+                fn.params[i].readOnly;
+    }
+    swgl_parse_compound(p);
+    swgl_scope_pop(p, scope);
+
+    int firstDropped = SWGL_GLSL_PERSISTENT + persistCount;
+    for (int kind = 0; kind < 3; ++kind)
+    {
+        for (int i = 0; i < p->declCount[kind]; ++i)
+        {
+            SwglGlslDecl *d = &p->decls[kind][i];
+            if (d->cache >= firstDropped)
+                d->cache = -1;
+            for (int k = 0; d->uniformRegs && k < d->info.components * d->info.arraySize; ++k)
+            {
+                if (d->uniformRegs[k] >= firstDropped)
+                    d->uniformRegs[k] = -1;
+            }
+        }
+    }
+    for (int row = 0; row < SWGL_GLSL_BUILTIN_ROWS; ++row)
+    {
+        if (p->builtinCache[row] >= firstDropped)
+            p->builtinCache[row] = -1;
+    }
+    p->codeCount = codeCount;
+    p->prologueCount = prologueCount;
+    p->persistCount = persistCount;
+    p->constCount = constCount;
+    p->regTop = regTop;
+    p->regMax = regMax;
+    p->dryRun = 0;
+    p->inMain = 0;
+    p->mainReturned = 0;
+    p->maskDepth = 0;
+}
+
+static void swgl_parse_external(SwglGlslParser *p)
+{
+    int start = p->pos;
+    swgl_accept_precision(p);
+    SwglGlslType type;
+    if (swgl_parse_type(p, &type) && swgl_peek(p, 0)->type == SWGL_TOK_IDENT && swgl_is_punct(swgl_peek(p, 1), '('))
+    {
+        swgl_parse_function(p, type);
+        return;
+    }
+    p->pos = start;
+    p->tempFloor = p->regTop;
+    p->stmtStart = p->codeCount;
+    if (!swgl_parse_declaration(p, 1))
+    {
+        const SwglGlslToken *tok = swgl_peek(p, 0);
+        swgl_error(p, tok->line, tok->text, "syntax error");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Translation unit
+
+static void swgl_declare_builtins(SwglGlslParser *p)
+{
+    static const struct
+    {
+        const char *name;
+        int value;
+    } limits[] = {
+        {"gl_MaxVertexAttribs", SWGL_GLSL_MAX_VERTEX_ATTRIBS},
+        {"gl_MaxVertexUniformVectors", SWGL_GLSL_MAX_UNIFORM_VECTORS},
+        {"gl_MaxVaryingVectors", SWGL_GLSL_MAX_VARYING_VECTORS},
+        {"gl_MaxVertexTextureImageUnits", 0},
+        {"gl_MaxCombinedTextureImageUnits", SWGL_GLSL_MAX_TEXTURE_IMAGE_UNITS},
+        {"gl_MaxTextureImageUnits", SWGL_GLSL_MAX_TEXTURE_IMAGE_UNITS},
+        {"gl_MaxFragmentUniformVectors", SWGL_GLSL_MAX_UNIFORM_VECTORS},
+        {"gl_MaxDrawBuffers", 1},
+    };
+    SwglGlslType vec4 = swgl_type(SWGL_T_FLOAT, 4, 0);
+    for (size_t i = 0; i < sizeof(limits) / sizeof(limits[0]); ++i)
+        swgl_declare(p, limits[i].name, swgl_type(SWGL_T_INT, 1, 0), SWGL_ST_CONST, 0, 0)->value[0] = (float)limits[i].value;
+    if (p->stage == SWGL_GLSL_VERTEX)
+    {
+        p->positionReg = swgl_reg_alloc(p, 4);
+        p->pointSizeReg = swgl_reg_alloc(p, 1);
+        for (int k = 0; k < 4; ++k)
+            swgl_add_global_init(p, p->positionReg + k, 0.0f);
+        swgl_add_global_init(p, p->pointSizeReg, 1.0f);
+        swgl_declare(p, "gl_Position", vec4, SWGL_ST_REG, p->positionReg, 0);
+        swgl_declare(p, "gl_PointSize", swgl_type(SWGL_T_FLOAT, 1, 0), SWGL_ST_REG, p->pointSizeReg, 0);
+        return;
+    }
+    swgl_declare(p, "gl_FragCoord", vec4, SWGL_ST_BUILTIN, SWGL_GLSL_BUILTIN_FRAGCOORD, 0)->readOnly = 1;
+    swgl_declare(p, "gl_FrontFacing", swgl_type(SWGL_T_BOOL, 1, 0), SWGL_ST_BUILTIN, SWGL_GLSL_BUILTIN_FRONTFACING, 0)
+        ->readOnly = 1;
+    swgl_declare(p, "gl_PointCoord", swgl_type(SWGL_T_FLOAT, 2, 0), SWGL_ST_BUILTIN, SWGL_GLSL_BUILTIN_POINTCOORD, 0)
+        ->readOnly = 1;
+    p->fragColorReg = swgl_reg_alloc(p, 4);
+    for (int k = 0; k < 4; ++k)
+        swgl_add_global_init(p, p->fragColorReg + k, 0.0f);
+    swgl_declare(p, "gl_FragColor", vec4, SWGL_ST_REG, p->fragColorReg, 0);
+    SwglGlslType fragData = vec4;
+    fragData.array = 1;
+    swgl_declare(p, "gl_FragData", fragData, SWGL_ST_REG, p->fragColorReg, 0);
+}
+
+// Expands main, between the global initializers and the output stores.
+static void swgl_emit_main(SwglGlslParser *p)
+{
+    if (p->mainIndex < 0)
+        swgl_error(p, swgl_peek(p, 0)->line, "main", "function is not defined");
+    for (int i = 0; i < p->globalInitCount; ++i)
+        swgl_emit(p, SWGL_GLSL_OP_MOV, p->globalInits[i].reg, swgl_const_reg(p, p->globalInits[i].value), 0, 0, 0, 0);
+    p->globalCount = p->symbolCount;
+    p->inMain = 1;
+    p->returnType = swgl_type(SWGL_T_VOID, 0, 0);
+    p->tempFloor = p->regTop;
+    p->stmtStart = p->codeCount;
+    p->pos = p->functions[p->mainIndex].bodyStart;
+    p->functions[p->mainIndex].active = 1;
+    swgl_parse_compound(p);
+    p->functions[p->mainIndex].active = 0;
+
+    if (p->stage == SWGL_GLSL_VERTEX)
+    {
+        for (int k = 0; k < 4; ++k)
+            swgl_emit(p, SWGL_GLSL_OP_STOREOUT, 0, p->positionReg + k, 0, 0, k, 0);
+        swgl_emit(p, SWGL_GLSL_OP_STOREOUT, 0, p->pointSizeReg, 0, 0, 4, 0);
+        int row = 5;
+        for (int i = 0; i < p->declCount[SWGL_GLSL_VARYING]; ++i)
+        {
+            SwglGlslDecl *d = &p->decls[SWGL_GLSL_VARYING][i];
+            d->info.offset = row;
+            for (int k = 0; k < d->info.components * d->info.arraySize; ++k)
+                swgl_emit(p, SWGL_GLSL_OP_STOREOUT, 0, d->reg + k, 0, 0, row++, 0);
+        }
+    }
+    else
+    {
+        for (int k = 0; k < 4; ++k)
+            swgl_emit(p, SWGL_GLSL_OP_STOREOUT, 0, p->fragColorReg + k, 0, 0, k, 0);
+    }
+}
+
+static int swgl_decl_used(const SwglGlslParser *p, int kind, int index)
+{
+    if (kind == SWGL_GLSL_UNIFORM)
+    {
+        for (int i = 0; i < p->prologueCount; ++i)
+        {
+            if (p->prologue[i].op == SWGL_GLSL_OP_LOADU && p->prologue[i].imm2 == index)
+                return 1;
+        }
+        for (int i = 0; i < p->codeCount; ++i)
+        {
+            if (p->code[i].op == SWGL_GLSL_OP_GATHERU && p->code[i].imm2 == index)
+                return 1;
+        }
+        return 0;
+    }
+    if (kind == SWGL_GLSL_VARYING && p->stage == SWGL_GLSL_VERTEX)
+        return 1;
+    return p->decls[kind][index].cache >= 0;
+}
+
+// Removes writes in the straight-line start of main that are overwritten
+// before being read, such as the zero-initialization of outputs.
+static void swgl_remove_dead_stores(SwglGlslParser *p)
+{
+    int prefix = 0;
+    while (prefix < p->codeCount && p->code[prefix].op < SWGL_GLSL_OP_GATHERR)
+        prefix++;
+    int kept = 0;
+    for (int i = 0; i < p->codeCount; ++i)
+    {
+        SwglGlslInstr *in = &p->code[i];
+        int dead = 0;
+        if (i < prefix && in->op <= SWGL_GLSL_OP_STORE)
+        {
+            for (int j = i + 1; j < prefix; ++j)
+            {
+                if (swgl_reads(&p->code[j], in->dst))
+                    break;
+                if ((swgl_op_fields(p->code[j].op) & SWGL_F_DST) && p->code[j].dst == in->dst)
+                {
+                    dead = 1;
+                    break;
+                }
+            }
+        }
+        if (!dead)
+            p->code[kept++] = *in;
+    }
+    // Every jump lies after the prefix, so targets move by the same amount
+    for (int i = 0; i < kept; ++i)
+    {
+        if (swgl_op_jumps(p->code[i].op))
+            p->code[i].imm -= p->codeCount - kept;
+    }
+    p->codeCount = kept;
+}
+
+static SwglGlslShader *swgl_finalize(SwglGlslParser *p)
+{
+    swgl_remove_dead_stores(p);
+    int regCount = p->regMax + p->persistCount;
+    if (regCount > SWGL_GLSL_MAX_REGISTERS)
+        swgl_error(p, 0, NULL, "shader is too complex");
+    SwglGlslShader *shader = (SwglGlslShader *)calloc(1, sizeof(SwglGlslShader));
+    if (!shader)
+        swgl_error(p, 0, NULL, "out of memory");
+    shader->stage = p->stage;
+    shader->regCount = regCount > 0 ? regCount : 1;
+    shader->codeCount = p->prologueCount + p->codeCount;
+    shader->constantCount = p->constCount;
+    shader->code = (SwglGlslInstr *)malloc((size_t)(shader->codeCount ? shader->codeCount : 1) * sizeof(SwglGlslInstr));
+    shader->constants = (SwglGlslConstant *)malloc((size_t)(p->constCount ? p->constCount : 1) * sizeof(SwglGlslConstant));
+    for (int kind = 0; kind < 3; ++kind)
+        shader->vars[kind] = (SwglGlslVariable *)malloc((size_t)(p->declCount[kind] ? p->declCount[kind] : 1) *
+                                                        sizeof(SwglGlslVariable));
+    int inputKind = p->stage == SWGL_GLSL_VERTEX ? SWGL_GLSL_ATTRIBUTE : SWGL_GLSL_VARYING;
+    int *remap[3] = {NULL, NULL, NULL};
+    int ok = shader->code && shader->constants && shader->vars[0] && shader->vars[1] && shader->vars[2];
+    for (int kind = 0; kind < 3; ++kind)
+    {
+        remap[kind] = (int *)malloc((size_t)(p->declCount[kind] ? p->declCount[kind] : 1) * sizeof(int));
+        ok = ok && remap[kind];
+    }
+    if (!ok)
+    {
+        for (int kind = 0; kind < 3; ++kind)
+            free(remap[kind]);
+        swgl_glsl_free(shader);
+        swgl_error(p, 0, NULL, "out of memory");
+    }
+
+    // Reflection lists only what is referenced; uniforms are packed and
+    // inputs get consecutive rows in declaration order
+    for (int kind = 0; kind < 3; ++kind)
+    {
+        int offset = kind == SWGL_GLSL_VARYING && p->stage == SWGL_GLSL_VERTEX ? 5 : 0;
+        for (int i = 0; i < p->declCount[kind]; ++i)
+        {
+            remap[kind][i] = -1;
+            if (!swgl_decl_used(p, kind, i))
+                continue;
+            SwglGlslVariable *var = &shader->vars[kind][shader->varCount[kind]];
+            *var = p->decls[kind][i].info;
+            var->offset = offset;
+            offset += var->components * var->arraySize;
+            remap[kind][i] = shader->varCount[kind]++;
+        }
+        if (kind == SWGL_GLSL_UNIFORM)
+            shader->uniformFloats = offset;
+        else if (kind == inputKind)
+            shader->inputRows = offset;
+    }
+    shader->outputRows = p->stage == SWGL_GLSL_VERTEX ? 5 : 4;
+    if (p->stage == SWGL_GLSL_VERTEX)
+    {
+        for (int i = 0; i < shader->varCount[SWGL_GLSL_VARYING]; ++i)
+            shader->outputRows += shader->vars[SWGL_GLSL_VARYING][i].components * shader->vars[SWGL_GLSL_VARYING][i].arraySize;
+    }
+
+    // Prologue then body; persistent registers go after the temporaries
+    if (p->prologueCount)
+        memcpy(shader->code, p->prologue, (size_t)p->prologueCount * sizeof(SwglGlslInstr));
+    if (p->codeCount)
+        memcpy(shader->code + p->prologueCount, p->code, (size_t)p->codeCount * sizeof(SwglGlslInstr));
+    int base = p->regMax - SWGL_GLSL_PERSISTENT;
+#define SWGL_GLSL_REMAP(r) ((r) >= SWGL_GLSL_PERSISTENT ? (uint16_t)((r) + base) : (r))
+    for (int i = 0; i < shader->codeCount; ++i)
+    {
+        SwglGlslInstr *in = &shader->code[i];
+        int fields = swgl_op_fields(in->op);
+        if (fields & SWGL_F_DST)
+            in->dst = SWGL_GLSL_REMAP(in->dst);
+        if (fields & SWGL_F_A)
+            in->a = SWGL_GLSL_REMAP(in->a);
+        if (fields & SWGL_F_B)
+            in->b = SWGL_GLSL_REMAP(in->b);
+        if (fields & SWGL_F_C)
+            in->c = SWGL_GLSL_REMAP(in->c);
+        if (i >= p->prologueCount && swgl_op_jumps(in->op))
+            in->imm += p->prologueCount;
+        if (in->op == SWGL_GLSL_OP_LOADU || in->op == SWGL_GLSL_OP_GATHERU)
+        {
+            int index = remap[SWGL_GLSL_UNIFORM][in->imm2];
+            in->imm += shader->vars[SWGL_GLSL_UNIFORM][index].offset;
+            in->imm2 = index;
+        }
+        else if (in->op == SWGL_GLSL_OP_LOADIN)
+            in->imm = shader->vars[inputKind][remap[inputKind][in->imm]].offset + in->imm2;
+        else if (in->op == SWGL_GLSL_OP_LOADB)
+        {
+            shader->flags |= in->imm < SWGL_GLSL_BUILTIN_POINTCOORD ? SWGL_GLSL_USES_FRAGCOORD
+                             : in->imm < SWGL_GLSL_BUILTIN_FRONTFACING ? SWGL_GLSL_USES_POINTCOORD
+                                                                       : SWGL_GLSL_USES_FRONTFACING;
+        }
+        else if (in->op == SWGL_GLSL_OP_DISCARD)
+            shader->flags |= SWGL_GLSL_USES_DISCARD;
+    }
+    for (int i = 0; i < p->constCount; ++i)
+    {
+        shader->constants[i].reg = SWGL_GLSL_REMAP(p->consts[i].reg);
+        shader->constants[i].value = p->consts[i].value;
+    }
+#undef SWGL_GLSL_REMAP
+    if (p->pointSizeWritten)
+        shader->flags |= SWGL_GLSL_WRITES_POINTSIZE;
+    shader->serial = swgl_glsl_next_serial();
+    for (int kind = 0; kind < 3; ++kind)
+        free(remap[kind]);
+    return shader;
+}
+
+// ---------------------------------------------------------------------------
+// Public interface
+
+static void swgl_parser_free(SwglGlslParser *p)
+{
+    free(p->text);
+    free(p->tokens.items);
+    free(p->macroTokens.items);
+    free(p->exprTokens.items);
+    free(p->macros);
+    free(p->symbols);
+    free(p->functions);
+    for (int kind = 0; kind < 3; ++kind)
+    {
+        for (int i = 0; i < p->declCount[kind]; ++i)
+            free(p->decls[kind][i].uniformRegs);
+        free(p->decls[kind]);
+    }
+    free(p->code);
+    free(p->prologue);
+    free(p->consts);
+    free(p->globalInits);
+    free(p);
+}
+
+// Errors longjmp back here with the partial state left for swgl_parser_free.
+static SwglGlslShader *swgl_compile_unit(SwglGlslParser *p, const char *source)
+{
+    if (setjmp(p->fail))
+        return NULL;
+    swgl_pp_run(p, source);
+    swgl_declare_builtins(p);
+    while (swgl_peek(p, 0)->type != SWGL_TOK_EOF)
+        swgl_parse_external(p);
+    swgl_emit_main(p);
+    return swgl_finalize(p);
+}
+
+SwglGlslShader *swgl_glsl_compile(SwglGlslStage stage, const char *source, char *log, size_t logSize)
+{
+    if (log && logSize)
+        log[0] = '\0';
+    SwglGlslParser *p = (SwglGlslParser *)calloc(1, sizeof(SwglGlslParser));
+    if (!p)
+    {
+        if (log && logSize)
+            snprintf(log, logSize, "ERROR: out of memory\n");
+        return NULL;
+    }
+    p->stage = stage;
+    p->log = log;
+    p->logSize = logSize;
+    p->mainIndex = -1;
+    p->positionReg = p->pointSizeReg = p->fragColorReg = -1;
+    for (int row = 0; row < SWGL_GLSL_BUILTIN_ROWS; ++row)
+        p->builtinCache[row] = -1;
+
+    SwglGlslShader *shader = swgl_compile_unit(p, source ? source : "");
+    swgl_parser_free(p);
+    return shader;
+}
+
+SwglGlslShader *swgl_glsl_clone(const SwglGlslShader *shader)
+{
+    SwglGlslShader *copy = (SwglGlslShader *)calloc(1, sizeof(SwglGlslShader));
+    if (!copy)
+        return NULL;
+    *copy = *shader;
+    copy->code = (SwglGlslInstr *)malloc((size_t)(shader->codeCount ? shader->codeCount : 1) * sizeof(SwglGlslInstr));
+    copy->constants = (SwglGlslConstant *)malloc((size_t)(shader->constantCount ? shader->constantCount : 1) *
+                                                 sizeof(SwglGlslConstant));
+    int ok = copy->code && copy->constants;
+    for (int kind = 0; kind < 3; ++kind)
+    {
+        copy->vars[kind] = (SwglGlslVariable *)malloc((size_t)(shader->varCount[kind] ? shader->varCount[kind] : 1) *
+                                                      sizeof(SwglGlslVariable));
+        ok = ok && copy->vars[kind];
+    }
+    if (!ok)
+    {
+        swgl_glsl_free(copy);
+        return NULL;
+    }
+    memcpy(copy->code, shader->code, (size_t)shader->codeCount * sizeof(SwglGlslInstr));
+    memcpy(copy->constants, shader->constants, (size_t)shader->constantCount * sizeof(SwglGlslConstant));
+    for (int kind = 0; kind < 3; ++kind)
+        memcpy(copy->vars[kind], shader->vars[kind], (size_t)shader->varCount[kind] * sizeof(SwglGlslVariable));
+    return copy;
+}
+
+void swgl_glsl_free(SwglGlslShader *shader)
+{
+    if (!shader)
+        return;
+    free(shader->code);
+    free(shader->constants);
+    for (int kind = 0; kind < 3; ++kind)
+        free(shader->vars[kind]);
+    free(shader);
+}
+
+SwglGlslStage swgl_glsl_stage(const SwglGlslShader *shader)
+{
+    return shader->stage;
+}
+
+unsigned swgl_glsl_flags(const SwglGlslShader *shader)
+{
+    return shader->flags;
+}
+
+int swgl_glsl_instruction_count(const SwglGlslShader *shader)
+{
+    return shader->codeCount;
+}
+
+int swgl_glsl_register_count(const SwglGlslShader *shader)
+{
+    return shader->regCount;
+}
+
+int swgl_glsl_variable_count(const SwglGlslShader *shader, SwglGlslVariableKind kind)
+{
+    return shader->varCount[kind];
+}
+
+const SwglGlslVariable *swgl_glsl_variable(const SwglGlslShader *shader, SwglGlslVariableKind kind, int index)
+{
+    return index >= 0 && index < shader->varCount[kind] ? &shader->vars[kind][index] : NULL;
+}
+
+int swgl_glsl_uniform_floats(const SwglGlslShader *shader)
+{
+    return shader->uniformFloats;
+}
+
+void swgl_glsl_set_uniform_offset(SwglGlslShader *shader, int index, int offset)
+{
+    if (index < 0 || index >= shader->varCount[SWGL_GLSL_UNIFORM])
+        return;
+    int delta = offset - shader->vars[SWGL_GLSL_UNIFORM][index].offset;
+    shader->vars[SWGL_GLSL_UNIFORM][index].offset = offset;
+    for (int i = 0; i < shader->codeCount; ++i)
+    {
+        SwglGlslInstr *in = &shader->code[i];
+        if ((in->op == SWGL_GLSL_OP_LOADU || in->op == SWGL_GLSL_OP_GATHERU) && in->imm2 == index)
+            in->imm += delta;
+    }
+}
+
+int swgl_glsl_input_rows(const SwglGlslShader *shader)
+{
+    return shader->inputRows;
+}
+
+int swgl_glsl_output_rows(const SwglGlslShader *shader)
+{
+    return shader->outputRows;
+}
@@ -0,0 +1,311 @@
+// swgl_internal.h
+// Shared state of the software renderer: GL objects, the per-context draw
+// state, the deferred tile binning structures and the shader backend hooks.
+#ifndef SWGL_INTERNAL_H
+#define SWGL_INTERNAL_H
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "swgl/swgl.h"
+
+#define SWGL_TILE_SIZE 64
+#define SWGL_LANES 8
+#define SWGL_MAX_ATTRIBS 16
+#define SWGL_MAX_VARYINGS 32 // scalar components, i.e. 8 vec4 varyings
+#define SWGL_MAX_UNIFORM_VECTORS 256
+#define SWGL_MAX_POINT_SIZE 256.0f
+#define SWGL_MAX_TEXTURE_SIZE 4096
+#define SWGL_NAME_LENGTH 64
+
+// Clip position (4), point size (1), then the program's varyings
+#define SWGL_VERTEX_HEADER 5
+
+// ---------------------------------------------------------------------------
+// Thread pool with per-worker deques; idle workers steal from their peers.
+
+typedef struct SwglThreadPool SwglThreadPool;
+typedef void (*SwglTaskFn)(void *userData, int taskIndex, int workerIndex);
+
+SwglThreadPool *swgl_threadpool_create(int threadCount);
+void swgl_threadpool_destroy(SwglThreadPool *pool);
+int swgl_threadpool_size(const SwglThreadPool *pool);
+// Runs fn for every task index in [0, taskCount) and returns when all are done.
+// The calling thread participates as worker 0.
+void swgl_threadpool_run(SwglThreadPool *pool, SwglTaskFn fn, void *userData, int taskCount);
+unsigned long long swgl_threadpool_steals(const SwglThreadPool *pool);
+
+// ---------------------------------------------------------------------------
+// GL objects
+
+typedef struct SwglBuffer
+{
+    unsigned char *data;
+    GLsizeiptr size;
+    GLenum usage;
+} SwglBuffer;
+
+enum
+{
+    SWGL_OBJECT_SHADER = 1,
+    SWGL_OBJECT_PROGRAM
+};
+
+typedef struct SwglShader
+{
+    int kind; // SWGL_OBJECT_SHADER
+    GLenum type;
+    char *source;
+    char *infoLog;
+    int compiled;
+    int deletePending;
+    int attachCount;
+    void *impl; // owned by the shader backend
+} SwglShader;
+
+typedef struct SwglAttribInfo
+{
+    char name[SWGL_NAME_LENGTH];
+    GLenum type;
+    GLint location;
+} SwglAttribInfo;
+
+typedef struct SwglUniformInfo
+{
+    char name[SWGL_NAME_LENGTH];
+    GLenum type;
+    GLint size;       // array length, 1 for non-arrays
+    GLint components; // floats per element
+    GLint offset;     // first float in the program's uniform storage
+    GLint location;   // location of element 0; element i is location + i
+} SwglUniformInfo;
+
+typedef struct SwglProgram
+{
+    int kind; // SWGL_OBJECT_PROGRAM
+    GLuint vertexShader;
+    GLuint fragmentShader;
+    int linked;
+    int validated;
+    int deletePending;
+    char *infoLog;
+
+    char *boundAttribNames[SWGL_MAX_ATTRIBS];
+
+    SwglAttribInfo attribs[SWGL_MAX_ATTRIBS];
+    int attribCount;
+    int attribSlots; // highest used location + 1
+
+    SwglUniformInfo *uniforms;
+    int uniformCount;
+    int uniformCapacity;
+    float *uniformData;
+    int uniformFloats;
+    int locationCount;
+
+    int varyingCount; // scalar varyings written by the vertex stage
+    void *impl;       // owned by the shader backend
+} SwglProgram;
+
+// Name table shared by buffers, shader objects, textures and framebuffers.
+typedef struct SwglNameTable
+{
+    void **slots;
+    GLuint capacity;
+    GLuint next;
+} SwglNameTable;
+
+GLuint swgl_names_alloc(SwglNameTable *table, void *object);
+void *swgl_names_get(const SwglNameTable *table, GLuint name);
+void swgl_names_set(SwglNameTable *table, GLuint name, void *object);
+void swgl_names_release(SwglNameTable *table, GLuint name);
+void swgl_names_free(SwglNameTable *table);
+
+// Placeholder stored for objects the renderer tracks by name only.
+extern char swgl_placeholder_object;
+
+// ---------------------------------------------------------------------------
+// Shader backend (swgl_shader.c)
+
+typedef struct SwglFragments
+{
+    unsigned mask; // active lanes
+    int frontFacing;
+    float fragCoord[4][SWGL_LANES];
+    float pointCoord[2][SWGL_LANES];
+    float varyings[SWGL_MAX_VARYINGS][SWGL_LANES];
+} SwglFragments;
+
+int swgl_shader_compile(SwglShader *shader);
+void swgl_shader_release(SwglShader *shader);
+int swgl_program_link(SwglProgram *program, SwglShader *vertexShader, SwglShader *fragmentShader);
+void swgl_program_release(SwglProgram *program);
+// attribs: count vertices of program->attribSlots vec4s each.
+// out: count vertices of SWGL_VERTEX_HEADER + program->varyingCount floats each.
+void swgl_program_shade_vertices(const SwglProgram *program, const float *uniforms,
+                                 const float *attribs, int count, float *out);
+// Returns the mask of lanes that were not discarded.
+unsigned swgl_program_shade_fragments(const SwglProgram *program, const float *uniforms,
+                                      const SwglFragments *in, float color[4][SWGL_LANES]);
+
+// Reflection helpers used by the backend while linking (swgl_program.c).
+int swgl_program_add_attrib(SwglProgram *program, const char *name, GLenum type);
+int swgl_program_add_uniform(SwglProgram *program, const char *name, GLenum type, GLint size);
+void swgl_program_set_info_log(SwglProgram *program, const char *message);
+void swgl_shader_set_info_log(SwglShader *shader, const char *message);
+
+// ---------------------------------------------------------------------------
+// Deferred rendering: draws are recorded with a snapshot of their state,
+// binned into screen tiles and rasterized at flush time.
+
+enum
+{
+    SWGL_PRIM_CLEAR,
+    SWGL_PRIM_TRIANGLE,
+    SWGL_PRIM_POINT
+};
+
+typedef struct SwglDrawState
+{
+    const SwglProgram *program;
+    size_t uniformOffset; // into SwglFrame.floats
+    int varyingCount;
+    int blendEnabled;
+    GLenum blendEquationRGB;
+    GLenum blendEquationAlpha;
+    GLenum blendSrcRGB;
+    GLenum blendDstRGB;
+    GLenum blendSrcAlpha;
+    GLenum blendDstAlpha;
+    float blendColor[4];
+    unsigned char colorMask[4];
+    int clip[4]; // x0, y0, x1, y1 (exclusive)
+} SwglDrawState;
+
+typedef struct SwglPrim
+{
+    int type;
+    int state;
+    int bounds[4]; // x0, y0, x1, y1 (exclusive), already clipped
+    int frontFacing;
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    unsigned topLeft; // bit k set when edge k owns the pixels on it
+    float invArea2;
+    float z[3];
+    float invW[3];
+    float pointX, pointY, pointSize;
+    size_t varyingOffset; // into SwglFrame.floats
+    uint32_t clearColor;
+} SwglPrim;
+
+typedef struct SwglBin
+{
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} SwglBin;
+
+typedef struct SwglFrame
+{
+    SwglPrim *prims;
+    size_t primCount;
+    size_t primCapacity;
+    SwglDrawState *states;
+    size_t stateCount;
+    size_t stateCapacity;
+    float *floats;
+    size_t floatCount;
+    size_t floatCapacity;
+    SwglBin *bins;
+    int tilesX;
+    int tilesY;
+    int *activeTiles;
+} SwglFrame;
+
+typedef struct SwglAttribArray
+{
+    int enabled;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+    const void *pointer;
+    GLuint buffer;
+    float current[4];
+} SwglAttribArray;
+
+typedef struct SwglContext
+{
+    int width;
+    int height;
+    uint32_t *color; // RGBA8, bottom row first
+
+    GLenum error;
+
+    SwglNameTable buffers;
+    SwglNameTable objects; // shaders and programs share one namespace
+    SwglNameTable textures;
+    SwglNameTable framebuffers;
+    SwglNameTable renderbuffers;
+
+    GLuint arrayBuffer;
+    GLuint elementArrayBuffer;
+    GLuint framebuffer;
+    GLuint renderbuffer;
+    GLuint boundTexture;
+    GLenum activeTexture;
+    GLuint currentProgram;
+    SwglAttribArray attribs[SWGL_MAX_ATTRIBS];
+
+    float clearColor[4];
+    GLint viewport[4];
+    GLint scissor[4];
+    int scissorTest;
+    int blendEnabled;
+    GLenum blendEquationRGB;
+    GLenum blendEquationAlpha;
+    GLenum blendSrcRGB;
+    GLenum blendDstRGB;
+    GLenum blendSrcAlpha;
+    GLenum blendDstAlpha;
+    float blendColor[4];
+    unsigned char colorMask[4];
+    int cullEnabled;
+    GLenum cullFace;
+    GLenum frontFace;
+    float depthRange[2];
+    GLint packAlignment;
+    GLint unpackAlignment;
+    float lineWidth;
+
+    SwglFrame frame;
+    float *vertexScratch;
+    size_t vertexScratchCapacity;
+    int warnedLines;
+} SwglContext;
+
+SwglContext *swgl_context_create(int width, int height);
+void swgl_context_destroy(SwglContext *ctx);
+void swgl_context_make_current(SwglContext *ctx);
+SwglContext *swgl_context_current(void);
+void swgl_set_error(SwglContext *ctx, GLenum error);
+
+// Entry points are no-ops without a current context, as with a real driver.
+#define SWGL_GET_CONTEXT(...)                    \
+    SwglContext *ctx = swgl_context_current(); \
+    if (!ctx)                                  \
+    return __VA_ARGS__
+
+// swgl_raster.c
+void swgl_frame_init(SwglFrame *frame, int width, int height);
+void swgl_frame_free(SwglFrame *frame);
+void swgl_raster_clear(SwglContext *ctx, GLbitfield mask);
+void swgl_raster_draw(SwglContext *ctx, GLenum mode, GLint first, GLsizei count,
+                      GLenum indexType, const void *indices);
+void swgl_raster_flush(SwglContext *ctx);
+void swgl_raster_count_frame(void);
+
+#endif // SWGL_INTERNAL_H
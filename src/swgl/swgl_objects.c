@@ -0,0 +1,478 @@
+// swgl_objects.c
+// Textures, framebuffers and renderbuffers. The renderer only draws into the
+// default framebuffer and does not sample textures, so these objects are
+// tracked by name and their contents are validated and dropped.
+#include "swgl_internal.h"
+
+#include <stddef.h>
+
+static void swgl_gen_names(SwglContext *ctx, SwglNameTable *table, GLsizei n, GLuint *names)
+{
+    if (n < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        names[i] = swgl_names_alloc(table, &swgl_placeholder_object);
+        if (!names[i])
+        {
+            swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+}
+
+// Deletes names and resets the binding when it refers to one of them.
+static void swgl_delete_names(SwglContext *ctx, SwglNameTable *table, GLsizei n, const GLuint *names, GLuint *binding)
+{
+    if (n < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (names[i] && *binding == names[i])
+            *binding = 0;
+        swgl_names_release(table, names[i]);
+    }
+}
+
+// Binding an unused name creates the object, as in the ES2 specification.
+static void swgl_bind_name(SwglNameTable *table, GLuint name, GLuint *binding)
+{
+    if (name && !swgl_names_get(table, name))
+        swgl_names_set(table, name, &swgl_placeholder_object);
+    *binding = name;
+}
+
+static int swgl_is_texture_target(GLenum target)
+{
+    return target == GL_TEXTURE_2D || target == GL_TEXTURE_CUBE_MAP;
+}
+
+static int swgl_is_image_target(GLenum target)
+{
+    return target == GL_TEXTURE_2D || (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z);
+}
+
+static int swgl_valid_image_size(SwglContext *ctx, GLenum target, GLint level, GLsizei width, GLsizei height, GLint border)
+{
+    if (!swgl_is_image_target(target))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return 0;
+    }
+    if (level < 0 || width < 0 || height < 0 || border != 0 ||
+        (width >> level) > SWGL_MAX_TEXTURE_SIZE || (height >> level) > SWGL_MAX_TEXTURE_SIZE)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return 0;
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Textures
+
+GL_APICALL void GL_APIENTRY glActiveTexture(GLenum texture)
+{
+    SWGL_GET_CONTEXT();
+    if (texture < GL_TEXTURE0 || texture > GL_TEXTURE7)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    ctx->activeTexture = texture;
+}
+
+GL_APICALL void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures)
+{
+    SWGL_GET_CONTEXT();
+    swgl_gen_names(ctx, &ctx->textures, n, textures);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures)
+{
+    SWGL_GET_CONTEXT();
+    swgl_delete_names(ctx, &ctx->textures, n, textures, &ctx->boundTexture);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsTexture(GLuint texture)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    return swgl_names_get(&ctx->textures, texture) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
+{
+    SWGL_GET_CONTEXT();
+    if (!swgl_is_texture_target(target))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    swgl_bind_name(&ctx->textures, texture, &ctx->boundTexture);
+}
+
+GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+    SWGL_GET_CONTEXT();
+    (void)pixels;
+    if (!swgl_valid_image_size(ctx, target, level, width, height, border))
+        return;
+    if ((GLenum)internalformat != format)
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+    (void)type;
+}
+
+GL_APICALL void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
+{
+    SWGL_GET_CONTEXT();
+    (void)format;
+    (void)type;
+    (void)pixels;
+    if (!swgl_valid_image_size(ctx, target, level, width, height, 0))
+        return;
+    if (xoffset < 0 || yoffset < 0)
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+}
+
+GL_APICALL void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data)
+{
+    SWGL_GET_CONTEXT();
+    (void)imageSize;
+    (void)data;
+    if (!swgl_valid_image_size(ctx, target, level, width, height, border))
+        return;
+    (void)internalformat;
+    swgl_set_error(ctx, GL_INVALID_ENUM); // GL_NUM_COMPRESSED_TEXTURE_FORMATS is 0
+}
+
+GL_APICALL void GL_APIENTRY glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data)
+{
+    SWGL_GET_CONTEXT();
+    (void)target;
+    (void)level;
+    (void)xoffset;
+    (void)yoffset;
+    (void)width;
+    (void)height;
+    (void)format;
+    (void)imageSize;
+    (void)data;
+    swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
+{
+    SWGL_GET_CONTEXT();
+    (void)internalformat;
+    (void)x;
+    (void)y;
+    swgl_valid_image_size(ctx, target, level, width, height, border);
+}
+
+GL_APICALL void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    SWGL_GET_CONTEXT();
+    (void)xoffset;
+    (void)yoffset;
+    (void)x;
+    (void)y;
+    swgl_valid_image_size(ctx, target, level, width, height, 0);
+}
+
+GL_APICALL void GL_APIENTRY glGenerateMipmap(GLenum target)
+{
+    SWGL_GET_CONTEXT();
+    if (!swgl_is_texture_target(target))
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+    glTexParameteri(target, pname, (GLint)param);
+}
+
+GL_APICALL void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const GLfloat *params)
+{
+    glTexParameteri(target, pname, (GLint)params[0]);
+}
+
+GL_APICALL void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+    SWGL_GET_CONTEXT();
+    (void)param;
+    if (!swgl_is_texture_target(target))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    switch (pname)
+    {
+    case GL_TEXTURE_MIN_FILTER:
+    case GL_TEXTURE_MAG_FILTER:
+    case GL_TEXTURE_WRAP_S:
+    case GL_TEXTURE_WRAP_T:
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLint *params)
+{
+    glTexParameteri(target, pname, params[0]);
+}
+
+GL_APICALL void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    if (!swgl_is_texture_target(target))
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    // Parameters are not stored; report the initial state
+    switch (pname)
+    {
+    case GL_TEXTURE_MIN_FILTER:
+        *params = GL_NEAREST_MIPMAP_LINEAR;
+        break;
+    case GL_TEXTURE_MAG_FILTER:
+        *params = GL_LINEAR;
+        break;
+    case GL_TEXTURE_WRAP_S:
+    case GL_TEXTURE_WRAP_T:
+        *params = GL_REPEAT;
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetTexParameterfv(GLenum target, GLenum pname, GLfloat *params)
+{
+    GLint value = 0;
+    glGetTexParameteriv(target, pname, &value);
+    *params = (GLfloat)value;
+}
+
+// ---------------------------------------------------------------------------
+// Framebuffers and renderbuffers
+
+GL_APICALL void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint *framebuffers)
+{
+    SWGL_GET_CONTEXT();
+    swgl_gen_names(ctx, &ctx->framebuffers, n, framebuffers);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+{
+    SWGL_GET_CONTEXT();
+    swgl_delete_names(ctx, &ctx->framebuffers, n, framebuffers, &ctx->framebuffer);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsFramebuffer(GLuint framebuffer)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    return swgl_names_get(&ctx->framebuffers, framebuffer) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    SWGL_GET_CONTEXT();
+    if (target != GL_FRAMEBUFFER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    swgl_bind_name(&ctx->framebuffers, framebuffer, &ctx->framebuffer);
+}
+
+GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum target)
+{
+    SWGL_GET_CONTEXT(0);
+    if (target != GL_FRAMEBUFFER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return 0;
+    }
+    // Callers are expected to fall back to the default framebuffer
+    return ctx->framebuffer ? GL_FRAMEBUFFER_UNSUPPORTED : GL_FRAMEBUFFER_COMPLETE;
+}
+
+GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+    SWGL_GET_CONTEXT();
+    (void)attachment;
+    (void)textarget;
+    (void)level;
+    if (target != GL_FRAMEBUFFER)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+    else if (!ctx->framebuffer || (texture && !swgl_names_get(&ctx->textures, texture)))
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+}
+
+GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+    SWGL_GET_CONTEXT();
+    (void)attachment;
+    if (target != GL_FRAMEBUFFER || renderbuffertarget != GL_RENDERBUFFER)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+    else if (!ctx->framebuffer || (renderbuffer && !swgl_names_get(&ctx->renderbuffers, renderbuffer)))
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+}
+
+GL_APICALL void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    (void)attachment;
+    if (target != GL_FRAMEBUFFER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (pname == GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE)
+        *params = GL_NONE;
+    else
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glGenRenderbuffers(GLsizei n, GLuint *renderbuffers)
+{
+    SWGL_GET_CONTEXT();
+    swgl_gen_names(ctx, &ctx->renderbuffers, n, renderbuffers);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers)
+{
+    SWGL_GET_CONTEXT();
+    swgl_delete_names(ctx, &ctx->renderbuffers, n, renderbuffers, &ctx->renderbuffer);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsRenderbuffer(GLuint renderbuffer)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    return swgl_names_get(&ctx->renderbuffers, renderbuffer) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+    SWGL_GET_CONTEXT();
+    if (target != GL_RENDERBUFFER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    swgl_bind_name(&ctx->renderbuffers, renderbuffer, &ctx->renderbuffer);
+}
+
+GL_APICALL void GL_APIENTRY glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+    SWGL_GET_CONTEXT();
+    (void)internalformat;
+    if (target != GL_RENDERBUFFER)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+    else if (width < 0 || height < 0 || width > SWGL_MAX_TEXTURE_SIZE || height > SWGL_MAX_TEXTURE_SIZE)
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+    else if (!ctx->renderbuffer)
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+}
+
+GL_APICALL void GL_APIENTRY glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    (void)pname;
+    if (target != GL_RENDERBUFFER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    *params = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Depth, stencil and multisample state. The default framebuffer has neither
+// a depth nor a stencil buffer, so these calls only validate their arguments.
+
+GL_APICALL void GL_APIENTRY glClearDepthf(GLfloat d)
+{
+    (void)d;
+}
+
+GL_APICALL void GL_APIENTRY glClearStencil(GLint s)
+{
+    (void)s;
+}
+
+GL_APICALL void GL_APIENTRY glDepthMask(GLboolean flag)
+{
+    (void)flag;
+}
+
+GL_APICALL void GL_APIENTRY glDepthFunc(GLenum func)
+{
+    SWGL_GET_CONTEXT();
+    if (func < GL_NEVER || func > GL_ALWAYS)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glPolygonOffset(GLfloat factor, GLfloat units)
+{
+    (void)factor;
+    (void)units;
+}
+
+GL_APICALL void GL_APIENTRY glSampleCoverage(GLfloat value, GLboolean invert)
+{
+    (void)value;
+    (void)invert;
+}
+
+GL_APICALL void GL_APIENTRY glStencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+    glStencilFuncSeparate(GL_FRONT_AND_BACK, func, ref, mask);
+}
+
+GL_APICALL void GL_APIENTRY glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
+{
+    SWGL_GET_CONTEXT();
+    (void)ref;
+    (void)mask;
+    if ((face != GL_FRONT && face != GL_BACK && face != GL_FRONT_AND_BACK) || func < GL_NEVER || func > GL_ALWAYS)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glStencilMask(GLuint mask)
+{
+    (void)mask;
+}
+
+GL_APICALL void GL_APIENTRY glStencilMaskSeparate(GLenum face, GLuint mask)
+{
+    SWGL_GET_CONTEXT();
+    (void)mask;
+    if (face != GL_FRONT && face != GL_BACK && face != GL_FRONT_AND_BACK)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
+
+GL_APICALL void GL_APIENTRY glStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+    glStencilOpSeparate(GL_FRONT_AND_BACK, fail, zfail, zpass);
+}
+
+GL_APICALL void GL_APIENTRY glStencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass)
+{
+    SWGL_GET_CONTEXT();
+    (void)sfail;
+    (void)dpfail;
+    (void)dppass;
+    if (face != GL_FRONT && face != GL_BACK && face != GL_FRONT_AND_BACK)
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+}
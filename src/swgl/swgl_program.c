@@ -0,0 +1,942 @@
+// swgl_program.c
+// Shader and program objects, attribute/uniform reflection and uniform
+// uploads. Compilation and execution are delegated to swgl_shader.c.
+#include "swgl_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *swgl_strdup(const char *text)
+{
+    size_t length = strlen(text) + 1;
+    char *copy = (char *)malloc(length);
+    if (copy)
+        memcpy(copy, text, length);
+    return copy;
+}
+
+static void swgl_copy_string(const char *text, GLsizei bufSize, GLsizei *length, GLchar *out)
+{
+    GLsizei n = 0;
+    if (text && out && bufSize > 0)
+    {
+        n = (GLsizei)strlen(text);
+        if (n > bufSize - 1)
+            n = bufSize - 1;
+        memcpy(out, text, (size_t)n);
+        out[n] = '\0';
+    }
+    if (length)
+        *length = n;
+}
+
+void swgl_shader_set_info_log(SwglShader *shader, const char *message)
+{
+    free(shader->infoLog);
+    shader->infoLog = message ? swgl_strdup(message) : NULL;
+}
+
+void swgl_program_set_info_log(SwglProgram *program, const char *message)
+{
+    free(program->infoLog);
+    program->infoLog = message ? swgl_strdup(message) : NULL;
+}
+
+static SwglShader *swgl_get_shader(SwglContext *ctx, GLuint name)
+{
+    void *object = swgl_names_get(&ctx->objects, name);
+    if (!object)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return NULL;
+    }
+    if (*(int *)object != SWGL_OBJECT_SHADER)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return NULL;
+    }
+    return (SwglShader *)object;
+}
+
+static SwglProgram *swgl_get_program(SwglContext *ctx, GLuint name)
+{
+    void *object = swgl_names_get(&ctx->objects, name);
+    if (!object)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return NULL;
+    }
+    if (*(int *)object != SWGL_OBJECT_PROGRAM)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return NULL;
+    }
+    return (SwglProgram *)object;
+}
+
+static void swgl_destroy_shader(SwglContext *ctx, GLuint name, SwglShader *shader)
+{
+    swgl_names_release(&ctx->objects, name);
+    swgl_shader_release(shader);
+    free(shader->source);
+    free(shader->infoLog);
+    free(shader);
+}
+
+static void swgl_detach(SwglContext *ctx, GLuint name)
+{
+    SwglShader *shader = (SwglShader *)swgl_names_get(&ctx->objects, name);
+    if (!shader || shader->kind != SWGL_OBJECT_SHADER)
+        return;
+    shader->attachCount--;
+    if (shader->deletePending && shader->attachCount <= 0)
+        swgl_destroy_shader(ctx, name, shader);
+}
+
+static void swgl_clear_reflection(SwglProgram *program)
+{
+    swgl_program_release(program);
+    program->linked = 0;
+    program->validated = 0;
+    program->attribCount = 0;
+    program->attribSlots = 0;
+    program->uniformCount = 0;
+    program->uniformFloats = 0;
+    program->locationCount = 0;
+    program->varyingCount = 0;
+    free(program->uniformData);
+    program->uniformData = NULL;
+}
+
+static void swgl_destroy_program(SwglContext *ctx, GLuint name, SwglProgram *program)
+{
+    swgl_names_release(&ctx->objects, name);
+    swgl_clear_reflection(program);
+    swgl_detach(ctx, program->vertexShader);
+    swgl_detach(ctx, program->fragmentShader);
+    for (int i = 0; i < SWGL_MAX_ATTRIBS; ++i)
+        free(program->boundAttribNames[i]);
+    free(program->uniforms);
+    free(program->infoLog);
+    free(program);
+}
+
+// ---------------------------------------------------------------------------
+// Reflection helpers for the shader backend
+
+static int swgl_type_components(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:
+        return 2;
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:
+        return 3;
+    case GL_FLOAT_VEC4:
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+    case GL_FLOAT_MAT2:
+        return 4;
+    case GL_FLOAT_MAT3:
+        return 9;
+    case GL_FLOAT_MAT4:
+        return 16;
+    default:
+        return 1;
+    }
+}
+
+static int swgl_attrib_slots(GLenum type)
+{
+    return type == GL_FLOAT_MAT4 ? 4 : (type == GL_FLOAT_MAT3 ? 3 : (type == GL_FLOAT_MAT2 ? 2 : 1));
+}
+
+int swgl_program_add_attrib(SwglProgram *program, const char *name, GLenum type)
+{
+    if (program->attribCount >= SWGL_MAX_ATTRIBS)
+        return -1;
+    int location = -1;
+    for (int i = 0; i < SWGL_MAX_ATTRIBS; ++i)
+    {
+        if (program->boundAttribNames[i] && strcmp(program->boundAttribNames[i], name) == 0)
+            location = i;
+    }
+    int slots = swgl_attrib_slots(type);
+    if (location < 0)
+    {
+        // First run of free locations that is not claimed by glBindAttribLocation
+        for (int candidate = 0; candidate + slots <= SWGL_MAX_ATTRIBS && location < 0; ++candidate)
+        {
+            int available = 1;
+            for (int s = candidate; s < candidate + slots && available; ++s)
+            {
+                if (program->boundAttribNames[s])
+                    available = 0;
+                for (int a = 0; a < program->attribCount && available; ++a)
+                {
+                    int used = swgl_attrib_slots(program->attribs[a].type);
+                    if (s >= program->attribs[a].location && s < program->attribs[a].location + used)
+                        available = 0;
+                }
+            }
+            if (available)
+                location = candidate;
+        }
+    }
+    if (location < 0)
+        return -1;
+    SwglAttribInfo *info = &program->attribs[program->attribCount++];
+    snprintf(info->name, sizeof(info->name), "%s", name);
+    info->type = type;
+    info->location = location;
+    if (location + slots > program->attribSlots)
+        program->attribSlots = location + slots;
+    return location;
+}
+
+int swgl_program_add_uniform(SwglProgram *program, const char *name, GLenum type, GLint size)
+{
+    for (int i = 0; i < program->uniformCount; ++i)
+    {
+        // Both stages may declare the same uniform; they share its storage
+        if (strcmp(program->uniforms[i].name, name) == 0)
+            return program->uniforms[i].type == type ? program->uniforms[i].offset : -1;
+    }
+    if (program->uniformCount == program->uniformCapacity)
+    {
+        int capacity = program->uniformCapacity ? program->uniformCapacity * 2 : 8;
+        SwglUniformInfo *uniforms = (SwglUniformInfo *)realloc(program->uniforms, capacity * sizeof(SwglUniformInfo));
+        if (!uniforms)
+            return -1;
+        program->uniforms = uniforms;
+        program->uniformCapacity = capacity;
+    }
+    int components = swgl_type_components(type);
+    float *data = (float *)realloc(program->uniformData, (size_t)(program->uniformFloats + components * size) * sizeof(float));
+    if (!data)
+        return -1;
+    memset(data + program->uniformFloats, 0, (size_t)components * size * sizeof(float));
+    program->uniformData = data;
+
+    SwglUniformInfo *info = &program->uniforms[program->uniformCount++];
+    snprintf(info->name, sizeof(info->name), "%s", name);
+    info->type = type;
+    info->size = size;
+    info->components = components;
+    info->offset = program->uniformFloats;
+    info->location = program->locationCount;
+    program->uniformFloats += components * size;
+    program->locationCount += size;
+    return info->offset;
+}
+
+// ---------------------------------------------------------------------------
+// Shaders
+
+GL_APICALL GLuint GL_APIENTRY glCreateShader(GLenum type)
+{
+    SWGL_GET_CONTEXT(0);
+    if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return 0;
+    }
+    SwglShader *shader = (SwglShader *)calloc(1, sizeof(SwglShader));
+    if (!shader)
+    {
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return 0;
+    }
+    shader->kind = SWGL_OBJECT_SHADER;
+    shader->type = type;
+    GLuint name = swgl_names_alloc(&ctx->objects, shader);
+    if (!name)
+    {
+        free(shader);
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+    }
+    return name;
+}
+
+GL_APICALL void GL_APIENTRY glDeleteShader(GLuint shader)
+{
+    SWGL_GET_CONTEXT();
+    if (shader == 0)
+        return;
+    SwglShader *object = swgl_get_shader(ctx, shader);
+    if (!object)
+        return;
+    if (object->attachCount > 0)
+        object->deletePending = 1;
+    else
+        swgl_destroy_shader(ctx, shader, object);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsShader(GLuint shader)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    void *object = swgl_names_get(&ctx->objects, shader);
+    return object && *(int *)object == SWGL_OBJECT_SHADER ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)
+{
+    SWGL_GET_CONTEXT();
+    SwglShader *object = swgl_get_shader(ctx, shader);
+    if (!object)
+        return;
+    if (count < 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    size_t total = 0;
+    for (GLsizei i = 0; i < count; ++i)
+        total += (length && length[i] >= 0) ? (size_t)length[i] : strlen(string[i]);
+    char *source = (char *)malloc(total + 1);
+    if (!source)
+    {
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return;
+    }
+    size_t offset = 0;
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        size_t n = (length && length[i] >= 0) ? (size_t)length[i] : strlen(string[i]);
+        memcpy(source + offset, string[i], n);
+        offset += n;
+    }
+    source[offset] = '\0';
+    free(object->source);
+    object->source = source;
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderSource(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *source)
+{
+    SWGL_GET_CONTEXT();
+    SwglShader *object = swgl_get_shader(ctx, shader);
+    if (!object)
+        return;
+    swgl_copy_string(object->source ? object->source : "", bufSize, length, source);
+}
+
+GL_APICALL void GL_APIENTRY glCompileShader(GLuint shader)
+{
+    SWGL_GET_CONTEXT();
+    SwglShader *object = swgl_get_shader(ctx, shader);
+    if (!object)
+        return;
+    swgl_shader_release(object);
+    swgl_shader_set_info_log(object, NULL);
+    object->compiled = object->source ? swgl_shader_compile(object) : 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    SwglShader *object = swgl_get_shader(ctx, shader);
+    if (!object)
+        return;
+    switch (pname)
+    {
+    case GL_SHADER_TYPE:
+        *params = (GLint)object->type;
+        break;
+    case GL_DELETE_STATUS:
+        *params = object->deletePending;
+        break;
+    case GL_COMPILE_STATUS:
+        *params = object->compiled;
+        break;
+    case GL_INFO_LOG_LENGTH:
+        *params = object->infoLog ? (GLint)strlen(object->infoLog) + 1 : 0;
+        break;
+    case GL_SHADER_SOURCE_LENGTH:
+        *params = object->source ? (GLint)strlen(object->source) + 1 : 0;
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog)
+{
+    SWGL_GET_CONTEXT();
+    SwglShader *object = swgl_get_shader(ctx, shader);
+    if (!object)
+        return;
+    swgl_copy_string(object->infoLog ? object->infoLog : "", bufSize, length, infoLog);
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderPrecisionFormat(GLenum shadertype, GLenum precisiontype, GLint *range, GLint *precision)
+{
+    SWGL_GET_CONTEXT();
+    if (shadertype != GL_VERTEX_SHADER && shadertype != GL_FRAGMENT_SHADER)
+    {
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    // Every precision executes as IEEE single precision
+    switch (precisiontype)
+    {
+    case GL_LOW_FLOAT:
+    case GL_MEDIUM_FLOAT:
+    case GL_HIGH_FLOAT:
+        range[0] = 127;
+        range[1] = 127;
+        *precision = 23;
+        break;
+    case GL_LOW_INT:
+    case GL_MEDIUM_INT:
+    case GL_HIGH_INT:
+        range[0] = 24;
+        range[1] = 24;
+        *precision = 0;
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glReleaseShaderCompiler(void)
+{
+}
+
+GL_APICALL void GL_APIENTRY glShaderBinary(GLsizei count, const GLuint *shaders, GLenum binaryFormat, const void *binary, GLsizei length)
+{
+    SWGL_GET_CONTEXT();
+    (void)count;
+    (void)shaders;
+    (void)binaryFormat;
+    (void)binary;
+    (void)length;
+    swgl_set_error(ctx, GL_INVALID_ENUM); // no binary formats are supported
+}
+
+// ---------------------------------------------------------------------------
+// Programs
+
+GL_APICALL GLuint GL_APIENTRY glCreateProgram(void)
+{
+    SWGL_GET_CONTEXT(0);
+    SwglProgram *program = (SwglProgram *)calloc(1, sizeof(SwglProgram));
+    if (!program)
+    {
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return 0;
+    }
+    program->kind = SWGL_OBJECT_PROGRAM;
+    GLuint name = swgl_names_alloc(&ctx->objects, program);
+    if (!name)
+    {
+        free(program);
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+    }
+    return name;
+}
+
+GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint program)
+{
+    SWGL_GET_CONTEXT();
+    if (program == 0)
+        return;
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    if (ctx->currentProgram == program)
+    {
+        object->deletePending = 1;
+        return;
+    }
+    swgl_raster_flush(ctx); // queued draws may still reference it
+    swgl_destroy_program(ctx, program, object);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsProgram(GLuint program)
+{
+    SWGL_GET_CONTEXT(GL_FALSE);
+    void *object = swgl_names_get(&ctx->objects, program);
+    return object && *(int *)object == SWGL_OBJECT_PROGRAM ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glAttachShader(GLuint program, GLuint shader)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *programObject = swgl_get_program(ctx, program);
+    if (!programObject)
+        return;
+    SwglShader *shaderObject = swgl_get_shader(ctx, shader);
+    if (!shaderObject)
+        return;
+    GLuint *slot = shaderObject->type == GL_VERTEX_SHADER ? &programObject->vertexShader : &programObject->fragmentShader;
+    if (*slot)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    *slot = shader;
+    shaderObject->attachCount++;
+}
+
+GL_APICALL void GL_APIENTRY glDetachShader(GLuint program, GLuint shader)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *programObject = swgl_get_program(ctx, program);
+    if (!programObject)
+        return;
+    if (!swgl_get_shader(ctx, shader))
+        return;
+    GLuint *slot = programObject->vertexShader == shader ? &programObject->vertexShader
+                   : (programObject->fragmentShader == shader ? &programObject->fragmentShader : NULL);
+    if (!slot)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    *slot = 0;
+    swgl_detach(ctx, shader);
+}
+
+GL_APICALL void GL_APIENTRY glGetAttachedShaders(GLuint program, GLsizei maxCount, GLsizei *count, GLuint *shaders)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    GLsizei n = 0;
+    if (object->vertexShader && n < maxCount)
+        shaders[n++] = object->vertexShader;
+    if (object->fragmentShader && n < maxCount)
+        shaders[n++] = object->fragmentShader;
+    if (count)
+        *count = n;
+}
+
+GL_APICALL void GL_APIENTRY glBindAttribLocation(GLuint program, GLuint index, const GLchar *name)
+{
+    SWGL_GET_CONTEXT();
+    if (index >= SWGL_MAX_ATTRIBS)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (strncmp(name, "gl_", 3) == 0)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    for (int i = 0; i < SWGL_MAX_ATTRIBS; ++i)
+    {
+        // A name is bound to at most one location; the last call wins
+        if (object->boundAttribNames[i] && strcmp(object->boundAttribNames[i], name) == 0)
+        {
+            free(object->boundAttribNames[i]);
+            object->boundAttribNames[i] = NULL;
+        }
+    }
+    free(object->boundAttribNames[index]);
+    object->boundAttribNames[index] = swgl_strdup(name);
+}
+
+GL_APICALL void GL_APIENTRY glLinkProgram(GLuint program)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    swgl_raster_flush(ctx); // queued draws may still reference the old executable
+    swgl_clear_reflection(object);
+    swgl_program_set_info_log(object, NULL);
+    SwglShader *vertex = (SwglShader *)swgl_names_get(&ctx->objects, object->vertexShader);
+    SwglShader *fragment = (SwglShader *)swgl_names_get(&ctx->objects, object->fragmentShader);
+    if (!vertex || !fragment)
+    {
+        swgl_program_set_info_log(object, "ERROR: a vertex and a fragment shader must be attached\n");
+        return;
+    }
+    if (!vertex->compiled || !fragment->compiled)
+    {
+        swgl_program_set_info_log(object, "ERROR: attached shaders must be compiled successfully\n");
+        return;
+    }
+    object->linked = swgl_program_link(object, vertex, fragment);
+    if (!object->linked)
+        swgl_clear_reflection(object);
+}
+
+GL_APICALL void GL_APIENTRY glUseProgram(GLuint program)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = NULL;
+    if (program)
+    {
+        object = swgl_get_program(ctx, program);
+        if (!object)
+            return;
+        if (!object->linked)
+        {
+            swgl_set_error(ctx, GL_INVALID_OPERATION);
+            return;
+        }
+    }
+    GLuint previous = ctx->currentProgram;
+    ctx->currentProgram = program;
+    SwglProgram *old = (SwglProgram *)swgl_names_get(&ctx->objects, previous);
+    if (old && old != object && old->kind == SWGL_OBJECT_PROGRAM && old->deletePending)
+    {
+        swgl_raster_flush(ctx);
+        swgl_destroy_program(ctx, previous, old);
+    }
+}
+
+GL_APICALL void GL_APIENTRY glValidateProgram(GLuint program)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (object)
+        object->validated = object->linked;
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint *params)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    switch (pname)
+    {
+    case GL_DELETE_STATUS:
+        *params = object->deletePending;
+        break;
+    case GL_LINK_STATUS:
+        *params = object->linked;
+        break;
+    case GL_VALIDATE_STATUS:
+        *params = object->validated;
+        break;
+    case GL_INFO_LOG_LENGTH:
+        *params = object->infoLog ? (GLint)strlen(object->infoLog) + 1 : 0;
+        break;
+    case GL_ATTACHED_SHADERS:
+        *params = (object->vertexShader != 0) + (object->fragmentShader != 0);
+        break;
+    case GL_ACTIVE_ATTRIBUTES:
+        *params = object->attribCount;
+        break;
+    case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH:
+    case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+    {
+        GLint longest = 0;
+        int count = pname == GL_ACTIVE_ATTRIBUTE_MAX_LENGTH ? object->attribCount : object->uniformCount;
+        for (int i = 0; i < count; ++i)
+        {
+            const char *name = pname == GL_ACTIVE_ATTRIBUTE_MAX_LENGTH ? object->attribs[i].name : object->uniforms[i].name;
+            GLint length = (GLint)strlen(name) + 1 + (pname == GL_ACTIVE_UNIFORM_MAX_LENGTH && object->uniforms[i].size > 1 ? 3 : 0);
+            longest = length > longest ? length : longest;
+        }
+        *params = longest;
+        break;
+    }
+    case GL_ACTIVE_UNIFORMS:
+        *params = object->uniformCount;
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    swgl_copy_string(object->infoLog ? object->infoLog : "", bufSize, length, infoLog);
+}
+
+GL_APICALL void GL_APIENTRY glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    if (index >= (GLuint)object->attribCount)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    *size = 1;
+    *type = object->attribs[index].type;
+    swgl_copy_string(object->attribs[index].name, bufSize, length, name);
+}
+
+GL_APICALL void GL_APIENTRY glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    if (index >= (GLuint)object->uniformCount)
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    const SwglUniformInfo *info = &object->uniforms[index];
+    char reported[SWGL_NAME_LENGTH + 3];
+    snprintf(reported, sizeof(reported), info->size > 1 ? "%s[0]" : "%s", info->name);
+    *size = info->size;
+    *type = info->type;
+    swgl_copy_string(reported, bufSize, length, name);
+}
+
+GL_APICALL GLint GL_APIENTRY glGetAttribLocation(GLuint program, const GLchar *name)
+{
+    SWGL_GET_CONTEXT(-1);
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return -1;
+    if (!object->linked)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return -1;
+    }
+    for (int i = 0; i < object->attribCount; ++i)
+    {
+        if (strcmp(object->attribs[i].name, name) == 0)
+            return object->attribs[i].location;
+    }
+    return -1;
+}
+
+GL_APICALL GLint GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar *name)
+{
+    SWGL_GET_CONTEXT(-1);
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return -1;
+    if (!object->linked)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return -1;
+    }
+    // Accept "name", "name[0]" and "name[i]" for arrays
+    char base[SWGL_NAME_LENGTH];
+    int element = 0;
+    snprintf(base, sizeof(base), "%s", name);
+    char *bracket = strchr(base, '[');
+    if (bracket)
+    {
+        element = atoi(bracket + 1);
+        *bracket = '\0';
+    }
+    for (int i = 0; i < object->uniformCount; ++i)
+    {
+        const SwglUniformInfo *info = &object->uniforms[i];
+        if (strcmp(info->name, base) == 0)
+            return element >= 0 && element < info->size ? info->location + element : -1;
+    }
+    return -1;
+}
+
+// Resolves a location to its uniform and element; NULL for unknown locations.
+static SwglUniformInfo *swgl_uniform_at(SwglProgram *program, GLint location, int *element)
+{
+    for (int i = 0; i < program->uniformCount; ++i)
+    {
+        SwglUniformInfo *info = &program->uniforms[i];
+        if (location >= info->location && location < info->location + info->size)
+        {
+            *element = location - info->location;
+            return info;
+        }
+    }
+    return NULL;
+}
+
+static SwglProgram *swgl_current_program(SwglContext *ctx)
+{
+    SwglProgram *program = (SwglProgram *)swgl_names_get(&ctx->objects, ctx->currentProgram);
+    return program && program->kind == SWGL_OBJECT_PROGRAM ? program : NULL;
+}
+
+static int swgl_is_int_type(GLenum type)
+{
+    return type == GL_INT || type == GL_INT_VEC2 || type == GL_INT_VEC3 || type == GL_INT_VEC4 ||
+           type == GL_BOOL || type == GL_BOOL_VEC2 || type == GL_BOOL_VEC3 || type == GL_BOOL_VEC4 ||
+           type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE;
+}
+
+// Common path of every glUniform* call; ints are stored as floats.
+static void swgl_uniform(GLint location, int components, GLsizei count, int isInt, int isMatrix,
+                         GLboolean transpose, const float *values)
+{
+    SWGL_GET_CONTEXT();
+    SwglProgram *program = swgl_current_program(ctx);
+    if (!program)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (location == -1)
+        return;
+    if (count < 0 || (isMatrix && transpose))
+    {
+        swgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    int element;
+    SwglUniformInfo *info = swgl_uniform_at(program, location, &element);
+    if (!info || info->components != components || (count > 1 && info->size == 1))
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    int infoIsInt = swgl_is_int_type(info->type);
+    int infoIsBool = info->type == GL_BOOL || info->type == GL_BOOL_VEC2 || info->type == GL_BOOL_VEC3 || info->type == GL_BOOL_VEC4;
+    if (infoIsInt != isInt && !infoIsBool)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (count > info->size - element)
+        count = info->size - element;
+    float *dst = program->uniformData + info->offset + element * components;
+    for (int i = 0; i < count * components; ++i)
+        dst[i] = infoIsBool ? (values[i] != 0.0f ? 1.0f : 0.0f) : values[i];
+}
+
+static void swgl_uniformf(GLint location, int components, GLsizei count, const GLfloat *value)
+{
+    swgl_uniform(location, components, count, 0, 0, GL_FALSE, value);
+}
+
+static void swgl_uniformi(GLint location, int components, GLsizei count, const GLint *value)
+{
+    float converted[4 * 64];
+    for (GLsizei offset = 0; offset < count; offset += 64)
+    {
+        GLsizei chunk = count - offset < 64 ? count - offset : 64;
+        for (int i = 0; i < chunk * components; ++i)
+            converted[i] = (float)value[offset * components + i];
+        swgl_uniform(location + offset, components, chunk, 1, 0, GL_FALSE, converted);
+    }
+}
+
+GL_APICALL void GL_APIENTRY glUniform1f(GLint location, GLfloat v0)
+{
+    GLfloat v[1] = {v0};
+    swgl_uniformf(location, 1, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+    GLfloat v[2] = {v0, v1};
+    swgl_uniformf(location, 2, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+    GLfloat v[3] = {v0, v1, v2};
+    swgl_uniformf(location, 3, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+    GLfloat v[4] = {v0, v1, v2, v3};
+    swgl_uniformf(location, 4, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform1fv(GLint location, GLsizei count, const GLfloat *value) { swgl_uniformf(location, 1, count, value); }
+GL_APICALL void GL_APIENTRY glUniform2fv(GLint location, GLsizei count, const GLfloat *value) { swgl_uniformf(location, 2, count, value); }
+GL_APICALL void GL_APIENTRY glUniform3fv(GLint location, GLsizei count, const GLfloat *value) { swgl_uniformf(location, 3, count, value); }
+GL_APICALL void GL_APIENTRY glUniform4fv(GLint location, GLsizei count, const GLfloat *value) { swgl_uniformf(location, 4, count, value); }
+
+GL_APICALL void GL_APIENTRY glUniform1i(GLint location, GLint v0)
+{
+    GLint v[1] = {v0};
+    swgl_uniformi(location, 1, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform2i(GLint location, GLint v0, GLint v1)
+{
+    GLint v[2] = {v0, v1};
+    swgl_uniformi(location, 2, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3i(GLint location, GLint v0, GLint v1, GLint v2)
+{
+    GLint v[3] = {v0, v1, v2};
+    swgl_uniformi(location, 3, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3)
+{
+    GLint v[4] = {v0, v1, v2, v3};
+    swgl_uniformi(location, 4, 1, v);
+}
+
+GL_APICALL void GL_APIENTRY glUniform1iv(GLint location, GLsizei count, const GLint *value) { swgl_uniformi(location, 1, count, value); }
+GL_APICALL void GL_APIENTRY glUniform2iv(GLint location, GLsizei count, const GLint *value) { swgl_uniformi(location, 2, count, value); }
+GL_APICALL void GL_APIENTRY glUniform3iv(GLint location, GLsizei count, const GLint *value) { swgl_uniformi(location, 3, count, value); }
+GL_APICALL void GL_APIENTRY glUniform4iv(GLint location, GLsizei count, const GLint *value) { swgl_uniformi(location, 4, count, value); }
+
+GL_APICALL void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+    swgl_uniform(location, 4, count, 0, 1, transpose, value);
+}
+
+GL_APICALL void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+    swgl_uniform(location, 9, count, 0, 1, transpose, value);
+}
+
+GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+    swgl_uniform(location, 16, count, 0, 1, transpose, value);
+}
+
+static void swgl_get_uniform(GLuint program, GLint location, float *out, int *components)
+{
+    *components = 0;
+    SWGL_GET_CONTEXT();
+    SwglProgram *object = swgl_get_program(ctx, program);
+    if (!object)
+        return;
+    int element;
+    SwglUniformInfo *info = object->linked ? swgl_uniform_at(object, location, &element) : NULL;
+    if (!info)
+    {
+        swgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    *components = info->components;
+    memcpy(out, object->uniformData + info->offset + element * info->components, info->components * sizeof(float));
+}
+
+GL_APICALL void GL_APIENTRY glGetUniformfv(GLuint program, GLint location, GLfloat *params)
+{
+    float values[16];
+    int components;
+    swgl_get_uniform(program, location, values, &components);
+    memcpy(params, values, components * sizeof(float));
+}
+
+GL_APICALL void GL_APIENTRY glGetUniformiv(GLuint program, GLint location, GLint *params)
+{
+    float values[16];
+    int components;
+    swgl_get_uniform(program, location, values, &components);
+    for (int i = 0; i < components; ++i)
+        params[i] = (GLint)values[i];
+}
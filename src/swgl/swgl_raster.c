@@ -0,0 +1,1230 @@
+// swgl_raster.c
+// Vertex fetch, clipping, triangle/point setup, tile binning and the
+// parallel tile rasterizer of the software renderer.
+//
+// Draw calls do not touch the framebuffer. Each draw shades its vertices,
+// snapshots the state it needs (program, uniforms, blending, clip rect) and
+// appends its primitives to the bins of every 64x64 tile they overlap.
+// swgl_raster_flush() then hands the non-empty tiles to the thread pool;
+// each tile replays its bin in submission order, so blending stays exact
+// while different tiles are rasterized concurrently.
+#include "swgl_internal.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SWGL_GUARD_BAND 8.0f
+#define SWGL_SUBPIXEL 256.0f
+#define SWGL_VERTEX_CHUNK 256
+#define SWGL_MAX_FRAME_PRIMS (1u << 20)
+#define SWGL_MAX_CLIP_VERTICES 10
+
+typedef char swgl_lanes_match_sse_code[(SWGL_LANES == 8) ? 1 : -1];
+
+static pthread_mutex_t swgl_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static SwglThreadPool *swgl_pool;
+static int swgl_thread_count = -1;
+
+static atomic_ullong swgl_stat_frames;
+static atomic_ullong swgl_stat_flushes;
+static atomic_ullong swgl_stat_primitives;
+static atomic_ullong swgl_stat_binned;
+static atomic_ullong swgl_stat_fragments;
+static unsigned long long swgl_steals_base;
+
+// ---------------------------------------------------------------------------
+// Thread configuration and statistics
+
+static int swgl_default_thread_count(void)
+{
+    const char *env = getenv("SWGL_THREADS");
+    if (env && atoi(env) > 0)
+        return atoi(env);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+void swgl_set_thread_count(int count)
+{
+    pthread_mutex_lock(&swgl_pool_lock);
+    if (swgl_pool)
+    {
+        swgl_steals_base += swgl_threadpool_steals(swgl_pool);
+        swgl_threadpool_destroy(swgl_pool);
+        swgl_pool = NULL;
+    }
+    swgl_thread_count = count > 0 ? count : swgl_default_thread_count();
+    pthread_mutex_unlock(&swgl_pool_lock);
+}
+
+int swgl_get_thread_count(void)
+{
+    pthread_mutex_lock(&swgl_pool_lock);
+    if (swgl_thread_count < 0)
+        swgl_thread_count = swgl_default_thread_count();
+    int count = swgl_thread_count;
+    pthread_mutex_unlock(&swgl_pool_lock);
+    return count;
+}
+
+void swgl_get_stats(SwglStats *stats)
+{
+    stats->frames = atomic_load(&swgl_stat_frames);
+    stats->flushes = atomic_load(&swgl_stat_flushes);
+    stats->primitives = atomic_load(&swgl_stat_primitives);
+    stats->binnedRefs = atomic_load(&swgl_stat_binned);
+    stats->fragments = atomic_load(&swgl_stat_fragments);
+    pthread_mutex_lock(&swgl_pool_lock);
+    stats->steals = swgl_steals_base + swgl_threadpool_steals(swgl_pool);
+    pthread_mutex_unlock(&swgl_pool_lock);
+}
+
+void swgl_reset_stats(void)
+{
+    atomic_store(&swgl_stat_frames, 0);
+    atomic_store(&swgl_stat_flushes, 0);
+    atomic_store(&swgl_stat_primitives, 0);
+    atomic_store(&swgl_stat_binned, 0);
+    atomic_store(&swgl_stat_fragments, 0);
+    pthread_mutex_lock(&swgl_pool_lock);
+    swgl_steals_base = 0ull - swgl_threadpool_steals(swgl_pool); // keeps the pool alive
+    pthread_mutex_unlock(&swgl_pool_lock);
+}
+
+void swgl_raster_count_frame(void)
+{
+    atomic_fetch_add(&swgl_stat_frames, 1);
+}
+
+// Locks the shared pool; callers run at most one job at a time.
+static SwglThreadPool *swgl_pool_acquire(void)
+{
+    pthread_mutex_lock(&swgl_pool_lock);
+    if (swgl_thread_count < 0)
+        swgl_thread_count = swgl_default_thread_count();
+    if (!swgl_pool)
+        swgl_pool = swgl_threadpool_create(swgl_thread_count);
+    return swgl_pool;
+}
+
+static void swgl_pool_release(void)
+{
+    pthread_mutex_unlock(&swgl_pool_lock);
+}
+
+// ---------------------------------------------------------------------------
+// Frame storage
+
+static int swgl_grow(void **data, size_t *capacity, size_t needed, size_t elementSize)
+{
+    if (needed <= *capacity)
+        return 1;
+    size_t next = *capacity ? *capacity * 2 : 256;
+    while (next < needed)
+        next *= 2;
+    void *grown = realloc(*data, next * elementSize);
+    if (!grown)
+        return 0;
+    *data = grown;
+    *capacity = next;
+    return 1;
+}
+
+void swgl_frame_init(SwglFrame *frame, int width, int height)
+{
+    memset(frame, 0, sizeof(SwglFrame));
+    frame->tilesX = (width + SWGL_TILE_SIZE - 1) / SWGL_TILE_SIZE;
+    frame->tilesY = (height + SWGL_TILE_SIZE - 1) / SWGL_TILE_SIZE;
+    frame->bins = (SwglBin *)calloc((size_t)frame->tilesX * frame->tilesY, sizeof(SwglBin));
+    frame->activeTiles = (int *)calloc((size_t)frame->tilesX * frame->tilesY, sizeof(int));
+}
+
+void swgl_frame_free(SwglFrame *frame)
+{
+    if (frame->bins)
+    {
+        for (int i = 0; i < frame->tilesX * frame->tilesY; ++i)
+            free(frame->bins[i].items);
+    }
+    free(frame->bins);
+    free(frame->activeTiles);
+    free(frame->prims);
+    free(frame->states);
+    free(frame->floats);
+    memset(frame, 0, sizeof(SwglFrame));
+}
+
+static void swgl_frame_reset(SwglFrame *frame)
+{
+    for (int i = 0; i < frame->tilesX * frame->tilesY; ++i)
+        frame->bins[i].count = 0;
+    frame->primCount = 0;
+    frame->stateCount = 0;
+    frame->floatCount = 0;
+}
+
+static float *swgl_frame_floats(SwglFrame *frame, size_t count, size_t *offset)
+{
+    if (!swgl_grow((void **)&frame->floats, &frame->floatCapacity, frame->floatCount + count, sizeof(float)))
+        return NULL;
+    *offset = frame->floatCount;
+    frame->floatCount += count;
+    return frame->floats + *offset;
+}
+
+static int swgl_intersect(int r[4], const int a[4], const int b[4])
+{
+    r[0] = a[0] > b[0] ? a[0] : b[0];
+    r[1] = a[1] > b[1] ? a[1] : b[1];
+    r[2] = a[2] < b[2] ? a[2] : b[2];
+    r[3] = a[3] < b[3] ? a[3] : b[3];
+    return r[0] < r[2] && r[1] < r[3];
+}
+
+// Snapshots the current draw state; consecutive identical draws share one.
+static int swgl_record_state(SwglContext *ctx, const SwglProgram *program)
+{
+    SwglFrame *frame = &ctx->frame;
+    SwglDrawState state;
+    memset(&state, 0, sizeof(state));
+    state.program = program;
+    state.varyingCount = program ? program->varyingCount : 0;
+    state.blendEnabled = ctx->blendEnabled;
+    state.blendEquationRGB = ctx->blendEquationRGB;
+    state.blendEquationAlpha = ctx->blendEquationAlpha;
+    state.blendSrcRGB = ctx->blendSrcRGB;
+    state.blendDstRGB = ctx->blendDstRGB;
+    state.blendSrcAlpha = ctx->blendSrcAlpha;
+    state.blendDstAlpha = ctx->blendDstAlpha;
+    memcpy(state.blendColor, ctx->blendColor, sizeof(state.blendColor));
+    memcpy(state.colorMask, ctx->colorMask, sizeof(state.colorMask));
+
+    int surface[4] = {0, 0, ctx->width, ctx->height};
+    int viewport[4] = {ctx->viewport[0], ctx->viewport[1],
+                       ctx->viewport[0] + ctx->viewport[2], ctx->viewport[1] + ctx->viewport[3]};
+    if (!program)
+        memcpy(viewport, surface, sizeof(viewport)); // glClear ignores the viewport
+    if (!swgl_intersect(state.clip, surface, viewport))
+        memset(state.clip, 0, sizeof(state.clip));
+    if (ctx->scissorTest)
+    {
+        int scissor[4] = {ctx->scissor[0], ctx->scissor[1],
+                          ctx->scissor[0] + ctx->scissor[2], ctx->scissor[1] + ctx->scissor[3]};
+        int clipped[4];
+        if (swgl_intersect(clipped, state.clip, scissor))
+            memcpy(state.clip, clipped, sizeof(clipped));
+        else
+            memset(state.clip, 0, sizeof(state.clip));
+    }
+
+    int uniformFloats = program ? program->uniformFloats : 0;
+    if (frame->stateCount > 0)
+    {
+        SwglDrawState *last = &frame->states[frame->stateCount - 1];
+        state.uniformOffset = last->uniformOffset;
+        if (memcmp(&state, last, sizeof(state)) == 0 &&
+            (uniformFloats == 0 ||
+             memcmp(frame->floats + last->uniformOffset, program->uniformData, uniformFloats * sizeof(float)) == 0))
+            return (int)frame->stateCount - 1;
+    }
+
+    if (uniformFloats > 0)
+    {
+        float *uniforms = swgl_frame_floats(frame, uniformFloats, &state.uniformOffset);
+        if (!uniforms)
+            return -1;
+        memcpy(uniforms, program->uniformData, uniformFloats * sizeof(float));
+    }
+    else
+    {
+        state.uniformOffset = 0;
+    }
+    if (!swgl_grow((void **)&frame->states, &frame->stateCapacity, frame->stateCount + 1, sizeof(SwglDrawState)))
+        return -1;
+    frame->states[frame->stateCount] = state;
+    return (int)frame->stateCount++;
+}
+
+static int swgl_tile_touches_triangle(const SwglPrim *p, int tx, int ty)
+{
+    float x0 = tx * SWGL_TILE_SIZE + 0.5f, x1 = (tx + 1) * SWGL_TILE_SIZE - 0.5f;
+    float y0 = ty * SWGL_TILE_SIZE + 0.5f, y1 = (ty + 1) * SWGL_TILE_SIZE - 0.5f;
+    for (int k = 0; k < 3; ++k)
+    {
+        float px = p->edgeA[k] > 0.0f ? x1 : x0;
+        float py = p->edgeB[k] > 0.0f ? y1 : y0;
+        if (p->edgeA[k] * px + (p->edgeB[k] * py + p->edgeC[k]) < 0.0f)
+            return 0;
+    }
+    return 1;
+}
+
+static void swgl_bin_prim(SwglFrame *frame, uint32_t index)
+{
+    const SwglPrim *p = &frame->prims[index];
+    int tx0 = p->bounds[0] / SWGL_TILE_SIZE, tx1 = (p->bounds[2] - 1) / SWGL_TILE_SIZE;
+    int ty0 = p->bounds[1] / SWGL_TILE_SIZE, ty1 = (p->bounds[3] - 1) / SWGL_TILE_SIZE;
+    int test = p->type == SWGL_PRIM_TRIANGLE && (tx1 > tx0 || ty1 > ty0);
+    unsigned long long refs = 0;
+    for (int ty = ty0; ty <= ty1; ++ty)
+    {
+        for (int tx = tx0; tx <= tx1; ++tx)
+        {
+            if (test && !swgl_tile_touches_triangle(p, tx, ty))
+                continue;
+            SwglBin *bin = &frame->bins[ty * frame->tilesX + tx];
+            if (bin->count == bin->capacity)
+            {
+                uint32_t capacity = bin->capacity ? bin->capacity * 2 : 64;
+                uint32_t *items = (uint32_t *)realloc(bin->items, capacity * sizeof(uint32_t));
+                if (!items)
+                    continue;
+                bin->items = items;
+                bin->capacity = capacity;
+            }
+            bin->items[bin->count++] = index;
+            refs++;
+        }
+    }
+    atomic_fetch_add_explicit(&swgl_stat_binned, refs, memory_order_relaxed);
+}
+
+static SwglPrim *swgl_new_prim(SwglFrame *frame)
+{
+    if (!swgl_grow((void **)&frame->prims, &frame->primCapacity, frame->primCount + 1, sizeof(SwglPrim)))
+        return NULL;
+    SwglPrim *p = &frame->prims[frame->primCount];
+    memset(p, 0, sizeof(SwglPrim));
+    return p;
+}
+
+static uint8_t swgl_unorm8(float v)
+{
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+// ---------------------------------------------------------------------------
+// Clears
+
+void swgl_raster_clear(SwglContext *ctx, GLbitfield mask)
+{
+    if (!(mask & GL_COLOR_BUFFER_BIT) || ctx->framebuffer)
+        return;
+    if (!ctx->colorMask[0] && !ctx->colorMask[1] && !ctx->colorMask[2] && !ctx->colorMask[3])
+        return;
+    SwglFrame *frame = &ctx->frame;
+    int stateIndex = swgl_record_state(ctx, NULL);
+    if (stateIndex < 0)
+        return;
+    const SwglDrawState *state = &frame->states[stateIndex];
+    if (state->clip[0] >= state->clip[2] || state->clip[1] >= state->clip[3])
+        return;
+
+    int full = state->clip[0] == 0 && state->clip[1] == 0 && state->clip[2] == ctx->width &&
+               state->clip[3] == ctx->height && ctx->colorMask[0] && ctx->colorMask[1] &&
+               ctx->colorMask[2] && ctx->colorMask[3];
+    if (full)
+    {
+        // Everything queued so far would be overwritten: drop it
+        for (int i = 0; i < frame->tilesX * frame->tilesY; ++i)
+            frame->bins[i].count = 0;
+    }
+
+    SwglPrim *p = swgl_new_prim(frame);
+    if (!p)
+        return;
+    p->type = SWGL_PRIM_CLEAR;
+    p->state = stateIndex;
+    memcpy(p->bounds, state->clip, sizeof(p->bounds));
+    uint8_t bytes[4];
+    for (int c = 0; c < 4; ++c)
+        bytes[c] = swgl_unorm8(ctx->clearColor[c]);
+    memcpy(&p->clearColor, bytes, sizeof(bytes));
+    swgl_bin_prim(frame, (uint32_t)frame->primCount++);
+}
+
+// ---------------------------------------------------------------------------
+// Vertex fetch and shading
+
+static float swgl_fetch_component(const unsigned char *p, GLenum type, GLboolean normalized, int i)
+{
+    switch (type)
+    {
+    case GL_FLOAT:
+    {
+        float v;
+        memcpy(&v, p + i * 4, sizeof(v));
+        return v;
+    }
+    case GL_UNSIGNED_BYTE:
+        return normalized ? p[i] / 255.0f : (float)p[i];
+    case GL_BYTE:
+    {
+        float v = (float)(signed char)p[i];
+        return normalized ? (2.0f * v + 1.0f) / 255.0f : v;
+    }
+    case GL_UNSIGNED_SHORT:
+    {
+        unsigned short v;
+        memcpy(&v, p + i * 2, sizeof(v));
+        return normalized ? v / 65535.0f : (float)v;
+    }
+    case GL_SHORT:
+    {
+        short v;
+        memcpy(&v, p + i * 2, sizeof(v));
+        return normalized ? (2.0f * v + 1.0f) / 65535.0f : (float)v;
+    }
+    case GL_FIXED:
+    {
+        int v;
+        memcpy(&v, p + i * 4, sizeof(v));
+        return v / 65536.0f;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+static int swgl_type_size(GLenum type)
+{
+    switch (type)
+    {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+static void swgl_fetch_vertex(const SwglContext *ctx, int slots, GLint vertex, float *out)
+{
+    for (int slot = 0; slot < slots; ++slot)
+    {
+        const SwglAttribArray *array = &ctx->attribs[slot];
+        float *dst = out + slot * 4;
+        if (!array->enabled)
+        {
+            memcpy(dst, array->current, 4 * sizeof(float));
+            continue;
+        }
+        dst[0] = 0.0f;
+        dst[1] = 0.0f;
+        dst[2] = 0.0f;
+        dst[3] = 1.0f;
+        int elementSize = array->size * swgl_type_size(array->type);
+        size_t stride = array->stride ? (size_t)array->stride : (size_t)elementSize;
+        const unsigned char *base;
+        if (array->buffer)
+        {
+            const SwglBuffer *buffer = (const SwglBuffer *)swgl_names_get(&ctx->buffers, array->buffer);
+            size_t offset = (size_t)(uintptr_t)array->pointer + (size_t)vertex * stride;
+            if (!buffer || !buffer->data || offset + elementSize > (size_t)buffer->size)
+                continue; // out-of-range reads return the default (0, 0, 0, 1)
+            base = buffer->data + offset;
+        }
+        else
+        {
+            if (!array->pointer)
+                continue;
+            base = (const unsigned char *)array->pointer + (size_t)vertex * stride;
+        }
+        for (int i = 0; i < array->size; ++i)
+            dst[i] = swgl_fetch_component(base, array->type, array->normalized, i);
+    }
+}
+
+typedef struct SwglVertexJob
+{
+    const SwglContext *ctx;
+    const SwglProgram *program;
+    GLint base;
+    int count;
+    float *out;
+    int stride;
+} SwglVertexJob;
+
+static void swgl_vertex_task(void *userData, int taskIndex, int workerIndex)
+{
+    (void)workerIndex;
+    const SwglVertexJob *job = (const SwglVertexJob *)userData;
+    float attribs[SWGL_VERTEX_CHUNK * SWGL_MAX_ATTRIBS * 4];
+    int slots = job->program->attribSlots;
+    int begin = taskIndex * SWGL_VERTEX_CHUNK;
+    int count = job->count - begin < SWGL_VERTEX_CHUNK ? job->count - begin : SWGL_VERTEX_CHUNK;
+    for (int i = 0; i < count; ++i)
+        swgl_fetch_vertex(job->ctx, slots, job->base + begin + i, attribs + i * slots * 4);
+    swgl_program_shade_vertices(job->program, job->program->uniformData, attribs, count,
+                                job->out + (size_t)begin * job->stride);
+}
+
+static int swgl_shade_vertices(SwglContext *ctx, const SwglProgram *program, GLint base, int count)
+{
+    int stride = SWGL_VERTEX_HEADER + program->varyingCount;
+    size_t needed = (size_t)count * stride;
+    if (!swgl_grow((void **)&ctx->vertexScratch, &ctx->vertexScratchCapacity, needed, sizeof(float)))
+        return 0;
+    SwglVertexJob job = {ctx, program, base, count, ctx->vertexScratch, stride};
+    int tasks = (count + SWGL_VERTEX_CHUNK - 1) / SWGL_VERTEX_CHUNK;
+    if (tasks > 4)
+    {
+        SwglThreadPool *pool = swgl_pool_acquire();
+        swgl_threadpool_run(pool, swgl_vertex_task, &job, tasks);
+        swgl_pool_release();
+    }
+    else
+    {
+        for (int i = 0; i < tasks; ++i)
+            swgl_vertex_task(&job, i, 0);
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Primitive setup
+
+typedef struct SwglSetup
+{
+    SwglContext *ctx;
+    const SwglProgram *program;
+    int stateIndex;
+    int stride;
+    int varyingCount;
+} SwglSetup;
+
+static void swgl_to_window(const SwglContext *ctx, const float *v, float *x, float *y, float *z, float *invW)
+{
+    float w = 1.0f / v[3];
+    float nx = v[0] * w, ny = v[1] * w, nz = v[2] * w;
+    *x = ctx->viewport[0] + (nx + 1.0f) * 0.5f * ctx->viewport[2];
+    *y = ctx->viewport[1] + (ny + 1.0f) * 0.5f * ctx->viewport[3];
+    *z = ctx->depthRange[0] + (nz * 0.5f + 0.5f) * (ctx->depthRange[1] - ctx->depthRange[0]);
+    *invW = w;
+    // Snapping keeps the edge equations of shared edges exactly opposite
+    *x = floorf(*x * SWGL_SUBPIXEL + 0.5f) / SWGL_SUBPIXEL;
+    *y = floorf(*y * SWGL_SUBPIXEL + 0.5f) / SWGL_SUBPIXEL;
+}
+
+// Keeps the recorded state valid when a huge draw forces a mid-draw flush.
+static int swgl_reserve_prim(SwglSetup *setup)
+{
+    if (setup->ctx->frame.primCount < SWGL_MAX_FRAME_PRIMS)
+        return 1;
+    swgl_raster_flush(setup->ctx);
+    setup->stateIndex = swgl_record_state(setup->ctx, setup->program);
+    return setup->stateIndex >= 0;
+}
+
+static void swgl_setup_triangle(SwglSetup *setup, const float *v0, const float *v1, const float *v2)
+{
+    SwglContext *ctx = setup->ctx;
+    SwglFrame *frame = &ctx->frame;
+    const float *v[3] = {v0, v1, v2};
+    float x[3], y[3], z[3], iw[3];
+    for (int i = 0; i < 3; ++i)
+        swgl_to_window(ctx, v[i], &x[i], &y[i], &z[i], &iw[i]);
+
+    float area2 = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area2 == 0.0f)
+        return;
+    int frontFacing = (ctx->frontFace == GL_CCW) == (area2 > 0.0f);
+    if (ctx->cullEnabled)
+    {
+        if (ctx->cullFace == GL_FRONT_AND_BACK)
+            return;
+        if ((ctx->cullFace == GL_FRONT) == frontFacing)
+            return;
+    }
+
+    int order[3] = {0, 1, 2};
+    if (area2 < 0.0f)
+    {
+        order[1] = 2;
+        order[2] = 1;
+        area2 = -area2;
+    }
+
+    if (!swgl_reserve_prim(setup))
+        return;
+    const SwglDrawState *state = &frame->states[setup->stateIndex];
+    float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+    for (int i = 1; i < 3; ++i)
+    {
+        minX = x[i] < minX ? x[i] : minX;
+        maxX = x[i] > maxX ? x[i] : maxX;
+        minY = y[i] < minY ? y[i] : minY;
+        maxY = y[i] > maxY ? y[i] : maxY;
+    }
+    // Pixel i is a candidate when its center i + 0.5 lies inside the box
+    minX = fmaxf(ceilf(minX - 0.5f), (float)state->clip[0]);
+    minY = fmaxf(ceilf(minY - 0.5f), (float)state->clip[1]);
+    maxX = fminf(floorf(maxX - 0.5f) + 1.0f, (float)state->clip[2]);
+    maxY = fminf(floorf(maxY - 0.5f) + 1.0f, (float)state->clip[3]);
+    if (minX >= maxX || minY >= maxY)
+        return;
+
+    SwglPrim *p = swgl_new_prim(frame);
+    if (!p)
+        return;
+    p->type = SWGL_PRIM_TRIANGLE;
+    p->state = setup->stateIndex;
+    p->bounds[0] = (int)minX;
+    p->bounds[1] = (int)minY;
+    p->bounds[2] = (int)maxX;
+    p->bounds[3] = (int)maxY;
+    p->frontFacing = frontFacing;
+    p->invArea2 = 1.0f / area2;
+    for (int k = 0; k < 3; ++k)
+    {
+        // Edge k runs between the two vertices opposite vertex k
+        int i = order[(k + 1) % 3], j = order[(k + 2) % 3];
+        p->edgeA[k] = y[i] - y[j];
+        p->edgeB[k] = x[j] - x[i];
+        p->edgeC[k] = x[i] * y[j] - x[j] * y[i];
+        // Top-left rule of a y-down raster, i.e. bottom and left edges own
+        // their pixels in GL window coordinates, as hardware does
+        if (p->edgeA[k] > 0.0f || (p->edgeA[k] == 0.0f && p->edgeB[k] > 0.0f))
+            p->topLeft |= 1u << k;
+        p->z[k] = z[order[k]];
+        p->invW[k] = iw[order[k]];
+    }
+
+    int vc = setup->varyingCount;
+    if (vc > 0)
+    {
+        size_t offset;
+        float *dst = swgl_frame_floats(frame, (size_t)vc * 3, &offset);
+        if (!dst)
+            return;
+        p->varyingOffset = offset;
+        for (int k = 0; k < 3; ++k)
+        {
+            const float *src = v[order[k]] + SWGL_VERTEX_HEADER;
+            for (int j = 0; j < vc; ++j)
+                dst[k * vc + j] = src[j] * iw[order[k]];
+        }
+    }
+    atomic_fetch_add_explicit(&swgl_stat_primitives, 1, memory_order_relaxed);
+    swgl_bin_prim(frame, (uint32_t)frame->primCount++);
+}
+
+static float swgl_clip_distance(const float *v, int plane)
+{
+    switch (plane)
+    {
+    case 0: return v[2] + v[3];                   // near
+    case 1: return v[3] - v[2];                   // far
+    case 2: return v[0] + SWGL_GUARD_BAND * v[3]; // guard band keeps the
+    case 3: return SWGL_GUARD_BAND * v[3] - v[0]; // edge equations in range
+    case 4: return v[1] + SWGL_GUARD_BAND * v[3];
+    case 5: return SWGL_GUARD_BAND * v[3] - v[1];
+    default: return v[3] - 1e-6f;                 // w > 0
+    }
+}
+
+#define SWGL_CLIP_PLANES 7
+
+static void swgl_clip_triangle(SwglSetup *setup, const float *v0, const float *v1, const float *v2)
+{
+    const float *v[3] = {v0, v1, v2};
+    unsigned outside[3] = {0, 0, 0};
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int plane = 0; plane < SWGL_CLIP_PLANES; ++plane)
+        {
+            if (swgl_clip_distance(v[i], plane) < 0.0f)
+                outside[i] |= 1u << plane;
+        }
+    }
+    if (outside[0] & outside[1] & outside[2])
+        return;
+    if (!(outside[0] | outside[1] | outside[2]))
+    {
+        swgl_setup_triangle(setup, v0, v1, v2);
+        return;
+    }
+
+    // Sutherland-Hodgman in homogeneous clip space
+    enum { SWGL_CLIP_FLOATS = SWGL_VERTEX_HEADER + SWGL_MAX_VARYINGS };
+    float buffers[2][SWGL_MAX_CLIP_VERTICES][SWGL_CLIP_FLOATS];
+    int stride = setup->stride;
+    int count = 3;
+    for (int i = 0; i < 3; ++i)
+        memcpy(buffers[0][i], v[i], stride * sizeof(float));
+    int src = 0;
+    for (int plane = 0; plane < SWGL_CLIP_PLANES && count >= 3; ++plane)
+    {
+        if (!((outside[0] | outside[1] | outside[2]) & (1u << plane)))
+            continue;
+        int dst = src ^ 1, out = 0;
+        for (int i = 0; i < count && out < SWGL_MAX_CLIP_VERTICES - 1; ++i)
+        {
+            const float *a = buffers[src][i];
+            const float *b = buffers[src][(i + 1) % count];
+            float da = swgl_clip_distance(a, plane), db = swgl_clip_distance(b, plane);
+            if (da >= 0.0f)
+                memcpy(buffers[dst][out++], a, stride * sizeof(float));
+            if ((da >= 0.0f) != (db >= 0.0f))
+            {
+                float t = da / (da - db);
+                for (int f = 0; f < stride; ++f)
+                    buffers[dst][out][f] = a[f] + (b[f] - a[f]) * t;
+                out++;
+            }
+        }
+        count = out;
+        src = dst;
+    }
+    for (int i = 1; i + 1 < count; ++i)
+        swgl_setup_triangle(setup, buffers[src][0], buffers[src][i], buffers[src][i + 1]);
+}
+
+static void swgl_setup_point(SwglSetup *setup, const float *v)
+{
+    SwglContext *ctx = setup->ctx;
+    SwglFrame *frame = &ctx->frame;
+    if (v[3] <= 0.0f || fabsf(v[0]) > v[3] || fabsf(v[1]) > v[3] || fabsf(v[2]) > v[3])
+        return; // points are clipped by their center
+    float x, y, z, iw;
+    swgl_to_window(ctx, v, &x, &y, &z, &iw);
+    float size = v[4];
+    size = size < 1.0f ? 1.0f : (size > SWGL_MAX_POINT_SIZE ? SWGL_MAX_POINT_SIZE : size);
+
+    if (!swgl_reserve_prim(setup))
+        return;
+    const SwglDrawState *state = &frame->states[setup->stateIndex];
+    float half = size * 0.5f;
+    float minX = fmaxf(ceilf(x - half - 0.5f), (float)state->clip[0]);
+    float minY = fmaxf(ceilf(y - half - 0.5f), (float)state->clip[1]);
+    float maxX = fminf(ceilf(x + half - 0.5f), (float)state->clip[2]);
+    float maxY = fminf(ceilf(y + half - 0.5f), (float)state->clip[3]);
+    if (minX >= maxX || minY >= maxY)
+        return;
+
+    SwglPrim *p = swgl_new_prim(frame);
+    if (!p)
+        return;
+    p->type = SWGL_PRIM_POINT;
+    p->state = setup->stateIndex;
+    p->bounds[0] = (int)minX;
+    p->bounds[1] = (int)minY;
+    p->bounds[2] = (int)maxX;
+    p->bounds[3] = (int)maxY;
+    p->frontFacing = 1;
+    p->pointX = x;
+    p->pointY = y;
+    p->pointSize = size;
+    p->z[0] = z;
+    p->invW[0] = iw;
+    int vc = setup->varyingCount;
+    if (vc > 0)
+    {
+        size_t offset;
+        float *dst = swgl_frame_floats(frame, (size_t)vc, &offset);
+        if (!dst)
+            return;
+        p->varyingOffset = offset;
+        memcpy(dst, v + SWGL_VERTEX_HEADER, vc * sizeof(float));
+    }
+    atomic_fetch_add_explicit(&swgl_stat_primitives, 1, memory_order_relaxed);
+    swgl_bin_prim(frame, (uint32_t)frame->primCount++);
+}
+
+static GLuint swgl_read_index(const void *indices, GLenum type, GLsizei i)
+{
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE:
+        return ((const GLubyte *)indices)[i];
+    case GL_UNSIGNED_SHORT:
+        return ((const GLushort *)indices)[i];
+    default:
+        return ((const GLuint *)indices)[i];
+    }
+}
+
+void swgl_raster_draw(SwglContext *ctx, GLenum mode, GLint first, GLsizei count, GLenum indexType, const void *indices)
+{
+    if (count <= 0 || ctx->framebuffer)
+        return; // only the default framebuffer is backed by memory
+    SwglProgram *program = (SwglProgram *)swgl_names_get(&ctx->objects, ctx->currentProgram);
+    if (!program || program->kind != SWGL_OBJECT_PROGRAM || !program->linked)
+        return;
+    if (mode == GL_LINES || mode == GL_LINE_STRIP || mode == GL_LINE_LOOP)
+    {
+        if (!ctx->warnedLines)
+            printf("WARNING: swgl does not rasterize lines; line draws are skipped\n");
+        ctx->warnedLines = 1;
+        return;
+    }
+
+    // Resolve the index source and the vertex range the draw touches
+    GLuint minIndex = (GLuint)first, maxIndex = (GLuint)(first + count - 1);
+    const void *indexData = NULL;
+    if (indexType)
+    {
+        int indexSize = indexType == GL_UNSIGNED_BYTE ? 1 : (indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+        if (ctx->elementArrayBuffer)
+        {
+            const SwglBuffer *buffer = (const SwglBuffer *)swgl_names_get(&ctx->buffers, ctx->elementArrayBuffer);
+            size_t offset = (size_t)(uintptr_t)indices;
+            if (!buffer || !buffer->data || offset + (size_t)count * indexSize > (size_t)buffer->size)
+                return;
+            indexData = buffer->data + offset;
+        }
+        else
+        {
+            indexData = indices;
+        }
+        minIndex = 0xFFFFFFFFu;
+        maxIndex = 0;
+        for (GLsizei i = 0; i < count; ++i)
+        {
+            GLuint index = swgl_read_index(indexData, indexType, i);
+            minIndex = index < minIndex ? index : minIndex;
+            maxIndex = index > maxIndex ? index : maxIndex;
+        }
+    }
+
+    if (!swgl_shade_vertices(ctx, program, (GLint)minIndex, (int)(maxIndex - minIndex + 1)))
+    {
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return;
+    }
+
+    SwglSetup setup;
+    setup.ctx = ctx;
+    setup.program = program;
+    setup.stateIndex = swgl_record_state(ctx, program);
+    setup.stride = SWGL_VERTEX_HEADER + program->varyingCount;
+    setup.varyingCount = program->varyingCount;
+    if (setup.stateIndex < 0)
+    {
+        swgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return;
+    }
+
+#define SWGL_VERTEX(i) (ctx->vertexScratch + \
+    (size_t)((indexData ? swgl_read_index(indexData, indexType, (i)) : (GLuint)(first + (i))) - minIndex) * setup.stride)
+
+    switch (mode)
+    {
+    case GL_POINTS:
+        for (GLsizei i = 0; i < count; ++i)
+            swgl_setup_point(&setup, SWGL_VERTEX(i));
+        break;
+    case GL_TRIANGLES:
+        for (GLsizei i = 0; i + 2 < count; i += 3)
+            swgl_clip_triangle(&setup, SWGL_VERTEX(i), SWGL_VERTEX(i + 1), SWGL_VERTEX(i + 2));
+        break;
+    case GL_TRIANGLE_STRIP:
+        for (GLsizei i = 0; i + 2 < count; ++i)
+        {
+            if (i & 1)
+                swgl_clip_triangle(&setup, SWGL_VERTEX(i + 1), SWGL_VERTEX(i), SWGL_VERTEX(i + 2));
+            else
+                swgl_clip_triangle(&setup, SWGL_VERTEX(i), SWGL_VERTEX(i + 1), SWGL_VERTEX(i + 2));
+        }
+        break;
+    case GL_TRIANGLE_FAN:
+        for (GLsizei i = 1; i + 1 < count; ++i)
+            swgl_clip_triangle(&setup, SWGL_VERTEX(0), SWGL_VERTEX(i), SWGL_VERTEX(i + 1));
+        break;
+    default:
+        swgl_set_error(ctx, GL_INVALID_ENUM);
+        break;
+    }
+#undef SWGL_VERTEX
+}
+
+// ---------------------------------------------------------------------------
+// Tile rasterization
+
+// Computes the blend factor of channel c for every lane.
+static void swgl_blend_factor(GLenum factor, int c, const float src[4][SWGL_LANES],
+                              const float dst[4][SWGL_LANES], const float constant[4], float o[SWGL_LANES])
+{
+    switch (factor)
+    {
+    case GL_ZERO:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 0.0f;
+        break;
+    case GL_ONE:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f;
+        break;
+    case GL_SRC_COLOR:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = src[c][l];
+        break;
+    case GL_ONE_MINUS_SRC_COLOR:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f - src[c][l];
+        break;
+    case GL_DST_COLOR:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = dst[c][l];
+        break;
+    case GL_ONE_MINUS_DST_COLOR:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f - dst[c][l];
+        break;
+    case GL_SRC_ALPHA:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = src[3][l];
+        break;
+    case GL_ONE_MINUS_SRC_ALPHA:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f - src[3][l];
+        break;
+    case GL_DST_ALPHA:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = dst[3][l];
+        break;
+    case GL_ONE_MINUS_DST_ALPHA:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f - dst[3][l];
+        break;
+    case GL_CONSTANT_COLOR:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = constant[c];
+        break;
+    case GL_ONE_MINUS_CONSTANT_COLOR:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f - constant[c];
+        break;
+    case GL_CONSTANT_ALPHA:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = constant[3];
+        break;
+    case GL_ONE_MINUS_CONSTANT_ALPHA:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 1.0f - constant[3];
+        break;
+    case GL_SRC_ALPHA_SATURATE:
+        for (int l = 0; l < SWGL_LANES; ++l)
+        {
+            float f = 1.0f - dst[3][l];
+            o[l] = c == 3 ? 1.0f : (src[3][l] < f ? src[3][l] : f);
+        }
+        break;
+    default:
+        for (int l = 0; l < SWGL_LANES; ++l) o[l] = 0.0f;
+        break;
+    }
+}
+
+static void swgl_blend_equation(GLenum equation, float out[SWGL_LANES], const float sf[SWGL_LANES],
+                                const float d[SWGL_LANES], const float df[SWGL_LANES])
+{
+    float v[SWGL_LANES];
+    switch (equation)
+    {
+    case GL_FUNC_SUBTRACT:
+        for (int l = 0; l < SWGL_LANES; ++l) v[l] = out[l] * sf[l] - d[l] * df[l];
+        break;
+    case GL_FUNC_REVERSE_SUBTRACT:
+        for (int l = 0; l < SWGL_LANES; ++l) v[l] = d[l] * df[l] - out[l] * sf[l];
+        break;
+    default:
+        for (int l = 0; l < SWGL_LANES; ++l) v[l] = out[l] * sf[l] + d[l] * df[l];
+        break;
+    }
+    for (int l = 0; l < SWGL_LANES; ++l)
+        out[l] = v[l] < 0.0f ? 0.0f : (v[l] > 1.0f ? 1.0f : v[l]);
+}
+
+// Blends and stores up to SWGL_LANES pixels. Pixels are handled as packed
+// little-endian RGBA8 words so the unpack/pack loops vectorize.
+static void swgl_write_span(const SwglDrawState *state, uint8_t *dst, unsigned mask, const float color[4][SWGL_LANES])
+{
+    // Lanes past the highest covered one may lie beyond the end of the row
+    int lanes = 32 - __builtin_clz(mask);
+    const unsigned char *colorMask = state->colorMask;
+    int writeAll = colorMask[0] && colorMask[1] && colorMask[2] && colorMask[3];
+    uint32_t old[SWGL_LANES] = {0};
+    if (state->blendEnabled || !writeAll)
+    {
+        if (lanes == SWGL_LANES)
+            memcpy(old, dst, sizeof(old));
+        else
+            memcpy(old, dst, (size_t)lanes * 4);
+    }
+
+    float src[4][SWGL_LANES];
+    for (int c = 0; c < 4; ++c)
+    {
+        for (int l = 0; l < SWGL_LANES; ++l)
+        {
+            float v = color[c][l];
+            src[c][l] = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        }
+    }
+
+    if (state->blendEnabled)
+    {
+        float d[4][SWGL_LANES], sf[4][SWGL_LANES], df[4][SWGL_LANES];
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int l = 0; l < SWGL_LANES; ++l)
+                d[c][l] = (float)(int32_t)((old[l] >> (8 * c)) & 0xFFu) * (1.0f / 255.0f);
+        }
+        for (int c = 0; c < 4; ++c)
+        {
+            swgl_blend_factor(c < 3 ? state->blendSrcRGB : state->blendSrcAlpha, c, src, d, state->blendColor, sf[c]);
+            swgl_blend_factor(c < 3 ? state->blendDstRGB : state->blendDstAlpha, c, src, d, state->blendColor, df[c]);
+        }
+        for (int c = 0; c < 4; ++c)
+            swgl_blend_equation(c < 3 ? state->blendEquationRGB : state->blendEquationAlpha, src[c], sf[c], d[c], df[c]);
+    }
+
+    uint32_t out[SWGL_LANES];
+    for (int l = 0; l < SWGL_LANES; ++l)
+    {
+        // Signed conversions map to single SSE2 instructions, unsigned ones do not
+        out[l] = (uint32_t)(int32_t)(src[0][l] * 255.0f + 0.5f) |
+                 (uint32_t)(int32_t)(src[1][l] * 255.0f + 0.5f) << 8 |
+                 (uint32_t)(int32_t)(src[2][l] * 255.0f + 0.5f) << 16 |
+                 (uint32_t)(int32_t)(src[3][l] * 255.0f + 0.5f) << 24;
+    }
+    if (!writeAll)
+    {
+        uint32_t keep = (colorMask[0] ? 0u : 0xFFu) | (colorMask[1] ? 0u : 0xFF00u) |
+                        (colorMask[2] ? 0u : 0xFF0000u) | (colorMask[3] ? 0u : 0xFF000000u);
+        for (int l = 0; l < SWGL_LANES; ++l)
+            out[l] = (out[l] & ~keep) | (old[l] & keep);
+    }
+    if (mask == 0xFFu)
+    {
+        memcpy(dst, out, sizeof(out));
+        return;
+    }
+    for (int l = 0; l < lanes; ++l)
+    {
+        if (mask & (1u << l))
+            memcpy(dst + l * 4, &out[l], 4);
+    }
+}
+
+// Evaluates the three edge functions for SWGL_LANES pixel centers of a row
+// and returns the coverage mask, honouring the top-left fill rule.
+static unsigned swgl_edge_mask(const SwglPrim *p, int x, float py, int remaining, float e[3][SWGL_LANES])
+{
+    unsigned mask = remaining >= SWGL_LANES ? 0xFFu : (1u << remaining) - 1u;
+#if defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 px0 = _mm_add_ps(_mm_set1_ps((float)x), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+    const __m128 px1 = _mm_add_ps(px0, _mm_set1_ps(4.0f));
+    for (int k = 0; k < 3; ++k)
+    {
+        __m128 a = _mm_set1_ps(p->edgeA[k]);
+        __m128 row = _mm_set1_ps(p->edgeB[k] * py + p->edgeC[k]);
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(a, px0), row);
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(a, px1), row);
+        _mm_storeu_ps(&e[k][0], e0);
+        _mm_storeu_ps(&e[k][4], e1);
+        int covered;
+        if (p->topLeft & (1u << k))
+            covered = _mm_movemask_ps(_mm_cmpge_ps(e0, zero)) | (_mm_movemask_ps(_mm_cmpge_ps(e1, zero)) << 4);
+        else
+            covered = _mm_movemask_ps(_mm_cmpgt_ps(e0, zero)) | (_mm_movemask_ps(_mm_cmpgt_ps(e1, zero)) << 4);
+        mask &= (unsigned)covered;
+    }
+#else
+    for (int k = 0; k < 3; ++k)
+    {
+        float row = p->edgeB[k] * py + p->edgeC[k];
+        int inclusive = (p->topLeft >> k) & 1u;
+        for (int l = 0; l < SWGL_LANES; ++l)
+        {
+            float v = p->edgeA[k] * ((float)x + (l + 0.5f)) + row;
+            e[k][l] = v;
+            if (inclusive ? v < 0.0f : v <= 0.0f)
+                mask &= ~(1u << l);
+        }
+    }
+#endif
+    return mask;
+}
+
+static unsigned long long swgl_raster_triangle(const SwglContext *ctx, const SwglPrim *p, const SwglDrawState *state,
+                                               const int r[4])
+{
+    const SwglFrame *frame = &ctx->frame;
+    const float *uniforms = frame->floats + state->uniformOffset;
+    const float *varyings = frame->floats + p->varyingOffset;
+    int vc = state->varyingCount;
+    unsigned long long fragments = 0;
+    SwglFragments frag;
+    float e[3][SWGL_LANES];
+    float color[4][SWGL_LANES];
+    memset(frag.pointCoord, 0, sizeof(frag.pointCoord));
+    frag.frontFacing = p->frontFacing;
+
+    for (int y = r[1]; y < r[3]; ++y)
+    {
+        float py = y + 0.5f;
+        uint8_t *row = (uint8_t *)(ctx->color + (size_t)y * ctx->width);
+        for (int x = r[0]; x < r[2]; x += SWGL_LANES)
+        {
+            unsigned mask = swgl_edge_mask(p, x, py, r[2] - x, e);
+            if (!mask)
+                continue;
+            float b[3][SWGL_LANES];
+            for (int l = 0; l < SWGL_LANES; ++l)
+            {
+                b[0][l] = e[0][l] * p->invArea2;
+                b[1][l] = e[1][l] * p->invArea2;
+                b[2][l] = e[2][l] * p->invArea2;
+                float ow = b[0][l] * p->invW[0] + b[1][l] * p->invW[1] + b[2][l] * p->invW[2];
+                frag.fragCoord[0][l] = (float)x + (l + 0.5f);
+                frag.fragCoord[1][l] = py;
+                frag.fragCoord[2][l] = b[0][l] * p->z[0] + b[1][l] * p->z[1] + b[2][l] * p->z[2];
+                frag.fragCoord[3][l] = ow;
+                // Perspective-correct weights for the w-divided varyings
+                float rw = ow != 0.0f ? 1.0f / ow : 0.0f;
+                b[0][l] *= rw;
+                b[1][l] *= rw;
+                b[2][l] *= rw;
+            }
+            for (int j = 0; j < vc; ++j)
+            {
+                float v0 = varyings[j], v1 = varyings[vc + j], v2 = varyings[2 * vc + j];
+                for (int l = 0; l < SWGL_LANES; ++l)
+                    frag.varyings[j][l] = b[0][l] * v0 + b[1][l] * v1 + b[2][l] * v2;
+            }
+            frag.mask = mask;
+            mask &= swgl_program_shade_fragments(state->program, uniforms, &frag, color);
+            if (!mask)
+                continue;
+            swgl_write_span(state, row + (size_t)x * 4, mask, color);
+            fragments += (unsigned long long)__builtin_popcount(mask);
+        }
+    }
+    return fragments;
+}
+
+static unsigned long long swgl_raster_point(const SwglContext *ctx, const SwglPrim *p, const SwglDrawState *state,
+                                            const int r[4])
+{
+    const SwglFrame *frame = &ctx->frame;
+    const float *uniforms = frame->floats + state->uniformOffset;
+    const float *varyings = frame->floats + p->varyingOffset;
+    unsigned long long fragments = 0;
+    SwglFragments frag;
+    float color[4][SWGL_LANES];
+    frag.frontFacing = 1;
+    for (int j = 0; j < state->varyingCount; ++j)
+    {
+        for (int l = 0; l < SWGL_LANES; ++l)
+            frag.varyings[j][l] = varyings[j];
+    }
+    float invSize = 1.0f / p->pointSize;
+
+    for (int y = r[1]; y < r[3]; ++y)
+    {
+        float py = y + 0.5f;
+        uint8_t *row = (uint8_t *)(ctx->color + (size_t)y * ctx->width);
+        for (int x = r[0]; x < r[2]; x += SWGL_LANES)
+        {
+            unsigned mask = r[2] - x >= SWGL_LANES ? 0xFFu : (1u << (r[2] - x)) - 1u;
+            for (int l = 0; l < SWGL_LANES; ++l)
+            {
+                float px = (float)x + (l + 0.5f);
+                frag.fragCoord[0][l] = px;
+                frag.fragCoord[1][l] = py;
+                frag.fragCoord[2][l] = p->z[0];
+                frag.fragCoord[3][l] = p->invW[0];
+                // Point sprite coordinates run top to bottom
+                frag.pointCoord[0][l] = 0.5f + (px - p->pointX) * invSize;
+                frag.pointCoord[1][l] = 0.5f - (py - p->pointY) * invSize;
+            }
+            frag.mask = mask;
+            mask &= swgl_program_shade_fragments(state->program, uniforms, &frag, color);
+            if (!mask)
+                continue;
+            swgl_write_span(state, row + (size_t)x * 4, mask, color);
+            fragments += (unsigned long long)__builtin_popcount(mask);
+        }
+    }
+    return fragments;
+}
+
+static void swgl_raster_fill(const SwglContext *ctx, const SwglPrim *p, const SwglDrawState *state, const int r[4])
+{
+    uint8_t bytes[4];
+    memcpy(bytes, &p->clearColor, sizeof(bytes));
+    int fullMask = state->colorMask[0] && state->colorMask[1] && state->colorMask[2] && state->colorMask[3];
+    for (int y = r[1]; y < r[3]; ++y)
+    {
+        uint32_t *row = ctx->color + (size_t)y * ctx->width;
+        if (fullMask)
+        {
+            for (int x = r[0]; x < r[2]; ++x)
+                row[x] = p->clearColor;
+            continue;
+        }
+        for (int x = r[0]; x < r[2]; ++x)
+        {
+            uint8_t *px = (uint8_t *)(row + x);
+            for (int c = 0; c < 4; ++c)
+            {
+                if (state->colorMask[c])
+                    px[c] = bytes[c];
+            }
+        }
+    }
+}
+
+static void swgl_tile_task(void *userData, int taskIndex, int workerIndex)
+{
+    (void)workerIndex;
+    const SwglContext *ctx = (const SwglContext *)userData;
+    const SwglFrame *frame = &ctx->frame;
+    int tile = frame->activeTiles[taskIndex];
+    int tx = tile % frame->tilesX, ty = tile / frame->tilesX;
+    int tileRect[4] = {tx * SWGL_TILE_SIZE, ty * SWGL_TILE_SIZE,
+                       (tx + 1) * SWGL_TILE_SIZE, (ty + 1) * SWGL_TILE_SIZE};
+    const SwglBin *bin = &frame->bins[tile];
+    unsigned long long fragments = 0;
+    for (uint32_t i = 0; i < bin->count; ++i)
+    {
+        const SwglPrim *p = &frame->prims[bin->items[i]];
+        const SwglDrawState *state = &frame->states[p->state];
+        int r[4];
+        if (!swgl_intersect(r, p->bounds, tileRect))
+            continue;
+        switch (p->type)
+        {
+        case SWGL_PRIM_CLEAR:
+            swgl_raster_fill(ctx, p, state, r);
+            break;
+        case SWGL_PRIM_TRIANGLE:
+            fragments += swgl_raster_triangle(ctx, p, state, r);
+            break;
+        case SWGL_PRIM_POINT:
+            fragments += swgl_raster_point(ctx, p, state, r);
+            break;
+        }
+    }
+    atomic_fetch_add_explicit(&swgl_stat_fragments, fragments, memory_order_relaxed);
+}
+
+void swgl_raster_flush(SwglContext *ctx)
+{
+    SwglFrame *frame = &ctx->frame;
+    if (frame->primCount == 0)
+        return;
+    int active = 0;
+    for (int i = 0; i < frame->tilesX * frame->tilesY; ++i)
+    {
+        if (frame->bins[i].count)
+            frame->activeTiles[active++] = i;
+    }
+    SwglThreadPool *pool = swgl_pool_acquire();
+    swgl_threadpool_run(pool, swgl_tile_task, ctx, active);
+    swgl_pool_release();
+    atomic_fetch_add(&swgl_stat_flushes, 1);
+    swgl_frame_reset(frame);
+}
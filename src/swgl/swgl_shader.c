@@ -0,0 +1,245 @@
+// swgl_shader.c
+// Shader backend: sources are compiled by the GLSL engine (swgl_glsl_*.c)
+// and linked programs run SWGL_LANES vertices or fragments per call. Each
+// program keeps its own copies of the two stages with the uniform offsets of
+// the program's storage, and each thread has its own register file.
+#include "swgl_internal.h"
+
+#include "swgl/swgl_glsl.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SWGL_MAX_INPUT_ROWS (SWGL_MAX_ATTRIBS * 4)
+#define SWGL_MAX_OUTPUT_ROWS (SWGL_VERTEX_HEADER + SWGL_MAX_VARYINGS)
+
+typedef struct SwglProgramImpl
+{
+    SwglGlslShader *vertex;
+    SwglGlslShader *fragment;
+    int inputRows;
+    int inputFloat[SWGL_MAX_INPUT_ROWS];    // attribute float of each vertex input row
+    int fragmentRows;
+    int fragmentVarying[SWGL_MAX_VARYINGS]; // varying of each fragment input row
+} SwglProgramImpl;
+
+static pthread_once_t swgl_exec_once = PTHREAD_ONCE_INIT;
+static pthread_key_t swgl_exec_key;
+
+static void swgl_exec_release(void *exec)
+{
+    swgl_glsl_exec_destroy((SwglGlslExec *)exec);
+}
+
+static void swgl_exec_key_create(void)
+{
+    pthread_key_create(&swgl_exec_key, swgl_exec_release);
+}
+
+// Register file of the calling thread
+static SwglGlslExec *swgl_thread_exec(void)
+{
+    pthread_once(&swgl_exec_once, swgl_exec_key_create);
+    SwglGlslExec *exec = (SwglGlslExec *)pthread_getspecific(swgl_exec_key);
+    if (!exec)
+    {
+        exec = swgl_glsl_exec_create();
+        if (exec)
+            pthread_setspecific(swgl_exec_key, exec);
+    }
+    return exec;
+}
+
+int swgl_shader_compile(SwglShader *shader)
+{
+    char log[1024];
+    SwglGlslStage stage = shader->type == GL_VERTEX_SHADER ? SWGL_GLSL_VERTEX : SWGL_GLSL_FRAGMENT;
+    SwglGlslShader *compiled = swgl_glsl_compile(stage, shader->source, log, sizeof(log));
+    if (!compiled)
+    {
+        swgl_shader_set_info_log(shader, log);
+        return 0;
+    }
+    shader->impl = compiled;
+    return 1;
+}
+
+void swgl_shader_release(SwglShader *shader)
+{
+    swgl_glsl_free((SwglGlslShader *)shader->impl);
+    shader->impl = NULL;
+}
+
+static int swgl_link_error(SwglProgram *program, const char *format, const char *name)
+{
+    char message[256];
+    snprintf(message, sizeof(message), format, name);
+    swgl_program_set_info_log(program, message);
+    return 0;
+}
+
+// Gives the stage's uniforms their place in the program's uniform storage.
+static int swgl_link_uniforms(SwglProgram *program, SwglGlslShader *shader)
+{
+    for (int i = 0; i < swgl_glsl_variable_count(shader, SWGL_GLSL_UNIFORM); ++i)
+    {
+        const SwglGlslVariable *var = swgl_glsl_variable(shader, SWGL_GLSL_UNIFORM, i);
+        int offset = swgl_program_add_uniform(program, var->name, var->type, var->arraySize);
+        for (int u = 0; offset >= 0 && u < program->uniformCount; ++u)
+        {
+            if (strcmp(program->uniforms[u].name, var->name) == 0 && program->uniforms[u].size != var->arraySize)
+                offset = -1;
+        }
+        if (offset < 0)
+            return swgl_link_error(program, "ERROR: uniform '%s' differs between the shaders\n", var->name);
+        if (offset / 4 + (var->components * var->arraySize + 3) / 4 > SWGL_MAX_UNIFORM_VECTORS)
+            return swgl_link_error(program, "ERROR: too many uniforms ('%s')\n", var->name);
+        swgl_glsl_set_uniform_offset(shader, i, offset);
+    }
+    return 1;
+}
+
+int swgl_program_link(SwglProgram *program, SwglShader *vertexShader, SwglShader *fragmentShader)
+{
+    SwglProgramImpl *impl = (SwglProgramImpl *)calloc(1, sizeof(SwglProgramImpl));
+    if (!impl)
+    {
+        swgl_program_set_info_log(program, "ERROR: out of memory\n");
+        return 0;
+    }
+    program->impl = impl;
+    impl->vertex = swgl_glsl_clone((const SwglGlslShader *)vertexShader->impl);
+    impl->fragment = swgl_glsl_clone((const SwglGlslShader *)fragmentShader->impl);
+    if (!impl->vertex || !impl->fragment)
+    {
+        swgl_program_set_info_log(program, "ERROR: out of memory\n");
+        return 0;
+    }
+
+    // Attributes: input row r of an attribute reads component r % 4 of
+    // location + r / 4, or column-major from consecutive locations for matrices
+    impl->inputRows = swgl_glsl_input_rows(impl->vertex);
+    for (int i = 0; i < swgl_glsl_variable_count(impl->vertex, SWGL_GLSL_ATTRIBUTE); ++i)
+    {
+        const SwglGlslVariable *var = swgl_glsl_variable(impl->vertex, SWGL_GLSL_ATTRIBUTE, i);
+        int location = swgl_program_add_attrib(program, var->name, var->type);
+        if (location < 0)
+            return swgl_link_error(program, "ERROR: too many vertex attributes ('%s')\n", var->name);
+        int columns = var->type == GL_FLOAT_MAT2 ? 2 : var->type == GL_FLOAT_MAT3 ? 3 : var->type == GL_FLOAT_MAT4 ? 4 : 1;
+        int rows = var->components / columns;
+        for (int r = 0; r < var->components; ++r)
+            impl->inputFloat[var->offset + r] = (location + r / rows) * 4 + r % rows;
+    }
+
+    if (!swgl_link_uniforms(program, impl->vertex) || !swgl_link_uniforms(program, impl->fragment))
+        return 0;
+
+    // Varyings are matched by name; the vertex stage writes all it declares
+    int outputs = swgl_glsl_output_rows(impl->vertex);
+    if (outputs > SWGL_MAX_OUTPUT_ROWS)
+        return swgl_link_error(program, "ERROR: too many varyings%s\n", "");
+    impl->fragmentRows = swgl_glsl_input_rows(impl->fragment);
+    for (int i = 0; i < swgl_glsl_variable_count(impl->fragment, SWGL_GLSL_VARYING); ++i)
+    {
+        const SwglGlslVariable *in = swgl_glsl_variable(impl->fragment, SWGL_GLSL_VARYING, i);
+        const SwglGlslVariable *out = NULL;
+        for (int j = 0; j < swgl_glsl_variable_count(impl->vertex, SWGL_GLSL_VARYING) && !out; ++j)
+        {
+            const SwglGlslVariable *candidate = swgl_glsl_variable(impl->vertex, SWGL_GLSL_VARYING, j);
+            if (strcmp(candidate->name, in->name) == 0)
+                out = candidate;
+        }
+        if (!out)
+            return swgl_link_error(program, "ERROR: varying '%s' is not declared in the vertex shader\n", in->name);
+        if (out->type != in->type || out->arraySize != in->arraySize)
+            return swgl_link_error(program, "ERROR: varying '%s' has different types in the two shaders\n", in->name);
+        for (int r = 0; r < in->components * in->arraySize; ++r)
+            impl->fragmentVarying[in->offset + r] = out->offset - SWGL_VERTEX_HEADER + r;
+    }
+    program->varyingCount = outputs - SWGL_VERTEX_HEADER;
+    return 1;
+}
+
+void swgl_program_release(SwglProgram *program)
+{
+    SwglProgramImpl *impl = (SwglProgramImpl *)program->impl;
+    if (impl)
+    {
+        swgl_glsl_free(impl->vertex);
+        swgl_glsl_free(impl->fragment);
+        free(impl);
+    }
+    program->impl = NULL;
+}
+
+void swgl_program_shade_vertices(const SwglProgram *program, const float *uniforms,
+                                 const float *attribs, int count, float *out)
+{
+    const SwglProgramImpl *impl = (const SwglProgramImpl *)program->impl;
+    int stride = SWGL_VERTEX_HEADER + program->varyingCount;
+    int slots = program->attribSlots * 4;
+    SwglGlslExec *exec = swgl_thread_exec();
+    if (!exec)
+    {
+        memset(out, 0, (size_t)count * stride * sizeof(float));
+        return;
+    }
+    float in[SWGL_MAX_INPUT_ROWS][SWGL_LANES];
+    float result[SWGL_MAX_OUTPUT_ROWS][SWGL_LANES];
+    const float *inputs[SWGL_MAX_INPUT_ROWS];
+    float *outputs[SWGL_MAX_OUTPUT_ROWS];
+    for (int r = 0; r < SWGL_MAX_INPUT_ROWS; ++r)
+        inputs[r] = in[r];
+    for (int r = 0; r < SWGL_MAX_OUTPUT_ROWS; ++r)
+        outputs[r] = result[r];
+    SwglGlslBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.uniforms = uniforms;
+    batch.inputs = inputs;
+    batch.outputs = outputs;
+
+    // Vertices are transposed into rows of SWGL_LANES and back
+    for (int first = 0; first < count; first += SWGL_LANES)
+    {
+        int n = count - first < SWGL_LANES ? count - first : SWGL_LANES;
+        const float *vertex = attribs + (size_t)first * slots;
+        for (int r = 0; r < impl->inputRows; ++r)
+        {
+            for (int lane = 0; lane < n; ++lane)
+                in[r][lane] = vertex[lane * slots + impl->inputFloat[r]];
+        }
+        batch.mask = (1u << n) - 1u;
+        swgl_glsl_run(exec, impl->vertex, &batch);
+        float *v = out + (size_t)first * stride;
+        for (int lane = 0; lane < n; ++lane)
+        {
+            for (int r = 0; r < stride; ++r)
+                v[lane * stride + r] = result[r][lane];
+        }
+    }
+}
+
+unsigned swgl_program_shade_fragments(const SwglProgram *program, const float *uniforms,
+                                      const SwglFragments *in, float color[4][SWGL_LANES])
+{
+    const SwglProgramImpl *impl = (const SwglProgramImpl *)program->impl;
+    SwglGlslExec *exec = swgl_thread_exec();
+    if (!exec)
+        return 0;
+    const float *inputs[SWGL_MAX_VARYINGS];
+    for (int r = 0; r < impl->fragmentRows; ++r)
+        inputs[r] = in->varyings[impl->fragmentVarying[r]];
+    float *outputs[4] = {color[0], color[1], color[2], color[3]};
+    SwglGlslBatch batch = {
+        in->mask,
+        uniforms,
+        inputs,
+        outputs,
+        {in->fragCoord[0], in->fragCoord[1], in->fragCoord[2], in->fragCoord[3]},
+        {in->pointCoord[0], in->pointCoord[1]},
+        in->frontFacing,
+    };
+    return swgl_glsl_run(exec, impl->fragment, &batch);
+}
@@ -0,0 +1,262 @@
+// swgl_threadpool.c
+// Work-stealing pool used to rasterize tiles and shade large vertex batches.
+// Every run splits the task range into contiguous blocks, one per worker
+// deque. Owners pop from the back of their own deque, idle workers steal
+// from the front of a peer's deque, so neighbouring tiles stay on one core
+// until the load becomes uneven.
+#include "swgl_internal.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct SwglDeque
+{
+    pthread_mutex_t lock;
+    int *tasks;
+    int head;
+    int tail;
+    int capacity;
+} SwglDeque;
+
+typedef struct SwglWorkerArgs
+{
+    SwglThreadPool *pool;
+    int index;
+} SwglWorkerArgs;
+
+struct SwglThreadPool
+{
+    int threadCount;
+    pthread_t *threads;
+    SwglWorkerArgs *args;
+    SwglDeque *deques;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned generation;
+    int shutdown;
+
+    SwglTaskFn fn;
+    void *userData;
+    atomic_int remaining;
+    atomic_ullong steals;
+};
+
+static int swgl_deque_pop(SwglDeque *deque, int *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head)
+    {
+        *task = deque->tasks[--deque->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static int swgl_deque_steal(SwglDeque *deque, int *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head)
+    {
+        *task = deque->tasks[deque->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static void swgl_threadpool_work(SwglThreadPool *pool, int worker)
+{
+    for (;;)
+    {
+        int task;
+        if (!swgl_deque_pop(&pool->deques[worker], &task))
+        {
+            int stolen = 0;
+            for (int i = 1; i < pool->threadCount && !stolen; ++i)
+            {
+                int victim = (worker + i) % pool->threadCount;
+                stolen = swgl_deque_steal(&pool->deques[victim], &task);
+            }
+            if (!stolen)
+                return;
+            atomic_fetch_add_explicit(&pool->steals, 1, memory_order_relaxed);
+        }
+        pool->fn(pool->userData, task, worker);
+        if (atomic_fetch_sub_explicit(&pool->remaining, 1, memory_order_acq_rel) == 1)
+        {
+            pthread_mutex_lock(&pool->lock);
+            pthread_cond_broadcast(&pool->done);
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+}
+
+static void *swgl_threadpool_main(void *arg)
+{
+    SwglWorkerArgs *args = (SwglWorkerArgs *)arg;
+    SwglThreadPool *pool = args->pool;
+    unsigned seen = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->shutdown)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        swgl_threadpool_work(pool, args->index);
+    }
+}
+
+SwglThreadPool *swgl_threadpool_create(int threadCount)
+{
+    if (threadCount < 1)
+        threadCount = 1;
+    SwglThreadPool *pool = (SwglThreadPool *)calloc(1, sizeof(SwglThreadPool));
+    if (!pool)
+        return NULL;
+    pool->threadCount = threadCount;
+    pool->deques = (SwglDeque *)calloc(threadCount, sizeof(SwglDeque));
+    pool->threads = (pthread_t *)calloc(threadCount, sizeof(pthread_t));
+    pool->args = (SwglWorkerArgs *)calloc(threadCount, sizeof(SwglWorkerArgs));
+    if (!pool->deques || !pool->threads || !pool->args)
+    {
+        free(pool->deques);
+        free(pool->threads);
+        free(pool->args);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->remaining, 0);
+    atomic_init(&pool->steals, 0);
+    for (int i = 0; i < threadCount; ++i)
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+
+    // Worker 0 is whichever thread calls swgl_threadpool_run()
+    for (int i = 1; i < threadCount; ++i)
+    {
+        pool->args[i].pool = pool;
+        pool->args[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, swgl_threadpool_main, &pool->args[i]) != 0)
+        {
+            printf("ERROR: swgl could only start %d of %d rasterizer threads\n", i, threadCount);
+            pool->threadCount = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void swgl_threadpool_destroy(SwglThreadPool *pool)
+{
+    if (!pool)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->threadCount; ++i)
+        pthread_join(pool->threads[i], NULL);
+    for (int i = 0; i < pool->threadCount; ++i)
+    {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->deques);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+int swgl_threadpool_size(const SwglThreadPool *pool)
+{
+    return pool ? pool->threadCount : 1;
+}
+
+unsigned long long swgl_threadpool_steals(const SwglThreadPool *pool)
+{
+    return pool ? atomic_load(&pool->steals) : 0;
+}
+
+void swgl_threadpool_run(SwglThreadPool *pool, SwglTaskFn fn, void *userData, int taskCount)
+{
+    if (taskCount <= 0)
+        return;
+    if (!pool || pool->threadCount == 1 || taskCount == 1)
+    {
+        for (int i = 0; i < taskCount; ++i)
+            fn(userData, i, 0);
+        return;
+    }
+
+    // Publish the job before any task becomes visible; a worker still
+    // draining the previous run may pick up a task the moment it is queued.
+    pool->fn = fn;
+    pool->userData = userData;
+    atomic_store(&pool->remaining, taskCount);
+
+    int workers = pool->threadCount;
+    for (int w = 0; w < workers; ++w)
+    {
+        SwglDeque *deque = &pool->deques[w];
+        int begin = (int)((long long)taskCount * w / workers);
+        int end = (int)((long long)taskCount * (w + 1) / workers);
+        pthread_mutex_lock(&deque->lock);
+        if (deque->capacity < end - begin)
+        {
+            int *tasks = (int *)realloc(deque->tasks, (size_t)(end - begin) * sizeof(int));
+            if (tasks)
+            {
+                deque->tasks = tasks;
+                deque->capacity = end - begin;
+            }
+        }
+        deque->head = 0;
+        deque->tail = 0;
+        if (deque->capacity >= end - begin)
+        {
+            // Reversed so the owner pops its block front to back
+            for (int t = end - 1; t >= begin; --t)
+                deque->tasks[deque->tail++] = t;
+        }
+        else
+        {
+            // Out of memory: run the block inline rather than dropping it
+            pthread_mutex_unlock(&deque->lock);
+            for (int t = begin; t < end; ++t)
+                fn(userData, t, 0);
+            atomic_fetch_sub(&pool->remaining, end - begin);
+            continue;
+        }
+        pthread_mutex_unlock(&deque->lock);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    swgl_threadpool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->remaining) > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
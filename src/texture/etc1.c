@@ -0,0 +1,428 @@
+// etc1.c
+// Blocks are 64-bit big-endian words. The upper 32 bits hold the base
+// colours, the two table indices, the diff bit and the flip bit; the lower
+// 32 bits hold the texel indices, column by column, the high bits of all 16
+// in the upper half-word and the low bits in the lower one.
+#include "texture/etc1.h"
+
+#include <GLFW/glfw3.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define ETC1_MAX_THREADS 32
+
+// Offsets per table: index 0 +a, 1 +b, 2 -a, 3 -b
+static const int etc1Modifiers[8][4] = {
+    {2, 8, -2, -8},     {5, 17, -5, -17},    {9, 29, -9, -29},     {13, 42, -13, -42},
+    {18, 60, -18, -60}, {24, 80, -24, -80}, {33, 106, -33, -106}, {47, 183, -47, -183},
+};
+
+// The 8 texels of one half of a block
+typedef struct Etc1Half
+{
+    int rgb[8][3];
+    int x[8];
+    int y[8];
+    int average[3]; // rounded
+#if defined(__SSE2__)
+    __m128i r, g, b; // the channels as 8 x 16 bits
+#endif
+} Etc1Half;
+
+// A fitted base colour of one half
+typedef struct Etc1Fit
+{
+    unsigned error;
+    int base[3]; // quantized, 4 or 5 bits
+    int table;
+    unsigned char indices[8];
+} Etc1Fit;
+
+static int etc1_clamp(int value)
+{
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+static int etc1_expand(int value, int bits)
+{
+    return bits == 4 ? value * 17 : (value << 3) | (value >> 2);
+}
+
+static void etc1_half(const unsigned char block[16][3], int flip, int half, Etc1Half *out)
+{
+    int sum[3] = {0, 0, 0};
+    for (int i = 0; i < 8; ++i)
+    {
+        int x = flip ? i % 4 : half * 2 + i / 4;
+        int y = flip ? half * 2 + i / 4 : i % 4;
+        out->x[i] = x;
+        out->y[i] = y;
+        for (int c = 0; c < 3; ++c)
+        {
+            out->rgb[i][c] = block[y * 4 + x][c];
+            sum[c] += block[y * 4 + x][c];
+        }
+    }
+    for (int c = 0; c < 3; ++c)
+        out->average[c] = (sum[c] + 4) / 8;
+#if defined(__SSE2__)
+    out->r = _mm_setr_epi16((short)out->rgb[0][0], (short)out->rgb[1][0], (short)out->rgb[2][0],
+                            (short)out->rgb[3][0], (short)out->rgb[4][0], (short)out->rgb[5][0],
+                            (short)out->rgb[6][0], (short)out->rgb[7][0]);
+    out->g = _mm_setr_epi16((short)out->rgb[0][1], (short)out->rgb[1][1], (short)out->rgb[2][1],
+                            (short)out->rgb[3][1], (short)out->rgb[4][1], (short)out->rgb[5][1],
+                            (short)out->rgb[6][1], (short)out->rgb[7][1]);
+    out->b = _mm_setr_epi16((short)out->rgb[0][2], (short)out->rgb[1][2], (short)out->rgb[2][2],
+                            (short)out->rgb[3][2], (short)out->rgb[4][2], (short)out->rgb[5][2],
+                            (short)out->rgb[6][2], (short)out->rgb[7][2]);
+#endif
+}
+
+// Fits tables first to last to the half with the base colour (expanded to
+// 8 bits) and keeps the result in fit when it is better.
+static void etc1_fit_tables(const Etc1Half *half, const int base[3], const int quantized[3], int first, int last,
+                            Etc1Fit *fit)
+{
+    for (int table = first; table <= last; ++table)
+    {
+        unsigned error = 0;
+        unsigned char indices[8];
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i bestLo = _mm_set1_epi32(0x7fffffff), bestHi = bestLo;
+        __m128i indexLo = zero, indexHi = zero;
+        for (int m = 0; m < 4; ++m)
+        {
+            int offset = etc1Modifiers[table][m];
+            __m128i dr = _mm_sub_epi16(half->r, _mm_set1_epi16((short)etc1_clamp(base[0] + offset)));
+            __m128i dg = _mm_sub_epi16(half->g, _mm_set1_epi16((short)etc1_clamp(base[1] + offset)));
+            __m128i db = _mm_sub_epi16(half->b, _mm_set1_epi16((short)etc1_clamp(base[2] + offset)));
+            // dr*dr + dg*dg + db*db per texel, 4 texels per register
+            __m128i rgLo = _mm_unpacklo_epi16(dr, dg), rgHi = _mm_unpackhi_epi16(dr, dg);
+            __m128i bLo = _mm_unpacklo_epi16(db, zero), bHi = _mm_unpackhi_epi16(db, zero);
+            __m128i errorLo = _mm_add_epi32(_mm_madd_epi16(rgLo, rgLo), _mm_madd_epi16(bLo, bLo));
+            __m128i errorHi = _mm_add_epi32(_mm_madd_epi16(rgHi, rgHi), _mm_madd_epi16(bHi, bHi));
+            __m128i lessLo = _mm_cmplt_epi32(errorLo, bestLo), lessHi = _mm_cmplt_epi32(errorHi, bestHi);
+            __m128i index = _mm_set1_epi32(m);
+            bestLo = _mm_or_si128(_mm_and_si128(lessLo, errorLo), _mm_andnot_si128(lessLo, bestLo));
+            bestHi = _mm_or_si128(_mm_and_si128(lessHi, errorHi), _mm_andnot_si128(lessHi, bestHi));
+            indexLo = _mm_or_si128(_mm_and_si128(lessLo, index), _mm_andnot_si128(lessLo, indexLo));
+            indexHi = _mm_or_si128(_mm_and_si128(lessHi, index), _mm_andnot_si128(lessHi, indexHi));
+        }
+        __m128i sum = _mm_add_epi32(bestLo, bestHi);
+        sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+        sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+        error = (unsigned)_mm_cvtsi128_si32(sum);
+        if (error >= fit->error)
+            continue;
+        __m128i packed = _mm_packs_epi32(indexLo, indexHi);
+        packed = _mm_packus_epi16(packed, packed);
+        _mm_storel_epi64((__m128i *)indices, packed);
+#else
+        for (int i = 0; i < 8 && error < fit->error; ++i)
+        {
+            unsigned best = ~0u;
+            for (int m = 0; m < 4; ++m)
+            {
+                int offset = etc1Modifiers[table][m];
+                int dr = half->rgb[i][0] - etc1_clamp(base[0] + offset);
+                int dg = half->rgb[i][1] - etc1_clamp(base[1] + offset);
+                int db = half->rgb[i][2] - etc1_clamp(base[2] + offset);
+                unsigned texelError = (unsigned)(dr * dr + dg * dg + db * db);
+                if (texelError < best)
+                {
+                    best = texelError;
+                    indices[i] = (unsigned char)m;
+                }
+            }
+            error += best;
+        }
+        if (error >= fit->error)
+            continue;
+#endif
+        fit->error = error;
+        fit->table = table;
+        memcpy(fit->base, quantized, sizeof(fit->base));
+        memcpy(fit->indices, indices, sizeof(fit->indices));
+    }
+}
+
+// Tries the base colours the quality allows around center (bits per
+// channel): the center with every table, at medium quality also the center
+// one step lighter and darker, and at high quality every other colour one
+// step away, with the tables next to the best one so far. With reference,
+// only colours within the 3-bit difference of it are tried.
+static void etc1_fit_half(const Etc1Half *half, const int center[3], int bits, const int *reference,
+                          Etc1Quality quality, Etc1Fit *fit)
+{
+    static const int steps[27] = {13, 0, 26, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 14, 15, 16, 17, 18,
+                                  19, 20, 21, 22, 23, 24, 25};
+    static const int stepCounts[ETC1_QUALITIES] = {1, 3, 27};
+    int maximum = (1 << bits) - 1;
+    fit->error = ~0u;
+    for (int i = 0; i < stepCounts[quality]; ++i)
+    {
+        int step = steps[i];
+        int delta[3] = {step % 3 - 1, step / 3 % 3 - 1, step / 9 - 1};
+        int quantized[3], base[3], valid = 1;
+        for (int c = 0; c < 3; ++c)
+        {
+            quantized[c] = center[c] + delta[c];
+            valid = valid && quantized[c] >= 0 && quantized[c] <= maximum;
+            if (reference)
+                valid = valid && quantized[c] - reference[c] >= -4 && quantized[c] - reference[c] <= 3;
+            base[c] = etc1_expand(quantized[c], bits);
+        }
+        if (!valid)
+            continue;
+        if (i < 3 || fit->error == ~0u)
+            etc1_fit_tables(half, base, quantized, 0, 7, fit);
+        else
+            etc1_fit_tables(half, base, quantized, fit->table > 0 ? fit->table - 1 : 0,
+                            fit->table < 7 ? fit->table + 1 : 7, fit);
+    }
+}
+
+static void etc1_pack(unsigned char *out, int flip, int differential, const Etc1Fit fits[2], const Etc1Half halves[2])
+{
+    uint32_t high = (uint32_t)fits[0].table << 5 | (uint32_t)fits[1].table << 2 | (uint32_t)differential << 1 |
+                    (uint32_t)flip;
+    for (int c = 0; c < 3; ++c)
+    {
+        int shift = 24 - c * 8;
+        if (differential)
+            high |= (uint32_t)fits[0].base[c] << (shift + 3) |
+                    (uint32_t)((fits[1].base[c] - fits[0].base[c]) & 7) << shift;
+        else
+            high |= (uint32_t)fits[0].base[c] << (shift + 4) | (uint32_t)fits[1].base[c] << shift;
+    }
+    uint32_t low = 0;
+    for (int h = 0; h < 2; ++h)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            int bit = halves[h].x[i] * 4 + halves[h].y[i];
+            low |= (uint32_t)(fits[h].indices[i] >> 1) << (bit + 16) | (uint32_t)(fits[h].indices[i] & 1) << bit;
+        }
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = (unsigned char)(high >> (24 - i * 8));
+        out[4 + i] = (unsigned char)(low >> (24 - i * 8));
+    }
+}
+
+static void etc1_encode_block(const unsigned char block[16][3], Etc1Quality quality, unsigned char *out)
+{
+    unsigned bestError = ~0u;
+    for (int flip = 0; flip < 2; ++flip)
+    {
+        Etc1Half halves[2];
+        etc1_half(block, flip, 0, &halves[0]);
+        etc1_half(block, flip, 1, &halves[1]);
+
+        // Two 4-bit colours
+        Etc1Fit fits[2];
+        for (int h = 0; h < 2; ++h)
+        {
+            int center[3];
+            for (int c = 0; c < 3; ++c)
+                center[c] = (halves[h].average[c] * 15 + 127) / 255;
+            etc1_fit_half(&halves[h], center, 4, NULL, quality, &fits[h]);
+        }
+        if (fits[0].error + fits[1].error < bestError)
+        {
+            bestError = fits[0].error + fits[1].error;
+            etc1_pack(out, flip, 0, fits, halves);
+        }
+
+        // A 5-bit colour and the second one as a difference to it
+        int center[2][3];
+        for (int h = 0; h < 2; ++h)
+        {
+            for (int c = 0; c < 3; ++c)
+                center[h][c] = (halves[h].average[c] * 31 + 127) / 255;
+        }
+        etc1_fit_half(&halves[0], center[0], 5, NULL, quality, &fits[0]);
+        for (int c = 0; c < 3; ++c)
+        {
+            int delta = center[1][c] - fits[0].base[c];
+            delta = delta < -4 ? -4 : delta > 3 ? 3 : delta;
+            center[1][c] = fits[0].base[c] + delta;
+        }
+        etc1_fit_half(&halves[1], center[1], 5, fits[0].base, quality, &fits[1]);
+        if (fits[1].error != ~0u && fits[0].error + fits[1].error < bestError)
+        {
+            bestError = fits[0].error + fits[1].error;
+            etc1_pack(out, flip, 1, fits, halves);
+        }
+    }
+}
+
+size_t etc1_encoded_size(int width, int height)
+{
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * ETC1_BLOCK_SIZE;
+}
+
+typedef struct Etc1Job
+{
+    const unsigned char *texels;
+    int width;
+    int height;
+    ptrdiff_t stride;
+    unsigned char *out;
+    Etc1Quality quality;
+    atomic_int nextRow; // of blocks
+} Etc1Job;
+
+static void *etc1_encode_rows(void *userData)
+{
+    Etc1Job *job = (Etc1Job *)userData;
+    int blocksWide = (job->width + 3) / 4, blocksHigh = (job->height + 3) / 4;
+    int row;
+    while ((row = atomic_fetch_add(&job->nextRow, 1)) < blocksHigh)
+    {
+        unsigned char *out = job->out + (size_t)row * (size_t)blocksWide * ETC1_BLOCK_SIZE;
+        for (int column = 0; column < blocksWide; ++column, out += ETC1_BLOCK_SIZE)
+        {
+            unsigned char block[16][3];
+            for (int y = 0; y < 4; ++y)
+            {
+                int sy = row * 4 + y < job->height ? row * 4 + y : job->height - 1;
+                const unsigned char *line = job->texels + sy * job->stride;
+                for (int x = 0; x < 4; ++x)
+                {
+                    int sx = column * 4 + x < job->width ? column * 4 + x : job->width - 1;
+                    memcpy(block[y * 4 + x], line + (size_t)sx * 4, 3);
+                }
+            }
+            etc1_encode_block(block, job->quality, out);
+        }
+    }
+    return NULL;
+}
+
+void etc1_encode(const unsigned char *texels, int width, int height, ptrdiff_t stride, unsigned char *out,
+                 Etc1Quality quality, int threadCount)
+{
+    Etc1Job job;
+    job.texels = texels;
+    job.width = width;
+    job.height = height;
+    job.stride = stride;
+    job.out = out;
+    job.quality = quality;
+    atomic_init(&job.nextRow, 0);
+    if (threadCount <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    int blocksHigh = (height + 3) / 4;
+    threadCount = threadCount > blocksHigh ? blocksHigh : threadCount;
+    threadCount = threadCount > ETC1_MAX_THREADS ? ETC1_MAX_THREADS : threadCount;
+
+    // The calling thread encodes too
+    pthread_t threads[ETC1_MAX_THREADS];
+    int started = 0;
+    while (started < threadCount - 1 && pthread_create(&threads[started], NULL, etc1_encode_rows, &job) == 0)
+        started++;
+    etc1_encode_rows(&job);
+    for (int i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+}
+
+void etc1_decode(const unsigned char *data, int width, int height, unsigned char *texels)
+{
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    for (int row = 0; row < blocksHigh; ++row)
+    {
+        for (int column = 0; column < blocksWide; ++column, data += ETC1_BLOCK_SIZE)
+        {
+            uint32_t high = (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+            uint32_t low = (uint32_t)data[4] << 24 | (uint32_t)data[5] << 16 | (uint32_t)data[6] << 8 | data[7];
+            int flip = high & 1, differential = high >> 1 & 1;
+            int base[2][3];
+            for (int c = 0; c < 3; ++c)
+            {
+                int shift = 24 - c * 8;
+                if (differential)
+                {
+                    int first = (int)(high >> (shift + 3) & 31);
+                    int delta = (int)(high >> shift & 7);
+                    delta = delta >= 4 ? delta - 8 : delta;
+                    base[0][c] = etc1_expand(first, 5);
+                    base[1][c] = etc1_expand((first + delta) & 31, 5);
+                }
+                else
+                {
+                    base[0][c] = etc1_expand((int)(high >> (shift + 4) & 15), 4);
+                    base[1][c] = etc1_expand((int)(high >> shift & 15), 4);
+                }
+            }
+            int tables[2] = {(int)(high >> 5 & 7), (int)(high >> 2 & 7)};
+            for (int y = 0; y < 4 && row * 4 + y < height; ++y)
+            {
+                for (int x = 0; x < 4 && column * 4 + x < width; ++x)
+                {
+                    int half = flip ? y >= 2 : x >= 2;
+                    int bit = x * 4 + y;
+                    int index = (int)((low >> (bit + 16) & 1) << 1 | (low >> bit & 1));
+                    int offset = etc1Modifiers[tables[half]][index];
+                    size_t texelIndex = ((size_t)row * 4 + (size_t)y) * (size_t)width + (size_t)column * 4 + (size_t)x;
+                    unsigned char *texel = texels + texelIndex * 4;
+                    for (int c = 0; c < 3; ++c)
+                        texel[c] = (unsigned char)etc1_clamp(base[half][c] + offset);
+                    texel[3] = 255;
+                }
+            }
+        }
+    }
+}
+
+int etc1_supported(void)
+{
+    return glfwExtensionSupported("GL_OES_compressed_ETC1_RGB8_texture");
+}
+
+GLenum etc1_tex_image_2d(GLint level, int width, int height, const unsigned char *data)
+{
+    if (etc1_supported())
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_ETC1_RGB8_OES, width, height, 0,
+                               (GLsizei)etc1_encoded_size(width, height), data);
+        return GL_ETC1_RGB8_OES;
+    }
+    unsigned char *texels = (unsigned char *)malloc((size_t)width * (size_t)height * 4);
+    if (!texels)
+        return 0;
+    etc1_decode(data, width, height, texels);
+    unsigned short *packed = (unsigned short *)texels;
+    for (size_t i = 0; i < (size_t)width * (size_t)height; ++i)
+    {
+        const unsigned char *texel = texels + i * 4;
+        packed[i] = (unsigned short)((texel[0] >> 3) << 11 | (texel[1] >> 2) << 5 | texel[2] >> 3);
+    }
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, packed);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    free(texels);
+    return GL_RGB;
+}
+
+const char *etc1_quality_name(Etc1Quality quality)
+{
+    static const char *names[ETC1_QUALITIES] = {"fast", "medium", "high"};
+    return names[quality];
+}
@@ -0,0 +1,484 @@
+// mipmap.c
+// A level is computed in row jobs: the box filter reads two source rows per
+// destination row; the Kaiser filter first filters every source row
+// horizontally into a temporary image of the destination width, then the
+// columns of that image vertically. Each destination row is converted to
+// RGBA8 right after it is filtered. The filter weights of every output
+// column and row are computed once per level, as the ratio between the
+// sizes is not exactly 2 for odd sizes.
+#include "texture/mipmap.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MIPMAP_MAX_THREADS 32
+// Levels with fewer rows are filtered on the calling thread only
+#define MIPMAP_MIN_THREAD_ROWS 32
+#define MIPMAP_KAISER_WIDTH 3.0
+#define MIPMAP_KAISER_ALPHA 4.0
+#define MIPMAP_PI 3.14159265358979323846
+// Entries of the linear to sRGB table
+#define MIPMAP_ENCODE_SIZE 65536
+
+static float srgbToLinear[256];
+static unsigned char linearToSrgb[MIPMAP_ENCODE_SIZE];
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+static void mipmap_init_tables(void)
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        double c = i / 255.0;
+        srgbToLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+    }
+    for (int i = 0; i < MIPMAP_ENCODE_SIZE; ++i)
+    {
+        double l = (double)i / (MIPMAP_ENCODE_SIZE - 1);
+        double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+        linearToSrgb[i] = (unsigned char)(c * 255.0 + 0.5);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// RGBA as 4 floats
+
+#if defined(__SSE2__)
+typedef __m128 MipmapTexel;
+
+static MipmapTexel texel_load(const float *p)
+{
+    return _mm_loadu_ps(p);
+}
+
+static void texel_store(float *p, MipmapTexel t)
+{
+    _mm_storeu_ps(p, t);
+}
+
+static MipmapTexel texel_zero(void)
+{
+    return _mm_setzero_ps();
+}
+
+static MipmapTexel texel_add(MipmapTexel a, MipmapTexel b)
+{
+    return _mm_add_ps(a, b);
+}
+
+// a + b * weight
+static MipmapTexel texel_madd(MipmapTexel a, MipmapTexel b, float weight)
+{
+    return _mm_add_ps(a, _mm_mul_ps(b, _mm_set1_ps(weight)));
+}
+
+static MipmapTexel texel_scale(MipmapTexel a, float scale)
+{
+    return _mm_mul_ps(a, _mm_set1_ps(scale));
+}
+
+static MipmapTexel texel_saturate(MipmapTexel a)
+{
+    return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+#else
+typedef struct MipmapTexel
+{
+    float c[4];
+} MipmapTexel;
+
+static MipmapTexel texel_load(const float *p)
+{
+    MipmapTexel t = {{p[0], p[1], p[2], p[3]}};
+    return t;
+}
+
+static void texel_store(float *p, MipmapTexel t)
+{
+    memcpy(p, t.c, sizeof(t.c));
+}
+
+static MipmapTexel texel_zero(void)
+{
+    MipmapTexel t = {{0.0f, 0.0f, 0.0f, 0.0f}};
+    return t;
+}
+
+static MipmapTexel texel_add(MipmapTexel a, MipmapTexel b)
+{
+    for (int i = 0; i < 4; ++i)
+        a.c[i] += b.c[i];
+    return a;
+}
+
+static MipmapTexel texel_madd(MipmapTexel a, MipmapTexel b, float weight)
+{
+    for (int i = 0; i < 4; ++i)
+        a.c[i] += b.c[i] * weight;
+    return a;
+}
+
+static MipmapTexel texel_scale(MipmapTexel a, float scale)
+{
+    for (int i = 0; i < 4; ++i)
+        a.c[i] *= scale;
+    return a;
+}
+
+static MipmapTexel texel_saturate(MipmapTexel a)
+{
+    for (int i = 0; i < 4; ++i)
+        a.c[i] = a.c[i] < 0.0f ? 0.0f : a.c[i] > 1.0f ? 1.0f : a.c[i];
+    return a;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Filter weights
+
+typedef struct MipmapKernel
+{
+    int taps;
+    int *first;     // first source index per output index, may be out of range
+    float *weights; // taps per output index
+} MipmapKernel;
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Kaiser-windowed sinc, x in destination texels
+static double kaiser(double x)
+{
+    if (fabs(x) >= MIPMAP_KAISER_WIDTH)
+        return 0.0;
+    double sinc = x == 0.0 ? 1.0 : sin(MIPMAP_PI * x) / (MIPMAP_PI * x);
+    double r = x / MIPMAP_KAISER_WIDTH;
+    return sinc * bessel_i0(MIPMAP_KAISER_ALPHA * sqrt(1.0 - r * r)) / bessel_i0(MIPMAP_KAISER_ALPHA);
+}
+
+static int kernel_init(MipmapKernel *kernel, int sourceSize, int size)
+{
+    double ratio = (double)sourceSize / size;
+    double radius = MIPMAP_KAISER_WIDTH * ratio;
+    kernel->taps = 2 * (int)ceil(radius) + 1;
+    kernel->first = (int *)malloc((size_t)size * sizeof(int));
+    kernel->weights = (float *)malloc((size_t)size * (size_t)kernel->taps * sizeof(float));
+    if (!kernel->first || !kernel->weights)
+        return 0;
+    for (int i = 0; i < size; ++i)
+    {
+        double center = (i + 0.5) * ratio - 0.5;
+        int first = (int)floor(center - radius) + 1;
+        float *weights = kernel->weights + (size_t)i * (size_t)kernel->taps;
+        double sum = 0.0;
+        for (int t = 0; t < kernel->taps; ++t)
+        {
+            weights[t] = (float)kaiser((first + t - center) / ratio);
+            sum += weights[t];
+        }
+        for (int t = 0; t < kernel->taps; ++t)
+            weights[t] = (float)(weights[t] / sum);
+        kernel->first[i] = first;
+    }
+    return 1;
+}
+
+static void kernel_free(MipmapKernel *kernel)
+{
+    free(kernel->first);
+    free(kernel->weights);
+}
+
+static int clamp_index(int i, int size)
+{
+    return i < 0 ? 0 : i >= size ? size - 1 : i;
+}
+
+// ---------------------------------------------------------------------------
+// Row jobs
+
+typedef struct MipmapJob MipmapJob;
+struct MipmapJob
+{
+    void (*row)(const MipmapJob *job, int y);
+    int rowCount;
+    atomic_int nextRow;
+
+    const float *source;
+    int sourceWidth;
+    int sourceHeight;
+    float *destination;
+    int width;
+    int height;
+    unsigned char *bytes; // RGBA8 destination
+    int gammaCorrect;
+    const MipmapKernel *horizontal;
+    const MipmapKernel *vertical;
+};
+
+static void *mipmap_worker(void *userData)
+{
+    MipmapJob *job = (MipmapJob *)userData;
+    int y;
+    while ((y = atomic_fetch_add(&job->nextRow, 1)) < job->rowCount)
+        job->row(job, y);
+    return NULL;
+}
+
+static void mipmap_run(MipmapJob *job, int threadCount)
+{
+    atomic_init(&job->nextRow, 0);
+    if (job->rowCount < MIPMAP_MIN_THREAD_ROWS)
+        threadCount = 1;
+    pthread_t threads[MIPMAP_MAX_THREADS];
+    int started = 0;
+    while (started < threadCount - 1 && pthread_create(&threads[started], NULL, mipmap_worker, job) == 0)
+        started++;
+    mipmap_worker(job);
+    for (int i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+}
+
+static void encode_row(const MipmapJob *job, const float *row, unsigned char *out)
+{
+    for (int x = 0; x < job->width; ++x, row += 4, out += 4)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            out[c] = job->gammaCorrect ? linearToSrgb[(int)(row[c] * (MIPMAP_ENCODE_SIZE - 1) + 0.5f)]
+                                       : (unsigned char)(row[c] * 255.0f + 0.5f);
+        }
+        out[3] = (unsigned char)(row[3] * 255.0f + 0.5f);
+    }
+}
+
+static void decode_row(const MipmapJob *job, int y)
+{
+    const unsigned char *in = job->bytes + (size_t)y * (size_t)job->width * 4;
+    float *out = job->destination + (size_t)y * (size_t)job->width * 4;
+    for (int x = 0; x < job->width; ++x, in += 4, out += 4)
+    {
+        for (int c = 0; c < 3; ++c)
+            out[c] = job->gammaCorrect ? srgbToLinear[in[c]] : in[c] / 255.0f;
+        out[3] = in[3] / 255.0f;
+    }
+}
+
+static void box_row(const MipmapJob *job, int y)
+{
+    size_t sourceStride = (size_t)job->sourceWidth * 4;
+    const float *row0 = job->source + (size_t)clamp_index(2 * y, job->sourceHeight) * sourceStride;
+    const float *row1 = job->source + (size_t)clamp_index(2 * y + 1, job->sourceHeight) * sourceStride;
+    float *out = job->destination + (size_t)y * (size_t)job->width * 4;
+    for (int x = 0; x < job->width; ++x)
+    {
+        size_t x0 = (size_t)clamp_index(2 * x, job->sourceWidth) * 4;
+        size_t x1 = (size_t)clamp_index(2 * x + 1, job->sourceWidth) * 4;
+        MipmapTexel sum = texel_add(texel_add(texel_load(row0 + x0), texel_load(row0 + x1)),
+                                    texel_add(texel_load(row1 + x0), texel_load(row1 + x1)));
+        texel_store(out + (size_t)x * 4, texel_scale(sum, 0.25f));
+    }
+    encode_row(job, out, job->bytes + (size_t)y * (size_t)job->width * 4);
+}
+
+// Source row y into the temporary image of the destination width
+static void kaiser_row_horizontal(const MipmapJob *job, int y)
+{
+    const MipmapKernel *kernel = job->horizontal;
+    const float *row = job->source + (size_t)y * (size_t)job->sourceWidth * 4;
+    float *out = job->destination + (size_t)y * (size_t)job->width * 4;
+    for (int x = 0; x < job->width; ++x)
+    {
+        const float *weights = kernel->weights + (size_t)x * (size_t)kernel->taps;
+        int first = kernel->first[x];
+        MipmapTexel sum = texel_zero();
+        if (first >= 0 && first + kernel->taps <= job->sourceWidth)
+        {
+            const float *texel = row + (size_t)first * 4;
+            for (int t = 0; t < kernel->taps; ++t, texel += 4)
+                sum = texel_madd(sum, texel_load(texel), weights[t]);
+        }
+        else
+        {
+            for (int t = 0; t < kernel->taps; ++t)
+                sum = texel_madd(sum, texel_load(row + (size_t)clamp_index(first + t, job->sourceWidth) * 4),
+                                 weights[t]);
+        }
+        texel_store(out + (size_t)x * 4, sum);
+    }
+}
+
+// Destination row y from the temporary image (source here)
+static void kaiser_row_vertical(const MipmapJob *job, int y)
+{
+    const MipmapKernel *kernel = job->vertical;
+    const float *weights = kernel->weights + (size_t)y * (size_t)kernel->taps;
+    size_t stride = (size_t)job->width * 4;
+    float *out = job->destination + (size_t)y * stride;
+    for (int t = 0; t < kernel->taps; ++t)
+    {
+        const float *row = job->source + (size_t)clamp_index(kernel->first[y] + t, job->sourceHeight) * stride;
+        for (int x = 0; x < job->width; ++x)
+        {
+            MipmapTexel sum = t == 0 ? texel_zero() : texel_load(out + (size_t)x * 4);
+            sum = texel_madd(sum, texel_load(row + (size_t)x * 4), weights[t]);
+            if (t == kernel->taps - 1)
+                sum = texel_saturate(sum);
+            texel_store(out + (size_t)x * 4, sum);
+        }
+    }
+    encode_row(job, out, job->bytes + (size_t)y * stride);
+}
+
+// ---------------------------------------------------------------------------
+// Chains
+
+static int mipmap_level(MipmapJob *job, MipmapFilter filter, int threadCount)
+{
+    if (filter == MIPMAP_BOX)
+    {
+        job->row = box_row;
+        job->rowCount = job->height;
+        mipmap_run(job, threadCount);
+        return 1;
+    }
+
+    MipmapKernel horizontal, vertical;
+    memset(&horizontal, 0, sizeof(horizontal));
+    memset(&vertical, 0, sizeof(vertical));
+    float *filtered = (float *)malloc((size_t)job->width * (size_t)job->sourceHeight * 4 * sizeof(float));
+    int ok = filtered && kernel_init(&horizontal, job->sourceWidth, job->width) &&
+             kernel_init(&vertical, job->sourceHeight, job->height);
+    if (ok)
+    {
+        float *destination = job->destination;
+        const float *source = job->source;
+        job->horizontal = &horizontal;
+        job->vertical = &vertical;
+        job->row = kaiser_row_horizontal;
+        job->rowCount = job->sourceHeight;
+        job->destination = filtered;
+        mipmap_run(job, threadCount);
+
+        job->row = kaiser_row_vertical;
+        job->rowCount = job->height;
+        job->source = filtered;
+        job->destination = destination;
+        mipmap_run(job, threadCount);
+        job->source = source;
+    }
+    kernel_free(&horizontal);
+    kernel_free(&vertical);
+    free(filtered);
+    return ok;
+}
+
+int mipmap_build(const unsigned char *texels, int width, int height, MipmapFilter filter, int gammaCorrect,
+                 int threadCount, MipmapChain *chain)
+{
+    pthread_once(&tablesOnce, mipmap_init_tables);
+    memset(chain, 0, sizeof(*chain));
+    if (threadCount <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    threadCount = threadCount > MIPMAP_MAX_THREADS ? MIPMAP_MAX_THREADS : threadCount;
+
+    size_t bytes = (size_t)width * (size_t)height * 4;
+    chain->levels[0] = (unsigned char *)malloc(bytes);
+    float *source = (float *)malloc(bytes * sizeof(float));
+    if (!chain->levels[0] || !source)
+    {
+        free(source);
+        mipmap_free(chain);
+        return 0;
+    }
+    memcpy(chain->levels[0], texels, bytes);
+    chain->widths[0] = width;
+    chain->heights[0] = height;
+    chain->levelCount = 1;
+
+    MipmapJob job;
+    memset(&job, 0, sizeof(job));
+    job.gammaCorrect = gammaCorrect;
+    job.row = decode_row;
+    job.rowCount = height;
+    job.destination = source;
+    job.width = width;
+    job.bytes = chain->levels[0];
+    mipmap_run(&job, threadCount);
+
+    int ok = 1;
+    while (ok && (width > 1 || height > 1) && chain->levelCount < MIPMAP_MAX_LEVELS)
+    {
+        int level = chain->levelCount;
+        chain->widths[level] = width > 1 ? width / 2 : 1;
+        chain->heights[level] = height > 1 ? height / 2 : 1;
+        size_t texelCount = (size_t)chain->widths[level] * (size_t)chain->heights[level];
+        float *destination = (float *)malloc(texelCount * 4 * sizeof(float));
+        chain->levels[level] = (unsigned char *)malloc(texelCount * 4);
+        ok = destination && chain->levels[level];
+        if (ok)
+        {
+            job.source = source;
+            job.sourceWidth = width;
+            job.sourceHeight = height;
+            job.destination = destination;
+            job.width = chain->widths[level];
+            job.height = chain->heights[level];
+            job.bytes = chain->levels[level];
+            ok = mipmap_level(&job, filter, threadCount);
+        }
+        chain->levelCount++;
+        free(source);
+        source = destination;
+        width = chain->widths[level];
+        height = chain->heights[level];
+    }
+    free(source);
+    if (!ok)
+        mipmap_free(chain);
+    return ok;
+}
+
+void mipmap_free(MipmapChain *chain)
+{
+    for (int i = 0; i < MIPMAP_MAX_LEVELS; ++i)
+        free(chain->levels[i]);
+    memset(chain, 0, sizeof(*chain));
+}
+
+void mipmap_upload(const MipmapChain *chain)
+{
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int level = 0; level < chain->levelCount; ++level)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, chain->widths[level], chain->heights[level], 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, chain->levels[level]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+}
+
+const char *mipmap_filter_name(MipmapFilter filter)
+{
+    static const char *names[MIPMAP_FILTERS] = {"box", "kaiser"};
+    return names[filter];
+}
@@ -0,0 +1,654 @@
+// texture_stream.c
+// Requests move through two queues: workers take them from the decode
+// queue, decode into a staging block and append them to the ready queue,
+// which only the GL thread consumes. Staging blocks come from per-size
+// free lists; the pool's byte count includes the free blocks, which are
+// released when a block of another size is needed and the cap is reached.
+#include "texture/texture_stream.h"
+#include "capture/qoi.h"
+#include "common/profiler.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEXTURE_STREAM_MAX_THREADS 32
+// Smallest staging block, as a power of two
+#define TEXTURE_STREAM_MIN_BLOCK_SHIFT 16
+#define TEXTURE_STREAM_BLOCK_CLASSES 16
+
+typedef struct TextureStreamBlock
+{
+    struct TextureStreamBlock *next;
+    int sizeClass;
+    size_t size;
+    unsigned char *pixels;
+} TextureStreamBlock;
+
+typedef struct TextureStreamRequest
+{
+    struct TextureStreamRequest *next;
+    char *path;                 // NULL for images in memory
+    const unsigned char *data;
+    size_t size;
+    TextureStreamFormat format;
+    TextureStreamCallback completed;
+    void *userData;
+
+    TextureStreamBlock *staging; // decoded texels, NULL when decoding failed
+    int width;
+    int height;
+    GLuint texture;
+    int uploadedRows;
+} TextureStreamRequest;
+
+typedef struct TextureStreamQueue
+{
+    TextureStreamRequest *head;
+    TextureStreamRequest *tail;
+} TextureStreamQueue;
+
+struct TextureStream
+{
+    size_t stagingBytes;
+    size_t frameBudget;
+    int threadCount;
+    pthread_t threads[TEXTURE_STREAM_MAX_THREADS];
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;          // decode queue or quit
+    pthread_cond_t blockReleased; // staging memory was returned
+    int quit;
+    TextureStreamQueue decodeQueue;
+    TextureStreamQueue readyQueue;
+    int pending;
+    TextureStreamBlock *freeBlocks[TEXTURE_STREAM_BLOCK_CLASSES];
+    size_t poolBytes;  // allocated, in use or free
+    size_t inUseBytes;
+    TextureStreamStats stats;
+
+    TextureStreamRequest *uploading; // GL thread only
+};
+
+static const struct
+{
+    GLenum format;
+    GLenum type;
+    int texelSize;
+    const char *name;
+} textureStreamFormats[TEXTURE_STREAM_FORMATS] = {
+    {GL_RGBA, GL_UNSIGNED_BYTE, 4, "RGBA8"},
+    {GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2, "RGB565"},
+    {GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 2, "RGBA4444"},
+};
+
+int texture_stream_texel_size(TextureStreamFormat format)
+{
+    return textureStreamFormats[format].texelSize;
+}
+
+const char *texture_stream_format_name(TextureStreamFormat format)
+{
+    return textureStreamFormats[format].name;
+}
+
+static double texture_stream_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void queue_push(TextureStreamQueue *queue, TextureStreamRequest *request)
+{
+    request->next = NULL;
+    if (queue->tail)
+        queue->tail->next = request;
+    else
+        queue->head = request;
+    queue->tail = request;
+}
+
+static TextureStreamRequest *queue_pop(TextureStreamQueue *queue)
+{
+    TextureStreamRequest *request = queue->head;
+    if (request)
+    {
+        queue->head = request->next;
+        if (!queue->head)
+            queue->tail = NULL;
+    }
+    return request;
+}
+
+// ---------------------------------------------------------------------------
+// Staging pool, called with the lock held
+
+static int block_class(size_t size)
+{
+    int sizeClass = 0;
+    while (sizeClass < TEXTURE_STREAM_BLOCK_CLASSES - 1 &&
+           ((size_t)1 << (TEXTURE_STREAM_MIN_BLOCK_SHIFT + sizeClass)) < size)
+        sizeClass++;
+    return sizeClass;
+}
+
+static void free_block(TextureStreamBlock *block)
+{
+    free(block->pixels);
+    free(block);
+}
+
+// Releases free blocks of other sizes until needed more bytes fit under the
+// cap. Returns 1 when they fit.
+static int trim_pool(TextureStream *stream, size_t needed)
+{
+    for (int i = 0; i < TEXTURE_STREAM_BLOCK_CLASSES && stream->poolBytes + needed > stream->stagingBytes; ++i)
+    {
+        while (stream->freeBlocks[i] && stream->poolBytes + needed > stream->stagingBytes)
+        {
+            TextureStreamBlock *block = stream->freeBlocks[i];
+            stream->freeBlocks[i] = block->next;
+            stream->poolBytes -= block->size;
+            free_block(block);
+        }
+    }
+    return stream->poolBytes + needed <= stream->stagingBytes;
+}
+
+static TextureStreamBlock *take_block(TextureStream *stream, TextureStreamBlock *block)
+{
+    stream->inUseBytes += block->size;
+    if (stream->inUseBytes > stream->stats.stagingPeak)
+        stream->stats.stagingPeak = stream->inUseBytes;
+    return block;
+}
+
+// Takes a block of at least size bytes, waiting while the pool is at its
+// cap. An image larger than the cap gets a block once nothing else is in
+// use. Returns NULL when out of memory or quitting.
+static TextureStreamBlock *acquire_block(TextureStream *stream, size_t size)
+{
+    int sizeClass = block_class(size);
+    size_t blockSize = (size_t)1 << (TEXTURE_STREAM_MIN_BLOCK_SHIFT + sizeClass);
+    if (blockSize < size)
+        blockSize = size; // beyond the largest class: exactly the size
+    int waited = 0;
+    while (!stream->quit)
+    {
+        TextureStreamBlock **link = &stream->freeBlocks[sizeClass];
+        while (*link && (*link)->size < size)
+            link = &(*link)->next;
+        if (*link)
+        {
+            TextureStreamBlock *block = *link;
+            *link = block->next;
+            return take_block(stream, block);
+        }
+        if (trim_pool(stream, blockSize) || stream->inUseBytes == 0)
+        {
+            TextureStreamBlock *block = (TextureStreamBlock *)malloc(sizeof(TextureStreamBlock));
+            unsigned char *pixels = (unsigned char *)malloc(blockSize);
+            if (!block || !pixels)
+            {
+                free(block);
+                free(pixels);
+                return NULL;
+            }
+            block->sizeClass = sizeClass;
+            block->size = blockSize;
+            block->pixels = pixels;
+            stream->poolBytes += blockSize;
+            return take_block(stream, block);
+        }
+        if (!waited)
+            stream->stats.stagingWaits++;
+        waited = 1;
+        pthread_cond_wait(&stream->blockReleased, &stream->lock);
+    }
+    return NULL;
+}
+
+static void release_block(TextureStream *stream, TextureStreamBlock *block)
+{
+    stream->inUseBytes -= block->size;
+    if (stream->poolBytes > stream->stagingBytes)
+    {
+        // An oversized image went through; do not keep its block
+        stream->poolBytes -= block->size;
+        free_block(block);
+    }
+    else
+    {
+        block->next = stream->freeBlocks[block->sizeClass];
+        stream->freeBlocks[block->sizeClass] = block;
+    }
+    pthread_cond_broadcast(&stream->blockReleased);
+}
+
+// ---------------------------------------------------------------------------
+// Decoding, on the worker threads
+
+static unsigned char *read_file(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = length > 0 ? (unsigned char *)malloc((size_t)length) : NULL;
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = data ? (size_t)length : 0;
+    return data;
+}
+
+// Reads the next header number of a PPM file, skipping whitespace and
+// comments. Returns -1 when there is none.
+static int ppm_number(const unsigned char *data, size_t size, size_t *offset)
+{
+    size_t i = *offset;
+    while (i < size && (data[i] == ' ' || data[i] == '\t' || data[i] == '\r' || data[i] == '\n' || data[i] == '#'))
+    {
+        if (data[i] == '#')
+        {
+            while (i < size && data[i] != '\n')
+                ++i;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    if (i >= size || data[i] < '0' || data[i] > '9')
+        return -1;
+    long value = 0;
+    while (i < size && data[i] >= '0' && data[i] <= '9' && value < 1000000)
+        value = value * 10 + (data[i++] - '0');
+    *offset = i;
+    return (int)value;
+}
+
+// Binary PPM with 8-bit samples. Returns the offset of the texels, 0 when
+// data is not such a file.
+static size_t ppm_read_header(const unsigned char *data, size_t size, int *width, int *height)
+{
+    if (size < 2 || data[0] != 'P' || data[1] != '6')
+        return 0;
+    size_t offset = 2;
+    *width = ppm_number(data, size, &offset);
+    *height = ppm_number(data, size, &offset);
+    int maxValue = ppm_number(data, size, &offset);
+    if (*width <= 0 || *height <= 0 || maxValue != 255 || offset >= size)
+        return 0;
+    offset++; // the single whitespace before the texels
+    if ((size - offset) / 3 / (size_t)*width < (size_t)*height)
+        return 0;
+    return offset;
+}
+
+// Packs RGBA8 texels into 16-bit ones, in place
+static void pack_texels(unsigned char *texels, size_t count, TextureStreamFormat format)
+{
+    const unsigned char *in = texels;
+    unsigned short *out = (unsigned short *)texels;
+    if (format == TEXTURE_STREAM_RGB565)
+    {
+        for (size_t i = 0; i < count; ++i, in += 4)
+            out[i] = (unsigned short)(((in[0] >> 3) << 11) | ((in[1] >> 2) << 5) | (in[2] >> 3));
+    }
+    else if (format == TEXTURE_STREAM_RGBA4444)
+    {
+        for (size_t i = 0; i < count; ++i, in += 4)
+            out[i] = (unsigned short)(((in[0] >> 4) << 12) | ((in[1] >> 4) << 8) | ((in[2] >> 4) << 4) | (in[3] >> 4));
+    }
+}
+
+static int decode_request(TextureStream *stream, TextureStreamRequest *request)
+{
+    size_t size = request->size;
+    unsigned char *fileData = NULL;
+    const unsigned char *data = request->data;
+    if (request->path)
+    {
+        data = fileData = read_file(request->path, &size);
+        if (!data)
+        {
+            printf("ERROR: texture stream: cannot read %s\n", request->path);
+            return 0;
+        }
+    }
+
+    int width = 0, height = 0, channels;
+    size_t ppmOffset = 0;
+    int qoi = qoi_read_header(data, size, &width, &height, &channels);
+    if (!qoi)
+        ppmOffset = ppm_read_header(data, size, &width, &height);
+    if (!qoi && !ppmOffset)
+    {
+        printf("ERROR: texture stream: %s is not a QOI or binary PPM image\n",
+               request->path ? request->path : "image");
+        free(fileData);
+        return 0;
+    }
+
+    size_t texelCount = (size_t)width * (size_t)height;
+    pthread_mutex_lock(&stream->lock);
+    request->staging = acquire_block(stream, texelCount * 4);
+    pthread_mutex_unlock(&stream->lock);
+    int ok = request->staging != NULL;
+    if (ok && qoi)
+    {
+        ok = qoi_decode(data, size, request->staging->pixels);
+    }
+    else if (ok)
+    {
+        const unsigned char *in = data + ppmOffset;
+        unsigned char *out = request->staging->pixels;
+        for (size_t i = 0; i < texelCount; ++i, in += 3, out += 4)
+        {
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+            out[3] = 255;
+        }
+    }
+    if (ok)
+    {
+        pack_texels(request->staging->pixels, texelCount, request->format);
+        request->width = width;
+        request->height = height;
+    }
+    else if (request->staging)
+    {
+        printf("ERROR: texture stream: %s is damaged\n", request->path ? request->path : "image");
+        pthread_mutex_lock(&stream->lock);
+        release_block(stream, request->staging);
+        pthread_mutex_unlock(&stream->lock);
+        request->staging = NULL;
+    }
+    free(fileData);
+    return ok;
+}
+
+static void *texture_stream_worker(void *userData)
+{
+    TextureStream *stream = (TextureStream *)userData;
+    PROFILE_THREAD_NAME("texture decode");
+    pthread_mutex_lock(&stream->lock);
+    for (;;)
+    {
+        while (!stream->quit && !stream->decodeQueue.head)
+            pthread_cond_wait(&stream->work, &stream->lock);
+        if (stream->quit)
+            break;
+        TextureStreamRequest *request = queue_pop(&stream->decodeQueue);
+        pthread_mutex_unlock(&stream->lock);
+
+        double start = texture_stream_seconds();
+        int ok;
+        PROFILE_CALL(ok = decode_request(stream, request));
+        double decodeMs = (texture_stream_seconds() - start) * 1000.0;
+
+        pthread_mutex_lock(&stream->lock);
+        stream->stats.decodeMs += decodeMs;
+        if (ok)
+            stream->stats.decodedBytes += (unsigned long long)request->width * (unsigned long long)request->height *
+                                          (unsigned long long)texture_stream_texel_size(request->format);
+        queue_push(&stream->readyQueue, request);
+    }
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Requests
+
+TextureStream *texture_stream_create(int threadCount, size_t stagingBytes, size_t frameBudget)
+{
+    TextureStream *stream = (TextureStream *)calloc(1, sizeof(TextureStream));
+    if (!stream)
+        return NULL;
+    if (threadCount <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threadCount > TEXTURE_STREAM_MAX_THREADS)
+        threadCount = TEXTURE_STREAM_MAX_THREADS;
+    stream->stagingBytes = stagingBytes;
+    stream->frameBudget = frameBudget;
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->work, NULL);
+    pthread_cond_init(&stream->blockReleased, NULL);
+    for (; stream->threadCount < threadCount; ++stream->threadCount)
+    {
+        if (pthread_create(&stream->threads[stream->threadCount], NULL, texture_stream_worker, stream) != 0)
+            break;
+    }
+    if (stream->threadCount == 0)
+    {
+        printf("ERROR: texture stream: cannot start the decode threads\n");
+        texture_stream_destroy(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+static void free_request(TextureStream *stream, TextureStreamRequest *request)
+{
+    if (request->staging)
+    {
+        pthread_mutex_lock(&stream->lock);
+        release_block(stream, request->staging);
+        pthread_mutex_unlock(&stream->lock);
+    }
+    free(request->path);
+    free(request);
+}
+
+void texture_stream_destroy(TextureStream *stream)
+{
+    if (!stream)
+        return;
+    pthread_mutex_lock(&stream->lock);
+    stream->quit = 1;
+    pthread_cond_broadcast(&stream->work);
+    pthread_cond_broadcast(&stream->blockReleased);
+    pthread_mutex_unlock(&stream->lock);
+    for (int i = 0; i < stream->threadCount; ++i)
+        pthread_join(stream->threads[i], NULL);
+
+    TextureStreamRequest *request;
+    if (stream->uploading)
+    {
+        glDeleteTextures(1, &stream->uploading->texture);
+        free_request(stream, stream->uploading);
+    }
+    while ((request = queue_pop(&stream->decodeQueue)) != NULL)
+        free_request(stream, request);
+    while ((request = queue_pop(&stream->readyQueue)) != NULL)
+        free_request(stream, request);
+    for (int i = 0; i < TEXTURE_STREAM_BLOCK_CLASSES; ++i)
+    {
+        while (stream->freeBlocks[i])
+        {
+            TextureStreamBlock *block = stream->freeBlocks[i];
+            stream->freeBlocks[i] = block->next;
+            free_block(block);
+        }
+    }
+    pthread_cond_destroy(&stream->blockReleased);
+    pthread_cond_destroy(&stream->work);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream);
+}
+
+static int queue_request(TextureStream *stream, TextureStreamRequest *request)
+{
+    pthread_mutex_lock(&stream->lock);
+    queue_push(&stream->decodeQueue, request);
+    stream->pending++;
+    pthread_cond_signal(&stream->work);
+    pthread_mutex_unlock(&stream->lock);
+    return 1;
+}
+
+int texture_stream_load_file(TextureStream *stream, const char *path, TextureStreamFormat format,
+                             TextureStreamCallback completed, void *userData)
+{
+    TextureStreamRequest *request = (TextureStreamRequest *)calloc(1, sizeof(TextureStreamRequest));
+    char *copy = (char *)malloc(strlen(path) + 1);
+    if (!request || !copy)
+    {
+        free(request);
+        free(copy);
+        return 0;
+    }
+    strcpy(copy, path);
+    request->path = copy;
+    request->format = format;
+    request->completed = completed;
+    request->userData = userData;
+    return queue_request(stream, request);
+}
+
+int texture_stream_load_memory(TextureStream *stream, const void *data, size_t size, TextureStreamFormat format,
+                               TextureStreamCallback completed, void *userData)
+{
+    TextureStreamRequest *request = (TextureStreamRequest *)calloc(1, sizeof(TextureStreamRequest));
+    if (!request)
+        return 0;
+    request->data = (const unsigned char *)data;
+    request->size = size;
+    request->format = format;
+    request->completed = completed;
+    request->userData = userData;
+    return queue_request(stream, request);
+}
+
+// ---------------------------------------------------------------------------
+// Uploads, on the GL thread
+
+static void complete_request(TextureStream *stream, TextureStreamRequest *request)
+{
+    pthread_mutex_lock(&stream->lock);
+    stream->pending--;
+    if (request->texture)
+        stream->stats.completed++;
+    else
+        stream->stats.failed++;
+    pthread_mutex_unlock(&stream->lock);
+    if (request->completed)
+        request->completed(request->texture, request->width, request->height, request->userData);
+    free_request(stream, request);
+}
+
+void texture_stream_update(TextureStream *stream)
+{
+    double start = texture_stream_seconds();
+    size_t uploadedBytes = 0;
+    GLint previousTexture = -1, previousAlignment = 4;
+    for (;;)
+    {
+        TextureStreamRequest *request = stream->uploading;
+        if (!request)
+        {
+            pthread_mutex_lock(&stream->lock);
+            request = queue_pop(&stream->readyQueue);
+            pthread_mutex_unlock(&stream->lock);
+            if (!request)
+                break;
+            stream->uploading = request;
+        }
+        if (!request->staging)
+        {
+            stream->uploading = NULL;
+            complete_request(stream, request);
+            continue;
+        }
+        if (stream->frameBudget && uploadedBytes >= stream->frameBudget)
+            break;
+
+        if (previousTexture < 0)
+        {
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+        }
+        GLenum format = textureStreamFormats[request->format].format;
+        GLenum type = textureStreamFormats[request->format].type;
+        size_t rowBytes = (size_t)request->width * (size_t)texture_stream_texel_size(request->format);
+        if (!request->texture)
+        {
+            glGenTextures(1, &request->texture);
+            glBindTexture(GL_TEXTURE_2D, request->texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, request->width, request->height, 0, format, type, NULL);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, request->texture);
+        }
+        // A band of whole rows within the budget, at least one row per update
+        int rows = request->height - request->uploadedRows;
+        size_t fit = stream->frameBudget ? (stream->frameBudget - uploadedBytes) / rowBytes : (size_t)rows;
+        if (fit == 0 && uploadedBytes)
+            break;
+        if (fit == 0)
+            fit = 1;
+        if ((size_t)rows > fit)
+            rows = (int)fit;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, rowBytes % 4 == 0 ? 4 : rowBytes % 2 == 0 ? 2 : 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, request->uploadedRows, request->width, rows, format, type,
+                        request->staging->pixels + (size_t)request->uploadedRows * rowBytes);
+        request->uploadedRows += rows;
+        uploadedBytes += (size_t)rows * rowBytes;
+        if (request->uploadedRows == request->height)
+        {
+            stream->uploading = NULL;
+            complete_request(stream, request);
+        }
+    }
+    if (previousTexture >= 0)
+    {
+        glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    }
+    if (uploadedBytes)
+    {
+        double updateMs = (texture_stream_seconds() - start) * 1000.0;
+        pthread_mutex_lock(&stream->lock);
+        stream->stats.uploadedBytes += uploadedBytes;
+        stream->stats.uploadMs += updateMs;
+        stream->stats.updates++;
+        if (updateMs > stream->stats.maxUpdateMs)
+            stream->stats.maxUpdateMs = updateMs;
+        pthread_mutex_unlock(&stream->lock);
+    }
+}
+
+int texture_stream_pending(TextureStream *stream)
+{
+    pthread_mutex_lock(&stream->lock);
+    int pending = stream->pending;
+    pthread_mutex_unlock(&stream->lock);
+    return pending;
+}
+
+void texture_stream_get_stats(TextureStream *stream, TextureStreamStats *stats)
+{
+    pthread_mutex_lock(&stream->lock);
+    *stats = stream->stats;
+    pthread_mutex_unlock(&stream->lock);
+}
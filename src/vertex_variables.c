@@ -1,5 +1,8 @@
 #include <GLES2/gl2.h>
 #include <GLFW/glfw3.h>
+#include <common/profiler.h>
+#include <common/sample_clock.h>
+#include <shaders.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,21 +13,6 @@ static GLint uPointSizeLoc;
 static GLuint vbo;
 static GLint posLoc;
 
-// Embedded shader sources
-static const char *pointsize_vert =
-    "#version 100\n"
-    "attribute vec3 aPosition;\n"
-    "uniform float uPointSize;\n"
-    "void main() {\n"
-    "    gl_Position = vec4(aPosition, 1.0);\n"
-    "    gl_PointSize = uPointSize;\n"
-    "}\n";
-static const char *pointsize_frag =
-    "#version 100\n"
-    "void main() {\n"
-    "    gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0);\n"
-    "}\n";
-
 GLuint compile_shader_from_source(const char *source, GLenum type)
 {
     GLuint shader = glCreateShader(type);
@@ -34,7 +22,7 @@ GLuint compile_shader_from_source(const char *source, GLenum type)
         return 0;
     }
     glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+    PROFILE_CALL(glCompileShader(shader));
     GLint compiled;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
     if (!compiled)
@@ -84,7 +72,7 @@ GLuint create_shader_program_embedded(const char *vertex_src, const char *fragme
     }
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+    PROFILE_CALL(glLinkProgram(program));
     GLint linked;
     glGetProgramiv(program, GL_LINK_STATUS, &linked);
     if (!linked)
@@ -116,7 +104,7 @@ GLuint create_shader_program_embedded(const char *vertex_src, const char *fragme
 
 void init()
 {
-    shaderProgram = create_shader_program_embedded(pointsize_vert, pointsize_frag);
+    shaderProgram = create_shader_program_embedded(shader_pointsize_vert.source, shader_pointsize_frag.source);
     uPointSizeLoc = glGetUniformLocation(shaderProgram, "uPointSize");
     float points[4][3] = {
         {-0.2f, 0.2f, 0.0f},
@@ -125,12 +113,13 @@ void init()
         {0.2f, -0.2f, 0.0f}};
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(points), points, GL_STATIC_DRAW);
+    PROFILE_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(points), points, GL_STATIC_DRAW));
     posLoc = glGetAttribLocation(shaderProgram, "aPosition");
 }
 
-void draw()
+void draw(const SampleClock *sampleClock)
 {
+    (void)sampleClock; // the scene does not change over time
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -149,9 +138,9 @@ void draw()
     glDisableVertexAttribArray(posLoc);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     // Swap front and back buffers
-    glfwSwapBuffers(window);
+    PROFILE_CALL(glfwSwapBuffers(window));
     // Poll for and process events
-    glfwPollEvents();
+    PROFILE_CALL(glfwPollEvents());
 }
 
 int main(void)
@@ -178,10 +167,15 @@ int main(void)
     }
     glfwMakeContextCurrent(window);
 
-    init();
-    while (!glfwWindowShouldClose(window))
+    PROFILE_CALL(init());
+    SampleClock sampleClock;
+    sample_clock_init_from_env(&sampleClock);
+    glfwSwapInterval(sample_clock_swap_interval(&sampleClock));
+    while (!glfwWindowShouldClose(window) && !sample_clock_done(&sampleClock))
     {
-        draw();
+        PROFILE_ZONE("frame");
+        sample_clock_tick(&sampleClock);
+        PROFILE_CALL(draw(&sampleClock));
     }
 
     return 0;
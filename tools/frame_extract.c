@@ -0,0 +1,112 @@
+// frame_extract.c
+// Lists the frames of a recording (SAMPLES_RECORD) or extracts one of them.
+// Frames are located through the recording's index, so only the requested
+// frame is read and decoded.
+//
+// Usage: frame_extract <recording> [<index> <output.ppm|output.qoi>]
+//   .qoi outputs copy the frame's QOI data as is; other outputs are PPM.
+#include <capture/frame_recorder.h>
+#include <capture/qoi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int write_file(const char *path, const unsigned char *data, size_t size)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return 0;
+    }
+    size_t written = fwrite(data, 1, size, file);
+    fclose(file);
+    return written == size;
+}
+
+static int write_ppm(const char *path, const unsigned char *data, size_t size)
+{
+    int width, height, channels;
+    if (!qoi_read_header(data, size, &width, &height, &channels))
+    {
+        fprintf(stderr, "The frame is not a QOI image\n");
+        return 0;
+    }
+    unsigned char *pixels = (unsigned char *)malloc((size_t)width * height * 4);
+    if (!pixels || !qoi_decode(data, size, pixels))
+    {
+        fprintf(stderr, "Failed to decode the frame\n");
+        free(pixels);
+        return 0;
+    }
+    // RGBA to RGB in place
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+        memmove(pixels + i * 3, pixels + i * 4, 3);
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        free(pixels);
+        return 0;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    size_t bytes = (size_t)width * height * 3;
+    int ok = fwrite(pixels, 1, bytes, file) == bytes;
+    fclose(file);
+    free(pixels);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 4)
+    {
+        fprintf(stderr, "Usage: %s <recording> [<index> <output.ppm|output.qoi>]\n", argv[0]);
+        return 1;
+    }
+    FrameRecording recording;
+    if (!frame_recording_open(&recording, argv[1]))
+    {
+        fprintf(stderr, "Failed to open the recording %s\n", argv[1]);
+        return 1;
+    }
+
+    int ok = 1;
+    if (argc == 2)
+    {
+        printf("%ux%u, %llu frames%s\n", recording.header.width, recording.header.height,
+               (unsigned long long)recording.header.frameCount,
+               recording.rebuiltIndex ? " (not closed, index rebuilt)" : "");
+        for (uint64_t i = 0; i < recording.header.frameCount; ++i)
+        {
+            size_t size;
+            unsigned long long frame;
+            if (frame_recording_frame(&recording, i, &size, &frame))
+                printf("%6llu  frame %6llu  %10zu bytes\n", (unsigned long long)i, frame, size);
+        }
+    }
+    else
+    {
+        char *end;
+        unsigned long long i = strtoull(argv[2], &end, 10);
+        size_t size;
+        const unsigned char *data = *end ? NULL : frame_recording_frame(&recording, i, &size, NULL);
+        if (!data)
+        {
+            fprintf(stderr, "No frame %s in the recording (%llu frames)\n", argv[2],
+                    (unsigned long long)recording.header.frameCount);
+            ok = 0;
+        }
+        else
+        {
+            size_t length = strlen(argv[3]);
+            if (length > 4 && strcmp(argv[3] + length - 4, ".qoi") == 0)
+                ok = write_file(argv[3], data, size);
+            else
+                ok = write_ppm(argv[3], data, size);
+        }
+    }
+    frame_recording_close(&recording);
+    return ok ? 0 : 1;
+}
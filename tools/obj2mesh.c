@@ -0,0 +1,134 @@
+// obj2mesh.c
+// Converts a Wavefront OBJ file into the binary mesh format of
+// mesh/mesh_format.h. The triangles are reordered for the post-transform
+// vertex cache (vertex_cache.h) and the vertices renumbered in the order
+// the triangles use them; the ACMR of the original and the optimized order
+// is printed for a 16 and a 32 entry FIFO cache. Meshes of up to 65536
+// vertices get 16-bit indices.
+//
+// Usage: obj2mesh <input.obj> <output.mesh> [--no-optimize]
+#include <mesh/mesh_format.h>
+#include <mesh/obj.h>
+#include <mesh/vertex_cache.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int write_padding(FILE *file, long *position)
+{
+    static const unsigned char zeros[MESH_FILE_ALIGNMENT];
+    size_t padding = (size_t)((MESH_FILE_ALIGNMENT - *position % MESH_FILE_ALIGNMENT) % MESH_FILE_ALIGNMENT);
+    *position += (long)padding;
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+static int write_mesh(const char *path, const ObjMesh *mesh)
+{
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.attributes = mesh->attributes;
+    header.vertexStride = mesh_vertex_stride(mesh->attributes);
+    header.vertexCount = mesh->vertexCount;
+    header.indexSize = mesh->vertexCount <= 65536 ? 2 : 4;
+    header.indexCount = mesh->indexCount;
+    for (int k = 0; k < 3; ++k)
+    {
+        header.boundsMin[k] = mesh->vertices[k];
+        header.boundsMax[k] = mesh->vertices[k];
+    }
+    for (uint32_t i = 0; i < mesh->vertexCount; ++i)
+    {
+        const float *position = mesh->vertices + (size_t)i * mesh->vertexStride;
+        for (int k = 0; k < 3; ++k)
+        {
+            header.boundsMin[k] = position[k] < header.boundsMin[k] ? position[k] : header.boundsMin[k];
+            header.boundsMax[k] = position[k] > header.boundsMax[k] ? position[k] : header.boundsMax[k];
+        }
+    }
+    size_t vertexBytes = (size_t)mesh->vertexCount * header.vertexStride;
+    header.vertexOffset = (sizeof(header) + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+    header.indexOffset =
+        (header.vertexOffset + vertexBytes + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return 0;
+    }
+    long position = (long)sizeof(header);
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 && write_padding(file, &position) &&
+             fwrite(mesh->vertices, 1, vertexBytes, file) == vertexBytes;
+    position += (long)vertexBytes;
+    ok = ok && write_padding(file, &position);
+    for (uint32_t i = 0; ok && i < mesh->indexCount; ++i)
+    {
+        if (header.indexSize == 2)
+        {
+            unsigned short index = (unsigned short)mesh->indices[i];
+            ok = fwrite(&index, sizeof(index), 1, file) == 1;
+        }
+        else
+        {
+            ok = fwrite(&mesh->indices[i], sizeof(uint32_t), 1, file) == 1;
+        }
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        remove(path);
+        return 0;
+    }
+    printf("INFO: %s: %u vertices, %u triangles, %u-bit indices, %zu bytes\n", path, mesh->vertexCount,
+           mesh->indexCount / 3, header.indexSize * 8,
+           (size_t)header.indexOffset + (size_t)mesh->indexCount * header.indexSize);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3 || (argc > 3 && strcmp(argv[3], "--no-optimize") != 0))
+    {
+        fprintf(stderr, "Usage: %s <input.obj> <output.mesh> [--no-optimize]\n", argv[0]);
+        return 1;
+    }
+    int optimize = argc == 3;
+    ObjMesh mesh;
+    if (!obj_load(argv[1], &mesh))
+        return 1;
+
+    double before16 = vertex_cache_acmr(mesh.indices, mesh.indexCount, mesh.vertexCount, 16);
+    double before32 = vertex_cache_acmr(mesh.indices, mesh.indexCount, mesh.vertexCount, 32);
+    if (optimize)
+    {
+        if (!vertex_cache_optimize(mesh.indices, mesh.indexCount, mesh.vertexCount))
+        {
+            fprintf(stderr, "Out of memory\n");
+            obj_free(&mesh);
+            return 1;
+        }
+        mesh.vertexCount =
+            vertex_fetch_optimize(mesh.vertices, mesh.vertexStride, mesh.vertexCount, mesh.indices, mesh.indexCount);
+        if (mesh.vertexCount == 0)
+        {
+            fprintf(stderr, "Out of memory\n");
+            obj_free(&mesh);
+            return 1;
+        }
+        printf("INFO: %s: ACMR %.3f -> %.3f (FIFO 16), %.3f -> %.3f (FIFO 32)\n", argv[1], before16,
+               vertex_cache_acmr(mesh.indices, mesh.indexCount, mesh.vertexCount, 16), before32,
+               vertex_cache_acmr(mesh.indices, mesh.indexCount, mesh.vertexCount, 32));
+    }
+    else
+    {
+        printf("INFO: %s: ACMR %.3f (FIFO 16), %.3f (FIFO 32), not optimized\n", argv[1], before16, before32);
+    }
+
+    int ok = write_mesh(argv[2], &mesh);
+    obj_free(&mesh);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,924 @@
+// shader_pack.c
+// Build step for the samples' shaders. Reads shaders/*.glsl, checks that
+// each one compiles with the software renderer's GLSL front end and uses
+// no number suffix (1.0f), which ES drivers reject, minifies it and
+// writes shaders.h and shaders.c, which embed the minified sources with
+// their length and 64-bit FNV-1a hash (common/shader_source.h).
+//
+// Minification removes comments and every space the grammar does not need,
+// shortens float literals (0.50 -> .5) and folds constants:
+// - global scalars initialized with a literal and never written
+//   (const float c = 0.3; and plain globals such as float v = 0.2;) are
+//   replaced by their value
+// - operators between literals are evaluated (2.0 * 0.5 -> 1.); chains of
+//   added constants are combined (x - 0.2 - 0.3 -> x - 0.5) in single
+//   precision, which GPU compilers are free to do as well
+// The minified source is compiled again, so a folding mistake fails the
+// build instead of reaching a driver.
+//
+// The stage comes from the file name: *_vert.glsl or *_frag.glsl.
+//
+// Usage: shader_pack <output directory> <shader.glsl>...
+#include <swgl/swgl_glsl.h>
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum TokenKind
+{
+    TOKEN_WORD,      // identifier or keyword
+    TOKEN_NUMBER,
+    TOKEN_OPERATOR,
+    TOKEN_DIRECTIVE  // whole preprocessor line
+} TokenKind;
+
+typedef struct Token
+{
+    TokenKind kind;
+    char *text;
+} Token;
+
+typedef struct TokenList
+{
+    Token *tokens;
+    int count;
+    int capacity;
+} TokenList;
+
+// Growable string
+typedef struct Buffer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static void buffer_append(Buffer *buffer, const char *text, size_t length)
+{
+    if (buffer->length + length + 1 > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : 256;
+        while (buffer->length + length + 1 > capacity)
+            capacity *= 2;
+        char *data = (char *)realloc(buffer->data, capacity);
+        if (!data)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+static void buffer_puts(Buffer *buffer, const char *text)
+{
+    buffer_append(buffer, text, strlen(text));
+}
+
+static char *copy_text(const char *text, size_t length)
+{
+    char *copy = (char *)malloc(length + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// Inserts a token before index (index == count appends).
+static void tokens_insert(TokenList *list, int index, TokenKind kind, const char *text)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        Token *tokens = (Token *)realloc(list->tokens, (size_t)capacity * sizeof(Token));
+        if (!tokens)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        list->tokens = tokens;
+        list->capacity = capacity;
+    }
+    memmove(&list->tokens[index + 1], &list->tokens[index], (size_t)(list->count - index) * sizeof(Token));
+    list->tokens[index].kind = kind;
+    list->tokens[index].text = copy_text(text, strlen(text));
+    list->count++;
+}
+
+static void tokens_remove(TokenList *list, int index, int count)
+{
+    for (int i = index; i < index + count; ++i)
+        free(list->tokens[i].text);
+    memmove(&list->tokens[index], &list->tokens[index + count],
+            (size_t)(list->count - index - count) * sizeof(Token));
+    list->count -= count;
+}
+
+static void tokens_free(TokenList *list)
+{
+    tokens_remove(list, 0, list->count);
+    free(list->tokens);
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+
+static const char *const operators[] = {"<<=", ">>=", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&",
+                                        "||",  "^^",  "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^="};
+
+// Skips a comment at p; returns p when there is none.
+static const char *skip_comment(const char *p)
+{
+    if (p[0] == '/' && p[1] == '/')
+    {
+        while (*p && *p != '\n')
+            ++p;
+    }
+    else if (p[0] == '/' && p[1] == '*')
+    {
+        const char *end = strstr(p + 2, "*/");
+        p = end ? end + 2 : p + strlen(p);
+    }
+    return p;
+}
+
+static void tokenize(const char *source, TokenList *list)
+{
+    const char *p = source;
+    int lineStart = 1;
+    while (*p)
+    {
+        const char *next = skip_comment(p);
+        if (next != p)
+        {
+            p = next;
+            continue;
+        }
+        if (isspace((unsigned char)*p))
+        {
+            lineStart |= *p == '\n';
+            ++p;
+            continue;
+        }
+        if (*p == '#' && lineStart)
+        {
+            // Directive: comments dropped, whitespace collapsed, continuation
+            // lines joined
+            Buffer line = {NULL, 0, 0};
+            int space = 0;
+            while (*p && *p != '\n')
+            {
+                next = skip_comment(p);
+                if (next != p)
+                {
+                    p = next;
+                    space = 1;
+                    continue;
+                }
+                if (p[0] == '\\' && p[1] == '\n')
+                {
+                    p += 2;
+                    space = 1;
+                    continue;
+                }
+                if (isspace((unsigned char)*p))
+                    space = 1;
+                else
+                {
+                    if (space && line.length)
+                        buffer_puts(&line, " ");
+                    buffer_append(&line, p, 1);
+                    space = 0;
+                }
+                ++p;
+            }
+            tokens_insert(list, list->count, TOKEN_DIRECTIVE, line.data ? line.data : "#");
+            free(line.data);
+            continue;
+        }
+        lineStart = 0;
+        const char *start = p;
+        TokenKind kind = TOKEN_OPERATOR;
+        if (isdigit((unsigned char)*p) || (*p == '.' && isdigit((unsigned char)p[1])))
+        {
+            kind = TOKEN_NUMBER;
+            int hex = p[0] == '0' && (p[1] == 'x' || p[1] == 'X');
+            while (isalnum((unsigned char)*p) || *p == '.' || *p == '_' ||
+                   (!hex && (*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E')))
+                ++p;
+        }
+        else if (isalpha((unsigned char)*p) || *p == '_')
+        {
+            kind = TOKEN_WORD;
+            while (isalnum((unsigned char)*p) || *p == '_')
+                ++p;
+        }
+        else
+        {
+            size_t length = 1;
+            for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); ++i)
+            {
+                size_t operatorLength = strlen(operators[i]);
+                if (operatorLength > length && strncmp(p, operators[i], operatorLength) == 0)
+                    length = operatorLength;
+            }
+            p += length;
+        }
+        char *text = copy_text(start, (size_t)(p - start));
+        tokens_insert(list, list->count, kind, text);
+        free(text);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Constant folding
+
+static int is(const TokenList *list, int index, const char *text)
+{
+    return index >= 0 && index < list->count && list->tokens[index].kind != TOKEN_DIRECTIVE &&
+           strcmp(list->tokens[index].text, text) == 0;
+}
+
+static int is_any(const TokenList *list, int index, const char *const *texts)
+{
+    for (; *texts; ++texts)
+    {
+        if (is(list, index, *texts))
+            return 1;
+    }
+    return 0;
+}
+
+static int is_kind(const TokenList *list, int index, TokenKind kind)
+{
+    return index >= 0 && index < list->count && list->tokens[index].kind == kind;
+}
+
+typedef struct Literal
+{
+    int isFloat;
+    long long integer;
+    float real;
+} Literal;
+
+// Numbers with a suffix or an unusual form are left alone.
+static int parse_literal(const Token *token, Literal *literal)
+{
+    if (token->kind != TOKEN_NUMBER)
+        return 0;
+    const char *text = token->text;
+    char *end;
+    int hex = text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+    literal->isFloat = !hex && strpbrk(text, ".eE") != NULL;
+    if (literal->isFloat)
+        literal->real = strtof(text, &end);
+    else
+        literal->integer = strtoll(text, &end, 0);
+    return *end == '\0' && (literal->isFloat ? isfinite(literal->real) : literal->integer <= 0x7fffffff);
+}
+
+// Drops the zeros GLSL does not need from a fixed-point number: 0.50 -> .5,
+// 2 -> 2.
+static void trim_float(char *text)
+{
+    if (!strchr(text, '.'))
+        strcat(text, ".");
+    size_t length = strlen(text);
+    while (text[length - 1] == '0')
+        text[--length] = '\0';
+    if (text[0] == '0' && text[1] == '.' && text[2])
+        memmove(text, text + 1, length);
+}
+
+// Shortest text that reads back as the same float, in fixed or exponent
+// notation.
+static void format_float(float value, char *text, size_t size)
+{
+    char fixed[64] = "", exponent[64] = "";
+    for (int decimals = 0; decimals <= 12; ++decimals)
+    {
+        snprintf(fixed, sizeof(fixed), "%.*f", decimals, (double)value);
+        if (strtof(fixed, NULL) == value)
+            break;
+    }
+    trim_float(fixed);
+    for (int digits = 1; digits <= 9; ++digits)
+    {
+        snprintf(exponent, sizeof(exponent), "%.*e", digits - 1, (double)value);
+        if (strtof(exponent, NULL) == value)
+            break;
+    }
+    int fixedExact = strtof(fixed, NULL) == value;
+    snprintf(text, size, "%s", fixedExact && strlen(fixed) <= strlen(exponent) ? fixed : exponent);
+}
+
+// value may be negative; it is written as a '-' token and a number.
+static void replace_with_literal(TokenList *list, int index, int count, int isFloat, double value)
+{
+    tokens_remove(list, index, count);
+    char text[64];
+    if (isFloat)
+        format_float((float)fabs(value), text, sizeof(text));
+    else
+        snprintf(text, sizeof(text), "%lld", (long long)fabs(value));
+    tokens_insert(list, index, TOKEN_NUMBER, text);
+    if (value < 0.0)
+        tokens_insert(list, index, TOKEN_OPERATOR, "-");
+}
+
+static int evaluate(const Literal *a, const char *op, const Literal *b, double *result)
+{
+    if (a->isFloat != b->isFloat)
+        return 0;
+    if (a->isFloat)
+    {
+        float value = *op == '+' ? a->real + b->real : *op == '-' ? a->real - b->real
+                    : *op == '*' ? a->real * b->real : b->real != 0.0f ? a->real / b->real : NAN;
+        *result = value;
+        return isfinite(value);
+    }
+    if (*op == '/' && b->integer == 0)
+        return 0;
+    long long value = *op == '+' ? a->integer + b->integer : *op == '-' ? a->integer - b->integer
+                    : *op == '*' ? a->integer * b->integer : a->integer / b->integer;
+    *result = (double)value;
+    return value >= -0x7fffffffLL && value <= 0x7fffffffLL;
+}
+
+static const char *const assignments[] = {"=", "+=", "-=", "*=", "/=", "%=", "<<=", ">>=", "&=", "|=", "^=", NULL};
+static const char *const increments[] = {"++", "--", NULL};
+static const char *const precisions[] = {"lowp", "mediump", "highp", NULL};
+static const char *const scalarTypes[] = {"float", "int", "bool", NULL};
+
+// Tokens that start an expression, before which an additive pair of
+// literals can be evaluated on its own
+static const char *const expressionStarts[] = {"(", ",", "[", "?", ":", ";", "{", "return", "=", "+=", "-=",
+                                               "*=", "/=", NULL};
+// Tokens that bind tighter than + and - to a following operand
+static const char *const tighterThanAdd[] = {"*", "/", "%", ".", "[", "++", "--", NULL};
+
+// A directive that mentions name, e.g. a macro using it
+static int directives_use(const TokenList *list, const char *name)
+{
+    size_t length = strlen(name);
+    for (int i = 0; i < list->count; ++i)
+    {
+        if (list->tokens[i].kind != TOKEN_DIRECTIVE)
+            continue;
+        for (const char *p = strstr(list->tokens[i].text, name); p; p = strstr(p + 1, name))
+        {
+            int before = p > list->tokens[i].text && (isalnum((unsigned char)p[-1]) || p[-1] == '_');
+            int after = isalnum((unsigned char)p[length]) || p[length] == '_';
+            if (!before && !after)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+// Replaces global scalars that hold a literal and are never written.
+static int fold_globals(TokenList *list)
+{
+    int folded = 0;
+    int depth = 0;
+    for (int i = 0; i < list->count; ++i)
+    {
+        if (is(list, i, "{"))
+            depth++;
+        else if (is(list, i, "}"))
+            depth--;
+        int statementStart = i == 0 || is_kind(list, i - 1, TOKEN_DIRECTIVE) || is(list, i - 1, ";") ||
+                             is(list, i - 1, "}");
+        if (depth != 0 || !statementStart)
+            continue;
+        // [const] [precision] type name = [-]literal ;
+        int j = i;
+        if (is(list, j, "const"))
+            ++j;
+        if (is_any(list, j, precisions))
+            ++j;
+        if (!is_any(list, j, scalarTypes) || !is_kind(list, j + 1, TOKEN_WORD) || !is(list, j + 2, "="))
+            continue;
+        int name = j + 1;
+        int value = j + 3;
+        int negative = is(list, value, "-");
+        Literal literal;
+        int isLiteral = is_kind(list, value + negative, TOKEN_NUMBER)
+                            ? parse_literal(&list->tokens[value + negative], &literal)
+                            : !negative && (is(list, value, "true") || is(list, value, "false"));
+        if (!isLiteral || !is(list, value + negative + 1, ";"))
+            continue;
+        int end = value + negative + 2;
+
+        const char *text = list->tokens[name].text;
+        int safe = !directives_use(list, text);
+        for (int k = 0; k < list->count && safe; ++k)
+        {
+            if (k == name || list->tokens[k].kind != TOKEN_WORD || strcmp(list->tokens[k].text, text) != 0)
+                continue;
+            // Written, redeclared, a member or a function: keep the variable
+            safe = !is_any(list, k + 1, assignments) && !is_any(list, k + 1, increments) &&
+                   !is_any(list, k - 1, increments) && !is(list, k - 1, ".") && !is(list, k + 1, "(") &&
+                   !(is_kind(list, k - 1, TOKEN_WORD) && !is(list, k - 1, "return"));
+        }
+        if (!safe)
+            continue;
+
+        char *nameText = copy_text(text, strlen(text));
+        Token *value_tokens = &list->tokens[value];
+        char *literalText = copy_text(value_tokens[negative].text, strlen(value_tokens[negative].text));
+        TokenKind literalKind = value_tokens[negative].kind;
+        tokens_remove(list, i, end - i);
+        for (int k = 0; k < list->count; ++k)
+        {
+            if (list->tokens[k].kind != TOKEN_WORD || strcmp(list->tokens[k].text, nameText) != 0)
+                continue;
+            tokens_remove(list, k, 1);
+            if (negative)
+            {
+                tokens_insert(list, k, TOKEN_OPERATOR, ")");
+                tokens_insert(list, k, literalKind, literalText);
+                tokens_insert(list, k, TOKEN_OPERATOR, "-");
+                tokens_insert(list, k, TOKEN_OPERATOR, "(");
+                k += 3;
+            }
+            else
+                tokens_insert(list, k, literalKind, literalText);
+        }
+        free(nameText);
+        free(literalText);
+        folded++;
+        i--; // the next statement now starts at i
+    }
+    return folded;
+}
+
+// One pass of expression folding; returns the number of changes.
+static int fold_expressions(TokenList *list)
+{
+    int changes = 0;
+    for (int i = 0; i < list->count; ++i)
+    {
+        Literal a, b;
+        double result;
+        // ( literal ) after an operator
+        if (is(list, i, "(") && is_kind(list, i + 1, TOKEN_NUMBER) && is(list, i + 2, ")") &&
+            is_kind(list, i - 1, TOKEN_OPERATOR) && !is(list, i - 1, ")") && !is(list, i - 1, "]"))
+        {
+            tokens_remove(list, i + 2, 1);
+            tokens_remove(list, i, 1);
+            changes++;
+            continue;
+        }
+        // operand +- (-literal) -> operand -+ literal; (-literal) -> -literal
+        // where an expression starts
+        if (is(list, i, "(") && is(list, i + 1, "-") && is_kind(list, i + 2, TOKEN_NUMBER) && is(list, i + 3, ")"))
+        {
+            int binary = (is(list, i - 1, "+") || is(list, i - 1, "-")) &&
+                         (is_kind(list, i - 2, TOKEN_NUMBER) || is_kind(list, i - 2, TOKEN_WORD) ||
+                          is(list, i - 2, ")") || is(list, i - 2, "]")) &&
+                         !is(list, i - 2, "return");
+            if (binary)
+            {
+                const char *flipped = is(list, i - 1, "-") ? "+" : "-";
+                tokens_remove(list, i + 3, 1);
+                tokens_remove(list, i - 1, 3);
+                tokens_insert(list, i - 1, TOKEN_OPERATOR, flipped);
+                changes++;
+                continue;
+            }
+            if (is_any(list, i - 1, expressionStarts) && !is_any(list, i + 4, tighterThanAdd))
+            {
+                tokens_remove(list, i + 3, 1);
+                tokens_remove(list, i, 1);
+                changes++;
+                continue;
+            }
+        }
+        if (!is_kind(list, i, TOKEN_NUMBER) || !is_kind(list, i + 2, TOKEN_NUMBER) ||
+            !parse_literal(&list->tokens[i], &a) || !parse_literal(&list->tokens[i + 2], &b))
+            continue;
+        const char *op = list->tokens[i + 1].kind == TOKEN_OPERATOR ? list->tokens[i + 1].text : "";
+        int multiplicative = strcmp(op, "*") == 0 || strcmp(op, "/") == 0;
+        int additive = strcmp(op, "+") == 0 || strcmp(op, "-") == 0;
+        // literal * literal, unless the left literal belongs to an operator
+        // on its left that binds as tightly
+        if (multiplicative && !is_any(list, i - 1, tighterThanAdd) && !is(list, i + 3, ".") &&
+            !is(list, i + 3, "[") && !is_any(list, i + 3, increments) && evaluate(&a, op, &b, &result))
+        {
+            replace_with_literal(list, i, 3, a.isFloat, result);
+            changes++;
+            continue;
+        }
+        // literal + literal at the start of an expression
+        if (additive && (i == 0 || is_kind(list, i - 1, TOKEN_DIRECTIVE) || is_any(list, i - 1, expressionStarts)) &&
+            !is_any(list, i + 3, tighterThanAdd) && evaluate(&a, op, &b, &result))
+        {
+            replace_with_literal(list, i, 3, a.isFloat, result);
+            changes++;
+            continue;
+        }
+        // -literal +- literal at the start of an expression
+        if (additive && is(list, i - 1, "-") && (i == 1 || is_any(list, i - 2, expressionStarts)) &&
+            !is_any(list, i + 3, tighterThanAdd))
+        {
+            Literal negated = a;
+            negated.real = -a.real;
+            negated.integer = -a.integer;
+            if (evaluate(&negated, op, &b, &result))
+            {
+                replace_with_literal(list, i - 1, 4, a.isFloat, result);
+                changes++;
+                continue;
+            }
+        }
+        // operand +- literal +- literal: combine the two constants
+        int operandEnd = i >= 2 && (is_kind(list, i - 2, TOKEN_NUMBER) || is(list, i - 2, ")") ||
+                                    is(list, i - 2, "]") ||
+                                    (is_kind(list, i - 2, TOKEN_WORD) && !is(list, i - 2, "return")));
+        if (additive && operandEnd && (is(list, i - 1, "+") || is(list, i - 1, "-")) &&
+            !is_any(list, i + 3, tighterThanAdd) && a.isFloat == b.isFloat)
+        {
+            double first = a.isFloat ? (double)a.real : (double)a.integer;
+            double second = b.isFloat ? (double)b.real : (double)b.integer;
+            if (is(list, i - 1, "-"))
+                first = -first;
+            if (*op == '-')
+                second = -second;
+            double sum = a.isFloat ? (double)((float)first + (float)second) : first + second;
+            if (fabs(sum) > 0x7fffffff)
+                continue;
+            replace_with_literal(list, i - 1, 4, a.isFloat, sum);
+            if (sum >= 0.0)
+                tokens_insert(list, i - 1, TOKEN_OPERATOR, "+");
+            changes++;
+        }
+    }
+    return changes;
+}
+
+// Float literals lose the zeros GLSL does not need.
+static void shorten_literals(TokenList *list)
+{
+    for (int i = 0; i < list->count; ++i)
+    {
+        Literal literal;
+        if (!parse_literal(&list->tokens[i], &literal) || !literal.isFloat || strpbrk(list->tokens[i].text, "eE"))
+            continue;
+        char text[64];
+        format_float(literal.real, text, sizeof(text));
+        if (strlen(text) < strlen(list->tokens[i].text) && strtof(text, NULL) == literal.real)
+        {
+            free(list->tokens[i].text);
+            list->tokens[i].text = copy_text(text, strlen(text));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Output
+
+// Two tokens need a space between them when they would otherwise read as
+// one token: two words or numbers, or operators such as - - or < =.
+static int needs_space(const char *previous, const char *next)
+{
+    size_t length = strlen(previous);
+    char a = previous[length - 1], b = next[0];
+    // A '.' ends a word only as part of a number such as 1.
+    if ((isalnum((unsigned char)a) || a == '_' || (a == '.' && length > 1)) && (isalnum((unsigned char)b) || b == '_'))
+        return 1;
+    char pair[3] = {a, b, '\0'};
+    static const char *const joined[] = {"++", "--", "+=", "-=", "*=", "/=", "%=", "<<", ">>", "<=", ">=", "==",
+                                         "!=", "&&", "||", "^^", "&=", "|=", "^=", "//", "/*", NULL};
+    for (int i = 0; joined[i]; ++i)
+    {
+        if (strcmp(pair, joined[i]) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+static char *emit(const TokenList *list)
+{
+    Buffer out = {NULL, 0, 0};
+    buffer_puts(&out, "");
+    const char *previous = NULL;
+    for (int i = 0; i < list->count; ++i)
+    {
+        const Token *token = &list->tokens[i];
+        if (token->kind == TOKEN_DIRECTIVE)
+        {
+            // Directives need lines of their own
+            if (out.length && out.data[out.length - 1] != '\n')
+                buffer_puts(&out, "\n");
+            buffer_puts(&out, token->text);
+            buffer_puts(&out, "\n");
+            previous = NULL;
+            continue;
+        }
+        if (previous && needs_space(previous, token->text))
+            buffer_puts(&out, " ");
+        buffer_puts(&out, token->text);
+        previous = token->text;
+    }
+    return out.data;
+}
+
+// Rewrites the front end's "ERROR: 0:<line>: message" lines as
+// "<path>:<line>: error: message" so editors can jump to them.
+static void print_log(const char *path, const char *log)
+{
+    for (const char *line = log; *line;)
+    {
+        const char *end = strchr(line, '\n');
+        int length = end ? (int)(end - line) : (int)strlen(line);
+        int number, offset = 0;
+        if (sscanf(line, "ERROR: 0:%d: %n", &number, &offset) == 1 && offset)
+            fprintf(stderr, "%s:%d: error: %.*s\n", path, number, length - offset, line + offset);
+        else if (length)
+            fprintf(stderr, "%s: %.*s\n", path, length, line);
+        line += length + (end ? 1 : 0);
+    }
+}
+
+static unsigned long long fnv1a64(const char *text)
+{
+    unsigned long long hash = 0xcbf29ce484222325ull;
+    for (; *text; ++text)
+    {
+        hash ^= (unsigned char)*text;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+typedef struct PackedShader
+{
+    char name[128];
+    const char *path;
+    SwglGlslStage stage;
+    char *source;
+    size_t originalLength;
+} PackedShader;
+
+static char *read_file(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    Buffer buffer = {NULL, 0, 0};
+    buffer_puts(&buffer, "");
+    char chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        buffer_append(&buffer, chunk, read);
+    fclose(file);
+    *size = buffer.length;
+    return buffer.data;
+}
+
+// GLSL ES 1.00 numbers have no suffix (1.0f, 2u): desktop compilers take
+// them, ES drivers reject the shader. Returns 0, and prints the first such
+// number, when there is one.
+static int check_literals(const char *path, const TokenList *list)
+{
+    for (int i = 0; i < list->count; ++i)
+    {
+        const char *text = list->tokens[i].text;
+        if (list->tokens[i].kind != TOKEN_NUMBER)
+            continue;
+        const char *p = text;
+        if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        {
+            for (p += 2; isxdigit((unsigned char)*p); ++p)
+            {
+            }
+        }
+        else
+        {
+            while (isdigit((unsigned char)*p) || *p == '.')
+                ++p;
+            if (*p == 'e' || *p == 'E')
+            {
+                ++p;
+                if (*p == '+' || *p == '-')
+                    ++p;
+                while (isdigit((unsigned char)*p))
+                    ++p;
+            }
+        }
+        if (*p)
+        {
+            fprintf(stderr, "%s: error: %s: GLSL ES 1.00 numbers have no suffix\n", path, text);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int pack_shader(const char *path, PackedShader *shader)
+{
+    const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    size_t length = strlen(base);
+    if (length < 5 || strcmp(base + length - 5, ".glsl") != 0 || length - 5 >= sizeof(shader->name))
+    {
+        fprintf(stderr, "%s: expected a <name>.glsl file\n", path);
+        return 0;
+    }
+    memcpy(shader->name, base, length - 5);
+    shader->name[length - 5] = '\0';
+    for (char *c = shader->name; *c; ++c)
+    {
+        if (!isalnum((unsigned char)*c))
+            *c = '_';
+    }
+    length -= 5;
+    if (length > 5 && strcmp(shader->name + length - 5, "_vert") == 0)
+        shader->stage = SWGL_GLSL_VERTEX;
+    else if (length > 5 && strcmp(shader->name + length - 5, "_frag") == 0)
+        shader->stage = SWGL_GLSL_FRAGMENT;
+    else
+    {
+        fprintf(stderr, "%s: the name must end in _vert or _frag to give the stage\n", path);
+        return 0;
+    }
+    shader->path = path;
+
+    char *original = read_file(path, &shader->originalLength);
+    if (!original)
+    {
+        fprintf(stderr, "%s: cannot read the file\n", path);
+        return 0;
+    }
+    char log[4096];
+    SwglGlslShader *compiled = swgl_glsl_compile(shader->stage, original, log, sizeof(log));
+    if (!compiled)
+    {
+        print_log(path, log);
+        free(original);
+        return 0;
+    }
+    swgl_glsl_free(compiled);
+
+    TokenList tokens = {NULL, 0, 0};
+    tokenize(original, &tokens);
+    free(original);
+    if (!check_literals(path, &tokens))
+    {
+        tokens_free(&tokens);
+        return 0;
+    }
+    fold_globals(&tokens);
+    while (fold_expressions(&tokens))
+    {
+    }
+    shorten_literals(&tokens);
+    shader->source = emit(&tokens);
+    tokens_free(&tokens);
+
+    compiled = swgl_glsl_compile(shader->stage, shader->source, log, sizeof(log));
+    if (!compiled)
+    {
+        fprintf(stderr, "%s: the minified shader does not compile, please report this with the shader:\n%s\n", path,
+                shader->source);
+        print_log(path, log);
+        return 0;
+    }
+    swgl_glsl_free(compiled);
+    return 1;
+}
+
+// Writes the source as adjacent C string literals of readable length.
+static void write_string(FILE *file, const char *text)
+{
+    fputs("\n    \"", file);
+    int column = 0;
+    for (const char *c = text; *c; ++c, ++column)
+    {
+        // Lines break after the source's own newlines and, in long lines,
+        // after a statement
+        if (*c == '\n' || (column >= 90 && (*c == ';' || *c == '{' || *c == '}') && c[1] && c[1] != '\n'))
+        {
+            if (*c != '\n')
+                fputc(*c, file);
+            fputs(*c == '\n' ? (c[1] ? "\\n\"\n    \"" : "\\n") : "\"\n    \"", file);
+            column = -1;
+        }
+        else if (*c == '"' || *c == '\\')
+            fprintf(file, "\\%c", *c);
+        else
+            fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static int write_outputs(const char *directory, const PackedShader *shaders, int count)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/shaders.h", directory);
+    FILE *header = fopen(path, "w");
+    if (!header)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return 0;
+    }
+    fprintf(header, "// shaders.h\n"
+                    "// Generated by shader_pack from shaders/*.glsl; do not edit.\n"
+                    "#ifndef SHADERS_H\n"
+                    "#define SHADERS_H\n"
+                    "\n"
+                    "#include <common/shader_source.h>\n"
+                    "\n");
+    for (int i = 0; i < count; ++i)
+        fprintf(header, "extern const ShaderSource shader_%s;\n", shaders[i].name);
+    fprintf(header, "\n"
+                    "#define SHADER_SOURCE_COUNT %d\n"
+                    "extern const ShaderSource *const shader_sources[SHADER_SOURCE_COUNT];\n"
+                    "\n"
+                    "#endif // SHADERS_H\n",
+            count);
+    int ok = !ferror(header);
+    fclose(header);
+
+    snprintf(path, sizeof(path), "%s/shaders.c", directory);
+    FILE *source = fopen(path, "w");
+    if (!source)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return 0;
+    }
+    fprintf(source, "// shaders.c\n"
+                    "// Generated by shader_pack from shaders/*.glsl; do not edit.\n"
+                    "#include \"shaders.h\"\n");
+    for (int i = 0; i < count; ++i)
+    {
+        fprintf(source, "\nconst ShaderSource shader_%s = {\n    \"%s\",\n    \"", shaders[i].name, shaders[i].name);
+        for (const char *c = shaders[i].path; *c; ++c)
+            fprintf(source, *c == '"' || *c == '\\' ? "\\%c" : "%c", *c);
+        fprintf(source, "\",\n    %s,", shaders[i].stage == SWGL_GLSL_VERTEX ? "SHADER_STAGE_VERTEX" : "SHADER_STAGE_FRAGMENT");
+        write_string(source, shaders[i].source);
+        fprintf(source, ",\n    %zu,\n    %zu,\n    0x%016llxull,\n};\n", strlen(shaders[i].source),
+                shaders[i].originalLength, fnv1a64(shaders[i].source));
+    }
+    fprintf(source, "\nconst ShaderSource *const shader_sources[SHADER_SOURCE_COUNT] = {\n");
+    for (int i = 0; i < count; ++i)
+        fprintf(source, "    &shader_%s,\n", shaders[i].name);
+    fprintf(source, "};\n");
+    ok = ok && !ferror(source);
+    fclose(source);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <output directory> <shader.glsl>...\n", argv[0]);
+        return 1;
+    }
+    int count = argc - 2;
+    PackedShader *shaders = (PackedShader *)calloc((size_t)count, sizeof(PackedShader));
+    if (!shaders)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    int ok = 1;
+    size_t originalBytes = 0, packedBytes = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        ok = pack_shader(argv[i + 2], &shaders[i]) && ok;
+        if (!shaders[i].source)
+            continue;
+        for (int j = 0; j < i; ++j)
+        {
+            if (strcmp(shaders[j].name, shaders[i].name) == 0)
+            {
+                fprintf(stderr, "%s: a shader named %s already comes from %s\n", argv[i + 2], shaders[i].name,
+                        shaders[j].path);
+                ok = 0;
+            }
+        }
+        originalBytes += shaders[i].originalLength;
+        packedBytes += strlen(shaders[i].source);
+    }
+    if (ok)
+        ok = write_outputs(argv[1], shaders, count);
+    if (ok)
+        printf("INFO: %d shaders packed, %zu -> %zu bytes\n", count, originalBytes, packedBytes);
+    for (int i = 0; i < count; ++i)
+        free(shaders[i].source);
+    free(shaders);
+    return ok ? 0 : 1;
+}